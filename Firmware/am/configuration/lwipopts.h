@@ -164,8 +164,10 @@ a lot of data that needs to be copied, this should be set high. */
 
 
 /* ---------- Pbuf options ---------- */
-/* PBUF_POOL_SIZE: the number of buffers in the pbuf pool. */
-#define PBUF_POOL_SIZE          12
+/* PBUF_POOL_SIZE: the number of buffers in the pbuf pool. 20 more than the 12 this started with,
+   paid for by the RAM the OTA download gave back (ARENA_RECLAIMED_LWIP_BYTES in scratchArena.h),
+   so a full TCP_WND of received data fits in the pool. */
+#define PBUF_POOL_SIZE          32
 
 /* PBUF_POOL_BUFSIZE: the size of each pbuf in the pbuf pool. */
 #define PBUF_POOL_BUFSIZE       512
@@ -190,8 +192,9 @@ a lot of data that needs to be copied, this should be set high. */
 
 #define TCP_SND_QUEUELEN        (2* TCP_SND_BUF/TCP_MSS)
 
-/* TCP receive window. */
-#define TCP_WND                 (2*TCP_MSS)
+/* TCP receive window. 8 segments keep a cellular link with a long round trip busy during the
+   OTA download, 2 segments capped it at about 3 KB per round trip. */
+#define TCP_WND                 (8*TCP_MSS)
 
 
 #define TCP_MSL 6000UL /* The maximum segment lifetime in milliseconds */
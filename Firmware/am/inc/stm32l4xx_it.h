@@ -62,6 +62,12 @@ void USART3_IRQHandler(void);
 void USART1_IRQHandler(void);
 void UART4_IRQHandler(void);
 void DMA1_Channel1_IRQHandler(void);
+void DMA1_Channel2_IRQHandler(void);
+void DMA1_Channel3_IRQHandler(void);
+void SPI1_IRQHandler(void);
+void DMA1_Channel4_IRQHandler(void);
+void DMA1_Channel5_IRQHandler(void);
+void SPI2_IRQHandler(void);
 void HAL_SYSTICK_Callback( void );
 
 
@@ -137,6 +137,9 @@ typedef struct _httpc_connection {
   /* this callback is called after receiving the http headers
      It can abort the connection by returning != ERR_OK */
   httpc_headers_done_fn headers_done_fn;
+  /* if != 0, a "Range: bytes=<range_start>-" header is sent to resume a download
+     (direct requests with a host name only). The server answers 206 if it honours it. */
+  u32_t range_start;
 } httpc_connection_t;
 
 err_t httpc_get_file(const ip_addr_t* server_addr, u16_t port, const char* uri, const httpc_connection_t *settings,
@@ -44,6 +44,8 @@
 #include "mbedtls/pk.h"
 #include "mbedtls/pk_internal.h"
 #include "mbedtls/debug.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/sha256.h"
 
 //Set this higher for printouts
 #ifdef MBEDTLS_DEBUG_C
@@ -55,6 +57,7 @@
 #include <time.h>
 #include <stdio.h>
 #include "logTypes.h"
+#include "tlsSessionCache.h"
 
 /**
  * @brief Internal context structure.
@@ -66,6 +69,9 @@
  * @param[in] xNetworkSend Callback for sending data on an open TCP socket.
  * @param[in] pvCallerContext Opaque pointer provided by caller for above callbacks.
  * @param[out] xTLSCHandshakeSuccessful Indicates whether TLS handshake was successfully completed.
+ * @param[out] xSessionOffered Indicates whether a cached session was offered in the ClientHello.
+ * @param[out] ucOfferedMaster Master secret of the offered session, a resumed session keeps it.
+ * @param[out] ucOfferedTicketHash SHA-256 of the ticket that was offered, all zero without one.
  * @param[out] xMbedSslCtx Connection context for mbedTLS.
  * @param[out] xMbedSslConfig Configuration context for mbedTLS.
  * @param[out] xMbedX509CA Server certificate context for mbedTLS.
@@ -87,6 +93,9 @@ typedef struct TLSContext
     NetworkSend_t xNetworkSend;
     void * pvCallerContext;
     BaseType_t xTLSHandshakeSuccessful;
+    BaseType_t xSessionOffered;
+    unsigned char ucOfferedMaster[ 48 ];
+    unsigned char ucOfferedTicketHash[ 32 ];
 
     /* mbedTLS. */
     mbedtls_ssl_context xMbedSslCtx;
@@ -655,6 +664,113 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Offer the session saved by the last connection in the ClientHello.
+ *
+ * A server that no longer knows the session carries on with a full handshake,
+ * so nothing else has to change on the way in.
+ *
+ * @param[in] pxCtx Caller context.
+ */
+static void prvOfferCachedSession( TLSContext_t * pxCtx )
+{
+    mbedtls_ssl_session xSession;
+
+    mbedtls_ssl_session_init( &xSession );
+    pxCtx->xSessionOffered = pdFALSE;
+    memset( pxCtx->ucOfferedTicketHash, 0, sizeof( pxCtx->ucOfferedTicketHash ) );
+
+    if( ( pdTRUE == TLSC_load( &xSession ) ) &&
+        ( 0 == mbedtls_ssl_set_session( &pxCtx->xMbedSslCtx, &xSession ) ) )
+    {
+        pxCtx->xSessionOffered = pdTRUE;
+        memcpy( pxCtx->ucOfferedMaster, xSession.master, sizeof( pxCtx->ucOfferedMaster ) );
+
+#if defined( MBEDTLS_SSL_SESSION_TICKETS )
+        if( ( NULL != xSession.ticket ) && ( 0 != xSession.ticket_len ) )
+        {
+            ( void ) mbedtls_sha256_ret( xSession.ticket, xSession.ticket_len, pxCtx->ucOfferedTicketHash, 0 );
+        }
+#endif
+    }
+
+    mbedtls_ssl_session_free( &xSession );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Save the session of a completed handshake for the next connection.
+ *
+ * The session is read straight from the SSL context: mbedtls_ssl_get_session()
+ * would parse the server certificate chain again only to copy it, and the
+ * cache does not keep it.
+ *
+ * @param[in] pxCtx Caller context.
+ */
+static void prvSaveSession( TLSContext_t * pxCtx )
+{
+    mbedtls_ssl_session * pxSession = pxCtx->xMbedSslCtx.session;
+    BaseType_t xResumed = pdFALSE;
+
+    if( NULL != pxSession )
+    {
+        /* The session ID cannot tell: mbedTLS makes up a new one when it offers
+         * a ticket. A full handshake always derives a new master secret. */
+        if( ( pdTRUE == pxCtx->xSessionOffered ) &&
+            ( 0 == memcmp( pxSession->master, pxCtx->ucOfferedMaster, sizeof( pxCtx->ucOfferedMaster ) ) ) )
+        {
+            xResumed = pdTRUE;
+        }
+
+#if defined( MBEDTLS_SSL_SESSION_TICKETS )
+        /* mbedTLS keeps the offered ticket when the server turns it down and
+         * does not send a new one. The server will not take it next time either,
+         * and while it is offered the session ID is never looked up. */
+        if( ( pdFALSE == xResumed ) && ( NULL != pxSession->ticket ) && ( 0 != pxSession->ticket_len ) )
+        {
+            unsigned char ucTicketHash[ 32 ];
+
+            ( void ) mbedtls_sha256_ret( pxSession->ticket, pxSession->ticket_len, ucTicketHash, 0 );
+
+            if( 0 == memcmp( ucTicketHash, pxCtx->ucOfferedTicketHash, sizeof( ucTicketHash ) ) )
+            {
+                mbedtls_platform_zeroize( pxSession->ticket, pxSession->ticket_len );
+                mbedtls_free( pxSession->ticket );
+                pxSession->ticket = NULL;
+                pxSession->ticket_len = 0;
+                pxSession->ticket_lifetime = 0;
+            }
+        }
+#endif
+
+        TLS_PRINT( ( "TLS: %s handshake", ( pdTRUE == xResumed ) ? "resumed" : "full" ) );
+        TLSC_save( pxSession, ( pdTRUE == xResumed ) );
+    }
+
+    mbedtls_platform_zeroize( pxCtx->ucOfferedMaster, sizeof( pxCtx->ucOfferedMaster ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Whether a failed handshake means the offered session should be dropped.
+ *
+ * Only failures that came back from the server count, a dropped link says
+ * nothing about the session.
+ *
+ * @param[in] xResult Handshake result.
+ */
+static BaseType_t prvIsSessionRejected( BaseType_t xResult )
+{
+    return ( ( MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE == xResult ) ||
+             ( MBEDTLS_ERR_SSL_BAD_HS_SERVER_HELLO == xResult ) ||
+             ( MBEDTLS_ERR_SSL_BAD_HS_FINISHED == xResult ) ||
+             ( MBEDTLS_ERR_SSL_INVALID_MAC == xResult ) ) ? pdTRUE : pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
 /*
  * Interface routines.
  */
@@ -847,6 +963,12 @@ BaseType_t TLS_Connect( void * pvContext )
         xResult = mbedtls_ssl_set_hostname( &pxCtx->xMbedSslCtx, pxCtx->pcDestination );
     }
 
+    /* Offer the session from the last connection. */
+    if( 0 == xResult )
+    {
+        prvOfferCachedSession( pxCtx );
+    }
+
     /* Set the socket callbacks. */
     if( 0 == xResult )
     {
@@ -876,8 +998,20 @@ BaseType_t TLS_Connect( void * pvContext )
     if( 0 == xResult )
     {
         pxCtx->xTLSHandshakeSuccessful = pdTRUE;
+        prvSaveSession( pxCtx );
     }
-    else if( xResult > 0 )
+    else
+    {
+        mbedtls_platform_zeroize( pxCtx->ucOfferedMaster, sizeof( pxCtx->ucOfferedMaster ) );
+
+        if( ( pdTRUE == pxCtx->xSessionOffered ) && ( pdTRUE == prvIsSessionRejected( xResult ) ) )
+        {
+            /* The retry will do a full handshake. */
+            TLSC_invalidate();
+        }
+    }
+
+    if( xResult > 0 )
     {
         //TLS_PRINT( ( "ERROR: TLS_Connect failed with error code %d \r\n", xResult ) );
         /* Convert PKCS #11 failures to a negative error code. */
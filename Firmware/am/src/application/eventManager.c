@@ -57,6 +57,7 @@
 
 //run the task every 50 ms when not in the middle of something
 #define EVT_TASK_POLL_RATE_MS       50
+#define EVENT_QUEUE_LEN             10
 
 //Event types that other application modules can report:
 typedef enum
@@ -109,10 +110,15 @@ typedef struct
 }eventMsg_t;
 
 QueueHandle_t eventQueue;
+static StaticQueue_t eventQueueBuffer;
+static uint8_t eventQueueStorage[ EVENT_QUEUE_LEN * sizeof( eventMsg_t ) ];
 static eventMsg_t xIncomingEvent;
 static bool xWaitingOnCell = false;
 static bool xAwsConnected = false;
 
+//no jobs left but the outbox is still waiting on a PUBACK, power down once it is done
+static bool xPowerDownWhenMqttIdle = false;
+
 //System Status
 static uint32_t xTimeAmHasBeenOn = 0u;
 static uint32_t xAllowedTimeOn = AM_ALLOWED_TIME_ON_MS;
@@ -164,7 +170,7 @@ static void xHandleMfgCompleteTimerElapsed(void);
 void EVT_initializeEventQueue(void)
 {
     //Init the message queue for events
-    eventQueue = xQueueCreate( 10, sizeof( eventMsg_t ) );
+    eventQueue = xQueueCreateStatic( EVENT_QUEUE_LEN, sizeof( eventMsg_t ), eventQueueStorage, &eventQueueBuffer );
 
     if ( eventQueue == NULL )
     {
@@ -262,8 +268,16 @@ void EVT_eventManagerTask()
                     //turn off modem only if we are not doing anything else connectivity related
                     if ( GPS_isGpsEnabled() == false )
                     {
-                        //nominal case - turn off since there is nothing left to do
-                        xTurnOffCellAndPowerDown();
+                        if ( MQTT_getOperationInProgressFlag() == true )
+                        {
+                            //let the queued messages finish first, they would only be resent next time
+                            xPowerDownWhenMqttIdle = true;
+                        }
+                        else
+                        {
+                            //nominal case - turn off since there is nothing left to do
+                            xTurnOffCellAndPowerDown();
+                        }
                     }
 
                     xWaitingOnCell = false;
@@ -364,6 +378,12 @@ void EVT_eventManagerTask()
         //increment on time
         xTimeAmHasBeenOn+= EVT_TASK_POLL_RATE_MS;
 
+        if ( xPowerDownWhenMqttIdle == true && MQTT_getOperationInProgressFlag() == false )
+        {
+            xPowerDownWhenMqttIdle = false;
+            xTurnOffCellAndPowerDown();
+        }
+
         //check if we need to turn off due to a timeout - we will automatically turn off if we have received a 'no jobs' event above
         if (xTimeAmHasBeenOn >= xAllowedTimeOn  && xTestMode == false)
         {
@@ -890,14 +910,8 @@ static void xPackageAndSendGpsMsgToCloud(void)
 
 static bool xPackageAndSendSensorDataToCloud(void)
 {
-    SensorDataMessage sensorDataMessageToSend = SensorDataMessage_init_default;
+    CommonHeader header = CommonHeader_init_default;
     APP_NVM_SENSOR_DATA_WITH_HEADER_T sensorDataEntry = {};
-    uint32_t formattedLiters[APP_NVM_SAMPLES_PER_DAY];
-    uint32_t formattedTemp[APP_NVM_SAMPLES_PER_DAY];
-    uint32_t formattedHumidity[APP_NVM_SAMPLES_PER_DAY];
-    uint32_t formattedStrokes[APP_NVM_SAMPLES_PER_DAY];
-    uint32_t formattedStrokeHeight[APP_NVM_SAMPLES_PER_DAY];
-    uint8_t i;
     bool status = false;
 
     int16_t msgsToSend = MEM_getNumSensorDataEntries();
@@ -909,113 +923,49 @@ static bool xPackageAndSendSensorDataToCloud(void)
         if(MEM_getSensorDataLog(&sensorDataEntry) == true)
         {
             /********** Message Header **********/
-            sensorDataMessageToSend.header.productId = sensorDataEntry.productId;
-            sensorDataMessageToSend.header.timestamp = sensorDataEntry.timestamp;
-            sensorDataMessageToSend.header.msgNumber = sensorDataEntry.msgNumber;
-            sensorDataMessageToSend.header.fwMajor = sensorDataEntry.fwVersionMaj;
-            sensorDataMessageToSend.header.fwMinor = sensorDataEntry.fwVersionMinor;
-            sensorDataMessageToSend.header.fwBuild = sensorDataEntry.fwVersionBuild;
-            sensorDataMessageToSend.header.voltage = (uint32_t)sensorDataEntry.batteryVoltage;
-            sensorDataMessageToSend.header.powerRemaining = (uint32_t)sensorDataEntry.powerRemaining;
-            sensorDataMessageToSend.header.state = (eState)sensorDataEntry.state;
-            sensorDataMessageToSend.header.activatedDate = sensorDataEntry.activatedDate;
-            sensorDataMessageToSend.header.magnetDetected = sensorDataEntry.magnetDetected;
-            sensorDataMessageToSend.header.errorBits = sensorDataEntry.errorBits;
-            sensorDataMessageToSend.header.numSSMResets = sensorDataEntry.numSSMResets;
-            sensorDataMessageToSend.header.lastSSMResetDate = sensorDataEntry.lastSSMResetDate;
-            sensorDataMessageToSend.header.numAMResets = sensorDataEntry.numAMResets;
-            sensorDataMessageToSend.header.lastAMResetDate = sensorDataEntry.lastAMResetDate;
+            header.productId = sensorDataEntry.productId;
+            header.timestamp = sensorDataEntry.timestamp;
+            header.msgNumber = sensorDataEntry.msgNumber;
+            header.fwMajor = sensorDataEntry.fwVersionMaj;
+            header.fwMinor = sensorDataEntry.fwVersionMinor;
+            header.fwBuild = sensorDataEntry.fwVersionBuild;
+            header.voltage = (uint32_t)sensorDataEntry.batteryVoltage;
+            header.powerRemaining = (uint32_t)sensorDataEntry.powerRemaining;
+            header.state = (eState)sensorDataEntry.state;
+            header.activatedDate = sensorDataEntry.activatedDate;
+            header.magnetDetected = sensorDataEntry.magnetDetected;
+            header.errorBits = sensorDataEntry.errorBits;
+            header.numSSMResets = sensorDataEntry.numSSMResets;
+            header.lastSSMResetDate = sensorDataEntry.lastSSMResetDate;
+            header.numAMResets = sensorDataEntry.numAMResets;
+            header.lastAMResetDate = sensorDataEntry.lastAMResetDate;
 
             //get rssi value on the fly:
-            sensorDataMessageToSend.header.rssi = NW_getRssiValue();
-            sensorDataMessageToSend.header.connectTime = awsConnectTimeMs;
-            sensorDataMessageToSend.header.imei = NW_getImeiOfModem();
-            sensorDataMessageToSend.header.mfgComplete = MEM_getMfgCompleteFlag();
+            header.rssi = NW_getRssiValue();
+            header.connectTime = awsConnectTimeMs;
+            header.imei = NW_getImeiOfModem();
+            header.mfgComplete = MEM_getMfgCompleteFlag();
 
             //set the flags to true for the optional fields in the header
-            sensorDataMessageToSend.header.has_activatedDate = true;
-            sensorDataMessageToSend.header.has_connectTime = true;
-            sensorDataMessageToSend.header.has_errorBits = true;
-            sensorDataMessageToSend.header.has_lastAMResetDate = true;
-            sensorDataMessageToSend.header.has_lastSSMResetDate = true;
-            sensorDataMessageToSend.header.has_magnetDetected = true;
-            sensorDataMessageToSend.header.has_mfgComplete = true;
-            sensorDataMessageToSend.header.has_numAMResets = true;
-            sensorDataMessageToSend.header.has_numSSMResets = true;
-            sensorDataMessageToSend.header.has_powerRemaining = true;
-            sensorDataMessageToSend.header.has_rssi = true;
-            sensorDataMessageToSend.header.has_state = true;
-            sensorDataMessageToSend.header.has_voltage = true;
+            header.has_activatedDate = true;
+            header.has_connectTime = true;
+            header.has_errorBits = true;
+            header.has_lastAMResetDate = true;
+            header.has_lastSSMResetDate = true;
+            header.has_magnetDetected = true;
+            header.has_mfgComplete = true;
+            header.has_numAMResets = true;
+            header.has_numSSMResets = true;
+            header.has_powerRemaining = true;
+            header.has_rssi = true;
+            header.has_state = true;
+            header.has_voltage = true;
 
             // TODO: Add debug log
 
-            /********** Message Body **********/
-            for(i = 0; i < APP_NVM_SAMPLES_PER_DAY; i++)
-            {
-                formattedLiters[i] = (uint32_t)sensorDataEntry.litersPerHour[i];
-                formattedTemp[i] = (uint32_t)sensorDataEntry.tempPerHour[i];
-                formattedHumidity[i] = (uint32_t)sensorDataEntry.humidityPerHour[i];
-                formattedStrokes[i] = (uint32_t)sensorDataEntry.strokesPerHour[i];
-                formattedStrokeHeight[i] = (uint32_t)sensorDataEntry.strokeHeightPerHour[i];
-            }
-            memcpy(&sensorDataMessageToSend.litersPerHour, &formattedLiters, sizeof(sensorDataMessageToSend.litersPerHour));
-            memcpy(&sensorDataMessageToSend.tempPerHour, &formattedTemp, sizeof(sensorDataMessageToSend.tempPerHour));
-            memcpy(&sensorDataMessageToSend.humidityPerHour, &formattedHumidity, sizeof(sensorDataMessageToSend.humidityPerHour));
-            memcpy(&sensorDataMessageToSend.strokesPerHour, &formattedStrokes, sizeof(sensorDataMessageToSend.strokesPerHour));
-            memcpy(&sensorDataMessageToSend.strokeHeightPerHour, &formattedStrokeHeight, sizeof(sensorDataMessageToSend.strokeHeightPerHour));
-            sensorDataMessageToSend.dailyLiters = sensorDataEntry.dailyLiters;
-            sensorDataMessageToSend.avgLiters = sensorDataEntry.avgLiters;
-            sensorDataMessageToSend.totalLiters = sensorDataEntry.totalLiters;
-            sensorDataMessageToSend.breakdown = sensorDataEntry.breakdown;
-            sensorDataMessageToSend.pumpCapacity = sensorDataEntry.pumpCapacity;
-            sensorDataMessageToSend.pumpUnusedTime = sensorDataEntry.pumpUnusedTime;
-            sensorDataMessageToSend.pumpUsage = sensorDataEntry.pumpUsage;
-            sensorDataMessageToSend.dryStrokes = sensorDataEntry.dryStrokes;
-            sensorDataMessageToSend.dryStrokeHeight = sensorDataEntry.dryStrokeHeight;
-
-
-            //set the flags to true for the optional fields in the payload
-            sensorDataMessageToSend.has_avgLiters = true;
-            sensorDataMessageToSend.has_breakdown = true;
-            sensorDataMessageToSend.has_dailyLiters = true;
-            sensorDataMessageToSend.humidityPerHour_count = 0; // do not send humidity data, will be 0
-            sensorDataMessageToSend.litersPerHour_count = APP_NVM_SAMPLES_PER_DAY;
-            sensorDataMessageToSend.has_pumpCapacity = true;
-            sensorDataMessageToSend.tempPerHour_count = APP_NVM_SAMPLES_PER_DAY;
-            sensorDataMessageToSend.has_totalLiters = true;
-            sensorDataMessageToSend.has_pumpUnusedTime = true;
-            sensorDataMessageToSend.has_pumpUsage = true;
-            sensorDataMessageToSend.has_dryStrokes = true;
-            sensorDataMessageToSend.has_dryStrokeHeight = true;
-
-            //if stroke detection is enabled, send the stroke info to the cloud
-            if ( xIsStrokeDetectionEnabled == true )
-            {
-                sensorDataMessageToSend.strokeHeightPerHour_count = APP_NVM_SAMPLES_PER_DAY;
-                sensorDataMessageToSend.strokesPerHour_count = APP_NVM_SAMPLES_PER_DAY;
-            }
-            else
-            {
-                sensorDataMessageToSend.strokeHeightPerHour_count = 0;
-                sensorDataMessageToSend.strokesPerHour_count = 0;
-            }
-
-
-            //if stroke detection is enabled, send the stroke info to the cloud
-            if ( xIsStrokeDetectionEnabled == true )
-            {
-                sensorDataMessageToSend.strokeHeightPerHour_count = APP_NVM_SAMPLES_PER_DAY;
-                sensorDataMessageToSend.strokesPerHour_count = APP_NVM_SAMPLES_PER_DAY;
-            }
-            else
-            {
-                sensorDataMessageToSend.strokeHeightPerHour_count = 0;
-                sensorDataMessageToSend.strokesPerHour_count = 0;
-            }
-
-
-            // Queue up the sensor data message
-            if (MQTT_sendSensorDataMsg(sensorDataMessageToSend))
+            // Queue up the sensor data message, the body is encoded straight from the log.
+            // The stroke info only goes out if stroke detection is enabled.
+            if (MQTT_sendSensorDataLog(&header, &sensorDataEntry, xIsStrokeDetectionEnabled))
             {
                 status = true;
             }
@@ -1532,6 +1482,9 @@ static void xTurnOffCellAndPowerDown(void)
     //clear reset counter
     MEM_setResetsSinceLastLpMode(0);
 
+    //compact the config journal now so the next session does not have to
+    MEM_prepareForStandby();
+
     if ( xTestMode == false )
     {
         //Now enter standby mode - Wake up from the SSM GPIO line
@@ -43,6 +43,7 @@
 #include "connectivity.h"
 #include "ATECC608A.h"
 #include "nwStackFunctionality.h"
+#include "pppLink.h"
 
 #define MSG_FREE_INDICATOR          'Z'
 #define MSG_START_INDICATOR         '\r'
@@ -51,9 +52,9 @@
 #define MAX_MSGS                     4
 #define IMEI_BYTE_LEN                15
 #define CRYPTO_DEVICE_ID_LEN         9
-#define MAX_BUFFERED_CELL_CHARS      1800
-#define TX_TIMEOUT_TICKS             0xFFFFFFF
 #define TASK_POLLING_RATE_MS         2
+#define PPP_RX_WAIT_MS               1000
+#define LINK_STATS_PRINT_MS          30000
 #define NW_REG_ROAMING               5
 #define NW_REG_HOME                  1
 
@@ -87,8 +88,7 @@ static cellMessage_t incomingMsgs[MAX_MSGS];
 static ppp_pcb *pppHandle;
 static struct netif pppNetifHandle;
 volatile uint8_t rxByte = 0u;
-static bool inPppRxMode = false;
-static bool currentlyTransmitting = false;
+static volatile bool inPppRxMode = false;
 
 //unique ID of the cell modem
 static uint8_t imei[IMEI_BYTE_LEN] = {};
@@ -99,12 +99,8 @@ static uint8_t cryptoUniqueId[CRYPTO_DEVICE_ID_LEN];
 //Each hex byte will be 2 characters:
 static char xCrypIdString[CRYPTO_DEVICE_ID_LEN*2];
 
-uint8_t receivedCharacters[MAX_BUFFERED_CELL_CHARS];
-uint16_t rxHead = 0u;
-uint16_t rxTail = 0u;
-
 static uint16_t uartErrors = 0;
-static uint16_t xTimeSinceLastPrint = 0;
+static TickType_t xLastPrintTick = 0;
 
 static bool timeSyncRequested = false;
 static bool nwRegistered = false;
@@ -124,12 +120,16 @@ static void xLookForRegStatus(uint8_t *incomingAtRsp);
 static void initMessageBuffers(void);
 static void freeUpMessageBuffer(cellMessage_t * pMsg);
 static cellMessage_t * getFreeMessageBufferPointer(void);
+static void xPrintLinkStats(void);
 
 
 void ATcommandModeParsing_Task(void)
 {
     initMessageBuffers();
 
+    //this task is the consumer of the ppp rx ring, the UART interrupt decides when to wake it
+    PPPLINK_initRxTask();
+
     while (1)
     {
         //route received UART chars depending on which mode we are in:
@@ -155,56 +155,40 @@ void ATcommandModeParsing_Task(void)
                     freeUpMessageBuffer(&incomingMsgs[index]);
                 }
             }
+
+            vTaskDelay(TASK_POLLING_RATE_MS);
         }
         else
         {
-            //if we have new data in the buffer, process it
-            if ( rxHead != rxTail)
-            {
-                while (rxHead != rxTail )
-                {
-                    //route characters to the ppp handler
-                     pppos_input(pppHandle, &receivedCharacters[rxTail], sizeof(uint8_t));
-
-                     rxTail++;
-
-                     if (rxTail >= MAX_BUFFERED_CELL_CHARS)
-                     {
-                         rxTail = 0;
-                     }
-                }
-            }
+            //sleep until the UART interrupt has a frame queued, then route it to the ppp handler. Bytes
+            //that are already in from the next frame go along with it.
+            (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PPP_RX_WAIT_MS));
+            PPPLINK_passRxToPpp(pppHandle);
         }
 
-        //every 30 secs print uart errors
-        if ( xTimeSinceLastPrint >= 30000)
+        //every 30 secs print the link stats
+        if ( (xTaskGetTickCount() - xLastPrintTick) >= pdMS_TO_TICKS(LINK_STATS_PRINT_MS) )
         {
-           // elogInfo(" uart errors %d", uartErrors);
-            xTimeSinceLastPrint = 0;
+            if ( inPppRxMode == true )
+            {
+                xPrintLinkStats();
+            }
+            xLastPrintTick = xTaskGetTickCount();
         }
-
-        xTimeSinceLastPrint += TASK_POLLING_RATE_MS;
-
-        vTaskDelay(TASK_POLLING_RATE_MS);
     }
 }
 
-
 //callback function when we receive UART chars.
 //Either throw into a buffer of raw bytes to process in the task (for ppp mode)
 //or put into an at command buffer to parse
 void NW_processCellRxByte(void)
 {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
     if (inPppRxMode == true )
     {
         //route characters to the ppp handler
-        receivedCharacters[rxHead] = rxByte;
-
-        rxHead++;
-        if(rxHead >= MAX_BUFFERED_CELL_CHARS )
-        {
-            rxHead = 0;
-        }
+        PPPLINK_rxByteFromIsr(rxByte, &xHigherPriorityTaskWoken);
     }
     else
     {
@@ -212,11 +196,24 @@ void NW_processCellRxByte(void)
         parseAtModeResponseInput(rxByte);
     }
 
-    if ( currentlyTransmitting != true )
+    if ( PPPLINK_isTransmitting() != true )
     {
         //kick off another rx
         UART_recieveDataNonBlocking(CELLULAR, &rxByte, sizeof(uint8_t));
     }
+
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+static void xPrintLinkStats(void)
+{
+    pppLinkStats_t stats;
+
+    PPPLINK_getStats(&stats);
+
+    elogInfo("ppp rx %lu B/s (%lu B in %lu spans) tx %lu B/s (%lu B in %lu dma) load %lu.%lu%% ovf %lu drop %lu uart err %d",
+             stats.rxBytesPerSec, stats.rxBytes, stats.rxSpans, stats.txBytesPerSec, stats.txBytes, stats.txDmaStarts,
+             stats.cpuLoadPermille / 10u, stats.cpuLoadPermille % 10u, stats.rxOverflows, stats.txDropped, uartErrors);
 }
 
 uint32_t NW_getRssiValue(void)
@@ -441,10 +438,19 @@ static void freeUpMessageBuffer(cellMessage_t * pMsg)
 //called when a transmission has completed
 void NW_txComplete(void)
 {
-    currentlyTransmitting = false;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    bool released;
+
+    //release the ppp bytes that just went out
+    released = PPPLINK_releaseSentFromIsr(&xHigherPriorityTaskWoken);
 
     //kick off another rx
     UART_recieveDataNonBlocking(CELLULAR, &rxByte, sizeof(uint8_t));
+
+    //chain straight into whatever was queued while this one was going out
+    PPPLINK_chainTxFromIsr(released);
+
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 //uart error handler..
@@ -556,6 +562,9 @@ void NW_initLwip(void)
         //init ip address as 0. The lwip stack will fill this in
         pppNetifHandle.ip_addr.addr = 0;
 
+        //the tx ring, the link stats and an empty rx ring, nothing writes to the ring until the mode changes
+        PPPLINK_start();
+
         //we are now in ppp mode - route uart chars to the stack
         inPppRxMode = true;
 
@@ -614,35 +623,8 @@ static void ctxcbFunction(void)
  */
 static u32_t ppposTxOutputCb(ppp_pcb *pcb, u8_t *data, u32_t len, void *ctx)
 {
-    uint32_t stat;
-    uint32_t msTimeout = 0;
-
-    //this flag is reset in the DMA interrupt handler once finished
-    currentlyTransmitting = true;
-
-    //start transmitting, interrupt based using DMA
-    stat = UART_sendDataNonBlockingWithDma(CELLULAR, data, len);
-
-    if (stat == HAL_OK)
-    {
-       //hang out while transmitting, time out if stuck
-       while ( currentlyTransmitting == true && msTimeout <= TX_TIMEOUT_TICKS )
-       {
-           msTimeout++;
-       }
-
-       //if still transmitting, return 0
-       if ( currentlyTransmitting == true )
-       {
-           len = 0;
-       }
-    }
-    else
-    {
-        len = 0;
-    }
-
-    return len;
+    //queued for the DMA, the bytes go out in the background
+    return PPPLINK_output(data, len);
 }
 
 //Add more to this cb as we get further along
@@ -0,0 +1,275 @@
+/**************************************************************************************************
+* \file     pppLink.c
+* \brief    PPP I/O between the cell UART and pppos: rx spans to pppos_input, tx frames through a DMA ring
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+/* Includes */
+#include "stdbool.h"
+#include "string.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#include "stm32l4r5xx.h"
+#include <stm32l4xx_hal.h>
+#include "uart.h"
+#include "pppos.h"
+#include "spscRing.h"
+#include "pppLink.h"
+
+#define CELL_RX_RING_BYTES           2048        //power of two, ~90 ms of modem output at 230400 baud
+#define CELL_TX_RING_BYTES           2048        //holds four PBUF_POOL_BUFSIZE chunks from pppos
+#define TX_SPACE_TIMEOUT_MS          500
+#define CELL_RX_WAKE_BYTES           1024        //wake the task before the ring gets near full
+#define PPP_FLAG_BYTE                0x7Eu       //HDLC frame delimiter
+
+//ppp mode bytes from the UART interrupt to the AT task. The task is only woken at the end of a frame
+//(or when the ring starts to fill), a notification per byte would cost more than the old 2 ms poll.
+RING_DEFINE_STORAGE(cellRxStorage, CELL_RX_RING_BYTES);
+static spscRing_t cellRxRing;
+static TaskHandle_t xPppRxTask = NULL;
+
+//encoded ppp frames waiting for the DMA. Bytes are released by the tx complete interrupt, whoever
+//holds currentlyTransmitting is the consumer.
+RING_DEFINE_STORAGE(cellTxStorage, CELL_TX_RING_BYTES);
+static spscRing_t cellTxRing;
+static volatile uint32_t txInFlight = 0u;
+static volatile bool currentlyTransmitting = false;
+static SemaphoreHandle_t xTxSpaceSem = NULL;
+static StaticSemaphore_t xTxSpaceSemBuffer;
+
+static pppLinkStats_t linkStats;
+static uint64_t linkCycles = 0u;
+static TickType_t linkStartTick = 0u;
+
+void PPPLINK_initRxTask(void);
+void PPPLINK_start(void);
+void PPPLINK_rxByteFromIsr(uint8_t byte, BaseType_t *pxHigherPriorityTaskWoken);
+void PPPLINK_passRxToPpp(ppp_pcb *pcb);
+u32_t PPPLINK_output(const u8_t *data, u32_t len);
+bool PPPLINK_releaseSentFromIsr(BaseType_t *pxHigherPriorityTaskWoken);
+void PPPLINK_chainTxFromIsr(bool released);
+bool PPPLINK_isTransmitting(void);
+void PPPLINK_getStats(pppLinkStats_t *pStats);
+
+static void xStartTxIfIdle(void);
+static bool xStartTxDma(void);
+
+void PPPLINK_initRxTask(void)
+{
+    //the calling task is the consumer of the ppp rx ring, the UART interrupt decides when to wake it
+    RING_init(&cellRxRing, cellRxStorage, sizeof(cellRxStorage), NULL);
+    xPppRxTask = xTaskGetCurrentTaskHandle();
+}
+
+void PPPLINK_start(void)
+{
+    //the ppp tx ring and the semaphore the DMA uses to hand back space only need creating once
+    if ( xTxSpaceSem == NULL )
+    {
+        RING_init(&cellTxRing, cellTxStorage, sizeof(cellTxStorage), NULL);
+        xTxSpaceSem = xSemaphoreCreateBinaryStatic(&xTxSpaceSemBuffer);
+    }
+
+    //cycle counter for the link load figure
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    //start the link stats and the rx ring from empty, nothing writes to the ring until the mode changes
+    memset(&linkStats, 0, sizeof(linkStats));
+    linkCycles = 0u;
+    linkStartTick = xTaskGetTickCount();
+    RING_reset(&cellRxRing);
+    cellRxRing.overflows = 0u;
+}
+
+void PPPLINK_rxByteFromIsr(uint8_t byte, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)RING_putFromIsr(&cellRxRing, byte, pxHigherPriorityTaskWoken);
+
+    if ( (byte == PPP_FLAG_BYTE) || (RING_count(&cellRxRing) >= CELL_RX_WAKE_BYTES) )
+    {
+        vTaskNotifyGiveFromISR(xPppRxTask, pxHigherPriorityTaskWoken);
+    }
+}
+
+//hand everything in the rx ring to pppos, one call per contiguous run instead of one per byte
+void PPPLINK_passRxToPpp(ppp_pcb *pcb)
+{
+    const uint8_t *pSpan;
+    uint32_t spanLen;
+    uint32_t startCycles;
+
+    pSpan = RING_readSpan(&cellRxRing, &spanLen);
+
+    while ( spanLen != 0u )
+    {
+        startCycles = DWT->CYCCNT;
+
+        //pppos copies the bytes out, so the span can be released as soon as it returns
+        pppos_input(pcb, (u8_t*)pSpan, (int)spanLen);
+
+        linkCycles += (DWT->CYCCNT - startCycles);
+        linkStats.rxBytes += spanLen;
+        linkStats.rxSpans++;
+
+        RING_commitRead(&cellRxRing, spanLen);
+
+        //a second span if the data wrapped, or whatever arrived in the meantime
+        pSpan = RING_readSpan(&cellRxRing, &spanLen);
+    }
+}
+
+u32_t PPPLINK_output(const u8_t *data, u32_t len)
+{
+    TickType_t startTick = xTaskGetTickCount();
+    uint32_t startCycles;
+
+    //a chunk is queued whole or not at all, so the modem never sees half a frame
+    if ( len > RING_capacity(&cellTxRing) )
+    {
+        linkStats.txDropped += len;
+        return 0;
+    }
+
+    //if the modem is behind, sleep until the DMA hands some space back instead of spinning
+    while ( RING_space(&cellTxRing) < len )
+    {
+        if ( (xTaskGetTickCount() - startTick) >= pdMS_TO_TICKS(TX_SPACE_TIMEOUT_MS) )
+        {
+            linkStats.txDropped += len;
+            return 0;
+        }
+
+        (void)xSemaphoreTake(xTxSpaceSem, pdMS_TO_TICKS(TX_SPACE_TIMEOUT_MS));
+    }
+
+    startCycles = DWT->CYCCNT;
+
+    (void)RING_write(&cellTxRing, data, len);
+    xStartTxIfIdle();
+
+    linkCycles += (DWT->CYCCNT - startCycles);
+
+    //the bytes go out in the background, the tx complete interrupt chains the rest of the ring
+    return len;
+}
+
+bool PPPLINK_releaseSentFromIsr(BaseType_t *pxHigherPriorityTaskWoken)
+{
+    uint32_t sent = txInFlight;
+
+    //AT commands are sent straight from their own buffer, only ring transfers have bytes to release
+    if ( sent == 0u )
+    {
+        return false;
+    }
+
+    txInFlight = 0u;
+    RING_commitRead(&cellTxRing, sent);
+    linkStats.txBytes += sent;
+
+    //wake a ppp output call that is waiting for space
+    xSemaphoreGiveFromISR(xTxSpaceSem, pxHigherPriorityTaskWoken);
+
+    return true;
+}
+
+void PPPLINK_chainTxFromIsr(bool released)
+{
+    //chain straight into whatever was queued while this one was going out
+    if ( (released == false) || (xStartTxDma() == false) )
+    {
+        currentlyTransmitting = false;
+    }
+}
+
+bool PPPLINK_isTransmitting(void)
+{
+    return currentlyTransmitting;
+}
+
+//throughput and the share of the core spent moving ppp bytes since the link came up
+void PPPLINK_getStats(pppLinkStats_t *pStats)
+{
+    uint32_t elapsedMs = (uint32_t)((xTaskGetTickCount() - linkStartTick) * portTICK_PERIOD_MS);
+    uint64_t elapsedCycles = (uint64_t)elapsedMs * (SystemCoreClock / 1000u);
+
+    *pStats = linkStats;
+    pStats->rxOverflows = cellRxRing.overflows;
+    pStats->elapsedMs = elapsedMs;
+
+    if ( elapsedMs != 0u )
+    {
+        pStats->rxBytesPerSec = (uint32_t)(((uint64_t)linkStats.rxBytes * 1000u) / elapsedMs);
+        pStats->txBytesPerSec = (uint32_t)(((uint64_t)linkStats.txBytes * 1000u) / elapsedMs);
+        pStats->cpuLoadPermille = (uint32_t)((linkCycles * 1000u) / elapsedCycles);
+    }
+}
+
+//take ownership of the UART tx side and start the DMA, unless a transfer is already running
+static void xStartTxIfIdle(void)
+{
+    bool start = false;
+
+    taskENTER_CRITICAL();
+    if ( currentlyTransmitting == false )
+    {
+        //also keeps the rx interrupt from re-arming (and locking the UART handle) under the DMA start
+        currentlyTransmitting = true;
+        start = true;
+    }
+    taskEXIT_CRITICAL();
+
+    if ( (start == true) && (xStartTxDma() == false) )
+    {
+        currentlyTransmitting = false;
+    }
+}
+
+//send the next contiguous run of the tx ring. The caller holds currentlyTransmitting.
+static bool xStartTxDma(void)
+{
+    const uint8_t *pSpan;
+    uint32_t spanLen;
+
+    pSpan = RING_readSpan(&cellTxRing, &spanLen);
+
+    if ( spanLen == 0u )
+    {
+        return false;
+    }
+
+    txInFlight = spanLen;
+
+    if ( UART_sendDataNonBlockingWithDma(CELLULAR, (uint8_t*)pSpan, (uint16_t)spanLen) != HAL_OK )
+    {
+        //drop it, the peer will ask again
+        txInFlight = 0u;
+        RING_commitRead(&cellTxRing, spanLen);
+        linkStats.txDropped += spanLen;
+        return false;
+    }
+
+    linkStats.txDmaStarts++;
+
+    return true;
+}
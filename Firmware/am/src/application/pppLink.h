@@ -0,0 +1,71 @@
+/**************************************************************************************************
+* \file     pppLink.h
+* \brief    PPP I/O between the cell UART and pppos: rx spans to pppos_input, tx frames through a DMA ring
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#ifndef APPLICATION_PPPLINK_H_
+#define APPLICATION_PPPLINK_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+#include "FreeRTOS.h"
+#include "ppp.h"
+
+typedef struct
+{
+    uint32_t rxBytes;
+    uint32_t rxSpans;               //pppos_input calls
+    uint32_t rxOverflows;           //bytes lost because the task fell behind the UART
+    uint32_t txBytes;
+    uint32_t txDmaStarts;
+    uint32_t txDropped;             //bytes pppos was told could not be sent
+    uint32_t elapsedMs;
+    uint32_t rxBytesPerSec;
+    uint32_t txBytesPerSec;
+    uint32_t cpuLoadPermille;       //pppos_input and tx queueing, not the UART interrupt
+}pppLinkStats_t;
+
+//the AT task, once at start up. It is the task PPPLINK_rxByteFromIsr() wakes.
+extern void PPPLINK_initRxTask(void);
+
+//each time the link is brought up, before the UART starts routing bytes here
+extern void PPPLINK_start(void);
+
+//UART receive interrupt, one byte in ppp mode
+extern void PPPLINK_rxByteFromIsr(uint8_t byte, BaseType_t *pxHigherPriorityTaskWoken);
+
+//the AT task once woken: everything received so far goes to pppos_input
+extern void PPPLINK_passRxToPpp(ppp_pcb *pcb);
+
+//the pppos output callback
+extern u32_t PPPLINK_output(const u8_t *data, u32_t len);
+
+//UART transmit complete interrupt. Release what was sent first, then (after the rx is re-armed) chain
+//the DMA into whatever was queued meanwhile.
+extern bool PPPLINK_releaseSentFromIsr(BaseType_t *pxHigherPriorityTaskWoken);
+extern void PPPLINK_chainTxFromIsr(bool released);
+
+//a ppp DMA transfer holds the UART tx side, the rx interrupt must not re-arm under it
+extern bool PPPLINK_isTransmitting(void);
+
+extern void PPPLINK_getStats(pppLinkStats_t *pStats);
+
+#endif /* APPLICATION_PPPLINK_H_ */
@@ -36,7 +36,6 @@
 #include "basic/atca_basic.h"
 
 #define ATE_BYTES_PER_RANDOM_NUM    32
-#define ATE_SERIAL_NUM_LEN          9
 
 static uint8_t deviceSerialNumber[ATE_SERIAL_NUM_LEN] = {};
 
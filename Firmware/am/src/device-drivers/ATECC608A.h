@@ -26,6 +26,7 @@
 #define DEVICE_DRIVERS_ATECC608A_H_
 
 #define ATECC_DEVICE_ID         0x6A
+#define ATE_SERIAL_NUM_LEN      9
 
 extern void ATECC_init(void);
 extern void ATECC_printRandomNum(void);
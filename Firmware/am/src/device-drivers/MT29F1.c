@@ -31,6 +31,7 @@
 	ReturnType FlashWriteDisable(void);
 	ReturnType FlashBlockErase(uAddrType udBlockAddr);
 	ReturnType FlashPageRead(uAddrType udAddr, NMX_uint8 *pArray);
+	ReturnType FlashPageReadSequential(uAddrType udAddr, NMX_uint8 *pArray, NMX_uint32 udNrOfPages);
 	ReturnType FlashPageReadDual(uAddrType udAddr, NMX_uint8 *pArray);
 	ReturnType FlashPageReadQuad(uAddrType udAddr, NMX_uint8 *pArray);
 	ReturnType FlashReadDeviceIdentification(NMX_uint16 *uwpDeviceIdentification);
@@ -51,8 +52,15 @@
 #include "logTypes.h"
 #include "string.h"
 #include "spi.h"
+#include "FreeRTOS.h"
+#include "task.h"
 #include <MT29F1.h>
 
+/* Status polls made back to back before the task starts sleeping a tick between polls. Covers a page
+ * read (tRD) and a typical page program (tPROG) so those are not stretched out to a whole tick, block
+ * erases and operations that overrun give the CPU away while they run */
+#define BUSY_SPIN_POLLS         128
+
 #ifdef MT29F1G01
 /*
  *
@@ -222,14 +230,24 @@ int IsFlashBusy()
  * ReturnType WAIT_EXECUTION_COMPLETE(uint16_t second)
  *
  * (This is not an api function)
+ *
+ * There is no ready line on the SPI bus, so completion is still found by polling the status register.
+ * After BUSY_SPIN_POLLS the calling task sleeps a tick between polls instead of spinning.
  */
 static inline mt29f_status_t WAIT_EXECUTION_COMPLETE(uint16_t second)
 {
-    FlashTimeOut(0);
+    TickType_t start = xTaskGetTickCount();
+    uint16_t polls = 0;
+
     while(IsFlashBusy())
     {
-        if(Flash_OperationTimeOut == FlashTimeOut(second))
+        if((xTaskGetTickCount() - start) >= pdMS_TO_TICKS((uint32_t)second * 1000u))
             return  Flash_OperationTimeOut;
+
+        if(polls < BUSY_SPIN_POLLS)
+            polls++;
+        else
+            vTaskDelay(1);
     }
     return Flash_Success;
 }
@@ -451,7 +469,7 @@ mt29f_status_t FlashBlockErase(uAddrType udBlockAddr)
  *
  * Function:		FlashPageRead()
  * Arguments:		uAddrType udAddr, NMX_uint8 *pArray
- * Return Value:	Flash_AddressInvalid, Flash_Success
+ * Return Value:	Flash_AddressInvalid, Flash_OperationTimeOut, Flash_Success
  * Description:
  *
  * The PAGE READ (13h) command transfers the data from the NAND Flash array to the
@@ -512,7 +530,84 @@ mt29f_status_t FlashPageRead(uAddrType udAddr, uint8_t *pArray)
     char_stream_recv.pChar    = pArray;
 
     // Step 6: Send the packet serially, and fill the buffer with the data being returned
-    SPI_nandTransfer(&char_stream_send, &char_stream_recv, OpsEndTransfer);
+    if(SPI_nandTransfer(&char_stream_send, &char_stream_recv, OpsEndTransfer) != spiSuccess)
+        return Flash_OperationTimeOut;
+
+    return Flash_Success;
+}
+
+/******************************************************************************
+ *
+ * Function:		FlashPageReadSequential()
+ * Arguments:		uAddrType udAddr, NMX_uint8 *pArray, NMX_uint32 udNrOfPages
+ * Return Value:	Flash_AddressInvalid, Flash_OperationTimeOut, Flash_Success
+ * Description:
+ *
+ * Read udNrOfPages consecutive pages of one block, starting at udAddr, with the
+ * cache read commands:
+ *
+ *  13h (PAGE READ to cache) for the first page
+ *  31h (PAGE READ CACHE SEQUENTIAL) moves the page into the cache register and
+ *   starts reading the next page from the array into the data register
+ *  03h (READ FROM CACHE) reads the page out while the next one is loading
+ *  3Fh (PAGE READ CACHE LAST) moves the last page into the cache register
+ *
+ * The array read of every page after the first overlaps the SPI transfer of the
+ * page before it, and the row address is only sent once.
+ *
+ * Only available on devices with the cache read commands, see
+ * MT29F1_CACHE_READ_DEVICE_ID.
+ ******************************************************************************/
+mt29f_status_t FlashPageReadSequential(uAddrType udAddr, uint8_t *pArray, uint32_t udNrOfPages)
+{
+    spiData_t char_stream_send;
+    spiData_t char_stream_recv;
+    uint8_t  chars[4];
+    uint8_t  cCacheCMD;
+    uint32_t i;
+
+    // Step 1: Validate address input, the sequence can not leave the block
+    if( (udAddr > MAX_ROW_ADDR) || (udNrOfPages == 0) ||
+        (((udAddr & (NUM_PAGE_BLOCK - 1)) + udNrOfPages) > NUM_PAGE_BLOCK) )
+        return Flash_AddressInvalid;
+
+    // Step 2: Read the first page from the array into the cache
+	Build_Row_Stream(udAddr, SPI_NAND_PAGE_READ_INS, chars);
+    char_stream_send.length   = 4;
+    char_stream_send.pChar    = chars;
+
+    SPI_nandTransfer(&char_stream_send, NULL, OpsEndTransfer);
+
+    if(WAIT_EXECUTION_COMPLETE(SE_TIMEOUT) != Flash_Success)
+        return Flash_OperationTimeOut;
+
+    for (i = 0; i < udNrOfPages; i++)
+    {
+        if (udNrOfPages > 1)
+        {
+            // Step 3: Hand this page to the cache register, and start on the next one unless it is the last
+            cCacheCMD = (i < (udNrOfPages - 1)) ? SPI_NAND_PAGE_READ_CACHE_SEQ_INS : SPI_NAND_PAGE_READ_CACHE_LAST_INS;
+
+            char_stream_send.length   = 1;
+            char_stream_send.pChar    = &cCacheCMD;
+
+            SPI_nandTransfer(&char_stream_send, NULL, OpsEndTransfer);
+
+            if(WAIT_EXECUTION_COMPLETE(SE_TIMEOUT) != Flash_Success)
+                return Flash_OperationTimeOut;
+        }
+
+        // Step 4: Read the page out of the cache register
+        Build_Column_Stream(udAddr, SPI_NAND_READ_CACHE_INS, chars);
+        char_stream_send.length   = 4;
+        char_stream_send.pChar    = chars;
+        char_stream_recv.length   = PAGE_DATA_SIZE;
+        char_stream_recv.pChar    = pArray + (i * PAGE_DATA_SIZE);
+
+        // the page data goes by DMA, a transfer that failed or timed out leaves the buffer short
+        if(SPI_nandTransfer(&char_stream_send, &char_stream_recv, OpsEndTransfer) != spiSuccess)
+            return Flash_OperationTimeOut;
+    }
 
     return Flash_Success;
 }
@@ -734,8 +829,10 @@ mt29f_status_t FlashPageProgram(uAddrType udAddr, uint8_t *pArray, uint32_t udNr
     char_stream_send.length   = udNrOfElementsInArray;
     char_stream_send.pChar    = pArray;
 
-    // Step 7: Send the packet (data to be programmed) serially
-    SPI_nandTransfer(&char_stream_send, NULL, OpsEndTransfer);
+    // Step 7: Send the packet (data to be programmed) serially, a cache register that did not get all
+    // of it must not be programmed
+    if(SPI_nandTransfer(&char_stream_send, NULL, OpsEndTransfer) != spiSuccess)
+        return Flash_ProgramFailed;
 	
     // Step 8: Initialize the data (i.e. Instruction) packet to be sent serially
 	Build_Row_Stream(udAddr, SPI_NAND_PROGRAM_EXEC_INS, chars);
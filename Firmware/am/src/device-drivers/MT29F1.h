@@ -75,6 +75,9 @@ typedef uint32_t uAddrType;
 
     #define BLOCK_2_ADDRESS(block)      ((uint32_t) (block << 17))
 
+    /* READ ID of the part that has the page read cache commands (31h/3Fh) - Micron 2Ch, MT29F1G01ABAFD 14h */
+    #define MT29F1_CACHE_READ_DEVICE_ID 0x2C14
+
 #endif
 
 #define SE_TIMEOUT 10 	/* MAX timeout in seconds suggested for Sector Erase Operation */
@@ -121,6 +124,8 @@ enum
     SPI_NAND_BLOCK_ERASE_INS 			= 0xD8,
     SPI_NAND_GET_FEATURE_INS 			= 0x0F,
     SPI_NAND_PAGE_READ_INS 				= 0x13,
+    SPI_NAND_PAGE_READ_CACHE_SEQ_INS 	= 0x31,
+    SPI_NAND_PAGE_READ_CACHE_LAST_INS 	= 0x3F,
     SPI_NAND_PROGRAM_EXEC_INS 			= 0x10,
     SPI_NAND_PROGRAM_LOAD_INS 			= 0x02,
     SPI_NAND_PROGRAM_LOAD_RANDOM_INS 	= 0x84,
@@ -261,6 +266,7 @@ extern mt29f_status_t FlashWriteEnable(void);
 extern mt29f_status_t FlashWriteDisable(void);
 extern mt29f_status_t FlashBlockErase(uAddrType udBlockAddr);
 extern mt29f_status_t FlashPageRead(uAddrType udAddr, uint8_t *pArray);
+extern mt29f_status_t FlashPageReadSequential(uAddrType udAddr, uint8_t *pArray, uint32_t udNrOfPages);
 extern mt29f_status_t FlashPageReadDual(uAddrType udAddr, uint8_t *pArray);
 extern mt29f_status_t FlashPageReadQuad(uAddrType udAddr, uint8_t *pArray, PageReadMode Mode);
 extern mt29f_status_t FlashReadDeviceIdentification(uint16_t *uwpDeviceIdentification);
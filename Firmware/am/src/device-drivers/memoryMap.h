@@ -17,6 +17,11 @@ See Twisthink-SoftwareLicenseAgreement-Auris.docx for details.
 //The FLASH memory layout of the NAND flash chip
 //Sections must start and end on page boundaries
 
+//device config snapshot plus journal of changes, two blocks used ping-pong by the config journal.
+//Managed page by page, not through Section_Map
+#define APP_MEM_ADR_CONFIG_JOURNAL_START                 0x00000000 //block 0 - 1
+#define APP_MEM_ADR_CONFIG_JOURNAL_END                   0x0003FFFF
+
 #define APP_MEM_ADR_CONFIG_START                         0x00042000 //block 2
 #define APP_MEM_ADR_CONFIG_END                           0x00044048
 
@@ -28,6 +33,10 @@ See Twisthink-SoftwareLicenseAgreement-Auris.docx for details.
 #define APP_MEM_FW_REGISTRY_START                        0x000C0000
 #define APP_MEM_FW_REGISTRY_END                          0x000DFFFF
 
+//outbound MQTT messages waiting on a PUBACK. Managed page by page by the outbox, not through Section_Map
+#define APP_MEM_ADR_MQTT_OUTBOX_START                    0x000E0000 //block 7 - 10
+#define APP_MEM_ADR_MQTT_OUTBOX_END                      0x0015FFFF
+
 #define APP_MEM_ADR_FW_APPLICATION_AM_A_START            0x00160000 //block 10 - 16
 #define APP_MEM_ADR_FW_APPLICATION_AM_A_END              0x0023FFFF
 
@@ -42,6 +51,14 @@ See Twisthink-SoftwareLicenseAgreement-Auris.docx for details.
 #define APP_MEM_ADR_FW_APPLICATION_SSM_B_START           0x00350000
 #define APP_MEM_ADR_FW_APPLICATION_SSM_B_END             0x0038FFFF
 
+//OTA download checkpoints, so a dropped download continues where it stopped. Managed page by page by otaUpdate
+#define APP_MEM_ADR_OTA_PROGRESS_START                   0x003A0000 //block 29
+#define APP_MEM_ADR_OTA_PROGRESS_END                     0x003BFFFF
+
+//sealed TLS session for resumption on the next connection. Managed page by page by the session cache
+#define APP_MEM_ADR_TLS_SESSION_START                    0x003C0000 //block 30
+#define APP_MEM_ADR_TLS_SESSION_END                      0x003DFFFF
+
 #define APP_MEM_NUM_SECTIONS                             7
 
 #define APP_MEM_ADR_MAGIC_VALUE                          0x00400000
@@ -43,6 +43,7 @@
 #include <stdlib.h>
 
 #define SSM_TASK_POLLING_RATE_MS                 100
+#define SSM_MSG_QUEUE_LEN                        3
 #define MIN_RED_FLAG_ON_THRESH                   0
 #define MAX_RED_FLAG_ON_THRESH                   100
 #define MIN_RED_FLAG_OFF_THRESH                  0
@@ -68,6 +69,8 @@ typedef enum
 static asp_attn_source_payload_t ssmAttentionSrcList;
 static aspMessageCode_t ssmOperationSuccess = BAD_REQUEST;
 static QueueHandle_t ssmMsgQueue;
+static StaticQueue_t ssmMsgQueueBuffer;
+static uint8_t ssmMsgQueueStorage[ SSM_MSG_QUEUE_LEN * sizeof( ssmCmds_t ) ];
 
 static ssmCmds_t xCurrentCmd;
 static asp_status_payload_t xCurrentStatus;
@@ -96,7 +99,7 @@ void SSM_Init(void)
 
     //init queue for app to issue commands to SSM
     //This allows the app to talk to the SSM without blocking on responses
-    ssmMsgQueue = xQueueCreate( 3, sizeof( ssmCmds_t ) );
+    ssmMsgQueue = xQueueCreateStatic( SSM_MSG_QUEUE_LEN, sizeof( ssmCmds_t ), ssmMsgQueueStorage, &ssmMsgQueueBuffer );
 
     if ( ssmMsgQueue == NULL )
     {
@@ -634,7 +637,7 @@ static void SSM_initHw(void)
     CLI_Command_Handler_s cmdHandler;
     cmdHandler.ptrFunction = &commandHandlerForSsm;
     cmdHandler.cmdString   = "ssm";
-    cmdHandler.usageString = "\n\r\tmux [on off] \n\r\tboot [on off] \n\r\tuart \n\r\tstatus \n\r\tr \n\r\treset\n\r\tsensorDataEntries\n\r\tgetSensorData [num entries] \n\r\ttime [epoch (hex)]";
+    cmdHandler.usageString = "\n\r\tmux [on off] \n\r\tboot [on off] \n\r\tuart \n\r\tstatus \n\r\tr \n\r\treset\n\r\tlink\n\r\tsensorDataEntries\n\r\tgetSensorData [num entries] \n\r\ttime [epoch (hex)]";
     CLI_registerThisCommandHandler(&cmdHandler);
 }
 
@@ -838,6 +841,17 @@ static void commandHandlerForSsm(int argc, char **argv)
                                             p_status.timestamp,
                                             p_status.errorBits,
                                             p_status.activatedState);
+            //the loop max is never 0 once the SSM is running, so all 0 is an SSM without the profile
+            if ( (p_status.algoMeanUs == 0u) && (p_status.algoMaxUs == 0u) && (p_status.loopMaxUs == 0u) )
+            {
+                elogInfo("SSM Algo: not reported\n\r");
+            }
+            else
+            {
+                elogInfo("SSM Algo: mean %u us, max %u us\n\rSSM Loop: max %u us\n\r", p_status.algoMeanUs,
+                                                p_status.algoMaxUs,
+                                                p_status.loopMaxUs);
+            }
 
 
             if ( p_status.ssmFwVersion.fwMaj == VERSION_MAJOR && p_status.ssmFwVersion.fwMin == VERSION_MINOR
@@ -866,6 +880,10 @@ static void commandHandlerForSsm(int argc, char **argv)
             elogError("SSM reset failed, error code %d ", ssmOperationSuccess);
         }
     }
+    else if ( argc == ONE_ARGUMENT && 0 == strcmp(argv[FIRST_ARG_IDX], "link") )
+    {
+        ASP_ReportLinkStats();
+    }
     else if ( argc == ONE_ARGUMENT && 0 == strcmp(argv[FIRST_ARG_IDX], "sensorDataEntries") )
     {
         asp_number_data_entries_payload_t logEntries;
@@ -32,24 +32,25 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "logTypes.h"
+#include "spscRing.h"
 #include <CLI.h>
 
 #define MAX_USER_INPUT_BYTES            50
+#define CLI_RX_RING_BYTES               64
 #define QUEUE_TIMEOUT_IN_MS             1000
 #define MAX_REGISTERED_HANDLERS         24
 #define DEFAULT_HANDLER_IDX             (MAX_REGISTERED_HANDLERS - 1)
 #define MAXARGS                         12
 #define CLI_PRINT_MAX_LINE              250
 #define CHAR_WAIT_TIMEOUT_MS            1000
-#define CLI_TASK_POLL_RATE_MS           30
+#define CLI_TASK_CHECK_IN_RATE_MS       1000
 #define CLI_MSG_LEN                     9
 
 static CLI_Command_Handler_s  Handler_List[MAX_REGISTERED_HANDLERS] = {{0}};
-uint8_t userInputBuffer[MAX_USER_INPUT_BYTES];
+RING_DEFINE_STORAGE(userInputStorage, CLI_RX_RING_BYTES);
+static spscRing_t userInputRing;
 static uint8_t commandBuffer[MAX_USER_INPUT_BYTES];
 static uint8_t commandBufferIdx = 0;
-uint8_t userInputBufferHeadIdx = 0u;
-uint8_t userInputBufferTailIdx = 0u;
 static char charLineBuf[CLI_PRINT_MAX_LINE];
 static char cliMsg[CLI_MSG_LEN] = "\r\nAM CLI>";
 uint8_t byteReceived = 0;
@@ -64,22 +65,18 @@ static void xDefaultCommandHandler(int argc, char **argv);
 static void xCliTestCommandHandler(int argc, char **argv);
 
 //Interrupt callback function for received characters. Add character to
-//buffer and kick off another receive. The buffer is processed in the task
-//starting at the tail index.
+//the ring, which wakes the task if it was empty, and kick off another receive.
 void CLI_charReceivedCb(void)
 {
-    //buffer up received data for the task to parse
-    userInputBuffer[userInputBufferHeadIdx] = byteReceived;
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
 
-    userInputBufferHeadIdx++;
-
-    if(userInputBufferHeadIdx >= MAX_USER_INPUT_BYTES )
-    {
-        userInputBufferHeadIdx = 0;
-    }
+    //buffer up received data for the task to parse, dropped if the task is that far behind
+    RING_putFromIsr(&userInputRing, byteReceived, &higherPriorityTaskWoken);
 
     //receive another byte
     UART_recieveDataNonBlocking(CLI, &byteReceived, 1);
+
+    portYIELD_FROM_ISR(higherPriorityTaskWoken);
 }
 
 
@@ -93,22 +90,11 @@ void CLI_commandLineHandler_task()
 
     while(1)
     {
-        //if we have new data in the buffer, process it
-        if ( userInputBufferHeadIdx != userInputBufferTailIdx)
+        //sleep until a char comes in, wake up once in a while to check in
+        if ( RING_waitForData(&userInputRing, pdMS_TO_TICKS(CLI_TASK_CHECK_IN_RATE_MS)) == true )
         {
-            while (userInputBufferHeadIdx != userInputBufferTailIdx )
+            while ( RING_read(&userInputRing, &commandBuffer[commandBufferIdx], 1) == 1 )
             {
-                //build a command
-                commandBuffer[commandBufferIdx] = userInputBuffer[userInputBufferTailIdx];
-
-                userInputBufferTailIdx++;
-
-                //make sure there hasnt been an overflow
-                if(userInputBufferTailIdx >= MAX_USER_INPUT_BYTES)
-                {
-                    userInputBufferTailIdx = 0u;
-                }
-
                 //echo the char
                 UART_sendDataBlocking(CLI, &commandBuffer[commandBufferIdx], 1);
 
@@ -141,8 +127,6 @@ void CLI_commandLineHandler_task()
         }
 
         TM_cliTaskCheckIn();
-
-        vTaskDelay(CLI_TASK_POLL_RATE_MS);
     }
 }
 
@@ -166,6 +150,9 @@ void CLI_init(void)
     CLI_registerThisCommandHandler(&cliTestCmdHandler);
     xRegisterThisDefaultCommandHandler(&cmdHandler);
 
+    //chars are passed from the receive interrupt to this task
+    RING_init(&userInputRing, userInputStorage, CLI_RX_RING_BYTES, xTaskGetCurrentTaskHandle());
+
     //init the uart peripheral
     UART_initCliUart();
 
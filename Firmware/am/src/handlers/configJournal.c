@@ -0,0 +1,468 @@
+/**************************************************************************************************
+* \file     configJournal.c
+* \brief    Journaled storage for the device configs. A snapshot of the configs plus a journal of the
+*           bytes that changed since, so a config update costs one NAND page instead of a block cycle.
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+/* Includes */
+#include "stdbool.h"
+#include "string.h"
+#include "logTypes.h"
+#include "MT29F1.h"
+#include "memoryMap.h"
+#include "flashHandler.h"
+#include "configJournal.h"
+
+// Layout of the journal region, two blocks used in turn:
+//
+//   page 0         snapshot - the whole image and the generation it starts
+//   pages 1 - 63   journal records, one per page. Each holds the byte runs that changed since the record
+//                  before it: { offset (2 bytes), length (1 byte), new bytes }...
+//
+// The block with the newest valid snapshot is the active one, the image is rebuilt by replaying its
+// records in page order. Compacting erases the other block and writes a snapshot with the next generation
+// there, the old block stays readable until the new snapshot has been verified. Every page is programmed
+// once after its block is erased and read back, a power loss can only damage the page being written.
+#define CFGJ_NUM_BLOCKS                     2
+#define CFGJ_SNAPSHOT_PAGE                  0
+#define CFGJ_FIRST_RECORD_PAGE              1
+#define CFGJ_NO_BLOCK                       0xFF
+
+#define CFGJ_SNAPSHOT_MAGIC                 0x43464753ul
+#define CFGJ_RECORD_MAGIC                   0x4346474Aul
+#define CFGJ_ERASED_BYTE                    0xFF
+
+//a run costs an offset and a length, unchanged gaps shorter than that are cheaper to copy than to split on
+#define CFGJ_RUN_HEADER_BYTES               3
+#define CFGJ_MAX_RUN_LEN                    255
+
+//header at the start of the snapshot page and of every record page
+typedef struct __attribute__ ((__packed__))
+{
+    uint32_t magic;
+    uint32_t generation;
+    uint16_t dataLen;
+    uint16_t crc;
+}cfgjRecordHeader_t;
+
+#define CFGJ_RECORD_MAX_BYTES               (sizeof(cfgjRecordHeader_t) + CFGJ_MAX_IMAGE_LEN + 64)
+#define CFGJ_RECORD_MAX_DATA                (CFGJ_RECORD_MAX_BYTES - sizeof(cfgjRecordHeader_t))
+
+//image as it is stored on NAND (snapshot + replayed records)
+static uint8_t shadowImage[CFGJ_MAX_IMAGE_LEN];
+static uint16_t shadowImageLen = 0u;
+
+//one snapshot or record as laid out in the page, used to build and to read back records
+static uint8_t recordBuffer[CFGJ_RECORD_MAX_BYTES];
+
+static uint8_t activeBlock = CFGJ_NO_BLOCK;
+static uint32_t generation = 0u;
+static uint8_t nextPage = NUM_PAGE_BLOCK;     // next free record page in the active block
+
+static bool xReadRecord(uint8_t block, uint8_t page, bool *isBlank);
+static bool xIsRecordValid(uint32_t magic);
+static bool xProgramRecord(uint8_t block, uint8_t page, uint32_t magic, uint16_t dataLen);
+static bool xApplyRecord(void);
+static uint16_t xBuildRecord(const uint8_t *image);
+static uint32_t xPageAddress(uint8_t block, uint8_t page);
+static uint16_t xCrc16(uint16_t crc, const uint8_t* data_p, uint32_t length);
+
+// Find the newest snapshot and replay its records. Returns false if there is no valid snapshot, the first
+// commit then writes one.
+bool CFGJ_init(uint16_t imageLen)
+{
+    cfgjRecordHeader_t *hdr = (cfgjRecordHeader_t *)recordBuffer;
+    uint32_t newestGeneration = 0u;
+    uint8_t applied = 0u;
+    uint8_t skipped = 0u;
+    bool isBlank;
+
+    activeBlock = CFGJ_NO_BLOCK;
+    nextPage = NUM_PAGE_BLOCK;
+
+    if ( imageLen > CFGJ_MAX_IMAGE_LEN )
+    {
+        elogError("CFGJ: image too large");
+        shadowImageLen = 0u;
+        return false;
+    }
+
+    shadowImageLen = imageLen;
+
+    for ( uint8_t block = 0u; block < CFGJ_NUM_BLOCKS; block++ )
+    {
+        if ( (xReadRecord(block, CFGJ_SNAPSHOT_PAGE, &isBlank) == true) &&
+             (xIsRecordValid(CFGJ_SNAPSHOT_MAGIC) == true) &&
+             (hdr->dataLen == shadowImageLen) )
+        {
+            if ( (activeBlock == CFGJ_NO_BLOCK) || ((int32_t)(hdr->generation - newestGeneration) > 0) )
+            {
+                activeBlock = block;
+                newestGeneration = hdr->generation;
+            }
+        }
+    }
+
+    if ( activeBlock == CFGJ_NO_BLOCK )
+    {
+        elogNotice("CFGJ: no snapshot");
+        return false;
+    }
+
+    //load the snapshot
+    xReadRecord(activeBlock, CFGJ_SNAPSHOT_PAGE, &isBlank);
+    memcpy(shadowImage, recordBuffer + sizeof(cfgjRecordHeader_t), shadowImageLen);
+    generation = newestGeneration;
+    nextPage = CFGJ_FIRST_RECORD_PAGE;
+
+    //and replay the records. A page damaged by a power loss is skipped, the writer moved past it too
+    for ( uint8_t page = CFGJ_FIRST_RECORD_PAGE; page < NUM_PAGE_BLOCK; page++ )
+    {
+        if ( xReadRecord(activeBlock, page, &isBlank) == false )
+        {
+            nextPage = page + 1u;
+            skipped++;
+        }
+        else if ( isBlank == false )
+        {
+            nextPage = page + 1u;
+
+            if ( (xIsRecordValid(CFGJ_RECORD_MAGIC) == true) && (xApplyRecord() == true) )
+            {
+                applied++;
+            }
+            else
+            {
+                skipped++;
+            }
+        }
+    }
+
+    elogInfo("CFGJ: generation %lu, %u records replayed, %u skipped", generation, applied, skipped);
+
+    return true;
+}
+
+// Copy out the image as stored.
+bool CFGJ_read(uint8_t *image, uint16_t imageLen)
+{
+    if ( (image == NULL) || (activeBlock == CFGJ_NO_BLOCK) || (imageLen != shadowImageLen) )
+    {
+        return false;
+    }
+
+    memcpy(image, shadowImage, shadowImageLen);
+
+    return true;
+}
+
+// Store the bytes of image that differ from what is stored. Costs one page program, or a compaction when
+// the active block has no free pages left.
+cfgjResult_t CFGJ_commit(const uint8_t *image, uint16_t imageLen)
+{
+    uint16_t dataLen;
+    uint8_t page;
+
+    if ( (image == NULL) || (imageLen != shadowImageLen) || (shadowImageLen == 0u) )
+    {
+        return CFGJ_ERROR;
+    }
+
+    if ( activeBlock == CFGJ_NO_BLOCK )
+    {
+        return (CFGJ_compact(image, imageLen) == true) ? CFGJ_COMPACTED : CFGJ_ERROR;
+    }
+
+    if ( memcmp(image, shadowImage, shadowImageLen) == 0 )
+    {
+        //nothing changed
+        return CFGJ_SUCCESS;
+    }
+
+    while ( nextPage < NUM_PAGE_BLOCK )
+    {
+        dataLen = xBuildRecord(image);
+
+        if ( dataLen == 0u )
+        {
+            //too many changes for one record, a snapshot is the smaller write anyway
+            break;
+        }
+
+        page = nextPage++;
+
+        if ( xProgramRecord(activeBlock, page, CFGJ_RECORD_MAGIC, dataLen) == true )
+        {
+            //apply what was read back, so the shadow is exactly what a replay will produce
+            if ( xApplyRecord() == true )
+            {
+                return CFGJ_SUCCESS;
+            }
+        }
+
+        elogNotice("CFGJ: record page %u unusable", page);
+    }
+
+    return (CFGJ_compact(image, imageLen) == true) ? CFGJ_COMPACTED : CFGJ_ERROR;
+}
+
+// Write image as the snapshot of the next generation into the other block. The current block is left
+// untouched, so if this fails the stored image is still the last one committed.
+bool CFGJ_compact(const uint8_t *image, uint16_t imageLen)
+{
+    uint8_t targetBlock = (activeBlock == 0u) ? 1u : 0u;
+    uint32_t targetGeneration = generation + 1u;
+
+    if ( (image == NULL) || (imageLen != shadowImageLen) || (shadowImageLen == 0u) )
+    {
+        return false;
+    }
+
+    if ( FLASH_erase(xPageAddress(targetBlock, CFGJ_SNAPSHOT_PAGE), BLOCK_SIZE) != FLASH_SUCCESS )
+    {
+        elogError("CFGJ: erase failed");
+        return false;
+    }
+
+    memcpy(recordBuffer + sizeof(cfgjRecordHeader_t), image, imageLen);
+
+    //the generation is part of the header that is built here
+    generation = targetGeneration;
+
+    if ( xProgramRecord(targetBlock, CFGJ_SNAPSHOT_PAGE, CFGJ_SNAPSHOT_MAGIC, imageLen) == false )
+    {
+        generation = targetGeneration - 1u;
+        elogError("CFGJ: snapshot failed");
+        return false;
+    }
+
+    memcpy(shadowImage, image, imageLen);
+    activeBlock = targetBlock;
+    nextPage = CFGJ_FIRST_RECORD_PAGE;
+
+    elogInfo("CFGJ: compacted to block %u, generation %lu", activeBlock, generation);
+
+    return true;
+}
+
+uint8_t CFGJ_getFreeRecords(void)
+{
+    return (activeBlock == CFGJ_NO_BLOCK) ? 0u : (uint8_t)(NUM_PAGE_BLOCK - nextPage);
+}
+
+uint8_t CFGJ_getMaxRecords(void)
+{
+    return (uint8_t)(NUM_PAGE_BLOCK - CFGJ_FIRST_RECORD_PAGE);
+}
+
+uint32_t CFGJ_getGeneration(void)
+{
+    return generation;
+}
+
+// Read the header and data of one page into recordBuffer. isBlank is set when the header was never programmed.
+static bool xReadRecord(uint8_t block, uint8_t page, bool *isBlank)
+{
+    cfgjRecordHeader_t *hdr = (cfgjRecordHeader_t *)recordBuffer;
+    uint16_t i;
+
+    *isBlank = false;
+
+    if ( FLASH_read(xPageAddress(block, page), recordBuffer, sizeof(cfgjRecordHeader_t)) != FLASH_SUCCESS )
+    {
+        return false;
+    }
+
+    *isBlank = true;
+
+    for ( i = 0u; i < sizeof(cfgjRecordHeader_t); i++ )
+    {
+        if ( recordBuffer[i] != CFGJ_ERASED_BYTE )
+        {
+            *isBlank = false;
+            break;
+        }
+    }
+
+    if ( (*isBlank == true) || (hdr->dataLen > CFGJ_RECORD_MAX_DATA) )
+    {
+        //nothing more to read, the validity check rejects the length
+        return true;
+    }
+
+    return ( FLASH_read(xPageAddress(block, page) + sizeof(cfgjRecordHeader_t), recordBuffer + sizeof(cfgjRecordHeader_t), hdr->dataLen) == FLASH_SUCCESS );
+}
+
+static bool xIsRecordValid(uint32_t magic)
+{
+    cfgjRecordHeader_t *hdr = (cfgjRecordHeader_t *)recordBuffer;
+    uint16_t crc;
+
+    if ( (hdr->magic != magic) || (hdr->dataLen > CFGJ_RECORD_MAX_DATA) )
+    {
+        return false;
+    }
+
+    //records of an older generation can be left over in a block whose erase was cut short
+    if ( (magic == CFGJ_RECORD_MAGIC) && (hdr->generation != generation) )
+    {
+        return false;
+    }
+
+    crc = xCrc16(0xFFFF, recordBuffer, sizeof(cfgjRecordHeader_t) - sizeof(hdr->crc));
+    crc = xCrc16(crc, recordBuffer + sizeof(cfgjRecordHeader_t), hdr->dataLen);
+
+    return ( crc == hdr->crc );
+}
+
+// Fill in the header for the dataLen bytes already in recordBuffer, program the page and read it back.
+static bool xProgramRecord(uint8_t block, uint8_t page, uint32_t magic, uint16_t dataLen)
+{
+    cfgjRecordHeader_t *hdr = (cfgjRecordHeader_t *)recordBuffer;
+    bool isBlank;
+
+    hdr->magic = magic;
+    hdr->generation = generation;
+    hdr->dataLen = dataLen;
+    hdr->crc = xCrc16(0xFFFF, recordBuffer, sizeof(cfgjRecordHeader_t) - sizeof(hdr->crc));
+    hdr->crc = xCrc16(hdr->crc, recordBuffer + sizeof(cfgjRecordHeader_t), dataLen);
+
+    if ( FLASH_programPage(xPageAddress(block, page), recordBuffer, sizeof(cfgjRecordHeader_t) + dataLen) != FLASH_SUCCESS )
+    {
+        return false;
+    }
+
+    //a page that looked blank may still hold bits from a program that was cut short, only trust what reads back
+    memset(recordBuffer, 0, sizeof(cfgjRecordHeader_t));
+
+    if ( xReadRecord(block, page, &isBlank) == false )
+    {
+        return false;
+    }
+
+    return ( (isBlank == false) && (xIsRecordValid(magic) == true) && (hdr->dataLen == dataLen) );
+}
+
+// Apply the runs of the record in recordBuffer to the shadow image. Nothing is applied unless every run fits.
+static bool xApplyRecord(void)
+{
+    cfgjRecordHeader_t *hdr = (cfgjRecordHeader_t *)recordBuffer;
+    uint8_t *data = recordBuffer + sizeof(cfgjRecordHeader_t);
+    uint16_t offset;
+    uint8_t runLen;
+    uint16_t pos;
+
+    for ( pos = 0u; pos < hdr->dataLen; pos += CFGJ_RUN_HEADER_BYTES + runLen )
+    {
+        if ( (pos + CFGJ_RUN_HEADER_BYTES) > hdr->dataLen )
+        {
+            return false;
+        }
+
+        offset = (uint16_t)data[pos] | ((uint16_t)data[pos + 1u] << 8);
+        runLen = data[pos + 2u];
+
+        if ( (runLen == 0u) || ((offset + runLen) > shadowImageLen) || ((pos + CFGJ_RUN_HEADER_BYTES + runLen) > hdr->dataLen) )
+        {
+            return false;
+        }
+    }
+
+    for ( pos = 0u; pos < hdr->dataLen; pos += CFGJ_RUN_HEADER_BYTES + runLen )
+    {
+        offset = (uint16_t)data[pos] | ((uint16_t)data[pos + 1u] << 8);
+        runLen = data[pos + 2u];
+
+        memcpy(&shadowImage[offset], &data[pos + CFGJ_RUN_HEADER_BYTES], runLen);
+    }
+
+    return true;
+}
+
+// Encode the differences between image and the shadow into recordBuffer. Returns the data length, 0 if
+// they do not fit in one record.
+static uint16_t xBuildRecord(const uint8_t *image)
+{
+    uint8_t *data = recordBuffer + sizeof(cfgjRecordHeader_t);
+    uint16_t dataLen = 0u;
+    uint16_t start;
+    uint16_t lastDiff;
+    uint16_t i = 0u;
+    uint16_t j;
+    uint8_t runLen;
+
+    while ( i < shadowImageLen )
+    {
+        if ( image[i] == shadowImage[i] )
+        {
+            i++;
+            continue;
+        }
+
+        //grow the run until the bytes have been unchanged for longer than a run header
+        start = i;
+        lastDiff = i;
+
+        for ( j = i + 1u; (j < shadowImageLen) && ((j - start) < CFGJ_MAX_RUN_LEN) && ((j - lastDiff) <= CFGJ_RUN_HEADER_BYTES); j++ )
+        {
+            if ( image[j] != shadowImage[j] )
+            {
+                lastDiff = j;
+            }
+        }
+
+        runLen = (uint8_t)(lastDiff + 1u - start);
+
+        if ( (uint32_t)(dataLen + CFGJ_RUN_HEADER_BYTES + runLen) > CFGJ_RECORD_MAX_DATA )
+        {
+            return 0u;
+        }
+
+        data[dataLen++] = (uint8_t)(start & 0xFF);
+        data[dataLen++] = (uint8_t)(start >> 8);
+        data[dataLen++] = runLen;
+        memcpy(&data[dataLen], &image[start], runLen);
+        dataLen += runLen;
+
+        i = lastDiff + 1u;
+    }
+
+    return dataLen;
+}
+
+static uint32_t xPageAddress(uint8_t block, uint8_t page)
+{
+    return APP_MEM_ADR_CONFIG_JOURNAL_START + ((uint32_t)block * BLOCK_SIZE) + ((uint32_t)page * PAGE_DATA_SIZE);
+}
+
+static uint16_t xCrc16(uint16_t crc, const uint8_t* data_p, uint32_t length)
+{
+    uint8_t x;
+
+    while (length--)
+    {
+        x = crc >> 8 ^ *data_p++;
+        x ^= x>>4;
+        crc = (crc << 8) ^ ((uint16_t)(x << 12)) ^ ((uint16_t)(x <<5)) ^ ((uint16_t)x);
+    }
+
+    return crc;
+}
@@ -0,0 +1,50 @@
+/**************************************************************************************************
+* \file     configJournal.h
+* \brief    Journaled storage for the device configs. A snapshot of the configs plus a journal of the
+*           bytes that changed since, so a config update costs one NAND page instead of a block cycle.
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#ifndef HANDLERS_CONFIGJOURNAL_H_
+#define HANDLERS_CONFIGJOURNAL_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+
+//largest image the journal can hold
+#define CFGJ_MAX_IMAGE_LEN                  512
+
+typedef enum
+{
+    CFGJ_SUCCESS = 0,
+    CFGJ_COMPACTED,         // journal was full (or not set up yet), the image was written as a new snapshot
+    CFGJ_ERROR,
+}cfgjResult_t;
+
+//The caller serializes access, none of these functions take a lock of their own
+extern bool CFGJ_init(uint16_t imageLen);
+extern bool CFGJ_read(uint8_t *image, uint16_t imageLen);
+extern cfgjResult_t CFGJ_commit(const uint8_t *image, uint16_t imageLen);
+extern bool CFGJ_compact(const uint8_t *image, uint16_t imageLen);
+extern uint8_t CFGJ_getFreeRecords(void);
+extern uint8_t CFGJ_getMaxRecords(void);
+extern uint32_t CFGJ_getGeneration(void);
+
+#endif /* HANDLERS_CONFIGJOURNAL_H_ */
@@ -22,25 +22,48 @@ See Twisthink-SoftwareLicenseAgreement-Auris.docx for details.
 #include "am-ssm-spi-protocol.h"
 #include "APP_NVM_Cfg_Shared.h"
 #include "memoryMap.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
 #include <flashHandler.h>
 
 //bump this if there is a change to mem map in future versions
 #define FLASH_VERSION           1
+#define FLASH_MUTEX_WAIT_MS     6000
 
 // private functions
+static flashErr_t xFlashWrite(uint32_t addr, uint8_t* data, uint32_t len);
+static flashErr_t xFlashRead(uint32_t addr, uint8_t *data, uint32_t len);
+static flashErr_t xFlashErase(uint32_t addr, uint32_t len);
+static flashErr_t xFlashProgramPage(uint32_t addr, uint8_t* data, uint32_t len);
+static mt29f_status_t xReadPages(uint32_t blockNum, uint32_t pageNum, uint8_t *data, uint32_t numPages);
 static void xNandCommandHandlerFunction(int argc, char **argv);
 
 //this is about 132kB....Holds an entire FLASH block
 //which is the minimum erase size for this chip
 uint8_t blockBuffer[BLOCK_SIZE];
 
+//blockBuffer and the chip itself are shared by every task that touches the NAND
+static SemaphoreHandle_t xFlashMutex;
+static StaticSemaphore_t xFlashMutexBuffer;
+
+//set when the fitted part has the page read cache commands, multi page reads then stream
+static bool xCacheReadSupported = false;
+
 void FLASH_init(void)
 {
     GPIO_InitTypeDef GPIO_InitStruct = {0};
+    uint16_t id = 0u;
+
+    /* create a mutex */
+    xFlashMutex = xSemaphoreCreateMutexStatic(&xFlashMutexBuffer);
 
     /* unlock the registers for writing, enable ECC */
     FlashUnlockAll();
 
+    FlashReadDeviceIdentification(&id);
+    xCacheReadSupported = (id == MT29F1_CACHE_READ_DEVICE_ID);
+    elogInfo("NAND device ID x%x, cache read %s", id, xCacheReadSupported ? "on" : "off");
+
     //set the WP pins high so that writes are not protected physically
     HAL_GPIO_WritePin(GPIOE, GPIO_PIN_9, GPIO_PIN_SET);
     HAL_GPIO_WritePin(GPIOE, GPIO_PIN_10, GPIO_PIN_SET);
@@ -60,6 +83,74 @@ void FLASH_init(void)
 }
 
 flashErr_t FLASH_write(uint32_t addr, uint8_t* data, uint32_t len)
+{
+    flashErr_t err = FLASH_MUTEX_ERR;
+
+    if( xSemaphoreTake(xFlashMutex, ( TickType_t ) FLASH_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        err = xFlashWrite(addr, data, len);
+        xSemaphoreGive(xFlashMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+
+    return err;
+}
+
+flashErr_t FLASH_read(uint32_t addr, uint8_t *data, uint32_t len)
+{
+    flashErr_t err = FLASH_MUTEX_ERR;
+
+    if( xSemaphoreTake(xFlashMutex, ( TickType_t ) FLASH_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        err = xFlashRead(addr, data, len);
+        xSemaphoreGive(xFlashMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+
+    return err;
+}
+
+flashErr_t FLASH_erase(uint32_t addr, uint32_t len)
+{
+    flashErr_t err = FLASH_MUTEX_ERR;
+
+    if( xSemaphoreTake(xFlashMutex, ( TickType_t ) FLASH_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        err = xFlashErase(addr, len);
+        xSemaphoreGive(xFlashMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+
+    return err;
+}
+
+flashErr_t FLASH_programPage(uint32_t addr, uint8_t* data, uint32_t len)
+{
+    flashErr_t err = FLASH_MUTEX_ERR;
+
+    if( xSemaphoreTake(xFlashMutex, ( TickType_t ) FLASH_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        err = xFlashProgramPage(addr, data, len);
+        xSemaphoreGive(xFlashMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+
+    return err;
+}
+
+static flashErr_t xFlashWrite(uint32_t addr, uint8_t* data, uint32_t len)
 {
     int i;
     flashErr_t flashErr = FLASH_GEN_ERROR;
@@ -84,21 +175,12 @@ flashErr_t FLASH_write(uint32_t addr, uint8_t* data, uint32_t len)
         // Get start address of block containing addr
         blockNum = ADDRESS_2_BLOCK(addr);
 
-        // Walk through each page to READ the data
-        for (i = 0; i < BLOCK_SIZE/PAGE_DATA_SIZE; i++)
-        {
-           //build the row address (block + page)
-           Build_RowAddressNoCmd(blockNum, i, &nextPageAddr);
-
-           //read out the next page into the buffer @ the next page index
-           err = FlashPageRead( nextPageAddr, (blockBuffer + (i * PAGE_DATA_SIZE)) );
+        // READ the whole block
+        err = xReadPages(blockNum, 0, blockBuffer, NUM_PAGE_BLOCK);
 
-           // If we had a flash error, bail out of the for loop
-           if (err != Flash_Success)
-           {
-               elogError("FLASH WRITE ERROR");
-               break;
-           }
+        if (err != Flash_Success)
+        {
+            elogError("FLASH WRITE ERROR");
         }
 
         // If we had a flash error, bail out.
@@ -186,7 +268,7 @@ flashErr_t FLASH_write(uint32_t addr, uint8_t* data, uint32_t len)
     return flashErr;
 }
 
-flashErr_t FLASH_read(uint32_t addr, uint8_t *data, uint32_t len)
+static flashErr_t xFlashRead(uint32_t addr, uint8_t *data, uint32_t len)
 {
     mt29f_status_t err = Flash_NoInformationAvailable;
     flashErr_t flashErr;
@@ -271,22 +353,14 @@ flashErr_t FLASH_read(uint32_t addr, uint8_t *data, uint32_t len)
                 pagesRead = NUM_PAGE_BLOCK - pageNum;
             }
 
-            // Walk through each page and read out the contents
-             for (int i = 0; i <  pagesRead; i++)
-             {
-                 //create the address (block + page)
-                 Build_RowAddressNoCmd(blockNum, pageNum+i, &address);
-
-                 // write the next page
-                 err = FlashPageRead( address, blockBuffer + (i * PAGE_DATA_SIZE)+offset);
-
-                 // If we had a flash error, bail out of the for loop
-                 if (err != Flash_Success)
-                 {
-                    elogError("FLASH WRITE ERROR");
-                    break;
-                 }
-             }
+            // read out the contents of the pages
+            err = xReadPages(blockNum, pageNum, blockBuffer + offset, pagesRead);
+
+            if (err != Flash_Success)
+            {
+               elogError("FLASH WRITE ERROR");
+               break;
+            }
         }
 
         tempLen -= PAGE_DATA_SIZE*pagesRead;
@@ -329,6 +403,132 @@ flashErr_t FLASH_read(uint32_t addr, uint8_t *data, uint32_t len)
     return flashErr;
 }
 
+//Erase every block touched by the address range. Unlike FLASH_write this does not
+//preserve the rest of the block - the caller owns the whole block
+static flashErr_t xFlashErase(uint32_t addr, uint32_t len)
+{
+    flashErr_t flashErr = FLASH_GEN_ERROR;
+    mt29f_status_t err = Flash_AddressInvalid;
+    uint32_t blockAddr = 0u;
+    uint16_t block;
+
+    if (len == 0 || addr + (len - 1) > (MT29F1_MAX_ADDR) || (addr + len) < addr)
+    {
+        return FLASH_ADDR_ERR;
+    }
+
+    FlashUnlockAll();
+
+    for (block = ADDRESS_2_BLOCK(addr); block <= ADDRESS_2_BLOCK(addr + (len - 1)); block++)
+    {
+        Build_RowAddressNoCmd(block, 0, &blockAddr);
+
+        err = FlashBlockErase(blockAddr);
+
+        if (err != Flash_Success)
+        {
+            elogError("Erase block %u FAILED", block);
+            break;
+        }
+    }
+
+    switch (err)
+    {
+        case Flash_Success:
+            flashErr = FLASH_SUCCESS;
+            break;
+        case Flash_AddressInvalid:
+            flashErr = FLASH_ADDR_ERR;
+            break;
+        default:
+            flashErr = FLASH_GEN_ERROR;
+            break;
+    }
+
+    return flashErr;
+}
+
+//Program up to one page that has already been erased, starting at the beginning of the page.
+//No read-modify-write of the block, so a power loss can only ever damage this one page
+static flashErr_t xFlashProgramPage(uint32_t addr, uint8_t* data, uint32_t len)
+{
+    flashErr_t flashErr = FLASH_GEN_ERROR;
+    mt29f_status_t err;
+    uint32_t rowAddr = 0u;
+    uint32_t pageStartAddr = 0u;
+
+    if (addr + (len - 1) > (MT29F1_MAX_ADDR) || len > PAGE_DATA_SIZE || len == 0)
+    {
+        return FLASH_ADDR_ERR;
+    }
+
+    Build_Address(ADDRESS_2_BLOCK(addr), ADDRESS_2_PAGE(addr), 0, &pageStartAddr);
+
+    if (pageStartAddr != addr)
+    {
+        return FLASH_ADDR_ERR;
+    }
+
+    FlashUnlockAll();
+
+    Build_RowAddressNoCmd(ADDRESS_2_BLOCK(addr), ADDRESS_2_PAGE(addr), &rowAddr);
+
+    err = FlashPageProgram(rowAddr, data, len);
+
+    switch (err)
+    {
+        case Flash_Success:
+            flashErr = FLASH_SUCCESS;
+            break;
+        case Flash_ProgramFailed:
+            flashErr = FLASH_SPI_ERR;
+            break;
+        case Flash_AddressInvalid:
+            flashErr = FLASH_ADDR_ERR;
+            break;
+        default:
+            flashErr = FLASH_GEN_ERROR;
+            break;
+    }
+
+    if (flashErr)
+    {
+        elogError("Failed to program page");
+    }
+
+    return flashErr;
+}
+
+//Read numPages consecutive pages of one block. Streamed with the cache read commands when the part
+//has them, otherwise one PAGE READ per page
+static mt29f_status_t xReadPages(uint32_t blockNum, uint32_t pageNum, uint8_t *data, uint32_t numPages)
+{
+    mt29f_status_t err = Flash_Success;
+    uint32_t address = 0;
+
+    if (xCacheReadSupported == true && numPages > 1)
+    {
+        Build_RowAddressNoCmd(blockNum, pageNum, &address);
+
+        return FlashPageReadSequential(address, data, numPages);
+    }
+
+    for (uint32_t i = 0; i < numPages; i++)
+    {
+        //create the address (block + page)
+        Build_RowAddressNoCmd(blockNum, pageNum + i, &address);
+
+        err = FlashPageRead(address, data + (i * PAGE_DATA_SIZE));
+
+        if (err != Flash_Success)
+        {
+            break;
+        }
+    }
+
+    return err;
+}
+
 static void xNandCommandHandlerFunction(int argc, char **argv)
 {
     uint16_t id;
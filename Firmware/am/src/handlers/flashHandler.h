@@ -51,5 +51,6 @@ extern void FLASH_init(void);
 extern flashErr_t FLASH_write(uint32_t address, uint8_t* data, uint32_t len);
 extern flashErr_t FLASH_read(uint32_t address, uint8_t *data, uint32_t len);
 extern flashErr_t FLASH_erase(uint32_t address, uint32_t len);
+extern flashErr_t FLASH_programPage(uint32_t address, uint8_t* data, uint32_t len);
 
 #endif /* DEVICE_DRIVERS_FLASHHANDLER_H_ */
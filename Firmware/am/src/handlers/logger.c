@@ -53,6 +53,7 @@ static bool enablePrinting = false;
 static tLogLvl minLevelToPrint = eLogLvlInfo;
 
 SemaphoreHandle_t xLogMutex;
+static StaticSemaphore_t xLogMutexBuffer;
 
 // Local functions
 static void xCommandHandlerForLogger(int argc, char **argv);
@@ -70,7 +71,7 @@ bool LOG_initializeLogger()
     loggerInitialized = true;
 
     /* create a mutex */
-    xLogMutex = xSemaphoreCreateMutex();
+    xLogMutex = xSemaphoreCreateMutexStatic(&xLogMutexBuffer);
 
     return true;
 }
@@ -24,6 +24,7 @@ See Twisthink-SoftwareLicenseAgreement-Auris.docx for details.
 #include "FreeRTOS.h"
 #include "semphr.h"
 #include <flashHandler.h>
+#include "configJournal.h"
 #include "memMapHandler.h"
 
 //bump this if there is a change to mem map in future versions
@@ -39,6 +40,7 @@ static bool xSensorDataIsFull = false;
 static imageRegistry_t appImageRegistry = {};
 
 static SemaphoreHandle_t xMemMapMutex;
+static StaticSemaphore_t xMemMapMutexBuffer;
 
 // private functions
 static bool xIsMagicValuePresent(void);
@@ -52,6 +54,8 @@ static bool xReadCurrentEntry(uint8_t sectionTypeIndex, uint8_t * pBuffer, uint1
 static uint8_t xComputeChecksum(uint8_t * p_bytes, uint16_t num_bytes);
 static bool xVerifyChecksum(uint8_t * p_buf, uint16_t buf_len, uint8_t expected_checksum);
 static bool xUpdateCurrentEntry(uint8_t map_index, uint8_t * p_data_to_write, bool bump_addr);
+static bool xSaveConfigs(void);
+static bool xCompactConfigs(const deviceInfo_t *info);
 static void xMemCommandHandlerFunction(int argc, char **argv);
 
 const deviceInfo_t amDeviceInfoDefault =
@@ -192,11 +196,15 @@ bool MEM_init(void)
 
     memCmdHandler.ptrFunction = &xMemCommandHandlerFunction;
     memCmdHandler.cmdString   = "mem";
-    memCmdHandler.usageString = "\n\r\tdefault";
+    memCmdHandler.usageString = "\n\r\tdefault \n\r\tjournal - config journal usage";
     CLI_registerThisCommandHandler(&memCmdHandler);
 
     /* create a mutex */
-    xMemMapMutex = xSemaphoreCreateMutex();
+    xMemMapMutex = xSemaphoreCreateMutexStatic(&xMemMapMutexBuffer);
+
+    //rebuild the configs from the journal. If it has never been written the configs are read from the
+    //config section below and the first save seeds the journal with them
+    CFGJ_init(sizeof(deviceInfo_t));
 
     //first read out the magic value in flash
     if ( xIsMagicValuePresent() == false )
@@ -256,7 +264,7 @@ void MEM_setResetsSinceLastLpMode(uint8_t resets)
 {
     amConfigsAndInfo.resetsSinceLpMode = resets;
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    xSaveConfigs();
 }
 
 uint32_t MEM_getUnexpectedResetCount(void)
@@ -275,7 +283,7 @@ void MEM_incrementUnexpectedResetCount(uint32_t timestampOfReset)
     amConfigsAndInfo.timeLastUnexpectedReset = timestampOfReset;
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    xSaveConfigs();
 }
 
 uint32_t MEM_getActivationDate(void)
@@ -300,7 +308,7 @@ void MEM_setSecondsToWaitForMfgComplete(uint32_t seconds)
         amConfigsAndInfo.manfCompleteSecsToWait = seconds;
 
         amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-        xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+        xSaveConfigs();
     }
     else
     {
@@ -313,14 +321,14 @@ void MEM_setMfgCompleteFlag(bool isMfgComplete)
     amConfigsAndInfo.manufacturingComplete = isMfgComplete;
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    xSaveConfigs();
 }
 
 void MEM_writeActivationDate(uint32_t date)
 {
     amConfigsAndInfo.recent_act_date = date;
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    xSaveConfigs();
 }
 
 uint32_t MEM_getDeactivationDate(void)
@@ -332,7 +340,7 @@ void MEM_writeDeactivationDate(uint32_t date)
 {
     amConfigsAndInfo.recent_deact_date = date;
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    xSaveConfigs();
 }
 
 uint16_t MEM_getAmWakeRate(void)
@@ -348,7 +356,7 @@ bool MEM_writeAmWakeRate(uint16_t days)
     {
         amConfigsAndInfo.am_wake_rate_days = days;
         amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-        stat = xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+        stat = xSaveConfigs();
     }
 
     return stat;
@@ -367,7 +375,7 @@ bool MEM_writeStrokeDetectionEnabledFlag(bool isStrokeDetEnabled)
     amConfigsAndInfo.isStrokeDetectionEnabled = isStrokeDetEnabled;
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
 
-    stat = xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    stat = xSaveConfigs();
 
     return stat;
 }
@@ -379,7 +387,7 @@ void MEM_setAntennaToUse(antenna_t antenna)
         amConfigsAndInfo.antennaToUse = antenna;
 
         amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-        xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+        xSaveConfigs();
     }
     else
     {
@@ -397,7 +405,7 @@ void MEM_setPrimaryAntennaRssi(uint8_t rssi)
     amConfigsAndInfo.rssiPrimaryAntenna = rssi;
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    xSaveConfigs();
 }
 
 uint8_t MEM_getPrimaryAntennaRssi(void)
@@ -410,7 +418,7 @@ void MEM_setSecondaryAntennaRssi(uint8_t rssi)
     amConfigsAndInfo.rssiSecondaryAntenna = rssi;
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    xSaveConfigs();
 }
 
 void MEM_setEpochTimeLastAntennaSwitch(uint32_t epochTime)
@@ -418,7 +426,7 @@ void MEM_setEpochTimeLastAntennaSwitch(uint32_t epochTime)
     amConfigsAndInfo.epochTimeLastSwitch = epochTime;
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    xSaveConfigs();
 }
 
 uint32_t MEM_getEpochTimeLastAntennaSwitch(void)
@@ -470,7 +478,7 @@ bool MEM_updateMsgNumber(void)
     }
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    stat = xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    stat = xSaveConfigs();
 
     return stat;
 }
@@ -486,7 +494,7 @@ bool  MEM_writeGpsConfigs(uint32_t gpsTimeoutSecs, uint32_t maxdHop, uint32_t mi
     amConfigsAndInfo.minMeasureTime = minMeasTimeSecs;
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    stat = xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    stat = xSaveConfigs();
 
     return stat;
 }
@@ -498,7 +506,7 @@ bool MEM_UpdateGpsCoordinates(GpsMessage latestGpsLocation)
     amConfigsAndInfo.gpsCoordinates = latestGpsLocation;
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    stat = xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    stat = xSaveConfigs();
 
     return stat;
 }
@@ -520,7 +528,7 @@ bool MEM_SetGpsFixedFlag(bool fixPassed)
     amConfigsAndInfo.gpsLocationFixed = fixPassed;
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    stat = xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    stat = xSaveConfigs();
 
     return stat;
 }
@@ -537,7 +545,7 @@ bool MEM_SetGpsSentToCloud(bool sent)
     amConfigsAndInfo.gpsLocationSentToCloud = sent;
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    stat = xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    stat = xSaveConfigs();
 
     return stat;
 }
@@ -554,7 +562,7 @@ bool MEM_SetGpsNumRetries(uint8_t tries)
     amConfigsAndInfo.gpsRetries = tries;
 
     amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-    stat = xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    stat = xSaveConfigs();
 
     return stat;
 }
@@ -585,7 +593,7 @@ extern bool MEM_writeSensorDataLog(APP_NVM_SENSOR_DATA_WITH_HEADER_T *pSensorDat
         amConfigsAndInfo.sensorDataBufferFull = xSensorDataIsFull;
 
         amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-        stat = xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+        stat = xSaveConfigs();
     }
 
     return stat;
@@ -642,7 +650,7 @@ extern bool MEM_updateSensorDataHeadAndLifoCount(void)
         amConfigsAndInfo.sensorDataBufferFull = xSensorDataIsFull;
 
         amConfigsAndInfo.checksum = xComputeChecksum((uint8_t*)&amConfigsAndInfo, sizeof(amConfigsAndInfo)-1);
-        status = xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+        status = xSaveConfigs();
     }
 
     //decrement head for the next read/write since we just popped one off the LIFO
@@ -711,6 +719,19 @@ bool MEM_defaultSection(uint8_t section)
 
             err = FLASH_write( Section_Map[section].start_addr, (uint8_t *) &hdr,  sizeof(flashSectionHeader_t));
         }
+
+        //the configs are read back from the journal, so it has to start over from the defaults too
+        if ( (err == FLASH_SUCCESS) && (section == SECTION_DEVICE_INFO) )
+        {
+            deviceInfo_t defaultInfo = amDeviceInfoDefault;
+
+            defaultInfo.checksum = xComputeChecksum((uint8_t*)&defaultInfo, sizeof(defaultInfo)-1);
+
+            if ( xCompactConfigs(&defaultInfo) == false )
+            {
+                err = FLASH_GEN_ERROR;
+            }
+        }
     }
 
     if (err == FLASH_SUCCESS)
@@ -719,12 +740,31 @@ bool MEM_defaultSection(uint8_t section)
     return status;
 }
 
+// Called before standby. If the config journal is more than half used, compact it now rather than during
+// the next cloud session, and bring the config section up to date so an image without the journal (e.g.
+// after a rollback) still starts from recent configs.
+void MEM_prepareForStandby(void)
+{
+    if ( CFGJ_getFreeRecords() >= (CFGJ_getMaxRecords() / 2) )
+    {
+        return;
+    }
+
+    if ( xCompactConfigs(&amConfigsAndInfo) == true )
+    {
+        xUpdateCurrentEntry((uint8_t)SECTION_DEVICE_INFO,  (uint8_t *) &amConfigsAndInfo, false);
+    }
+}
+
 
 static bool xReadConfigs(void)
 {
     bool stat;
 
-    stat = xReadCurrentEntry((uint8_t)SECTION_DEVICE_INFO, (uint8_t *) &amConfigsAndInfo, sizeof(amConfigsAndInfo));
+    if ( CFGJ_read((uint8_t *) &amConfigsAndInfo, sizeof(amConfigsAndInfo)) == false )
+    {
+        stat = xReadCurrentEntry((uint8_t)SECTION_DEVICE_INFO, (uint8_t *) &amConfigsAndInfo, sizeof(amConfigsAndInfo));
+    }
 
     stat = xVerifyAndCorrectConfigs(&amConfigsAndInfo);
 
@@ -1187,6 +1227,47 @@ static bool xUpdateCurrentEntry(uint8_t map_index, uint8_t * p_data_to_write, bo
     return status;
 }
 
+// Store the RAM copy of the configs. Only the bytes that changed since the last save are written, as one
+// page in the config journal.
+static bool xSaveConfigs(void)
+{
+    cfgjResult_t result = CFGJ_ERROR;
+
+    if( xSemaphoreTake(xMemMapMutex, ( TickType_t ) 6000) == pdTRUE )
+    {
+        result = CFGJ_commit((uint8_t *) &amConfigsAndInfo, sizeof(deviceInfo_t));
+
+        /* Return mutex */
+        xSemaphoreGive(xMemMapMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+
+    return ( result != CFGJ_ERROR );
+}
+
+// Write info as a new journal snapshot, dropping the records before it.
+static bool xCompactConfigs(const deviceInfo_t *info)
+{
+    bool status = false;
+
+    if( xSemaphoreTake(xMemMapMutex, ( TickType_t ) 6000) == pdTRUE )
+    {
+        status = CFGJ_compact((const uint8_t *) info, sizeof(deviceInfo_t));
+
+        /* Return mutex */
+        xSemaphoreGive(xMemMapMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+
+    return status;
+}
+
 // Compute 2 complement checksum.
 static uint8_t xComputeChecksum(uint8_t * p_bytes, uint16_t num_bytes)
 {
@@ -1242,6 +1323,10 @@ static void xMemCommandHandlerFunction(int argc, char **argv)
         xReadConfigs();
         elogInfo("wake rate %d", amConfigsAndInfo.am_wake_rate_days);
     }
+    else if ( (argc == ONE_ARGUMENT) &&  (0 == strcmp(argv[FIRST_ARG_IDX], "journal")) )
+    {
+        elogInfo("generation %lu, %u of %u records free", CFGJ_getGeneration(), CFGJ_getFreeRecords(), CFGJ_getMaxRecords());
+    }
     else
     {
         elogInfo("Invaid args");
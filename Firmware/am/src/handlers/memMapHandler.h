@@ -210,6 +210,7 @@ extern bool MEM_writeSensorDataLog(APP_NVM_SENSOR_DATA_WITH_HEADER_T *pSensorDat
 extern bool MEM_getSensorDataLog(APP_NVM_SENSOR_DATA_WITH_HEADER_T *pSensorData);
 extern  bool MEM_updateSensorDataHeadAndLifoCount(void);
 extern bool MEM_defaultSection(uint8_t section);
+extern void MEM_prepareForStandby(void);
 
 extern uint32_t MEM_getUnexpectedResetCount(void);
 extern uint32_t MEM_getTimestampLastUnexpectedReset(void);
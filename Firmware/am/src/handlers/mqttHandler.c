@@ -43,6 +43,8 @@
 #include "iot_threads.h"
 #include "iot_network_types.h"
 #include "eventManager.h"
+#include "mqttOutbox.h"
+#include "sensorDataEncoder.h"
 #include "queue.h"
 
 /* MQTT include. */
@@ -64,10 +66,30 @@
 
 //there are 2 fixed job related topics and 3 others
 #define TOPIC_FILTER_COUNT                       ( 5 )
+#define MQTT_QUEUE_LEN                           ( 3 )
 #define PUBLISH_RETRY_LIMIT                      ( 10 )
 #define PUBLISH_RETRY_MS                         ( 1000 )
 
+//failed outbox publishes in a row before we stop draining for this connection
+//the records stay in NAND and go out on the next connection
+#define OUTBOX_MAX_FAILURES_PER_SESSION          ( 3 )
+
 #define MAX_MSG_SIZE                            (SensorDataMessage_size)
+
+//Largest encoded size of each cloud message (from the generated messages.pb.h) when the buffers below,
+//the outbox records and the NAND outbox slots were last sized. A schema or nanopb option change that
+//grows one of them stops the build here, so the RAM and NAND cost is looked at before these are bumped.
+#define STATUS_MSG_SIZE_BASELINE                 223
+#define GPS_MSG_SIZE_BASELINE                    273
+#define SENSOR_DATA_MSG_SIZE_BASELINE            993
+
+_Static_assert(StatusMessage_size <= STATUS_MSG_SIZE_BASELINE, "StatusMessage grew, check the publish buffers");
+_Static_assert(GpsMessage_size <= GPS_MSG_SIZE_BASELINE, "GpsMessage grew, check the publish buffers");
+_Static_assert(SensorDataMessage_size <= SENSOR_DATA_MSG_SIZE_BASELINE, "SensorDataMessage grew, check the publish buffers");
+
+//every message is encoded into the same publish buffer and outbox record
+_Static_assert((StatusMessage_size <= MAX_MSG_SIZE) && (GpsMessage_size <= MAX_MSG_SIZE), "publish buffer too small");
+_Static_assert(MAX_MSG_SIZE <= OUTBOX_MAX_PAYLOAD_LEN, "outbox record too small");
 #define MAX_DUID_BYTE_LEN                        30
 #define MAX_TOPIC_LEN                            80
 #define MAX_JOB_TYPE_LEN                         100
@@ -91,6 +113,7 @@ typedef enum
     SEND_JOB_PASS,
     SEND_JOB_FAIL,
     SEND_JOB_FAIL_BAD_CONFIGS,
+    DRAIN_OUTBOX,
 }mqttMsgId_t;
 
 typedef union
@@ -167,6 +190,8 @@ static outgoingJobMessageType_t jsonEncodedRsp =
 
 //queue to unblock this task
 QueueHandle_t mqttQueue;
+static StaticQueue_t mqttQueueBuffer;
+static uint8_t mqttQueueStorage[ MQTT_QUEUE_LEN * sizeof( mqttMsg_t ) ];
 
 //task handle
 TaskHandle_t xMqttHandle;
@@ -192,6 +217,9 @@ static bool takeNewGpsMeasurement = false;
 static char fwUpdateLink[MAX_UPDATE_LINK_LEN] = {};
 static bool xCloudTxInProgress = false;
 
+//record being published from the NAND outbox
+static outboxRecord_t xOutboxRecord;
+
 /* Topics, will be initialized with the DUID provided */
 const char * pTopicStrings[ TOPIC_FILTER_COUNT ] =
 {
@@ -214,6 +242,9 @@ static void xStartNextJobCb( void * param1,
 static void xStartNextJobAcceptRejectCb( void * param1,
                                        IotMqttCallbackParam_t * const pPublish);
 
+static void xOutboxPublishCompleteCb( void * param1,
+                                       IotMqttCallbackParam_t * const pOperation);
+
 static int xNewMqttConnection( bool awsIotMqttMode,
                                      const char * pIdentifier,
                                      void * pNetworkServerInfo,
@@ -233,10 +264,12 @@ static int xDisconnectAndCleanUp(void);
 
 static uint32_t xEncodeStatusMessagePayload(StatusMessage message, uint8_t *buf, uint16_t bufLen);
 static uint32_t xEncodeGpsMessagePayload(GpsMessage message, uint8_t *buf, uint16_t bufLen);
-static uint32_t xEncodeSensorDataMessagePayload(SensorDataMessage message, uint8_t *buf, uint16_t bufLen);
 static bool jsonEncodeJobUpdateMessage(awsJobStatus_t jobStat, jobRequestType_t jobRequest, uint32_t expectedVersion, uint32_t stepTimeoutMins, char *clientToken, bool valid);
 static bool xSendJobUpdate(char * jobId, awsJobStatus_t jobStat, jobRequestType_t jobRequest, uint32_t expectedVersion, uint32_t stepTimeoutMins, char *clientToken, bool valid);
 static bool xSendGetNextJobReq(void);
+static bool xQueueToOutbox(const char *topic, uint8_t *payload, uint32_t payloadLen);
+static void xRequestOutboxDrain(void);
+static void xDrainOutbox(void);
 
 static const char *xJobStatusToString(awsJobStatus_t status);
 static const char *xRequestTypeToString(jobRequestType_t jobRequest);
@@ -328,8 +361,15 @@ void MQTT_task()
 
     if ( status == EXIT_SUCCESS )
     {
-        //Message queue for incoming mqtt messages
-        mqttQueue = xQueueCreate( 3, sizeof( mqttMsg_t ) );
+        //Message queue for incoming mqtt messages - created once, emptied on every reconnect
+        if ( mqttQueue == NULL )
+        {
+            mqttQueue = xQueueCreateStatic( MQTT_QUEUE_LEN, sizeof( mqttMsg_t ), mqttQueueStorage, &mqttQueueBuffer );
+        }
+        else
+        {
+            xQueueReset( mqttQueue );
+        }
 
         if ( mqttQueue == NULL )
         {
@@ -337,6 +377,10 @@ void MQTT_task()
         }
         else
         {
+            //anything left in the outbox from an earlier connection goes out first
+            OUTBOX_resetFailures();
+            xRequestOutboxDrain();
+
             //indicate to the event manager that we are connected to the cloud and available to send messages
             EVT_indicateMqttReady();
         }
@@ -468,6 +512,10 @@ void MQTT_task()
                     xPublishMessage(mqttConnection, xMqttQueueEvt.payload.mqttPulishInfo);
                     break;
 
+                case DRAIN_OUTBOX:
+                    xDrainOutbox();
+                    break;
+
                 default:
                     break;
 
@@ -479,7 +527,7 @@ void MQTT_task()
 //return if we are sending a cloud message or waiting on a response
 bool MQTT_getOperationInProgressFlag(void)
 {
-    return xCloudTxInProgress;
+    return ( xCloudTxInProgress || OUTBOX_isBusy() );
 }
 
 static void xSetTxOperationIp(bool inProgress)
@@ -503,24 +551,32 @@ bool MQTT_sendStatusMsg(StatusMessage statusToSend)
     {
         status = true;
 
-        //set up the publish
-        publishInfo.qos = IOT_MQTT_QOS_0;
-        publishInfo.pTopicName = pTopicStrings[0];
-        publishInfo.topicNameLength = strlen(pTopicStrings[0]);
+        //store it in NAND until the broker acknowledges it
+        if ( xQueueToOutbox(pTopicStrings[0], payloadBufferOutgoingTopic, lenEncoded) == true )
+        {
+            elogInfo("queued status msg to outbox");
+        }
+        else
+        {
+            //outbox not available, send it straight out like before
+            publishInfo.qos = IOT_MQTT_QOS_0;
+            publishInfo.pTopicName = pTopicStrings[0];
+            publishInfo.topicNameLength = strlen(pTopicStrings[0]);
 
-        //fill in the payload with the protobuf
-        publishInfo.pPayload = payloadBufferOutgoingTopic;
-        publishInfo.payloadLength = lenEncoded;
-        publishInfo.retryMs = PUBLISH_RETRY_MS;
-        publishInfo.retryLimit = PUBLISH_RETRY_LIMIT;
+            //fill in the payload with the protobuf
+            publishInfo.pPayload = payloadBufferOutgoingTopic;
+            publishInfo.payloadLength = lenEncoded;
+            publishInfo.retryMs = PUBLISH_RETRY_MS;
+            publishInfo.retryLimit = PUBLISH_RETRY_LIMIT;
 
-        //queue up the msg to be sent out
-        msg.eventID = SEND_STATUS_MSG;
-        msg.payload.mqttPulishInfo = publishInfo;
+            //queue up the msg to be sent out
+            msg.eventID = SEND_STATUS_MSG;
+            msg.payload.mqttPulishInfo = publishInfo;
 
-        elogInfo("queued status msg");
+            elogInfo("queued status msg");
 
-        xQueueSend(mqttQueue, &msg, ( TickType_t ) QUEUE_WAIT_TIME_MS );
+            xQueueSend(mqttQueue, &msg, ( TickType_t ) QUEUE_WAIT_TIME_MS );
+        }
     }
 
     return status;
@@ -542,31 +598,40 @@ bool MQTT_sendGpsMsg(GpsMessage gpsMsgToSend)
     {
         status = true;
 
-        //set up the publish
-        publishInfo.qos = IOT_MQTT_QOS_0;
-        publishInfo.pTopicName = pTopicStrings[1];
-        publishInfo.topicNameLength = strlen(pTopicStrings[1]);
+        //store it in NAND until the broker acknowledges it
+        if ( xQueueToOutbox(pTopicStrings[1], payloadBufferOutgoingTopic, lenEncoded) == true )
+        {
+            elogInfo("queued GPS msg to outbox");
+        }
+        else
+        {
+            //outbox not available, send it straight out like before
+            publishInfo.qos = IOT_MQTT_QOS_0;
+            publishInfo.pTopicName = pTopicStrings[1];
+            publishInfo.topicNameLength = strlen(pTopicStrings[1]);
 
-        //fill in the payload with the protobuf
-        publishInfo.pPayload = payloadBufferOutgoingTopic;
-        publishInfo.payloadLength = lenEncoded;
-        publishInfo.retryMs = PUBLISH_RETRY_MS;
-        publishInfo.retryLimit = PUBLISH_RETRY_LIMIT;
+            //fill in the payload with the protobuf
+            publishInfo.pPayload = payloadBufferOutgoingTopic;
+            publishInfo.payloadLength = lenEncoded;
+            publishInfo.retryMs = PUBLISH_RETRY_MS;
+            publishInfo.retryLimit = PUBLISH_RETRY_LIMIT;
 
-        //queue up the msg to be sent out
-        msg.eventID = SEND_GPS_DATA_MSG;
-        msg.payload.mqttPulishInfo = publishInfo;
+            //queue up the msg to be sent out
+            msg.eventID = SEND_GPS_DATA_MSG;
+            msg.payload.mqttPulishInfo = publishInfo;
 
-        elogInfo("queued GPS msg");
+            elogInfo("queued GPS msg");
 
-        xQueueSend(mqttQueue, &msg, ( TickType_t ) QUEUE_WAIT_TIME_MS );
+            xQueueSend(mqttQueue, &msg, ( TickType_t ) QUEUE_WAIT_TIME_MS );
+        }
     }
 
     return status;
 }
 
 
-bool MQTT_sendSensorDataMsg(SensorDataMessage sensorDataMessageToSend)
+//header is the live part of the message header (rssi, imei, ...), the rest is encoded straight from the log
+bool MQTT_sendSensorDataLog(const CommonHeader *pHeader, const APP_NVM_SENSOR_DATA_WITH_HEADER_T *pLog, bool sendStrokes)
 {
     bool status = false;
     uint32_t lenEncoded = 0;
@@ -576,7 +641,7 @@ bool MQTT_sendSensorDataMsg(SensorDataMessage sensorDataMessageToSend)
     xCleanupTopicBuffer();
 
     //encode the sensor data payload per our mqtt protocol
-    lenEncoded = xEncodeSensorDataMessagePayload(sensorDataMessageToSend, payloadBufferOutgoingTopic, MAX_MSG_SIZE);
+    lenEncoded = SDENC_encodeLog(pHeader, pLog, sendStrokes, payloadBufferOutgoingTopic, MAX_MSG_SIZE);
 
     if (lenEncoded > 0 )
     {
@@ -692,27 +757,84 @@ static uint32_t xEncodeGpsMessagePayload(GpsMessage message, uint8_t *buf, uint1
     return msgLen;
 }
 
-static uint32_t xEncodeSensorDataMessagePayload(SensorDataMessage message, uint8_t *buf, uint16_t bufLen)
+static bool xQueueToOutbox(const char *topic, uint8_t *payload, uint32_t payloadLen)
 {
-    uint32_t msgLen;
-    bool status;
+    bool queued;
 
-    /* Create a stream that will write to our buffer. */
-    pb_ostream_t stream = pb_ostream_from_buffer(buf, bufLen);
+    //QoS 1 so that the record is only retired on a PUBACK
+    queued = OUTBOX_push(topic, (uint8_t)strlen(topic), (uint8_t)IOT_MQTT_QOS_1, payload, (uint16_t)payloadLen);
 
-    /* Now we are ready to encode the message */
-    status = pb_encode(&stream, SensorDataMessage_fields, &message);
-    msgLen = stream.bytes_written;
+    if ( queued == true )
+    {
+        xRequestOutboxDrain();
+    }
 
-    /* Then check for any errors.. */
-    if ( status == false )
+    return queued;
+}
+
+static void xRequestOutboxDrain(void)
+{
+    mqttMsg_t msg;
+
+    //only while connected, otherwise the records wait in NAND for the next connection
+    if ( mqttQueue != NULL && connectionEstablished == true )
     {
-       elogError("Encoding failed: %s\n", PB_GET_ERROR(&stream));
-       msgLen = 0;
+        msg.eventID = DRAIN_OUTBOX;
+        xQueueSend(mqttQueue, &msg, ( TickType_t ) QUEUE_WAIT_TIME_MS );
     }
+}
 
-    //return the message length
-    return msgLen;
+//publish queued records in order, up to OUTBOX_BATCH_SIZE waiting on a PUBACK at a time
+//runs again from the publish complete callback until the outbox is empty
+static void xDrainOutbox(void)
+{
+    IotMqttError_t publishStatus = IOT_MQTT_STATUS_PENDING;
+    IotMqttPublishInfo_t publishInfo = IOT_MQTT_PUBLISH_INFO_INITIALIZER;
+    IotMqttCallbackInfo_t publishComplete = IOT_MQTT_CALLBACK_INFO_INITIALIZER;
+
+    //save the acks from the last pass before sending more
+    OUTBOX_commit();
+
+    if ( OUTBOX_getFailureCount() >= OUTBOX_MAX_FAILURES_PER_SESSION )
+    {
+        return;
+    }
+
+    publishComplete.function = xOutboxPublishCompleteCb;
+
+    while ( OUTBOX_getNextToSend(&xOutboxRecord) == true )
+    {
+        publishInfo.qos = (IotMqttQos_t)xOutboxRecord.qos;
+        publishInfo.pTopicName = xOutboxRecord.topic;
+        publishInfo.topicNameLength = xOutboxRecord.topicLen;
+        publishInfo.pPayload = xOutboxRecord.payload;
+        publishInfo.payloadLength = xOutboxRecord.payloadLen;
+        publishInfo.retryMs = PUBLISH_RETRY_MS;
+        publishInfo.retryLimit = PUBLISH_RETRY_LIMIT;
+
+        if ( publishInfo.qos == IOT_MQTT_QOS_0 )
+        {
+            //no PUBACK will come, retire it once it is handed to the network
+            publishStatus = IotMqtt_Publish( mqttConnection, &publishInfo, 0, NULL, NULL );
+
+            if ( publishStatus == IOT_MQTT_SUCCESS )
+            {
+                OUTBOX_markAcked(xOutboxRecord.seq);
+            }
+        }
+        else
+        {
+            publishComplete.pCallbackContext = (void*)(uintptr_t)xOutboxRecord.seq;
+            publishStatus = IotMqtt_Publish( mqttConnection, &publishInfo, 0, &publishComplete, NULL );
+        }
+
+        if ( publishStatus != IOT_MQTT_STATUS_PENDING && publishStatus != IOT_MQTT_SUCCESS )
+        {
+            elogError( "Outbox PUBLISH returned error %s.", IotMqtt_strerror( publishStatus ) );
+            OUTBOX_markFailed(xOutboxRecord.seq);
+            break;
+        }
+    }
 }
 
 static int xDisconnectAndCleanUp()
@@ -761,6 +883,25 @@ static void xOperationCompleteCb( void * param1, IotMqttCallbackParam_t * const
     }
 }
 
+//PUBACK (or give up) for a record from the outbox, runs in the MQTT library task
+static void xOutboxPublishCompleteCb( void * param1, IotMqttCallbackParam_t * const pOperation )
+{
+    uint32_t seq = (uint32_t)(uintptr_t)param1;
+
+    if( pOperation->u.operation.result == IOT_MQTT_SUCCESS )
+    {
+        OUTBOX_markAcked(seq);
+    }
+    else
+    {
+        elogInfo( "Outbox record %lu could not be sent. Error %s.", seq, IotMqtt_strerror( pOperation->u.operation.result ) );
+        OUTBOX_markFailed(seq);
+    }
+
+    //send the next batch, or journal the acks if that was the last one
+    xRequestOutboxDrain();
+}
+
 //Called by the MQTT library when an incoming PUBLISH message is received.
 //we will use jobs for incoming messages so this is just for debugging
 static void xSubscriptionCb( void * param1, IotMqttCallbackParam_t * const pPublish )
@@ -27,6 +27,7 @@
 
 #include "iot_network.h"
 #include "messages.pb.h"
+#include "APP_NVM_Cfg_Shared.h"
 
 //any app-cloud protocol should go here:
 typedef struct
@@ -51,7 +52,7 @@ extern int MQTT_init( bool awsIotMqttMode,
 
 extern bool MQTT_sendStatusMsg(StatusMessage statusToSend);
 extern bool MQTT_sendGpsMsg(GpsMessage gpsMsgToSend);
-extern bool MQTT_sendSensorDataMsg(SensorDataMessage sensorDataMessageToSend);
+extern bool MQTT_sendSensorDataLog(const CommonHeader *pHeader, const APP_NVM_SENSOR_DATA_WITH_HEADER_T *pLog, bool sendStrokes);
 extern bool MQTT_disconnect(void);
 extern void MQTT_indicateOperationPass(void);
 extern void MQTT_indicateOperationFail(void);
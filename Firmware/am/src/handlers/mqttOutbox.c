@@ -0,0 +1,643 @@
+/**************************************************************************************************
+* \file     mqttOutbox.c
+* \brief    Persistent outbound MQTT queue. Encoded publishes are kept in NAND until the broker
+*           acknowledges them, so they survive resets and coverage gaps.
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+/* Includes */
+#include "stdbool.h"
+#include "string.h"
+#include "logTypes.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "CLI.h"
+#include "MT29F1.h"
+#include "memoryMap.h"
+#include "flashHandler.h"
+#include "mqttOutbox.h"
+
+// Layout of the outbox region:
+//
+//   blocks 0 - 2   records, one per page. Record seq always lives in slot (seq % OUTBOX_SLOTS), so the
+//                  position of a record never has to be stored anywhere. Pages are only ever programmed
+//                  once after their block is erased, a power loss can damage at most the page being written.
+//   block 3        journal of the oldest record that has not been acknowledged (the tail), one entry per page.
+//
+// Every record also carries the tail as it was when the record was pushed. The tail only moves forward, so
+// the highest tail found in the journal or in any record is a safe place to start after a reset, even if
+// power was lost just after the journal block was erased.
+//
+// A record is only retired once the broker has acknowledged it and the new tail has been journaled. If
+// power is lost before that, the record is sent again on the next connection (at least once delivery).
+#define OUTBOX_RECORD_BLOCKS                3
+#define OUTBOX_SLOTS                        (OUTBOX_RECORD_BLOCKS * NUM_PAGE_BLOCK)
+#define OUTBOX_JOURNAL_ADDR                 (APP_MEM_ADR_MQTT_OUTBOX_START + (OUTBOX_RECORD_BLOCKS * BLOCK_SIZE))
+
+#define OUTBOX_RECORD_MAGIC                 0x4F425832ul
+#define OUTBOX_JOURNAL_MAGIC                0x4F424A31ul
+#define OUTBOX_ERASED_WORD                  0xFFFFFFFFul
+#define OUTBOX_MUTEX_WAIT_MS                6000
+
+//header at the start of every record page, followed by the topic and then the payload
+typedef struct __attribute__ ((__packed__))
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t tailSeq;
+    uint8_t qos;
+    uint8_t topicLen;
+    uint16_t payloadLen;
+    uint16_t crc;
+}outboxRecordHeader_t;
+
+typedef struct __attribute__ ((__packed__))
+{
+    uint32_t magic;
+    uint32_t tailSeq;
+    uint32_t headSeq;
+    uint16_t crc;
+}outboxJournalEntry_t;
+
+#define OUTBOX_RECORD_BYTES                 (sizeof(outboxRecordHeader_t) + OUTBOX_MAX_TOPIC_LEN + OUTBOX_MAX_PAYLOAD_LEN)
+
+static SemaphoreHandle_t xOutboxMutex;
+static StaticSemaphore_t xOutboxMutexBuffer;
+
+//one record as laid out in the page, used to build and to read back records
+static uint8_t recordBuffer[OUTBOX_RECORD_BYTES];
+
+static uint32_t headSeq = 0u;          // seq the next push will get
+static uint32_t tailSeq = 0u;          // oldest record not yet acknowledged
+static uint32_t sendSeq = 0u;          // next record to hand out for sending
+static uint32_t ackedMask = 0u;        // bit n set = (tailSeq + n) acknowledged out of order
+static uint32_t committedTailSeq = 0u; // tail as it is stored in the journal
+static uint8_t journalPage = 0u;       // next free journal page
+static uint32_t droppedCount = 0u;
+static uint32_t skippedCount = 0u;
+static uint32_t failureCount = 0u;    // publishes failed since the last acknowledge, from any task
+
+static bool xRecoverState(void);
+static bool xReadRecordHeader(uint32_t seq, outboxRecordHeader_t *hdr);
+static bool xIsRecordValid(uint32_t seq, outboxRecordHeader_t *hdr, const uint8_t *body);
+static bool xWriteJournal(void);
+static void xAdvanceTail(void);
+static void xMarkAckedLocked(uint32_t seq);
+static uint32_t xOldestKeptSeq(uint32_t head);
+static uint32_t xSlotAddress(uint32_t seq);
+static uint16_t xCrc16(uint16_t crc, const uint8_t* data_p, uint32_t length);
+static void xOutboxCommandHandlerFunction(int argc, char **argv);
+
+void OUTBOX_init(void)
+{
+    /* register a command handler cb function */
+    CLI_Command_Handler_s outboxCmdHandler;
+    outboxCmdHandler.ptrFunction = &xOutboxCommandHandlerFunction;
+    outboxCmdHandler.cmdString   = "outbox";
+    outboxCmdHandler.usageString = "\n\r\tstats \n\r\tclear - retire everything queued";
+    CLI_registerThisCommandHandler(&outboxCmdHandler);
+
+    /* create a mutex */
+    xOutboxMutex = xSemaphoreCreateMutexStatic(&xOutboxMutexBuffer);
+
+    if ( xRecoverState() == false )
+    {
+        //nothing usable in the region (first boot with this layout), start from erased blocks
+        FLASH_erase(APP_MEM_ADR_MQTT_OUTBOX_START, (APP_MEM_ADR_MQTT_OUTBOX_END - APP_MEM_ADR_MQTT_OUTBOX_START) + 1);
+
+        headSeq = 0u;
+        tailSeq = 0u;
+        committedTailSeq = 0u;
+        journalPage = 0u;
+
+        elogInfo("OUTBOX: formatted");
+    }
+
+    sendSeq = tailSeq;
+    ackedMask = 0u;
+    failureCount = 0u;
+
+    elogInfo("OUTBOX: %lu queued (seq %lu - %lu)", headSeq - tailSeq, tailSeq, headSeq);
+}
+
+// Append one publish. The record is on NAND when this returns true.
+bool OUTBOX_push(const char *topic, uint8_t topicLen, uint8_t qos, const uint8_t *payload, uint16_t payloadLen)
+{
+    outboxRecordHeader_t hdr;
+    flashErr_t err = FLASH_GEN_ERROR;
+    uint32_t oldestKept;
+    uint16_t crc;
+    bool pushed = false;
+
+    if ( (topic == NULL) || (payload == NULL) || (topicLen > OUTBOX_MAX_TOPIC_LEN) || (payloadLen > OUTBOX_MAX_PAYLOAD_LEN) )
+    {
+        elogError("OUTBOX: bad record");
+        return false;
+    }
+
+    if( xSemaphoreTake(xOutboxMutex, ( TickType_t ) OUTBOX_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        while ( pushed == false )
+        {
+            if ( (headSeq % NUM_PAGE_BLOCK) == 0u )
+            {
+                //first page of a block, the block has to be erased before it can be written
+                err = FLASH_erase(xSlotAddress(headSeq), BLOCK_SIZE);
+
+                //erasing overwrote the oldest block, anything in it that was still queued is gone
+                oldestKept = xOldestKeptSeq(headSeq + 1u);
+
+                if ( tailSeq < oldestKept )
+                {
+                    droppedCount += oldestKept - tailSeq;
+                    elogNotice("OUTBOX: full, dropped %lu oldest", oldestKept - tailSeq);
+
+                    tailSeq = oldestKept;
+                    sendSeq = (sendSeq < tailSeq) ? tailSeq : sendSeq;
+                    ackedMask = 0u;
+
+                    //so a reset does not go looking for them
+                    xWriteJournal();
+                }
+
+                if ( err != FLASH_SUCCESS )
+                {
+                    break;
+                }
+            }
+            else if ( xReadRecordHeader(headSeq, &hdr) == false )
+            {
+                break;
+            }
+            else if ( hdr.magic != OUTBOX_ERASED_WORD )
+            {
+                //this page was damaged by a power loss during the last write, leave it and use the next one
+                headSeq++;
+                continue;
+            }
+
+            hdr.magic = OUTBOX_RECORD_MAGIC;
+            hdr.seq = headSeq;
+            hdr.tailSeq = tailSeq;
+            hdr.qos = qos;
+            hdr.topicLen = topicLen;
+            hdr.payloadLen = payloadLen;
+            hdr.crc = 0u;
+
+            memcpy(recordBuffer + sizeof(outboxRecordHeader_t), topic, topicLen);
+            memcpy(recordBuffer + sizeof(outboxRecordHeader_t) + topicLen, payload, payloadLen);
+
+            crc = xCrc16(0xFFFF, (uint8_t*)&hdr, sizeof(outboxRecordHeader_t) - sizeof(hdr.crc));
+            hdr.crc = xCrc16(crc, recordBuffer + sizeof(outboxRecordHeader_t), topicLen + payloadLen);
+            memcpy(recordBuffer, &hdr, sizeof(outboxRecordHeader_t));
+
+            err = FLASH_programPage(xSlotAddress(headSeq), recordBuffer, sizeof(outboxRecordHeader_t) + topicLen + payloadLen);
+
+            //the page is used either way, a failed program is skipped when draining
+            headSeq++;
+
+            if ( err != FLASH_SUCCESS )
+            {
+                break;
+            }
+
+            pushed = true;
+        }
+
+        /* Return mutex */
+        xSemaphoreGive(xOutboxMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+
+    return pushed;
+}
+
+// Hand out the next record to publish, in order. Returns false when there is nothing left to send or
+// OUTBOX_BATCH_SIZE records are already waiting on an acknowledge.
+bool OUTBOX_getNextToSend(outboxRecord_t *record)
+{
+    outboxRecordHeader_t hdr;
+    bool found = false;
+
+    if (record == NULL) return false;
+
+    if( xSemaphoreTake(xOutboxMutex, ( TickType_t ) OUTBOX_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        while ( (found == false) && (sendSeq < headSeq) && ((sendSeq - tailSeq) < OUTBOX_BATCH_SIZE) )
+        {
+            //already acknowledged before a resend was needed
+            if ( (ackedMask & (1ul << (sendSeq - tailSeq))) != 0u )
+            {
+                sendSeq++;
+                continue;
+            }
+
+            if ( FLASH_read(xSlotAddress(sendSeq), recordBuffer, OUTBOX_RECORD_BYTES) == FLASH_SUCCESS )
+            {
+                memcpy(&hdr, recordBuffer, sizeof(outboxRecordHeader_t));
+
+                if ( xIsRecordValid(sendSeq, &hdr, recordBuffer + sizeof(outboxRecordHeader_t)) == true )
+                {
+                    record->seq = hdr.seq;
+                    record->qos = hdr.qos;
+                    record->topicLen = hdr.topicLen;
+                    record->payloadLen = hdr.payloadLen;
+                    memcpy(record->topic, recordBuffer + sizeof(outboxRecordHeader_t), hdr.topicLen);
+                    memcpy(record->payload, recordBuffer + sizeof(outboxRecordHeader_t) + hdr.topicLen, hdr.payloadLen);
+
+                    found = true;
+                }
+                else
+                {
+                    //damaged page, there is nothing to send - retire it
+                    skippedCount++;
+                    sendSeq++;
+                    xMarkAckedLocked(sendSeq - 1u);
+                    continue;
+                }
+            }
+            else
+            {
+                //flash not readable right now, try again on the next drain
+                break;
+            }
+
+            sendSeq++;
+        }
+
+        /* Return mutex */
+        xSemaphoreGive(xOutboxMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+
+    return found;
+}
+
+// Broker acknowledged the record, it can be retired (RAM only until OUTBOX_commit)
+void OUTBOX_markAcked(uint32_t seq)
+{
+    if( xSemaphoreTake(xOutboxMutex, ( TickType_t ) OUTBOX_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        xMarkAckedLocked(seq);
+        failureCount = 0u;
+
+        /* Return mutex */
+        xSemaphoreGive(xOutboxMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+}
+
+// Publish failed, everything from the tail that has not been acknowledged is sent again
+void OUTBOX_markFailed(uint32_t seq)
+{
+    if( xSemaphoreTake(xOutboxMutex, ( TickType_t ) OUTBOX_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        if ( seq >= tailSeq && seq < sendSeq )
+        {
+            sendSeq = tailSeq;
+        }
+
+        failureCount++;
+
+        /* Return mutex */
+        xSemaphoreGive(xOutboxMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+}
+
+// Journal the tail if it moved. Called once per drain pass rather than per acknowledge to save erases.
+bool OUTBOX_commit(void)
+{
+    bool stat = true;
+
+    if( xSemaphoreTake(xOutboxMutex, ( TickType_t ) OUTBOX_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        if ( tailSeq != committedTailSeq )
+        {
+            stat = xWriteJournal();
+        }
+
+        /* Return mutex */
+        xSemaphoreGive(xOutboxMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+        stat = false;
+    }
+
+    return stat;
+}
+
+uint32_t OUTBOX_getPendingCount(void)
+{
+    return headSeq - tailSeq;
+}
+
+uint32_t OUTBOX_getInFlightCount(void)
+{
+    return sendSeq - tailSeq;
+}
+
+// The publish complete callback and the MQTT task both report failures, so the count lives here
+// under the outbox mutex rather than in either of them
+uint32_t OUTBOX_getFailureCount(void)
+{
+    uint32_t count = 0u;
+
+    if( xSemaphoreTake(xOutboxMutex, ( TickType_t ) OUTBOX_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        count = failureCount;
+
+        /* Return mutex */
+        xSemaphoreGive(xOutboxMutex);
+    }
+
+    return count;
+}
+
+void OUTBOX_resetFailures(void)
+{
+    if( xSemaphoreTake(xOutboxMutex, ( TickType_t ) OUTBOX_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        failureCount = 0u;
+
+        /* Return mutex */
+        xSemaphoreGive(xOutboxMutex);
+    }
+}
+
+// Records waiting on a PUBACK, or acknowledged records that are not journaled yet
+bool OUTBOX_isBusy(void)
+{
+    return ( (sendSeq != tailSeq) || (tailSeq != committedTailSeq) );
+}
+
+// Rebuild head and tail from what is on NAND. Returns false if the region holds nothing we wrote.
+static bool xRecoverState(void)
+{
+    outboxRecordHeader_t hdr;
+    outboxJournalEntry_t entry;
+    bool journalFound = false;
+    bool recordFound = false;
+    uint32_t minSeq = OUTBOX_ERASED_WORD;
+    uint32_t maxSeq = 0u;
+    uint32_t maxTailSeq = 0u;
+    uint32_t slot;
+    uint8_t page;
+
+    //the tail only ever moves forward, the highest good journal entry holds it. Every page is read, a
+    //power loss part way through erasing the journal leaves erased pages in front of older entries
+    journalPage = 0u;
+
+    for ( page = 0u; page < NUM_PAGE_BLOCK; page++ )
+    {
+        if ( FLASH_read(OUTBOX_JOURNAL_ADDR + (page * PAGE_DATA_SIZE), (uint8_t*)&entry, sizeof(entry)) != FLASH_SUCCESS )
+        {
+            return false;
+        }
+
+        if ( entry.magic == OUTBOX_ERASED_WORD )
+        {
+            continue;
+        }
+
+        //the next entry goes after the last page that is not erased
+        journalPage = page + 1u;
+
+        if ( (entry.magic == OUTBOX_JOURNAL_MAGIC) &&
+             (xCrc16(0xFFFF, (uint8_t*)&entry, sizeof(entry) - sizeof(entry.crc)) == entry.crc) &&
+             ((journalFound == false) || (entry.tailSeq > committedTailSeq)) )
+        {
+            committedTailSeq = entry.tailSeq;
+            journalFound = true;
+        }
+    }
+
+    //then find the oldest and newest records
+    for ( slot = 0u; slot < OUTBOX_SLOTS; slot++ )
+    {
+        if ( FLASH_read(APP_MEM_ADR_MQTT_OUTBOX_START + (slot * PAGE_DATA_SIZE), recordBuffer, OUTBOX_RECORD_BYTES) != FLASH_SUCCESS )
+        {
+            return false;
+        }
+
+        memcpy(&hdr, recordBuffer, sizeof(outboxRecordHeader_t));
+
+        if ( hdr.magic == OUTBOX_ERASED_WORD )
+        {
+            //skip the rest of this block
+            slot += (NUM_PAGE_BLOCK - 1u) - (slot % NUM_PAGE_BLOCK);
+            continue;
+        }
+
+        //the whole record is checked, a page cut off part way through its header can carry any seq
+        if ( (xIsRecordValid(hdr.seq, &hdr, recordBuffer + sizeof(outboxRecordHeader_t)) == true) && ((hdr.seq % OUTBOX_SLOTS) == slot) )
+        {
+            minSeq = (hdr.seq < minSeq) ? hdr.seq : minSeq;
+            maxSeq = (hdr.seq > maxSeq) ? hdr.seq : maxSeq;
+            maxTailSeq = (hdr.tailSeq > maxTailSeq) ? hdr.tailSeq : maxTailSeq;
+            recordFound = true;
+        }
+    }
+
+    if ( (journalFound == false) && (recordFound == false) )
+    {
+        return false;
+    }
+
+    headSeq = (recordFound == true) ? (maxSeq + 1u) : committedTailSeq;
+
+    if ( journalFound == true )
+    {
+        tailSeq = committedTailSeq;
+
+        if ( headSeq < tailSeq )
+        {
+            headSeq = tailSeq;
+        }
+    }
+    else
+    {
+        //journal was lost mid erase, resend everything still on NAND
+        tailSeq = minSeq;
+    }
+
+    //a record pushed after the last journal entry that survived knows a later tail
+    if ( (recordFound == true) && (maxTailSeq > tailSeq) && (maxTailSeq <= headSeq) )
+    {
+        tailSeq = maxTailSeq;
+    }
+
+    //never older than what the record blocks can still hold
+    if ( tailSeq < xOldestKeptSeq(headSeq) )
+    {
+        tailSeq = xOldestKeptSeq(headSeq);
+    }
+
+    committedTailSeq = tailSeq;
+
+    return true;
+}
+
+static bool xReadRecordHeader(uint32_t seq, outboxRecordHeader_t *hdr)
+{
+    return ( FLASH_read(xSlotAddress(seq), (uint8_t*)hdr, sizeof(outboxRecordHeader_t)) == FLASH_SUCCESS );
+}
+
+static bool xIsRecordValid(uint32_t seq, outboxRecordHeader_t *hdr, const uint8_t *body)
+{
+    uint16_t crc;
+
+    if ( (hdr->magic != OUTBOX_RECORD_MAGIC) || (hdr->seq != seq) ||
+         (hdr->topicLen > OUTBOX_MAX_TOPIC_LEN) || (hdr->payloadLen > OUTBOX_MAX_PAYLOAD_LEN) )
+    {
+        return false;
+    }
+
+    crc = xCrc16(0xFFFF, (uint8_t*)hdr, sizeof(outboxRecordHeader_t) - sizeof(hdr->crc));
+    crc = xCrc16(crc, body, hdr->topicLen + hdr->payloadLen);
+
+    return ( crc == hdr->crc );
+}
+
+static bool xWriteJournal(void)
+{
+    outboxJournalEntry_t entry;
+    flashErr_t err = FLASH_SUCCESS;
+
+    if ( journalPage >= NUM_PAGE_BLOCK )
+    {
+        //journal block is full, start it over. A power loss before the next program only costs resends
+        err = FLASH_erase(OUTBOX_JOURNAL_ADDR, BLOCK_SIZE);
+        journalPage = 0u;
+    }
+
+    if ( err == FLASH_SUCCESS )
+    {
+        entry.magic = OUTBOX_JOURNAL_MAGIC;
+        entry.tailSeq = tailSeq;
+        entry.headSeq = headSeq;
+        entry.crc = xCrc16(0xFFFF, (uint8_t*)&entry, sizeof(entry) - sizeof(entry.crc));
+
+        err = FLASH_programPage(OUTBOX_JOURNAL_ADDR + (journalPage * PAGE_DATA_SIZE), (uint8_t*)&entry, sizeof(entry));
+
+        //the page is used either way
+        journalPage++;
+    }
+
+    if ( err == FLASH_SUCCESS )
+    {
+        committedTailSeq = entry.tailSeq;
+    }
+
+    return ( err == FLASH_SUCCESS );
+}
+
+static void xMarkAckedLocked(uint32_t seq)
+{
+    if ( seq >= tailSeq && seq < sendSeq )
+    {
+        ackedMask |= (1ul << (seq - tailSeq));
+        xAdvanceTail();
+    }
+}
+
+//retire every acknowledged record at the front of the queue
+static void xAdvanceTail(void)
+{
+    while ( (ackedMask & 1u) != 0u )
+    {
+        ackedMask >>= 1;
+        tailSeq++;
+    }
+}
+
+//oldest seq that can still be on NAND when the next record to be written is headSeq.
+//The block holding headSeq has been erased, unless headSeq is the first page of it.
+static uint32_t xOldestKeptSeq(uint32_t head)
+{
+    uint32_t blockEnd = ((head + (NUM_PAGE_BLOCK - 1u)) / NUM_PAGE_BLOCK) * NUM_PAGE_BLOCK;
+
+    return ( blockEnd > OUTBOX_SLOTS ) ? (blockEnd - OUTBOX_SLOTS) : 0u;
+}
+
+static uint32_t xSlotAddress(uint32_t seq)
+{
+    return APP_MEM_ADR_MQTT_OUTBOX_START + ((seq % OUTBOX_SLOTS) * PAGE_DATA_SIZE);
+}
+
+// CRC-16/CCITT, same polynomial as the OTA image check
+static uint16_t xCrc16(uint16_t crc, const uint8_t* data_p, uint32_t length)
+{
+    uint8_t x;
+
+    while (length--)
+    {
+        x = crc >> 8 ^ *data_p++;
+        x ^= x>>4;
+        crc = (crc << 8) ^ ((uint16_t)(x << 12)) ^ ((uint16_t)(x <<5)) ^ ((uint16_t)x);
+    }
+
+    return crc;
+}
+
+static void xOutboxCommandHandlerFunction(int argc, char **argv)
+{
+    /* process the user input */
+    if ( (argc == ONE_ARGUMENT) &&  (0 == strcmp(argv[FIRST_ARG_IDX], "stats")) )
+    {
+        elogInfo("queued %lu, in flight %lu", OUTBOX_getPendingCount(), OUTBOX_getInFlightCount());
+        elogInfo("head %lu tail %lu journaled tail %lu", headSeq, tailSeq, committedTailSeq);
+        elogInfo("dropped %lu, damaged pages skipped %lu, journal page %u", droppedCount, skippedCount, journalPage);
+    }
+    else if ( (argc == ONE_ARGUMENT) &&  (0 == strcmp(argv[FIRST_ARG_IDX], "clear")) )
+    {
+        if( xSemaphoreTake(xOutboxMutex, ( TickType_t ) OUTBOX_MUTEX_WAIT_MS) == pdTRUE )
+        {
+            tailSeq = headSeq;
+            sendSeq = headSeq;
+            ackedMask = 0u;
+            xWriteJournal();
+
+            /* Return mutex */
+            xSemaphoreGive(xOutboxMutex);
+        }
+
+        elogInfo("outbox cleared");
+    }
+    else
+    {
+        elogInfo("Invaid args");
+    }
+}
@@ -0,0 +1,61 @@
+/**************************************************************************************************
+* \file     mqttOutbox.h
+* \brief    Persistent outbound MQTT queue. Encoded publishes are kept in NAND until the broker
+*           acknowledges them, so they survive resets and coverage gaps.
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#ifndef HANDLERS_MQTTOUTBOX_H_
+#define HANDLERS_MQTTOUTBOX_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+#include "messages.pb.h"
+
+#define OUTBOX_MAX_TOPIC_LEN                80
+#define OUTBOX_MAX_PAYLOAD_LEN              (SensorDataMessage_size)
+
+//number of records handed out for sending before any of them has to be acknowledged
+#define OUTBOX_BATCH_SIZE                   4
+
+//RAM copy of one queued publish
+typedef struct
+{
+    uint32_t seq;
+    uint8_t qos;
+    uint8_t topicLen;
+    uint16_t payloadLen;
+    char topic[OUTBOX_MAX_TOPIC_LEN];
+    uint8_t payload[OUTBOX_MAX_PAYLOAD_LEN];
+}outboxRecord_t;
+
+extern void OUTBOX_init(void);
+extern bool OUTBOX_push(const char *topic, uint8_t topicLen, uint8_t qos, const uint8_t *payload, uint16_t payloadLen);
+extern bool OUTBOX_getNextToSend(outboxRecord_t *record);
+extern void OUTBOX_markAcked(uint32_t seq);
+extern void OUTBOX_markFailed(uint32_t seq);
+extern bool OUTBOX_commit(void);
+extern uint32_t OUTBOX_getPendingCount(void);
+extern uint32_t OUTBOX_getInFlightCount(void);
+extern bool OUTBOX_isBusy(void);
+extern uint32_t OUTBOX_getFailureCount(void);
+extern void OUTBOX_resetFailures(void);
+
+#endif /* HANDLERS_MQTTOUTBOX_H_ */
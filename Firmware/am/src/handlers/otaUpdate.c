@@ -15,6 +15,8 @@ See Twisthink-SoftwareLicenseAgreement-Auris.docx for details.
 #define HANDLERS_OTAUPDATE_C_
 
 #include "stdint.h"
+#include "stddef.h"
+#include "stdlib.h"
 #include "string.h"
 #include "stdbool.h"
 #include "lwip/apps/http_client.h"
@@ -28,50 +30,98 @@ See Twisthink-SoftwareLicenseAgreement-Auris.docx for details.
 #include "MT29F1.h"
 #include "eventManager.h"
 #include "otaUpdate.h"
-
-#define MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM      PAGE_DATA_SIZE*40
+#include "scratchArena.h"
+
+#define MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM      ARENA_OTA_WRITE_BUFFER_BYTES
+
+// The package is parsed as a byte stream: AM record header, AM record, SSM record header, SSM record. A
+// checkpoint is saved every time the write buffer goes to flash: when it is full (16 pages), at the end of
+// each record and when a connection ends part way through a record. It is always taken with the buffer
+// empty and holds everything the parser needs to carry on from that byte: the package offset, the record
+// being parsed, the running CRCs and the firmware version. When the connection drops the next one asks for
+// the rest of the file with a Range header and continues from the checkpoint. The checkpoints are kept in
+// NAND, so a job that is sent again after a power down also continues instead of starting over.
+#define OTA_PROGRESS_MAGIC                      0x4F544131ul
+#define OTA_MAX_ATTEMPTS_WITHOUT_PROGRESS       4
+#define OTA_RETRY_DELAY_MS                      2000
+#define OTA_NOTIFY_CLOSED                       0x01ul
+#define OTA_HTTP_PORT                           80
+#define HTTP_STATUS_OK                          200
+#define HTTP_STATUS_PARTIAL_CONTENT             206
+#define HTTP_CONTENT_LEN_INVALID                0xFFFFFFFFul
+#define CONTENT_RANGE_PREFIX                    "Content-Range: bytes "
+
+//version is 3 big endian words within the AM record
+#define FW_VERSION_LEN                          12
+#define FW_VERSION_RECORD_IDX                   (AM_FW_VERSION_START_IDX - RECORD_HEADER_LEN)
+
+//records have to fit the smaller of the two slots
+#define AM_RECORD_MAX_LEN                       (APP_MEM_ADR_FW_APPLICATION_AM_B_END - APP_MEM_ADR_FW_APPLICATION_AM_B_START + 1u)
+#define SSM_RECORD_MAX_LEN                      (APP_MEM_ADR_FW_APPLICATION_SSM_B_END - APP_MEM_ADR_FW_APPLICATION_SSM_B_START + 1u)
 
 typedef enum
 {
-    FIRST_PACKET,
+    FIRST_PACKET,               //waiting on the AM record header
     DOWNLOADING_AM_RECORD,
     WAITING_ON_SSM_HEADER,
     DOWNLOADING_SSM_RECORD,
+    DOWNLOAD_DONE,
 }otaDownloadState_t;
 
-static otaDownloadState_t downloadState = FIRST_PACKET;
+//where the parser is, saved with each checkpoint
+typedef struct __attribute__ ((__packed__))
+{
+    uint32_t jobHash;           //hash of the package url, a new job never continues an old one
+    uint8_t loadedSlot;         //image that was running, the download goes to the other slot
+    uint8_t state;              //otaDownloadState_t
+    uint32_t fileSize;
+    uint32_t pkgOffset;         //package bytes that are in flash
+    uint32_t recordOffset;      //bytes of the current record (after its header) that are in flash
+    uint32_t amRecordLength;
+    uint32_t ssmRecordLength;
+    uint16_t amCrc;             //running crc of each record after its stored crc
+    uint16_t ssmCrc;
+    uint8_t fwVersion[FW_VERSION_LEN];
+}otaProgress_t;
+
+//one per page, appended through the block. The newest valid record is the checkpoint.
+typedef struct __attribute__ ((__packed__))
+{
+    uint32_t magic;
+    uint32_t seq;
+    otaProgress_t progress;
+    uint16_t check;             //crc of everything before it
+}otaProgressRecord_t;
 
-//track ota download progress
-static uint32_t packetCnt = 0;
-static uint32_t totalIncomingBytes = 0;
-static uint32_t fileSize = 0;
+//live parser state, advanced by the tcp callbacks
+static otaProgress_t progress;
 
-//these are found within the file that is downloaded
-static uint32_t amRecordLength = 0xFFFFFF;
-static uint32_t ssmRecordLength = 0u;
+//last checkpoint, every connection starts from here
+static otaProgress_t checkpoint;
 
+static int32_t progressPage = -1;
+static uint32_t progressSeq = 0u;
 
-static uint32_t downloadedImageFwMaj = 0;
-static uint32_t downloadedImageFwMin = 0;
-static uint32_t downloadedImageFwBuild = 0;
+//a record header can be split over two packets
+static uint8_t recordHeader[RECORD_HEADER_LEN];
+static uint8_t recordHeaderIdx = 0u;
+static bool formatError = false;
+
+//what the download cost, including bytes received again after a drop
+static uint32_t bytesOverAir = 0u;
+static uint32_t connectionCount = 0u;
 
 //track where to store into flash
-//TODO change this to the correct SLOT (either A or B)
 static uint32_t nextAddrToStoreImage = 0;
 static uint32_t amImageStartAddr = 0;
 static uint32_t ssmImageStartAddr = 0;
 
 
-//store 40 pages to minimize flash writes..
-static uint8_t nextFlashWriteBuffer[MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM] = {0};
+//store 16 pages to limit flash writes
+//the buffer lives in the scratch arena while a download is in progress
+static uint8_t *nextFlashWriteBuffer = NULL;
 static uint32_t writeBufferLen = 0u;
 
-static uint8_t tempBufferForAmSsmCrossover[2000];
-static uint16_t tempBufferIdx = 0;
-static uint32_t amBytesInPacket = 0;
-static uint32_t ssmBytesInPacket = 0;
-static uint16_t crc = 0xFFFF;
-
 //s3 bucket that contains the ota package
 static char fileLocationUrl[MAX_OTA_FILEPATH_LEN_BYTES] = {};
 static char fileLocationDomainName[MAX_OTA_FILEPATH_LEN_BYTES] = {};
@@ -92,15 +142,35 @@ err_t RecvHttpHeaderCallback (httpc_state_t *connection, void *arg, struct
 static uint32_t checkWhichAddrToStoreSsmImage(void);
 static uint32_t checkWhichAddrToStoreAmImage(void);
 static void downloadFinishedUpdateRegistry(void);
-static uint16_t xRunningCrc(const uint8_t* data_p, uint32_t length);
+static uint16_t xRunningCrc(uint16_t crc, const uint8_t* data_p, uint32_t length);
+static uint16_t xFlashCrc(uint32_t addr, uint32_t len);
+static void xReleaseDownloadBuffers(void);
+static bool xConsumePackageBytes(const uint8_t *data, uint32_t len);
+static bool xStartRecord(void);
+static void xTrackRecordBytes(const uint8_t *data, uint32_t len);
+static bool xFlushAndCheckpoint(void);
+static uint32_t xCurrentRecordLength(void);
+static void xStartOver(void);
+static void xRestoreCheckpoint(void);
+static uint32_t xHashUrl(const char *url);
+static uint16_t xGetHttpStatus(struct pbuf *hdr);
+static bool xGetContentRange(struct pbuf *hdr, uint32_t *start, uint32_t *total);
+static bool xLoadProgress(otaProgress_t *pSaved);
+static bool xSaveProgress(const otaProgress_t *pProgress);
+static void xClearProgress(void);
+static uint32_t xProgressPageAddress(int32_t page);
+static uint32_t xGetBigEndian32(const uint8_t *p);
 
 //pass in the S3 file link contained in the AWS job to init the download
 bool OTA_initDownload(char * filePath)
 {
     bool res = false;
+    otaProgress_t saved;
 
     //copy the full filepath into the URL
-    strncpy(fileLocationUrl, filePath, strlen(filePath));
+    memset(fileLocationUrl, 0, sizeof(fileLocationUrl));
+    memset(fileLocationDomainName, 0, sizeof(fileLocationDomainName));
+    strncpy(fileLocationUrl, filePath, sizeof(fileLocationUrl) - 1u);
 
     //we dont want the file name in the domain name, so need to
     //remove everything AFTER .com
@@ -123,12 +193,34 @@ bool OTA_initDownload(char * filePath)
     ssmImageStartAddr = checkWhichAddrToStoreSsmImage();
     amImageStartAddr = checkWhichAddrToStoreAmImage();
 
-    //we start saving the image at the am slot
-    nextAddrToStoreImage = amImageStartAddr;
+    //continue a download of the same package into the same slot, anything else starts from byte 0
+    if ( (xLoadProgress(&saved) == true) && (saved.jobHash == xHashUrl(fileLocationUrl)) &&
+         (saved.loadedSlot == (uint8_t)MEM_getLoadedImage()) && (saved.state < DOWNLOAD_DONE) )
+    {
+        checkpoint = saved;
+        elogInfo("Resuming OTA at byte %lu of %lu", checkpoint.pkgOffset, checkpoint.fileSize);
+    }
+    else
+    {
+        xStartOver();
+    }
+
+    bytesOverAir = 0u;
+    connectionCount = 0u;
+
+    //grab the download buffer, released once the download task is done
+    nextFlashWriteBuffer = ARENA_acquire(ARENA_OWNER_OTA_DOWNLOAD, ARENA_OTA_DOWNLOAD_BYTES);
+
+    if ( nextFlashWriteBuffer == NULL )
+    {
+        elogError("No scratch RAM for the OTA download");
+        return res;
+    }
 
     if( xTaskCreate( OTA_downloadTask, "downloadThread", ( configSTACK_DEPTH_TYPE ) 768*12, NULL, 7, &otaDownloadHandle ) != pdPASS )
     {
        elogError("Failed to create task");
+       xReleaseDownloadBuffers();
     }
     else
     {
@@ -140,29 +232,103 @@ bool OTA_initDownload(char * filePath)
 }
 
 
-//set up the URL of the s3 bucket and begin the file download
+//set up the URL of the s3 bucket and download the file, reconnecting from the last checkpoint
+//when the connection drops
 void OTA_downloadTask()
 {
     httpc_connection_t conn_settings;
     httpc_state_t *connection;
     err_t error;
+    uint32_t notifiedValue;
+    uint32_t offsetBefore;
+    uint8_t attemptsWithoutProgress = 0u;
 
     //set up the callback functions
+    memset(&conn_settings, 0, sizeof(conn_settings));
     conn_settings.use_proxy = 0;
     conn_settings.headers_done_fn = RecvHttpHeaderCallback;
     conn_settings.result_fn = HttpClientResultCallback;
 
-    //init the file download & assign a callback for bytes received
-    error = httpc_get_file_dns(fileLocationDomainName, 80, fileLocationUrl, &conn_settings,
-    RecvImageBytesCallback, NULL, &connection);
+    while ( (checkpoint.state != DOWNLOAD_DONE) && (attemptsWithoutProgress < OTA_MAX_ATTEMPTS_WITHOUT_PROGRESS) )
+    {
+        //anything received after the checkpoint is asked for again
+        xRestoreCheckpoint();
+        offsetBefore = checkpoint.pkgOffset;
+        conn_settings.range_start = checkpoint.pkgOffset;
+        connectionCount++;
+
+        //init the file download & assign a callback for bytes received
+        error = httpc_get_file_dns(fileLocationDomainName, OTA_HTTP_PORT, fileLocationUrl, &conn_settings,
+        RecvImageBytesCallback, NULL, &connection);
+
+        elogInfo("OTA request from byte %lu, result %d\n", conn_settings.range_start, error);
+
+        if ( error == ERR_OK )
+        {
+            //the client always finishes with the result callback, its poll timeout ends a stalled connection
+            xTaskNotifyWait(0u, OTA_NOTIFY_CLOSED, &notifiedValue, portMAX_DELAY);
+
+            //the connection is gone so nothing else touches the buffer, keep what it delivered
+            if ( (formatError == false) && (writeBufferLen != 0u) )
+            {
+                (void)xFlushAndCheckpoint();
+            }
+        }
+
+        if ( formatError == true )
+        {
+            break;
+        }
+
+        if ( checkpoint.pkgOffset != offsetBefore )
+        {
+            attemptsWithoutProgress = 0u;
+        }
+        else
+        {
+            attemptsWithoutProgress++;
+        }
+
+        if ( checkpoint.state != DOWNLOAD_DONE )
+        {
+            vTaskDelay(pdMS_TO_TICKS(OTA_RETRY_DELAY_MS));
+        }
+    }
+
+    if ( checkpoint.state == DOWNLOAD_DONE )
+    {
+        elogInfo("OTA package of %lu bytes received with %lu bytes over %lu connections",
+                 checkpoint.fileSize, bytesOverAir, connectionCount);
 
-    elogInfo("DNS lookup result %d\n", error);
+        //update the image registry so that on the next PC, the BL will
+        //see that we have a new primary image (the one we just downloaded)
+        downloadFinishedUpdateRegistry();
 
-    //this will get deleted once we finish downloading the image
-    while(1)
+        //a bad image has to be downloaded again from the start
+        xClearProgress();
+    }
+    else
     {
+        if ( formatError == true )
+        {
+            elogError("OTA file is not an OTA package");
+            xClearProgress();
+        }
+        else
+        {
+            //the checkpoint stays, the job continues from it the next time it is sent
+            elogError("OTA download stopped at byte %lu of %lu", checkpoint.pkgOffset, checkpoint.fileSize);
+        }
 
+        EVT_indicateFwDownloadFail();
     }
+
+    elogInfo("Deleting OTA Download Task");
+
+    xReleaseDownloadBuffers();
+
+    //now destroy the task!
+    vTaskDelete(NULL);
 }
 
 
@@ -209,8 +375,6 @@ static uint32_t checkWhichAddrToStoreSsmImage(void)
 
 static void downloadFinishedUpdateRegistry(void)
 {
-    uint32_t tempLen;
-    uint32_t addr;
     imageSlotTypes_t currentLoadedSlot = MEM_getLoadedImage();
     uint16_t calculatedAmCrc = 0u;
     uint16_t storedAmCrc = 0u;
@@ -218,89 +382,29 @@ static void downloadFinishedUpdateRegistry(void)
     uint16_t storedSsmCrc = 0u;
     bool valid = false;
 
-    //get address where we loaded the image (will be in the slot other than the loaded slot)
-    if ( currentLoadedSlot == A)
-    {
-        tempLen = amRecordLength - CRC_LEN;
-        addr = APP_MEM_ADR_FW_APPLICATION_AM_B_START + CRC_LEN;
-    }
-    else
-    {
-        tempLen = amRecordLength - CRC_LEN;
-        addr = APP_MEM_ADR_FW_APPLICATION_AM_A_START + CRC_LEN;
-    }
+    uint32_t downloadedImageFwMaj = xGetBigEndian32(&checkpoint.fwVersion[0]);
+    uint32_t downloadedImageFwMin = xGetBigEndian32(&checkpoint.fwVersion[4]);
+    uint32_t downloadedImageFwBuild = xGetBigEndian32(&checkpoint.fwVersion[8]);
 
-    //compute AM image checksum
-    while (tempLen)
-    {
-        if(tempLen < MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM)
-        {
-            FLASH_read(addr, (uint8_t*) &nextFlashWriteBuffer, tempLen);
+    //compute the checksums of what is in flash (the image is in the slot other than the loaded slot)
+    calculatedAmCrc = xFlashCrc(amImageStartAddr + CRC_LEN, checkpoint.amRecordLength - CRC_LEN);
+    calculatedSsmCrc = xFlashCrc(ssmImageStartAddr + CRC_LEN, checkpoint.ssmRecordLength - CRC_LEN);
 
-            calculatedAmCrc = xRunningCrc((uint8_t*)&nextFlashWriteBuffer, tempLen);
+    FLASH_read(amImageStartAddr, (uint8_t*)&storedAmCrc, CRC_LEN);
+    FLASH_read(ssmImageStartAddr, (uint8_t*)&storedSsmCrc, CRC_LEN);
 
-            tempLen = 0;
-        }
-        else
-        {
-            FLASH_read(addr, (uint8_t*)&nextFlashWriteBuffer, MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM);
-
-            calculatedAmCrc = xRunningCrc((uint8_t*)&nextFlashWriteBuffer, MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM);
-            tempLen-=MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM;
-            addr+= MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM;
-        }
-    }
+    //shift bytes since they are read out of flash backwards:
+    storedAmCrc = (uint8_t)storedAmCrc<<8 | storedAmCrc>>8;
+    storedSsmCrc = (uint8_t)storedSsmCrc<<8 | storedSsmCrc>>8;
 
-    //now do the ssm crc
-    //get address where we loaded the image (will be in the slot other than the loaded slot)
-    if ( currentLoadedSlot == A)
+    //the running crcs cover what came over the air (across every resume), the flash crcs what was stored
+    if ( (calculatedAmCrc == storedAmCrc) && (calculatedSsmCrc == storedSsmCrc) &&
+         (checkpoint.amCrc == storedAmCrc) && (checkpoint.ssmCrc == storedSsmCrc) )
     {
-        tempLen = ssmRecordLength - CRC_LEN;
-        addr = APP_MEM_ADR_FW_APPLICATION_SSM_B_START + CRC_LEN;
-    }
-    else
-    {
-        tempLen = ssmRecordLength - CRC_LEN;
-        addr = APP_MEM_ADR_FW_APPLICATION_SSM_A_START + CRC_LEN;
-    }
+        valid = true;
 
-    //reset crc value used in calculation
-    crc = 0xFFFF;
-
-    //compute SSM image checksum
-    while (tempLen)
-    {
-        if(tempLen < MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM)
+        if ( currentLoadedSlot == A )
         {
-            FLASH_read(addr, (uint8_t*) &nextFlashWriteBuffer, tempLen);
-
-            calculatedSsmCrc = xRunningCrc((uint8_t*)&nextFlashWriteBuffer, tempLen);
-
-            tempLen = 0;
-        }
-        else
-        {
-            FLASH_read(addr, (uint8_t*)&nextFlashWriteBuffer, MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM);
-
-            calculatedSsmCrc = xRunningCrc((uint8_t*)&nextFlashWriteBuffer, MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM);
-            tempLen-=MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM;
-            addr+= MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM;
-        }
-    }
-
-    if ( currentLoadedSlot == A )
-    {
-        FLASH_read(APP_MEM_ADR_FW_APPLICATION_AM_B_START, (uint8_t*)&storedAmCrc, CRC_LEN);
-        FLASH_read(APP_MEM_ADR_FW_APPLICATION_SSM_B_START, (uint8_t*)&storedSsmCrc, CRC_LEN);
-
-        //shift bytes since they are read out of flash backwards:
-        storedAmCrc = (uint8_t)storedAmCrc<<8 | storedAmCrc>>8;
-        storedSsmCrc = (uint8_t)storedSsmCrc<<8 | storedSsmCrc>>8;
-
-        if ( (calculatedAmCrc == storedAmCrc) && (calculatedSsmCrc == storedSsmCrc) )
-        {
-            valid = true;
-
             MEM_setImageBoperationalState(OP_UNKNOWN);
 
             //set the fw version
@@ -311,26 +415,6 @@ static void downloadFinishedUpdateRegistry(void)
         }
         else
         {
-            elogError("Bad checksum AM: 0x%X, 0x%X SSM: 0x%X, 0x%X", calculatedAmCrc, storedAmCrc, calculatedSsmCrc, storedSsmCrc);
-
-            //overwrite the metadata section in FLASH with invalid values for this image
-            memset(&nextFlashWriteBuffer, 0xFF, MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM);
-
-            FLASH_write(APP_MEM_ADR_FW_APPLICATION_AM_B_START, (uint8_t*)nextFlashWriteBuffer, MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM);
-        }
-    }
-    else
-    {
-        FLASH_read(APP_MEM_ADR_FW_APPLICATION_AM_A_START, (uint8_t*)&storedAmCrc, CRC_LEN);
-        FLASH_read(APP_MEM_ADR_FW_APPLICATION_SSM_A_START, (uint8_t*)&storedSsmCrc, CRC_LEN);
-
-        //shift bytes since they are read out of flash backwards:
-        storedAmCrc = (uint8_t)storedAmCrc<<8 | storedAmCrc>>8;
-        storedSsmCrc = (uint8_t)storedSsmCrc<<8 | storedSsmCrc>>8;
-
-        if ( (calculatedAmCrc == storedAmCrc) && (calculatedSsmCrc == storedSsmCrc) )
-        {
-            valid = true;
             MEM_setImageAoperationalState(OP_UNKNOWN);
 
             //set new fw version
@@ -339,15 +423,16 @@ static void downloadFinishedUpdateRegistry(void)
 
             elogDebug("Set image A to the primary image");
         }
-        else
-        {
-            elogError("Bad checksum AM: 0x%X, 0x%X SSM: 0x%X, 0x%X", calculatedAmCrc, storedAmCrc, calculatedSsmCrc, storedSsmCrc);
+    }
+    else
+    {
+        elogError("Bad checksum AM: 0x%X, 0x%X (rx 0x%X) SSM: 0x%X, 0x%X (rx 0x%X)", calculatedAmCrc, storedAmCrc, checkpoint.amCrc,
+                  calculatedSsmCrc, storedSsmCrc, checkpoint.ssmCrc);
 
-            //overwrite the metadata section in FLASH with invalid values for this image
-            memset(&nextFlashWriteBuffer, 0xFF, MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM);
+        //overwrite the metadata section in FLASH with invalid values for this image
+        memset(nextFlashWriteBuffer, 0xFF, MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM);
 
-            FLASH_write(APP_MEM_ADR_FW_APPLICATION_AM_A_START, (uint8_t*)nextFlashWriteBuffer, MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM);
-        }
+        FLASH_write(amImageStartAddr, nextFlashWriteBuffer, MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM);
     }
 
     if ( valid == true )
@@ -361,336 +446,502 @@ static void downloadFinishedUpdateRegistry(void)
     }
 }
 
-//header received - this will contain the file size of the download
+//header received - this will contain the file size of the download, or for a resumed
+//download the range the server is sending
 err_t RecvHttpHeaderCallback (httpc_state_t *connection, void *arg, struct
                                 pbuf *hdr, u16_t hdr_len, u32_t content_len)
 {
-    elogInfo("HEADER RECEIVED OTA Filesize =  %lu bytes", content_len);
+    uint16_t status = xGetHttpStatus(hdr);
+    uint32_t rangeStart = 0u;
+    uint32_t rangeTotal = 0u;
 
-    //set the file size - this value is contained in the header
-    fileSize = content_len;
+    if ( (status == HTTP_STATUS_PARTIAL_CONTENT) && (progress.pkgOffset != 0u) )
+    {
+        if ( (xGetContentRange(hdr, &rangeStart, &rangeTotal) == false) ||
+             (rangeStart != progress.pkgOffset) || (rangeTotal != progress.fileSize) )
+        {
+            //not the file the checkpoint belongs to, the next connection starts from byte 0
+            elogError("OTA range %lu of %lu does not match the checkpoint", rangeStart, rangeTotal);
+            xStartOver();
+            return ERR_VAL;
+        }
+
+        elogInfo("OTA resumed at byte %lu of %lu", rangeStart, rangeTotal);
+    }
+    else if ( (status == HTTP_STATUS_OK) && (content_len != HTTP_CONTENT_LEN_INVALID) )
+    {
+        if ( progress.pkgOffset != 0u )
+        {
+            //the server sent the whole file, take it from the top
+            elogNotice("OTA range not honoured, starting over");
+            xStartOver();
+            xRestoreCheckpoint();
+        }
+
+        elogInfo("HEADER RECEIVED OTA Filesize =  %lu bytes", content_len);
+
+        //set the file size - this value is contained in the header
+        progress.fileSize = content_len;
+        checkpoint.fileSize = content_len;
+    }
+    else
+    {
+        elogError("OTA download refused, http status %u", status);
+        return ERR_VAL;
+    }
 
     return ERR_OK;
 }
 
 
-//this is called DURING the download process when there is an error, or when the
-//download has completed without errors
+//this is called when the connection has ended, either because of an error or because the server
+//closed it after the last byte
 void HttpClientResultCallback (void *arg, httpc_result_t httpc_result, u32_t
                                     rx_content_len, u32_t srv_res, err_t err)
 {
    elogInfo("CLIENT RESULT - httpc_result: %u\n", httpc_result);
    elogInfo("received number of bytes: %lu\n", rx_content_len);
-   elogInfo("Deleting OTA Download Task");
 
-   //now destroy the task!
-   vTaskDelete(otaDownloadHandle);
+   //the download task decides whether to reconnect
+   xTaskNotify(otaDownloadHandle, OTA_NOTIFY_CLOSED, eSetBits);
 }
 
-//The tcp packets come in chains, so typically there are 3 of them chained together to operate on
-//in this function
-//the p->tot_len variable is the total # bytes between all 3 chains
+//The tcp packets come in chains, each pbuf in the chain is a contiguous run of the package
+//and is parsed in place
 err_t RecvImageBytesCallback(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
 {
-    uint16_t thisPacketLen = 0;
+    struct pbuf *q;
+    bool accepted = true;
 
-    if (p == NULL || p->tot_len > PAGE_DATA_SIZE)
+    if ( p == NULL )
     {
-        elogError("invalid TCP packet has arrived");
+        return ERR_OK;
     }
-    else
+
+    bytesOverAir += p->tot_len;
+
+    for ( q = p; (q != NULL) && (accepted == true); q = q->next )
     {
+        accepted = xConsumePackageBytes((const uint8_t*)q->payload, q->len);
+    }
 
-        //if we are about to hit the max stored chars, write them all to FLASH and reset the write buffer idx
-        if( p->tot_len + writeBufferLen >= MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM)
-        {
-            FLASH_write(nextAddrToStoreImage, (uint8_t*)&nextFlashWriteBuffer, writeBufferLen);
-            nextAddrToStoreImage += writeBufferLen;
-            writeBufferLen = 0;
-        }
+    tcp_recved(tpcb, p->tot_len);
+    pbuf_free(p);
 
-        //if we are simply downloading the AM image before the ssm-am overlap or downloading the ssm record,
-        //throw the payloads intp the buffer that we will write to flash:
-        if ( (totalIncomingBytes + p->tot_len <= (amRecordLength + RECORD_HEADER_LEN) && downloadState != FIRST_PACKET && downloadState != WAITING_ON_SSM_HEADER )
-                || downloadState == DOWNLOADING_SSM_RECORD )
-        {
-            //copy the payload into a buffer so its easier to operate on:
-            memcpy(&nextFlashWriteBuffer[writeBufferLen], p->payload, p->len);
-            writeBufferLen += p->len;
+    if ( accepted == false )
+    {
+        //stop receiving the file, the result callback tells the download task
+        tcp_abort(tpcb);
+        return ERR_ABRT;
+    }
 
-            //second chain
-            if(p->next != NULL )
-            {
+    return ERR_OK;
+}
 
-                memcpy(&nextFlashWriteBuffer[writeBufferLen], p->next->payload, p->next->len);
+//run a span of the package through the record parser
+static bool xConsumePackageBytes(const uint8_t *data, uint32_t len)
+{
+    uint32_t n;
 
-                writeBufferLen += p->next->len;
+    while ( len > 0u )
+    {
+        switch ( progress.state )
+        {
+            case FIRST_PACKET:
+            case WAITING_ON_SSM_HEADER:
 
-                //final chain
-                if ( p->next->next != NULL )
+                n = RECORD_HEADER_LEN - recordHeaderIdx;
+                if ( n > len )
                 {
-                    //another copy...
-                    memcpy(&nextFlashWriteBuffer[writeBufferLen], p->next->next->payload, p->next->next->len);
-                    writeBufferLen += p->next->next->len;
+                    n = len;
                 }
-            }
-        }
-
-        thisPacketLen = p->tot_len;
 
-        //process the bytes according to which state we are in:
-        switch(downloadState)
-        {
+                memcpy(&recordHeader[recordHeaderIdx], data, n);
+                recordHeaderIdx += n;
+                progress.pkgOffset += n;
 
-            case FIRST_PACKET:
+                if ( (recordHeaderIdx == RECORD_HEADER_LEN) && (xStartRecord() == false) )
+                {
+                    //this file does NOT follow the OTA package format
+                    formatError = true;
+                    return false;
+                }
+                break;
 
-                //copy the payload into a TEMP buffer so its easier to operate on:
-                memcpy(&tempBufferForAmSsmCrossover, p->payload, p->len);
-                tempBufferIdx += p->len;
+            case DOWNLOADING_AM_RECORD:
+            case DOWNLOADING_SSM_RECORD:
 
-                //second chain
-                if(p->next != NULL )
+                //up to the end of the record or of the write buffer, whichever comes first
+                n = xCurrentRecordLength() - progress.recordOffset;
+                if ( n > len )
                 {
+                    n = len;
+                }
+                if ( n > (MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM - writeBufferLen) )
+                {
+                    n = MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM - writeBufferLen;
+                }
 
-                  memcpy(&tempBufferForAmSsmCrossover[tempBufferIdx], p->next->payload, p->next->len);
+                xTrackRecordBytes(data, n);
 
-                  tempBufferIdx += p->next->len;
+                memcpy(&nextFlashWriteBuffer[writeBufferLen], data, n);
+                writeBufferLen += n;
+                progress.recordOffset += n;
+                progress.pkgOffset += n;
 
-                  //final chain
-                  if ( p->next->next != NULL )
-                  {
-                      //another copy...
-                      memcpy(&tempBufferForAmSsmCrossover[tempBufferIdx], p->next->next->payload, p->next->next->len);
-                      tempBufferIdx += p->next->next->len;
-                  }
+                if ( ((writeBufferLen == MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM) || (progress.recordOffset == xCurrentRecordLength())) &&
+                     (xFlushAndCheckpoint() == false) )
+                {
+                    return false;
                 }
+                break;
 
-                //check first record type - either AM or SSM
-                if ( tempBufferForAmSsmCrossover[RECORD_TYPE_IDX] == AM_IMAGE)
-                {
-                    //this is an AM record and follows the OTA package format so we can continue to parse it
+            default:
 
-                    //record length - cs, metadata, and binary
-                    amRecordLength = ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX] <<24) | ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX+1] <<16)
-                            | ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX+2] << 8) | ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX+3]);
+                //anything after the SSM record is not part of the image
+                n = len;
+                break;
+        }
 
-                    //also set the fw verson:
-                    downloadedImageFwMaj = ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX] <<24) | ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+1] <<16)
-                                    | ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+2] << 8) | ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+3]);
+        data += n;
+        len -= n;
+    }
 
-                    downloadedImageFwMin = ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+4] <<24) | ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+5] <<16)
-                                    | ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+6] << 8) | ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+7]);
+    return true;
+}
 
+//a record header is complete, check it and start storing the record into its slot
+static bool xStartRecord(void)
+{
+    uint32_t recordLength = xGetBigEndian32(&recordHeader[RECORD_LEN_IDX]);
 
-                    downloadedImageFwBuild = ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+8] <<24) | ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+9] <<16)
-                                    | ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+10] << 8) | ((uint32_t)tempBufferForAmSsmCrossover[AM_FW_VERSION_START_IDX+11]);
+    recordHeaderIdx = 0u;
 
+    if ( progress.state == FIRST_PACKET )
+    {
+        //the version sits inside the AM record, it has to be long enough to hold it
+        if ( (recordHeader[RECORD_TYPE_IDX] != AM_IMAGE) || (recordLength < (FW_VERSION_RECORD_IDX + FW_VERSION_LEN)) ||
+             (recordLength > AM_RECORD_MAX_LEN) )
+        {
+            elogError("Bad AM record header, type %u len %lu", recordHeader[RECORD_TYPE_IDX], recordLength);
+            return false;
+        }
 
-                    memcpy(&nextFlashWriteBuffer, &tempBufferForAmSsmCrossover[RECORD_HEADER_LEN], tempBufferIdx-RECORD_HEADER_LEN);
+        progress.amRecordLength = recordLength;
+        progress.state = DOWNLOADING_AM_RECORD;
+        nextAddrToStoreImage = amImageStartAddr;
+    }
+    else
+    {
+        if ( (recordHeader[RECORD_TYPE_IDX] != SSM_IMAGE) || (recordLength < CRC_LEN) || (recordLength > SSM_RECORD_MAX_LEN) )
+        {
+            elogError("Bad SSM record header, type %u len %lu", recordHeader[RECORD_TYPE_IDX], recordLength);
+            return false;
+        }
 
-                    writeBufferLen+= tempBufferIdx - RECORD_HEADER_LEN;
-                    tempBufferIdx = 0;
+        progress.ssmRecordLength = recordLength;
+        progress.state = DOWNLOADING_SSM_RECORD;
+        nextAddrToStoreImage = ssmImageStartAddr;
+    }
 
-                    //bump up the state
-                    downloadState = DOWNLOADING_AM_RECORD;
+    progress.recordOffset = 0u;
 
-                }
-                else
-                {
-                    //this packet does NOT follow the OTA package format - stop receiving the file
-                    tcp_recved(tpcb, p->tot_len);
-                    pbuf_free(p);
+    return true;
+}
 
-                    //BAIL
-                    EVT_indicateFwDownloadFail();
+//running crc and the firmware version, for len bytes of the current record starting at recordOffset
+static void xTrackRecordBytes(const uint8_t *data, uint32_t len)
+{
+    uint32_t skip = 0u;
+    uint32_t first;
+    uint32_t last;
 
-                    return tcp_close(tpcb);
+    //the stored crc is not part of what it covers
+    if ( progress.recordOffset < CRC_LEN )
+    {
+        skip = CRC_LEN - progress.recordOffset;
+        if ( skip > len )
+        {
+            skip = len;
+        }
+    }
 
-                }
-                break;
-            case DOWNLOADING_AM_RECORD:
+    if ( progress.state == DOWNLOADING_AM_RECORD )
+    {
+        progress.amCrc = xRunningCrc(progress.amCrc, &data[skip], len - skip);
 
-                //check if we are about to cross over into the SSM record section, we will handle differently if so
-                if ( totalIncomingBytes + p->tot_len > amRecordLength + RECORD_HEADER_LEN)
-                {
-                    //now calculate the makeup of the packet - ssm vs am line - subtract 5 from incoming bytes to account for the record type + len = 5
-                    amBytesInPacket = p->tot_len - (totalIncomingBytes - RECORD_HEADER_LEN + p->tot_len - amRecordLength);
-                    ssmBytesInPacket = p->tot_len - amBytesInPacket;
-
-                    //copy the payload into a TEMPORARY buffer so its easier to operate on:
-                    memcpy(&tempBufferForAmSsmCrossover, p->payload, p->len);
-                    tempBufferIdx += p->len;
-
-                    //second chain
-                    if(p->next != NULL )
-                    {
-                       memcpy(&tempBufferForAmSsmCrossover[tempBufferIdx], p->next->payload, p->next->len);
-
-                       tempBufferIdx += p->next->len;
-
-                       //final chain
-                       if ( p->next->next != NULL )
-                       {
-                           //another copy...
-                           memcpy(&tempBufferForAmSsmCrossover[tempBufferIdx], p->next->next->payload, p->next->next->len);
-                           tempBufferIdx += p->next->next->len;
-                       }
-                    }
-
-                    //put the AM byes into the actual buffer
-                    memcpy(&nextFlashWriteBuffer[writeBufferLen], &tempBufferForAmSsmCrossover, amBytesInPacket);
-
-                    writeBufferLen += amBytesInPacket;
-
-                    //write the current buffer to flash
-                    FLASH_write(nextAddrToStoreImage, (uint8_t*)&nextFlashWriteBuffer, writeBufferLen);
-
-                    //reset variables
-                    writeBufferLen = 0;
-
-                    //now parse out the ssm bytes, which are located at nextFlashWriteBuffer[amBytesInPacket] index
-                    //and have a length of ssmBytesInPacket
-
-                    if ( ssmBytesInPacket >= RECORD_HEADER_LEN )
-                    {
-                        if ( tempBufferForAmSsmCrossover[amBytesInPacket] == SSM_IMAGE)
-                        {
-                            //this is an SSM record and follows the OTA package format so we can continue to parse it
-
-                            //record length - cs, metadata, and binary
-                            ssmRecordLength = ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX + amBytesInPacket] <<24) | ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX+1+amBytesInPacket] <<16)
-                                                       | ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX+2+amBytesInPacket] << 8) | ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX+3+amBytesInPacket]);
-
-                            //now start saving at the SSM slot
-                            nextAddrToStoreImage = ssmImageStartAddr;
-
-                            memcpy(&nextFlashWriteBuffer, &tempBufferForAmSsmCrossover[amBytesInPacket + RECORD_HEADER_LEN], ssmBytesInPacket - RECORD_HEADER_LEN);
-                            writeBufferLen += (ssmBytesInPacket - RECORD_HEADER_LEN);
-
-                            downloadState = DOWNLOADING_SSM_RECORD;
-                        }
-                        else
-                        {
-
-                            //this packet does NOT follow the OTA package format - stop receiving the file
-                            tcp_recved(tpcb, p->tot_len);
-                            pbuf_free(p);
-
-                            //bail
-                            EVT_indicateFwDownloadFail();
-                            return tcp_close(tpcb);
-                        }
-                    }
-                    else
-                    {
-                        //wait for the next chunk and then process this edge case
-                        downloadState = WAITING_ON_SSM_HEADER;
-                    }
-                }
+        //copy whatever part of the version this span holds
+        first = (progress.recordOffset > FW_VERSION_RECORD_IDX) ? progress.recordOffset : FW_VERSION_RECORD_IDX;
+        last = ((progress.recordOffset + len) < (FW_VERSION_RECORD_IDX + FW_VERSION_LEN)) ? (progress.recordOffset + len) : (FW_VERSION_RECORD_IDX + FW_VERSION_LEN);
 
-                break;
+        if ( first < last )
+        {
+            memcpy(&progress.fwVersion[first - FW_VERSION_RECORD_IDX], &data[first - progress.recordOffset], last - first);
+        }
+    }
+    else
+    {
+        progress.ssmCrc = xRunningCrc(progress.ssmCrc, &data[skip], len - skip);
+    }
+}
 
-            case WAITING_ON_SSM_HEADER:
+//write the buffer to flash, move on to the next record if this one is done, and save a checkpoint
+static bool xFlushAndCheckpoint(void)
+{
+    if ( writeBufferLen != 0u )
+    {
+        if ( FLASH_write(nextAddrToStoreImage, nextFlashWriteBuffer, writeBufferLen) != FLASH_SUCCESS )
+        {
+            //the next connection writes it again from the last checkpoint
+            elogError("OTA flash write failed at 0x%X", nextAddrToStoreImage);
+            return false;
+        }
 
-                //copy the next X ssm packet bytes into the temporary buffer...
-                memcpy(&tempBufferForAmSsmCrossover[tempBufferIdx], p->next->payload, (RECORD_HEADER_LEN - ssmBytesInPacket));
+        nextAddrToStoreImage += writeBufferLen;
+        writeBufferLen = 0u;
+    }
 
-                ssmBytesInPacket += (RECORD_HEADER_LEN - ssmBytesInPacket);
+    if ( progress.recordOffset == xCurrentRecordLength() )
+    {
+        progress.state = (progress.state == DOWNLOADING_AM_RECORD) ? WAITING_ON_SSM_HEADER : DOWNLOAD_DONE;
+        progress.recordOffset = 0u;
+    }
 
-               if ( tempBufferForAmSsmCrossover[amBytesInPacket] == SSM_IMAGE)
-               {
-                   //this is an SSM record and follows the OTA package format so we can continue to parse it
+    checkpoint = progress;
 
-                   //record length - cs, metadata, and binary
-                   ssmRecordLength = ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX + amBytesInPacket] <<24) | ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX+1+amBytesInPacket] <<16)
-                                              | ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX+2+amBytesInPacket] << 8) | ((uint32_t)tempBufferForAmSsmCrossover[RECORD_LEN_IDX+3+amBytesInPacket]);
+    //a checkpoint that could not be saved only costs downloading these bytes again after a power down
+    (void)xSaveProgress(&checkpoint);
 
-                   //now start saving at the SSM slot
-                   nextAddrToStoreImage = ssmImageStartAddr;
-               }
-               else
-               {
+    elogDebug("incoming bytes (%lu)\n", progress.pkgOffset);
 
-                   //this packet does NOT follow the OTA package format - stop receiving the file
-                   tcp_recved(tpcb, p->tot_len);
-                   pbuf_free(p);
+    return true;
+}
 
-                   //bail
-                   EVT_indicateFwDownloadFail();
+static uint32_t xCurrentRecordLength(void)
+{
+    return (progress.state == DOWNLOADING_AM_RECORD) ? progress.amRecordLength : progress.ssmRecordLength;
+}
 
-                   return tcp_close(tpcb);
-               }
+//new checkpoint at byte 0 of this job
+static void xStartOver(void)
+{
+    memset(&checkpoint, 0, sizeof(checkpoint));
+    checkpoint.jobHash = xHashUrl(fileLocationUrl);
+    checkpoint.loadedSlot = (uint8_t)MEM_getLoadedImage();
+    checkpoint.state = FIRST_PACKET;
+    checkpoint.amCrc = 0xFFFF;
+    checkpoint.ssmCrc = 0xFFFF;
+}
 
-                p->payload += (RECORD_HEADER_LEN - ssmBytesInPacket);
+//put the parser back to the last checkpoint, the write buffer was empty when it was taken
+static void xRestoreCheckpoint(void)
+{
+    progress = checkpoint;
+    writeBufferLen = 0u;
+    recordHeaderIdx = 0u;
+    formatError = false;
 
-                //copy the payload into a buffer so its easier to operate on:
-                memcpy(&nextFlashWriteBuffer[writeBufferLen], p->payload, p->len - (RECORD_HEADER_LEN - ssmBytesInPacket));
-                writeBufferLen += p->len - (RECORD_HEADER_LEN - ssmBytesInPacket);
+    if ( progress.state == DOWNLOADING_SSM_RECORD )
+    {
+        nextAddrToStoreImage = ssmImageStartAddr + progress.recordOffset;
+    }
+    else
+    {
+        nextAddrToStoreImage = amImageStartAddr + progress.recordOffset;
+    }
+}
 
-                //second chain
+//FNV-1a
+static uint32_t xHashUrl(const char *url)
+{
+    uint32_t hash = 2166136261ul;
 
-                if(p->next != NULL )
-                {
+    while ( *url != '\0' )
+    {
+        hash ^= (uint8_t)*url++;
+        hash *= 16777619ul;
+    }
 
-                    memcpy(&nextFlashWriteBuffer[writeBufferLen], p->next->payload, p->next->len);
+    return hash;
+}
 
-                    writeBufferLen += p->next->len;
+//status code from the "HTTP/1.1 206 Partial Content" line, 0 if there is none
+static uint16_t xGetHttpStatus(struct pbuf *hdr)
+{
+    char line[16];
+    char *pStatus;
+    u16_t len = pbuf_copy_partial(hdr, line, sizeof(line) - 1u, 0);
 
-                    //final chain
-                    if ( p->next->next != NULL )
-                    {
-                        //another copy...
-                        memcpy(&nextFlashWriteBuffer[writeBufferLen], p->next->next->payload, p->next->next->len);
-                        writeBufferLen += p->next->next->len;
-                    }
-                }
+    line[len] = '\0';
+    pStatus = strchr(line, ' ');
 
-                downloadState = DOWNLOADING_SSM_RECORD;
+    return (pStatus == NULL) ? 0u : (uint16_t)strtoul(pStatus + 1, NULL, 10);
+}
 
-                break;
-            default:
-                break;
-        }
+//"Content-Range: bytes <start>-<end>/<total>"
+static bool xGetContentRange(struct pbuf *hdr, uint32_t *start, uint32_t *total)
+{
+    char value[32];
+    char *pEnd;
+    u16_t len;
+    u16_t idx = pbuf_memfind(hdr, CONTENT_RANGE_PREFIX, sizeof(CONTENT_RANGE_PREFIX) - 1u, 0);
+
+    if ( idx == 0xFFFF )
+    {
+        return false;
+    }
+
+    len = pbuf_copy_partial(hdr, value, sizeof(value) - 1u, idx + sizeof(CONTENT_RANGE_PREFIX) - 1u);
+    value[len] = '\0';
+
+    *start = strtoul(value, &pEnd, 10);
+    if ( *pEnd != '-' )
+    {
+        return false;
+    }
 
-        tcp_recved(tpcb, p->tot_len);
-        pbuf_free(p);
+    (void)strtoul(pEnd + 1, &pEnd, 10);
+    if ( *pEnd != '/' )
+    {
+        return false;
+    }
 
-        totalIncomingBytes += thisPacketLen;
-        packetCnt++;
+    *total = strtoul(pEnd + 1, &pEnd, 10);
 
-        elogDebug("incoming bytes (%lu)\n",totalIncomingBytes);
+    return true;
+}
 
-        if (totalIncomingBytes >= fileSize)
+/*******************************************************************************
+Find the newest valid checkpoint in the progress block
+*******************************************************************************/
+static bool xLoadProgress(otaProgress_t *pSaved)
+{
+    otaProgressRecord_t record;
+    bool found = false;
+    int32_t page;
+
+    progressPage = -1;
+    progressSeq = 0u;
+
+    for (page = 0; page < NUM_PAGE_BLOCK; page++)
+    {
+        if ( FLASH_read(xProgressPageAddress(page), (uint8_t*)&record, sizeof(record)) != FLASH_SUCCESS )
         {
-           elogInfo("incoming bytes (%lu) >= filesize (%lu)\n", totalIncomingBytes, fileSize);
-           elogInfo("Last packet received -> closing of the tcp connection has been initiated");
-           totalIncomingBytes = 0;
-           packetCnt = 0;
+            continue;
+        }
 
-           //do a final write with the remaining characters
-           FLASH_write(nextAddrToStoreImage, (uint8_t*)&nextFlashWriteBuffer, writeBufferLen);
+        if ( (record.magic == OTA_PROGRESS_MAGIC) &&
+             (record.check == xRunningCrc(0xFFFF, (const uint8_t*)&record, offsetof(otaProgressRecord_t, check))) &&
+             ((found == false) || (record.seq >= progressSeq)) )
+        {
+            found = true;
+            progressPage = page;
+            progressSeq = record.seq + 1u;
+            *pSaved = record.progress;
+        }
+    }
 
-           writeBufferLen = 0;
+    return found;
+}
 
-           //finally, update the image registry so that on the next PC, the BL will
-           //see that we have a new primary image (the one we just downloaded)
-           downloadFinishedUpdateRegistry();
+/*******************************************************************************
+Append a checkpoint after the newest one, erasing the block first when it is full
+*******************************************************************************/
+static bool xSaveProgress(const otaProgress_t *pProgress)
+{
+    otaProgressRecord_t record;
+    uint32_t existing;
+    int32_t page = progressPage + 1;
+
+    //pages damaged by a power loss part way through a write are skipped
+    while ( (page < NUM_PAGE_BLOCK) &&
+            ((FLASH_read(xProgressPageAddress(page), (uint8_t*)&existing, sizeof(existing)) != FLASH_SUCCESS) ||
+             (existing != 0xFFFFFFFFul)) )
+    {
+        page++;
+    }
 
-           //close off the connection
-           return tcp_close(tpcb);
+    if ( page >= NUM_PAGE_BLOCK )
+    {
+        if ( FLASH_erase(APP_MEM_ADR_OTA_PROGRESS_START, BLOCK_SIZE) != FLASH_SUCCESS )
+        {
+            elogError("OTA progress erase failed");
+            return false;
         }
+
+        page = 0;
     }
 
-    return ERR_OK;
+    record.magic = OTA_PROGRESS_MAGIC;
+    record.seq = progressSeq;
+    record.progress = *pProgress;
+    record.check = xRunningCrc(0xFFFF, (const uint8_t*)&record, offsetof(otaProgressRecord_t, check));
+
+    //the page is used either way, a failed program is skipped next time
+    progressPage = page;
+
+    if ( FLASH_programPage(xProgressPageAddress(page), (uint8_t*)&record, sizeof(record)) != FLASH_SUCCESS )
+    {
+        return false;
+    }
+
+    progressSeq++;
+
+    return true;
+}
+
+//a checkpoint for no job, nothing is resumed from it
+static void xClearProgress(void)
+{
+    otaProgress_t none;
+
+    memset(&none, 0, sizeof(none));
+    (void)xSaveProgress(&none);
+}
+
+static uint32_t xProgressPageAddress(int32_t page)
+{
+    return APP_MEM_ADR_OTA_PROGRESS_START + ((uint32_t)page * PAGE_DATA_SIZE);
 }
 
+static uint32_t xGetBigEndian32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | ((uint32_t)p[3]);
+}
+
+
+static void xReleaseDownloadBuffers(void)
+{
+    nextFlashWriteBuffer = NULL;
+    ARENA_release(ARENA_OWNER_OTA_DOWNLOAD);
+}
+
+//crc of len bytes of flash, read through the write buffer
+static uint16_t xFlashCrc(uint32_t addr, uint32_t len)
+{
+    uint16_t crc = 0xFFFF;
+    uint32_t chunk;
+
+    while (len)
+    {
+        chunk = (len < MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM) ? len : MAX_CHARS_FROM_OTA_TO_STORE_IN_RAM;
+
+        FLASH_read(addr, nextFlashWriteBuffer, chunk);
+
+        crc = xRunningCrc(crc, nextFlashWriteBuffer, chunk);
+        len -= chunk;
+        addr += chunk;
+    }
+
+    return crc;
+}
 
 /*
      CRC-16 Attributes:
     Name                 |   Polynomial | Reversed? |  Init-value | XOR-out Check
     crc-ccitt-false [1]  |   0x11021    | False     | 0xFFFF      | 0x0000  0x29B1
  */
-static uint16_t xRunningCrc(const uint8_t* data_p, uint32_t length)
+static uint16_t xRunningCrc(uint16_t crc, const uint8_t* data_p, uint32_t length)
 {
     uint8_t x;
 
@@ -0,0 +1,177 @@
+/**************************************************************************************************
+* \file     scratchArena.c
+* \brief    Shared scratch RAM for phases that never run at the same time (OTA download, SSM
+*           programming). One owner at a time, acquire and release are checked.
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*           
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+/* Includes */
+#include "stdbool.h"
+#include "string.h"
+#include "logTypes.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "CLI.h"
+#include "lwipopts.h"
+#include "scratchArena.h"
+
+#if ( (PBUF_POOL_SIZE - 12) > ARENA_RECLAIMED_PBUFS ) || ( PBUF_POOL_BUFSIZE > 512 )
+#error "the pbuf pool grew past what the arena gave back, update ARENA_RECLAIMED_LWIP_BYTES"
+#endif
+
+//the blockBuffer in the flash handler is NOT in here - it is in use for every FLASH_read/FLASH_write,
+//including the ones made while the OTA download is holding the arena
+
+static void xArenaCommandHandlerFunction(int argc, char **argv);
+
+static uint8_t arenaBuffer[ARENA_SIZE_BYTES] __attribute__( ( aligned( 4 ) ) );
+static arenaOwner_t currentOwner = ARENA_OWNER_NONE;
+static uint32_t currentLen = 0u;
+static uint32_t highWaterBytes = 0u;
+static uint32_t conflictCount = 0u;
+
+//what each owner would need if it had its own static buffer, used to report what sharing saves
+static const uint32_t ownerBytes[ARENA_OWNER_MAX] =
+{
+    0u,
+    ARENA_OTA_DOWNLOAD_BYTES,
+    ARENA_SSM_PROGRAMMING_BYTES,
+};
+
+static const char* ownerNames[ARENA_OWNER_MAX] =
+{
+    "none",
+    "ota",
+    "ssm bsl",
+};
+
+void ARENA_init(void)
+{
+    /* register a command handler cb function */
+    CLI_Command_Handler_s arenaCmdHandler;
+    arenaCmdHandler.ptrFunction = &xArenaCommandHandlerFunction;
+    arenaCmdHandler.cmdString   = "arena";
+    arenaCmdHandler.usageString = "\n\r\tstats - owner, high water mark and the RAM the arena gave back";
+    CLI_registerThisCommandHandler(&arenaCmdHandler);
+}
+
+//returns NULL if someone else holds the arena or the request does not fit
+uint8_t* ARENA_acquire(arenaOwner_t owner, uint32_t len)
+{
+    uint8_t *buffer = NULL;
+    arenaOwner_t heldBy;
+
+    if ( (owner == ARENA_OWNER_NONE) || (owner >= ARENA_OWNER_MAX) || (len > ARENA_SIZE_BYTES) )
+    {
+        elogError("ARENA: bad request %d, %lu bytes", owner, len);
+        return NULL;
+    }
+
+    taskENTER_CRITICAL();
+
+    heldBy = currentOwner;
+
+    if ( heldBy == ARENA_OWNER_NONE )
+    {
+        currentOwner = owner;
+        currentLen = len;
+        buffer = arenaBuffer;
+
+        if ( len > highWaterBytes )
+        {
+            highWaterBytes = len;
+        }
+    }
+    else
+    {
+        conflictCount++;
+    }
+
+    taskEXIT_CRITICAL();
+
+    if ( buffer == NULL )
+    {
+        elogError("ARENA: %s requested while held by %s", ownerNames[owner], ownerNames[heldBy]);
+    }
+
+    return buffer;
+}
+
+void ARENA_release(arenaOwner_t owner)
+{
+    arenaOwner_t heldBy;
+
+    taskENTER_CRITICAL();
+
+    heldBy = currentOwner;
+
+    if ( heldBy == owner )
+    {
+        currentOwner = ARENA_OWNER_NONE;
+        currentLen = 0u;
+    }
+
+    taskEXIT_CRITICAL();
+
+    if ( (heldBy != owner) && (owner < ARENA_OWNER_MAX) && (heldBy < ARENA_OWNER_MAX) )
+    {
+        elogError("ARENA: %s released but held by %s", ownerNames[owner], ownerNames[heldBy]);
+    }
+}
+
+arenaOwner_t ARENA_getOwner(void)
+{
+    return currentOwner;
+}
+
+uint32_t ARENA_getHighWaterBytes(void)
+{
+    return highWaterBytes;
+}
+
+uint32_t ARENA_getConflictCount(void)
+{
+    return conflictCount;
+}
+
+static void xArenaCommandHandlerFunction(int argc, char **argv)
+{
+    uint32_t totalOwnerBytes = 0u;
+
+    if ( (argc == ONE_ARGUMENT) &&  (0 == strcmp(argv[FIRST_ARG_IDX], "stats")) )
+    {
+        for (uint8_t i = ARENA_OWNER_NONE + 1; i < ARENA_OWNER_MAX; i++)
+        {
+            elogInfo("%s: %lu bytes", ownerNames[i], ownerBytes[i]);
+            totalOwnerBytes += ownerBytes[i];
+        }
+
+        elogInfo("arena size: %lu bytes, owner: %s (%lu bytes)", (uint32_t)ARENA_SIZE_BYTES, ownerNames[currentOwner], currentLen);
+        elogInfo("high water: %lu bytes, conflicts: %lu", highWaterBytes, conflictCount);
+        elogInfo("sharing saves %lu bytes over one buffer per phase", totalOwnerBytes - (uint32_t)ARENA_SIZE_BYTES);
+        elogInfo("reclaimed: %lu bytes (%lu before the arena), %lu to the lwIP pbuf pool, %lu to the heap",
+                 (uint32_t)ARENA_RECLAIMED_BYTES, (uint32_t)ARENA_UNSHARED_BYTES, (uint32_t)ARENA_RECLAIMED_LWIP_BYTES, (uint32_t)ARENA_RECLAIMED_HEAP_BYTES);
+    }
+    else
+    {
+        elogInfo("Invalid args");
+    }
+}
@@ -0,0 +1,64 @@
+/**************************************************************************************************
+* \file     scratchArena.h
+* \brief    Shared scratch RAM for phases that never run at the same time (OTA download, SSM
+*           programming). One owner at a time, acquire and release are checked.
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*           
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#ifndef HANDLERS_SCRATCHARENA_H_
+#define HANDLERS_SCRATCHARENA_H_
+
+#include "stdint.h"
+#include "MT29F1.h"
+
+//scratch needed by each phase, the arena is sized for the largest one
+#define ARENA_OTA_WRITE_BUFFER_BYTES        (PAGE_DATA_SIZE * 16)
+#define ARENA_OTA_DOWNLOAD_BYTES            ARENA_OTA_WRITE_BUFFER_BYTES
+#define ARENA_SSM_PROGRAMMING_BYTES         (PAGE_DATA_SIZE)
+
+#define ARENA_SIZE_BYTES                    ARENA_OTA_DOWNLOAD_BYTES
+
+//what the phases held as their own static buffers before the arena: the 40 page OTA write buffer,
+//the 2000 byte AM/SSM crossover buffer and the SSM programming page buffer
+#define ARENA_UNSHARED_BYTES                ( (PAGE_DATA_SIZE * 40) + 2000 + PAGE_DATA_SIZE )
+#define ARENA_RECLAIMED_BYTES               ( ARENA_UNSHARED_BYTES - ARENA_SIZE_BYTES )
+
+//where the reclaimed RAM went: the 20 pbufs lwipopts.h added to the pool (512 bytes of data and
+//a header each, 32 bytes is more than the header needs) and the rest to the first FreeRTOS heap region
+#define ARENA_RECLAIMED_PBUFS               20
+#define ARENA_RECLAIMED_LWIP_BYTES          ( ARENA_RECLAIMED_PBUFS * (512 + 32) )
+#define ARENA_RECLAIMED_HEAP_BYTES          ( ARENA_RECLAIMED_BYTES - ARENA_RECLAIMED_LWIP_BYTES )
+
+typedef enum
+{
+    ARENA_OWNER_NONE,
+    ARENA_OWNER_OTA_DOWNLOAD,
+    ARENA_OWNER_SSM_PROGRAMMING,
+    ARENA_OWNER_MAX,
+}arenaOwner_t;
+
+extern void ARENA_init(void);
+extern uint8_t* ARENA_acquire(arenaOwner_t owner, uint32_t len);
+extern void ARENA_release(arenaOwner_t owner);
+extern arenaOwner_t ARENA_getOwner(void);
+extern uint32_t ARENA_getHighWaterBytes(void);
+extern uint32_t ARENA_getConflictCount(void);
+
+#endif /* HANDLERS_SCRATCHARENA_H_ */
@@ -0,0 +1,135 @@
+/**************************************************************************************************
+* \file     sensorDataEncoder.c
+* \brief    Encodes a stored sensor data log as a SensorDataMessage without building the message struct
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+/* Includes */
+#include "stdbool.h"
+#include "string.h"
+#include "logTypes.h"
+#include "pb_encode.h"
+#include "sensorDataEncoder.h"
+
+uint32_t SDENC_encodeLog(const CommonHeader *pHeader, const APP_NVM_SENSOR_DATA_WITH_HEADER_T *pLog, bool sendStrokes, uint8_t *buf, uint16_t bufLen);
+
+static bool xEncodeUint32Field(pb_ostream_t *stream, uint32_t tag, uint32_t value);
+static bool xEncodeRepeatedField(pb_ostream_t *stream, uint32_t tag, const void *pValues, uint8_t valueSize, uint8_t count);
+static uint32_t xGetLogValue(const void *pValues, uint8_t valueSize, uint8_t idx);
+
+// Encode a SensorDataMessage straight from a stored log. There is no SensorDataMessage struct: the hourly
+// arrays are widened one value at a time as they go out, in the field order pb_encode() would use, so the
+// bytes are the same as encoding the filled in struct.
+uint32_t SDENC_encodeLog(const CommonHeader *pHeader, const APP_NVM_SENSOR_DATA_WITH_HEADER_T *pLog, bool sendStrokes, uint8_t *buf, uint16_t bufLen)
+{
+    uint32_t msgLen;
+    bool status;
+    uint8_t strokeCount = (sendStrokes == true) ? APP_NVM_SAMPLES_PER_DAY : 0u;
+
+    /* Create a stream that will write to our buffer. */
+    pb_ostream_t stream = pb_ostream_from_buffer(buf, bufLen);
+
+    status = pb_encode_tag(&stream, PB_WT_STRING, SensorDataMessage_header_tag) &&
+             pb_encode_submessage(&stream, CommonHeader_fields, pHeader);
+
+    //humidity is not sent, it is always 0
+    status = status &&
+             xEncodeRepeatedField(&stream, SensorDataMessage_litersPerHour_tag, pLog->litersPerHour, sizeof(pLog->litersPerHour[0]), APP_NVM_SAMPLES_PER_DAY) &&
+             xEncodeRepeatedField(&stream, SensorDataMessage_tempPerHour_tag, pLog->tempPerHour, sizeof(pLog->tempPerHour[0]), APP_NVM_SAMPLES_PER_DAY) &&
+             xEncodeRepeatedField(&stream, SensorDataMessage_strokesPerHour_tag, pLog->strokesPerHour, sizeof(pLog->strokesPerHour[0]), strokeCount) &&
+             xEncodeRepeatedField(&stream, SensorDataMessage_strokeHeightPerHour_tag, pLog->strokeHeightPerHour, sizeof(pLog->strokeHeightPerHour[0]), strokeCount);
+
+    status = status &&
+             xEncodeUint32Field(&stream, SensorDataMessage_dailyLiters_tag, pLog->dailyLiters) &&
+             xEncodeUint32Field(&stream, SensorDataMessage_avgLiters_tag, pLog->avgLiters) &&
+             xEncodeUint32Field(&stream, SensorDataMessage_totalLiters_tag, pLog->totalLiters) &&
+             xEncodeUint32Field(&stream, SensorDataMessage_breakdown_tag, (pLog->breakdown ? 1u : 0u)) &&
+             xEncodeUint32Field(&stream, SensorDataMessage_pumpCapacity_tag, pLog->pumpCapacity) &&
+             xEncodeUint32Field(&stream, SensorDataMessage_pumpUsage_tag, pLog->pumpUsage) &&
+             xEncodeUint32Field(&stream, SensorDataMessage_dryStrokes_tag, pLog->dryStrokes) &&
+             xEncodeUint32Field(&stream, SensorDataMessage_dryStrokeHeight_tag, pLog->dryStrokeHeight) &&
+             xEncodeUint32Field(&stream, SensorDataMessage_pumpUnusedTime_tag, pLog->pumpUnusedTime);
+
+    msgLen = stream.bytes_written;
+
+    /* Then check for any errors.. */
+    if ( status == false )
+    {
+       elogError("Encoding failed: %s\n", PB_GET_ERROR(&stream));
+       msgLen = 0;
+    }
+
+    //return the message length
+    return msgLen;
+}
+
+static bool xEncodeUint32Field(pb_ostream_t *stream, uint32_t tag, uint32_t value)
+{
+    return ( pb_encode_tag(stream, PB_WT_VARINT, tag) && pb_encode_varint(stream, value) );
+}
+
+// Repeated uint32 field from a packed log array of 1 or 2 byte values. pb_encode() writes repeated
+// scalars in packed form, so this does too: one tag, the length, then the varints.
+static bool xEncodeRepeatedField(pb_ostream_t *stream, uint32_t tag, const void *pValues, uint8_t valueSize, uint8_t count)
+{
+    pb_ostream_t sizing = PB_OSTREAM_SIZING;
+    bool status = true;
+    uint8_t i;
+
+    if ( count == 0u )
+    {
+        return true;
+    }
+
+    for ( i = 0; i < count; i++ )
+    {
+        pb_encode_varint(&sizing, xGetLogValue(pValues, valueSize, i));
+    }
+
+    status = pb_encode_tag(stream, PB_WT_STRING, tag) && pb_encode_varint(stream, sizing.bytes_written);
+
+    for ( i = 0; (i < count) && (status == true); i++ )
+    {
+        status = pb_encode_varint(stream, xGetLogValue(pValues, valueSize, i));
+    }
+
+    return status;
+}
+
+static uint32_t xGetLogValue(const void *pValues, uint8_t valueSize, uint8_t idx)
+{
+    const uint8_t *pBytes = (const uint8_t *)pValues;
+    uint16_t value16;
+    uint32_t value;
+
+    if ( valueSize == sizeof(uint16_t) )
+    {
+        //the log is packed, the value may not be aligned
+        memcpy(&value16, &pBytes[idx * sizeof(uint16_t)], sizeof(value16));
+        value = value16;
+    }
+    else
+    {
+        value = pBytes[idx];
+    }
+
+    return value;
+}
@@ -0,0 +1,36 @@
+/**************************************************************************************************
+* \file     sensorDataEncoder.h
+* \brief    Encodes a stored sensor data log as a SensorDataMessage without building the message struct
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#ifndef HANDLERS_SENSORDATAENCODER_H_
+#define HANDLERS_SENSORDATAENCODER_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+#include "messages.pb.h"
+#include "APP_NVM_Cfg_Shared.h"
+
+//header is the live part of the message header (rssi, imei, ...), the body comes straight from the log.
+//Returns the encoded length, 0 if it did not fit in bufLen.
+extern uint32_t SDENC_encodeLog(const CommonHeader *pHeader, const APP_NVM_SENSOR_DATA_WITH_HEADER_T *pLog, bool sendStrokes, uint8_t *buf, uint16_t bufLen);
+
+#endif /* HANDLERS_SENSORDATAENCODER_H_ */
@@ -0,0 +1,681 @@
+/**************************************************************************************************
+* \file     tlsSessionCache.c
+* \brief    Keeps the TLS session negotiated with AWS IoT across power downs, so the next connection
+*           can resume it instead of running a full handshake over the cell link.
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+/* Includes */
+#include "stdbool.h"
+#include "stddef.h"
+#include "string.h"
+#include "logTypes.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "CLI.h"
+#include <stm32l4xx_hal.h>
+#include "MT29F1.h"
+#include "memoryMap.h"
+#include "flashHandler.h"
+#include "ATECC608A.h"
+#include "ntpHandler.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/entropy_poll.h"
+#include "tlsSessionCache.h"
+
+// Layout of the session region: one record per page, appended in order through the block. The record with
+// the highest seq is the cached session, a record without a payload (a tombstone) means there is none.
+// The block is erased when its last page has been used, a power loss in between only costs a full
+// handshake on the next connection.
+//
+// The payload holds the master secret, so it is sealed with AES-128-GCM under a key derived from the MCU
+// and ATECC608A serial numbers, with the record header as additional data. Neither serial is secret: the
+// UID reads over SWD and the ATECC608A serial over I2C, without any key. So the seal only keeps the master
+// secret out of a plain dump of the NAND and rejects records that were corrupted or copied from another
+// unit. Anyone with the board in hand and this source can derive the key, read the master secret and
+// decrypt recorded sessions that resumed it, for up to TLSC_MAX_AGE_SECS. Protecting against that needs
+// the key from a secret the ATECC608A never returns (a KDF or HMAC over a provisioned slot), which the
+// provisioning does not set up today.
+#define TLSC_RECORD_MAGIC                   0x544C5331ul
+#define TLSC_ERASED_WORD                    0xFFFFFFFFul
+#define TLSC_MUTEX_WAIT_MS                  6000
+
+#define TLSC_KEY_LEN                        16
+#define TLSC_NONCE_LEN                      12
+#define TLSC_TAG_LEN                        16
+#define TLSC_DIGEST_LEN                     32
+#define TLSC_FORMAT_VERSION                 1
+
+//serialized session: version, ciphersuite, compression, id len, id, master secret, verify result,
+//max fragment length code, truncated hmac, encrypt then mac, ticket lifetime, ticket len, then the ticket
+#define TLSC_FIXED_LEN                      (1 + 2 + 1 + 1 + 32 + 48 + 4 + 1 + 1 + 1 + 4 + 2)
+#define TLSC_MAX_PLAIN_LEN                  (TLSC_FIXED_LEN + TLSC_MAX_TICKET_LEN)
+
+typedef struct __attribute__ ((__packed__))
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t savedAt;       // NTP epoch when the session was saved, 0 if the time was not known
+    uint16_t len;           // sealed bytes after the header, 0 for a tombstone
+    uint8_t nonce[TLSC_NONCE_LEN];
+    uint8_t tag[TLSC_TAG_LEN];
+}tlscRecordHeader_t;
+
+//header fields covered by the tag
+#define TLSC_AAD_LEN                        offsetof(tlscRecordHeader_t, nonce)
+
+static SemaphoreHandle_t xTlscMutex;
+static StaticSemaphore_t xTlscMutexBuffer;
+
+static uint8_t recordBuffer[sizeof(tlscRecordHeader_t) + TLSC_MAX_PLAIN_LEN];
+static uint8_t plainBuffer[TLSC_MAX_PLAIN_LEN];
+static mbedtls_gcm_context gcmCtx;
+static bool sealKeyReady = false;
+
+static int32_t currentPage = -1;                // page of the newest record, -1 when the block is empty
+static uint32_t nextSeq = 0u;
+static bool currentValid = false;               // newest record holds a session rather than a tombstone
+static uint8_t currentDigest[TLSC_DIGEST_LEN];  // hash of that session, a resume that changes nothing is not rewritten
+static bool currentDigestKnown = false;
+
+static uint32_t offeredCount = 0u;
+static uint32_t resumedCount = 0u;
+static uint32_t fullCount = 0u;
+static uint32_t writeCount = 0u;
+static uint32_t rejectedCount = 0u;
+
+static void xScanRecords(void);
+static bool xDeriveSealKey(void);
+static bool xWriteRecord(const uint8_t *plain, uint16_t len);
+static bool xReadRecord(int32_t page, uint16_t *len, uint32_t *savedAt);
+static uint16_t xSerializeSession(const mbedtls_ssl_session *session, uint8_t *buf);
+static bool xDeserializeSession(const uint8_t *buf, uint16_t len, mbedtls_ssl_session *session);
+static bool xIsTooOld(uint32_t savedAt, const mbedtls_ssl_session *session);
+static uint32_t xPageAddress(int32_t page);
+static void xPut16(uint8_t **p, uint16_t v);
+static void xPut32(uint8_t **p, uint32_t v);
+static uint16_t xGet16(const uint8_t **p);
+static uint32_t xGet32(const uint8_t **p);
+static void xTlscCommandHandlerFunction(int argc, char **argv);
+
+void TLSC_init(void)
+{
+    /* register a command handler cb function */
+    CLI_Command_Handler_s tlscCmdHandler;
+    tlscCmdHandler.ptrFunction = &xTlscCommandHandlerFunction;
+    tlscCmdHandler.cmdString   = "tlsc";
+    tlscCmdHandler.usageString = "\n\r\tstats \n\r\tclear - forget the cached session";
+    CLI_registerThisCommandHandler(&tlscCmdHandler);
+
+    /* create a mutex */
+    xTlscMutex = xSemaphoreCreateMutexStatic(&xTlscMutexBuffer);
+
+    mbedtls_gcm_init(&gcmCtx);
+    sealKeyReady = false;
+
+    xScanRecords();
+
+    elogInfo("TLSC: %s (seq %lu)", currentValid ? "session cached" : "no session", nextSeq);
+}
+
+// Fill in the session to offer on the next handshake. Returns false if there is nothing usable cached. The
+// caller frees the session with mbedtls_ssl_session_free() either way.
+bool TLSC_load(mbedtls_ssl_session *session)
+{
+    uint16_t len = 0u;
+    uint32_t savedAt = 0u;
+    bool loaded = false;
+
+    if (session == NULL) return false;
+
+    if( xSemaphoreTake(xTlscMutex, ( TickType_t ) TLSC_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        if ( (currentValid == true) && (xDeriveSealKey() == true) )
+        {
+            if ( (xReadRecord(currentPage, &len, &savedAt) == false) || (len == 0u) ||
+                 (xDeserializeSession(plainBuffer, len, session) == false) )
+            {
+                elogError("TLSC: cached session unreadable");
+            }
+            else if ( xIsTooOld(savedAt, session) == true )
+            {
+                elogInfo("TLSC: cached session expired");
+            }
+            else
+            {
+                mbedtls_sha256_ret(plainBuffer, len, currentDigest, 0);
+                currentDigestKnown = true;
+                offeredCount++;
+                loaded = true;
+            }
+
+            if ( loaded == false )
+            {
+                //leave it for the next save to replace, there is no point reading it again until then
+                currentValid = false;
+            }
+        }
+
+        mbedtls_platform_zeroize(plainBuffer, sizeof(plainBuffer));
+
+        /* Return mutex */
+        xSemaphoreGive(xTlscMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+
+    return loaded;
+}
+
+// Store the session from a successful handshake. A resumed session that comes back unchanged (no new
+// ticket) is already what is stored and is not written again.
+void TLSC_save(const mbedtls_ssl_session *session, bool resumed)
+{
+    uint8_t digest[TLSC_DIGEST_LEN];
+    uint16_t len;
+
+    if (session == NULL) return;
+
+    if( xSemaphoreTake(xTlscMutex, ( TickType_t ) TLSC_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        if ( resumed == true )
+        {
+            resumedCount++;
+        }
+        else
+        {
+            fullCount++;
+        }
+
+        len = xSerializeSession(session, plainBuffer);
+
+        if ( len == 0u )
+        {
+            elogNotice("TLSC: session not cached");
+        }
+        else
+        {
+            mbedtls_sha256_ret(plainBuffer, len, digest, 0);
+
+            if ( (currentValid == true) && (currentDigestKnown == true) &&
+                 (memcmp(digest, currentDigest, sizeof(digest)) == 0) )
+            {
+                //nothing changed
+            }
+            else if ( (xDeriveSealKey() == true) && (xWriteRecord(plainBuffer, len) == true) )
+            {
+                memcpy(currentDigest, digest, sizeof(currentDigest));
+                currentDigestKnown = true;
+                currentValid = true;
+                writeCount++;
+            }
+        }
+
+        mbedtls_platform_zeroize(plainBuffer, sizeof(plainBuffer));
+
+        /* Return mutex */
+        xSemaphoreGive(xTlscMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+}
+
+// Forget the cached session, the next connection does a full handshake.
+void TLSC_invalidate(void)
+{
+    if( xSemaphoreTake(xTlscMutex, ( TickType_t ) TLSC_MUTEX_WAIT_MS) == pdTRUE )
+    {
+        if ( (currentPage >= 0) && (currentValid == true) )
+        {
+            rejectedCount++;
+
+            //the tombstone needs no key, only the payload is sealed
+            xWriteRecord(NULL, 0u);
+        }
+
+        currentValid = false;
+        currentDigestKnown = false;
+
+        /* Return mutex */
+        xSemaphoreGive(xTlscMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+}
+
+/*******************************************************************************
+Find the newest record in the block. Only the headers are read here, the record
+is authenticated when it is loaded.
+*******************************************************************************/
+static void xScanRecords(void)
+{
+    tlscRecordHeader_t hdr;
+    bool found = false;
+    int32_t page;
+
+    currentPage = -1;
+    nextSeq = 0u;
+    currentValid = false;
+
+    for (page = 0; page < NUM_PAGE_BLOCK; page++)
+    {
+        if ( FLASH_read(xPageAddress(page), (uint8_t*)&hdr, sizeof(hdr)) != FLASH_SUCCESS )
+        {
+            continue;
+        }
+
+        if ( (hdr.magic == TLSC_RECORD_MAGIC) && (hdr.len <= TLSC_MAX_PLAIN_LEN) &&
+             ((found == false) || (hdr.seq >= nextSeq)) )
+        {
+            found = true;
+            currentPage = page;
+            nextSeq = hdr.seq + 1u;
+            currentValid = (hdr.len > 0u);
+        }
+    }
+}
+
+/*******************************************************************************
+The sealing key is derived on first use, the ATECC608A is not up yet when the
+cache is initialized. It is only as secret as the two serial numbers, see the
+top of the file.
+*******************************************************************************/
+static bool xDeriveSealKey(void)
+{
+    static const char label[] = "AM TLS session cache";
+    mbedtls_sha256_context sha;
+    uint8_t serial[ATE_SERIAL_NUM_LEN];
+    uint8_t digest[TLSC_DIGEST_LEN];
+    uint32_t uid[3];
+
+    if ( sealKeyReady == true )
+    {
+        return true;
+    }
+
+    if ( ATECC_getUniqueId(serial) == false )
+    {
+        return false;
+    }
+
+    uid[0] = HAL_GetUIDw0();
+    uid[1] = HAL_GetUIDw1();
+    uid[2] = HAL_GetUIDw2();
+
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts_ret(&sha, 0);
+    mbedtls_sha256_update_ret(&sha, (const uint8_t*)label, sizeof(label) - 1u);
+    mbedtls_sha256_update_ret(&sha, (const uint8_t*)uid, sizeof(uid));
+    mbedtls_sha256_update_ret(&sha, serial, sizeof(serial));
+    mbedtls_sha256_finish_ret(&sha, digest);
+    mbedtls_sha256_free(&sha);
+
+    sealKeyReady = (mbedtls_gcm_setkey(&gcmCtx, MBEDTLS_CIPHER_ID_AES, digest, TLSC_KEY_LEN * 8u) == 0);
+    mbedtls_platform_zeroize(digest, sizeof(digest));
+
+    if ( sealKeyReady == false )
+    {
+        elogError("TLSC: key setup failed");
+    }
+
+    return sealKeyReady;
+}
+
+/*******************************************************************************
+Append a record after the newest one, erasing the block first when it is full.
+A NULL payload writes a tombstone.
+*******************************************************************************/
+static bool xWriteRecord(const uint8_t *plain, uint16_t len)
+{
+    tlscRecordHeader_t hdr;
+    tlscRecordHeader_t existing;
+    int32_t page = currentPage + 1;
+    size_t olen;
+    uint8_t i;
+    int err;
+
+    //pages damaged by a power loss part way through a write are skipped
+    while ( (page < NUM_PAGE_BLOCK) &&
+            ((FLASH_read(xPageAddress(page), (uint8_t*)&existing, sizeof(existing)) != FLASH_SUCCESS) ||
+             (existing.magic != TLSC_ERASED_WORD)) )
+    {
+        page++;
+    }
+
+    if ( page >= NUM_PAGE_BLOCK )
+    {
+        if ( FLASH_erase(APP_MEM_ADR_TLS_SESSION_START, BLOCK_SIZE) != FLASH_SUCCESS )
+        {
+            elogError("TLSC: erase failed");
+            return false;
+        }
+
+        page = 0;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = TLSC_RECORD_MAGIC;
+    hdr.seq = nextSeq;
+    hdr.savedAt = NTP_getTime();
+    hdr.len = (plain == NULL) ? 0u : len;
+
+    //the seq makes the nonce unique under this key, the random part covers the block being wiped
+    memcpy(hdr.nonce, &hdr.seq, sizeof(hdr.seq));
+    for (i = sizeof(hdr.seq); i < TLSC_NONCE_LEN; i += (uint8_t)olen)
+    {
+        olen = 0u;
+        mbedtls_hardware_poll(NULL, &hdr.nonce[i], TLSC_NONCE_LEN - i, &olen);
+
+        if ( olen == 0u )
+        {
+            break;
+        }
+    }
+
+    err = 0;
+
+    if ( hdr.len > 0u )
+    {
+        err = mbedtls_gcm_crypt_and_tag(&gcmCtx, MBEDTLS_GCM_ENCRYPT, hdr.len, hdr.nonce, TLSC_NONCE_LEN,
+                                        (const uint8_t*)&hdr, TLSC_AAD_LEN, plain,
+                                        recordBuffer + sizeof(hdr), TLSC_TAG_LEN, hdr.tag);
+    }
+
+    memcpy(recordBuffer, &hdr, sizeof(hdr));
+
+    if ( (err != 0) ||
+         (FLASH_programPage(xPageAddress(page), recordBuffer, sizeof(hdr) + hdr.len) != FLASH_SUCCESS) )
+    {
+        elogError("TLSC: write failed %d", err);
+        return false;
+    }
+
+    currentPage = page;
+    nextSeq++;
+
+    return true;
+}
+
+/*******************************************************************************
+Read a record and open it into plainBuffer. Fails if the record was altered,
+sealed on another unit or only partly written.
+*******************************************************************************/
+static bool xReadRecord(int32_t page, uint16_t *len, uint32_t *savedAt)
+{
+    tlscRecordHeader_t hdr;
+
+    if ( FLASH_read(xPageAddress(page), recordBuffer, sizeof(recordBuffer)) != FLASH_SUCCESS )
+    {
+        return false;
+    }
+
+    memcpy(&hdr, recordBuffer, sizeof(hdr));
+
+    if ( (hdr.magic != TLSC_RECORD_MAGIC) || (hdr.len > TLSC_MAX_PLAIN_LEN) )
+    {
+        return false;
+    }
+
+    if ( mbedtls_gcm_auth_decrypt(&gcmCtx, hdr.len, hdr.nonce, TLSC_NONCE_LEN, (const uint8_t*)&hdr, TLSC_AAD_LEN,
+                                  hdr.tag, TLSC_TAG_LEN, recordBuffer + sizeof(hdr), plainBuffer) != 0 )
+    {
+        elogError("TLSC: record %lu failed authentication", hdr.seq);
+        return false;
+    }
+
+    *len = hdr.len;
+    *savedAt = hdr.savedAt;
+
+    return true;
+}
+
+/*******************************************************************************
+Session fields that are not compiled into mbedTLS are stored as zero so the
+format does not change with the config. The server certificate is not kept, it
+is not needed to resume.
+*******************************************************************************/
+static uint16_t xSerializeSession(const mbedtls_ssl_session *session, uint8_t *buf)
+{
+    uint8_t *p = buf;
+    uint16_t ticketLen = 0u;
+    uint32_t ticketLifetime = 0u;
+    uint8_t mflCode = 0u;
+    uint8_t truncHmac = 0u;
+    uint8_t encryptThenMac = 0u;
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    if ( session->ticket_len > TLSC_MAX_TICKET_LEN )
+    {
+        return 0u;
+    }
+
+    ticketLen = (uint16_t)session->ticket_len;
+    ticketLifetime = session->ticket_lifetime;
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    mflCode = session->mfl_code;
+#endif
+#if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
+    truncHmac = (uint8_t)session->trunc_hmac;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+    encryptThenMac = (uint8_t)session->encrypt_then_mac;
+#endif
+
+    //without an id or a ticket there is nothing the server could resume
+    if ( (session->id_len == 0u) && (ticketLen == 0u) )
+    {
+        return 0u;
+    }
+
+    *p++ = TLSC_FORMAT_VERSION;
+    xPut16(&p, (uint16_t)session->ciphersuite);
+    *p++ = (uint8_t)session->compression;
+    *p++ = (uint8_t)session->id_len;
+    memcpy(p, session->id, sizeof(session->id));
+    p += sizeof(session->id);
+    memcpy(p, session->master, sizeof(session->master));
+    p += sizeof(session->master);
+    xPut32(&p, session->verify_result);
+    *p++ = mflCode;
+    *p++ = truncHmac;
+    *p++ = encryptThenMac;
+    xPut32(&p, ticketLifetime);
+    xPut16(&p, ticketLen);
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    if ( ticketLen > 0u )
+    {
+        memcpy(p, session->ticket, ticketLen);
+        p += ticketLen;
+    }
+#endif
+
+    return (uint16_t)(p - buf);
+}
+
+static bool xDeserializeSession(const uint8_t *buf, uint16_t len, mbedtls_ssl_session *session)
+{
+    const uint8_t *p = buf;
+    uint16_t ticketLen;
+    uint32_t ticketLifetime;
+    uint8_t mflCode;
+    uint8_t truncHmac;
+    uint8_t encryptThenMac;
+
+    if ( (len < TLSC_FIXED_LEN) || (*p++ != TLSC_FORMAT_VERSION) )
+    {
+        return false;
+    }
+
+    session->ciphersuite = xGet16(&p);
+    session->compression = *p++;
+    session->id_len = *p++;
+    memcpy(session->id, p, sizeof(session->id));
+    p += sizeof(session->id);
+    memcpy(session->master, p, sizeof(session->master));
+    p += sizeof(session->master);
+    session->verify_result = xGet32(&p);
+    mflCode = *p++;
+    truncHmac = *p++;
+    encryptThenMac = *p++;
+    ticketLifetime = xGet32(&p);
+    ticketLen = xGet16(&p);
+
+    if ( (session->id_len > sizeof(session->id)) || (ticketLen != (len - TLSC_FIXED_LEN)) )
+    {
+        return false;
+    }
+
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    session->mfl_code = mflCode;
+#endif
+#if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
+    session->trunc_hmac = truncHmac;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+    session->encrypt_then_mac = encryptThenMac;
+#endif
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    session->ticket_lifetime = ticketLifetime;
+    session->ticket_len = 0u;
+    session->ticket = NULL;
+
+    if ( ticketLen > 0u )
+    {
+        //freed with the session by mbedtls_ssl_session_free()
+        session->ticket = mbedtls_calloc(1, ticketLen);
+
+        if ( session->ticket == NULL )
+        {
+            return false;
+        }
+
+        memcpy(session->ticket, p, ticketLen);
+        session->ticket_len = ticketLen;
+    }
+#else
+    (void)ticketLifetime;
+
+    if ( ticketLen > 0u )
+    {
+        return false;
+    }
+#endif
+
+    (void)mflCode;
+    (void)truncHmac;
+    (void)encryptThenMac;
+
+    return true;
+}
+
+/*******************************************************************************
+The age is only known when the time was synced both when the session was saved
+and now. Otherwise the session is offered and the server decides.
+*******************************************************************************/
+static bool xIsTooOld(uint32_t savedAt, const mbedtls_ssl_session *session)
+{
+    uint32_t now = NTP_getTime();
+    uint32_t maxAge = TLSC_MAX_AGE_SECS;
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    //the server's lifetime hint, a ticket past it would only be refused
+    if ( (session->ticket_lifetime > 0u) && (session->ticket_lifetime < maxAge) )
+    {
+        maxAge = session->ticket_lifetime;
+    }
+#else
+    (void)session;
+#endif
+
+    if ( (savedAt == 0u) || (now == 0u) || (now < savedAt) )
+    {
+        return false;
+    }
+
+    return ((now - savedAt) > maxAge);
+}
+
+static uint32_t xPageAddress(int32_t page)
+{
+    return APP_MEM_ADR_TLS_SESSION_START + ((uint32_t)page * PAGE_DATA_SIZE);
+}
+
+static void xPut16(uint8_t **p, uint16_t v)
+{
+    (*p)[0] = (uint8_t)(v >> 8);
+    (*p)[1] = (uint8_t)v;
+    *p += 2;
+}
+
+static void xPut32(uint8_t **p, uint32_t v)
+{
+    (*p)[0] = (uint8_t)(v >> 24);
+    (*p)[1] = (uint8_t)(v >> 16);
+    (*p)[2] = (uint8_t)(v >> 8);
+    (*p)[3] = (uint8_t)v;
+    *p += 4;
+}
+
+static uint16_t xGet16(const uint8_t **p)
+{
+    uint16_t v = (uint16_t)(((uint16_t)(*p)[0] << 8) | (*p)[1]);
+    *p += 2;
+    return v;
+}
+
+static uint32_t xGet32(const uint8_t **p)
+{
+    uint32_t v = ((uint32_t)(*p)[0] << 24) | ((uint32_t)(*p)[1] << 16) | ((uint32_t)(*p)[2] << 8) | (*p)[3];
+    *p += 4;
+    return v;
+}
+
+static void xTlscCommandHandlerFunction(int argc, char **argv)
+{
+    /* process the user input */
+    if ( (argc == ONE_ARGUMENT) &&  (0 == strcmp(argv[FIRST_ARG_IDX], "stats")) )
+    {
+        elogInfo("session %s, page %ld, next seq %lu", currentValid ? "cached" : "none", currentPage, nextSeq);
+        elogInfo("offered %lu, resumed %lu, full %lu, written %lu, rejected %lu",
+                offeredCount, resumedCount, fullCount, writeCount, rejectedCount);
+    }
+    else if ( (argc == ONE_ARGUMENT) &&  (0 == strcmp(argv[FIRST_ARG_IDX], "clear")) )
+    {
+        TLSC_invalidate();
+        elogInfo("session cache cleared");
+    }
+    else
+    {
+        elogInfo("Invaid args");
+    }
+}
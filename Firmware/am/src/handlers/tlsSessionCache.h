@@ -0,0 +1,44 @@
+/**************************************************************************************************
+* \file     tlsSessionCache.h
+* \brief    Keeps the TLS session negotiated with AWS IoT across power downs, so the next connection
+*           can resume it instead of running a full handshake over the cell link.
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#ifndef HANDLERS_TLSSESSIONCACHE_H_
+#define HANDLERS_TLSSESSIONCACHE_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+#include "mbedtls/ssl.h"
+
+//largest session ticket that is kept, a bigger one is not cached and the next connect is a full handshake
+#define TLSC_MAX_TICKET_LEN                 1024
+
+//sessions older than this are not offered, even if the server's ticket lifetime hint is longer. It also
+//bounds how long a master secret read out of the NAND is of use, the seal is not secret (tlsSessionCache.c)
+#define TLSC_MAX_AGE_SECS                   (7ul * 24ul * 60ul * 60ul)
+
+extern void TLSC_init(void);
+extern bool TLSC_load(mbedtls_ssl_session *session);
+extern void TLSC_save(const mbedtls_ssl_session *session, bool resumed);
+extern void TLSC_invalidate(void);
+
+#endif /* HANDLERS_TLSSESSIONCACHE_H_ */
@@ -32,6 +32,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "updateSsmFw.h"
+#include "scratchArena.h"
 
 #define MAX_FRAM_SECTIONS               9
 #define SSM_BOOT_UP_TIME_DELAY_MS       5000
@@ -68,7 +69,7 @@ typedef struct  __attribute__ ((__packed__))
 
 static ssmMetaData_t ssmImageMetaData = {};
 static uint32_t externalFlashAddr = 0u;
-static uint8_t pageReadBuffer[MT29F1_PAGE_SIZE];
+static uint8_t *pageReadBuffer = NULL;
 
 static bool xGetAndValidateMetaDataStruct(uint32_t addr);
 static void xFinishProgrammingAndReset(void);
@@ -156,6 +157,15 @@ static bool xProgramEachFramSection(uint32_t startAddr)
     uint32_t externalSpiAddr = startAddr + IMAGE_META_DATA_LEN;
     bool res = true;
 
+    //page buffer comes out of the scratch arena for the duration of the programming
+    pageReadBuffer = ARENA_acquire(ARENA_OWNER_SSM_PROGRAMMING, MT29F1_PAGE_SIZE);
+
+    if ( pageReadBuffer == NULL )
+    {
+        elogError("No scratch RAM to program the SSM");
+        return false;
+    }
+
     for (uint8_t i = 0; i< MAX_FRAM_SECTIONS; i++)
     {
         //first init the length and fram address for each section
@@ -210,9 +220,9 @@ static bool xProgramEachFramSection(uint32_t startAddr)
             //read sections out of external spi flash and send it over uart to the msp's BSL
             if ( len >=  MT29F1_PAGE_SIZE )
             {
-                FLASH_read(externalSpiAddr, (uint8_t*)&pageReadBuffer, MT29F1_PAGE_SIZE);
+                FLASH_read(externalSpiAddr, pageReadBuffer, MT29F1_PAGE_SIZE);
 
-                res = BSL_writeLargeChunkOfDataToMemory(framAddr, MT29F1_PAGE_SIZE, (uint8_t*)&pageReadBuffer);
+                res = BSL_writeLargeChunkOfDataToMemory(framAddr, MT29F1_PAGE_SIZE, pageReadBuffer);
 
                 if ( res == false )
                 {
@@ -224,8 +234,8 @@ static bool xProgramEachFramSection(uint32_t startAddr)
             }
             else
             {
-                FLASH_read(externalSpiAddr, (uint8_t*)&pageReadBuffer, len);
-                res = BSL_writeLargeChunkOfDataToMemory(framAddr, len, (uint8_t*)&pageReadBuffer);
+                FLASH_read(externalSpiAddr, pageReadBuffer, len);
+                res = BSL_writeLargeChunkOfDataToMemory(framAddr, len, pageReadBuffer);
 
                 if ( res == false )
                 {
@@ -246,6 +256,9 @@ static bool xProgramEachFramSection(uint32_t startAddr)
         }
     }
 
+    pageReadBuffer = NULL;
+    ARENA_release(ARENA_OWNER_SSM_PROGRAMMING);
+
     return res;
 }
 
@@ -53,6 +53,9 @@
 #include "memMapHandler.h"
 #include "memoryMap.h"
 #include "updateSsmFw.h"
+#include "scratchArena.h"
+#include "mqttOutbox.h"
+#include "tlsSessionCache.h"
 #include "externalWatchdog.h"
 #include "aws_dev_mode_key_provisioning.h"
 
@@ -109,7 +112,12 @@ typedef struct
 //Set the image register appropriately based on these contents during initialization
 static bootloaderCache_t *blState = (bootloaderCache_t *) 0x20000000;
 
-static uint8_t ucHeap1[ configTOTAL_HEAP_SIZE*2 ];   //60 *1024 * 2
+//the application task stacks are static now (see below), take them back out of the heap.
+//the heap gets what the scratch arena gave back that lwIP did not take (see scratchArena.h)
+#define STATIC_TASK_STACK_BYTES                 ( ( STARTUP_TASK_STACK_SIZE + EVENT_MANAGER_TASK_STACK_SIZE + SSM_SPI_TASK_STACK_SIZE + \
+                                                    AT_TASK_STACK_SIZE + WATCHDOG_TASK_STACK_SIZE + CLI_TASK_STACK_SIZE ) * sizeof( StackType_t ) )
+
+static uint8_t ucHeap1[ configTOTAL_HEAP_SIZE*2 - STATIC_TASK_STACK_BYTES + ARENA_RECLAIMED_HEAP_BYTES ];   //60 *1024 * 2
 static uint8_t ucHeap2[ 120 * 1024 ] __attribute__( ( section( ".freertos_heap2" ) ) ); //98
 static bool printStats = false;
 static uint32_t runTimeCounterMs = 0u;
@@ -121,6 +129,21 @@ TaskHandle_t xSSM_SPIHandle;
 TaskHandle_t xTmHandle;
 TaskHandle_t xEventHandle;
 
+//tasks that live for the life of the application are allocated statically, only
+//the tasks that come and go with the cloud connection use the FreeRTOS heap
+static StackType_t xStartupStack[ STARTUP_TASK_STACK_SIZE ];
+static StaticTask_t xStartupTcb;
+static StackType_t xEventStack[ EVENT_MANAGER_TASK_STACK_SIZE ];
+static StaticTask_t xEventTcb;
+static StackType_t xSSM_SPIStack[ SSM_SPI_TASK_STACK_SIZE ];
+static StaticTask_t xSSM_SPITcb;
+static StackType_t xAtStack[ AT_TASK_STACK_SIZE ];
+static StaticTask_t xAtTcb;
+static StackType_t xTmStack[ WATCHDOG_TASK_STACK_SIZE ];
+static StaticTask_t xTmTcb;
+static StackType_t xCLIStack[ CLI_TASK_STACK_SIZE ];
+static StaticTask_t xCLITcb;
+
 RNG_HandleTypeDef xHrng;
 
 HeapRegion_t xHeapRegions[] =
@@ -205,7 +228,7 @@ static void xInitAndStartRtos(void)
 {
     vPortDefineHeapRegions(xHeapRegions);
 
-    xTaskCreate(startupTask, "START", STARTUP_TASK_STACK_SIZE, NULL, STARTUP_TASK_PRIORITY, &xStartupHandle);
+    xStartupHandle = xTaskCreateStatic(startupTask, "START", STARTUP_TASK_STACK_SIZE, NULL, STARTUP_TASK_PRIORITY, xStartupStack, &xStartupTcb);
 
     /* start up the RTOS */
     vTaskStartScheduler();
@@ -300,7 +323,10 @@ void startupTask()
     I2C_Init();
 
     FLASH_init();
+    ARENA_init();
     MEM_init();
+    OUTBOX_init();
+    TLSC_init();
     EVT_initializeEventQueue();
     SSM_Init();
 
@@ -329,11 +355,11 @@ void startupTask()
     CONN_initCliCommands();
 
     /* Create tasks */
-    xTaskCreate(EVT_eventManagerTask, "STATE", EVENT_MANAGER_TASK_STACK_SIZE, NULL, EVENT_MANAGER_TASK_PRIORITY, &xEventHandle);
-    xTaskCreate(SSM_SPI_Task, "SSM", SSM_SPI_TASK_STACK_SIZE, NULL, SSM_SPI_TASK_PRIORITY, &xSSM_SPIHandle);
-    xTaskCreate(ATcommandModeParsing_Task, "AT", AT_TASK_STACK_SIZE, NULL, AT_TASK_PRIORITY, &xAtHandle );
-    xTaskCreate(TM_task, "WD", WATCHDOG_TASK_STACK_SIZE, NULL, WATCHDOG_TASK_PRIORITY, &xTmHandle);
-    xTaskCreate(CLI_commandLineHandler_task, "CLI", CLI_TASK_STACK_SIZE, NULL, CLI_TASK_PRIORITY, &xCLIHandle);
+    xEventHandle = xTaskCreateStatic(EVT_eventManagerTask, "STATE", EVENT_MANAGER_TASK_STACK_SIZE, NULL, EVENT_MANAGER_TASK_PRIORITY, xEventStack, &xEventTcb);
+    xSSM_SPIHandle = xTaskCreateStatic(SSM_SPI_Task, "SSM", SSM_SPI_TASK_STACK_SIZE, NULL, SSM_SPI_TASK_PRIORITY, xSSM_SPIStack, &xSSM_SPITcb);
+    xAtHandle = xTaskCreateStatic(ATcommandModeParsing_Task, "AT", AT_TASK_STACK_SIZE, NULL, AT_TASK_PRIORITY, xAtStack, &xAtTcb);
+    xTmHandle = xTaskCreateStatic(TM_task, "WD", WATCHDOG_TASK_STACK_SIZE, NULL, WATCHDOG_TASK_PRIORITY, xTmStack, &xTmTcb);
+    xCLIHandle = xTaskCreateStatic(CLI_commandLineHandler_task, "CLI", CLI_TASK_STACK_SIZE, NULL, CLI_TASK_PRIORITY, xCLIStack, &xCLITcb);
 
     /* use this task to periodically log task stats to the terminal */
     while (1)
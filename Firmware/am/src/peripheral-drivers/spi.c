@@ -37,10 +37,51 @@
 
 #define MAX_SSM_WAIT_TIME_MS       600
 
+//NAND transfers at least this long (page data) go through DMA, the command and status bytes are
+//quicker to poll out than to set up a DMA transfer for
+#define NAND_DMA_MIN_LEN           32
+#define NAND_DMA_TIMEOUT_MS        100
+#define NAND_POLL_TIMEOUT_MS       100
+
+//SSM frames always go through DMA, the calling task sleeps instead of spinning at the slow SSM clock.
+//The timeout is the time the frame takes at the current clock plus this margin.
+#define SSM_DMA_MARGIN_MS          20
+
+//SPI2 clock steps for the SSM link, slowest first. The SSM is an SPI slave that loads and frames every
+//byte in its ISR, which CapTIvate and the timer ISRs can hold off, so the fastest step still gives it
+//85 us per byte.
+static const uint32_t xSsmPrescalers[SPI_SSM_NUM_SPEEDS] =
+{
+    SPI_BAUDRATEPRESCALER_256,
+    SPI_BAUDRATEPRESCALER_128,
+    SPI_BAUDRATEPRESCALER_64,
+    SPI_BAUDRATEPRESCALER_32,
+};
+static const uint16_t xSsmDividers[SPI_SSM_NUM_SPEEDS] = { 256, 128, 64, 32 };
+static uint8_t xSsmSpeed = 0;
+
 SPI_HandleTypeDef hspi1;
 SPI_HandleTypeDef hspi2;
+DMA_HandleTypeDef hdma_spi1_rx;
+DMA_HandleTypeDef hdma_spi1_tx;
+DMA_HandleTypeDef hdma_spi2_rx;
+DMA_HandleTypeDef hdma_spi2_tx;
 
 SemaphoreHandle_t xSPITransferMutex;
+static StaticSemaphore_t xSPITransferMutexBuffer;
+
+//given from the DMA complete/error callbacks of one bus, the task waiting on a transfer on that bus sleeps
+//on it. Each bus has its own, so a completion that comes late on one bus (after its transfer was aborted)
+//can never be taken for the end of a transfer on the other, whatever the locking around the buses.
+typedef struct
+{
+    SemaphoreHandle_t done;
+    StaticSemaphore_t doneBuffer;
+    volatile bool failed;
+}spiDmaWait_t;
+
+static spiDmaWait_t xNandDma;
+static spiDmaWait_t xSsmDma;
 
 static void xEnableNandCommunication(void);
 static void xDisableNandCommunication(void);
@@ -53,6 +94,13 @@ static void xInitSsmSpi(void);
 
 static bool WaitForSSMReady(uint16_t max_wait_ms);
 
+static HAL_StatusTypeDef xNandTransmit(uint8_t *data, uint16_t len);
+static HAL_StatusTypeDef xNandReceive(uint8_t *data, uint16_t len);
+static uint32_t xSsmDmaTimeoutMs(uint16_t len);
+static HAL_StatusTypeDef xWaitForDma(SPI_HandleTypeDef *hspi, HAL_StatusTypeDef started, uint32_t timeoutMs);
+static spiDmaWait_t * xDmaWaitFor(SPI_HandleTypeDef *hspi);
+static void xDmaDone(SPI_HandleTypeDef *hspi, bool failed);
+
 /* init spi peripherals */
  void SPI_Init(void)
 {
@@ -60,13 +108,35 @@ static bool WaitForSSMReady(uint16_t max_wait_ms);
     xInitSsmSpi();
 
     /* create a mutex */
-    xSPITransferMutex = xSemaphoreCreateMutex();
+    xSPITransferMutex = xSemaphoreCreateMutexStatic(&xSPITransferMutexBuffer);
+
+    xNandDma.done = xSemaphoreCreateBinaryStatic(&xNandDma.doneBuffer);
+    xSsmDma.done = xSemaphoreCreateBinaryStatic(&xSsmDma.doneBuffer);
 }
 
 void SPI_DeInit(void)
 {
     HAL_SPI_DeInit(&hspi2);
     HAL_SPI_DeInit(&hspi1);
+    HAL_DMA_DeInit(&hdma_spi1_rx);
+    HAL_DMA_DeInit(&hdma_spi1_tx);
+    HAL_DMA_DeInit(&hdma_spi2_rx);
+    HAL_DMA_DeInit(&hdma_spi2_tx);
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    xDmaDone(hspi, false);
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    xDmaDone(hspi, false);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    xDmaDone(hspi, true);
 }
 
 /*******************************************************************************
@@ -98,14 +168,14 @@ buffer is provided.
     {
 
         /* Send the spi command/data */
-        stat = HAL_SPI_Transmit(&hspi1, dataSend, txLen, 0xffffff );
+        stat = xNandTransmit(dataSend, txLen);
 
         if (stat == HAL_OK)
         {
             if (rxLen > 0)
             {
                 // now read the actual data
-                stat = HAL_SPI_Receive(&hspi1, dataRecv, rxLen, 0xffffff);
+                stat = xNandReceive(dataRecv, rxLen);
             }
         }
 
@@ -129,6 +199,88 @@ buffer is provided.
 }
 
 
+/*******************************************************************************
+Page data goes out by DMA while the calling task sleeps, short command bytes are
+sent polled.
+*******************************************************************************/
+static HAL_StatusTypeDef xNandTransmit(uint8_t *data, uint16_t len)
+{
+    if (len < NAND_DMA_MIN_LEN)
+    {
+        return HAL_SPI_Transmit(&hspi1, data, len, NAND_POLL_TIMEOUT_MS);
+    }
+
+    return xWaitForDma(&hspi1, HAL_SPI_Transmit_DMA(&hspi1, data, len), NAND_DMA_TIMEOUT_MS);
+}
+
+static HAL_StatusTypeDef xNandReceive(uint8_t *data, uint16_t len)
+{
+    if (len < NAND_DMA_MIN_LEN)
+    {
+        return HAL_SPI_Receive(&hspi1, data, len, NAND_POLL_TIMEOUT_MS);
+    }
+
+    return xWaitForDma(&hspi1, HAL_SPI_Receive_DMA(&hspi1, data, len), NAND_DMA_TIMEOUT_MS);
+}
+
+/*******************************************************************************
+Sleep until the DMA transfer that was just started completes.
+*******************************************************************************/
+static HAL_StatusTypeDef xWaitForDma(SPI_HandleTypeDef *hspi, HAL_StatusTypeDef started, uint32_t timeoutMs)
+{
+    spiDmaWait_t *p_wait = xDmaWaitFor(hspi);
+
+    if (started != HAL_OK)
+    {
+        return started;
+    }
+
+    if (xSemaphoreTake(p_wait->done, pdMS_TO_TICKS(timeoutMs)) != pdTRUE)
+    {
+        HAL_SPI_Abort(hspi);
+
+        //a completion that raced the abort must not satisfy the next transfer
+        xSemaphoreTake(p_wait->done, 0);
+
+        elogError("%s DMA timeout", (hspi->Instance == SPI1) ? "NAND" : "SSM");
+        return HAL_TIMEOUT;
+    }
+
+    return (p_wait->failed == true) ? HAL_ERROR : HAL_OK;
+}
+
+static spiDmaWait_t * xDmaWaitFor(SPI_HandleTypeDef *hspi)
+{
+    if (hspi->Instance == SPI1)
+    {
+        return &xNandDma;
+    }
+
+    if (hspi->Instance == SPI2)
+    {
+        return &xSsmDma;
+    }
+
+    return NULL;
+}
+
+/* called from the DMA/SPI interrupt */
+static void xDmaDone(SPI_HandleTypeDef *hspi, bool failed)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    spiDmaWait_t *p_wait = xDmaWaitFor(hspi);
+
+    if (p_wait == NULL)
+    {
+        return;
+    }
+
+    p_wait->failed = failed;
+
+    xSemaphoreGiveFromISR(p_wait->done, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
 /*******************************************************************************
 Wait up to the specified mS for the SSM to assert WAKE_AP.  Return true
 if the SSM is ready.
@@ -183,7 +335,7 @@ spiStatus_t SPI_ssmTransfer(const spiData_t* pDataToSend, spiData_t* pDataReceiv
          xEnableSsmCommunication();
 
          /* Send the spi command/data */
-         stat = HAL_SPI_Transmit(&hspi2, dataSend, txLen, 0xffff );
+         stat = xWaitForDma(&hspi2, HAL_SPI_Transmit_DMA(&hspi2, dataSend, txLen), xSsmDmaTimeoutMs(txLen));
 
          if (stat == HAL_OK)
          {
@@ -197,7 +349,7 @@ spiStatus_t SPI_ssmTransfer(const spiData_t* pDataToSend, spiData_t* pDataReceiv
                if (WaitForSSMReady(MAX_SSM_WAIT_TIME_MS) == true)
                 {
                     // now read the actual data
-                    stat = HAL_SPI_Receive(&hspi2, dataRecv, rxLen, 0xffff);
+                    stat = xWaitForDma(&hspi2, HAL_SPI_Receive_DMA(&hspi2, dataRecv, rxLen), xSsmDmaTimeoutMs(rxLen));
 
                     //check timeout on this receive to verify we received actual data.
                     if (stat != HAL_OK)
@@ -243,6 +395,54 @@ spiStatus_t SPI_ssmTransfer(const spiData_t* pDataToSend, spiData_t* pDataReceiv
      return spiSuccess;
  }
 
+/*******************************************************************************
+Set the SSM SPI clock, 0 (slowest) to SPI_SSM_NUM_SPEEDS - 1. Takes effect on
+the next transfer.
+*******************************************************************************/
+bool SPI_ssmSetSpeed(uint8_t speed)
+{
+    bool set = false;
+
+    if (speed >= SPI_SSM_NUM_SPEEDS)
+    {
+        return false;
+    }
+
+    if( xSemaphoreTake(xSPITransferMutex, ( TickType_t ) 10000) == pdTRUE )
+    {
+        //the baud rate can only be changed while the peripheral is off, the HAL turns it back on
+        __HAL_SPI_DISABLE(&hspi2);
+        MODIFY_REG(hspi2.Instance->CR1, SPI_CR1_BR, xSsmPrescalers[speed]);
+        hspi2.Init.BaudRatePrescaler = xSsmPrescalers[speed];
+        xSsmSpeed = speed;
+        set = true;
+
+        xSemaphoreGive(xSPITransferMutex);
+    }
+    else
+    {
+        elogError("Failed to take mutex");
+    }
+
+    return set;
+}
+
+uint8_t SPI_ssmGetSpeed(void)
+{
+    return xSsmSpeed;
+}
+
+/* SSM SPI clock in Hz */
+uint32_t SPI_ssmGetBitRate(void)
+{
+    return (HAL_RCC_GetPCLK1Freq() / xSsmDividers[xSsmSpeed]);
+}
+
+static uint32_t xSsmDmaTimeoutMs(uint16_t len)
+{
+    return ((((uint32_t)len * 8u * 1000u) / SPI_ssmGetBitRate()) + SSM_DMA_MARGIN_MS);
+}
+
  static void xInitNandSpi(void)
  {
      GPIO_InitTypeDef GPIO_InitStruct = {0};
@@ -266,6 +466,52 @@ spiStatus_t SPI_ssmTransfer(const spiData_t* pDataToSend, spiData_t* pDataReceiv
         // log error
     }
 
+    /* DMA controller clock enable */
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    /* Use DMA for page data in both directions. A receive in full duplex master mode also runs the tx channel */
+    hdma_spi1_rx.Instance = DMA1_Channel2;
+    hdma_spi1_rx.Init.Request = DMA_REQUEST_SPI1_RX;
+    hdma_spi1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_spi1_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi1_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi1_rx.Init.Mode = DMA_NORMAL;
+    hdma_spi1_rx.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_spi1_rx) != HAL_OK)
+    {
+        elogError("Failed to init NAND rx DMA");
+    }
+
+    hdma_spi1_tx.Instance = DMA1_Channel3;
+    hdma_spi1_tx.Init.Request = DMA_REQUEST_SPI1_TX;
+    hdma_spi1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_spi1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi1_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi1_tx.Init.Mode = DMA_NORMAL;
+    hdma_spi1_tx.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_spi1_tx) != HAL_OK)
+    {
+        elogError("Failed to init NAND tx DMA");
+    }
+
+    //link DMA channels 2 and 3 to SPI 1
+    __HAL_LINKDMA(&hspi1, hdmarx, hdma_spi1_rx);
+    __HAL_LINKDMA(&hspi1, hdmatx, hdma_spi1_tx);
+
+    HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+
+    /* SPI errors during a DMA transfer */
+    HAL_NVIC_SetPriority(SPI1_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(SPI1_IRQn);
+
     /* init chip select */
     HAL_GPIO_WritePin(MT28F1_CS_PORT, MT28F1_CS_PIN, GPIO_PIN_SET);
 
@@ -289,7 +535,7 @@ static void xInitSsmSpi(void)
     hspi2.Init.CLKPolarity = SPI_POLARITY_LOW;
     hspi2.Init.CLKPhase = SPI_PHASE_1EDGE;
     hspi2.Init.NSS = SPI_NSS_SOFT;
-    hspi2.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_256;
+    hspi2.Init.BaudRatePrescaler = xSsmPrescalers[xSsmSpeed];
     hspi2.Init.FirstBit = SPI_FIRSTBIT_MSB;
     hspi2.Init.TIMode = SPI_TIMODE_DISABLE;
     hspi2.Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
@@ -300,6 +546,52 @@ static void xInitSsmSpi(void)
         // log error
     }
 
+    /* DMA controller clock enable */
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    /* Whole frames to and from the SSM go through DMA */
+    hdma_spi2_rx.Instance = DMA1_Channel4;
+    hdma_spi2_rx.Init.Request = DMA_REQUEST_SPI2_RX;
+    hdma_spi2_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_spi2_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi2_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi2_rx.Init.Mode = DMA_NORMAL;
+    hdma_spi2_rx.Init.Priority = DMA_PRIORITY_MEDIUM;
+    if (HAL_DMA_Init(&hdma_spi2_rx) != HAL_OK)
+    {
+        elogError("Failed to init SSM rx DMA");
+    }
+
+    hdma_spi2_tx.Instance = DMA1_Channel5;
+    hdma_spi2_tx.Init.Request = DMA_REQUEST_SPI2_TX;
+    hdma_spi2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_spi2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi2_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi2_tx.Init.Mode = DMA_NORMAL;
+    hdma_spi2_tx.Init.Priority = DMA_PRIORITY_MEDIUM;
+    if (HAL_DMA_Init(&hdma_spi2_tx) != HAL_OK)
+    {
+        elogError("Failed to init SSM tx DMA");
+    }
+
+    //link DMA channels 4 and 5 to SPI 2
+    __HAL_LINKDMA(&hspi2, hdmarx, hdma_spi2_rx);
+    __HAL_LINKDMA(&hspi2, hdmatx, hdma_spi2_tx);
+
+    HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+
+    /* SPI errors during a DMA transfer */
+    HAL_NVIC_SetPriority(SPI2_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(SPI2_IRQn);
+
     /*Configure GPIO pin : PB12  as an input pin.
      * Not using CS as there is only 1 SPI slave */
     GPIO_InitStruct.Pin = SSM_RDY_PIN;
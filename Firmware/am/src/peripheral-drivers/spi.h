@@ -35,6 +35,9 @@
 #define GPIO_LOW                0
 #define GPIO_HIGH               1
 
+/* SSM SPI clock steps, 0 is the power up (slowest) speed */
+#define SPI_SSM_NUM_SPEEDS      4
+
 typedef enum
 {
     spiError,
@@ -65,6 +68,12 @@ extern spiStatus_t SPI_nandTransfer(const spiData_t* pDataToSend,
 extern spiStatus_t SPI_ssmTransfer(const spiData_t* pDataToSend, spiData_t* pDataReceived,
         spiConfigOptions_t optAfter);
 
+extern bool SPI_ssmSetSpeed(uint8_t speed);
+
+extern uint8_t SPI_ssmGetSpeed(void);
+
+extern uint32_t SPI_ssmGetBitRate(void);
+
 extern void SPI_Init(void);
 
 extern void SPI_DeInit(void);
@@ -0,0 +1,285 @@
+/**************************************************************************************************
+* \file     spscRing.h
+* \brief    Lock free single producer / single consumer byte ring for passing data from an ISR to a
+*           task (or from one task to another) without a mutex or a critical section.
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#ifndef PERIPHERAL_DRIVERS_SPSCRING_H_
+#define PERIPHERAL_DRIVERS_SPSCRING_H_
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "string.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// The head is only written by the producer and the tail only by the consumer. Both run freely and are
+// masked on use, so a full ring needs no spare slot and (head - tail) is always the fill level. Each side
+// publishes its index with a release store after it is done with the data, and loads the other side's
+// index with an acquire load, so the bytes are in place before the index that covers them is seen.
+//
+// Exactly one context may call the write functions and exactly one the read functions. The capacity
+// has to be a power of two.
+//
+// A consumer task can ask to be notified when the ring goes from empty to not empty, then it sleeps in
+// RING_waitForData() instead of polling. The notification uses the task's direct to task notification
+// value, so that task must not use it for anything else.
+
+typedef struct
+{
+    uint8_t *pBuf;
+    uint32_t mask;
+    volatile uint32_t head;             //written by the producer
+    volatile uint32_t tail;             //written by the consumer
+    TaskHandle_t consumer;              //NULL: no notification
+    volatile uint32_t overflows;        //bytes the producer dropped because the ring was full
+}spscRing_t;
+
+//declare the storage for a ring, capacity must be a power of two
+#define RING_DEFINE_STORAGE(name, capacity)                                                         \
+    _Static_assert((((capacity) & ((capacity) - 1u)) == 0u) && ((capacity) != 0u), "ring capacity"); \
+    static uint8_t name[(capacity)]
+
+static inline uint32_t xRingLoadAcquire(volatile const uint32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void xRingStoreRelease(volatile uint32_t *p, uint32_t value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+// Set up a ring on capacity bytes of storage. Returns false if the capacity is not a power of two.
+static inline bool RING_init(spscRing_t *pRing, uint8_t *pBuf, uint32_t capacity, TaskHandle_t consumer)
+{
+    if ((pRing == NULL) || (pBuf == NULL) || (capacity == 0u) || ((capacity & (capacity - 1u)) != 0u))
+    {
+        return false;
+    }
+
+    pRing->pBuf = pBuf;
+    pRing->mask = capacity - 1u;
+    pRing->head = 0u;
+    pRing->tail = 0u;
+    pRing->consumer = consumer;
+    pRing->overflows = 0u;
+
+    return true;
+}
+
+// Drop everything in the ring. Only safe while the producer is stopped (e.g. its UART is not receiving).
+static inline void RING_reset(spscRing_t *pRing)
+{
+    xRingStoreRelease(&pRing->tail, xRingLoadAcquire(&pRing->head));
+}
+
+static inline uint32_t RING_capacity(const spscRing_t *pRing)
+{
+    return (pRing->mask + 1u);
+}
+
+// Bytes waiting. Exact when called by the consumer, a lower bound for anyone else.
+static inline uint32_t RING_count(const spscRing_t *pRing)
+{
+    return (xRingLoadAcquire(&pRing->head) - xRingLoadAcquire(&pRing->tail));
+}
+
+// Free space. Exact when called by the producer, a lower bound for anyone else.
+static inline uint32_t RING_space(const spscRing_t *pRing)
+{
+    return (RING_capacity(pRing) - (pRing->head - xRingLoadAcquire(&pRing->tail)));
+}
+
+//------------------------------------------------------------------------------
+// Producer side
+//------------------------------------------------------------------------------
+
+// Contiguous free space at the head. It may be less than RING_space() where the buffer wraps, a second
+// call after RING_commitWrite() returns the rest.
+static inline uint8_t *RING_writeSpan(spscRing_t *pRing, uint32_t *pLen)
+{
+    uint32_t head = pRing->head;
+    uint32_t space = RING_capacity(pRing) - (head - xRingLoadAcquire(&pRing->tail));
+    uint32_t offset = head & pRing->mask;
+    uint32_t toEnd = RING_capacity(pRing) - offset;
+
+    *pLen = (space < toEnd) ? space : toEnd;
+
+    return &pRing->pBuf[offset];
+}
+
+// Publish len bytes that were written into the span. Returns true if the ring was empty before them.
+static inline bool RING_commitWrite(spscRing_t *pRing, uint32_t len)
+{
+    uint32_t head = pRing->head;
+
+    xRingStoreRelease(&pRing->head, head + len);
+
+    //the new head has to be visible before the tail is looked at, or a consumer that just found the ring
+    //empty and is about to sleep would not be woken
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    return ((len != 0u) && (xRingLoadAcquire(&pRing->tail) == head));
+}
+
+// Copy in as much of the data as fits, returns the number of bytes written. Not for ISRs when a consumer
+// is registered, use RING_writeFromIsr().
+static inline uint32_t RING_write(spscRing_t *pRing, const uint8_t *pData, uint32_t len)
+{
+    uint32_t written = 0u;
+    uint32_t spanLen;
+    uint8_t *pSpan;
+
+    //at most two spans, before and after the wrap
+    while (written < len)
+    {
+        pSpan = RING_writeSpan(pRing, &spanLen);
+        if (spanLen == 0u)
+        {
+            break;
+        }
+        if (spanLen > (len - written))
+        {
+            spanLen = len - written;
+        }
+        memcpy(pSpan, &pData[written], spanLen);
+        written += spanLen;
+
+        if (RING_commitWrite(pRing, spanLen) && (pRing->consumer != NULL))
+        {
+            xTaskNotifyGive(pRing->consumer);
+        }
+    }
+
+    pRing->overflows += (len - written);
+
+    return written;
+}
+
+// Same as RING_write() for use in an ISR. Wakes the consumer on the empty to not empty transition.
+static inline uint32_t RING_writeFromIsr(spscRing_t *pRing, const uint8_t *pData, uint32_t len, BaseType_t *pHigherPriorityTaskWoken)
+{
+    uint32_t written = 0u;
+    uint32_t spanLen;
+    uint8_t *pSpan;
+
+    while (written < len)
+    {
+        pSpan = RING_writeSpan(pRing, &spanLen);
+        if (spanLen == 0u)
+        {
+            break;
+        }
+        if (spanLen > (len - written))
+        {
+            spanLen = len - written;
+        }
+        memcpy(pSpan, &pData[written], spanLen);
+        written += spanLen;
+
+        if (RING_commitWrite(pRing, spanLen) && (pRing->consumer != NULL))
+        {
+            vTaskNotifyGiveFromISR(pRing->consumer, pHigherPriorityTaskWoken);
+        }
+    }
+
+    pRing->overflows += (len - written);
+
+    return written;
+}
+
+// One byte from a receive interrupt, the common case
+static inline bool RING_putFromIsr(spscRing_t *pRing, uint8_t byte, BaseType_t *pHigherPriorityTaskWoken)
+{
+    return (RING_writeFromIsr(pRing, &byte, 1u, pHigherPriorityTaskWoken) == 1u);
+}
+
+//------------------------------------------------------------------------------
+// Consumer side
+//------------------------------------------------------------------------------
+
+// Contiguous bytes waiting at the tail, for parsing in place. Like RING_writeSpan() it stops at the end
+// of the buffer. The bytes stay valid until they are released with RING_commitRead().
+static inline const uint8_t *RING_readSpan(spscRing_t *pRing, uint32_t *pLen)
+{
+    uint32_t tail = pRing->tail;
+    uint32_t count = xRingLoadAcquire(&pRing->head) - tail;
+    uint32_t offset = tail & pRing->mask;
+    uint32_t toEnd = RING_capacity(pRing) - offset;
+
+    *pLen = (count < toEnd) ? count : toEnd;
+
+    return &pRing->pBuf[offset];
+}
+
+// Hand len bytes at the tail back to the producer
+static inline void RING_commitRead(spscRing_t *pRing, uint32_t len)
+{
+    xRingStoreRelease(&pRing->tail, pRing->tail + len);
+}
+
+// Copy out up to len bytes, returns the number read
+static inline uint32_t RING_read(spscRing_t *pRing, uint8_t *pData, uint32_t len)
+{
+    uint32_t readLen = 0u;
+    uint32_t spanLen;
+    const uint8_t *pSpan;
+
+    while (readLen < len)
+    {
+        pSpan = RING_readSpan(pRing, &spanLen);
+        if (spanLen == 0u)
+        {
+            break;
+        }
+        if (spanLen > (len - readLen))
+        {
+            spanLen = len - readLen;
+        }
+        memcpy(&pData[readLen], pSpan, spanLen);
+        readLen += spanLen;
+        RING_commitRead(pRing, spanLen);
+    }
+
+    return readLen;
+}
+
+// Block the consumer task until there is data or the timeout runs out. Returns true if there is data.
+static inline bool RING_waitForData(spscRing_t *pRing, TickType_t ticksToWait)
+{
+    //pairs with the fence in RING_commitWrite(), the tail this task last stored has to be visible before
+    //the head is looked at
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    //a notification left over from bytes that were already read just makes this loop once more
+    while (RING_count(pRing) == 0u)
+    {
+        if (ulTaskNotifyTake(pdTRUE, ticksToWait) == 0u)
+        {
+            break;
+        }
+    }
+
+    return (RING_count(pRing) != 0u);
+}
+
+#endif /* PERIPHERAL_DRIVERS_SPSCRING_H_ */
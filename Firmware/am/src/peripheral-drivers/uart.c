@@ -49,6 +49,8 @@ DMA_HandleTypeDef hdma_uart5_tx;
 
 SemaphoreHandle_t xUartTxMutex;
 SemaphoreHandle_t xUartRxMutex;
+static StaticSemaphore_t xUartTxMutexBuffer;
+static StaticSemaphore_t xUartRxMutexBuffer;
 
 static void xInitLpuart1(void);
 static void xInitUart1(void);
@@ -107,8 +109,8 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 void UART_initPeripherals(void)
 {
     /* create mutex */
-    xUartTxMutex = xSemaphoreCreateMutex();
-    xUartRxMutex = xSemaphoreCreateMutex();
+    xUartTxMutex = xSemaphoreCreateMutexStatic(&xUartTxMutexBuffer);
+    xUartRxMutex = xSemaphoreCreateMutexStatic(&xUartRxMutexBuffer);
 
     xInitLpuart1(); //log
     xInitUart4(); //ssm
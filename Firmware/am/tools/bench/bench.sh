@@ -0,0 +1,40 @@
+#!/bin/bash
+
+#
+# Build and run the cloud message benchmark (pb_bench.c) with gcc
+#
+# messages.pb.c and nanopb are built from protos/ with the firmware's nanopb options (none, the defaults).
+# Run from this folder, the binary goes to out/. The arguments go to pb_bench, exits 1 on a regression.
+#
+# Usage: ./bench.sh [--update] [--tolerance PCT]     e.g. ./bench.sh --update after a schema change
+#        ./bench.sh --record                         rewrite fixtures/ from the messages in pb_bench.c
+#
+
+CC="gcc"
+PROTOS="../../protos"
+OUTPUT_NAME=out/pb_bench
+
+GENERIC_OPTIONS=(   -std=gnu99 \
+                    -O2 \
+                    -g \
+                    -Wall)
+
+INCLUDE_PATHS=( -I$PROTOS)
+
+# The *.c at the end of each file is omitted for flexibility in the BASH script
+FILES=( "pb_bench" \
+        "$PROTOS/messages.pb" \
+        "$PROTOS/pb_common" \
+        "$PROTOS/pb_decode" \
+        "$PROTOS/pb_encode")
+
+mkdir -p out
+SOURCES=()
+for FILE in "${FILES[@]}"; do
+    SOURCES+=($FILE.c)
+done
+
+BUILD_COMMAND="$CC ${GENERIC_OPTIONS[@]} ${INCLUDE_PATHS[@]} -o $OUTPUT_NAME ${SOURCES[@]}"
+echo $BUILD_COMMAND
+$BUILD_COMMAND || exit 1
+$OUTPUT_NAME "$@"
@@ -0,0 +1,588 @@
+/**************************************************************************************************
+* \file     pb_bench.c
+* \brief    Host benchmark of the cloud message encode and decode, against a recorded baseline
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include "pb_encode.h"
+#include "pb_decode.h"
+#include "messages.pb.h"
+
+// Each cloud message is benchmarked twice: a typical one, as a pump sends on a normal day, and a worst case
+// one with every optional field present and every number at its largest encoding.
+//
+// The encoded messages are the checked in fixtures/<name>.bin. Each fixture is decoded, checked against
+// the message it was recorded from and encoded again, the bytes have to come back the same. Then the
+// encode and decode are timed (best of BENCH_ROUNDS runs of BENCH_ITERATIONS) and run once more on a
+// painted stack to find the deepest byte they touched.
+//
+// The bytes on the wire, the generated *_size and the stack are compared with baseline.txt. Any growth of
+// the wire bytes or the generated maximum fails, so does stack more than the tolerance over the baseline.
+// The stack is the host's (x86-64, gcc -O2), not the Cortex-M4's, it moves with the code the same way.
+// The times are printed for information only, they are neither in the baseline nor gated: they depend
+// on the machine and its load, not only on the code.
+//
+// Usage: pb_bench [--update] [--tolerance PCT]
+//        pb_bench --record          write fixtures/ from the messages below, after a schema change
+//        --update writes the results to baseline.txt, check it in with the change that moved them.
+
+#define FIXTURE_DIR                 "fixtures/"
+#define BASELINE_FILE               "baseline.txt"
+#define DEFAULT_TOLERANCE_PCT       10u
+#define BENCH_ITERATIONS            20000u
+#define BENCH_ROUNDS                5u
+#define PAINT_STACK_SIZE            65536u
+#define PAINT_BYTE                  0xA5u
+#define WIRE_BUFFER_SIZE            2048u
+#define HOURS_PER_DAY               24u
+#define MAX_MESSAGES                8u
+#define NAME_LENGTH                 32u
+
+typedef struct
+{
+    const char * p_name;
+    const pb_msgdesc_t * p_fields;
+    size_t structSize;
+    size_t maxSize;                 // generated <message>_size
+    void (*p_build)(void * p_msg, bool worst);
+    bool worst;
+}benchMessage_t;
+
+typedef struct
+{
+    char name[NAME_LENGTH];
+    uint32_t wire;
+    uint32_t max;
+    uint32_t encodeStack;
+    uint32_t decodeStack;
+    uint32_t encodeNs;
+    uint32_t decodeNs;
+}benchResult_t;
+
+static void xBuildHeader(CommonHeader * p_header, bool worst);
+static void xBuildStatus(void * p_msg, bool worst);
+static void xBuildGps(void * p_msg, bool worst);
+static void xBuildSensorData(void * p_msg, bool worst);
+
+static const benchMessage_t xMessages[] =
+{
+    { "status_typical",         StatusMessage_fields,       sizeof(StatusMessage),      StatusMessage_size,     xBuildStatus,       false },
+    { "status_worst",           StatusMessage_fields,       sizeof(StatusMessage),      StatusMessage_size,     xBuildStatus,       true },
+    { "gps_typical",            GpsMessage_fields,          sizeof(GpsMessage),         GpsMessage_size,        xBuildGps,          false },
+    { "gps_worst",              GpsMessage_fields,          sizeof(GpsMessage),         GpsMessage_size,        xBuildGps,          true },
+    { "sensor_data_typical",    SensorDataMessage_fields,   sizeof(SensorDataMessage),  SensorDataMessage_size, xBuildSensorData,   false },
+    { "sensor_data_worst",      SensorDataMessage_fields,   sizeof(SensorDataMessage),  SensorDataMessage_size, xBuildSensorData,   true },
+};
+
+#define NUM_MESSAGES                (sizeof(xMessages) / sizeof(xMessages[0]))
+
+// What the encode and decode jobs work on, they take no arguments so they can run on the painted stack
+static const benchMessage_t * xJobMessage;
+static const void * xJobSource;
+static void * xJobDecoded;
+static uint8_t xJobWire[WIRE_BUFFER_SIZE];
+static size_t xJobWireLen;
+static bool xJobOk;
+
+static uint8_t xPaintStack[PAINT_STACK_SIZE];
+static ucontext_t xMainContext;
+static ucontext_t xJobContext;
+static void (*xPaintJob)(void);
+
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static int xRecord(void);
+static bool xReadFixture(const char * p_name, uint8_t * p_wire, size_t * p_len);
+static void xEncodeJob(void);
+static void xDecodeJob(void);
+static void xPaintTrampoline(void);
+static uint32_t xStackUse(void (*p_job)(void));
+static uint32_t xTimeNs(void (*p_job)(void));
+static void xBenchMessage(const benchMessage_t * p_message, benchResult_t * p_result);
+static uint32_t xReadBaseline(benchResult_t * p_baseline, uint32_t maxEntries);
+static const benchResult_t * xFindBaseline(const benchResult_t * p_baseline, uint32_t count, const char * p_name);
+static void xCompare(const benchResult_t * p_result, const benchResult_t * p_baseline, uint32_t tolerancePct);
+static bool xWriteBaseline(const benchResult_t * p_results, uint32_t count);
+
+int main(int argc, char **argv)
+{
+    benchResult_t results[NUM_MESSAGES];
+    benchResult_t baseline[MAX_MESSAGES];
+    uint32_t baselineCount = 0u;
+    uint32_t tolerancePct = DEFAULT_TOLERANCE_PCT;
+    bool update = false;
+    uint32_t i = 0u;
+
+    for ( int arg = 1; arg < argc; arg++ )
+    {
+        if ( strcmp(argv[arg], "--record") == 0 )
+        {
+            return xRecord();
+        }
+        else if ( strcmp(argv[arg], "--update") == 0 )
+        {
+            update = true;
+        }
+        else if ( (strcmp(argv[arg], "--tolerance") == 0) && (arg + 1 < argc) )
+        {
+            tolerancePct = (uint32_t)strtoul(argv[++arg], NULL, 10);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: pb_bench [--update] [--tolerance PCT] | --record\n");
+            return 2;
+        }
+    }
+
+    printf("  fixtures:\n");
+    for ( i = 0u; i < NUM_MESSAGES; i++ )
+    {
+        xBenchMessage(&xMessages[i], &results[i]);
+    }
+
+    printf("\n  %-20s %6s %6s %8s %8s %9s %9s\n", "message", "wire", "max", "enc ns", "dec ns", "enc stack", "dec stack");
+    for ( i = 0u; i < NUM_MESSAGES; i++ )
+    {
+        printf("  %-20s %6u %6u %8u %8u %9u %9u\n", results[i].name, results[i].wire, results[i].max,
+               results[i].encodeNs, results[i].decodeNs, results[i].encodeStack, results[i].decodeStack);
+    }
+
+    if ( update == true )
+    {
+        xCheck(xWriteBaseline(results, NUM_MESSAGES), "wrote " BASELINE_FILE);
+    }
+    else
+    {
+        baselineCount = xReadBaseline(baseline, MAX_MESSAGES);
+        printf("\n  against " BASELINE_FILE ", %u%% tolerance on stack:\n", tolerancePct);
+        xCheck(baselineCount > 0u, BASELINE_FILE " read");
+
+        for ( i = 0u; i < NUM_MESSAGES; i++ )
+        {
+            xCompare(&results[i], xFindBaseline(baseline, baselineCount, results[i].name), tolerancePct);
+        }
+    }
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// Fixed values so a --record after a schema change only moves the fields that changed
+static void xBuildHeader(CommonHeader * p_header, bool worst)
+{
+    p_header->productId = 4u;
+    p_header->timestamp = 1790000000u;
+    p_header->msgNumber = worst ? UINT32_MAX : 17u;
+    p_header->fwMajor = 1u;
+    p_header->fwMinor = 2u;
+    p_header->fwBuild = worst ? UINT32_MAX : 345u;
+    p_header->imei = worst ? UINT64_MAX : 352656100000000ull;
+    p_header->has_voltage = true;
+    p_header->voltage = worst ? UINT32_MAX : 3600u;
+    p_header->has_powerRemaining = true;
+    p_header->powerRemaining = 87u;
+    p_header->has_state = true;
+    p_header->state = worst ? eState_FAULT : eState_ACTIVATED;
+    p_header->has_activatedDate = true;
+    p_header->activatedDate = 1780000000u;
+    p_header->has_magnetDetected = true;
+    p_header->magnetDetected = true;
+    p_header->has_errorBits = true;
+    p_header->errorBits = worst ? UINT32_MAX : 0u;
+    p_header->has_rssi = true;
+    p_header->rssi = worst ? UINT32_MAX : 18u;
+    p_header->has_connectTime = true;
+    p_header->connectTime = worst ? UINT32_MAX : 41u;
+    p_header->has_mfgComplete = true;
+    p_header->mfgComplete = true;
+
+    //the reset counters and the log only go out after a fault
+    if ( worst == true )
+    {
+        p_header->has_numSSMResets = true;
+        p_header->numSSMResets = UINT32_MAX;
+        p_header->has_lastSSMResetDate = true;
+        p_header->lastSSMResetDate = UINT32_MAX;
+        p_header->has_numAMResets = true;
+        p_header->numAMResets = UINT32_MAX;
+        p_header->has_lastAMResetDate = true;
+        p_header->lastAMResetDate = UINT32_MAX;
+        p_header->has_logs = true;
+        memset(p_header->logs, 'x', sizeof(p_header->logs) - 1u);
+    }
+}
+
+static void xBuildStatus(void * p_msg, bool worst)
+{
+    StatusMessage * p_status = p_msg;
+
+    xBuildHeader(&p_status->header, worst);
+}
+
+static void xBuildGps(void * p_msg, bool worst)
+{
+    GpsMessage * p_gps = p_msg;
+
+    xBuildHeader(&p_gps->header, worst);
+    p_gps->has_hours = true;
+    p_gps->hours = worst ? UINT32_MAX : 13u;
+    p_gps->has_minutes = true;
+    p_gps->minutes = worst ? UINT32_MAX : 42u;
+    p_gps->has_latitude = true;
+    p_gps->latitude = -1.2921f;
+    p_gps->has_longitude = true;
+    p_gps->longitude = 36.8219f;
+    p_gps->has_altitude = true;
+    p_gps->altitude = 1795.0f;
+    p_gps->has_fixQuality = true;
+    p_gps->fixQuality = worst ? UINT32_MAX : 1u;
+    p_gps->has_satellitesTracked = true;
+    p_gps->satellitesTracked = worst ? UINT32_MAX : 9u;
+    p_gps->has_hdopValue = true;
+    p_gps->hdopValue = 0.9f;
+    p_gps->has_measurementTime = true;
+    p_gps->measurementTime = worst ? UINT32_MAX : 35u;
+}
+
+// A typical day pumps from 07:00 to 18:00
+static void xBuildSensorData(void * p_msg, bool worst)
+{
+    SensorDataMessage * p_data = p_msg;
+    uint32_t hour = 0u;
+    bool pumping = false;
+
+    xBuildHeader(&p_data->header, worst);
+
+    p_data->litersPerHour_count = HOURS_PER_DAY;
+    p_data->tempPerHour_count = HOURS_PER_DAY;
+    p_data->humidityPerHour_count = HOURS_PER_DAY;
+    p_data->strokesPerHour_count = HOURS_PER_DAY;
+    p_data->strokeHeightPerHour_count = HOURS_PER_DAY;
+
+    for ( hour = 0u; hour < HOURS_PER_DAY; hour++ )
+    {
+        pumping = (hour > 6u) && (hour < 19u);
+        p_data->litersPerHour[hour] = worst ? UINT32_MAX : (pumping ? 40u + hour * 3u : 0u);
+        p_data->tempPerHour[hour] = worst ? UINT32_MAX : 24u + hour % 5u;
+        p_data->humidityPerHour[hour] = worst ? UINT32_MAX : 60u + hour % 7u;
+        p_data->strokesPerHour[hour] = worst ? UINT32_MAX : (pumping ? 300u + hour * 11u : 0u);
+        p_data->strokeHeightPerHour[hour] = worst ? UINT32_MAX : (pumping ? 120u : 0u);
+    }
+
+    p_data->has_dailyLiters = true;
+    p_data->dailyLiters = worst ? UINT32_MAX : 812u;
+    p_data->has_avgLiters = true;
+    p_data->avgLiters = worst ? UINT32_MAX : 790u;
+    p_data->has_totalLiters = true;
+    p_data->totalLiters = worst ? UINT32_MAX : 412345u;
+    p_data->has_breakdown = true;
+    p_data->breakdown = worst;
+    p_data->has_pumpCapacity = true;
+    p_data->pumpCapacity = worst ? UINT32_MAX : 55u;
+    p_data->has_pumpUsage = true;
+    p_data->pumpUsage = worst ? UINT32_MAX : 31u;
+    p_data->has_dryStrokes = true;
+    p_data->dryStrokes = worst ? UINT32_MAX : 12u;
+    p_data->has_dryStrokeHeight = true;
+    p_data->dryStrokeHeight = worst ? UINT32_MAX : 4u;
+    p_data->has_pumpUnusedTime = true;
+    p_data->pumpUnusedTime = worst ? UINT32_MAX : 3u;
+}
+
+static int xRecord(void)
+{
+    static uint8_t msg[sizeof(SensorDataMessage)];
+    char path[64];
+    FILE * p_file = NULL;
+    uint32_t i = 0u;
+
+    for ( i = 0u; i < NUM_MESSAGES; i++ )
+    {
+        memset(msg, 0, sizeof(msg));
+        xMessages[i].p_build(msg, xMessages[i].worst);
+        xJobMessage = &xMessages[i];
+        xJobSource = msg;
+        xEncodeJob();
+
+        snprintf(path, sizeof(path), FIXTURE_DIR "%s.bin", xMessages[i].p_name);
+        p_file = fopen(path, "wb");
+        if ( (xJobOk == false) || (p_file == NULL) )
+        {
+            fprintf(stderr, "%s: %s\n", path, (xJobOk == false) ? "encode failed" : strerror(errno));
+            return 1;
+        }
+        fwrite(xJobWire, 1u, xJobWireLen, p_file);
+        fclose(p_file);
+        printf("%s: %zu bytes\n", path, xJobWireLen);
+    }
+
+    return 0;
+}
+
+static bool xReadFixture(const char * p_name, uint8_t * p_wire, size_t * p_len)
+{
+    char path[64];
+    FILE * p_file = NULL;
+
+    snprintf(path, sizeof(path), FIXTURE_DIR "%s.bin", p_name);
+    p_file = fopen(path, "rb");
+    if ( p_file == NULL )
+    {
+        return false;
+    }
+    *p_len = fread(p_wire, 1u, WIRE_BUFFER_SIZE, p_file);
+    fclose(p_file);
+
+    return true;
+}
+
+static void xEncodeJob(void)
+{
+    pb_ostream_t stream = pb_ostream_from_buffer(xJobWire, sizeof(xJobWire));
+
+    xJobOk = pb_encode(&stream, xJobMessage->p_fields, xJobSource);
+    xJobWireLen = stream.bytes_written;
+}
+
+static void xDecodeJob(void)
+{
+    pb_istream_t stream = pb_istream_from_buffer(xJobWire, xJobWireLen);
+
+    memset(xJobDecoded, 0, xJobMessage->structSize);
+    xJobOk = pb_decode(&stream, xJobMessage->p_fields, xJobDecoded);
+}
+
+static void xPaintTrampoline(void)
+{
+    xPaintJob();
+}
+
+// Runs the job on a stack filled with PAINT_BYTE, the stack grows down so the first byte from the bottom
+// that changed is the deepest it went
+static uint32_t xStackUse(void (*p_job)(void))
+{
+    uint32_t untouched = 0u;
+
+    memset(xPaintStack, PAINT_BYTE, sizeof(xPaintStack));
+    xPaintJob = p_job;
+    getcontext(&xJobContext);
+    xJobContext.uc_stack.ss_sp = xPaintStack;
+    xJobContext.uc_stack.ss_size = sizeof(xPaintStack);
+    xJobContext.uc_link = &xMainContext;
+    makecontext(&xJobContext, xPaintTrampoline, 0);
+    swapcontext(&xMainContext, &xJobContext);
+
+    while ( (untouched < sizeof(xPaintStack)) && (xPaintStack[untouched] == PAINT_BYTE) )
+    {
+        untouched++;
+    }
+
+    return (uint32_t)(sizeof(xPaintStack) - untouched);
+}
+
+static uint32_t xTimeNs(void (*p_job)(void))
+{
+    struct timespec start;
+    struct timespec end;
+    double best = 0.0;
+    double ns = 0.0;
+    uint32_t round = 0u;
+    uint32_t i = 0u;
+
+    for ( round = 0u; round < BENCH_ROUNDS; round++ )
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for ( i = 0u; i < BENCH_ITERATIONS; i++ )
+        {
+            p_job();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        ns = ((double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec)) / BENCH_ITERATIONS;
+        if ( (round == 0u) || (ns < best) )
+        {
+            best = ns;
+        }
+    }
+
+    return (uint32_t)(best + 0.5);
+}
+
+static void xBenchMessage(const benchMessage_t * p_message, benchResult_t * p_result)
+{
+    static uint8_t built[sizeof(SensorDataMessage)];
+    static uint8_t decoded[sizeof(SensorDataMessage)];
+    static uint8_t fixture[WIRE_BUFFER_SIZE];
+    size_t fixtureLen = 0u;
+    char what[128];
+    bool readOk = false;
+    bool decodeOk = false;
+    bool sameMessage = false;
+    bool sameBytes = false;
+
+    memset(p_result, 0, sizeof(*p_result));
+    snprintf(p_result->name, sizeof(p_result->name), "%s", p_message->p_name);
+    p_result->max = (uint32_t)p_message->maxSize;
+
+    memset(built, 0, sizeof(built));
+    p_message->p_build(built, p_message->worst);
+
+    readOk = xReadFixture(p_message->p_name, fixture, &fixtureLen);
+    snprintf(what, sizeof(what), "%s.bin read (pb_bench --record writes it)", p_message->p_name);
+    xCheck(readOk, what);
+    if ( readOk == false )
+    {
+        return;
+    }
+
+    //the fixture decodes to the message it was recorded from
+    xJobMessage = p_message;
+    xJobDecoded = decoded;
+    memcpy(xJobWire, fixture, fixtureLen);
+    xJobWireLen = fixtureLen;
+    xDecodeJob();
+    decodeOk = xJobOk;
+    sameMessage = (decodeOk == true) && (memcmp(decoded, built, p_message->structSize) == 0);
+
+    //and encodes back to the same bytes
+    xJobSource = decoded;
+    xEncodeJob();
+    sameBytes = (xJobOk == true) && (xJobWireLen == fixtureLen) && (memcmp(xJobWire, fixture, fixtureLen) == 0);
+
+    snprintf(what, sizeof(what), "%s: %zu bytes decode to the recorded message and encode back the same",
+             p_message->p_name, fixtureLen);
+    xCheck(decodeOk && sameMessage && sameBytes, what);
+    snprintf(what, sizeof(what), "%s: within the generated maximum, %zu of %zu bytes",
+             p_message->p_name, fixtureLen, p_message->maxSize);
+    xCheck(fixtureLen <= p_message->maxSize, what);
+
+    p_result->wire = (uint32_t)fixtureLen;
+    p_result->encodeNs = xTimeNs(xEncodeJob);
+    p_result->decodeNs = xTimeNs(xDecodeJob);
+    p_result->encodeStack = xStackUse(xEncodeJob);
+    p_result->decodeStack = xStackUse(xDecodeJob);
+}
+
+// One line per message: name wire max encodeStack decodeStack, # starts a comment
+static uint32_t xReadBaseline(benchResult_t * p_baseline, uint32_t maxEntries)
+{
+    FILE * p_file = fopen(BASELINE_FILE, "r");
+    char line[256];
+    uint32_t count = 0u;
+    benchResult_t * p_entry = NULL;
+
+    if ( p_file == NULL )
+    {
+        return 0u;
+    }
+
+    while ( (count < maxEntries) && (fgets(line, sizeof(line), p_file) != NULL) )
+    {
+        p_entry = &p_baseline[count];
+        if ( (line[0] != '#') &&
+             (sscanf(line, "%31s %u %u %u %u", p_entry->name, &p_entry->wire, &p_entry->max,
+                     &p_entry->encodeStack, &p_entry->decodeStack) == 5) )
+        {
+            count++;
+        }
+    }
+    fclose(p_file);
+
+    return count;
+}
+
+static const benchResult_t * xFindBaseline(const benchResult_t * p_baseline, uint32_t count, const char * p_name)
+{
+    uint32_t i = 0u;
+
+    for ( i = 0u; i < count; i++ )
+    {
+        if ( strcmp(p_baseline[i].name, p_name) == 0 )
+        {
+            return &p_baseline[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void xCompare(const benchResult_t * p_result, const benchResult_t * p_baseline, uint32_t tolerancePct)
+{
+    char what[512];
+    uint64_t scale = 100u + tolerancePct;
+
+    if ( p_baseline == NULL )
+    {
+        snprintf(what, sizeof(what), "%s: in the baseline (pb_bench --update adds it)", p_result->name);
+        xCheck(false, what);
+        return;
+    }
+
+    snprintf(what, sizeof(what), "%s: wire %u bytes, baseline %u", p_result->name, p_result->wire, p_baseline->wire);
+    xCheck(p_result->wire <= p_baseline->wire, what);
+    snprintf(what, sizeof(what), "%s: generated maximum %u bytes, baseline %u", p_result->name, p_result->max, p_baseline->max);
+    xCheck(p_result->max <= p_baseline->max, what);
+    snprintf(what, sizeof(what), "%s: stack %u/%u bytes, baseline %u/%u", p_result->name,
+             p_result->encodeStack, p_result->decodeStack, p_baseline->encodeStack, p_baseline->decodeStack);
+    xCheck(((uint64_t)p_result->encodeStack * 100u <= (uint64_t)p_baseline->encodeStack * scale) &&
+           ((uint64_t)p_result->decodeStack * 100u <= (uint64_t)p_baseline->decodeStack * scale), what);
+}
+
+static bool xWriteBaseline(const benchResult_t * p_results, uint32_t count)
+{
+    FILE * p_file = fopen(BASELINE_FILE, "w");
+    uint32_t i = 0u;
+
+    if ( p_file == NULL )
+    {
+        return false;
+    }
+
+    fprintf(p_file, "# Host nanopb benchmark baseline, written by pb_bench --update (x86-64, gcc -O2)\n");
+    fprintf(p_file, "# name wire max encodeStack decodeStack\n");
+    for ( i = 0u; i < count; i++ )
+    {
+        fprintf(p_file, "%s %u %u %u %u\n", p_results[i].name, p_results[i].wire, p_results[i].max,
+                p_results[i].encodeStack, p_results[i].decodeStack);
+    }
+    fclose(p_file);
+
+    return true;
+}
@@ -0,0 +1,352 @@
+/**************************************************************************************************
+* \file     host_am.c
+* \brief    Host stand-ins for the AM modules a test does not build
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CLI.h"
+#include "semphr.h"
+#include "host_am.h"
+
+#define HOST_MAX_LOG_LINES      1024
+#define HOST_MAX_COMMANDS       32
+#define HOST_MAX_ARGS           8
+
+static char xLogLines[HOST_MAX_LOG_LINES][HOST_LOG_LINE_LEN];
+static uint32_t xNumLogLines = 0u;
+static uint32_t xLogCounts[eLogLvlInvalid + 1];
+static CLI_Command_Handler_s xCommands[HOST_MAX_COMMANDS];
+static uint32_t xNumCommands = 0u;
+static __thread TaskHandle_t xCurrentTask = NULL;
+static pthread_mutex_t xCriticalMutex;
+static pthread_once_t xCriticalOnce = PTHREAD_ONCE_INIT;
+
+static void xInitCritical(void);
+static void xGetDeadline(TickType_t ticks, struct timespec * p_deadline);
+
+void HOST_ClearLog(void)
+{
+    xNumLogLines = 0u;
+    memset(xLogCounts, 0, sizeof(xLogCounts));
+}
+
+uint32_t HOST_GetLogCount(tLogLvl level)
+{
+    return (level <= eLogLvlInvalid) ? xLogCounts[level] : 0u;
+}
+
+// The last line that has p_text in it, copied to p_line if it is not NULL. Only the newest
+// HOST_MAX_LOG_LINES lines are kept.
+bool HOST_FindLog(const char * p_text, char * p_line)
+{
+    uint32_t i;
+    uint32_t oldest = (xNumLogLines > HOST_MAX_LOG_LINES) ? (xNumLogLines - HOST_MAX_LOG_LINES) : 0u;
+
+    for ( i = xNumLogLines; i > oldest; i-- )
+    {
+        if ( strstr(xLogLines[(i - 1u) % HOST_MAX_LOG_LINES], p_text) != NULL )
+        {
+            if ( p_line != NULL )
+            {
+                strcpy(p_line, xLogLines[(i - 1u) % HOST_MAX_LOG_LINES]);
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Splits the line on spaces and calls the handler registered for the first word, as CLI.c does
+bool HOST_RunCommand(const char * p_commandLine)
+{
+    char line[HOST_LOG_LINE_LEN];
+    char * argv[HOST_MAX_ARGS];
+    int argc = 0;
+    char * p_token;
+    uint32_t i;
+
+    snprintf(line, sizeof(line), "%s", p_commandLine);
+
+    for ( p_token = strtok(line, " "); (p_token != NULL) && (argc < HOST_MAX_ARGS); p_token = strtok(NULL, " ") )
+    {
+        argv[argc++] = p_token;
+    }
+
+    for ( i = 0u; (argc > 0) && (i < xNumCommands); i++ )
+    {
+        if ( strcmp(xCommands[i].cmdString, argv[COMMAND_IDX]) == 0 )
+        {
+            xCommands[i].ptrFunction(argc, argv);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+__attribute__((weak)) void logCore(const char * fileName, const char * functionName, int lineNumber, tLogLvl loggingLevel, const char * formatStr, ...)
+{
+    va_list args;
+    char * p_line = xLogLines[xNumLogLines % HOST_MAX_LOG_LINES];
+
+    va_start(args, formatStr);
+    vsnprintf(p_line, HOST_LOG_LINE_LEN, formatStr, args);
+    va_end(args);
+
+    xNumLogLines++;
+
+    if ( loggingLevel <= eLogLvlInvalid )
+    {
+        xLogCounts[loggingLevel]++;
+    }
+
+    if ( getenv("HOST_VERBOSE") != NULL )
+    {
+        printf("    [%s] %s\n", functionName, p_line);
+    }
+}
+
+__attribute__((weak)) void CLI_registerThisCommandHandler(CLI_Command_Handler_s * ptrStruct)
+{
+    uint32_t i;
+
+    //registering again after a simulated reset replaces the handler
+    for ( i = 0u; i < xNumCommands; i++ )
+    {
+        if ( strcmp(xCommands[i].cmdString, ptrStruct->cmdString) == 0 )
+        {
+            xCommands[i] = *ptrStruct;
+            return;
+        }
+    }
+
+    if ( xNumCommands < HOST_MAX_COMMANDS )
+    {
+        xCommands[xNumCommands++] = *ptrStruct;
+    }
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t * pxMutexBuffer)
+{
+    pthread_mutex_init(&pxMutexBuffer->mutex, NULL);
+    pxMutexBuffer->isBinary = false;
+
+    return pxMutexBuffer;
+}
+
+// Created empty, as FreeRTOS does
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t * pxSemaphoreBuffer)
+{
+    pthread_mutex_init(&pxSemaphoreBuffer->mutex, NULL);
+    pthread_cond_init(&pxSemaphoreBuffer->cond, NULL);
+    pxSemaphoreBuffer->isBinary = true;
+    pxSemaphoreBuffer->isGiven = false;
+
+    return pxSemaphoreBuffer;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    struct timespec deadline;
+    TickType_t start;
+    BaseType_t taken;
+
+    if ( xSemaphore->isBinary == false )
+    {
+        return (pthread_mutex_lock(&xSemaphore->mutex) == 0) ? pdTRUE : pdFALSE;
+    }
+
+    xGetDeadline(xBlockTime, &deadline);
+    start = xTaskGetTickCount();
+
+    //a timeout is only over once the tick count has moved on by the whole wait, as it is in FreeRTOS
+    pthread_mutex_lock(&xSemaphore->mutex);
+    while ( (xSemaphore->isGiven == false) && (xBlockTime != 0u) )
+    {
+        if ( pthread_cond_timedwait(&xSemaphore->cond, &xSemaphore->mutex, &deadline) == ETIMEDOUT )
+        {
+            if ( (xTaskGetTickCount() - start) >= xBlockTime )
+            {
+                break;
+            }
+            xGetDeadline(1u, &deadline);
+        }
+    }
+
+    taken = (xSemaphore->isGiven == true) ? pdTRUE : pdFALSE;
+    xSemaphore->isGiven = false;
+    pthread_mutex_unlock(&xSemaphore->mutex);
+
+    return taken;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    BaseType_t given;
+
+    if ( xSemaphore->isBinary == false )
+    {
+        return (pthread_mutex_unlock(&xSemaphore->mutex) == 0) ? pdTRUE : pdFALSE;
+    }
+
+    pthread_mutex_lock(&xSemaphore->mutex);
+    given = (xSemaphore->isGiven == false) ? pdTRUE : pdFALSE;
+    xSemaphore->isGiven = true;
+    pthread_cond_signal(&xSemaphore->cond);
+    pthread_mutex_unlock(&xSemaphore->mutex);
+
+    return given;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore, BaseType_t * pxHigherPriorityTaskWoken)
+{
+    if ( pxHigherPriorityTaskWoken != NULL )
+    {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+
+    return xSemaphoreGive(xSemaphore);
+}
+
+void HOST_EnterCritical(void)
+{
+    pthread_once(&xCriticalOnce, xInitCritical);
+    pthread_mutex_lock(&xCriticalMutex);
+}
+
+void HOST_ExitCritical(void)
+{
+    pthread_mutex_unlock(&xCriticalMutex);
+}
+
+// ms since the first call
+TickType_t xTaskGetTickCount(void)
+{
+    static struct timespec start;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if ( (start.tv_sec == 0) && (start.tv_nsec == 0) )
+    {
+        start = now;
+    }
+
+    return (TickType_t)(((now.tv_sec - start.tv_sec) * 1000l) + ((now.tv_nsec - start.tv_nsec) / 1000000l));
+}
+
+void HOST_InitTask(hostTask_t * p_task)
+{
+    pthread_mutex_init(&p_task->mutex, NULL);
+    pthread_cond_init(&p_task->cond, NULL);
+    p_task->notifyValue = 0u;
+}
+
+void HOST_SetCurrentTask(TaskHandle_t task)
+{
+    xCurrentTask = task;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return xCurrentTask;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    pthread_mutex_lock(&xTaskToNotify->mutex);
+    xTaskToNotify->notifyValue++;
+    pthread_cond_signal(&xTaskToNotify->cond);
+    pthread_mutex_unlock(&xTaskToNotify->mutex);
+
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t * pxHigherPriorityTaskWoken)
+{
+    (void)xTaskNotifyGive(xTaskToNotify);
+
+    if ( pxHigherPriorityTaskWoken != NULL )
+    {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    TaskHandle_t task = xCurrentTask;
+    struct timespec deadline;
+    uint32_t value = 0u;
+
+    xGetDeadline(xTicksToWait, &deadline);
+
+    pthread_mutex_lock(&task->mutex);
+    while ( task->notifyValue == 0u )
+    {
+        if ( (xTicksToWait == 0u) || (pthread_cond_timedwait(&task->cond, &task->mutex, &deadline) == ETIMEDOUT) )
+        {
+            break;
+        }
+    }
+
+    value = task->notifyValue;
+    if ( xClearCountOnExit != pdFALSE )
+    {
+        task->notifyValue = 0u;
+    }
+    else if ( value != 0u )
+    {
+        task->notifyValue--;
+    }
+    pthread_mutex_unlock(&task->mutex);
+
+    return value;
+}
+
+// Nested sections from the same thread, as the firmware's critical nesting count allows
+static void xInitCritical(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&xCriticalMutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+// The wall clock time a wait of ticks (ms) from now ends, for pthread_cond_timedwait()
+static void xGetDeadline(TickType_t ticks, struct timespec * p_deadline)
+{
+    clock_gettime(CLOCK_REALTIME, p_deadline);
+    p_deadline->tv_sec += (time_t)(ticks / 1000u);
+    p_deadline->tv_nsec += (long)(ticks % 1000u) * 1000000l;
+    if ( p_deadline->tv_nsec >= 1000000000l )
+    {
+        p_deadline->tv_sec++;
+        p_deadline->tv_nsec -= 1000000000l;
+    }
+}
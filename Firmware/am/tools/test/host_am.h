@@ -0,0 +1,48 @@
+/**************************************************************************************************
+* \file     host_am.h
+* \brief    Host stand-ins for the AM modules a test does not build
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef HOST_AM_H_
+#define HOST_AM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "logger.h"
+#include "task.h"
+
+// host_am.c gives every test the logger, the CLI registry, the FreeRTOS mutexes, binary semaphores, critical
+// sections, tick count and task notifications. The logger and the CLI are weak, so a test that builds the real
+// module, or needs its own behavior, just defines them.
+//
+// The newest log lines are kept so a test can look for them, set HOST_VERBOSE in the environment to see them.
+
+#define HOST_LOG_LINE_LEN       256
+
+extern void HOST_ClearLog(void);
+extern uint32_t HOST_GetLogCount(tLogLvl level);
+extern bool HOST_FindLog(const char * p_text, char * p_line);
+extern bool HOST_RunCommand(const char * p_commandLine);
+extern void HOST_InitTask(hostTask_t * p_task);
+extern void HOST_SetCurrentTask(TaskHandle_t task);
+
+#endif /* HOST_AM_H_ */
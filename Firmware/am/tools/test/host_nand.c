@@ -0,0 +1,243 @@
+/**************************************************************************************************
+* \file     host_nand.c
+* \brief    Simulated NAND behind the flash handler API, with power cuts
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "MT29F1.h"
+#include "flashHandler.h"
+#include "host_nand.h"
+
+#define NAND_BYTES              (HOST_NAND_BLOCKS * BLOCK_SIZE)
+#define NAND_PAGES              (NAND_BYTES / PAGE_DATA_SIZE)
+#define NO_CUT                  0xFFFFFFFFul
+
+jmp_buf hostNandPowerCut;
+
+static uint8_t xArray[NAND_BYTES];
+static bool xProgrammed[NAND_PAGES];
+static uint32_t xSteps = 0u;
+static uint32_t xCutStep = NO_CUT;
+static uint32_t xErases = 0u;
+static uint32_t xPrograms = 0u;
+static uint32_t xViolations = 0u;
+static bool xFailReads = false;
+static uint32_t xRandom = 1u;
+
+static void xStep(uint8_t * p_dest, const uint8_t * p_src, uint32_t len);
+static bool xIsInRange(uint32_t address, uint32_t len);
+static uint32_t xNextRandom(void);
+
+// Starts every block over as fill, 0xFF is a new part and anything else a region holding garbage
+void HOST_NandReset(uint8_t fill)
+{
+    memset(xArray, fill, sizeof(xArray));
+    memset(xProgrammed, (fill == 0xFFu) ? 0 : 1, sizeof(xProgrammed));
+    xSteps = 0u;
+    xCutStep = NO_CUT;
+    xErases = 0u;
+    xPrograms = 0u;
+    xViolations = 0u;
+    xFailReads = false;
+}
+
+// Power is lost on the step'th erase or page program from now, 0 for the next one
+void HOST_NandCutAt(uint32_t step)
+{
+    xCutStep = xSteps + step;
+}
+
+uint32_t HOST_NandGetSteps(void)
+{
+    return xSteps;
+}
+
+uint32_t HOST_NandGetErases(void)
+{
+    return xErases;
+}
+
+uint32_t HOST_NandGetPrograms(void)
+{
+    return xPrograms;
+}
+
+uint32_t HOST_NandGetViolations(void)
+{
+    return xViolations;
+}
+
+void HOST_NandFailReads(bool fail)
+{
+    xFailReads = fail;
+}
+
+uint8_t * HOST_NandGetArray(uint32_t address)
+{
+    return &xArray[address];
+}
+
+void FLASH_init(void)
+{
+}
+
+flashErr_t FLASH_read(uint32_t address, uint8_t *data, uint32_t len)
+{
+    if ( xIsInRange(address, len) == false )
+    {
+        return FLASH_ADDR_ERR;
+    }
+
+    if ( xFailReads == true )
+    {
+        return FLASH_SPI_ERR;
+    }
+
+    memcpy(data, &xArray[address], len);
+
+    return FLASH_SUCCESS;
+}
+
+// Every block the range touches
+flashErr_t FLASH_erase(uint32_t address, uint32_t len)
+{
+    uint32_t block;
+
+    if ( (len == 0u) || (xIsInRange(address, len) == false) )
+    {
+        return FLASH_ADDR_ERR;
+    }
+
+    for ( block = address / BLOCK_SIZE; block <= ((address + len - 1u) / BLOCK_SIZE); block++ )
+    {
+        xErases++;
+        xStep(&xArray[block * BLOCK_SIZE], NULL, BLOCK_SIZE);
+        memset(&xArray[block * BLOCK_SIZE], 0xFF, BLOCK_SIZE);
+        memset(&xProgrammed[block * NUM_PAGE_BLOCK], 0, NUM_PAGE_BLOCK * sizeof(bool));
+    }
+
+    return FLASH_SUCCESS;
+}
+
+// One page from its start, the rest of the page stays erased
+flashErr_t FLASH_programPage(uint32_t address, uint8_t* data, uint32_t len)
+{
+    uint32_t page = address / PAGE_DATA_SIZE;
+    uint32_t i;
+
+    if ( ((address % PAGE_DATA_SIZE) != 0u) || (len > PAGE_DATA_SIZE) || (xIsInRange(address, len) == false) )
+    {
+        return FLASH_ADDR_ERR;
+    }
+
+    if ( xProgrammed[page] == true )
+    {
+        xViolations++;
+    }
+
+    xPrograms++;
+    xProgrammed[page] = true;
+    xStep(&xArray[address], data, len);
+
+    for ( i = 0u; i < len; i++ )
+    {
+        xArray[address + i] &= data[i];
+    }
+
+    return FLASH_SUCCESS;
+}
+
+// Read, erase and program back every block the range touches, as flashHandler.c does
+flashErr_t FLASH_write(uint32_t address, uint8_t* data, uint32_t len)
+{
+    static uint8_t block[BLOCK_SIZE];
+    uint32_t blockAddr;
+    uint32_t index;
+    uint32_t lenToWrite;
+    uint32_t page;
+
+    if ( (len == 0u) || (xIsInRange(address, len) == false) )
+    {
+        return FLASH_ADDR_ERR;
+    }
+
+    while ( len > 0u )
+    {
+        blockAddr = (address / BLOCK_SIZE) * BLOCK_SIZE;
+        index = address - blockAddr;
+        lenToWrite = ((index + len) > BLOCK_SIZE) ? (BLOCK_SIZE - index) : len;
+
+        memcpy(block, &xArray[blockAddr], BLOCK_SIZE);
+        memcpy(&block[index], data, lenToWrite);
+        FLASH_erase(blockAddr, BLOCK_SIZE);
+
+        for ( page = 0u; page < NUM_PAGE_BLOCK; page++ )
+        {
+            FLASH_programPage(blockAddr + (page * PAGE_DATA_SIZE), &block[page * PAGE_DATA_SIZE], PAGE_DATA_SIZE);
+        }
+
+        address += lenToWrite;
+        data += lenToWrite;
+        len -= lenToWrite;
+    }
+
+    return FLASH_SUCCESS;
+}
+
+// Counts the step and, if power is lost on it, does part of it and jumps out. A cut erase leaves the
+// front of the block erased and a cut program the front of the page programmed, with one byte half way.
+static void xStep(uint8_t * p_dest, const uint8_t * p_src, uint32_t len)
+{
+    uint32_t done;
+    uint32_t i;
+
+    if ( xSteps++ != xCutStep )
+    {
+        return;
+    }
+
+    xCutStep = NO_CUT;
+    done = xNextRandom() % len;
+
+    for ( i = 0u; i < done; i++ )
+    {
+        p_dest[i] = (p_src == NULL) ? 0xFFu : (p_dest[i] & p_src[i]);
+    }
+
+    p_dest[done] = (uint8_t)xNextRandom();
+
+    longjmp(hostNandPowerCut, 1);
+}
+
+static bool xIsInRange(uint32_t address, uint32_t len)
+{
+    return ( (address < NAND_BYTES) && (len <= (NAND_BYTES - address)) );
+}
+
+static uint32_t xNextRandom(void)
+{
+    xRandom = (xRandom * 1103515245u) + 12345u;
+
+    return (xRandom >> 16);
+}
@@ -0,0 +1,54 @@
+/**************************************************************************************************
+* \file     host_nand.h
+* \brief    Simulated NAND behind the flash handler API, with power cuts
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef HOST_NAND_H_
+#define HOST_NAND_H_
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// host_nand.c is FLASH_read, FLASH_write, FLASH_erase and FLASH_programPage over RAM, for tests that
+// build a module which keeps its state in NAND. It acts like the part: erase sets a whole block to 0xFF,
+// programming can only clear bits, and a page is programmed once per erase (a second program is counted
+// as a violation).
+//
+// Every erase and page program is a step. HOST_NandCutAt(n) loses power on step n: that block or page is
+// left partly done, with the bytes past a random point untouched, and the call longjmps to
+// hostNandPowerCut instead of returning. The test restarts the module from there.
+
+#define HOST_NAND_BLOCKS        32u     // covers the memory map up to the TLS session block
+
+extern jmp_buf hostNandPowerCut;
+
+extern void HOST_NandReset(uint8_t fill);
+extern void HOST_NandCutAt(uint32_t step);
+extern uint32_t HOST_NandGetSteps(void);
+extern uint32_t HOST_NandGetErases(void);
+extern uint32_t HOST_NandGetPrograms(void);
+extern uint32_t HOST_NandGetViolations(void);
+extern void HOST_NandFailReads(bool fail);
+extern uint8_t * HOST_NandGetArray(uint32_t address);
+
+#endif /* HOST_NAND_H_ */
@@ -0,0 +1,47 @@
+/**************************************************************************************************
+* \file     FreeRTOS.h
+* \brief    Host stand-in for the FreeRTOS kernel header, for the host tests
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef STUBS_FREERTOS_H_
+#define STUBS_FREERTOS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE                 ( ( BaseType_t ) 0 )
+#define pdTRUE                  ( ( BaseType_t ) 1 )
+#define pdPASS                  ( pdTRUE )
+#define pdFAIL                  ( pdFALSE )
+#define portMAX_DELAY           ( ( TickType_t ) 0xffffffffUL )
+#define portTICK_PERIOD_MS      ( ( TickType_t ) 1 )
+#define pdMS_TO_TICKS( ms )     ( ( TickType_t ) ( ms ) )
+#define configASSERT( x )
+#define portYIELD_FROM_ISR( x )  ( ( void ) ( x ) )
+#define configSTACK_DEPTH_TYPE  uint16_t
+
+#endif /* STUBS_FREERTOS_H_ */
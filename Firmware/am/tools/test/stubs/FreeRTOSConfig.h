@@ -0,0 +1,32 @@
+/**************************************************************************************************
+* \file     FreeRTOSConfig.h
+* \brief    Host stand-in for the FreeRTOS configuration, for the host tests
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef STUBS_FREERTOSCONFIG_H_
+#define STUBS_FREERTOSCONFIG_H_
+
+// The settings the firmware sources use are in the stub FreeRTOS.h, the firmware's configuration needs the
+// ARM port
+#include "FreeRTOS.h"
+
+#endif /* STUBS_FREERTOSCONFIG_H_ */
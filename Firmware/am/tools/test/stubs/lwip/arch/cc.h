@@ -0,0 +1,37 @@
+/**************************************************************************************************
+* \file     stubs/lwip/arch/cc.h
+* \brief    Host lwIP compiler and platform glue
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+#ifndef STUBS_LWIP_ARCH_CC_H_
+#define STUBS_LWIP_ARCH_CC_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// lwIP's defaults cover the types and byte order on the host, only the diagnostics go to stdout
+#define LWIP_ERRNO_STDINCLUDE           1
+#define LWIP_PLATFORM_DIAG(x)           do { printf x; } while ( 0 )
+#define LWIP_PLATFORM_ASSERT(x)         do { printf("lwIP assert: %s at %s:%d\n", x, __FILE__, __LINE__); abort(); } while ( 0 )
+
+#endif /* STUBS_LWIP_ARCH_CC_H_ */
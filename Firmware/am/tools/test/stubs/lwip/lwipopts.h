@@ -0,0 +1,79 @@
+/**************************************************************************************************
+* \file     stubs/lwip/lwipopts.h
+* \brief    Host lwIP options for the PPPoS loopback and OTA resume tests
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+#ifndef STUBS_LWIP_LWIPOPTS_H_
+#define STUBS_LWIP_LWIPOPTS_H_
+
+#include <stdlib.h>
+
+// The firmware runs lwIP under FreeRTOS with the sockets API and feeds pppos from a task with
+// PPP_INPROC_IRQ_SAFE. The host tests drive lwIP from one thread with the raw API, so there is no OS layer.
+// test_ppp_link runs two pcbs, the firmware side and its peer, and the ppp and pbuf settings that decide
+// how the bytes reach pppLink.c are the firmware's. test_ota_resume runs the HTTP client and a local server
+// over the loopback interface, the server name is added to the DNS table at run time.
+#define NO_SYS                          1
+#define SYS_LIGHTWEIGHT_PROT            0
+#define LWIP_SOCKET                     0
+#define LWIP_NETCONN                    0
+
+#define PPP_SUPPORT                     1
+#define PPPOS_SUPPORT                   1
+#define PPP_SERVER                      1
+#define PPP_INPROC_IRQ_SAFE             0
+#define PPP_IPV4_SUPPORT                1
+#define MEMP_NUM_PPP_PCB                2
+#define PAP_SUPPORT                     0
+#define CHAP_SUPPORT                    0
+#define VJ_SUPPORT                      0
+
+#define LWIP_IPV4                       1
+#define LWIP_IPV6                       0
+#define LWIP_ARP                        0
+#define LWIP_DHCP                       0
+#define LWIP_ICMP                       1
+#define LWIP_UDP                        1
+#define LWIP_TCP                        1
+#define CHECKSUM_CHECK_UDP              1
+#define LWIP_DNS                        1
+#define DNS_LOCAL_HOSTLIST              1
+#define DNS_LOCAL_HOSTLIST_IS_DYNAMIC   1
+#define LWIP_HAVE_LOOPIF                1
+#define LWIP_NETIF_LOOPBACK             1
+
+#define TCP_MSS                         1400
+#define TCP_WND                         (8 * TCP_MSS)
+#define TCP_SND_BUF                     (8 * TCP_MSS)
+#define MEMP_NUM_TCP_PCB                8
+#define MEMP_NUM_TCP_SEG                128
+
+#define MEM_ALIGNMENT                   4
+#define MEM_SIZE                        (256 * 1024)
+#define MEMP_NUM_PBUF                   64
+#define PBUF_POOL_SIZE                  64
+#define PBUF_POOL_BUFSIZE               512
+
+#define LWIP_RAND()                     ((u32_t)rand())
+
+#endif /* STUBS_LWIP_LWIPOPTS_H_ */
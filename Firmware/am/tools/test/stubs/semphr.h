@@ -0,0 +1,51 @@
+/**************************************************************************************************
+* \file     semphr.h
+* \brief    Host stand-in for the FreeRTOS semaphore header, for the host tests
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef STUBS_SEMPHR_H_
+#define STUBS_SEMPHR_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+
+// Mutexes are pthread mutexes so a test can run firmware from more than one thread. Creating one again
+// (a simulated reset) starts it over unlocked. A binary semaphore is a flag under the mutex with a
+// condition to wait on, it can be given from a thread that plays an interrupt.
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool isBinary;
+    bool isGiven;
+}StaticSemaphore_t;
+
+typedef StaticSemaphore_t * SemaphoreHandle_t;
+
+extern SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t * pxMutexBuffer);
+extern SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t * pxSemaphoreBuffer);
+extern BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime);
+extern BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore);
+extern BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore, BaseType_t * pxHigherPriorityTaskWoken);
+
+#endif /* STUBS_SEMPHR_H_ */
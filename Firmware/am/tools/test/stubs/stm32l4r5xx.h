@@ -0,0 +1,55 @@
+/**************************************************************************************************
+* \file     stm32l4r5xx.h
+* \brief    Host stand-in for the STM32L4R5 device header
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+#ifndef STUBS_STM32L4R5XX_H_
+#define STUBS_STM32L4R5XX_H_
+
+#include <stdint.h>
+
+// Only the cycle counter. Reading DWT calls HOST_GetDwt(), which loads CYCCNT from the calling thread's CPU
+// time, so a load figure counts the cycles the firmware spent rather than the time it was preempted. With
+// SystemCoreClock at 1 GHz a cycle is a ns. The test that uses them defines these.
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+}DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+}CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk          ( 1UL )
+#define CoreDebug_DEMCR_TRCENA_Msk      ( 1UL << 24 )
+
+#define DWT                             ( HOST_GetDwt() )
+#define CoreDebug                       ( &HOST_CoreDebug )
+
+extern DWT_Type * HOST_GetDwt(void);
+extern CoreDebug_Type HOST_CoreDebug;
+extern uint32_t SystemCoreClock;
+
+#endif /* STUBS_STM32L4R5XX_H_ */
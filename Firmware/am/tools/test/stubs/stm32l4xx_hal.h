@@ -0,0 +1,223 @@
+/**************************************************************************************************
+* \file     stubs/stm32l4xx_hal.h
+* \brief    Host stand-in for the STM32L4 HAL
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+#ifndef STUBS_STM32L4XX_HAL_H_
+#define STUBS_STM32L4XX_HAL_H_
+
+#include <stdint.h>
+
+typedef enum
+{
+    HAL_OK       = 0x00U,
+    HAL_ERROR    = 0x01U,
+    HAL_BUSY     = 0x02U,
+    HAL_TIMEOUT  = 0x03U
+}HAL_StatusTypeDef;
+
+// Only what the modules under test call, the test that builds them defines these
+extern uint32_t HAL_GetUIDw0(void);
+extern uint32_t HAL_GetUIDw1(void);
+extern uint32_t HAL_GetUIDw2(void);
+
+// GPIO, SPI and DMA for spi.c. The instances are plain structs, only the pointers are compared
+typedef enum
+{
+    GPIO_PIN_RESET = 0u,
+    GPIO_PIN_SET
+}GPIO_PinState;
+
+typedef struct
+{
+    volatile uint32_t ODR;
+}GPIO_TypeDef;
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+}GPIO_InitTypeDef;
+
+typedef struct
+{
+    volatile uint32_t CR1;
+}SPI_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CCR;
+}DMA_Channel_TypeDef;
+
+typedef struct
+{
+    uint32_t Mode;
+    uint32_t Direction;
+    uint32_t DataSize;
+    uint32_t CLKPolarity;
+    uint32_t CLKPhase;
+    uint32_t NSS;
+    uint32_t BaudRatePrescaler;
+    uint32_t FirstBit;
+    uint32_t TIMode;
+    uint32_t CRCCalculation;
+    uint32_t CRCPolynomial;
+    uint32_t NSSPMode;
+}SPI_InitTypeDef;
+
+typedef struct
+{
+    uint32_t Request;
+    uint32_t Direction;
+    uint32_t PeriphInc;
+    uint32_t MemInc;
+    uint32_t PeriphDataAlignment;
+    uint32_t MemDataAlignment;
+    uint32_t Mode;
+    uint32_t Priority;
+}DMA_InitTypeDef;
+
+typedef struct
+{
+    DMA_Channel_TypeDef *Instance;
+    DMA_InitTypeDef Init;
+    void *Parent;
+}DMA_HandleTypeDef;
+
+typedef struct
+{
+    SPI_TypeDef *Instance;
+    SPI_InitTypeDef Init;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+}SPI_HandleTypeDef;
+
+typedef enum
+{
+    DMA1_Channel2_IRQn = 12,
+    DMA1_Channel3_IRQn = 13,
+    DMA1_Channel4_IRQn = 14,
+    DMA1_Channel5_IRQn = 15,
+    SPI1_IRQn          = 35,
+    SPI2_IRQn          = 36
+}IRQn_Type;
+
+extern GPIO_TypeDef HOST_GpioA;
+extern GPIO_TypeDef HOST_GpioB;
+extern GPIO_TypeDef HOST_GpioE;
+extern SPI_TypeDef HOST_Spi1;
+extern SPI_TypeDef HOST_Spi2;
+extern DMA_Channel_TypeDef HOST_Dma1Channel[8];
+
+#define GPIOA                           ( &HOST_GpioA )
+#define GPIOB                           ( &HOST_GpioB )
+#define GPIOE                           ( &HOST_GpioE )
+#define SPI1                            ( &HOST_Spi1 )
+#define SPI2                            ( &HOST_Spi2 )
+#define DMA1_Channel2                   ( &HOST_Dma1Channel[2] )
+#define DMA1_Channel3                   ( &HOST_Dma1Channel[3] )
+#define DMA1_Channel4                   ( &HOST_Dma1Channel[4] )
+#define DMA1_Channel5                   ( &HOST_Dma1Channel[5] )
+
+#define GPIO_PIN_4                      ( ( uint16_t ) 0x0010 )
+#define GPIO_PIN_9                      ( ( uint16_t ) 0x0200 )
+#define GPIO_PIN_10                     ( ( uint16_t ) 0x0400 )
+#define GPIO_PIN_12                     ( ( uint16_t ) 0x1000 )
+#define GPIO_MODE_INPUT                 ( 0x00000000u )
+#define GPIO_MODE_OUTPUT_PP             ( 0x00000001u )
+#define GPIO_NOPULL                     ( 0x00000000u )
+#define GPIO_SPEED_FREQ_LOW             ( 0x00000000u )
+
+#define SPI_MODE_MASTER                 ( 0x00000104u )
+#define SPI_DIRECTION_2LINES            ( 0x00000000u )
+#define SPI_DATASIZE_8BIT               ( 0x00000700u )
+#define SPI_POLARITY_LOW                ( 0x00000000u )
+#define SPI_PHASE_1EDGE                 ( 0x00000000u )
+#define SPI_NSS_SOFT                    ( 0x00000200u )
+#define SPI_FIRSTBIT_MSB                ( 0x00000000u )
+#define SPI_TIMODE_DISABLE              ( 0x00000000u )
+#define SPI_CRCCALCULATION_DISABLE      ( 0x00000000u )
+#define SPI_NSS_PULSE_DISABLE           ( 0x00000000u )
+#define SPI_BAUDRATEPRESCALER_2         ( 0x00000000u )
+#define SPI_BAUDRATEPRESCALER_32        ( 0x00000020u )
+#define SPI_BAUDRATEPRESCALER_64        ( 0x00000028u )
+#define SPI_BAUDRATEPRESCALER_128       ( 0x00000030u )
+#define SPI_BAUDRATEPRESCALER_256       ( 0x00000038u )
+#define SPI_CR1_BR                      ( 0x00000038u )
+#define SPI_CR1_SPE                     ( 0x00000040u )
+
+#define DMA_REQUEST_SPI1_RX             ( 10u )
+#define DMA_REQUEST_SPI1_TX             ( 11u )
+#define DMA_REQUEST_SPI2_RX             ( 12u )
+#define DMA_REQUEST_SPI2_TX             ( 13u )
+#define DMA_PERIPH_TO_MEMORY            ( 0x00000000u )
+#define DMA_MEMORY_TO_PERIPH            ( 0x00000010u )
+#define DMA_PINC_DISABLE                ( 0x00000000u )
+#define DMA_MINC_ENABLE                 ( 0x00000080u )
+#define DMA_PDATAALIGN_BYTE             ( 0x00000000u )
+#define DMA_MDATAALIGN_BYTE             ( 0x00000000u )
+#define DMA_NORMAL                      ( 0x00000000u )
+#define DMA_PRIORITY_MEDIUM             ( 0x00001000u )
+#define DMA_PRIORITY_HIGH               ( 0x00002000u )
+
+#define MODIFY_REG(REG, CLEARMASK, SETMASK)     ( (REG) = (((REG) & (~(CLEARMASK))) | (SETMASK)) )
+#define __HAL_SPI_DISABLE(__HANDLE__)           ( (__HANDLE__)->Instance->CR1 &= ~SPI_CR1_SPE )
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__) \
+    do { (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__); (__DMA_HANDLE__).Parent = (__HANDLE__); } while(0)
+
+// Clocks, interrupts and pin setup have nothing to do on the host
+#define __HAL_RCC_DMAMUX1_CLK_ENABLE()          do { } while(0)
+#define __HAL_RCC_DMA1_CLK_ENABLE()             do { } while(0)
+
+static inline void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+}
+
+static inline void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+}
+
+static inline void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+}
+
+extern HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi);
+extern HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef *hspi);
+extern HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+extern HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+extern HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+extern HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+extern HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi);
+extern void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+extern void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi);
+extern void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi);
+extern HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+extern HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma);
+extern void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+extern GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+extern uint32_t HAL_RCC_GetPCLK1Freq(void);
+
+#endif /* STUBS_STM32L4XX_HAL_H_ */
@@ -0,0 +1,77 @@
+/**************************************************************************************************
+* \file     task.h
+* \brief    Host stand-in for the FreeRTOS task header, for the host tests
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef STUBS_TASK_H_
+#define STUBS_TASK_H_
+
+#include <pthread.h>
+#include "FreeRTOS.h"
+
+// A critical section is one recursive mutex. A test thread that plays an interrupt takes it with
+// HOST_EnterCritical() around the handler, so the handler can not run inside the firmware's sections.
+#define taskENTER_CRITICAL()    HOST_EnterCritical()
+#define taskEXIT_CRITICAL()     HOST_ExitCritical()
+
+// A task is a thread with a direct to task notification value, the value is counted the way
+// xTaskNotifyGive()/ulTaskNotifyTake() use it. A test sets up the task with HOST_InitTask() and calls
+// HOST_SetCurrentTask() from the thread that plays it. Ticks are ms.
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t notifyValue;
+}hostTask_t;
+
+typedef hostTask_t * TaskHandle_t;
+
+// A test that runs a firmware task on its own thread, or inline, defines these
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum
+{
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+}eNotifyAction;
+
+extern void HOST_EnterCritical(void);
+extern void HOST_ExitCritical(void);
+
+extern TickType_t xTaskGetTickCount(void);
+extern TaskHandle_t xTaskGetCurrentTaskHandle(void);
+extern BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+extern void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t * pxHigherPriorityTaskWoken);
+extern uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+
+extern BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName, configSTACK_DEPTH_TYPE usStackDepth,
+                              void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask);
+extern void vTaskDelete(TaskHandle_t xTaskToDelete);
+extern void vTaskDelay(const TickType_t xTicksToDelay);
+extern BaseType_t xTaskNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction);
+extern BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t * pulNotificationValue,
+                                  TickType_t xTicksToWait);
+
+#endif /* STUBS_TASK_H_ */
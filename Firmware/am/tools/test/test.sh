@@ -0,0 +1,153 @@
+#!/bin/bash
+
+#
+# Build and run the AM host tests with gcc
+#
+# Each test_*.c here is built with the firmware sources it checks and run. The FreeRTOS and HAL headers
+# come from stubs/, host_am.c stands in for the logger and the CLI. Run from this folder, everything
+# goes to out/. Exits 1 if any test fails.
+#
+# Usage: ./test.sh [test ...]     e.g. ./test.sh test_arena
+#
+
+CC="gcc"
+SRC="../../src"
+PROTOS="../../protos"
+ASP="../../../shared/asp"
+MBEDTLS="../../lib/third_party/mbedtls"
+MBEDTLS_OPTIONS="-I$MBEDTLS/include -DMBEDTLS_CONFIG_FILE=\"mbedtls_host_config.h\""
+LWIP="../../lib/third_party/LwIP/src"
+# -iquote puts the host lwipopts.h ahead of the firmware's for lwIP, other tests still see the firmware's
+LWIP_OPTIONS="-iquote stubs/lwip -I$LWIP/include -I$LWIP/include/netif/ppp"
+
+GENERIC_OPTIONS=(   -std=gnu99 \
+                    -O2 \
+                    -g \
+                    -Wall \
+                    -Wno-unused-function \
+                    -Wno-format \
+                    -pthread \
+                    -DAM_HOST_TEST)
+
+# stubs is first so the FreeRTOS and HAL headers come from there
+INCLUDE_PATHS=( -I. \
+                -Istubs \
+                -I$SRC \
+                -I$SRC/application \
+                -I$SRC/handlers \
+                -I$SRC/device-drivers \
+                -I$SRC/peripheral-drivers \
+                -I../../configuration \
+                -I$PROTOS \
+                -I../../../shared/nvm/inc)
+
+# Firmware sources of each test, the *.c is omitted
+declare -A SOURCES
+SOURCES[test_arena]="host_am $SRC/handlers/scratchArena"
+SOURCES[test_outbox]="host_am host_nand $SRC/handlers/mqttOutbox"
+SOURCES[test_config_journal]="host_am host_nand $SRC/handlers/configJournal"
+SOURCES[test_tls_session]="host_am host_nand $SRC/handlers/tlsSessionCache"
+SOURCES[test_spsc_ring]="host_am"
+SOURCES[test_sensor_data_encoder]="host_am $SRC/handlers/sensorDataEncoder $PROTOS/messages.pb $PROTOS/pb_common $PROTOS/pb_encode $PROTOS/pb_decode"
+SOURCES[test_ppp_link]="host_am $SRC/application/pppLink"
+SOURCES[test_ota_resume]="host_am host_nand $SRC/handlers/otaUpdate"
+SOURCES[test_ssm_status]="host_am $ASP/am-spi-protocol $ASP/am-ssm-spi-protocol"
+SOURCES[test_nand_dma]="host_am $SRC/peripheral-drivers/spi $SRC/device-drivers/MT29F1 $SRC/handlers/flashHandler"
+
+# Extra compile options
+declare -A TEST_OPTIONS
+TEST_OPTIONS[test_tls_session]="$MBEDTLS_OPTIONS"
+TEST_OPTIONS[test_sensor_data_encoder]="-DAM_BUILD"
+TEST_OPTIONS[test_ppp_link]="$LWIP_OPTIONS"
+TEST_OPTIONS[test_ota_resume]="$LWIP_OPTIONS -DAM_BUILD -I../../lib/include"
+TEST_OPTIONS[test_ssm_status]="-DAM_BUILD -I$ASP/inc"
+TEST_OPTIONS[test_nand_dma]="-DAM_BUILD -I$ASP/inc"
+
+# Extra link options, out/libmbedtls.a and out/liblwip.a are built the first time a test links them
+declare -A LINK_OPTIONS
+LINK_OPTIONS[test_tls_session]="out/libmbedtls.a"
+LINK_OPTIONS[test_ppp_link]="out/liblwip.a -Wl,--wrap=pppos_input"
+LINK_OPTIONS[test_ota_resume]="out/liblwip.a"
+LINK_OPTIONS[test_nand_dma]="-Wl,--wrap=xTaskGetTickCount"
+
+# Run in this order when no test is named
+TESTS=( "test_arena" \
+        "test_outbox" \
+        "test_config_journal" \
+        "test_tls_session" \
+        "test_spsc_ring" \
+        "test_sensor_data_encoder" \
+        "test_ppp_link" \
+        "test_ota_resume" \
+        "test_ssm_status" \
+        "test_nand_dma")
+
+mkdir -p out
+
+# The mbedTLS library sources with mbedtls_host_config.h, again only when the configuration changes
+function build_mbedtls {
+    if [ out/libmbedtls.a -nt mbedtls_host_config.h ]
+    then
+        return 0
+    fi
+    echo Building: out/libmbedtls.a
+    mkdir -p out/mbedtls
+    rm -f out/mbedtls/*.o out/libmbedtls.a
+    for FILE in $MBEDTLS/library/*.c; do
+        $CC ${GENERIC_OPTIONS[@]} -w ${INCLUDE_PATHS[@]} $MBEDTLS_OPTIONS -c $FILE -o out/mbedtls/$(basename $FILE .c).o || return 1
+    done
+    ar rcs out/libmbedtls.a out/mbedtls/*.o
+}
+
+# The lwIP core, IPv4, PPP and HTTP client sources with stubs/lwip/lwipopts.h, again only when the options change
+function build_lwip {
+    if [ out/liblwip.a -nt stubs/lwip/lwipopts.h ]
+    then
+        return 0
+    fi
+    echo Building: out/liblwip.a
+    mkdir -p out/lwip
+    rm -f out/lwip/*.o out/liblwip.a
+    for FILE in $LWIP/core/*.c $LWIP/core/ipv4/*.c $LWIP/netif/ppp/*.c $LWIP/netif/ppp/polarssl/*.c $LWIP/apps/http/http_client.c; do
+        $CC ${GENERIC_OPTIONS[@]} -w ${INCLUDE_PATHS[@]} $LWIP_OPTIONS -c $FILE -o out/lwip/$(basename $FILE .c).o || return 1
+    done
+    ar rcs out/liblwip.a out/lwip/*.o
+}
+
+if [ $# -ne 0 ]
+then
+    TESTS=( "$@" )
+fi
+
+FAILED=()
+
+for TEST in "${TESTS[@]}"; do
+    echo Running: $TEST
+    OBJECTS=()
+    for FILE in ${SOURCES[$TEST]}; do
+        OBJECTS+=($FILE.c)
+    done
+    if [[ "${LINK_OPTIONS[$TEST]}" == *libmbedtls.a* ]]
+    then
+        build_mbedtls || { FAILED+=($TEST); continue; }
+    fi
+    if [[ "${LINK_OPTIONS[$TEST]}" == *liblwip.a* ]]
+    then
+        build_lwip || { FAILED+=($TEST); continue; }
+    fi
+    BUILD_COMMAND="$CC ${GENERIC_OPTIONS[@]} ${INCLUDE_PATHS[@]} ${TEST_OPTIONS[$TEST]} -o out/$TEST $TEST.c ${OBJECTS[@]} ${LINK_OPTIONS[$TEST]} -lm"
+    echo $BUILD_COMMAND
+    $BUILD_COMMAND && out/$TEST
+    if [ $? -ne 0 ]
+    then
+        FAILED+=($TEST)
+    fi
+    echo
+done
+
+if [ ${#FAILED[@]} -ne 0 ]
+then
+    echo Failed: ${FAILED[@]}
+    exit 1
+fi
+echo All ${#TESTS[@]} tests passed
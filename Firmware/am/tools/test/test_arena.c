@@ -0,0 +1,142 @@
+/**************************************************************************************************
+* \file     test_arena.c
+* \brief    Checks of the scratch arena owner rules and the RAM it reports giving back
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_am.h"
+#include "lwipopts.h"
+#include "scratchArena.h"
+
+// Walks the arena through an OTA download, an SSM programming run and the mistakes the firmware logs
+// (a second owner, a release by the wrong owner, a request that does not fit), then runs "arena stats"
+// and checks the bytes it reports against the sizes the phases used to hold and what lwipopts.h and the
+// heap took of them.
+//
+// Usage: test_arena
+
+// sizeof(struct pbuf) on the Cortex-M4 plus the pool element rounding, what a pool pbuf really costs
+#define LWIP_PBUF_HEADER_BYTES      16u
+#define BASELINE_PBUF_POOL_SIZE     12u
+#define LWIP_PBUF_HEADERS_BYTES     54u     // link, IP and TCP headers in front of the data
+
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static uint32_t xReportedBytes(const char * p_text, const char * p_label);
+
+int main(int argc, char **argv)
+{
+    uint8_t * p_ota;
+    uint8_t * p_ssm;
+    uint32_t errors;
+    uint32_t poolGrowthBytes;
+
+    ARENA_init();
+
+    printf("arena %u bytes, ota download %u, ssm programming %u\n", ARENA_SIZE_BYTES, ARENA_OTA_DOWNLOAD_BYTES, ARENA_SSM_PROGRAMMING_BYTES);
+
+    //an OTA download with the SSM programming asking part way through
+    p_ota = ARENA_acquire(ARENA_OWNER_OTA_DOWNLOAD, ARENA_OTA_DOWNLOAD_BYTES);
+    xCheck(p_ota != NULL, "ota download gets the arena");
+    xCheck(ARENA_getOwner() == ARENA_OWNER_OTA_DOWNLOAD, "ota download owns it");
+    memset(p_ota, 0xA5, ARENA_OTA_DOWNLOAD_BYTES);
+
+    errors = HOST_GetLogCount(eLogLvlError);
+    p_ssm = ARENA_acquire(ARENA_OWNER_SSM_PROGRAMMING, ARENA_SSM_PROGRAMMING_BYTES);
+    xCheck(p_ssm == NULL, "ssm programming is refused while the download holds it");
+    xCheck(ARENA_getConflictCount() == 1u, "the conflict is counted");
+    xCheck(HOST_GetLogCount(eLogLvlError) == errors + 1u, "the conflict is logged");
+    xCheck(HOST_FindLog("ssm bsl requested while held by ota", NULL), "the log names both owners");
+
+    //releasing what it does not hold leaves the download alone
+    ARENA_release(ARENA_OWNER_SSM_PROGRAMMING);
+    xCheck(ARENA_getOwner() == ARENA_OWNER_OTA_DOWNLOAD, "a release by the wrong owner is ignored");
+    xCheck(HOST_FindLog("ssm bsl released but held by ota", NULL), "the wrong release is logged");
+
+    ARENA_release(ARENA_OWNER_OTA_DOWNLOAD);
+    xCheck(ARENA_getOwner() == ARENA_OWNER_NONE, "the download gives it back");
+
+    //the programming run gets the same RAM
+    p_ssm = ARENA_acquire(ARENA_OWNER_SSM_PROGRAMMING, ARENA_SSM_PROGRAMMING_BYTES);
+    xCheck(p_ssm == p_ota, "ssm programming reuses the download buffer");
+    ARENA_release(ARENA_OWNER_SSM_PROGRAMMING);
+
+    //a release with no owner and requests that can never be met
+    errors = HOST_GetLogCount(eLogLvlError);
+    ARENA_release(ARENA_OWNER_OTA_DOWNLOAD);
+    xCheck(HOST_GetLogCount(eLogLvlError) == errors + 1u, "a release with no owner is logged");
+    xCheck(ARENA_acquire(ARENA_OWNER_OTA_DOWNLOAD, ARENA_SIZE_BYTES + 1u) == NULL, "a request larger than the arena fails");
+    xCheck(ARENA_acquire(ARENA_OWNER_NONE, 1u) == NULL, "the none owner can not acquire");
+    xCheck(ARENA_acquire(ARENA_OWNER_MAX, 1u) == NULL, "an unknown owner can not acquire");
+    xCheck(ARENA_getOwner() == ARENA_OWNER_NONE, "failed requests take no ownership");
+    xCheck(ARENA_getHighWaterBytes() == ARENA_OTA_DOWNLOAD_BYTES, "high water is the download");
+    xCheck(ARENA_getConflictCount() == 1u, "bad requests are not conflicts");
+
+    //the report
+    xCheck(HOST_RunCommand("arena stats"), "arena stats runs");
+    xCheck(xReportedBytes("high water:", "high water:") == ARENA_OTA_DOWNLOAD_BYTES, "stats reports the high water mark");
+    xCheck(xReportedBytes("conflicts:", "conflicts:") == 1u, "stats reports the conflict");
+    xCheck(xReportedBytes("sharing saves", "sharing saves") == ARENA_SSM_PROGRAMMING_BYTES, "sharing saves the ssm page buffer");
+    xCheck(xReportedBytes("reclaimed:", "reclaimed:") == ARENA_UNSHARED_BYTES - ARENA_SIZE_BYTES, "reclaimed is the old buffers less the arena");
+    xCheck(xReportedBytes("reclaimed:", "before the arena),") + xReportedBytes("reclaimed:", "pool,") == ARENA_RECLAIMED_BYTES,
+           "the lwIP pool and the heap get all of it");
+
+    //what lwipopts.h really took has to fit in its share, and the window has to fit in the pool
+    poolGrowthBytes = (PBUF_POOL_SIZE - BASELINE_PBUF_POOL_SIZE) * (LWIP_PBUF_HEADER_BYTES + PBUF_POOL_BUFSIZE);
+    printf("  lwIP pool grew %u bytes of its %u, the heap got %u\n", poolGrowthBytes, ARENA_RECLAIMED_LWIP_BYTES, ARENA_RECLAIMED_HEAP_BYTES);
+    xCheck(poolGrowthBytes <= ARENA_RECLAIMED_LWIP_BYTES, "the pbuf pool growth fits in the lwIP share");
+    xCheck(TCP_WND <= PBUF_POOL_SIZE * (PBUF_POOL_BUFSIZE - LWIP_PBUF_HEADERS_BYTES), "a full TCP window fits in the pool");
+    xCheck(TCP_WND > 2 * TCP_MSS, "the window grew");
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// The number after p_label in the last log line with p_text in it
+static uint32_t xReportedBytes(const char * p_text, const char * p_label)
+{
+    char line[HOST_LOG_LINE_LEN];
+    char * p_value;
+
+    if ( (HOST_FindLog(p_text, line) == false) || ((p_value = strstr(line, p_label)) == NULL) )
+    {
+        return UINT32_MAX;
+    }
+
+    return (uint32_t)strtoul(p_value + strlen(p_label), NULL, 10);
+}
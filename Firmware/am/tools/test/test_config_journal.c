@@ -0,0 +1,290 @@
+/**************************************************************************************************
+* \file     test_config_journal.c
+* \brief    Power cut at every erase and page program of the config journal
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_am.h"
+#include "host_nand.h"
+#include "configJournal.h"
+
+// Builds configJournal.c over the simulated NAND and runs a fixed workload the way memMapHandler.c uses
+// it: counters bumped, a few flags changed, now and then most of the image rewritten, and a compaction
+// every COMPACT_EVERY commits as before standby. That is less often than a block fills up, so commits
+// compact on their own too. The clean run counts its erases and page programs, then the workload is run
+// again once for every one of those steps with the power lost on it.
+//
+// After each cut the journal starts over from NAND and has to read back either the image last committed
+// or the one being committed, never a mix and never an older one. The generation must not go back. The
+// journal then carries on with more commits, with a second cut a few steps in, and must still read back
+// what was committed. No page may be programmed twice without an erase.
+//
+// Usage: test_config_journal
+
+#define IMAGE_LEN                   362u        // deviceInfo_t
+#define NUM_COMMITS                 300u
+#define COMPACT_EVERY               90u
+#define REBOOT_EVERY                71u
+#define AFTER_CUT_COMMITS           150u
+#define SECOND_CUT_WITHIN           16u
+#define WORKLOAD_SEED               12345u
+
+static uint8_t xImage[IMAGE_LEN];
+static uint8_t xCommitted[IMAGE_LEN];
+static uint8_t xInFlight[IMAGE_LEN];
+static uint32_t xGenerationBefore = 0u;
+static uint32_t xSelfCompactions = 0u;
+static uint32_t xRandom = WORKLOAD_SEED;
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static bool xWorkload(void);
+static bool xCommit(bool compact);
+static bool xRestart(void);
+static void xMutate(void);
+static uint32_t xNextRandom(uint32_t range);
+
+int main(void)
+{
+    volatile uint32_t cutStep;
+    volatile uint32_t cuts;
+    volatile bool isSecondCut;
+    uint32_t steps;
+    uint32_t rolledBack = 0u;
+    uint32_t completed = 0u;
+    uint32_t lost = 0u;
+    uint32_t wentBack = 0u;
+    uint32_t lostAfter = 0u;
+    uint32_t k;
+
+    //the clean run, which also sets how many steps there are to cut
+    HOST_NandReset(0x5A);
+    HOST_ClearLog();
+    xCheck(xWorkload() == true, "the clean run reads back every commit");
+    steps = HOST_NandGetSteps();
+
+    printf("  clean run: %u commits, %u erases, %u page programs, generation %u\n", NUM_COMMITS, HOST_NandGetErases(), HOST_NandGetPrograms(), CFGJ_getGeneration());
+    xCheck(HOST_NandGetViolations() == 0u, "no page is programmed twice without an erase");
+
+    for ( k = 0u; k < steps; k++ )
+    {
+        HOST_NandReset(0x5A);
+        cutStep = k;
+        cuts = 0u;
+        isSecondCut = false;
+
+        if ( setjmp(hostNandPowerCut) != 0 )
+        {
+            cuts++;
+            xRestart();
+
+            if ( isSecondCut == true )
+            {
+                //cut while carrying on, only the committed or the in-flight image is acceptable again
+                lostAfter += ( (memcmp(xImage, xCommitted, IMAGE_LEN) != 0) && (memcmp(xImage, xInFlight, IMAGE_LEN) != 0) ) ? 1u : 0u;
+                memcpy(xCommitted, xImage, IMAGE_LEN);
+            }
+            else
+            {
+                if ( memcmp(xImage, xCommitted, IMAGE_LEN) == 0 )
+                {
+                    rolledBack++;
+                }
+                else if ( memcmp(xImage, xInFlight, IMAGE_LEN) == 0 )
+                {
+                    completed++;
+                }
+                else
+                {
+                    printf("  cut at step %u: the image read back is neither the old nor the new one\n", k);
+                    lost++;
+                }
+
+                wentBack += ((int32_t)(CFGJ_getGeneration() - xGenerationBefore) < 0) ? 1u : 0u;
+                memcpy(xCommitted, xImage, IMAGE_LEN);
+
+                //carry on from there, and lose the power again a few steps in
+                isSecondCut = true;
+                HOST_NandCutAt(xNextRandom(SECOND_CUT_WITHIN));
+            }
+
+            for ( uint32_t i = 0u; i < AFTER_CUT_COMMITS; i++ )
+            {
+                xMutate();
+
+                if ( xCommit((i % COMPACT_EVERY) == (COMPACT_EVERY - 1u)) == false )
+                {
+                    lostAfter++;
+                    break;
+                }
+            }
+
+            HOST_NandCutAt(UINT32_MAX);
+            lostAfter += (xRestart() == false) ? 1u : 0u;
+        }
+        else
+        {
+            HOST_NandCutAt(cutStep);
+            xWorkload();
+        }
+
+        if ( cuts == 0u )
+        {
+            printf("  step %u was never reached\n", k);
+            lost++;
+        }
+
+        if ( HOST_NandGetViolations() != 0u )
+        {
+            printf("  cut at step %u: a page was programmed twice without an erase\n", k);
+            lost++;
+        }
+    }
+
+    printf("  power lost at each of %u steps: %u rolled back, %u completed, %u lost\n", steps, rolledBack, completed, lost);
+    xCheck(lost == 0u, "a cut at any step leaves the old or the new image");
+    xCheck(wentBack == 0u, "the generation never goes back");
+    xCheck(lostAfter == 0u, "the journal carries on after a cut, and after a second one");
+    xCheck(xSelfCompactions > 0u, "commits compact a full block on their own");
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// The same commits every time, from a blank journal. Returns false if anything read back differs.
+static bool xWorkload(void)
+{
+    bool ok = true;
+    uint32_t i;
+
+    xRandom = WORKLOAD_SEED;
+    memset(xImage, 0, sizeof(xImage));
+    memset(xCommitted, 0, sizeof(xCommitted));
+    memset(xInFlight, 0, sizeof(xInFlight));
+    xGenerationBefore = 0u;
+    xRestart();
+
+    for ( i = 0u; i < NUM_COMMITS; i++ )
+    {
+        xMutate();
+        ok &= xCommit((i % COMPACT_EVERY) == (COMPACT_EVERY - 1u));
+
+        if ( (i % REBOOT_EVERY) == 0u )
+        {
+            ok &= xRestart();
+        }
+    }
+
+    return ( ok & xRestart() );
+}
+
+// Commit or compact xImage, which is in flight until the call returns
+static bool xCommit(bool compact)
+{
+    cfgjResult_t result = CFGJ_SUCCESS;
+    bool ok;
+
+    memcpy(xInFlight, xImage, IMAGE_LEN);
+    xGenerationBefore = CFGJ_getGeneration();
+
+    if ( compact == true )
+    {
+        ok = CFGJ_compact(xImage, IMAGE_LEN);
+    }
+    else
+    {
+        result = CFGJ_commit(xImage, IMAGE_LEN);
+        ok = (result != CFGJ_ERROR);
+        xSelfCompactions += (result == CFGJ_COMPACTED) ? 1u : 0u;
+    }
+
+    memcpy(xCommitted, xImage, IMAGE_LEN);
+
+    return ok;
+}
+
+// A reset, the journal rebuilds the image from NAND. Returns false if it is not the one last committed.
+static bool xRestart(void)
+{
+    if ( (CFGJ_init(IMAGE_LEN) == false) || (CFGJ_read(xImage, IMAGE_LEN) == false) )
+    {
+        //nothing stored yet, the configs start from defaults
+        memset(xImage, 0, sizeof(xImage));
+    }
+
+    return ( memcmp(xImage, xCommitted, IMAGE_LEN) == 0 );
+}
+
+// Most commits bump a counter, some change a couple of settings and a few rewrite most of the image
+static void xMutate(void)
+{
+    uint32_t kind = xNextRandom(10u);
+    uint32_t offset;
+    uint32_t value;
+    uint32_t i;
+
+    if ( kind < 6u )
+    {
+        offset = xNextRandom(IMAGE_LEN - sizeof(value));
+        memcpy(&value, &xImage[offset], sizeof(value));
+        value++;
+        memcpy(&xImage[offset], &value, sizeof(value));
+    }
+    else if ( kind < 9u )
+    {
+        xImage[xNextRandom(IMAGE_LEN)] ^= (uint8_t)(1u + xNextRandom(255u));
+        xImage[xNextRandom(IMAGE_LEN)] ^= (uint8_t)(1u + xNextRandom(255u));
+    }
+    else
+    {
+        for ( i = 0u; i < IMAGE_LEN; i++ )
+        {
+            if ( xNextRandom(3u) == 0u )
+            {
+                xImage[i] = (uint8_t)xNextRandom(256u);
+            }
+        }
+    }
+}
+
+static uint32_t xNextRandom(uint32_t range)
+{
+    xRandom = (xRandom * 1103515245u) + 12345u;
+
+    return ((xRandom >> 16) % range);
+}
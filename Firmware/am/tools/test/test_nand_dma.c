@@ -0,0 +1,737 @@
+/**************************************************************************************************
+* \file     test_nand_dma.c
+* \brief    Host test of the NAND SPI/DMA path and the MT29F1 command sequences
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_am.h"
+#include "stm32l4xx_hal.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#include "spi.h"
+#include "MT29F1.h"
+#include "flashHandler.h"
+
+// spi.c, MT29F1.c and flashHandler.c over a model of SPI1, its DMA and an MT29F1 NAND. The model decodes
+// every command between CS low and CS high. It keeps the cache register, the data register and the array,
+// and stays busy for tRD, tPROG and tERS after the commands that start them. Any command but GET FEATURE
+// while the part is busy, program or erase without WRITE ENABLE or on locked blocks, a cache read sequence
+// that leaves its block and programming a page twice without an erase are counted as violations.
+//
+// Time is simulated in ns. A byte is 8 clocks of SPI1 at 60 MHz (PCLK2 / 2). A polled transfer keeps the
+// CPU for the HAL call and the whole transfer, a DMA transfer only for the setup, the task sleeps on the
+// DMA semaphore while the bytes go. The DMA completes at once through the HAL callbacks unless a test drops
+// the completion or turns it into an error, then the firmware's wait times out in real time (100 ms).
+// xTaskGetTickCount in the firmware is wrapped to the simulated ms and vTaskDelay moves it to the next tick.
+//
+// The "before" figures are a whole block read the way the driver did it before the cache read and the DMA:
+// a PAGE READ per page (a part without the cache read ID), with the page data clocked out polled so the CPU
+// time is the bus time.
+//
+// Usage: test_nand_dma
+
+#define SPI_BYTE_NS             133u        // 8 clocks at 60 MHz
+#define POLL_CALL_NS            2000u       // a polled HAL_SPI_Transmit/Receive with the bus mutex
+#define DMA_SETUP_NS            5000u       // starting the DMA, the semaphore and the switch back to the task
+#define T_RD_NS                 25000u      // typical times of the part
+#define T_RCBSY_NS              3000u
+#define T_PROG_NS               200000u
+#define T_ERS_NS                2000000u
+#define NS_PER_TICK             1000000u
+#define SPIN_POLLS              128u        // BUSY_SPIN_POLLS in MT29F1.c
+#define OTHER_DEVICE_ID         0x2C12u
+#define TEST_BLOCK              5u
+#define FRAME_BYTES             (8u + PAGE_DATA_SIZE)
+#define LOG_BYTES               256u
+#define NO_ROW                  0xFFFFFFFFul
+#define LOCK_BITS               (SPI_NAND_BP2 | SPI_NAND_BP1 | SPI_NAND_BP0)
+
+typedef enum
+{
+    DMA_COMPLETES,
+    DMA_FAILS,
+    DMA_DROPPED,
+    DMA_LATE,           // the completion comes as the transfer is aborted
+}dmaMode_t;
+
+// Simulated and CPU time of one run
+typedef struct
+{
+    uint64_t elapsedNs;
+    uint64_t cpuNs;
+    uint32_t sleeps;
+}run_t;
+
+extern SPI_HandleTypeDef hspi1;
+
+GPIO_TypeDef HOST_GpioA;
+GPIO_TypeDef HOST_GpioB;
+GPIO_TypeDef HOST_GpioE;
+SPI_TypeDef HOST_Spi1;
+SPI_TypeDef HOST_Spi2;
+DMA_Channel_TypeDef HOST_Dma1Channel[8];
+
+static bool xPass = true;
+
+// the part
+static uint8_t * xArray[NUM_BLOCKS];
+static bool xProgrammed[NUM_BLOCKS][NUM_PAGE_BLOCK];
+static uint8_t xCache[PAGE_DATA_SIZE];
+static uint32_t xDataRegRow = NO_ROW;
+static uint64_t xDataRegReadyNs = 0u;
+static uint64_t xBusyUntilNs = 0u;
+static bool xWel = false;
+static uint8_t xBlockLock = LOCK_BITS;
+static uint16_t xDeviceId = MT29F1_CACHE_READ_DEVICE_ID;
+static uint32_t xErases = 0u;
+static uint32_t xPrograms = 0u;
+static uint32_t xViolations = 0u;
+
+// the bus
+static bool xCsLow = false;
+static uint8_t xFrame[FRAME_BYTES];
+static uint32_t xFrameLen = 0u;
+static uint32_t xFrames = 0u;
+static uint8_t xLog[LOG_BYTES];
+static uint32_t xLogLen = 0u;
+static dmaMode_t xDmaMode = DMA_COMPLETES;
+static bool xDmaPolled = false;
+static SPI_HandleTypeDef * xPendingDma = NULL;
+static uint32_t xDmaTransfers = 0u;
+static uint32_t xAborts = 0u;
+
+// time
+static uint64_t xNowNs = 0u;
+static uint64_t xCpuNs = 0u;
+static uint32_t xSleeps = 0u;
+static uint32_t xOpBusyPolls = 0u;
+static uint32_t xOpSleeps = 0u;
+static uint32_t xOpSpinPolls = 0u;
+
+static void xCheck(bool condition, const char * p_what);
+static void xViolation(const char * p_what);
+static bool xBusy(void);
+static uint8_t * xPage(uint32_t row);
+static void xStartOp(uint64_t busyNs);
+static void xExecute(void);
+static void xBusTime(uint32_t len, bool dma);
+static void xShift(const uint8_t * p_data, uint16_t len);
+static void xShiftIn(uint8_t * p_data, uint16_t len);
+static HAL_StatusTypeDef xDmaEnd(SPI_HandleTypeDef * hspi, bool rx);
+static uint8_t xPattern(uint32_t addr);
+static bool xIsPattern(uint32_t addr, const uint8_t * p_data, uint32_t len);
+static uint32_t xRow(uint32_t block, uint32_t page);
+static bool xLogIs(const uint8_t * p_expected, uint32_t len);
+static void xStartRun(run_t * p_run);
+static void xEndRun(run_t * p_run);
+static spiStatus_t xReadCacheFrame(uint8_t * p_data);
+
+int main(int argc, char **argv)
+{
+    static uint8_t page[NUM_PAGE_BLOCK * PAGE_DATA_SIZE];
+    static const uint8_t fourPages[] = { 0x13, 0x31, 0x03, 0x31, 0x03, 0x31, 0x03, 0x3F, 0x03 };
+    static const uint8_t onePage[] = { 0x13, 0x03 };
+    static const uint8_t perPage[] = { 0x1F, 0x13, 0x03, 0x13, 0x03 };
+    uint32_t addr = BLOCK_2_ADDRESS(TEST_BLOCK);
+    uint32_t frames;
+    uint32_t aborts;
+    uint32_t programs;
+    uint32_t p;
+    bool programsSpin = true;
+    bool programsGood = true;
+    run_t run;
+    run_t before;
+    run_t after;
+
+    SPI_Init();
+    FLASH_init();
+    xCheck(HOST_FindLog("cache read on", NULL) == true, "the part with the cache read ID turns the cache read on");
+
+    // erase two blocks, the wait spins for the typical times and sleeps when it runs longer
+    xStartRun(&run);
+    xCheck(FLASH_erase(addr, 2u * BLOCK_SIZE) == FLASH_SUCCESS, "two blocks erase");
+    xEndRun(&run);
+    printf("  erase: %u busy polls before the first sleep, %u sleeps, CPU %.0f of %.0f us\n",
+           xOpSpinPolls, run.sleeps, run.cpuNs / 1000.0, run.elapsedNs / 1000.0);
+    xCheck((xErases == 2u) && (xOpSpinPolls == (SPIN_POLLS + 1u)) && (xOpSleeps != 0u),
+           "an erase spins BUSY_SPIN_POLLS polls and then sleeps a tick between polls");
+    xCheck((run.cpuNs * 2u) < run.elapsedNs, "the erase gives the CPU away for most of tERS");
+
+    for ( p = 0u; p < (2u * NUM_PAGE_BLOCK); p++ )
+    {
+        uint32_t pageAddr = addr + (p * PAGE_DATA_SIZE);
+        uint32_t sleeps = xSleeps;
+
+        for ( uint32_t i = 0u; i < PAGE_DATA_SIZE; i++ )
+        {
+            page[i] = xPattern(pageAddr + i);
+        }
+        programsGood &= (FLASH_programPage(pageAddr, page, PAGE_DATA_SIZE) == FLASH_SUCCESS);
+        programsSpin &= (xSleeps == sleeps);
+    }
+    xCheck((programsGood == true) && (xPrograms == (2u * NUM_PAGE_BLOCK)), "128 pages program");
+    xCheck(programsSpin == true, "a typical tPROG is covered by the spin, a program never sleeps");
+
+    // the command order of a sequential read
+    xLogLen = 0u;
+    xCheck(FlashPageReadSequential(xRow(TEST_BLOCK, 8u), page, 4u) == Flash_Success, "4 pages read with the cache read");
+    xCheck(xLogIs(fourPages, sizeof(fourPages)) == true, "13h, then 31h or 3Fh before each 03h, 3Fh last");
+    xCheck(xIsPattern(addr + (8u * PAGE_DATA_SIZE), page, 4u * PAGE_DATA_SIZE) == true, "the 4 pages read back");
+
+    xLogLen = 0u;
+    xCheck(FlashPageReadSequential(xRow(TEST_BLOCK, 63u), page, 1u) == Flash_Success, "a single page reads");
+    xCheck(xLogIs(onePage, sizeof(onePage)) == true, "a single page is 13h and 03h");
+    xCheck(xIsPattern(addr + (63u * PAGE_DATA_SIZE), page, PAGE_DATA_SIZE) == true, "the last page of the block reads back");
+
+    // a sequence can not leave its block, nothing goes on the bus
+    frames = xFrames;
+    xCheck(FlashPageReadSequential(xRow(TEST_BLOCK, 60u), page, 5u) == Flash_AddressInvalid, "a read from page 60 to 64 is rejected");
+    xCheck(FlashPageReadSequential(xRow(TEST_BLOCK, 0u), page, 65u) == Flash_AddressInvalid, "a read of 65 pages is rejected");
+    xCheck(FlashPageReadSequential(xRow(TEST_BLOCK, 0u), page, 0u) == Flash_AddressInvalid, "a read of 0 pages is rejected");
+    xCheck(xFrames == frames, "a rejected read sends nothing");
+    xCheck(FlashPageReadSequential(xRow(TEST_BLOCK, 60u), page, 4u) == Flash_Success, "a read from page 60 to the end of the block is fine");
+
+    // across the block boundary FLASH_read splits into a sequence per block
+    memset(page, 0, sizeof(page));
+    xCheck(FLASH_read(addr + (62u * PAGE_DATA_SIZE) + 100u, page, 3u * PAGE_DATA_SIZE) == FLASH_SUCCESS, "a read over the block boundary");
+    xCheck(xIsPattern(addr + (62u * PAGE_DATA_SIZE) + 100u, page, 3u * PAGE_DATA_SIZE) == true, "reads back");
+
+    // a whole block, cache read with DMA, then the per page read with the data polled
+    memset(page, 0, sizeof(page));
+    xStartRun(&after);
+    xCheck(FLASH_read(addr, page, BLOCK_SIZE) == FLASH_SUCCESS, "a block reads with the cache read and DMA");
+    xEndRun(&after);
+    xCheck(xIsPattern(addr, page, BLOCK_SIZE) == true, "the block reads back");
+
+    xDeviceId = OTHER_DEVICE_ID;
+    FLASH_init();
+    xCheck(HOST_FindLog("cache read off", NULL) == true, "another part keeps the PAGE READ per page");
+    xLogLen = 0u;
+    xCheck(FLASH_read(addr, page, 2u * PAGE_DATA_SIZE) == FLASH_SUCCESS, "2 pages read a page at a time");
+    xCheck(xLogIs(perPage, sizeof(perPage)) == true, "the unlock, then 13h and 03h for each page");
+
+    memset(page, 0, sizeof(page));
+    xDmaPolled = true;
+    xStartRun(&before);
+    xCheck(FLASH_read(addr, page, BLOCK_SIZE) == FLASH_SUCCESS, "a block reads a page at a time, polled");
+    xEndRun(&before);
+    xCheck(xIsPattern(addr, page, BLOCK_SIZE) == true, "the block reads back");
+    xDmaPolled = false;
+    xDeviceId = MT29F1_CACHE_READ_DEVICE_ID;
+    FLASH_init();
+
+    printf("  128 kB block, before: %.2f ms, %.2f MB/s, CPU %.2f ms\n", before.elapsedNs / 1e6,
+           (BLOCK_SIZE * 1e3) / before.elapsedNs, before.cpuNs / 1e6);
+    printf("  128 kB block, after:  %.2f ms, %.2f MB/s, CPU %.2f ms\n", after.elapsedNs / 1e6,
+           (BLOCK_SIZE * 1e3) / after.elapsedNs, after.cpuNs / 1e6);
+    xCheck((after.sleeps == 0u) && (before.sleeps == 0u), "a page read never sleeps, tRD is covered by the spin");
+    xCheck(after.elapsedNs < before.elapsedNs, "the cache read is quicker");
+    xCheck((after.cpuNs * 10u) < before.cpuNs, "with DMA the read takes a tenth of the CPU or less");
+
+    // the DMA reports an error
+    HOST_ClearLog();
+    aborts = xAborts;
+    xDmaMode = DMA_FAILS;
+    xCheck(xReadCacheFrame(page) == spiError, "a DMA error fails the transfer");
+    xCheck((xAborts == aborts) && (xCsLow == false), "without an abort, CS goes back high");
+
+    // the completion never comes
+    xDmaMode = DMA_DROPPED;
+    xCheck(xReadCacheFrame(page) == spiError, "a DMA that never completes times out");
+    xCheck((xAborts == (aborts + 1u)) && (xCsLow == false), "the transfer is aborted, CS goes back high");
+    xCheck(HOST_FindLog("NAND DMA timeout", NULL) == true, "the timeout is logged");
+    xCheck(FlashPageReadSequential(xRow(TEST_BLOCK, 0u), page, 2u) == Flash_OperationTimeOut, "a sequential read with a lost DMA fails");
+    xCheck(FlashPageRead(xRow(TEST_BLOCK, 0u), page) == Flash_OperationTimeOut, "so does a page read");
+
+    // the completion races the abort, it must not end the next transfer
+    xDmaMode = DMA_LATE;
+    aborts = xAborts;
+    xCheck(xReadCacheFrame(page) == spiError, "a DMA that completes as it is aborted still times out");
+    xDmaMode = DMA_DROPPED;
+    xCheck(xReadCacheFrame(page) == spiError, "the late completion is not taken for the next transfer");
+    xCheck(xAborts == (aborts + 2u), "both transfers are aborted");
+
+    // page data that did not all go out is not programmed
+    programs = xPrograms;
+    xDmaMode = DMA_FAILS;
+    xCheck(FLASH_programPage(addr + (2u * BLOCK_SIZE), page, PAGE_DATA_SIZE) == FLASH_SPI_ERR, "a program with a DMA error fails");
+    xCheck(xPrograms == programs, "and does not send PROGRAM EXECUTE");
+
+    xDmaMode = DMA_COMPLETES;
+    memset(page, 0, sizeof(page));
+    xCheck(FlashPageReadSequential(xRow(TEST_BLOCK, 0u), page, 2u) == Flash_Success, "the next read after the timeouts works");
+    xCheck(xIsPattern(addr, page, 2u * PAGE_DATA_SIZE) == true, "and reads back");
+
+    printf("  %u frames, %u DMA transfers, %u erases, %u page programs\n", xFrames, xDmaTransfers, xErases, xPrograms);
+    xCheck(xViolations == 0u, "no command while busy, no program or erase without WRITE ENABLE, no sequence leaves its block");
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+static void xViolation(const char * p_what)
+{
+    if ( xViolations < 10u )
+    {
+        printf("  violation: %s\n", p_what);
+    }
+    xViolations++;
+}
+
+static bool xBusy(void)
+{
+    return (xNowNs < xBusyUntilNs);
+}
+
+// A page of the array, erased until it is programmed
+static uint8_t * xPage(uint32_t row)
+{
+    uint32_t block = row / NUM_PAGE_BLOCK;
+
+    if ( xArray[block] == NULL )
+    {
+        xArray[block] = malloc(BLOCK_SIZE);
+        memset(xArray[block], 0xFF, BLOCK_SIZE);
+    }
+
+    return &xArray[block][(row % NUM_PAGE_BLOCK) * PAGE_DATA_SIZE];
+}
+
+static void xStartOp(uint64_t busyNs)
+{
+    xBusyUntilNs = xNowNs + busyNs;
+    xOpBusyPolls = 0u;
+    xOpSleeps = 0u;
+    xOpSpinPolls = 0u;
+}
+
+// CS went high, run the command of the frame
+static void xExecute(void)
+{
+    uint32_t row = ((uint32_t)xFrame[2] << 8) | xFrame[3];
+    uint32_t col = (((uint32_t)xFrame[1] << 8) | xFrame[2]) & 0x0FFFu;
+    uint8_t cmd = xFrame[0];
+    uint64_t start;
+    uint32_t i;
+
+    xFrames++;
+    if ( (cmd != SPI_NAND_GET_FEATURE_INS) && (xLogLen < LOG_BYTES) )
+    {
+        xLog[xLogLen++] = cmd;
+    }
+
+    switch ( cmd )
+    {
+        case SPI_NAND_WRITE_ENABLE:
+            xWel = true;
+            break;
+
+        case SPI_NAND_WRITE_DISABLE:
+            xWel = false;
+            break;
+
+        case SPI_NAND_SET_FEATURE:
+            if ( xFrame[1] == SPI_NAND_BLKLOCK_REG_ADDR )
+            {
+                xBlockLock = xFrame[2];
+            }
+            break;
+
+        case SPI_NAND_PAGE_READ_INS:
+            memcpy(xCache, xPage(row), PAGE_DATA_SIZE);
+            xStartOp(T_RD_NS);
+            xDataRegRow = row;
+            xDataRegReadyNs = xBusyUntilNs;
+            break;
+
+        case SPI_NAND_PAGE_READ_CACHE_SEQ_INS:
+        case SPI_NAND_PAGE_READ_CACHE_LAST_INS:
+            if ( xDataRegRow == NO_ROW )
+            {
+                xViolation("a cache read without a PAGE READ");
+                break;
+            }
+            //the page in the data register goes to the cache, 31h starts the next one
+            start = (xNowNs > xDataRegReadyNs) ? xNowNs : xDataRegReadyNs;
+            memcpy(xCache, xPage(xDataRegRow), PAGE_DATA_SIZE);
+            xStartOp((start - xNowNs) + T_RCBSY_NS);
+            if ( cmd == SPI_NAND_PAGE_READ_CACHE_LAST_INS )
+            {
+                xDataRegRow = NO_ROW;
+            }
+            else if ( ((xDataRegRow + 1u) % NUM_PAGE_BLOCK) == 0u )
+            {
+                xViolation("a cache read leaves its block");
+                xDataRegRow = NO_ROW;
+            }
+            else
+            {
+                xDataRegRow++;
+                xDataRegReadyNs = xBusyUntilNs + T_RD_NS;
+            }
+            break;
+
+        case SPI_NAND_PROGRAM_LOAD_INS:
+            if ( xWel == false )
+            {
+                xViolation("PROGRAM LOAD without WRITE ENABLE");
+            }
+            memset(xCache, 0xFF, PAGE_DATA_SIZE);
+            for ( i = 3u; (i < xFrameLen) && ((col + i - 3u) < PAGE_DATA_SIZE); i++ )
+            {
+                xCache[col + i - 3u] = xFrame[i];
+            }
+            break;
+
+        case SPI_NAND_PROGRAM_EXEC_INS:
+            if ( (xWel == false) || ((xBlockLock & LOCK_BITS) != 0u) )
+            {
+                xViolation("PROGRAM EXECUTE without WRITE ENABLE or on a locked block");
+                break;
+            }
+            if ( xProgrammed[row / NUM_PAGE_BLOCK][row % NUM_PAGE_BLOCK] == true )
+            {
+                xViolation("a page programmed twice without an erase");
+            }
+            for ( i = 0u; i < PAGE_DATA_SIZE; i++ )
+            {
+                xPage(row)[i] &= xCache[i];
+            }
+            xProgrammed[row / NUM_PAGE_BLOCK][row % NUM_PAGE_BLOCK] = true;
+            xPrograms++;
+            xWel = false;
+            xStartOp(T_PROG_NS);
+            break;
+
+        case SPI_NAND_BLOCK_ERASE_INS:
+            if ( (xWel == false) || ((xBlockLock & LOCK_BITS) != 0u) )
+            {
+                xViolation("BLOCK ERASE without WRITE ENABLE or on a locked block");
+                break;
+            }
+            memset(xPage(row - (row % NUM_PAGE_BLOCK)), 0xFF, BLOCK_SIZE);
+            memset(xProgrammed[row / NUM_PAGE_BLOCK], 0, sizeof(xProgrammed[0]));
+            xErases++;
+            xWel = false;
+            xStartOp(T_ERS_NS);
+            break;
+
+        case SPI_NAND_RESET:
+            xDataRegRow = NO_ROW;
+            xWel = false;
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Bus and CPU time of a transfer
+static void xBusTime(uint32_t len, bool dma)
+{
+    uint64_t bus = (uint64_t)len * SPI_BYTE_NS;
+
+    if ( (dma == false) || (xDmaPolled == true) )
+    {
+        xNowNs += POLL_CALL_NS + bus;
+        xCpuNs += POLL_CALL_NS + bus;
+    }
+    else
+    {
+        xNowNs += DMA_SETUP_NS + bus;
+        xCpuNs += DMA_SETUP_NS;
+    }
+}
+
+static void xShift(const uint8_t * p_data, uint16_t len)
+{
+    uint16_t i;
+
+    if ( xCsLow == false )
+    {
+        xViolation("bytes sent with CS high");
+        return;
+    }
+
+    if ( (xFrameLen == 0u) && (len != 0u) && (p_data[0] != SPI_NAND_GET_FEATURE_INS) && (xBusy() == true) )
+    {
+        xViolation("a command while the part is busy");
+    }
+
+    for ( i = 0u; (i < len) && (xFrameLen < FRAME_BYTES); i++ )
+    {
+        xFrame[xFrameLen++] = p_data[i];
+    }
+}
+
+static void xShiftIn(uint8_t * p_data, uint16_t len)
+{
+    uint32_t col = (((uint32_t)xFrame[1] << 8) | xFrame[2]) & 0x0FFFu;
+    uint8_t status;
+
+    memset(p_data, 0xFF, len);
+
+    switch ( xFrame[0] )
+    {
+        case SPI_NAND_GET_FEATURE_INS:
+            if ( xFrame[1] == SPI_NAND_STATUS_REG_ADDR )
+            {
+                status = ((xBusy() == true) ? SPI_NAND_OIP : 0u) | ((xWel == true) ? SPI_NAND_WE : 0u);
+                if ( xBusy() == true )
+                {
+                    xOpBusyPolls++;
+                }
+                memset(p_data, status, len);
+            }
+            else if ( xFrame[1] == SPI_NAND_BLKLOCK_REG_ADDR )
+            {
+                memset(p_data, xBlockLock, len);
+            }
+            break;
+
+        case SPI_NAND_READ_ID:
+            p_data[0] = (uint8_t)(xDeviceId >> 8);
+            if ( len > 1u )
+            {
+                p_data[1] = (uint8_t)xDeviceId;
+            }
+            break;
+
+        case SPI_NAND_READ_CACHE_INS:
+            if ( col < PAGE_DATA_SIZE )
+            {
+                memcpy(p_data, &xCache[col], ((col + len) > PAGE_DATA_SIZE) ? (PAGE_DATA_SIZE - col) : len);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+// The DMA interrupt, or not
+static HAL_StatusTypeDef xDmaEnd(SPI_HandleTypeDef * hspi, bool rx)
+{
+    xDmaTransfers++;
+
+    switch ( xDmaMode )
+    {
+        case DMA_COMPLETES:
+            (rx == true) ? HAL_SPI_RxCpltCallback(hspi) : HAL_SPI_TxCpltCallback(hspi);
+            break;
+
+        case DMA_FAILS:
+            HAL_SPI_ErrorCallback(hspi);
+            break;
+
+        default:
+            xPendingDma = hspi;
+            break;
+    }
+
+    return HAL_OK;
+}
+
+static uint8_t xPattern(uint32_t addr)
+{
+    return (uint8_t)((addr * 7u) ^ (addr >> 11));
+}
+
+static bool xIsPattern(uint32_t addr, const uint8_t * p_data, uint32_t len)
+{
+    uint32_t i;
+
+    for ( i = 0u; i < len; i++ )
+    {
+        if ( p_data[i] != xPattern(addr + i) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static uint32_t xRow(uint32_t block, uint32_t page)
+{
+    uint32_t row = 0u;
+
+    Build_RowAddressNoCmd(block, page, &row);
+    return row;
+}
+
+static bool xLogIs(const uint8_t * p_expected, uint32_t len)
+{
+    return (xLogLen == len) && (memcmp(xLog, p_expected, len) == 0);
+}
+
+static void xStartRun(run_t * p_run)
+{
+    p_run->elapsedNs = xNowNs;
+    p_run->cpuNs = xCpuNs;
+    p_run->sleeps = xSleeps;
+}
+
+static void xEndRun(run_t * p_run)
+{
+    p_run->elapsedNs = xNowNs - p_run->elapsedNs;
+    p_run->cpuNs = xCpuNs - p_run->cpuNs;
+    p_run->sleeps = xSleeps - p_run->sleeps;
+}
+
+// READ FROM CACHE of a whole page, straight through SPI_nandTransfer
+static spiStatus_t xReadCacheFrame(uint8_t * p_data)
+{
+    uint8_t cmd[4] = { SPI_NAND_READ_CACHE_INS, 0u, 0u, 0u };
+    spiData_t send = { .pChar = cmd, .length = sizeof(cmd) };
+    spiData_t recv = { .pChar = p_data, .length = PAGE_DATA_SIZE };
+
+    return SPI_nandTransfer(&send, &recv, OpsEndTransfer);
+}
+
+// The HAL and the kernel under the firmware
+
+TickType_t __wrap_xTaskGetTickCount(void)
+{
+    return (TickType_t)(xNowNs / NS_PER_TICK);
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    if ( xOpSleeps == 0u )
+    {
+        xOpSpinPolls = xOpBusyPolls;
+    }
+    xOpSleeps++;
+    xSleeps++;
+    xNowNs = ((xNowNs / NS_PER_TICK) + xTicksToDelay) * NS_PER_TICK;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if ( (GPIOx != MT28F1_CS_PORT) || (GPIO_Pin != MT28F1_CS_PIN) )
+    {
+        return;
+    }
+
+    if ( PinState == GPIO_PIN_RESET )
+    {
+        //a transfer that keeps CS low carries on the same frame
+        if ( xCsLow == false )
+        {
+            xCsLow = true;
+            xFrameLen = 0u;
+        }
+    }
+    else if ( xCsLow == true )
+    {
+        xCsLow = false;
+        if ( xFrameLen != 0u )
+        {
+            xExecute();
+        }
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return GPIO_PIN_SET;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    xShift(pData, Size);
+    xBusTime(Size, false);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    xShiftIn(pData, Size);
+    xBusTime(Size, false);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size)
+{
+    xShift(pData, Size);
+    xBusTime(Size, true);
+    return xDmaEnd(hspi, false);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size)
+{
+    xShiftIn(pData, Size);
+    xBusTime(Size, true);
+    return xDmaEnd(hspi, true);
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi)
+{
+    xAborts++;
+
+    if ( (xDmaMode == DMA_LATE) && (xPendingDma == hspi) )
+    {
+        HAL_SPI_RxCpltCallback(hspi);
+    }
+    xPendingDma = NULL;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef *hspi)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma)
+{
+    return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return 120000000u;
+}
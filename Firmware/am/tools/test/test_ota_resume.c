@@ -0,0 +1,756 @@
+/**************************************************************************************************
+* \file     test_ota_resume.c
+* \brief    Host test of the OTA download resume against a local HTTP server
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_am.h"
+#include "host_nand.h"
+#include "lwip/init.h"
+#include "lwip/timeouts.h"
+#include "lwip/netif.h"
+#include "lwip/dns.h"
+#include "lwip/tcp.h"
+#include "MT29F1.h"
+#include "memoryMap.h"
+#include "memMapHandler.h"
+#include "eventManager.h"
+#include "scratchArena.h"
+#include "otaUpdate.h"
+
+// otaUpdate.c with the HTTP client over lwIP's TCP against a small HTTP server on the loopback interface,
+// in one lwIP core. The download task runs inline on this thread: its waits and delays run lwIP one
+// virtual ms at a time, so the retry delays cost nothing. The image slots and the progress block are in
+// host_nand.c. The scratch arena is a static buffer here, scratchArena.c checks its size against the
+// firmware's lwipopts.h.
+//
+// The server honours "Range: bytes=<start>-" with a 206 and a Content-Range, sends the body in random
+// sized writes, and drops the connection at a random offset on a share of the requests, either with a
+// FIN or a RST. Every download is checked at the end: the image slots against the package byte for byte,
+// the CRC of each slot against the CRC in its record, the version and the slot handed to the registry.
+// The bytes over the air and the connections are what the firmware logs when it is done, the ranged
+// requests are counted by the server.
+//
+// A power cycle is a new job for the same URL: OTA_initDownload() starts from the checkpoint in NAND,
+// nothing else is carried over.
+//
+// Usage: test_ota_resume
+
+#define OTA_HOST                    "ota.example.com"
+#define OTA_URL                     OTA_HOST "/fw/pkg-4.2.77.bin"
+#define AM_LEN                      412345u
+#define SSM_LEN                     131071u
+#define FW_MAJOR                    4u
+#define FW_MINOR                    2u
+#define FW_BUILD                    77u
+#define FW_VERSION_RECORD_IDX       (AM_FW_VERSION_START_IDX - RECORD_HEADER_LEN)
+#define HTTP_PORT                   80u
+#define DROP_SEEDS                  40u
+#define DROP_PERCENT                70
+#define SERVER_DIES_AFTER           250000u
+#define JOB_TIMEOUT_MS              (3600u * 1000u)
+#define MAX_WRITE_BYTES             1000u
+#define NO_LIMIT                    0xFFFFFFFFul
+#define REQUEST_BYTES               1024u
+#define RESPONSE_HEADER_BYTES       256u
+
+// One connection to the server
+typedef struct
+{
+    char request[REQUEST_BYTES];
+    uint32_t requestLen;
+    char header[RESPONSE_HEADER_BYTES];
+    uint32_t headerLen;
+    uint32_t headerSent;
+    uint32_t pos;
+    uint32_t dropAt;
+    bool started;
+    bool graceful;
+}connection_t;
+
+// What a job did, from the firmware's log and the server
+typedef struct
+{
+    bool done;
+    uint32_t overAir;
+    uint32_t connections;
+    uint32_t stoppedAt;
+    bool resumed;
+    uint32_t serverConnections;
+    uint32_t ranged;
+}job_t;
+
+static bool xPass = true;
+static bool xTasksEnd = true;
+static uint32_t xNowMs = 0u;
+static uint32_t xJobStartMs = 0u;
+static TaskFunction_t xTaskCode = NULL;
+static bool xTaskDeleted = false;
+static uint32_t xNotifiedValue = 0u;
+static hostTask_t xOtaTask;
+static uint8_t xArena[ARENA_SIZE_BYTES];
+static arenaOwner_t xArenaOwner = ARENA_OWNER_NONE;
+
+static uint8_t * xPkg = NULL;
+static uint32_t xPkgLen = 0u;
+static int xDropPercent = 0;
+static bool xIgnoreRange = false;
+static uint32_t xDieAfter = NO_LIMIT;
+static uint32_t xBodyQueued = 0u;
+static uint32_t xConnections = 0u;
+static uint32_t xRanged = 0u;
+
+static imageSlotTypes_t xPrimary = A;
+static uint32_t xVersionB[3];
+static bool xOpStateB = false;
+static uint32_t xCompleteEvents = 0u;
+static uint32_t xFailEvents = 0u;
+
+static void xCheck(bool condition, const char * p_what);
+static void xPump(void);
+static void xServerClose(struct tcp_pcb * pcb, connection_t * p_conn, bool reset);
+static err_t xServerPush(struct tcp_pcb * pcb, connection_t * p_conn);
+static err_t xServerSent(void * arg, struct tcp_pcb * pcb, u16_t len);
+static err_t xServerRecv(void * arg, struct tcp_pcb * pcb, struct pbuf * p, err_t err);
+static void xServerErr(void * arg, err_t err);
+static err_t xServerAccept(void * arg, struct tcp_pcb * pcb, err_t err);
+static uint16_t xCrc(const uint8_t * p_data, uint32_t len);
+static void xPutRecordHeader(uint8_t * p_header, uint8_t type, uint32_t len);
+static void xBuildPackage(uint32_t amLen, uint32_t ssmLen, uint8_t amType);
+static void xResetRegistry(void);
+static void xFillSlots(void);
+static void xRunJob(const char * p_url, job_t * p_job);
+static bool xSlotIsRecord(uint32_t slotAddr, const uint8_t * p_record, uint32_t len);
+static bool xImageIsGood(uint32_t amLen, uint32_t ssmLen);
+
+int main(int argc, char **argv)
+{
+    struct tcp_pcb * pcb;
+    ip_addr_t local;
+    job_t job;
+    uint32_t seed;
+    uint32_t good = 0u;
+    uint32_t extra;
+    uint32_t extraMax = 0u;
+    uint64_t extraSum = 0u;
+    uint64_t connectionSum = 0u;
+    bool oneRangedPerReconnect = true;
+    bool bytesCover = true;
+    bool extraBounded = true;
+    char url[MAX_OTA_FILEPATH_LEN_BYTES];
+
+    HOST_NandReset(0xFFu);
+    HOST_InitTask(&xOtaTask);
+    lwip_init();
+
+    IP_ADDR4(&local, 127, 0, 0, 1);
+    dns_local_addhost(OTA_HOST, &local);
+    pcb = tcp_new();
+    tcp_bind(pcb, IP_ADDR_ANY, HTTP_PORT);
+    pcb = tcp_listen(pcb);
+    tcp_accept(pcb, xServerAccept);
+
+    printf("  package of %u B, AM record %u B, SSM record %u B\n", 2u * RECORD_HEADER_LEN + AM_LEN + SSM_LEN, AM_LEN, SSM_LEN);
+
+    // nothing dropped
+    srand(1);
+    xBuildPackage(AM_LEN, SSM_LEN, AM_IMAGE);
+    xFillSlots();
+    xResetRegistry();
+    xRunJob(OTA_URL, &job);
+    printf("  clean: %u B over the air, %u connections\n", job.overAir, job.connections);
+    xCheck(xImageIsGood(AM_LEN, SSM_LEN) == true, "a clean download stores both records, CRCs match");
+    xCheck((job.done == true) && (job.overAir == xPkgLen) && (job.connections == 1u) && (job.ranged == 0u),
+           "a clean download takes one connection and every byte once");
+
+    // drops at random offsets, each seed a different package and URL
+    for ( seed = 0u; seed < DROP_SEEDS; seed++ )
+    {
+        srand(100u + seed);
+        xBuildPackage(AM_LEN + seed, SSM_LEN - seed, AM_IMAGE);
+        xFillSlots();
+        xResetRegistry();
+        xDropPercent = DROP_PERCENT;
+        snprintf(url, sizeof(url), OTA_URL "?seed=%u", seed);
+        xRunJob(url, &job);
+
+        if ( (job.done == true) && (xImageIsGood(AM_LEN + seed, SSM_LEN - seed) == true) )
+        {
+            good++;
+        }
+
+        //every reconnect asks for the rest of the file, and gets back at most what the last checkpoint
+        //left behind: the write buffer and the TCP window in flight
+        extra = job.overAir - xPkgLen;
+        oneRangedPerReconnect &= (job.ranged == (job.connections - 1u)) && (job.serverConnections == job.connections);
+        bytesCover &= (job.overAir >= xPkgLen);
+        extraBounded &= (extra <= ((job.connections - 1u) * (ARENA_OTA_WRITE_BUFFER_BYTES + TCP_WND)));
+        extraSum += extra;
+        connectionSum += job.connections;
+        extraMax = (extra > extraMax) ? extra : extraMax;
+    }
+
+    printf("  %u%% of connections dropped, %u downloads: %.1f connections each, %.2f%% sent again, at most %u B\n",
+           DROP_PERCENT, DROP_SEEDS, (double)connectionSum / DROP_SEEDS, (100.0 * extraSum) / ((double)DROP_SEEDS * xPkgLen), extraMax);
+    xCheck(good == DROP_SEEDS, "every download with drops stores both records, CRCs match");
+    xCheck(bytesCover == true, "the bytes over the air cover the package");
+    xCheck(oneRangedPerReconnect == true, "every reconnect is a ranged request");
+    xCheck(extraBounded == true, "a reconnect gets back at most a write buffer and a window");
+    xCheck(connectionSum > DROP_SEEDS, "connections were dropped");
+    xDropPercent = 0;
+
+    // the server goes away part way, the task gives up, the unit powers down and the job comes again
+    srand(7);
+    xBuildPackage(AM_LEN, SSM_LEN, AM_IMAGE);
+    xFillSlots();
+    xResetRegistry();
+    xDropPercent = 100;
+    xDieAfter = SERVER_DIES_AFTER;
+    xRunJob(OTA_URL, &job);
+    printf("  server gone: stopped at %u of %u B after %u connections\n", job.stoppedAt, xPkgLen, job.connections);
+    xCheck((job.done == false) && (xFailEvents == 1u) && (xCompleteEvents == 0u), "the download gives up when the server is gone");
+    xCheck((job.stoppedAt != 0u) && (job.stoppedAt < xPkgLen), "it stops part way");
+
+    xResetRegistry();
+    xDropPercent = 30;
+    xDieAfter = NO_LIMIT;
+    xRunJob(OTA_URL, &job);
+    printf("  after a power cycle: %u B over the air, %u connections, %u ranged\n", job.overAir, job.connections, job.ranged);
+    xCheck((job.resumed == true) && (job.ranged != 0u), "the job sent again resumes from the checkpoint in NAND");
+    xCheck((job.done == true) && (xImageIsGood(AM_LEN, SSM_LEN) == true), "the resumed download stores both records, CRCs match");
+    xCheck(job.overAir < xPkgLen, "it does not download the package again");
+    xDropPercent = 0;
+
+    // the server ignores the Range header, every reconnect starts over
+    srand(8);
+    xBuildPackage(AM_LEN, SSM_LEN, AM_IMAGE);
+    xFillSlots();
+    xResetRegistry();
+    xDropPercent = 50;
+    xIgnoreRange = true;
+    xRunJob(OTA_URL, &job);
+    printf("  range ignored: %u B over the air, %u connections\n", job.overAir, job.connections);
+    xCheck((job.done == true) && (xImageIsGood(AM_LEN, SSM_LEN) == true), "a server that ignores the range still gives a good image");
+    xIgnoreRange = false;
+    xDropPercent = 0;
+
+    // the file behind the URL changed since the checkpoint, the 206 has another total
+    srand(9);
+    xBuildPackage(AM_LEN, SSM_LEN, AM_IMAGE);
+    xFillSlots();
+    xResetRegistry();
+    xDieAfter = SERVER_DIES_AFTER;
+    xRunJob(OTA_URL, &job);
+    xBuildPackage(AM_LEN - 1000u, SSM_LEN, AM_IMAGE);
+    xFillSlots();
+    xResetRegistry();
+    xDieAfter = NO_LIMIT;
+    xRunJob(OTA_URL, &job);
+    printf("  file changed: %u B over the air, %u connections\n", job.overAir, job.connections);
+    xCheck((job.done == true) && (xImageIsGood(AM_LEN - 1000u, SSM_LEN) == true), "a changed file is downloaded from the start");
+    xCheck(job.overAir >= xPkgLen, "none of the old file is kept");
+
+    // a new job never continues an old one
+    srand(10);
+    xBuildPackage(AM_LEN, SSM_LEN, AM_IMAGE);
+    xFillSlots();
+    xResetRegistry();
+    xDieAfter = SERVER_DIES_AFTER;
+    xRunJob(OTA_URL, &job);
+    xResetRegistry();
+    xDieAfter = NO_LIMIT;
+    xRunJob(OTA_URL "?v=2", &job);
+    xCheck((job.resumed == false) && (job.ranged == 0u) && (job.overAir == xPkgLen), "a new URL starts from byte 0");
+    xCheck((job.done == true) && (xImageIsGood(AM_LEN, SSM_LEN) == true), "and stores both records, CRCs match");
+
+    // not an OTA package, fails at once and leaves nothing to resume
+    srand(11);
+    xBuildPackage(AM_LEN, SSM_LEN, SSM_IMAGE);
+    xFillSlots();
+    xResetRegistry();
+    xRunJob(OTA_URL, &job);
+    xCheck((job.done == false) && (xFailEvents == 1u) && (job.connections == 1u), "a file that is not a package fails on the first connection");
+    xBuildPackage(AM_LEN, SSM_LEN, AM_IMAGE);
+    xFillSlots();
+    xResetRegistry();
+    xRunJob(OTA_URL, &job);
+    xCheck((job.resumed == false) && (job.ranged == 0u) && (xImageIsGood(AM_LEN, SSM_LEN) == true), "it leaves no checkpoint behind");
+
+    xCheck(xTasksEnd == true, "every download task ends and gives the arena back");
+    printf("  NAND: %u erases, %u page programs\n", HOST_NandGetErases(), HOST_NandGetPrograms());
+    xCheck(HOST_NandGetViolations() == 0u, "no page is programmed twice without an erase");
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+u32_t sys_now(void)
+{
+    return xNowMs;
+}
+
+u32_t sys_jiffies(void)
+{
+    return xNowMs;
+}
+
+// One virtual ms of lwIP: the loopback interface and the timers
+static void xPump(void)
+{
+    xNowMs++;
+    netif_poll_all();
+    sys_check_timeouts();
+
+    if ( (xNowMs - xJobStartMs) > JOB_TIMEOUT_MS )
+    {
+        printf("  FAIL: the download task is stuck\nFAIL\n");
+        exit(1);
+    }
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName, configSTACK_DEPTH_TYPE usStackDepth,
+                       void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask)
+{
+    xTaskCode = pxTaskCode;
+    xTaskDeleted = false;
+    xNotifiedValue = 0u;
+    *pxCreatedTask = &xOtaTask;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    xTaskDeleted = true;
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    TickType_t tick;
+
+    for ( tick = 0u; tick < xTicksToDelay; tick++ )
+    {
+        xPump();
+    }
+}
+
+BaseType_t xTaskNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction)
+{
+    xNotifiedValue |= ulValue;
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t * pulNotificationValue,
+                           TickType_t xTicksToWait)
+{
+    TickType_t start = xNowMs;
+
+    xNotifiedValue &= ~ulBitsToClearOnEntry;
+
+    while ( xNotifiedValue == 0u )
+    {
+        if ( (xTicksToWait != portMAX_DELAY) && ((xNowMs - start) >= xTicksToWait) )
+        {
+            return pdFALSE;
+        }
+        xPump();
+    }
+
+    *pulNotificationValue = xNotifiedValue;
+    xNotifiedValue &= ~ulBitsToClearOnExit;
+    return pdTRUE;
+}
+
+imageSlotTypes_t MEM_getLoadedImage(void)
+{
+    return A;
+}
+
+bool MEM_setPrimaryImage(imageSlotTypes_t slot)
+{
+    xPrimary = slot;
+    return true;
+}
+
+bool MEM_setImageAoperationalState(imageOperationalState_t state)
+{
+    return true;
+}
+
+bool MEM_setImageBoperationalState(imageOperationalState_t state)
+{
+    xOpStateB = (state == OP_UNKNOWN);
+    return true;
+}
+
+bool MEM_setImageAversion(uint32_t major, uint32_t minor, uint32_t build)
+{
+    return true;
+}
+
+bool MEM_setImageBversion(uint32_t major, uint32_t minor, uint32_t build)
+{
+    xVersionB[0] = major;
+    xVersionB[1] = minor;
+    xVersionB[2] = build;
+    return true;
+}
+
+uint8_t* ARENA_acquire(arenaOwner_t owner, uint32_t len)
+{
+    if ( (xArenaOwner != ARENA_OWNER_NONE) || (len > sizeof(xArena)) )
+    {
+        return NULL;
+    }
+
+    xArenaOwner = owner;
+    return xArena;
+}
+
+void ARENA_release(arenaOwner_t owner)
+{
+    if ( owner == xArenaOwner )
+    {
+        xArenaOwner = ARENA_OWNER_NONE;
+    }
+}
+
+void EVT_indicateFwDownloadComplete(void)
+{
+    xCompleteEvents++;
+}
+
+void EVT_indicateFwDownloadFail(void)
+{
+    xFailEvents++;
+}
+
+static void xServerClose(struct tcp_pcb * pcb, connection_t * p_conn, bool reset)
+{
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    tcp_sent(pcb, NULL);
+    tcp_err(pcb, NULL);
+    free(p_conn);
+
+    if ( reset == true )
+    {
+        tcp_abort(pcb);
+    }
+    else
+    {
+        tcp_close(pcb);
+    }
+}
+
+// Queue as much of the header and the body as the send buffer takes, in random sized writes
+static err_t xServerPush(struct tcp_pcb * pcb, connection_t * p_conn)
+{
+    uint32_t room;
+    uint32_t len;
+
+    while ( (room = tcp_sndbuf(pcb)) > 0u )
+    {
+        if ( p_conn->headerSent < p_conn->headerLen )
+        {
+            len = p_conn->headerLen - p_conn->headerSent;
+            len = (len > room) ? room : len;
+            if ( tcp_write(pcb, &p_conn->header[p_conn->headerSent], len, TCP_WRITE_FLAG_COPY) != ERR_OK )
+            {
+                break;
+            }
+            p_conn->headerSent += len;
+            continue;
+        }
+
+        if ( p_conn->pos >= p_conn->dropAt )
+        {
+            if ( (p_conn->dropAt >= xPkgLen) || (p_conn->graceful == true) )
+            {
+                tcp_output(pcb);
+                xServerClose(pcb, p_conn, false);
+                return ERR_OK;
+            }
+
+            //reset once what was written before the drop has been delivered
+            if ( (pcb->unsent != NULL) || (pcb->unacked != NULL) )
+            {
+                break;
+            }
+            xServerClose(pcb, p_conn, true);
+            return ERR_ABRT;
+        }
+
+        len = p_conn->dropAt - p_conn->pos;
+        len = (len > room) ? room : len;
+        len = (len > MAX_WRITE_BYTES) ? (1u + ((uint32_t)rand() % MAX_WRITE_BYTES)) : len;
+        if ( tcp_write(pcb, &xPkg[p_conn->pos], len, TCP_WRITE_FLAG_COPY) != ERR_OK )
+        {
+            break;
+        }
+        p_conn->pos += len;
+        xBodyQueued += len;
+    }
+
+    tcp_output(pcb);
+    return ERR_OK;
+}
+
+static err_t xServerSent(void * arg, struct tcp_pcb * pcb, u16_t len)
+{
+    return xServerPush(pcb, (connection_t *)arg);
+}
+
+static err_t xServerRecv(void * arg, struct tcp_pcb * pcb, struct pbuf * p, err_t err)
+{
+    connection_t * p_conn = (connection_t *)arg;
+    char * p_range;
+    uint32_t start = 0u;
+
+    if ( p == NULL )
+    {
+        xServerClose(pcb, p_conn, false);
+        return ERR_OK;
+    }
+
+    if ( p_conn->started == false )
+    {
+        p_conn->requestLen += pbuf_copy_partial(p, &p_conn->request[p_conn->requestLen], sizeof(p_conn->request) - 1u - p_conn->requestLen, 0);
+        p_conn->request[p_conn->requestLen] = '\0';
+    }
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+
+    if ( (p_conn->started == true) || (strstr(p_conn->request, "\r\n\r\n") == NULL) )
+    {
+        return ERR_OK;
+    }
+    p_conn->started = true;
+
+    p_range = strstr(p_conn->request, "Range: bytes=");
+    if ( p_range != NULL )
+    {
+        xRanged++;
+        start = (xIgnoreRange == true) ? 0u : strtoul(p_range + strlen("Range: bytes="), NULL, 10);
+    }
+
+    if ( start == 0u )
+    {
+        p_conn->headerLen = snprintf(p_conn->header, sizeof(p_conn->header), "HTTP/1.1 200 OK\r\nContent-Length: %u\r\n\r\n", xPkgLen);
+    }
+    else
+    {
+        p_conn->headerLen = snprintf(p_conn->header, sizeof(p_conn->header),
+                                     "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %u-%u/%u\r\nContent-Length: %u\r\n\r\n",
+                                     start, xPkgLen - 1u, xPkgLen, xPkgLen - start);
+    }
+
+    p_conn->pos = start;
+    p_conn->dropAt = xPkgLen;
+    if ( xBodyQueued >= xDieAfter )
+    {
+        p_conn->dropAt = start;
+    }
+    else if ( (rand() % 100) < xDropPercent )
+    {
+        p_conn->dropAt = start + 1u + ((uint32_t)rand() % (xPkgLen - start));
+    }
+    p_conn->graceful = ((rand() & 1) != 0);
+
+    return xServerPush(pcb, p_conn);
+}
+
+static void xServerErr(void * arg, err_t err)
+{
+    free(arg);
+}
+
+static err_t xServerAccept(void * arg, struct tcp_pcb * pcb, err_t err)
+{
+    connection_t * p_conn = calloc(1u, sizeof(connection_t));
+
+    xConnections++;
+    tcp_arg(pcb, p_conn);
+    tcp_recv(pcb, xServerRecv);
+    tcp_sent(pcb, xServerSent);
+    tcp_err(pcb, xServerErr);
+    return ERR_OK;
+}
+
+// crc-ccitt-false, bit by bit so it does not share code with otaUpdate.c
+static uint16_t xCrc(const uint8_t * p_data, uint32_t len)
+{
+    uint16_t crc = 0xFFFFu;
+    uint32_t bit;
+
+    while ( len-- > 0u )
+    {
+        crc ^= (uint16_t)(*p_data++ << 8);
+        for ( bit = 0u; bit < 8u; bit++ )
+        {
+            crc = ((crc & 0x8000u) != 0u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static void xPutRecordHeader(uint8_t * p_header, uint8_t type, uint32_t len)
+{
+    p_header[RECORD_TYPE_IDX] = type;
+    p_header[RECORD_LEN_IDX] = (uint8_t)(len >> 24);
+    p_header[RECORD_LEN_IDX + 1] = (uint8_t)(len >> 16);
+    p_header[RECORD_LEN_IDX + 2] = (uint8_t)(len >> 8);
+    p_header[RECORD_LEN_IDX + 3] = (uint8_t)len;
+}
+
+// AM record header, AM record, SSM record header, SSM record. Each record starts with the big endian CRC
+// of the rest of it, the AM record holds the version as three big endian words.
+static void xBuildPackage(uint32_t amLen, uint32_t ssmLen, uint8_t amType)
+{
+    uint8_t * p_am;
+    uint8_t * p_ssm;
+    uint16_t crc;
+    uint32_t i;
+
+    xPkgLen = (2u * RECORD_HEADER_LEN) + amLen + ssmLen;
+    free(xPkg);
+    xPkg = malloc(xPkgLen);
+    for ( i = 0u; i < xPkgLen; i++ )
+    {
+        xPkg[i] = (uint8_t)rand();
+    }
+
+    xPutRecordHeader(xPkg, amType, amLen);
+    p_am = &xPkg[RECORD_HEADER_LEN];
+    memset(&p_am[FW_VERSION_RECORD_IDX], 0, 12);
+    p_am[FW_VERSION_RECORD_IDX + 3] = FW_MAJOR;
+    p_am[FW_VERSION_RECORD_IDX + 7] = FW_MINOR;
+    p_am[FW_VERSION_RECORD_IDX + 11] = FW_BUILD;
+    crc = xCrc(&p_am[CRC_LEN], amLen - CRC_LEN);
+    p_am[0] = (uint8_t)(crc >> 8);
+    p_am[1] = (uint8_t)crc;
+
+    xPutRecordHeader(&p_am[amLen], SSM_IMAGE, ssmLen);
+    p_ssm = &p_am[amLen + RECORD_HEADER_LEN];
+    crc = xCrc(&p_ssm[CRC_LEN], ssmLen - CRC_LEN);
+    p_ssm[0] = (uint8_t)(crc >> 8);
+    p_ssm[1] = (uint8_t)crc;
+}
+
+// The registry and the events start clean
+static void xResetRegistry(void)
+{
+    xPrimary = A;
+    memset(xVersionB, 0, sizeof(xVersionB));
+    xOpStateB = false;
+    xCompleteEvents = 0u;
+    xFailEvents = 0u;
+}
+
+// The B slots hold something that is not the image
+static void xFillSlots(void)
+{
+    memset(HOST_NandGetArray(APP_MEM_ADR_FW_APPLICATION_AM_B_START), 0xA5,
+           APP_MEM_ADR_FW_APPLICATION_AM_B_END - APP_MEM_ADR_FW_APPLICATION_AM_B_START + 1u);
+    memset(HOST_NandGetArray(APP_MEM_ADR_FW_APPLICATION_SSM_B_START), 0xA5,
+           APP_MEM_ADR_FW_APPLICATION_SSM_B_END - APP_MEM_ADR_FW_APPLICATION_SSM_B_START + 1u);
+}
+
+// Start the job and run the download task to the end
+static void xRunJob(const char * p_url, job_t * p_job)
+{
+    char url[MAX_OTA_FILEPATH_LEN_BYTES];
+    char line[HOST_LOG_LINE_LEN];
+    unsigned long fileSize;
+    unsigned long overAir;
+    unsigned long connections;
+    unsigned long stoppedAt;
+
+    memset(p_job, 0, sizeof(job_t));
+    snprintf(url, sizeof(url), "%s", p_url);
+    HOST_ClearLog();
+    xConnections = 0u;
+    xRanged = 0u;
+    xBodyQueued = 0u;
+    xTaskCode = NULL;
+    xJobStartMs = xNowMs;
+
+    if ( (OTA_initDownload(url) == false) || (xTaskCode == NULL) )
+    {
+        xCheck(false, "the download starts");
+        return;
+    }
+
+    xTaskCode(NULL);
+
+    xTasksEnd &= (xTaskDeleted == true) && (xArenaOwner == ARENA_OWNER_NONE);
+
+    if ( (HOST_FindLog("bytes received with", line) == true) &&
+         (sscanf(line, "OTA package of %lu bytes received with %lu bytes over %lu connections", &fileSize, &overAir, &connections) == 3) )
+    {
+        p_job->done = true;
+        p_job->overAir = overAir;
+        p_job->connections = connections;
+    }
+    else
+    {
+        p_job->connections = xConnections;
+    }
+
+    if ( (HOST_FindLog("OTA download stopped at byte", line) == true) &&
+         (sscanf(line, "OTA download stopped at byte %lu", &stoppedAt) == 1) )
+    {
+        p_job->stoppedAt = stoppedAt;
+    }
+
+    p_job->resumed = HOST_FindLog("Resuming OTA at byte", NULL);
+    p_job->serverConnections = xConnections;
+    p_job->ranged = xRanged;
+}
+
+static bool xSlotIsRecord(uint32_t slotAddr, const uint8_t * p_record, uint32_t len)
+{
+    const uint8_t * p_slot = HOST_NandGetArray(slotAddr);
+    uint16_t crc = xCrc(&p_slot[CRC_LEN], len - CRC_LEN);
+
+    return (memcmp(p_slot, p_record, len) == 0) && (p_slot[0] == (uint8_t)(crc >> 8)) && (p_slot[1] == (uint8_t)crc);
+}
+
+static bool xImageIsGood(uint32_t amLen, uint32_t ssmLen)
+{
+    return (xCompleteEvents == 1u) && (xFailEvents == 0u) && (xPrimary == B) && (xOpStateB == true) &&
+           (xVersionB[0] == FW_MAJOR) && (xVersionB[1] == FW_MINOR) && (xVersionB[2] == FW_BUILD) &&
+           (xSlotIsRecord(APP_MEM_ADR_FW_APPLICATION_AM_B_START, &xPkg[RECORD_HEADER_LEN], amLen) == true) &&
+           (xSlotIsRecord(APP_MEM_ADR_FW_APPLICATION_SSM_B_START, &xPkg[(2u * RECORD_HEADER_LEN) + amLen], ssmLen) == true);
+}
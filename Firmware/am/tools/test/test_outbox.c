@@ -0,0 +1,303 @@
+/**************************************************************************************************
+* \file     test_outbox.c
+* \brief    Replay of the MQTT outbox against a flaky broker with power cuts on the NAND
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_am.h"
+#include "host_nand.h"
+#include "MT29F1.h"
+#include "memoryMap.h"
+#include "mqttOutbox.h"
+
+// Builds mqttOutbox.c over the simulated NAND and drains it the way mqttHandler.c does: commit, hand out
+// up to OUTBOX_BATCH_SIZE records, stop after OUTBOX_MAX_FAILURES_PER_SESSION failures until the next
+// connection. The broker takes each publish with BROKER_LOSS_PERCENT odds of losing it or its PUBACK,
+// a lost PUBACK means the broker has it and it is sent again. Power is lost at a random erase or page
+// program in about one pass in CUT_ONE_IN, after which the outbox starts over from NAND.
+//
+// Every push that returned true has to reach the broker at least once and intact, a record can only be
+// overtaken by the others in its batch, and no page may be programmed twice without an erase. A second part queues more than the
+// outbox holds while offline and checks that only the oldest records are dropped.
+//
+// Usage: test_outbox [seed]
+
+#define NUM_RECORDS                 600u
+#define MAX_RECORDS                 (NUM_RECORDS + 300u)
+#define MAX_PASSES                  20000u
+#define BROKER_LOSS_PERCENT         25u
+#define PUBACK_LOSS_PERCENT         10u
+#define CUT_ONE_IN                  8u
+#define OFFLINE_RECORDS             250u
+#define OUTBOX_SLOTS                (3u * NUM_PAGE_BLOCK)
+
+// As in mqttHandler.c
+#define OUTBOX_MAX_FAILURES_PER_SESSION 3u
+
+static const char * xTopics[] = { "async/dev/status", "async/dev/sensor-data" };
+
+static bool xConfirmed[MAX_RECORDS];
+static uint32_t xDeliveries[MAX_RECORDS];
+static uint32_t xFirstOrder[MAX_RECORDS];
+static uint32_t xNumFirst = 0u;
+static uint32_t xDamaged = 0u;
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static void xRestart(void);
+static bool xPush(uint32_t id);
+static void xDrainPass(uint32_t lossPercent);
+static uint16_t xPayloadLen(uint32_t id);
+
+int main(int argc, char **argv)
+{
+    volatile uint32_t next = 0u;
+    volatile uint32_t cuts = 0u;
+    volatile uint32_t pass = 0u;
+    uint32_t duplicates = 0u;
+    uint32_t missing = 0u;
+    uint32_t reorder = 0u;
+    uint32_t ahead;
+    uint32_t offlineFirst;
+    uint32_t i;
+    uint32_t j;
+
+    srand((argc > 1) ? (unsigned)atoi(argv[1]) : 1u);
+
+    //first boot on a region that holds someone else's data
+    HOST_NandReset(0x5A);
+    xRestart();
+    xCheck(OUTBOX_getPendingCount() == 0u, "formats a region it did not write");
+
+    //queued while offline, still there after a reset
+    for ( i = 0u; i < 40u; i++ )
+    {
+        xPush(next++);
+    }
+
+    xRestart();
+    xCheck(OUTBOX_getPendingCount() == 40u, "40 records offline survive a reset");
+
+    //connected with a flaky broker, more records arriving and the power going out
+    HOST_ClearLog();
+
+    for ( pass = 0u; (pass < MAX_PASSES) && ((next < NUM_RECORDS) || (OUTBOX_getPendingCount() > 0u)); pass++ )
+    {
+        if ( setjmp(hostNandPowerCut) != 0 )
+        {
+            cuts++;
+            xRestart();
+            continue;
+        }
+
+        if ( (rand() % CUT_ONE_IN) == 0 )
+        {
+            HOST_NandCutAt((uint32_t)(rand() % 4));
+        }
+
+        for ( i = (uint32_t)(rand() % 3); (i > 0u) && (next < NUM_RECORDS); i-- )
+        {
+            xPush(next++);
+        }
+
+        //a new connection now and then clears the failure count
+        if ( (rand() % 10) == 0 )
+        {
+            OUTBOX_resetFailures();
+        }
+
+        xDrainPass(BROKER_LOSS_PERCENT);
+        HOST_NandCutAt(UINT32_MAX);
+    }
+
+    HOST_NandCutAt(UINT32_MAX);
+
+    //the callback of the last acknowledge asks for one more pass, which journals the tail
+    OUTBOX_commit();
+
+    for ( i = 0u; i < next; i++ )
+    {
+        duplicates += (xDeliveries[i] > 1u) ? (xDeliveries[i] - 1u) : 0u;
+        missing += ((xConfirmed[i] == true) && (xDeliveries[i] == 0u)) ? 1u : 0u;
+    }
+
+    //a record can only get ahead of the ones it was sent with
+    for ( i = 0u; i < xNumFirst; i++ )
+    {
+        ahead = 0u;
+
+        for ( j = i + 1u; j < xNumFirst; j++ )
+        {
+            ahead += (xFirstOrder[j] < xFirstOrder[i]) ? 1u : 0u;
+        }
+
+        reorder = (ahead > reorder) ? ahead : reorder;
+    }
+
+    printf("  %u records in %u passes, %u power cuts, %u erases, %u page programs\n", next, pass, cuts, HOST_NandGetErases(), HOST_NandGetPrograms());
+    printf("  %u delivered, %u sent again, %u damaged pages skipped, at most %u overtaken\n", xNumFirst, duplicates, xDamaged, reorder);
+    xCheck(pass < MAX_PASSES, "the outbox drains");
+    xCheck(HOST_FindLog("dropped", NULL) == false, "the outbox never filled up");
+    xCheck(missing == 0u, "every confirmed push reaches the broker");
+    xCheck(xDamaged == 0u, "no damaged record is handed out");
+    xCheck(reorder < OUTBOX_BATCH_SIZE, "records are only overtaken within a batch");
+    xCheck(HOST_NandGetViolations() == 0u, "no page is programmed twice without an erase");
+    xCheck(cuts > 0u, "power was lost during the replay");
+
+    xRestart();
+    xCheck(OUTBOX_getPendingCount() == 0u, "nothing left after a reset");
+
+    //the failure count, from the callback and the task
+    OUTBOX_markFailed(0u);
+    OUTBOX_markFailed(0u);
+    xCheck(OUTBOX_getFailureCount() == 2u, "failures are counted");
+    OUTBOX_markAcked(0u);
+    xCheck(OUTBOX_getFailureCount() == 0u, "an acknowledge clears the failure count");
+    OUTBOX_markFailed(0u);
+    OUTBOX_resetFailures();
+    xCheck(OUTBOX_getFailureCount() == 0u, "a new connection clears the failure count");
+
+    //more than the outbox holds while offline, the oldest are dropped a block at a time
+    offlineFirst = next;
+
+    for ( i = 0u; i < OFFLINE_RECORDS; i++ )
+    {
+        xPush(next++);
+    }
+
+    xRestart();
+    printf("  %u queued offline, %u kept\n", OFFLINE_RECORDS, OUTBOX_getPendingCount());
+    xCheck(OUTBOX_getPendingCount() < OUTBOX_SLOTS, "the outbox keeps less than its slots");
+    xCheck(OUTBOX_getPendingCount() >= (OUTBOX_SLOTS - NUM_PAGE_BLOCK), "the outbox loses at most a block more than it must");
+
+    memset(xDeliveries, 0, sizeof(xDeliveries));
+    xNumFirst = 0u;
+
+    while ( OUTBOX_getPendingCount() > 0u )
+    {
+        xDrainPass(0u);
+    }
+
+    xCheck(xFirstOrder[0] == next - OUTBOX_getPendingCount() - xNumFirst, "the oldest were dropped");
+    xCheck(xFirstOrder[xNumFirst - 1u] == next - 1u, "the newest were kept");
+    xCheck(xFirstOrder[0] > offlineFirst, "some were dropped");
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// A reset, the outbox rebuilds itself from NAND
+static void xRestart(void)
+{
+    OUTBOX_init();
+}
+
+// Record id is in the first 4 bytes of the payload, the rest is a pattern of it
+static bool xPush(uint32_t id)
+{
+    uint8_t payload[OUTBOX_MAX_PAYLOAD_LEN];
+    const char * p_topic = xTopics[id % 2u];
+
+    memset(payload, (int)(id & 0xFFu), sizeof(payload));
+    memcpy(payload, &id, sizeof(id));
+    xConfirmed[id] = OUTBOX_push(p_topic, (uint8_t)strlen(p_topic), 1u, payload, xPayloadLen(id));
+
+    return xConfirmed[id];
+}
+
+// One pass of xDrainOutbox() and the publish complete callbacks of what it sent
+static void xDrainPass(uint32_t lossPercent)
+{
+    outboxRecord_t records[OUTBOX_BATCH_SIZE];
+    uint32_t numRecords = 0u;
+    uint32_t id;
+    uint32_t i;
+    bool intact;
+
+    OUTBOX_commit();
+
+    if ( OUTBOX_getFailureCount() >= OUTBOX_MAX_FAILURES_PER_SESSION )
+    {
+        return;
+    }
+
+    while ( (numRecords < OUTBOX_BATCH_SIZE) && (OUTBOX_getNextToSend(&records[numRecords]) == true) )
+    {
+        numRecords++;
+    }
+
+    for ( i = 0u; i < numRecords; i++ )
+    {
+        memcpy(&id, records[i].payload, sizeof(id));
+        intact = (id < MAX_RECORDS) && (records[i].payloadLen == xPayloadLen(id)) &&
+                 (records[i].topicLen == strlen(xTopics[id % 2u])) && (memcmp(records[i].topic, xTopics[id % 2u], records[i].topicLen) == 0) &&
+                 (records[i].payload[records[i].payloadLen - 1u] == (uint8_t)(id & 0xFFu));
+
+        if ( intact == false )
+        {
+            xDamaged++;
+            OUTBOX_markAcked(records[i].seq);
+        }
+        else if ( (uint32_t)(rand() % 100) < lossPercent )
+        {
+            //never got there
+            OUTBOX_markFailed(records[i].seq);
+        }
+        else
+        {
+            if ( xDeliveries[id]++ == 0u )
+            {
+                xFirstOrder[xNumFirst++] = id;
+            }
+
+            //the broker has it, but the PUBACK can still be lost
+            if ( (uint32_t)(rand() % 100) < ((lossPercent > 0u) ? PUBACK_LOSS_PERCENT : 0u) )
+            {
+                OUTBOX_markFailed(records[i].seq);
+            }
+            else
+            {
+                OUTBOX_markAcked(records[i].seq);
+            }
+        }
+    }
+}
+
+static uint16_t xPayloadLen(uint32_t id)
+{
+    return (uint16_t)(8u + ((id * 37u) % (OUTBOX_MAX_PAYLOAD_LEN - 8u)));
+}
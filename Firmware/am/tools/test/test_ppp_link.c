@@ -0,0 +1,1085 @@
+/**************************************************************************************************
+* \file     test_ppp_link.c
+* \brief    Host test of the PPP link I/O in pppLink.c: lwIP PPPoS against a loopback peer
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_am.h"
+#include "stm32l4r5xx.h"
+#include "stm32l4xx_hal.h"
+#include "uart.h"
+#include "lwip/init.h"
+#include "lwip/timeouts.h"
+#include "lwip/udp.h"
+#include "lwip/pbuf.h"
+#include "pppos.h"
+#include "pppLink.h"
+
+// The AM's lwIP PPPoS pcb against a second pcb that plays the modem and the network behind it, both in
+// one lwIP core run from this thread, which also plays the AT task. Two more threads play the cell UART
+// at 230400 baud: one is the receive interrupt, handing the peer's bytes over one at a time as the line
+// delivers them, the other is the transmit DMA, which takes as long as the line needs for each transfer
+// and then runs the tx complete interrupt. The interrupt threads hold HOST_EnterCritical() around the
+// handlers, so they can not run inside the firmware's critical sections.
+//
+// The link is brought up through pppLink.c and UDP datagrams go both ways at 70% of the line rate, each
+// checked byte for byte. Then the same traffic goes through a model of the engine pppLink.c replaced:
+// the UART interrupt queues bytes into an 1800 byte buffer, the task polls it every 2 ms and calls
+// pppos_input() once per byte, and the output callback starts the DMA and spins until it completes.
+// Throughput on the line is the same for both, the task CPU time is what changes. The task CPU time is
+// the thread CPU time the AT task spends receiving and sending on the AM's side, the peer's share is
+// left out.
+//
+// Last the receive path without the line: the peer's side of 2000 datagrams is captured and replayed
+// into the AM's pcb as fast as it will go, byte per call against spans, for the ns a byte each costs.
+//
+// Usage: test_ppp_link
+
+#define LINE_BYTES_PER_SEC          23040u          // 230400 baud, 10 bits a byte
+#define LINE_LOAD_PERCENT           70u
+#define LINK_UP_TIMEOUT_MS          10000u
+#define DATAGRAM_BYTES              1000u
+#define DATAGRAMS_EACH_WAY          60u
+#define TRAFFIC_TIMEOUT_MS          20000u
+#define QUIET_TIMEOUT_MS            5000u
+#define PPP_RX_WAIT_MS              1000u           // as nwStackFunctionality.c
+#define OLD_POLLING_RATE_MS         2u
+#define OLD_RX_BUFFER_BYTES         1800u
+#define OLD_TX_TIMEOUT_SPINS        0xFFFFFFFu
+#define PIPE_BYTES                  (1024u * 1024u)
+#define AM_PORT                     5000u
+#define PEER_PORT                   5001u
+#define STALL_CHUNK_BYTES           600u
+#define STALL_CHUNKS                3u              // fit the 2 KB tx ring, the next one waits for space
+#define TX_SPACE_TIMEOUT_MS         500u            // as pppLink.c
+#define TX_RING_BYTES               2048u           // as pppLink.c
+#define REPLAY_DATAGRAMS            2000u
+#define REPLAY_RUNS                 5u
+#define NS_PER_SEC                  1000000000ull
+
+// The two ways the AT task can move ppp bytes
+typedef struct
+{
+    const char * p_name;
+    void (*p_start)(void);
+    void (*p_rxByteFromIsr)(uint8_t byte);
+    void (*p_txCompleteFromIsr)(void);
+    void (*p_waitForRx)(TickType_t ticks);
+    void (*p_passRxToPpp)(void);
+    u32_t (*p_output)(const u8_t * p_data, u32_t len);
+}engine_t;
+
+// One direction of the serial line, bytes in order
+typedef struct
+{
+    uint8_t * p_buf;
+    size_t head;
+    size_t tail;
+    pthread_mutex_t mutex;
+}pipe_t;
+
+typedef struct
+{
+    uint32_t sent;
+    uint32_t received;
+    uint32_t damaged;
+    uint64_t firstSentNs;
+    uint64_t lastReceivedNs;
+}flow_t;
+
+typedef struct
+{
+    flow_t up;                      // AM to the peer
+    flow_t down;                    // the peer to the AM
+    uint64_t rxCpuNs;
+    uint64_t txCpuNs;
+    uint64_t elapsedNs;
+    uint32_t rxWakes;
+    uint32_t rxCalls;
+}run_t;
+
+static const engine_t xNewEngine;
+static const engine_t xOldEngine;
+
+static const engine_t * volatile xEngine = &xNewEngine;
+static pipe_t xToAm;
+static pipe_t xToPeer;
+static hostTask_t xAmTask;
+static pthread_t xRxIsrThread;
+static pthread_t xDmaThread;
+static volatile bool xRunning = true;
+
+// The DMA, the transfer the firmware started and what the line has moved
+static pthread_mutex_t xDmaMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t xDmaCond = PTHREAD_COND_INITIALIZER;
+static const uint8_t * xDmaData = NULL;
+static uint32_t xDmaLen = 0u;
+static volatile bool xDmaStalled = false;
+static uint32_t xDmaStarts = 0u;
+static uint32_t xDmaBusy = 0u;
+static uint64_t xDmaBytes = 0u;
+static uint64_t xRxIsrBytes = 0u;
+static uint32_t xRxIsrWakes = 0u;
+
+static ppp_pcb * xAm;
+static ppp_pcb * xPeer;
+static struct netif xAmNetif;
+static struct netif xPeerNetif;
+static struct udp_pcb * xAmUdp;
+static struct udp_pcb * xPeerUdp;
+static bool xAmUp = false;
+static bool xPeerUp = false;
+static run_t * xRun = NULL;
+static uint32_t xAmRxCalls = 0u;
+static uint8_t * xCapture = NULL;
+static size_t xCaptureLen = 0u;
+static bool xCapturing = false;
+static uint8_t xTooLong[TX_RING_BYTES + 1u];
+
+// The engine pppLink.c replaced, as nwStackFunctionality.c had it
+static uint8_t xOldRxBuffer[OLD_RX_BUFFER_BYTES];
+static volatile uint16_t xOldRxHead = 0u;
+static volatile uint16_t xOldRxTail = 0u;
+static volatile bool xOldTransmitting = false;
+
+DWT_Type xDwt;
+CoreDebug_Type HOST_CoreDebug;
+uint32_t SystemCoreClock = 1000000000u;
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static uint64_t xNowNs(void);
+static uint64_t xCpuNs(void);
+static void xSleepNs(uint64_t ns);
+static void xPipeInit(pipe_t * p_pipe);
+static void xPipeReset(pipe_t * p_pipe);
+static void xPipeWrite(pipe_t * p_pipe, const uint8_t * p_data, size_t len);
+static bool xPipeGet(pipe_t * p_pipe, uint8_t * p_byte);
+static size_t xPipeRead(pipe_t * p_pipe, uint8_t * p_data, size_t max);
+static bool xPipeIsEmpty(pipe_t * p_pipe);
+static void * xRxIsr(void * p_arg);
+static void * xDma(void * p_arg);
+static u32_t xAmOutput(ppp_pcb * pcb, u8_t * data, u32_t len, void * ctx);
+static u32_t xPeerOutput(ppp_pcb * pcb, u8_t * data, u32_t len, void * ctx);
+static void xAmStatus(ppp_pcb * pcb, int errCode, void * ctx);
+static void xPeerStatus(ppp_pcb * pcb, int errCode, void * ctx);
+static void xUdpReceive(void * arg, struct udp_pcb * pcb, struct pbuf * p, const ip_addr_t * addr, u16_t port);
+static void xFillDatagram(uint8_t * p_buf, uint32_t seq);
+static bool xSendDatagram(bool fromAm, uint32_t seq);
+static void xServiceAm(void);
+static void xServicePeer(void);
+static bool xBringUpLink(void);
+static void xRunTraffic(const engine_t * p_engine, run_t * p_run);
+static bool xWaitForQuiet(void);
+static void xSwitchEngine(const engine_t * p_engine);
+static void xStalledDma(void);
+static void xReplay(void);
+static void xReport(const char * p_name, const run_t * p_run);
+static void xNewStart(void);
+static void xNewRxByteFromIsr(uint8_t byte);
+static void xNewTxCompleteFromIsr(void);
+static void xNewWaitForRx(TickType_t ticks);
+static void xNewPassRxToPpp(void);
+static void xOldStart(void);
+static void xOldRxByteFromIsr(uint8_t byte);
+static void xOldTxCompleteFromIsr(void);
+static void xOldWaitForRx(TickType_t ticks);
+static void xOldPassRxToPpp(void);
+static u32_t xOldOutput(const u8_t * p_data, u32_t len);
+extern err_t __real_pppos_input(ppp_pcb * ppp, u8_t * s, int l);
+
+static const engine_t xNewEngine =
+{
+    "pppLink.c", xNewStart, xNewRxByteFromIsr, xNewTxCompleteFromIsr, xNewWaitForRx, xNewPassRxToPpp, PPPLINK_output
+};
+
+static const engine_t xOldEngine =
+{
+    "2 ms poll, spin tx", xOldStart, xOldRxByteFromIsr, xOldTxCompleteFromIsr, xOldWaitForRx, xOldPassRxToPpp, xOldOutput
+};
+
+int main(int argc, char **argv)
+{
+    run_t newRun;
+    run_t oldRun;
+    pppLinkStats_t before;
+    pppLinkStats_t stats;
+    uint64_t rxLineBytes;
+    uint64_t txLineBytes;
+    uint32_t dmaStarts;
+
+    srand(41);
+
+    HOST_InitTask(&xAmTask);
+    HOST_SetCurrentTask(&xAmTask);
+    xPipeInit(&xToAm);
+    xPipeInit(&xToPeer);
+    pthread_create(&xRxIsrThread, NULL, xRxIsr, NULL);
+    pthread_create(&xDmaThread, NULL, xDma, NULL);
+
+    lwip_init();
+    PPPLINK_initRxTask();
+
+    printf("  link up over the line at %u B/s:\n", LINE_BYTES_PER_SEC);
+    xCheck(xBringUpLink() == true, "the link comes up through pppLink.c");
+    if ( (xAmUp == false) || (xPeerUp == false) )
+    {
+        printf("FAIL\n");
+        return 1;
+    }
+
+    printf("  %u datagrams of %u B each way at %u%% of the line:\n", DATAGRAMS_EACH_WAY, DATAGRAM_BYTES, LINE_LOAD_PERCENT);
+    PPPLINK_getStats(&before);
+    rxLineBytes = xRxIsrBytes;
+    txLineBytes = xDmaBytes;
+    dmaStarts = xDmaStarts;
+    xRunTraffic(&xNewEngine, &newRun);
+    xReport(xNewEngine.p_name, &newRun);
+
+    PPPLINK_getStats(&stats);
+    rxLineBytes = xRxIsrBytes - rxLineBytes;
+    txLineBytes = xDmaBytes - txLineBytes;
+    dmaStarts = xDmaStarts - dmaStarts;
+    xCheck((newRun.up.received == DATAGRAMS_EACH_WAY) && (newRun.up.damaged == 0u), "pppLink.c: every datagram to the peer arrives intact");
+    xCheck((newRun.down.received == DATAGRAMS_EACH_WAY) && (newRun.down.damaged == 0u), "pppLink.c: every datagram from the peer arrives intact");
+    xCheck((stats.rxOverflows == 0u) && (stats.txDropped == 0u), "pppLink.c: no rx overflow, no tx drop");
+    xCheck(xDmaBusy == 0u, "the DMA is never started under a running transfer");
+    xCheck((stats.rxBytes - before.rxBytes) == rxLineBytes, "the rx byte count is what the line delivered");
+    xCheck(((stats.txBytes - before.txBytes) == txLineBytes) && ((stats.txDmaStarts - before.txDmaStarts) == dmaStarts),
+           "the tx byte and DMA counts are what the line moved");
+    xCheck((stats.rxSpans - before.rxSpans) == newRun.rxCalls, "rx spans are the pppos_input calls");
+    printf("    link stats: rx %u B/s tx %u B/s, %u spans, %u dma, load %u.%u%%, %u ms\n",
+           stats.rxBytesPerSec, stats.txBytesPerSec, stats.rxSpans, stats.txDmaStarts,
+           stats.cpuLoadPermille / 10u, stats.cpuLoadPermille % 10u, stats.elapsedMs);
+    xCheck((stats.cpuLoadPermille * (uint64_t)stats.elapsedMs * 1000000u) <= ((newRun.rxCpuNs + newRun.txCpuNs) * 1000u + (stats.elapsedMs * 1000000ull)),
+           "the load figure is no more than the task CPU time measured");
+
+    xStalledDma();
+
+    xCheck(xWaitForQuiet() == true, "the link goes quiet");
+    xSwitchEngine(&xOldEngine);
+    xRunTraffic(&xOldEngine, &oldRun);
+    xReport(xOldEngine.p_name, &oldRun);
+    if ( (oldRun.up.received != DATAGRAMS_EACH_WAY) || (oldRun.down.received != DATAGRAMS_EACH_WAY) )
+    {
+        printf("    the old engine lost %u up, %u down\n", DATAGRAMS_EACH_WAY - oldRun.up.received, DATAGRAMS_EACH_WAY - oldRun.down.received);
+    }
+
+    printf("  %s against %s:\n", xNewEngine.p_name, xOldEngine.p_name);
+    printf("    throughput up %.0f%%, down %.0f%%, task CPU %.2f%%, pppos_input calls %.2f%%\n",
+           100.0 * (double)(oldRun.up.lastReceivedNs - oldRun.up.firstSentNs) / (double)(newRun.up.lastReceivedNs - newRun.up.firstSentNs),
+           100.0 * (double)(oldRun.down.lastReceivedNs - oldRun.down.firstSentNs) / (double)(newRun.down.lastReceivedNs - newRun.down.firstSentNs),
+           100.0 * (double)(newRun.rxCpuNs + newRun.txCpuNs) / (double)(oldRun.rxCpuNs + oldRun.txCpuNs),
+           100.0 * (double)newRun.rxCalls / (double)oldRun.rxCalls);
+    xCheck((newRun.up.lastReceivedNs - newRun.up.firstSentNs) <= ((oldRun.up.lastReceivedNs - oldRun.up.firstSentNs) * 105u / 100u),
+           "the upload is no slower");
+    xCheck((newRun.down.lastReceivedNs - newRun.down.firstSentNs) <= ((oldRun.down.lastReceivedNs - oldRun.down.firstSentNs) * 105u / 100u),
+           "the download is no slower");
+    xCheck((newRun.txCpuNs * 10u) < oldRun.txCpuNs, "sending takes less than a tenth of the task CPU time");
+    xCheck((newRun.rxCalls * 10u) < oldRun.rxCalls, "receiving takes less than a tenth of the pppos_input calls");
+
+    xCheck(xWaitForQuiet() == true, "the link goes quiet again");
+    xSwitchEngine(&xNewEngine);
+    xReplay();
+
+    xRunning = false;
+    pthread_join(xRxIsrThread, NULL);
+    pthread_join(xDmaThread, NULL);
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+u32_t sys_now(void)
+{
+    return xTaskGetTickCount();
+}
+
+u32_t sys_jiffies(void)
+{
+    return xTaskGetTickCount();
+}
+
+// CYCCNT is the calling thread's CPU time in ns, SystemCoreClock is 1 GHz
+DWT_Type * HOST_GetDwt(void)
+{
+    xDwt.CYCCNT = (uint32_t)xCpuNs();
+    return &xDwt;
+}
+
+// Linked with --wrap, every pppos_input() call on the AM's side is counted
+err_t __wrap_pppos_input(ppp_pcb * ppp, u8_t * s, int l)
+{
+    if ( ppp == xAm )
+    {
+        xAmRxCalls++;
+    }
+
+    return __real_pppos_input(ppp, s, l);
+}
+
+// The cell UART's transmit DMA, one transfer at a time as the HAL allows
+uint32_t UART_sendDataNonBlockingWithDma(UART_Periph_t device, uint8_t *pData, uint16_t bytesToSend)
+{
+    uint32_t status = HAL_OK;
+
+    pthread_mutex_lock(&xDmaMutex);
+    if ( (device != CELLULAR) || (xDmaLen != 0u) )
+    {
+        xDmaBusy++;
+        status = HAL_BUSY;
+    }
+    else
+    {
+        xDmaData = pData;
+        xDmaLen = bytesToSend;
+        xDmaStarts++;
+        pthread_cond_signal(&xDmaCond);
+    }
+    pthread_mutex_unlock(&xDmaMutex);
+
+    return status;
+}
+
+static uint64_t xNowNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * NS_PER_SEC) + (uint64_t)now.tv_nsec;
+}
+
+static uint64_t xCpuNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return ((uint64_t)now.tv_sec * NS_PER_SEC) + (uint64_t)now.tv_nsec;
+}
+
+static void xSleepNs(uint64_t ns)
+{
+    struct timespec delay;
+
+    delay.tv_sec = (time_t)(ns / NS_PER_SEC);
+    delay.tv_nsec = (long)(ns % NS_PER_SEC);
+    nanosleep(&delay, NULL);
+}
+
+static void xPipeInit(pipe_t * p_pipe)
+{
+    p_pipe->p_buf = malloc(PIPE_BYTES);
+    p_pipe->head = 0u;
+    p_pipe->tail = 0u;
+    pthread_mutex_init(&p_pipe->mutex, NULL);
+}
+
+static void xPipeReset(pipe_t * p_pipe)
+{
+    pthread_mutex_lock(&p_pipe->mutex);
+    p_pipe->head = 0u;
+    p_pipe->tail = 0u;
+    pthread_mutex_unlock(&p_pipe->mutex);
+}
+
+static void xPipeWrite(pipe_t * p_pipe, const uint8_t * p_data, size_t len)
+{
+    pthread_mutex_lock(&p_pipe->mutex);
+    if ( p_pipe->tail == p_pipe->head )
+    {
+        p_pipe->head = 0u;
+        p_pipe->tail = 0u;
+    }
+    if ( (p_pipe->head + len) > PIPE_BYTES )
+    {
+        printf("  the line backed up past %u bytes\n", PIPE_BYTES);
+        abort();
+    }
+    memcpy(&p_pipe->p_buf[p_pipe->head], p_data, len);
+    p_pipe->head += len;
+    pthread_mutex_unlock(&p_pipe->mutex);
+}
+
+static bool xPipeGet(pipe_t * p_pipe, uint8_t * p_byte)
+{
+    return (xPipeRead(p_pipe, p_byte, 1u) == 1u);
+}
+
+static size_t xPipeRead(pipe_t * p_pipe, uint8_t * p_data, size_t max)
+{
+    size_t len;
+
+    pthread_mutex_lock(&p_pipe->mutex);
+    len = p_pipe->head - p_pipe->tail;
+    if ( len > max )
+    {
+        len = max;
+    }
+    memcpy(p_data, &p_pipe->p_buf[p_pipe->tail], len);
+    p_pipe->tail += len;
+    pthread_mutex_unlock(&p_pipe->mutex);
+
+    return len;
+}
+
+static bool xPipeIsEmpty(pipe_t * p_pipe)
+{
+    bool isEmpty;
+
+    pthread_mutex_lock(&p_pipe->mutex);
+    isEmpty = (p_pipe->head == p_pipe->tail);
+    pthread_mutex_unlock(&p_pipe->mutex);
+
+    return isEmpty;
+}
+
+// The UART receive interrupt, a byte each time the line has delivered one
+static void * xRxIsr(void * p_arg)
+{
+    const uint64_t byteNs = NS_PER_SEC / LINE_BYTES_PER_SEC;
+    uint64_t nextNs = xNowNs();
+    uint64_t now;
+    uint8_t byte;
+
+    while ( xRunning == true )
+    {
+        now = xNowNs();
+
+        //an idle line delivers the next byte as soon as it is sent
+        if ( xPipeIsEmpty(&xToAm) == true )
+        {
+            if ( nextNs < now )
+            {
+                nextNs = now;
+            }
+        }
+
+        while ( (nextNs <= now) && (xPipeGet(&xToAm, &byte) == true) )
+        {
+            HOST_EnterCritical();
+            xEngine->p_rxByteFromIsr(byte);
+            HOST_ExitCritical();
+
+            xRxIsrBytes++;
+            nextNs += byteNs;
+        }
+
+        xSleepNs(100000u);
+    }
+
+    return NULL;
+}
+
+// The transmit DMA: the transfer takes as long as the line needs, then the tx complete interrupt runs
+static void * xDma(void * p_arg)
+{
+    struct timespec deadline;
+    const uint8_t * p_data;
+    uint32_t len;
+
+    while ( xRunning == true )
+    {
+        pthread_mutex_lock(&xDmaMutex);
+        while ( (xDmaLen == 0u) && (xRunning == true) )
+        {
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 10000000l;
+            if ( deadline.tv_nsec >= 1000000000l )
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000l;
+            }
+            pthread_cond_timedwait(&xDmaCond, &xDmaMutex, &deadline);
+        }
+        p_data = xDmaData;
+        len = xDmaLen;
+        pthread_mutex_unlock(&xDmaMutex);
+
+        if ( len == 0u )
+        {
+            continue;
+        }
+
+        xSleepNs(((uint64_t)len * NS_PER_SEC) / LINE_BYTES_PER_SEC);
+        while ( (xDmaStalled == true) && (xRunning == true) )
+        {
+            xSleepNs(1000000u);
+        }
+
+        xPipeWrite(&xToPeer, p_data, len);
+        xDmaBytes += len;
+
+        //the HAL is ready for the next transfer before the interrupt runs
+        pthread_mutex_lock(&xDmaMutex);
+        xDmaLen = 0u;
+        pthread_mutex_unlock(&xDmaMutex);
+
+        HOST_EnterCritical();
+        xEngine->p_txCompleteFromIsr();
+        HOST_ExitCritical();
+
+        //the peer runs in the same thread as the AT task, wake it for the bytes that arrived there
+        (void)xTaskNotifyGive(&xAmTask);
+    }
+
+    return NULL;
+}
+
+static u32_t xAmOutput(ppp_pcb * pcb, u8_t * data, u32_t len, void * ctx)
+{
+    return xEngine->p_output(data, len);
+}
+
+static u32_t xPeerOutput(ppp_pcb * pcb, u8_t * data, u32_t len, void * ctx)
+{
+    if ( xCapturing == true )
+    {
+        memcpy(&xCapture[xCaptureLen], data, len);
+        xCaptureLen += len;
+    }
+    else
+    {
+        xPipeWrite(&xToAm, data, len);
+    }
+
+    return len;
+}
+
+static void xAmStatus(ppp_pcb * pcb, int errCode, void * ctx)
+{
+    xAmUp = (errCode == PPPERR_NONE);
+}
+
+static void xPeerStatus(ppp_pcb * pcb, int errCode, void * ctx)
+{
+    xPeerUp = (errCode == PPPERR_NONE);
+}
+
+// Both ends count what reaches them, the first 4 bytes are the sequence number
+static void xUdpReceive(void * arg, struct udp_pcb * pcb, struct pbuf * p, const ip_addr_t * addr, u16_t port)
+{
+    uint8_t expected[DATAGRAM_BYTES];
+    uint8_t got[DATAGRAM_BYTES];
+    flow_t * p_flow;
+    uint32_t seq = 0u;
+
+    if ( (p->tot_len == DATAGRAM_BYTES) && (pbuf_copy_partial(p, got, DATAGRAM_BYTES, 0u) == DATAGRAM_BYTES) )
+    {
+        memcpy(&seq, got, sizeof(seq));
+        xFillDatagram(expected, seq);
+    }
+
+    if ( xRun != NULL )
+    {
+        p_flow = (pcb == xPeerUdp) ? &xRun->up : &xRun->down;
+        if ( (p->tot_len == DATAGRAM_BYTES) && (memcmp(got, expected, DATAGRAM_BYTES) == 0) )
+        {
+            p_flow->received++;
+            p_flow->lastReceivedNs = xNowNs();
+        }
+        else
+        {
+            p_flow->damaged++;
+        }
+    }
+
+    pbuf_free(p);
+}
+
+// Pseudo random bytes from the sequence number, so the HDLC escapes land anywhere
+static void xFillDatagram(uint8_t * p_buf, uint32_t seq)
+{
+    uint32_t state = (seq * 2654435761u) + 41u;
+    uint32_t i;
+
+    memcpy(p_buf, &seq, sizeof(seq));
+    for ( i = sizeof(seq); i < DATAGRAM_BYTES; i++ )
+    {
+        state = (state * 1103515245u) + 12345u;
+        p_buf[i] = (uint8_t)(state >> 16);
+    }
+}
+
+static bool xSendDatagram(bool fromAm, uint32_t seq)
+{
+    struct pbuf * p;
+    ip_addr_t to;
+    err_t err;
+
+    p = pbuf_alloc(PBUF_TRANSPORT, DATAGRAM_BYTES, PBUF_RAM);
+    if ( p == NULL )
+    {
+        return false;
+    }
+    xFillDatagram((uint8_t *)p->payload, seq);
+
+    if ( fromAm == true )
+    {
+        ip_addr_copy_from_ip4(to, *netif_ip4_gw(&xAmNetif));
+        err = udp_sendto_if(xAmUdp, p, &to, PEER_PORT, &xAmNetif);
+    }
+    else
+    {
+        ip_addr_copy_from_ip4(to, *netif_ip4_gw(&xPeerNetif));
+        err = udp_sendto_if(xPeerUdp, p, &to, AM_PORT, &xPeerNetif);
+    }
+    pbuf_free(p);
+
+    return (err == ERR_OK);
+}
+
+// The ppp branch of the AT task, timed on the task's CPU clock
+static void xServiceAm(void)
+{
+    uint64_t start = xCpuNs();
+
+    xEngine->p_passRxToPpp();
+
+    if ( xRun != NULL )
+    {
+        xRun->rxCpuNs += xCpuNs() - start;
+    }
+}
+
+// The modem and the network behind it, not part of the AM's time
+static void xServicePeer(void)
+{
+    uint8_t buf[512];
+    size_t len;
+
+    while ( (len = xPipeRead(&xToPeer, buf, sizeof(buf))) != 0u )
+    {
+        pppos_input(xPeer, buf, (int)len);
+    }
+
+    sys_check_timeouts();
+}
+
+static bool xBringUpLink(void)
+{
+    ip4_addr_t peerAddr;
+    ip4_addr_t amAddr;
+    TickType_t start;
+
+    //nwStackFunctionality.c starts the link I/O before it connects
+    xEngine->p_start();
+
+    xAm = pppos_create(&xAmNetif, xAmOutput, xAmStatus, NULL);
+    xPeer = pppos_create(&xPeerNetif, xPeerOutput, xPeerStatus, NULL);
+
+    IP4_ADDR(&peerAddr, 10, 64, 64, 1);
+    IP4_ADDR(&amAddr, 10, 64, 64, 2);
+    ppp_set_ipcp_ouraddr(xPeer, &peerAddr);
+    ppp_set_ipcp_hisaddr(xPeer, &amAddr);
+
+    ppp_listen(xPeer);
+    ppp_connect(xAm, 0);
+
+    start = xTaskGetTickCount();
+    while ( ((xAmUp == false) || (xPeerUp == false)) && ((xTaskGetTickCount() - start) < LINK_UP_TIMEOUT_MS) )
+    {
+        xEngine->p_waitForRx(10u);
+        xServiceAm();
+        xServicePeer();
+    }
+
+    if ( (xAmUp == false) || (xPeerUp == false) )
+    {
+        return false;
+    }
+
+    printf("    up in %u ms, AM %s\n", xTaskGetTickCount() - start, ip4addr_ntoa(netif_ip4_addr(&xAmNetif)));
+
+    xAmUdp = udp_new();
+    udp_bind(xAmUdp, IP_ADDR_ANY, AM_PORT);
+    udp_recv(xAmUdp, xUdpReceive, NULL);
+    xPeerUdp = udp_new();
+    udp_bind(xPeerUdp, IP_ADDR_ANY, PEER_PORT);
+    udp_recv(xPeerUdp, xUdpReceive, NULL);
+
+    return true;
+}
+
+// Datagrams both ways on a fixed schedule until every one is in or the time runs out
+static void xRunTraffic(const engine_t * p_engine, run_t * p_run)
+{
+    //a datagram, its headers, the ppp framing and about 1% escapes
+    const uint64_t intervalNs = ((uint64_t)(DATAGRAM_BYTES + 50u) * NS_PER_SEC * 100u) / ((uint64_t)LINE_BYTES_PER_SEC * LINE_LOAD_PERCENT);
+    uint64_t start;
+    uint64_t now;
+    uint64_t due;
+    uint64_t cpu;
+    uint32_t waitMs;
+
+    memset(p_run, 0, sizeof(*p_run));
+    xAmRxCalls = 0u;
+    xRxIsrWakes = 0u;
+    xRun = p_run;
+    start = xNowNs();
+
+    while ( ((p_run->up.received + p_run->up.damaged) < DATAGRAMS_EACH_WAY) ||
+            ((p_run->down.received + p_run->down.damaged) < DATAGRAMS_EACH_WAY) )
+    {
+        now = xNowNs();
+        if ( (now - start) > ((uint64_t)TRAFFIC_TIMEOUT_MS * 1000000u) )
+        {
+            break;
+        }
+
+        due = start + (p_run->up.sent * intervalNs);
+        if ( (p_run->up.sent < DATAGRAMS_EACH_WAY) && (now >= due) )
+        {
+            if ( p_run->up.sent == 0u )
+            {
+                p_run->up.firstSentNs = now;
+            }
+            cpu = xCpuNs();
+            (void)xSendDatagram(true, p_run->up.sent);
+            p_run->txCpuNs += xCpuNs() - cpu;
+            p_run->up.sent++;
+        }
+
+        due = start + (p_run->down.sent * intervalNs);
+        if ( (p_run->down.sent < DATAGRAMS_EACH_WAY) && (now >= due) )
+        {
+            if ( p_run->down.sent == 0u )
+            {
+                p_run->down.firstSentNs = now;
+            }
+            (void)xSendDatagram(false, p_run->down.sent);
+            p_run->down.sent++;
+        }
+
+        //sleep until the next send at the latest, once everything is sent until something arrives
+        now = xNowNs();
+        due = start + (((p_run->up.sent < p_run->down.sent) ? p_run->up.sent : p_run->down.sent) * intervalNs);
+        waitMs = PPP_RX_WAIT_MS;
+        if ( (p_run->up.sent < DATAGRAMS_EACH_WAY) || (p_run->down.sent < DATAGRAMS_EACH_WAY) )
+        {
+            waitMs = (due > now) ? (uint32_t)(((due - now) + 999999u) / 1000000u) : 0u;
+            waitMs = (waitMs < PPP_RX_WAIT_MS) ? waitMs : PPP_RX_WAIT_MS;
+        }
+        p_engine->p_waitForRx(waitMs);
+
+        xServiceAm();
+        xServicePeer();
+    }
+
+    p_run->elapsedNs = xNowNs() - start;
+    p_run->rxWakes = xRxIsrWakes;
+    p_run->rxCalls = xAmRxCalls;
+    xRun = NULL;
+}
+
+// Nothing on the line, nothing in the DMA and nothing left for either pcb
+static bool xWaitForQuiet(void)
+{
+    TickType_t start = xTaskGetTickCount();
+    uint32_t quietPasses = 0u;
+    bool dmaIdle;
+
+    while ( (quietPasses < 20u) && ((xTaskGetTickCount() - start) < QUIET_TIMEOUT_MS) )
+    {
+        xEngine->p_waitForRx(5u);
+        xServiceAm();
+        xServicePeer();
+
+        pthread_mutex_lock(&xDmaMutex);
+        dmaIdle = (xDmaLen == 0u);
+        pthread_mutex_unlock(&xDmaMutex);
+
+        if ( (dmaIdle == true) && (xPipeIsEmpty(&xToAm) == true) && (xPipeIsEmpty(&xToPeer) == true) )
+        {
+            quietPasses++;
+        }
+        else
+        {
+            quietPasses = 0u;
+        }
+    }
+
+    return (quietPasses >= 20u);
+}
+
+static void xSwitchEngine(const engine_t * p_engine)
+{
+    HOST_EnterCritical();
+    xEngine = p_engine;
+    p_engine->p_start();
+    HOST_ExitCritical();
+}
+
+// The modem stops taking bytes: the ring fills, the next chunk waits for space as long as pppLink.c
+// allows and is dropped, and the link carries on once the DMA moves again. The chunks are HDLC flags,
+// which the peer skips.
+static void xStalledDma(void)
+{
+    uint8_t flags[STALL_CHUNK_BYTES];
+    pppLinkStats_t before;
+    pppLinkStats_t after;
+    uint32_t accepted = 0u;
+    uint32_t i;
+    uint64_t start;
+    uint64_t waitedMs;
+    u32_t result;
+
+    memset(flags, 0x7E, sizeof(flags));
+    PPPLINK_getStats(&before);
+    xDmaStalled = true;
+
+    for ( i = 0u; i < STALL_CHUNKS; i++ )
+    {
+        accepted += (PPPLINK_output(flags, sizeof(flags)) == sizeof(flags)) ? 1u : 0u;
+    }
+
+    start = xNowNs();
+    result = PPPLINK_output(flags, sizeof(flags));
+    waitedMs = (xNowNs() - start) / 1000000u;
+
+    xDmaStalled = false;
+    PPPLINK_getStats(&after);
+
+    printf("  a stalled DMA:\n");
+    xCheck(accepted == STALL_CHUNKS, "chunks that fit the ring are taken at once");
+    printf("    %u chunks of %u B queued, the next one waited %u ms\n", accepted, STALL_CHUNK_BYTES, (uint32_t)waitedMs);
+    //the timeout is counted in ticks, a tick short of it on this clock is still the timeout
+    xCheck((result == 0u) && (waitedMs >= (TX_SPACE_TIMEOUT_MS - 1u)) && (waitedMs < (TX_SPACE_TIMEOUT_MS * 2u)), "a chunk that does not fit waits out the timeout and fails");
+    xCheck((after.txDropped - before.txDropped) == STALL_CHUNK_BYTES, "the dropped bytes are counted");
+    xCheck(PPPLINK_output(xTooLong, sizeof(xTooLong)) == 0u, "a chunk larger than the ring is refused");
+}
+
+// The peer's side of a download, captured, then fed to the AM's pcb with no line in between. The
+// interrupt's share runs too, the ring or the old buffer, with the task called the way it would be:
+// pppLink.c when its notification is pending, the old engine every 2 ms worth of bytes.
+static void xReplay(void)
+{
+    const uint32_t pollBytes = (LINE_BYTES_PER_SEC * OLD_POLLING_RATE_MS) / 1000u;
+    const engine_t * engines[2] = { &xOldEngine, &xNewEngine };
+    run_t run;
+    uint64_t bestTotalNs[2];
+    uint64_t bestTaskNs[2];
+    uint32_t calls[2];
+    uint32_t received[2];
+    uint64_t start;
+    uint64_t total;
+    uint64_t task;
+    uint64_t cpu;
+    uint32_t e;
+    uint32_t r;
+    size_t i;
+
+    xCapture = malloc(PIPE_BYTES * 4u);
+    xCaptureLen = 0u;
+    xCapturing = true;
+    for ( i = 0u; i < REPLAY_DATAGRAMS; i++ )
+    {
+        (void)xSendDatagram(false, (uint32_t)i);
+    }
+    xCapturing = false;
+
+    printf("  replay of %u datagrams from the peer, %u bytes, %.1f s of line, %.1f%% headers, framing and escapes:\n",
+           REPLAY_DATAGRAMS, (uint32_t)xCaptureLen, (double)xCaptureLen / LINE_BYTES_PER_SEC,
+           100.0 * (double)(xCaptureLen - (REPLAY_DATAGRAMS * DATAGRAM_BYTES)) / (double)(REPLAY_DATAGRAMS * DATAGRAM_BYTES));
+
+    for ( e = 0u; e < 2u; e++ )
+    {
+        bestTotalNs[e] = UINT64_MAX;
+        bestTaskNs[e] = UINT64_MAX;
+
+        for ( r = 0u; r < REPLAY_RUNS; r++ )
+        {
+            memset(&run, 0, sizeof(run));
+            xRun = &run;
+            engines[e]->p_start();
+            xAmRxCalls = 0u;
+            task = 0u;
+            start = xCpuNs();
+
+            for ( i = 0u; i < xCaptureLen; i++ )
+            {
+                engines[e]->p_rxByteFromIsr(xCapture[i]);
+
+                if ( ((engines[e] == &xNewEngine) && (xAmTask.notifyValue != 0u)) ||
+                     ((engines[e] == &xOldEngine) && (((i + 1u) % pollBytes) == 0u)) || ((i + 1u) == xCaptureLen) )
+                {
+                    xAmTask.notifyValue = 0u;
+                    cpu = xCpuNs();
+                    engines[e]->p_passRxToPpp();
+                    task += xCpuNs() - cpu;
+                }
+            }
+
+            total = xCpuNs() - start;
+            bestTotalNs[e] = (total < bestTotalNs[e]) ? total : bestTotalNs[e];
+            bestTaskNs[e] = (task < bestTaskNs[e]) ? task : bestTaskNs[e];
+            calls[e] = xAmRxCalls;
+            received[e] = run.down.received;
+            xRun = NULL;
+        }
+
+        printf("    %-20s %8u pppos_input calls, task %5.1f ns a byte, with the interrupt %5.1f MB/s, %u/%u datagrams\n",
+               engines[e]->p_name, calls[e], (double)bestTaskNs[e] / (double)xCaptureLen,
+               ((double)xCaptureLen * 1000.0) / (double)bestTotalNs[e], received[e], REPLAY_DATAGRAMS);
+    }
+
+    xCheck((received[0] == REPLAY_DATAGRAMS) && (received[1] == REPLAY_DATAGRAMS), "every replayed datagram arrives either way");
+    xCheck((calls[1] * 100u) < calls[0], "spans need less than 1% of the pppos_input calls");
+    xCheck(bestTaskNs[1] <= ((bestTaskNs[0] * 110u) / 100u), "spans cost the task no more a byte");
+
+    free(xCapture);
+}
+
+static void xReport(const char * p_name, const run_t * p_run)
+{
+    printf("    %-20s up %u/%u %5.0f B/s, down %u/%u %5.0f B/s, task CPU rx %6.1f ms tx %7.1f ms (%4.1f%% of %.1f s), %6u pppos_input calls, %5u rx wakes\n",
+           p_name,
+           p_run->up.received, p_run->up.sent,
+           ((double)p_run->up.received * DATAGRAM_BYTES * NS_PER_SEC) / (double)(p_run->up.lastReceivedNs - p_run->up.firstSentNs),
+           p_run->down.received, p_run->down.sent,
+           ((double)p_run->down.received * DATAGRAM_BYTES * NS_PER_SEC) / (double)(p_run->down.lastReceivedNs - p_run->down.firstSentNs),
+           (double)p_run->rxCpuNs / 1e6, (double)p_run->txCpuNs / 1e6,
+           100.0 * (double)(p_run->rxCpuNs + p_run->txCpuNs) / (double)p_run->elapsedNs, (double)p_run->elapsedNs / 1e9,
+           p_run->rxCalls, p_run->rxWakes);
+}
+
+static void xNewStart(void)
+{
+    PPPLINK_start();
+}
+
+static void xNewRxByteFromIsr(uint8_t byte)
+{
+    BaseType_t woken = pdFALSE;
+
+    PPPLINK_rxByteFromIsr(byte, &woken);
+
+    if ( woken != pdFALSE )
+    {
+        xRxIsrWakes++;
+    }
+}
+
+// NW_txComplete() less the AT command receive re-arm
+static void xNewTxCompleteFromIsr(void)
+{
+    BaseType_t woken = pdFALSE;
+    bool released;
+
+    released = PPPLINK_releaseSentFromIsr(&woken);
+    PPPLINK_chainTxFromIsr(released);
+}
+
+static void xNewWaitForRx(TickType_t ticks)
+{
+    (void)ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+static void xNewPassRxToPpp(void)
+{
+    PPPLINK_passRxToPpp(xAm);
+}
+
+static void xOldStart(void)
+{
+    xOldRxHead = 0u;
+    xOldRxTail = 0u;
+    xOldTransmitting = false;
+}
+
+static void xOldRxByteFromIsr(uint8_t byte)
+{
+    xOldRxBuffer[xOldRxHead] = byte;
+
+    xOldRxHead++;
+    if ( xOldRxHead >= OLD_RX_BUFFER_BYTES )
+    {
+        xOldRxHead = 0u;
+    }
+}
+
+static void xOldTxCompleteFromIsr(void)
+{
+    xOldTransmitting = false;
+}
+
+// The old task slept 2 ms whatever was waiting
+static void xOldWaitForRx(TickType_t ticks)
+{
+    xSleepNs(OLD_POLLING_RATE_MS * 1000000ull);
+    xRxIsrWakes++;
+}
+
+static void xOldPassRxToPpp(void)
+{
+    while ( xOldRxHead != xOldRxTail )
+    {
+        pppos_input(xAm, &xOldRxBuffer[xOldRxTail], sizeof(uint8_t));
+
+        xOldRxTail++;
+        if ( xOldRxTail >= OLD_RX_BUFFER_BYTES )
+        {
+            xOldRxTail = 0u;
+        }
+    }
+}
+
+// The old output callback. The flag is volatile here, the firmware's was not and only worked because the
+// loop compiled to a load each pass.
+static u32_t xOldOutput(const u8_t * p_data, u32_t len)
+{
+    uint32_t msTimeout = 0u;
+
+    xOldTransmitting = true;
+
+    if ( UART_sendDataNonBlockingWithDma(CELLULAR, (uint8_t *)p_data, (uint16_t)len) == HAL_OK )
+    {
+        while ( (xOldTransmitting == true) && (msTimeout <= OLD_TX_TIMEOUT_SPINS) )
+        {
+            msTimeout++;
+        }
+
+        if ( xOldTransmitting == true )
+        {
+            len = 0u;
+        }
+    }
+    else
+    {
+        len = 0u;
+    }
+
+    return len;
+}
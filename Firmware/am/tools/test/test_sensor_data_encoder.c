@@ -0,0 +1,476 @@
+/**************************************************************************************************
+* \file     test_sensor_data_encoder.c
+* \brief    Host test of the sensor data log encoder against the message struct path it replaced
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include "pb_encode.h"
+#include "pb_decode.h"
+#include "messages.pb.h"
+#include "host_am.h"
+#include "sensorDataEncoder.h"
+
+// The old path is kept below as it was in eventManager.c and mqttHandler.c before SDENC_encodeLog(): fill a
+// SensorDataMessage from the log with the hourly arrays widened into uint32 copies, pass it by value to
+// MQTT_sendSensorDataMsg(), which passes it by value again to the encode helper, then pb_encode().
+//
+// Both paths encode the same logs, with stroke detection on and off, and the bytes have to be identical:
+// all zero, all 0xFF, random records and a day of pumping. The new bytes are decoded too, to check
+// humidity is still left out and the stroke arrays only go out with stroke detection on. Both also have
+// to give up cleanly when the buffer is one byte short.
+//
+// Then the cost of each path per publish: peak stack from the log to the encoded bytes (run on a painted
+// stack), the struct bytes built and copied on the way to pb_encode, and the time per encode. The stack
+// and the times are the host's (x86-64, gcc -O2).
+//
+// Usage: test_sensor_data_encoder
+
+#define RANDOM_RECORDS              20000u
+#define PAINT_STACK_SIZE            65536u
+#define PAINT_BYTE                  0xA5u
+#define BENCH_ITERATIONS            20000u
+#define NUM_STATES                  3u
+#define STROKE_DETECTION_ON         true
+
+static APP_NVM_SENSOR_DATA_WITH_HEADER_T xLog;
+static bool xSendStrokes;
+static uint8_t xOldBuf[SensorDataMessage_size];
+static uint8_t xNewBuf[SensorDataMessage_size];
+static uint32_t xOldLen;
+static uint32_t xNewLen;
+static uint16_t xOldBufLen = sizeof(xOldBuf);
+
+static uint8_t xPaintStack[PAINT_STACK_SIZE];
+static ucontext_t xMainContext;
+static ucontext_t xJobContext;
+static void (*xPaintJob)(void);
+
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static void xFillHeader(CommonHeader * p_header);
+static uint32_t xOldEncodePayload(SensorDataMessage message, uint8_t * buf, uint16_t bufLen);
+static uint32_t xOldSendSensorDataMsg(SensorDataMessage message);
+static void xOldPath(void);
+static void xNewPath(void);
+static void xFillLog(uint32_t kind);
+static bool xSameBytes(void);
+static void xEquivalence(void);
+static void xDecodeChecks(void);
+static void xShortBuffer(void);
+static void xPaintTrampoline(void);
+static uint32_t xStackUse(void (*p_job)(void));
+static double xTimeNs(void (*p_job)(void));
+static void xCost(void);
+
+int main(int argc, char **argv)
+{
+    srand(40);
+
+    printf("  byte identical to the message struct path:\n");
+    xEquivalence();
+
+    printf("  what goes on the wire:\n");
+    xDecodeChecks();
+    xShortBuffer();
+
+    printf("  cost per publish:\n");
+    xCost();
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// The header as xPackageAndSendSensorDataToCloud() fills it, the same for both paths
+static void xFillHeader(CommonHeader * p_header)
+{
+    *p_header = (CommonHeader)CommonHeader_init_default;
+
+    p_header->productId = xLog.productId;
+    p_header->timestamp = xLog.timestamp;
+    p_header->msgNumber = xLog.msgNumber;
+    p_header->fwMajor = xLog.fwVersionMaj;
+    p_header->fwMinor = xLog.fwVersionMinor;
+    p_header->fwBuild = xLog.fwVersionBuild;
+    p_header->voltage = (uint32_t)xLog.batteryVoltage;
+    p_header->powerRemaining = (uint32_t)xLog.powerRemaining;
+    p_header->state = (eState)xLog.state;
+    p_header->activatedDate = xLog.activatedDate;
+    p_header->magnetDetected = xLog.magnetDetected;
+    p_header->errorBits = xLog.errorBits;
+    p_header->numSSMResets = xLog.numSSMResets;
+    p_header->lastSSMResetDate = xLog.lastSSMResetDate;
+    p_header->numAMResets = xLog.numAMResets;
+    p_header->lastAMResetDate = xLog.lastAMResetDate;
+
+    p_header->rssi = 17u;
+    p_header->connectTime = 41234u;
+    p_header->imei = 352656100123456ull;
+    p_header->mfgComplete = true;
+
+    p_header->has_activatedDate = true;
+    p_header->has_connectTime = true;
+    p_header->has_errorBits = true;
+    p_header->has_lastAMResetDate = true;
+    p_header->has_lastSSMResetDate = true;
+    p_header->has_magnetDetected = true;
+    p_header->has_mfgComplete = true;
+    p_header->has_numAMResets = true;
+    p_header->has_numSSMResets = true;
+    p_header->has_powerRemaining = true;
+    p_header->has_rssi = true;
+    p_header->has_state = true;
+    p_header->has_voltage = true;
+}
+
+// The old mqttHandler.c helper, the message comes in by value
+static __attribute__((noinline)) uint32_t xOldEncodePayload(SensorDataMessage message, uint8_t * buf, uint16_t bufLen)
+{
+    pb_ostream_t stream = pb_ostream_from_buffer(buf, bufLen);
+    bool status = pb_encode(&stream, SensorDataMessage_fields, &message);
+
+    return (status == true) ? stream.bytes_written : 0u;
+}
+
+// The old MQTT_sendSensorDataMsg(), by value again, the publish itself is left out
+static __attribute__((noinline)) uint32_t xOldSendSensorDataMsg(SensorDataMessage message)
+{
+    return xOldEncodePayload(message, xOldBuf, xOldBufLen);
+}
+
+// The old xPackageAndSendSensorDataToCloud() body
+static __attribute__((noinline)) void xOldPath(void)
+{
+    SensorDataMessage message = SensorDataMessage_init_default;
+    uint32_t formattedLiters[APP_NVM_SAMPLES_PER_DAY];
+    uint32_t formattedTemp[APP_NVM_SAMPLES_PER_DAY];
+    uint32_t formattedHumidity[APP_NVM_SAMPLES_PER_DAY];
+    uint32_t formattedStrokes[APP_NVM_SAMPLES_PER_DAY];
+    uint32_t formattedStrokeHeight[APP_NVM_SAMPLES_PER_DAY];
+    uint8_t i;
+
+    xFillHeader(&message.header);
+
+    for ( i = 0; i < APP_NVM_SAMPLES_PER_DAY; i++ )
+    {
+        formattedLiters[i] = (uint32_t)xLog.litersPerHour[i];
+        formattedTemp[i] = (uint32_t)xLog.tempPerHour[i];
+        formattedHumidity[i] = (uint32_t)xLog.humidityPerHour[i];
+        formattedStrokes[i] = (uint32_t)xLog.strokesPerHour[i];
+        formattedStrokeHeight[i] = (uint32_t)xLog.strokeHeightPerHour[i];
+    }
+    memcpy(&message.litersPerHour, &formattedLiters, sizeof(message.litersPerHour));
+    memcpy(&message.tempPerHour, &formattedTemp, sizeof(message.tempPerHour));
+    memcpy(&message.humidityPerHour, &formattedHumidity, sizeof(message.humidityPerHour));
+    memcpy(&message.strokesPerHour, &formattedStrokes, sizeof(message.strokesPerHour));
+    memcpy(&message.strokeHeightPerHour, &formattedStrokeHeight, sizeof(message.strokeHeightPerHour));
+    message.dailyLiters = xLog.dailyLiters;
+    message.avgLiters = xLog.avgLiters;
+    message.totalLiters = xLog.totalLiters;
+    message.breakdown = xLog.breakdown;
+    message.pumpCapacity = xLog.pumpCapacity;
+    message.pumpUnusedTime = xLog.pumpUnusedTime;
+    message.pumpUsage = xLog.pumpUsage;
+    message.dryStrokes = xLog.dryStrokes;
+    message.dryStrokeHeight = xLog.dryStrokeHeight;
+
+    message.has_avgLiters = true;
+    message.has_breakdown = true;
+    message.has_dailyLiters = true;
+    message.humidityPerHour_count = 0;
+    message.litersPerHour_count = APP_NVM_SAMPLES_PER_DAY;
+    message.has_pumpCapacity = true;
+    message.tempPerHour_count = APP_NVM_SAMPLES_PER_DAY;
+    message.has_totalLiters = true;
+    message.has_pumpUnusedTime = true;
+    message.has_pumpUsage = true;
+    message.has_dryStrokes = true;
+    message.has_dryStrokeHeight = true;
+    message.strokeHeightPerHour_count = (xSendStrokes == true) ? APP_NVM_SAMPLES_PER_DAY : 0;
+    message.strokesPerHour_count = (xSendStrokes == true) ? APP_NVM_SAMPLES_PER_DAY : 0;
+
+    xOldLen = xOldSendSensorDataMsg(message);
+}
+
+// The new xPackageAndSendSensorDataToCloud() and MQTT_sendSensorDataLog()
+static __attribute__((noinline)) void xNewPath(void)
+{
+    CommonHeader header;
+
+    xFillHeader(&header);
+    xNewLen = SDENC_encodeLog(&header, &xLog, xSendStrokes, xNewBuf, sizeof(xNewBuf));
+}
+
+// 0: all zero, 1: all 0xFF, 2: random, 3: a day of pumping from 07:00 to 18:00
+static void xFillLog(uint32_t kind)
+{
+    uint8_t * p_bytes = (uint8_t *)&xLog;
+    uint32_t hour = 0u;
+    bool pumping = false;
+    size_t i = 0u;
+
+    for ( i = 0u; i < sizeof(xLog); i++ )
+    {
+        p_bytes[i] = (kind == 0u) ? 0x00u : ((kind == 1u) ? 0xFFu : (uint8_t)rand());
+    }
+
+    //the fields the firmware only ever stores as 0/1 or a state
+    xLog.breakdown = (kind == 1u) || ((kind == 2u) && ((rand() & 1) != 0));
+    xLog.magnetDetected = (kind == 1u) || ((kind == 2u) && ((rand() & 1) != 0));
+    xLog.state = (uint8_t)(xLog.state % NUM_STATES);
+    xLog.debugLog[0] = '\0';
+
+    if ( kind == 3u )
+    {
+        memset(&xLog, 0, sizeof(xLog));
+        xLog.productId = 4u;
+        xLog.timestamp = 1790000000u;
+        xLog.msgNumber = 812u;
+        xLog.fwVersionMaj = 1u;
+        xLog.fwVersionMinor = 2u;
+        xLog.fwVersionBuild = 345u;
+        xLog.batteryVoltage = 3600u;
+        xLog.powerRemaining = 87u;
+        xLog.activatedDate = 1780000000u;
+        xLog.magnetDetected = true;
+        for ( hour = 0u; hour < APP_NVM_SAMPLES_PER_DAY; hour++ )
+        {
+            pumping = (hour > 6u) && (hour < 19u);
+            xLog.litersPerHour[hour] = pumping ? (uint16_t)(40u + hour * 3u) : 0u;
+            xLog.tempPerHour[hour] = (uint8_t)(24u + hour % 5u);
+            xLog.humidityPerHour[hour] = (uint8_t)(60u + hour % 7u);
+            xLog.strokesPerHour[hour] = pumping ? (uint16_t)(300u + hour * 11u) : 0u;
+            xLog.strokeHeightPerHour[hour] = pumping ? 120u : 0u;
+        }
+        xLog.dailyLiters = 812u;
+        xLog.avgLiters = 790u;
+        xLog.totalLiters = 412345u;
+        xLog.pumpCapacity = 55u;
+        xLog.pumpUsage = 31u;
+        xLog.dryStrokes = 12u;
+        xLog.dryStrokeHeight = 4u;
+        xLog.pumpUnusedTime = 3u;
+    }
+}
+
+static bool xSameBytes(void)
+{
+    memset(xOldBuf, 0, sizeof(xOldBuf));
+    memset(xNewBuf, 0, sizeof(xNewBuf));
+    xOldPath();
+    xNewPath();
+
+    return (xOldLen != 0u) && (xOldLen == xNewLen) && (memcmp(xOldBuf, xNewBuf, xOldLen) == 0);
+}
+
+static void xEquivalence(void)
+{
+    static const char * const kindNames[] = { "all zero", "all 0xFF", "random", "a day of pumping" };
+    char what[128];
+    uint32_t kind = 0u;
+    uint32_t record = 0u;
+    uint32_t records = 0u;
+    uint32_t encodes = 0u;
+    uint32_t mismatches = 0u;
+    uint32_t strokes = 0u;
+
+    for ( kind = 0u; kind < 4u; kind++ )
+    {
+        records = (kind == 2u) ? RANDOM_RECORDS : 1u;
+        encodes = 0u;
+        mismatches = 0u;
+
+        for ( record = 0u; record < records; record++ )
+        {
+            xFillLog(kind);
+            for ( strokes = 0u; strokes < 2u; strokes++ )
+            {
+                xSendStrokes = (strokes != 0u);
+                if ( xSameBytes() == false )
+                {
+                    if ( mismatches == 0u )
+                    {
+                        printf("  first mismatch: record %u, strokes %u, %u vs %u bytes\n", record, strokes, xOldLen, xNewLen);
+                    }
+                    mismatches++;
+                }
+                encodes++;
+            }
+        }
+
+        snprintf(what, sizeof(what), "%s: %u encodes, strokes on and off, %u differ", kindNames[kind], encodes, mismatches);
+        xCheck(mismatches == 0u, what);
+    }
+}
+
+static void xDecodeChecks(void)
+{
+    static SensorDataMessage decoded;
+    pb_istream_t stream;
+    bool decodeOk = false;
+    bool sameValues = true;
+    uint32_t hour = 0u;
+
+    xFillLog(3u);
+    xSendStrokes = STROKE_DETECTION_ON;
+    xNewPath();
+
+    memset(&decoded, 0, sizeof(decoded));
+    stream = pb_istream_from_buffer(xNewBuf, xNewLen);
+    decodeOk = pb_decode(&stream, SensorDataMessage_fields, &decoded);
+    xCheck(decodeOk && (stream.bytes_left == 0u), "a day of pumping decodes as a SensorDataMessage");
+
+    for ( hour = 0u; hour < APP_NVM_SAMPLES_PER_DAY; hour++ )
+    {
+        sameValues = sameValues &&
+                     (decoded.litersPerHour[hour] == xLog.litersPerHour[hour]) &&
+                     (decoded.tempPerHour[hour] == xLog.tempPerHour[hour]) &&
+                     (decoded.strokesPerHour[hour] == xLog.strokesPerHour[hour]) &&
+                     (decoded.strokeHeightPerHour[hour] == xLog.strokeHeightPerHour[hour]);
+    }
+    xCheck(sameValues && (decoded.litersPerHour_count == APP_NVM_SAMPLES_PER_DAY) &&
+           (decoded.tempPerHour_count == APP_NVM_SAMPLES_PER_DAY), "hourly values come back as stored");
+    xCheck(decoded.humidityPerHour_count == 0u, "humidity is left out");
+    xCheck((decoded.strokesPerHour_count == APP_NVM_SAMPLES_PER_DAY) &&
+           (decoded.strokeHeightPerHour_count == APP_NVM_SAMPLES_PER_DAY), "stroke arrays go out with stroke detection on");
+    xCheck((decoded.header.msgNumber == xLog.msgNumber) && (decoded.header.rssi == 17u) &&
+           (decoded.dailyLiters == xLog.dailyLiters) && (decoded.totalLiters == xLog.totalLiters) &&
+           (decoded.pumpUnusedTime == xLog.pumpUnusedTime), "header and totals come back as stored");
+
+    xSendStrokes = !STROKE_DETECTION_ON;
+    xNewPath();
+    memset(&decoded, 0, sizeof(decoded));
+    stream = pb_istream_from_buffer(xNewBuf, xNewLen);
+    decodeOk = pb_decode(&stream, SensorDataMessage_fields, &decoded);
+    xCheck(decodeOk && (decoded.strokesPerHour_count == 0u) && (decoded.strokeHeightPerHour_count == 0u),
+           "stroke arrays are left out with stroke detection off");
+}
+
+static void xShortBuffer(void)
+{
+    CommonHeader header;
+    uint32_t fullLen = 0u;
+    uint32_t shortLen = 0u;
+
+    xFillLog(1u);
+    xSendStrokes = STROKE_DETECTION_ON;
+    xNewPath();
+    fullLen = xNewLen;
+
+    xFillHeader(&header);
+    shortLen = SDENC_encodeLog(&header, &xLog, xSendStrokes, xNewBuf, (uint16_t)(fullLen - 1u));
+    xCheck((fullLen > 0u) && (shortLen == 0u), "one byte short of the worst case log returns 0");
+
+    xOldBufLen = (uint16_t)(fullLen - 1u);
+    xOldPath();
+    xOldBufLen = sizeof(xOldBuf);
+    xCheck(xOldLen == 0u, "as the struct path did");
+}
+
+static void xPaintTrampoline(void)
+{
+    xPaintJob();
+}
+
+// Runs the job on a stack filled with PAINT_BYTE, the stack grows down so the first byte from the bottom
+// that changed is the deepest it went
+static uint32_t xStackUse(void (*p_job)(void))
+{
+    uint32_t untouched = 0u;
+
+    memset(xPaintStack, PAINT_BYTE, sizeof(xPaintStack));
+    xPaintJob = p_job;
+    getcontext(&xJobContext);
+    xJobContext.uc_stack.ss_sp = xPaintStack;
+    xJobContext.uc_stack.ss_size = sizeof(xPaintStack);
+    xJobContext.uc_link = &xMainContext;
+    makecontext(&xJobContext, xPaintTrampoline, 0);
+    swapcontext(&xMainContext, &xJobContext);
+
+    while ( (untouched < sizeof(xPaintStack)) && (xPaintStack[untouched] == PAINT_BYTE) )
+    {
+        untouched++;
+    }
+
+    return (uint32_t)(sizeof(xPaintStack) - untouched);
+}
+
+static double xTimeNs(void (*p_job)(void))
+{
+    struct timespec start;
+    struct timespec end;
+    uint32_t i = 0u;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for ( i = 0u; i < BENCH_ITERATIONS; i++ )
+    {
+        p_job();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return ((double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec)) / BENCH_ITERATIONS;
+}
+
+static void xCost(void)
+{
+    // built: the message and the five widened arrays, copied: the message into MQTT_sendSensorDataMsg()
+    // and again into the encode helper
+    uint32_t oldBytes = (uint32_t)(sizeof(SensorDataMessage) + (5u * APP_NVM_SAMPLES_PER_DAY * sizeof(uint32_t)) +
+                                   (2u * sizeof(SensorDataMessage)));
+    uint32_t newBytes = (uint32_t)sizeof(CommonHeader);
+    uint32_t oldStack = 0u;
+    uint32_t newStack = 0u;
+    double oldNs = 0.0;
+    double newNs = 0.0;
+    char what[128];
+
+    xFillLog(3u);
+    xSendStrokes = STROKE_DETECTION_ON;
+    oldStack = xStackUse(xOldPath);
+    newStack = xStackUse(xNewPath);
+    oldNs = xTimeNs(xOldPath);
+    newNs = xTimeNs(xNewPath);
+
+    printf("          %14s %14s %10s\n", "peak stack", "struct bytes", "encode");
+    printf("    old   %12u B %12u B %7.0f ns\n", oldStack, oldBytes, oldNs);
+    printf("    new   %12u B %12u B %7.0f ns\n", newStack, newBytes, newNs);
+
+    snprintf(what, sizeof(what), "peak stack %u B, under the %u B the struct path needed", newStack, oldStack);
+    xCheck(newStack < oldStack, what);
+    snprintf(what, sizeof(what), "peak stack %u B, less than one SensorDataMessage (%zu B)", newStack, sizeof(SensorDataMessage));
+    xCheck(newStack < sizeof(SensorDataMessage), what);
+}
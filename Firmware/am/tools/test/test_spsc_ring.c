@@ -0,0 +1,521 @@
+/**************************************************************************************************
+* \file     test_spsc_ring.c
+* \brief    SPSC byte ring unit checks, two thread stress and throughput
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_am.h"
+#include "semphr.h"
+#include "spscRing.h"
+
+// Checks spscRing.h on its own first: init, full and overflow, the spans around the wrap, the empty to
+// not empty transition and the free running indexes wrapping past 2^32.
+//
+// Then one thread plays the USART receive ISR and another the CLI task, for STRESS_BYTES each way of
+// running it: bytes one at a time with RING_putFromIsr(), random sized chunks with RING_writeFromIsr(),
+// and a consumer that parses in place off RING_readSpan() or copies out with RING_read(). The bytes are
+// a counter pattern, every one is checked in order. The consumer sleeps in RING_waitForData() with a
+// long timeout, a timeout while the producer still has bytes to send means a lost wakeup and fails.
+//
+// Last the throughput: span to span with no notifications, one byte per call the way the ISR uses it, and
+// the same bytes through a mutex guarded ring for comparison.
+//
+// Usage: test_spsc_ring
+
+#define UNIT_CAPACITY               64u
+#define STRESS_CAPACITY             256u
+#define STRESS_BYTES                4000000u
+#define STRESS_MAX_CHUNK            37u
+#define WAIT_TIMEOUT_MS             2000u
+#define BENCH_CAPACITY              4096u
+#define BENCH_SPAN_BYTES            400000000ull
+#define BENCH_BYTE_BYTES            40000000ull
+
+typedef enum
+{
+    PRODUCE_BYTES,
+    PRODUCE_CHUNKS,
+}produceMode_t;
+
+typedef enum
+{
+    CONSUME_SPANS,
+    CONSUME_COPY,
+}consumeMode_t;
+
+typedef struct
+{
+    spscRing_t * p_ring;
+    produceMode_t produce;
+    consumeMode_t consume;
+    uint64_t bytes;
+    uint64_t mismatchAt;            // UINT64_MAX: none
+    uint32_t timeouts;
+    uint32_t wakes;
+    uint32_t fullRetries;
+}stressRun_t;
+
+// The comparison ring, a plain ring with the critical section a mutex
+typedef struct
+{
+    uint8_t buf[BENCH_CAPACITY];
+    uint32_t head;
+    uint32_t tail;
+    StaticSemaphore_t lockBuffer;
+    SemaphoreHandle_t lock;
+}lockedRing_t;
+
+RING_DEFINE_STORAGE(xUnitStorage, UNIT_CAPACITY);
+RING_DEFINE_STORAGE(xStressStorage, STRESS_CAPACITY);
+RING_DEFINE_STORAGE(xBenchStorage, BENCH_CAPACITY);
+
+static hostTask_t xConsumerTask;
+static lockedRing_t xLocked;
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static void xUnitChecks(void);
+static uint8_t xPattern(uint64_t idx);
+static void xStress(const char * p_label, produceMode_t produce, consumeMode_t consume);
+static void * xStressProducer(void * p_arg);
+static void * xStressConsumer(void * p_arg);
+static void xBenchmark(void);
+static void * xSpanProducer(void * p_arg);
+static void * xSpanConsumer(void * p_arg);
+static void * xByteProducer(void * p_arg);
+static void * xByteConsumer(void * p_arg);
+static void * xLockedProducer(void * p_arg);
+static void * xLockedConsumer(void * p_arg);
+static double xRunPair(void * (*p_producer)(void *), void * (*p_consumer)(void *), void * p_arg);
+
+int main(int argc, char **argv)
+{
+    srand(38);
+
+    printf("  unit:\n");
+    xUnitChecks();
+
+    printf("  stress, %u bytes each through a %u byte ring:\n", STRESS_BYTES, STRESS_CAPACITY);
+    xStress("bytes from the ISR, parsed in place", PRODUCE_BYTES, CONSUME_SPANS);
+    xStress("chunks from the ISR, parsed in place", PRODUCE_CHUNKS, CONSUME_SPANS);
+    xStress("chunks from the ISR, copied out", PRODUCE_CHUNKS, CONSUME_COPY);
+
+    printf("  throughput, %u byte ring:\n", BENCH_CAPACITY);
+    xBenchmark();
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+static void xUnitChecks(void)
+{
+    spscRing_t ring;
+    uint8_t in[200];
+    uint8_t out[200];
+    const uint8_t * p_read;
+    uint8_t * p_write;
+    uint32_t len = 0u;
+
+    for ( uint32_t i = 0u; i < sizeof(in); i++ )
+    {
+        in[i] = (uint8_t)i;
+    }
+
+    xCheck(RING_init(&ring, xUnitStorage, 48u, NULL) == false, "a capacity that is not a power of two is refused");
+    xCheck(RING_init(&ring, NULL, UNIT_CAPACITY, NULL) == false, "no storage is refused");
+    xCheck(RING_init(&ring, xUnitStorage, UNIT_CAPACITY, NULL) == true, "a power of two capacity is taken");
+    xCheck((RING_count(&ring) == 0u) && (RING_space(&ring) == UNIT_CAPACITY), "a new ring is empty");
+
+    xCheck((RING_write(&ring, in, 70u) == UNIT_CAPACITY) && (ring.overflows == 6u), "a write past full stops at the capacity and counts the rest");
+    xCheck((RING_space(&ring) == 0u) && (RING_count(&ring) == UNIT_CAPACITY), "a full ring needs no spare slot");
+    xCheck(RING_putFromIsr(&ring, 0xEEu, NULL) == false, "a put into a full ring fails");
+
+    xCheck((RING_read(&ring, out, 10u) == 10u) && (memcmp(out, in, 10u) == 0), "bytes come out in order");
+    xCheck(RING_write(&ring, &in[64], 10u) == 10u, "a write wraps the end of the buffer");
+
+    p_read = RING_readSpan(&ring, &len);
+    xCheck((len == 54u) && (p_read == &xUnitStorage[10]), "the read span stops at the end of the buffer");
+    RING_commitRead(&ring, len);
+    p_read = RING_readSpan(&ring, &len);
+    xCheck((len == 10u) && (p_read == xUnitStorage) && (memcmp(p_read, &in[64], 10u) == 0), "the second read span is the wrapped part");
+
+    p_write = RING_writeSpan(&ring, &len);
+    xCheck((len == 54u) && (p_write == &xUnitStorage[10]), "the write span stops where the data is");
+    xCheck(RING_commitWrite(&ring, 0u) == false, "an empty commit is not a transition");
+    RING_commitRead(&ring, 10u);
+    p_write = RING_writeSpan(&ring, &len);
+    xCheck((len == 54u) && (p_write == &xUnitStorage[10]), "the write span of an empty ring runs to the end");
+    xCheck(RING_commitWrite(&ring, 3u) == true, "the first bytes into an empty ring are the transition");
+    xCheck(RING_commitWrite(&ring, 1u) == false, "more bytes are not");
+
+    RING_reset(&ring);
+    xCheck((RING_count(&ring) == 0u) && (RING_space(&ring) == UNIT_CAPACITY), "reset drops everything");
+
+    ring.head = 0xFFFFFFF0u;
+    ring.tail = 0xFFFFFFF0u;
+    xCheck((RING_write(&ring, in, 40u) == 40u) && (RING_count(&ring) == 40u), "the fill level is right across the index wrap");
+    xCheck((RING_read(&ring, out, 40u) == 40u) && (memcmp(out, in, 40u) == 0) && (ring.tail == 0x18u), "so are the bytes");
+
+    HOST_InitTask(&xConsumerTask);
+    HOST_SetCurrentTask(&xConsumerTask);
+    RING_init(&ring, xUnitStorage, UNIT_CAPACITY, &xConsumerTask);
+    xCheck(RING_waitForData(&ring, 0u) == false, "waiting on an empty ring times out");
+    RING_putFromIsr(&ring, 1u, NULL);
+    RING_putFromIsr(&ring, 2u, NULL);
+    xCheck(xConsumerTask.notifyValue == 1u, "only the empty to not empty transition notifies");
+    xCheck(RING_waitForData(&ring, 0u) == true, "the consumer sees the data");
+    RING_read(&ring, out, 2u);
+    RING_putFromIsr(&ring, 3u, NULL);
+    xCheck(xConsumerTask.notifyValue == 2u, "emptying the ring arms the next notification");
+    HOST_SetCurrentTask(NULL);
+}
+
+static uint8_t xPattern(uint64_t idx)
+{
+    return (uint8_t)((idx * 2654435761u) >> 24);
+}
+
+static void xStress(const char * p_label, produceMode_t produce, consumeMode_t consume)
+{
+    spscRing_t ring;
+    stressRun_t run = {0};
+    double seconds;
+    char what[128];
+
+    HOST_InitTask(&xConsumerTask);
+    RING_init(&ring, xStressStorage, STRESS_CAPACITY, &xConsumerTask);
+
+    run.p_ring = &ring;
+    run.produce = produce;
+    run.consume = consume;
+    run.bytes = STRESS_BYTES;
+    run.mismatchAt = UINT64_MAX;
+
+    seconds = xRunPair(xStressProducer, xStressConsumer, &run);
+
+    printf("    %-38s %5.2f s, %6u wakes, %7u retries on full\n", p_label, seconds, (unsigned)run.wakes, (unsigned)run.fullRetries);
+    snprintf(what, sizeof(what), "%s: every byte in order, no lost wakeup", p_label);
+    xCheck((run.mismatchAt == UINT64_MAX) && (run.timeouts == 0u) && (RING_count(&ring) == 0u), what);
+}
+
+// The receive ISR, it retries when the ring is full so the consumer has to see every byte
+static void * xStressProducer(void * p_arg)
+{
+    stressRun_t * p_run = p_arg;
+    uint8_t chunk[STRESS_MAX_CHUNK];
+    uint64_t idx = 0u;
+    BaseType_t woken = pdFALSE;
+
+    while ( idx < p_run->bytes )
+    {
+        uint32_t len = 1u;
+        uint32_t done = 0u;
+
+        if ( p_run->produce == PRODUCE_CHUNKS )
+        {
+            len = 1u + ((uint32_t)rand() % STRESS_MAX_CHUNK);
+            if ( len > (p_run->bytes - idx) )
+            {
+                len = (uint32_t)(p_run->bytes - idx);
+            }
+        }
+
+        for ( uint32_t i = 0u; i < len; i++ )
+        {
+            chunk[i] = xPattern(idx + i);
+        }
+
+        while ( done < len )
+        {
+            uint32_t written = (p_run->produce == PRODUCE_BYTES) ? (RING_putFromIsr(p_run->p_ring, chunk[done], &woken) ? 1u : 0u)
+                                                                 : RING_writeFromIsr(p_run->p_ring, &chunk[done], len - done, &woken);
+            if ( written == 0u )
+            {
+                p_run->fullRetries++;
+                sched_yield();
+            }
+            done += written;
+        }
+
+        idx += len;
+    }
+
+    return NULL;
+}
+
+// The CLI task
+static void * xStressConsumer(void * p_arg)
+{
+    stressRun_t * p_run = p_arg;
+    uint8_t copy[STRESS_MAX_CHUNK];
+    uint64_t idx = 0u;
+
+    HOST_SetCurrentTask(&xConsumerTask);
+
+    while ( (idx < p_run->bytes) && (p_run->mismatchAt == UINT64_MAX) )
+    {
+        const uint8_t * p_bytes = copy;
+        uint32_t len = 0u;
+
+        if ( RING_waitForData(p_run->p_ring, WAIT_TIMEOUT_MS) == false )
+        {
+            p_run->timeouts++;
+            break;
+        }
+        p_run->wakes++;
+
+        if ( p_run->consume == CONSUME_SPANS )
+        {
+            p_bytes = RING_readSpan(p_run->p_ring, &len);
+        }
+        else
+        {
+            len = RING_read(p_run->p_ring, copy, 1u + ((uint32_t)rand() % STRESS_MAX_CHUNK));
+        }
+
+        for ( uint32_t i = 0u; i < len; i++ )
+        {
+            if ( p_bytes[i] != xPattern(idx + i) )
+            {
+                p_run->mismatchAt = idx + i;
+                break;
+            }
+        }
+
+        if ( p_run->consume == CONSUME_SPANS )
+        {
+            RING_commitRead(p_run->p_ring, len);
+        }
+        idx += len;
+    }
+
+    return NULL;
+}
+
+static void xBenchmark(void)
+{
+    spscRing_t ring;
+    double seconds;
+
+    RING_init(&ring, xBenchStorage, BENCH_CAPACITY, NULL);
+    seconds = xRunPair(xSpanProducer, xSpanConsumer, &ring);
+    printf("    span to span:            %7.0f MB/s\n", (BENCH_SPAN_BYTES / seconds) / 1e6);
+
+    RING_init(&ring, xBenchStorage, BENCH_CAPACITY, NULL);
+    seconds = xRunPair(xByteProducer, xByteConsumer, &ring);
+    printf("    one byte per call:       %7.1f MB/s, %5.1f ns a byte\n", (BENCH_BYTE_BYTES / seconds) / 1e6, (seconds * 1e9) / BENCH_BYTE_BYTES);
+
+    memset(&xLocked, 0, sizeof(xLocked));
+    xLocked.lock = xSemaphoreCreateMutexStatic(&xLocked.lockBuffer);
+    seconds = xRunPair(xLockedProducer, xLockedConsumer, &xLocked);
+    printf("    one byte, mutex guarded: %7.1f MB/s, %5.1f ns a byte\n", (BENCH_BYTE_BYTES / seconds) / 1e6, (seconds * 1e9) / BENCH_BYTE_BYTES);
+}
+
+static void * xSpanProducer(void * p_arg)
+{
+    spscRing_t * p_ring = p_arg;
+    uint64_t idx = 0u;
+
+    while ( idx < BENCH_SPAN_BYTES )
+    {
+        uint32_t len = 0u;
+        uint8_t * p_span = RING_writeSpan(p_ring, &len);
+
+        if ( len == 0u )
+        {
+            sched_yield();
+            continue;
+        }
+        if ( len > (BENCH_SPAN_BYTES - idx) )
+        {
+            len = (uint32_t)(BENCH_SPAN_BYTES - idx);
+        }
+        p_span[0] = (uint8_t)idx;
+        RING_commitWrite(p_ring, len);
+        idx += len;
+    }
+
+    return NULL;
+}
+
+static void * xSpanConsumer(void * p_arg)
+{
+    spscRing_t * p_ring = p_arg;
+    uint64_t idx = 0u;
+
+    while ( idx < BENCH_SPAN_BYTES )
+    {
+        uint32_t len = 0u;
+
+        (void)RING_readSpan(p_ring, &len);
+        if ( len == 0u )
+        {
+            sched_yield();
+            continue;
+        }
+        RING_commitRead(p_ring, len);
+        idx += len;
+    }
+
+    return NULL;
+}
+
+static void * xByteProducer(void * p_arg)
+{
+    spscRing_t * p_ring = p_arg;
+    uint64_t idx = 0u;
+
+    while ( idx < BENCH_BYTE_BYTES )
+    {
+        if ( RING_putFromIsr(p_ring, (uint8_t)idx, NULL) == true )
+        {
+            idx++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void * xByteConsumer(void * p_arg)
+{
+    spscRing_t * p_ring = p_arg;
+    uint8_t byte = 0u;
+    uint64_t idx = 0u;
+
+    while ( idx < BENCH_BYTE_BYTES )
+    {
+        if ( RING_read(p_ring, &byte, 1u) == 1u )
+        {
+            idx++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void * xLockedProducer(void * p_arg)
+{
+    lockedRing_t * p_ring = p_arg;
+    uint64_t idx = 0u;
+
+    while ( idx < BENCH_BYTE_BYTES )
+    {
+        bool put = false;
+
+        xSemaphoreTake(p_ring->lock, portMAX_DELAY);
+        if ( (p_ring->head - p_ring->tail) < BENCH_CAPACITY )
+        {
+            p_ring->buf[p_ring->head % BENCH_CAPACITY] = (uint8_t)idx;
+            p_ring->head++;
+            put = true;
+        }
+        xSemaphoreGive(p_ring->lock);
+
+        if ( put == true )
+        {
+            idx++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void * xLockedConsumer(void * p_arg)
+{
+    lockedRing_t * p_ring = p_arg;
+    uint64_t idx = 0u;
+    volatile uint8_t byte = 0u;
+
+    while ( idx < BENCH_BYTE_BYTES )
+    {
+        bool got = false;
+
+        xSemaphoreTake(p_ring->lock, portMAX_DELAY);
+        if ( p_ring->head != p_ring->tail )
+        {
+            byte = p_ring->buf[p_ring->tail % BENCH_CAPACITY];
+            p_ring->tail++;
+            got = true;
+        }
+        xSemaphoreGive(p_ring->lock);
+
+        if ( got == true )
+        {
+            idx++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    (void)byte;
+
+    return NULL;
+}
+
+// Run a producer and a consumer thread to the end, returns the wall time
+static double xRunPair(void * (*p_producer)(void *), void * (*p_consumer)(void *), void * p_arg)
+{
+    pthread_t producer;
+    pthread_t consumer;
+    struct timespec start;
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&consumer, NULL, p_consumer, p_arg);
+    pthread_create(&producer, NULL, p_producer, p_arg);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (double)(end.tv_sec - start.tv_sec) + ((double)(end.tv_nsec - start.tv_nsec) / 1e9);
+}
@@ -0,0 +1,190 @@
+/**************************************************************************************************
+* \file     test_ssm_status.c
+* \brief    Host test of the AM side of the SSM status request against new and old SSM status frames
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_am.h"
+#include "am-ssm-spi-protocol.h"
+#include "spi.h"
+
+// Runs ASP_GetSSMStatus() from am-spi-protocol.c with the SSM end of the SPI link mocked. The SSM answers
+// with the status frame it builds, then the line idles for the rest of the bytes the AM clocks in.
+//
+// The status payload grew by the three profile fields (6 bytes). An SSM from before them sends the
+// shorter payload, the AM has to take the fields it did send and read the profile as 0, whatever the
+// idle bytes after the frame are. A payload shorter than that, a NACK and a bad checksum are not a status.
+//
+// Usage: test_ssm_status
+
+#define IDLE_BYTES_TO_TRY           3u
+
+static const uint8_t xIdleBytes[IDLE_BYTES_TO_TRY] = { 0x00u, 0xFFu, ASP_START_FRAME_MAGIC };
+
+static bool xPass = true;
+static asp_msg_t xResponse;
+static uint8_t xIdle = 0u;
+static uint8_t xSpeed = 0u;
+
+static void xCheck(bool condition, const char * p_what);
+static asp_status_payload_t xSampleStatus(void);
+static void xRespond(uint8_t messageId, const asp_status_payload_t * p_status, uint8_t payloadLen, bool goodChecksum);
+
+int main(int argc, char * argv[])
+{
+    asp_status_payload_t sent = xSampleStatus();
+    asp_status_payload_t got;
+    asp_status_payload_t expected;
+    aspMessageCode_t result;
+    bool oldOk = true;
+    uint8_t i;
+
+    printf("  status payload %u bytes, %u from an SSM without the profile fields\n", (unsigned)ASP_STATUS_PAYLOAD_BYTES,
+           (unsigned)ASP_STATUS_MIN_PAYLOAD_BYTES);
+    xCheck(ASP_STATUS_PAYLOAD_BYTES == (ASP_STATUS_MIN_PAYLOAD_BYTES + 6u), "the profile fields are the last 6 bytes");
+
+    xIdle = 0xFFu;
+    xRespond(ASP_STATUS_MSG_ID, &sent, ASP_STATUS_PAYLOAD_BYTES, true);
+    memset(&got, 0xAA, sizeof(got));
+    result = ASP_GetSSMStatus(&got);
+    xCheck((result == SUCCESSFUL_REQUEST) && (memcmp(&got, &sent, sizeof(got)) == 0), "a full status is taken as sent");
+    xCheck((got.algoMeanUs == 2100u) && (got.algoMaxUs == 5400u) && (got.loopMaxUs == 9800u), "with the profile fields");
+
+    expected = sent;
+    expected.algoMeanUs = 0u;
+    expected.algoMaxUs = 0u;
+    expected.loopMaxUs = 0u;
+    for ( i = 0u; i < IDLE_BYTES_TO_TRY; i++ )
+    {
+        xIdle = xIdleBytes[i];
+        xRespond(ASP_STATUS_MSG_ID, &sent, ASP_STATUS_MIN_PAYLOAD_BYTES, true);
+        memset(&got, 0xAA, sizeof(got));
+        result = ASP_GetSSMStatus(&got);
+        if ( (result != SUCCESSFUL_REQUEST) || (memcmp(&got, &expected, sizeof(got)) != 0) )
+        {
+            printf("    idle 0x%02X: result %d, profile %u %u %u\n", xIdle, result, got.algoMeanUs, got.algoMaxUs, got.loopMaxUs);
+            oldOk = false;
+        }
+    }
+    xCheck(oldOk, "a status without the profile is taken, the profile reads 0 whatever the line idles at");
+
+    xIdle = 0xFFu;
+    xRespond(ASP_STATUS_MSG_ID, &sent, ASP_STATUS_MIN_PAYLOAD_BYTES - 1u, true);
+    memset(&got, 0xAA, sizeof(got));
+    memset(&expected, 0xAA, sizeof(expected));
+    result = ASP_GetSSMStatus(&got);
+    xCheck((result == INVALID_LEN) && (memcmp(&got, &expected, sizeof(got)) == 0), "a shorter status is refused and nothing is copied");
+
+    xRespond(ASP_NACK_MSG_ID, NULL, ASP_NACK_PAYLOAD_BYTES, true);
+    xCheck(ASP_GetSSMStatus(&got) == NACKED_MSG, "a NACK is a NACK");
+
+    xRespond(ASP_STATUS_MSG_ID, &sent, ASP_STATUS_PAYLOAD_BYTES, false);
+    xCheck(ASP_GetSSMStatus(&got) == INVALID_CS, "a bad checksum is refused");
+
+    xRespond(ASP_STATUS_MSG_ID, &sent, ASP_STATUS_MIN_PAYLOAD_BYTES, false);
+    xCheck(ASP_GetSSMStatus(&got) == INVALID_CS, "a bad checksum on a short status is refused");
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+static asp_status_payload_t xSampleStatus(void)
+{
+    asp_status_payload_t status;
+
+    memset(&status, 0, sizeof(status));
+    status.resetState = 2u;
+    status.activatedState = 1u;
+    status.ssmFwVersion.fwMaj = 1u;
+    status.ssmFwVersion.fwMin = 4u;
+    status.ssmFwVersion.fwBuild = 7u;
+    status.errorBits = 0x00010004u;
+    status.timestamp = 1792368000u;
+    status.voltageMv = 3600u;
+    status.powerRemainingPercent = 87u;
+    status.magnetDetected = true;
+    status.breakdown = false;
+    status.activatedDate = 1790000000u;
+    status.unexpectedResetCount = 3u;
+    status.timeLastReset = 1791000000u;
+    status.algoMeanUs = 2100u;
+    status.algoMaxUs = 5400u;
+    status.loopMaxUs = 9800u;
+
+    return status;
+}
+
+// The frame the SSM puts out next, as ASP_TransmitStatus() builds it with the given payload length
+static void xRespond(uint8_t messageId, const asp_status_payload_t * p_status, uint8_t payloadLen, bool goodChecksum)
+{
+    memset(&xResponse, 0, sizeof(xResponse));
+    xResponse.fields.startFrame = ASP_START_FRAME_MAGIC;
+    xResponse.fields.payloadLen = payloadLen;
+    xResponse.fields.messageID = messageId;
+    if ( p_status != NULL )
+    {
+        memcpy(xResponse.fields.payload.bytes, p_status, payloadLen);
+    }
+    xResponse.bytes[payloadLen + ASP_HEADER_BYTES] = ASP_ComputeChecksum(&xResponse) + ((goodChecksum == true) ? 0u : 1u);
+}
+
+// The SSM clocks out its frame, then the idle line for the rest of what the AM reads
+spiStatus_t SPI_ssmTransfer(const spiData_t* pDataToSend, spiData_t* pDataReceived, spiConfigOptions_t optAfter)
+{
+    uint32_t frameLen = xResponse.fields.payloadLen + ASP_TOTAL_OVERHEAD_BYTES;
+    uint32_t i;
+
+    for ( i = 0u; i < pDataReceived->length; i++ )
+    {
+        pDataReceived->pChar[i] = (i < frameLen) ? xResponse.bytes[i] : xIdle;
+    }
+
+    return spiSuccess;
+}
+
+bool SPI_ssmSetSpeed(uint8_t speed)
+{
+    xSpeed = speed;
+    return true;
+}
+
+uint8_t SPI_ssmGetSpeed(void)
+{
+    return xSpeed;
+}
+
+uint32_t SPI_ssmGetBitRate(void)
+{
+    return 1000000u >> (SPI_SSM_NUM_SPEEDS - 1u - xSpeed);
+}
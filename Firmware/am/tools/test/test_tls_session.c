@@ -0,0 +1,549 @@
+/**************************************************************************************************
+* \file     test_tls_session.c
+* \brief    Cold vs resumed handshakes of the TLS session cache against a loopback mbedTLS server
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include MBEDTLS_CONFIG_FILE
+#include "mbedtls/certs.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_ticket.h"
+#include "host_am.h"
+#include "host_nand.h"
+#include "MT29F1.h"
+#include "memoryMap.h"
+#include "tlsSessionCache.h"
+
+// Builds tlsSessionCache.c over the simulated NAND and connects an mbedTLS client to an mbedTLS server
+// thread on a loopback socket, with mutual ECDSA authentication as AWS IoT does. The client goes through
+// the same steps as TLS_Connect() in iot_tls.c: offer the cached session, handshake, then save the session
+// or drop it if the server turned it down. Every connection counts the bytes each way and the round trips
+// (the client sending, then waiting on the server) until the handshake is done.
+//
+// A reset between connections is TLSC_init(), as after standby. The server first issues RFC 5077 tickets,
+// then forgets its ticket key, then keeps only a session ID cache. Records altered in NAND, copied from
+// another unit or older than the age limit must not be offered, and the block has to wrap.
+//
+// Usage: test_tls_session
+
+#define WRAP_CONNECTS               70u
+#define TAMPER_OFFSET               60u         // in the sealed payload, past the record header
+#define HOST_NAME                   "localhost"
+
+typedef enum
+{
+    SERVER_TICKETS,
+    SERVER_SESSION_CACHE
+}serverMode_t;
+
+typedef struct
+{
+    mbedtls_net_context fd;
+    uint32_t txBytes;
+    uint32_t rxBytes;
+    uint32_t roundTrips;
+    bool lastWasTx;
+}link_t;
+
+typedef struct
+{
+    bool ok;
+    bool offered;
+    bool resumed;
+    uint32_t txBytes;
+    uint32_t rxBytes;
+    uint32_t roundTrips;
+}connection_t;
+
+static volatile serverMode_t xServerMode = SERVER_TICKETS;
+static volatile uint32_t xServerGeneration = 0u;      // bumped to make the server forget everything
+static mbedtls_net_context xListen;
+static char xPort[8];
+
+static mbedtls_entropy_context xEntropy;
+static mbedtls_ctr_drbg_context xDrbg;
+static mbedtls_x509_crt xCa;
+static mbedtls_x509_crt xClientCrt;
+static mbedtls_pk_context xClientKey;
+
+static uint8_t xSerial[9] = { 0x01, 0x23, 0x5E, 0x6F, 0x11, 0x22, 0x33, 0x44, 0xEE };
+static uint32_t xNtpTime = 0u;
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static connection_t xConnect(const char * p_label);
+static connection_t xConnectOnce(void);
+static void xPowerCycle(void);
+static void xTamperRecords(void);
+static bool xIsSessionRejected(int result);
+static void * xServerThread(void * p_arg);
+static int xLinkSend(void * p_ctx, const unsigned char * p_buf, size_t len);
+static int xLinkRecv(void * p_ctx, unsigned char * p_buf, size_t len);
+
+int main(void)
+{
+    pthread_t server;
+    struct sockaddr_in address;
+    socklen_t addressLen = sizeof(address);
+    connection_t cold;
+    connection_t conn;
+    uint32_t programsBefore;
+    uint32_t erasesBefore;
+    bool resumedAll = true;
+    uint32_t i;
+
+    //any free port
+    mbedtls_net_init(&xListen);
+
+    if ( (mbedtls_net_bind(&xListen, "127.0.0.1", "0", MBEDTLS_NET_PROTO_TCP) != 0) ||
+         (getsockname(xListen.fd, (struct sockaddr *)&address, &addressLen) != 0) )
+    {
+        printf("  no loopback socket\nFAIL\n");
+        return 1;
+    }
+
+    snprintf(xPort, sizeof(xPort), "%u", ntohs(address.sin_port));
+
+    mbedtls_entropy_init(&xEntropy);
+    mbedtls_ctr_drbg_init(&xDrbg);
+    mbedtls_ctr_drbg_seed(&xDrbg, mbedtls_entropy_func, &xEntropy, (const unsigned char *)"client", 6u);
+    mbedtls_x509_crt_init(&xCa);
+    mbedtls_x509_crt_init(&xClientCrt);
+    mbedtls_pk_init(&xClientKey);
+    mbedtls_x509_crt_parse(&xCa, (const unsigned char *)mbedtls_test_ca_crt_ec, mbedtls_test_ca_crt_ec_len);
+    mbedtls_x509_crt_parse(&xClientCrt, (const unsigned char *)mbedtls_test_cli_crt_ec, mbedtls_test_cli_crt_ec_len);
+    mbedtls_pk_parse_key(&xClientKey, (const unsigned char *)mbedtls_test_cli_key_ec, mbedtls_test_cli_key_ec_len, NULL, 0u);
+
+    HOST_NandReset(0xFF);
+    pthread_create(&server, NULL, xServerThread, NULL);
+    TLSC_init();
+
+    printf("  server with RFC 5077 session tickets:\n");
+    cold = xConnect("cold, nothing cached");
+    xCheck((cold.ok == true) && (cold.offered == false), "a cold connect does a full handshake");
+
+    xPowerCycle();
+    conn = xConnect("after a power cycle");
+    xCheck((conn.ok == true) && (conn.offered == true) && (conn.resumed == true), "the ticket resumes the session");
+    printf("  resumed vs cold: tx %u -> %u B, rx %u -> %u B, %u%% of the bytes, %u -> %u round trips\n",
+           cold.txBytes, conn.txBytes, cold.rxBytes, conn.rxBytes,
+           (100u * (conn.txBytes + conn.rxBytes)) / (cold.txBytes + cold.rxBytes), cold.roundTrips, conn.roundTrips);
+    xCheck(conn.roundTrips < cold.roundTrips, "a resumed handshake saves a round trip");
+    xCheck((2u * (conn.txBytes + conn.rxBytes)) < (cold.txBytes + cold.rxBytes), "a resumed handshake sends less than half the bytes");
+
+    xPowerCycle();
+    conn = xConnect("again, with the renewed ticket");
+    xCheck((conn.ok == true) && (conn.resumed == true), "the renewed ticket resumes too");
+
+    xServerGeneration++;
+    xPowerCycle();
+    conn = xConnect("server forgot its ticket key");
+    xCheck((conn.ok == true) && (conn.offered == true) && (conn.resumed == false), "a ticket the server forgot falls back to a full handshake");
+
+    xPowerCycle();
+    conn = xConnect("next connect");
+    xCheck((conn.ok == true) && (conn.resumed == true), "the session after the fallback resumes");
+
+    //a byte of every sealed record flipped, nothing may be offered
+    xTamperRecords();
+    HOST_ClearLog();
+    xPowerCycle();
+    conn = xConnect("records altered in NAND");
+    xCheck((conn.ok == true) && (conn.offered == false), "an altered record is not offered");
+    xCheck(HOST_FindLog("failed authentication", NULL) == true, "an altered record fails authentication");
+
+    xPowerCycle();
+    conn = xConnect("next connect");
+    xCheck((conn.ok == true) && (conn.resumed == true), "the session written after it resumes");
+
+    //the same NAND in a unit with another ATECC608A
+    xSerial[8] ^= 0xFFu;
+    xPowerCycle();
+    conn = xConnect("records from another unit");
+    xCheck((conn.ok == true) && (conn.offered == false), "a record from another unit is not offered");
+    xSerial[8] ^= 0xFFu;
+
+    //age limit, with the time known
+    xNtpTime = 1700000000u;
+    xPowerCycle();
+    xConnect("saved with the time known");
+    xNtpTime += TLSC_MAX_AGE_SECS + 10u;
+    xPowerCycle();
+    conn = xConnect("older than the age limit");
+    xCheck((conn.ok == true) && (conn.offered == false), "a session past the age limit is not offered");
+
+    printf("  server with a session ID cache, no tickets:\n");
+    xServerMode = SERVER_SESSION_CACHE;
+    xServerGeneration++;
+    xNtpTime = 0u;
+    xPowerCycle();
+    cold = xConnect("cold");
+    programsBefore = HOST_NandGetPrograms();
+    xPowerCycle();
+    conn = xConnect("after a power cycle");
+    xCheck((conn.ok == true) && (conn.resumed == true), "the session ID resumes the session");
+    xCheck(HOST_NandGetPrograms() == programsBefore, "a session that did not change is not written again");
+    printf("  resumed vs cold: tx %u -> %u B, rx %u -> %u B, %u%% of the bytes, %u -> %u round trips\n",
+           cold.txBytes, conn.txBytes, cold.rxBytes, conn.rxBytes,
+           (100u * (conn.txBytes + conn.rxBytes)) / (cold.txBytes + cold.rxBytes), cold.roundTrips, conn.roundTrips);
+
+    //enough new tickets to wrap the block
+    xServerMode = SERVER_TICKETS;
+    xServerGeneration++;
+    erasesBefore = HOST_NandGetErases();
+    xPowerCycle();
+    xConnect("tickets again");
+
+    for ( i = 0u; i < WRAP_CONNECTS; i++ )
+    {
+        xPowerCycle();
+        conn = xConnectOnce();
+        resumedAll &= conn.resumed;
+    }
+
+    printf("  %u more connects: %u block erases, %u page programs in all\n", WRAP_CONNECTS, HOST_NandGetErases() - erasesBefore, HOST_NandGetPrograms());
+    xCheck(resumedAll == true, "every connect resumes while the block wraps");
+    xCheck(HOST_NandGetErases() > erasesBefore, "the block wrapped");
+    xCheck(HOST_NandGetViolations() == 0u, "no page is programmed twice without an erase");
+
+    HOST_RunCommand("tlsc clear");
+    conn = xConnect("after tlsc clear");
+    xCheck((conn.ok == true) && (conn.offered == false), "tlsc clear drops the session");
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+static connection_t xConnect(const char * p_label)
+{
+    connection_t conn = xConnectOnce();
+
+    printf("    %-32s %s offered %u resumed %u  tx %5u B  rx %5u B  %u round trips\n", p_label, (conn.ok == true) ? "ok " : "ERR",
+           conn.offered, conn.resumed, conn.txBytes, conn.rxBytes, conn.roundTrips);
+
+    return conn;
+}
+
+// TLS_Connect() of iot_tls.c with prvOfferCachedSession() and prvSaveSession(), over a loopback socket
+static connection_t xConnectOnce(void)
+{
+    connection_t conn = { 0 };
+    link_t link = { 0 };
+    mbedtls_ssl_config config;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_session offered;
+    mbedtls_ssl_session * p_session;
+    unsigned char offeredMaster[48];
+    unsigned char offeredTicketHash[32] = { 0 };
+    unsigned char ticketHash[32];
+    unsigned char reply[8];
+    int result;
+
+    mbedtls_net_init(&link.fd);
+
+    if ( mbedtls_net_connect(&link.fd, "127.0.0.1", xPort, MBEDTLS_NET_PROTO_TCP) != 0 )
+    {
+        return conn;
+    }
+
+    mbedtls_ssl_config_init(&config);
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_defaults(&config, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    mbedtls_ssl_conf_authmode(&config, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_rng(&config, mbedtls_ctr_drbg_random, &xDrbg);
+    mbedtls_ssl_conf_ca_chain(&config, &xCa, NULL);
+    mbedtls_ssl_conf_own_cert(&config, &xClientCrt, &xClientKey);
+    mbedtls_ssl_setup(&ssl, &config);
+    mbedtls_ssl_set_hostname(&ssl, HOST_NAME);
+
+    //prvOfferCachedSession()
+    mbedtls_ssl_session_init(&offered);
+
+    if ( (TLSC_load(&offered) == true) && (mbedtls_ssl_set_session(&ssl, &offered) == 0) )
+    {
+        conn.offered = true;
+        memcpy(offeredMaster, offered.master, sizeof(offeredMaster));
+
+        if ( (offered.ticket != NULL) && (offered.ticket_len != 0u) )
+        {
+            mbedtls_sha256_ret(offered.ticket, offered.ticket_len, offeredTicketHash, 0);
+        }
+    }
+
+    mbedtls_ssl_session_free(&offered);
+    mbedtls_ssl_set_bio(&ssl, &link, xLinkSend, xLinkRecv, NULL);
+
+    do
+    {
+        result = mbedtls_ssl_handshake(&ssl);
+    } while ( (result == MBEDTLS_ERR_SSL_WANT_READ) || (result == MBEDTLS_ERR_SSL_WANT_WRITE) );
+
+    conn.txBytes = link.txBytes;
+    conn.rxBytes = link.rxBytes;
+    conn.roundTrips = link.roundTrips;
+
+    if ( result == 0 )
+    {
+        //prvSaveSession()
+        p_session = ssl.session;
+        conn.resumed = (conn.offered == true) && (memcmp(p_session->master, offeredMaster, sizeof(offeredMaster)) == 0);
+
+        if ( (conn.resumed == false) && (p_session->ticket != NULL) && (p_session->ticket_len != 0u) )
+        {
+            mbedtls_sha256_ret(p_session->ticket, p_session->ticket_len, ticketHash, 0);
+
+            if ( memcmp(ticketHash, offeredTicketHash, sizeof(ticketHash)) == 0 )
+            {
+                mbedtls_platform_zeroize(p_session->ticket, p_session->ticket_len);
+                mbedtls_free(p_session->ticket);
+                p_session->ticket = NULL;
+                p_session->ticket_len = 0u;
+                p_session->ticket_lifetime = 0u;
+            }
+        }
+
+        TLSC_save(p_session, conn.resumed);
+        conn.ok = (mbedtls_ssl_read(&ssl, reply, sizeof(reply)) == 2);
+    }
+    else if ( (conn.offered == true) && (xIsSessionRejected(result) == true) )
+    {
+        TLSC_invalidate();
+    }
+
+    mbedtls_ssl_free(&ssl);
+    mbedtls_ssl_config_free(&config);
+    mbedtls_net_free(&link.fd);
+
+    return conn;
+}
+
+// STANDBY keeps no RAM, the cache starts over from its NAND block
+static void xPowerCycle(void)
+{
+    TLSC_init();
+}
+
+static void xTamperRecords(void)
+{
+    uint8_t * p_page;
+    uint32_t page;
+
+    for ( page = 0u; page < NUM_PAGE_BLOCK; page++ )
+    {
+        p_page = HOST_NandGetArray(APP_MEM_ADR_TLS_SESSION_START + (page * PAGE_DATA_SIZE));
+
+        if ( (p_page[0] & p_page[1] & p_page[2] & p_page[3]) != 0xFFu )
+        {
+            p_page[TAMPER_OFFSET] ^= 0x01u;
+        }
+    }
+}
+
+// prvIsSessionRejected()
+static bool xIsSessionRejected(int result)
+{
+    return ( (result == MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE) || (result == MBEDTLS_ERR_SSL_BAD_HS_SERVER_HELLO) ||
+             (result == MBEDTLS_ERR_SSL_BAD_HS_FINISHED) || (result == MBEDTLS_ERR_SSL_INVALID_MAC) );
+}
+
+// Accepts one connection at a time, requires a client certificate and answers "ok" once the handshake is done
+static void * xServerThread(void * p_arg)
+{
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_x509_crt serverCrt;
+    mbedtls_x509_crt ca;
+    mbedtls_pk_context serverKey;
+    mbedtls_ssl_config config;
+    mbedtls_ssl_cache_context cache;
+    mbedtls_ssl_ticket_context ticket;
+    mbedtls_ssl_context ssl;
+    mbedtls_net_context client;
+    int64_t generation = -1;
+
+    (void)p_arg;
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, (const unsigned char *)"server", 6u);
+    mbedtls_x509_crt_init(&serverCrt);
+    mbedtls_x509_crt_init(&ca);
+    mbedtls_pk_init(&serverKey);
+    mbedtls_x509_crt_parse(&serverCrt, (const unsigned char *)mbedtls_test_srv_crt_ec, mbedtls_test_srv_crt_ec_len);
+    mbedtls_x509_crt_parse(&ca, (const unsigned char *)mbedtls_test_ca_crt_ec, mbedtls_test_ca_crt_ec_len);
+    mbedtls_pk_parse_key(&serverKey, (const unsigned char *)mbedtls_test_srv_key_ec, mbedtls_test_srv_key_ec_len, NULL, 0u);
+
+    for ( ;; )
+    {
+        mbedtls_net_init(&client);
+
+        if ( mbedtls_net_accept(&xListen, &client, NULL, 0u, NULL) != 0 )
+        {
+            break;
+        }
+
+        //a new generation is a server that lost its ticket key and its session cache
+        if ( generation != (int64_t)xServerGeneration )
+        {
+            if ( generation >= 0 )
+            {
+                mbedtls_ssl_config_free(&config);
+                mbedtls_ssl_cache_free(&cache);
+                mbedtls_ssl_ticket_free(&ticket);
+            }
+
+            generation = (int64_t)xServerGeneration;
+            mbedtls_ssl_config_init(&config);
+            mbedtls_ssl_cache_init(&cache);
+            mbedtls_ssl_ticket_init(&ticket);
+            mbedtls_ssl_config_defaults(&config, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+            mbedtls_ssl_conf_rng(&config, mbedtls_ctr_drbg_random, &drbg);
+            mbedtls_ssl_conf_ca_chain(&config, &ca, NULL);
+            mbedtls_ssl_conf_own_cert(&config, &serverCrt, &serverKey);
+            mbedtls_ssl_conf_authmode(&config, MBEDTLS_SSL_VERIFY_REQUIRED);
+
+            if ( xServerMode == SERVER_TICKETS )
+            {
+                mbedtls_ssl_ticket_setup(&ticket, mbedtls_ctr_drbg_random, &drbg, MBEDTLS_CIPHER_AES_256_GCM, 86400u);
+                mbedtls_ssl_conf_session_tickets_cb(&config, mbedtls_ssl_ticket_write, mbedtls_ssl_ticket_parse, &ticket);
+            }
+            else
+            {
+                mbedtls_ssl_conf_session_cache(&config, &cache, mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
+            }
+        }
+
+        mbedtls_ssl_init(&ssl);
+        mbedtls_ssl_setup(&ssl, &config);
+        mbedtls_ssl_set_bio(&ssl, &client, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+        if ( mbedtls_ssl_handshake(&ssl) == 0 )
+        {
+            mbedtls_ssl_write(&ssl, (const unsigned char *)"ok", 2u);
+            mbedtls_ssl_close_notify(&ssl);
+        }
+
+        mbedtls_ssl_free(&ssl);
+        mbedtls_net_free(&client);
+    }
+
+    return NULL;
+}
+
+// The client side of the socket, a receive after a send starts a round trip
+static int xLinkSend(void * p_ctx, const unsigned char * p_buf, size_t len)
+{
+    link_t * p_link = (link_t *)p_ctx;
+    int result = mbedtls_net_send(&p_link->fd, p_buf, len);
+
+    if ( result > 0 )
+    {
+        p_link->txBytes += (uint32_t)result;
+        p_link->lastWasTx = true;
+    }
+
+    return result;
+}
+
+static int xLinkRecv(void * p_ctx, unsigned char * p_buf, size_t len)
+{
+    link_t * p_link = (link_t *)p_ctx;
+    int result = mbedtls_net_recv(&p_link->fd, p_buf, len);
+
+    if ( result > 0 )
+    {
+        p_link->roundTrips += (p_link->lastWasTx == true) ? 1u : 0u;
+        p_link->lastWasTx = false;
+        p_link->rxBytes += (uint32_t)result;
+    }
+
+    return result;
+}
+
+// The platform under tlsSessionCache.c: MCU and ATECC608A serials, NTP time and the TRNG
+uint32_t HAL_GetUIDw0(void)
+{
+    return 0x12345678u;
+}
+
+uint32_t HAL_GetUIDw1(void)
+{
+    return 0x9ABCDEF0u;
+}
+
+uint32_t HAL_GetUIDw2(void)
+{
+    return 0x0BADF00Du;
+}
+
+bool ATECC_getUniqueId(uint8_t *id)
+{
+    memcpy(id, xSerial, sizeof(xSerial));
+
+    return true;
+}
+
+uint32_t NTP_getTime(void)
+{
+    return xNtpTime;
+}
+
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    FILE * p_random = fopen("/dev/urandom", "rb");
+
+    (void)data;
+    *olen = (p_random != NULL) ? fread(output, 1u, len, p_random) : 0u;
+
+    if ( p_random != NULL )
+    {
+        fclose(p_random);
+    }
+
+    return 0;
+}
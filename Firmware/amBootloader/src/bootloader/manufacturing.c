@@ -36,12 +36,14 @@ See Twisthink-SoftwareLicenseAgreement-Auris.docx for details.
 #define MAX_AM_IMAGE_LEN     0x1DC130 //2Mb - 50kB for the BL
 #define MAX_SSM_IMAGE_LEN    0xFF80
 
-//data read from INTERNAL flash
-static uint8_t dataBuffer[STM_FLASH_PAGE_SIZE];
+//short last page of an image, and the read back of the copy
+static uint8_t pageBuffer[MT29F1_PAGE_SIZE];
 static uint16_t crc = 0xFFFF;
 static manufacturingImageVersion_t imagePackageVersion = {};
 
+static bool xStageImage(uint32_t offset, uint32_t len, uint32_t externalFlashAddr);
 static uint16_t xRunningCrc(uint8_t* data_p, uint32_t length);
+static uint16_t xCrc16(uint16_t crcIn, const uint8_t* data_p, uint32_t length);
 
 bool MFG_MODE_checkForImagePackageInternalFlash(void)
 {
@@ -160,13 +162,8 @@ bool MFG_MODE_copyImagePackageToExternalFlash(void)
 {
     uint32_t imageLength = 0u;
     uint32_t ssmImageOffset = 0u;
-    uint32_t externalFlashAddr = APP_MEM_ADR_FW_APPLICATION_AM_A_START;
-    uint32_t bytesLeftToRead = 0;
-    uint32_t startByte = IMAGE_LEN_SIZE + IMAGE_TYPE_SIZE;
-    uint32_t bytesReadThisRound = 0;
-    uint32_t imagePackageIdx = 0;
-    uint16_t idx = 0;
     volatile uint8_t *internalFlash = (volatile uint8_t *) INTERNAL_FLASH_START_ADDR;
+    bool staged = false;
 
     elogInfo("Copying internal flash to external");
 
@@ -177,80 +174,89 @@ bool MFG_MODE_copyImagePackageToExternalFlash(void)
     //compute ssm image package offset
     ssmImageOffset = imageLength + IMAGE_LEN_SIZE + IMAGE_TYPE_SIZE;
 
-    //page by page update external flash with the internal image package
-    bytesLeftToRead = imageLength;
+    staged = xStageImage(IMAGE_LEN_SIZE + IMAGE_TYPE_SIZE, imageLength, APP_MEM_ADR_FW_APPLICATION_AM_A_START);
 
-    while (bytesLeftToRead)
+    //now store the SSM image package
+    if ( staged == true )
     {
-        if ( bytesLeftToRead >= STM_FLASH_PAGE_SIZE )
-        {
-            bytesReadThisRound = STM_FLASH_PAGE_SIZE;
-        }
-        else
-        {
-            bytesReadThisRound = bytesLeftToRead;
-        }
-
-        memset(&dataBuffer, 0, STM_FLASH_PAGE_SIZE);
+        imageLength = (internalFlash[IMAGE_LEN_BYTE + ssmImageOffset] << 24) | (internalFlash[IMAGE_LEN_BYTE + 1 + ssmImageOffset] << 16) |
+                   (internalFlash[IMAGE_LEN_BYTE + 2 + ssmImageOffset] << 8) | internalFlash[IMAGE_LEN_BYTE + 3 + ssmImageOffset];
 
-        idx = 0;
-
-        //read the next ~4096 bytes of internal flash and store it in a buffer
-        for(imagePackageIdx = startByte; imagePackageIdx < (bytesReadThisRound + startByte); imagePackageIdx++)
-        {
-            dataBuffer[idx] = internalFlash[imagePackageIdx];
-            idx++;
-        }
+        staged = xStageImage(ssmImageOffset + IMAGE_LEN_SIZE + IMAGE_TYPE_SIZE, imageLength, APP_MEM_ADR_FW_APPLICATION_SSM_A_START);
+    }
 
-        //write to flash
-        FLASH_write(externalFlashAddr, (uint8_t*)dataBuffer, bytesReadThisRound);
+    return staged;
+}
 
-        //update for next loop
-        bytesLeftToRead -= bytesReadThisRound;
-        startByte += bytesReadThisRound;
-        externalFlashAddr += bytesReadThisRound;
+/*
+ * Copy len bytes at offset in the internal flash image package to external flash at externalFlashAddr.
+ *
+ * The destination is a fresh image slot, so each block it covers is erased once up front and then
+ * programmed a page at a time straight out of the memory mapped internal flash. FLASH_write would read,
+ * erase and rewrite the whole 128k block for every call. Only a short last page goes through pageBuffer
+ * to fill it out with erased bytes. The copy is read back once and its CRC compared against the source.
+ */
+static bool xStageImage(uint32_t offset, uint32_t len, uint32_t externalFlashAddr)
+{
+    const uint8_t *source = (const uint8_t *) (INTERNAL_FLASH_START_ADDR + offset);
+    uint16_t sourceCrc = 0xFFFF;
+    uint16_t copyCrc = 0xFFFF;
+    uint32_t pageOffset = 0u;
+    uint32_t bytesThisPage = 0u;
+    uint32_t eraseLen = 0u;
+    flashErr_t err = FLASH_SUCCESS;
+
+    if ( len == 0u )
+    {
+        return true;
     }
 
+    //the slot starts on a block, erase whole blocks up to the one the image ends in
+    eraseLen = ((len + (MT29F1_BLOCK_DATA_SIZE - 1u)) / MT29F1_BLOCK_DATA_SIZE) * MT29F1_BLOCK_DATA_SIZE;
+    err = FLASH_erase(externalFlashAddr, eraseLen);
 
-    //now store the SSM image package
-    imageLength = (internalFlash[IMAGE_LEN_BYTE + ssmImageOffset] << 24) | (internalFlash[IMAGE_LEN_BYTE + 1 + ssmImageOffset] << 16) |
-               (internalFlash[IMAGE_LEN_BYTE + 2 + ssmImageOffset] << 8) | internalFlash[IMAGE_LEN_BYTE + 3 + ssmImageOffset];
+    //page by page program external flash with the internal image package
+    for ( pageOffset = 0u; (pageOffset < len) && (err == FLASH_SUCCESS); pageOffset += MT29F1_PAGE_SIZE )
+    {
+        bytesThisPage = ((len - pageOffset) >= MT29F1_PAGE_SIZE) ? MT29F1_PAGE_SIZE : (len - pageOffset);
 
-    bytesLeftToRead = imageLength;
-    externalFlashAddr = APP_MEM_ADR_FW_APPLICATION_SSM_A_START;
-    startByte = ssmImageOffset + IMAGE_LEN_SIZE + IMAGE_TYPE_SIZE;
+        sourceCrc = xCrc16(sourceCrc, &source[pageOffset], bytesThisPage);
 
-    while (bytesLeftToRead)
-    {
-        if ( bytesLeftToRead >= STM_FLASH_PAGE_SIZE )
+        if ( bytesThisPage == MT29F1_PAGE_SIZE )
         {
-            bytesReadThisRound = STM_FLASH_PAGE_SIZE;
+            err = FLASH_programPage(externalFlashAddr + pageOffset, &source[pageOffset], MT29F1_PAGE_SIZE);
         }
         else
         {
-            bytesReadThisRound = bytesLeftToRead;
+            memset(pageBuffer, 0xFF, MT29F1_PAGE_SIZE);
+            memcpy(pageBuffer, &source[pageOffset], bytesThisPage);
+            err = FLASH_programPage(externalFlashAddr + pageOffset, pageBuffer, MT29F1_PAGE_SIZE);
         }
+    }
 
-        memset(&dataBuffer, 0, STM_FLASH_PAGE_SIZE);
-
-        idx = 0;
+    //read the copy back and check it in one pass
+    for ( pageOffset = 0u; (pageOffset < len) && (err == FLASH_SUCCESS); pageOffset += MT29F1_PAGE_SIZE )
+    {
+        bytesThisPage = ((len - pageOffset) >= MT29F1_PAGE_SIZE) ? MT29F1_PAGE_SIZE : (len - pageOffset);
 
-        //read the next ~4096 bytes of internal flash and store it in a buffer
-        for(imagePackageIdx = startByte; imagePackageIdx < (bytesReadThisRound + startByte); imagePackageIdx++)
-        {
-            dataBuffer[idx] = internalFlash[imagePackageIdx];
-            idx++;
-        }
+        err = FLASH_read(externalFlashAddr + pageOffset, pageBuffer, bytesThisPage);
+        copyCrc = xCrc16(copyCrc, pageBuffer, bytesThisPage);
+    }
 
-        //write to flash
-        FLASH_write(externalFlashAddr, (uint8_t*)dataBuffer, bytesReadThisRound);
+    if ( err != FLASH_SUCCESS )
+    {
+        elogError("Staging to %x failed, err %d", externalFlashAddr, err);
+        return false;
+    }
 
-        //update for next loop
-        bytesLeftToRead -= bytesReadThisRound;
-        startByte += bytesReadThisRound;
-        externalFlashAddr += bytesReadThisRound;
+    if ( copyCrc != sourceCrc )
+    {
+        elogError("Staging to %x CRC MISMATCH, image %x, copy %x", externalFlashAddr, sourceCrc, copyCrc);
+        return false;
     }
 
+    elogInfo("Staged %d bytes at %x, CRC %x", len, externalFlashAddr, copyCrc);
+
     return true;
 }
 
@@ -260,16 +266,23 @@ bool MFG_MODE_copyImagePackageToExternalFlash(void)
     crc-ccitt-false [1]  |   0x11021    | False     | 0xFFFF      | 0x0000  0x29B1
  */
 static uint16_t xRunningCrc(uint8_t* data_p, uint32_t length)
+{
+    crc = xCrc16(crc, data_p, length);
+
+    return crc;
+}
+
+static uint16_t xCrc16(uint16_t crcIn, const uint8_t* data_p, uint32_t length)
 {
     uint8_t x;
 
     while (length--)
     {
-        x = crc >> 8 ^ *data_p++;
+        x = crcIn >> 8 ^ *data_p++;
         x ^= x>>4;
-        crc = (crc << 8) ^ ((uint16_t)(x << 12)) ^ ((uint16_t)(x <<5)) ^ ((uint16_t)x);
+        crcIn = (crcIn << 8) ^ ((uint16_t)(x << 12)) ^ ((uint16_t)(x <<5)) ^ ((uint16_t)x);
     }
 
-    return crc;
+    return crcIn;
 }
 
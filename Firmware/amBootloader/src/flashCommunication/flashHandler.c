@@ -30,6 +30,8 @@ uint8_t blockBuffer[BLOCK_SIZE];
 
 //uint8_t pageBuffer[PAGE_SIZE];
 
+static flashErr_t xToFlashErr(mt29f_status_t err);
+
 void FLASH_init(void)
 {
     GPIO_InitTypeDef GPIO_InitStruct = {0};
@@ -320,3 +322,100 @@ flashErr_t FLASH_read(uint32_t addr, uint8_t *data, uint32_t len)
     return flashErr;
 }
 
+
+/*
+ * Erase the whole blocks from address through address + len - 1, each one once.
+ * Used before a run of FLASH_programPage() calls, FLASH_write() does its own erase.
+ * The NAND only erases whole blocks, so address and len must both be block aligned,
+ * anything else would take out data outside the range and is rejected.
+ */
+flashErr_t FLASH_erase(uint32_t addr, uint32_t len)
+{
+    mt29f_status_t err = Flash_Success;
+    uint32_t blockAddr;
+    uint32_t lastAddr = addr + (len - 1);
+    uint16_t blockNum;
+    uint16_t lastBlock;
+
+    if (len == 0 || lastAddr > (MT29F1_MAX_ADDR) || (addr + len) < addr)
+    {
+        return FLASH_ADDR_ERR;
+    }
+
+    if ((addr % BLOCK_SIZE) != 0 || (len % BLOCK_SIZE) != 0)
+    {
+        elogError("Erase of %x, len %x is not block aligned", addr, len);
+        return FLASH_ADDR_ERR;
+    }
+
+    FlashUnlockAll();
+
+    lastBlock = ADDRESS_2_BLOCK(lastAddr);
+
+    for (blockNum = ADDRESS_2_BLOCK(addr); blockNum <= lastBlock; blockNum++)
+    {
+        //build the row address (block + page)
+        Build_RowAddressNoCmd(blockNum, 0, &blockAddr);
+
+        err = FlashBlockErase(blockAddr);
+
+        if (err != Flash_Success)
+        {
+            elogError("FLASH ERASE ERROR");
+            break;
+        }
+    }
+
+    return xToFlashErr(err);
+}
+
+/*
+ * Program one page of a block that has been erased, with no read-modify-write of the block.
+ * The address must be page aligned and len at most a page. Bytes past len stay erased.
+ */
+flashErr_t FLASH_programPage(uint32_t addr, const uint8_t* data, uint32_t len)
+{
+    mt29f_status_t err;
+    uint32_t rowAddr;
+
+    if ((addr % PAGE_DATA_SIZE) != 0 || len == 0 || len > PAGE_DATA_SIZE || addr + (len - 1) > (MT29F1_MAX_ADDR))
+    {
+        return FLASH_ADDR_ERR;
+    }
+
+    //build the row address (block + page)
+    Build_RowAddressNoCmd(ADDRESS_2_BLOCK(addr), ADDRESS_2_PAGE(addr), &rowAddr);
+
+    //the driver only reads the data out over SPI
+    err = FlashPageProgram(rowAddr, (uint8_t *)data, len);
+
+    if (err != Flash_Success)
+    {
+        elogError("FLASH PROGRAM ERROR");
+    }
+
+    return xToFlashErr(err);
+}
+
+static flashErr_t xToFlashErr(mt29f_status_t err)
+{
+    flashErr_t flashErr;
+
+    switch (err)
+    {
+        case Flash_Success:
+            flashErr = FLASH_SUCCESS;
+            break;
+        case Flash_ProgramFailed:
+            flashErr = FLASH_SPI_ERR;
+            break;
+        case Flash_AddressInvalid:
+            flashErr = FLASH_ADDR_ERR;
+            break;
+        default:
+            flashErr = FLASH_GEN_ERROR;
+            break;
+    }
+
+    return flashErr;
+}
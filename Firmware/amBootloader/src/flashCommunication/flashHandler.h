@@ -29,6 +29,7 @@ See Twisthink-SoftwareLicenseAgreement-Auris.docx for details.
 #define MT29F1_OVERHEAD             64
 #define MT29F1_PAGES_PER_BLOCK      64
 #define MT29F1_BLOCK_SIZE           (MT29F1_PAGE_SIZE + MT29F1_OVERHEAD) * MT29F1_PAGES_PER_BLOCK
+#define MT29F1_BLOCK_DATA_SIZE      (MT29F1_PAGE_SIZE * MT29F1_PAGES_PER_BLOCK)
 #define MT29F1_BLOCKS_PER_PLANE     512
 #define MT29F1_PLANE_SIZE           MT29F1_BLOCK_SIZE * MT29F1_BLOCKS_PER_PLANE
 #define MT29F1_PLANES_PER_DEVICE    2
@@ -52,5 +53,6 @@ extern void FLASH_init(void);
 extern flashErr_t FLASH_write(uint32_t address, uint8_t* data, uint32_t len);
 extern flashErr_t FLASH_read(uint32_t address, uint8_t *data, uint32_t len);
 extern flashErr_t FLASH_erase(uint32_t address, uint32_t len);
+extern flashErr_t FLASH_programPage(uint32_t address, const uint8_t* data, uint32_t len);
 
 #endif /* DEVICE_DRIVERS_FLASHHANDLER_H_ */
@@ -0,0 +1,65 @@
+/**************************************************************************************************
+* \file     stm32l4xx_hal.h
+* \brief    Host stand in for the STM32L4 HAL, only what the bootloader modules under test use
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+#ifndef STUBS_STM32L4XX_HAL_H_
+#define STUBS_STM32L4XX_HAL_H_
+
+#include <stdint.h>
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0u,
+    GPIO_PIN_SET
+}GPIO_PinState;
+
+typedef struct
+{
+    volatile uint32_t ODR;
+}GPIO_TypeDef;
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+}GPIO_InitTypeDef;
+
+// The instances are plain structs, the test that builds the modules defines them
+extern GPIO_TypeDef HOST_GpioE;
+
+#define GPIOE                   (&HOST_GpioE)
+
+#define GPIO_PIN_9              ((uint16_t)0x0200)
+#define GPIO_PIN_10             ((uint16_t)0x0400)
+#define GPIO_MODE_OUTPUT_PP     0x00000001u
+#define GPIO_NOPULL             0x00000000u
+#define GPIO_SPEED_FREQ_LOW     0x00000000u
+
+extern void HAL_GPIO_WritePin(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+extern void HAL_GPIO_Init(GPIO_TypeDef * GPIOx, GPIO_InitTypeDef * GPIO_Init);
+
+#endif /* STUBS_STM32L4XX_HAL_H_ */
@@ -0,0 +1,73 @@
+#!/bin/bash
+
+#
+# Build and run the bootloader host tests with gcc
+#
+# Each test_*.c here is built with the bootloader sources it checks and run. The HAL header comes from
+# stubs/, the test stands in for the parts the sources talk to. Run from this folder, everything goes to
+# out/. Exits 1 if any test fails.
+#
+# Usage: ./test.sh [test ...]     e.g. ./test.sh test_mfg_stage
+#
+
+CC="gcc"
+SRC="../../src"
+
+GENERIC_OPTIONS=(   -std=gnu99 \
+                    -O2 \
+                    -g \
+                    -Wall \
+                    -Wno-unused-function \
+                    -Wno-format)
+
+# stubs is first so the HAL header comes from there
+INCLUDE_PATHS=( -I. \
+                -Istubs \
+                -I$SRC \
+                -I$SRC/bootloader \
+                -I$SRC/flashCommunication \
+                -I$SRC/logging)
+
+# Bootloader sources of each test, the *.c is omitted
+declare -A SOURCES
+SOURCES[test_mfg_stage]="$SRC/bootloader/manufacturing $SRC/flashCommunication/flashHandler"
+
+# Extra compile options
+declare -A TEST_OPTIONS
+# the internal flash is mapped at its 32 bit address, so the casts to a pointer are fine
+TEST_OPTIONS[test_mfg_stage]="-Wno-int-to-pointer-cast"
+
+# Run in this order when no test is named
+TESTS=( "test_mfg_stage")
+
+mkdir -p out
+
+if [ $# -ne 0 ]
+then
+    TESTS=( "$@" )
+fi
+
+FAILED=()
+
+for TEST in "${TESTS[@]}"; do
+    echo Running: $TEST
+    OBJECTS=()
+    for FILE in ${SOURCES[$TEST]}; do
+        OBJECTS+=($FILE.c)
+    done
+    BUILD_COMMAND="$CC ${GENERIC_OPTIONS[@]} ${INCLUDE_PATHS[@]} ${TEST_OPTIONS[$TEST]} -o out/$TEST $TEST.c ${OBJECTS[@]}"
+    echo $BUILD_COMMAND
+    $BUILD_COMMAND && out/$TEST
+    if [ $? -ne 0 ]
+    then
+        FAILED+=($TEST)
+    fi
+    echo
+done
+
+if [ ${#FAILED[@]} -ne 0 ]
+then
+    echo Failed: ${FAILED[@]}
+    exit 1
+fi
+echo All ${#TESTS[@]} tests passed
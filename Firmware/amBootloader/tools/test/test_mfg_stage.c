@@ -0,0 +1,526 @@
+/**************************************************************************************************
+* \file     test_mfg_stage.c
+* \brief    Staging the manufacturing image package to the NAND, counted and timed before and after
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "stm32l4xx_hal.h"
+#include "logTypes.h"
+#include "MT29F1.h"
+#include "flashHandler.h"
+#include "manufacturing.h"
+#include "memoryMap.h"
+#include "memMapHandler.h"
+#include "stmFlash.h"
+
+// manufacturing.c and flashHandler.c over a model of the internal flash and of an MT29F1 NAND behind the
+// MT29F1.c API. The internal flash is mapped at its real address, so the firmware reads the image package
+// straight out of it the way it does on the part. The NAND keeps the array, erase sets a whole block to
+// 0xFF, programming can only clear bits, and programming a page twice without an erase is a violation.
+// Every block starts out holding an old image, so a page the copy programs without erasing shows up.
+//
+// Time is simulated: tRD, tPROG and tERS are the typical times of the part, and every byte of a page read
+// or program is clocked over SPI. The CPU time of the copy loops is left out, it is small next to the bus.
+//
+// The "before" figures replay the copy the way it was done before xStageImage: the package 4 KB at a time
+// through FLASH_write, which reads, erases and programs the whole 128 KB block for every call.
+//
+// Usage: test_mfg_stage
+
+#define SPI_BYTE_NS             200u        // 8 clocks at 40 MHz
+#define T_RD_NS                 25000u      // typical times of the part
+#define T_PROG_NS               200000u
+#define T_ERS_NS                2000000u
+#define CMD_BYTES               4u          // instruction and row address of PAGE READ, PROGRAM EXECUTE, BLOCK ERASE
+#define OLD_FILL                0x5Au       // what an old image leaves in a block
+#define INTERNAL_BYTES          ((INTERNAL_FLASH_END_ADDR + STM_FLASH_PAGE_SIZE) - INTERNAL_FLASH_START_ADDR)
+#define PACKAGE_HEADER          5u          // image type and length in front of each image
+#define AM_LEN                  0xC8123u    // a release AM image
+#define AM_FULL_LEN             0xDF000u    // the most the AM slot takes
+#define SSM_LEN                 0xF011u
+#define NO_FAULT                0xFFFFFFFFul
+#define LOG_LINE_LEN            128u
+
+// Counts and simulated time of one run
+typedef struct
+{
+    uint32_t erases;
+    uint32_t programs;
+    uint32_t reads;
+    uint64_t elapsedNs;
+}run_t;
+
+GPIO_TypeDef HOST_GpioE;
+
+static bool xPass = true;
+
+// the internal flash, at INTERNAL_FLASH_START_ADDR
+static uint8_t * xInternal = NULL;
+
+// the part
+static uint8_t * xArray[NUM_BLOCKS];
+static bool xProgrammed[NUM_BLOCKS][NUM_PAGE_BLOCK];
+static uint32_t xErases = 0u;
+static uint32_t xPrograms = 0u;
+static uint32_t xReads = 0u;
+static uint32_t xViolations = 0u;
+static uint64_t xNowNs = 0u;
+static uint32_t xFlipReadAt = NO_FAULT;
+static uint32_t xFailProgramAt = NO_FAULT;
+
+// the log
+static char xLastError[LOG_LINE_LEN];
+static uint32_t xErrors = 0u;
+
+static void xCheck(bool condition, const char * p_what);
+static void xViolation(const char * p_what);
+static uint8_t * xBlock(uint32_t block);
+static void xNandReset(void);
+static uint8_t xPattern(uint32_t i);
+static uint16_t xCrc16(uint16_t crcIn, const uint8_t * p_data, uint32_t len);
+static void xPutImage(uint32_t offset, uint8_t type, uint32_t len);
+static void xLoadPackage(uint32_t amLen, uint32_t ssmLen);
+static bool xIsCopied(uint32_t offset, uint32_t len, uint32_t externalFlashAddr);
+static bool xIsOld(uint32_t block);
+static void xCopyBefore(void);
+static void xWriteBefore(uint32_t offset, uint32_t len, uint32_t externalFlashAddr);
+static void xStartRun(void);
+static void xEndRun(run_t * p_run);
+static void xPrintRun(const char * p_name, const run_t * p_run);
+
+int main(int argc, char **argv)
+{
+    uint32_t amAddr = APP_MEM_ADR_FW_APPLICATION_AM_A_START;
+    uint32_t ssmAddr = APP_MEM_ADR_FW_APPLICATION_SSM_A_START;
+    uint32_t amBlocks = (AM_LEN + (BLOCK_SIZE - 1u)) / BLOCK_SIZE;
+    uint32_t amPages = (AM_LEN + (PAGE_DATA_SIZE - 1u)) / PAGE_DATA_SIZE;
+    uint32_t ssmPages = (SSM_LEN + (PAGE_DATA_SIZE - 1u)) / PAGE_DATA_SIZE;
+    uint32_t errors;
+    run_t before;
+    run_t after;
+    run_t fullBefore;
+    run_t fullAfter;
+
+    xInternal = mmap((void *)(uintptr_t) INTERNAL_FLASH_START_ADDR, INTERNAL_BYTES, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if ( xInternal != (uint8_t *)(uintptr_t) INTERNAL_FLASH_START_ADDR )
+    {
+        printf("  could not map the internal flash at %x\n", INTERNAL_FLASH_START_ADDR);
+        return 1;
+    }
+
+    FLASH_init();
+
+    // a package with a release AM image and an SSM image
+    xLoadPackage(AM_LEN, SSM_LEN);
+    xCheck(MFG_MODE_checkForImagePackageInternalFlash() == true, "the package in internal flash checks out");
+
+    xNandReset();
+    xStartRun();
+    xCopyBefore();
+    xEndRun(&before);
+    xCheck(xIsCopied(PACKAGE_HEADER, AM_LEN, amAddr) && xIsCopied(PACKAGE_HEADER + AM_LEN + PACKAGE_HEADER, SSM_LEN, ssmAddr),
+           "before: both images copy byte exact");
+
+    xNandReset();
+    xStartRun();
+    xCheck(MFG_MODE_copyImagePackageToExternalFlash() == true, "after: the copy reports success");
+    xEndRun(&after);
+    xCheck(xIsCopied(PACKAGE_HEADER, AM_LEN, amAddr) && xIsCopied(PACKAGE_HEADER + AM_LEN + PACKAGE_HEADER, SSM_LEN, ssmAddr),
+           "after: both images copy byte exact");
+    xCheck((after.erases == (amBlocks + 1u)) && (after.programs == (amPages + ssmPages)),
+           "after: each block the images cover is erased once and each page programmed once");
+    xCheck(after.reads == after.programs, "after: the copy is read back once");
+    xCheck(xIsOld(ADDRESS_2_BLOCK(amAddr) - 1u) && xIsOld(ADDRESS_2_BLOCK(ssmAddr) + 1u),
+           "after: the blocks next to the images are not erased");
+    xCheck(xViolations == 0u, "no page is programmed twice without an erase");
+
+    xPrintRun("AM + SSM before", &before);
+    xPrintRun("AM + SSM after ", &after);
+    xCheck((after.erases * 20u) < before.erases, "the copy erases 20 times less than it did");
+    xCheck((after.elapsedNs * 20u) < before.elapsedNs, "the copy takes a 20th of the time it did");
+
+    // the largest AM image the slot takes
+    xLoadPackage(AM_FULL_LEN, SSM_LEN);
+    xNandReset();
+    xStartRun();
+    xCopyBefore();
+    xEndRun(&fullBefore);
+    xNandReset();
+    xStartRun();
+    xCheck(MFG_MODE_copyImagePackageToExternalFlash() == true, "full AM slot: the copy reports success");
+    xEndRun(&fullAfter);
+    xCheck(xIsCopied(PACKAGE_HEADER, AM_FULL_LEN, amAddr) && xIsOld(ADDRESS_2_BLOCK(APP_MEM_ADR_FW_APPLICATION_AM_A_END) + 2u),
+           "full AM slot: the image copies byte exact and the erase stays in the slots");
+    xPrintRun("full AM before ", &fullBefore);
+    xPrintRun("full AM after  ", &fullAfter);
+
+    // FLASH_erase only takes whole blocks
+    xNandReset();
+    errors = xErrors;
+    xCheck(FLASH_erase(amAddr + PAGE_DATA_SIZE, BLOCK_SIZE) == FLASH_ADDR_ERR, "an erase that starts inside a block is rejected");
+    xCheck(FLASH_erase(amAddr, AM_LEN) == FLASH_ADDR_ERR, "an erase that ends inside a block is rejected");
+    xCheck((xErases == 0u) && xIsOld(ADDRESS_2_BLOCK(amAddr)) && (xErrors == (errors + 2u)),
+           "a rejected erase erases nothing and is logged");
+    xCheck((FLASH_erase(amAddr, 2u * BLOCK_SIZE) == FLASH_SUCCESS) && (xErases == 2u), "an erase of two whole blocks erases two");
+
+    // a bit that flips reading the copy back fails the copy
+    xLoadPackage(AM_LEN, SSM_LEN);
+    xNandReset();
+    xFlipReadAt = amPages / 2u;
+    xCheck(MFG_MODE_copyImagePackageToExternalFlash() == false, "a bit flipped in the read back fails the copy");
+    xCheck(strstr(xLastError, "CRC MISMATCH") != NULL, "the CRC mismatch is logged");
+
+    // so does a program that fails, and the copy stops there
+    xNandReset();
+    xFailProgramAt = 10u;
+    xCheck(MFG_MODE_copyImagePackageToExternalFlash() == false, "a failed page program fails the copy");
+    xCheck((xPrograms == 10u) && (xReads == 0u), "the copy stops at the failed program");
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+static void xViolation(const char * p_what)
+{
+    if ( xViolations < 10u )
+    {
+        printf("  violation: %s\n", p_what);
+    }
+    xViolations++;
+}
+
+// The block's data, allocated holding an old image the first time it is touched
+static uint8_t * xBlock(uint32_t block)
+{
+    if ( xArray[block] == NULL )
+    {
+        xArray[block] = malloc(BLOCK_SIZE);
+        memset(xArray[block], OLD_FILL, BLOCK_SIZE);
+        memset(xProgrammed[block], 1, sizeof(xProgrammed[block]));
+    }
+
+    return xArray[block];
+}
+
+// Every block back to an old image, no faults
+static void xNandReset(void)
+{
+    uint32_t block;
+
+    for ( block = 0u; block < NUM_BLOCKS; block++ )
+    {
+        free(xArray[block]);
+        xArray[block] = NULL;
+    }
+    xErases = 0u;
+    xPrograms = 0u;
+    xReads = 0u;
+    xViolations = 0u;
+    xFlipReadAt = NO_FAULT;
+    xFailProgramAt = NO_FAULT;
+    xLastError[0] = '\0';
+}
+
+static uint8_t xPattern(uint32_t i)
+{
+    return (uint8_t)((i * 7u) ^ (i >> 11) ^ 0x3Cu);
+}
+
+// crc-ccitt-false, the one manufacturing.c checks the images with
+static uint16_t xCrc16(uint16_t crcIn, const uint8_t * p_data, uint32_t len)
+{
+    uint8_t x;
+
+    while ( len-- )
+    {
+        x = (crcIn >> 8) ^ *p_data++;
+        x ^= x >> 4;
+        crcIn = (crcIn << 8) ^ ((uint16_t)(x << 12)) ^ ((uint16_t)(x << 5)) ^ ((uint16_t)x);
+    }
+
+    return crcIn;
+}
+
+// An image at offset in the package: type, big endian length, then the image, which starts with the
+// big endian CRC of the rest of it
+static void xPutImage(uint32_t offset, uint8_t type, uint32_t len)
+{
+    uint8_t * p_image = &xInternal[offset + PACKAGE_HEADER];
+    uint16_t crc;
+    uint32_t i;
+
+    xInternal[offset] = type;
+    xInternal[offset + 1u] = (uint8_t)(len >> 24);
+    xInternal[offset + 2u] = (uint8_t)(len >> 16);
+    xInternal[offset + 3u] = (uint8_t)(len >> 8);
+    xInternal[offset + 4u] = (uint8_t)len;
+
+    for ( i = 0u; i < len; i++ )
+    {
+        p_image[i] = xPattern(offset + i);
+    }
+
+    crc = xCrc16(0xFFFFu, &p_image[2], len - 2u);
+    p_image[0] = (uint8_t)(crc >> 8);
+    p_image[1] = (uint8_t)crc;
+}
+
+static void xLoadPackage(uint32_t amLen, uint32_t ssmLen)
+{
+    memset(xInternal, 0xFF, INTERNAL_BYTES);
+    xPutImage(0u, AM_IMAGE, amLen);
+    xPutImage(PACKAGE_HEADER + amLen, SSM_IMAGE, ssmLen);
+}
+
+static bool xIsCopied(uint32_t offset, uint32_t len, uint32_t externalFlashAddr)
+{
+    uint32_t i;
+
+    for ( i = 0u; i < len; i++ )
+    {
+        uint32_t addr = externalFlashAddr + i;
+
+        if ( xBlock(ADDRESS_2_BLOCK(addr))[addr % BLOCK_SIZE] != xInternal[offset + i] )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool xIsOld(uint32_t block)
+{
+    uint8_t * p_data = xBlock(block);
+    uint32_t i;
+
+    for ( i = 0u; i < BLOCK_SIZE; i++ )
+    {
+        if ( p_data[i] != OLD_FILL )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// MFG_MODE_copyImagePackageToExternalFlash as it was
+static void xCopyBefore(void)
+{
+    uint32_t amLen = (xInternal[1] << 24) | (xInternal[2] << 16) | (xInternal[3] << 8) | xInternal[4];
+    uint32_t ssmOffset = PACKAGE_HEADER + amLen;
+    uint32_t ssmLen = (xInternal[ssmOffset + 1u] << 24) | (xInternal[ssmOffset + 2u] << 16) |
+                      (xInternal[ssmOffset + 3u] << 8) | xInternal[ssmOffset + 4u];
+
+    xWriteBefore(PACKAGE_HEADER, amLen, APP_MEM_ADR_FW_APPLICATION_AM_A_START);
+    xWriteBefore(ssmOffset + PACKAGE_HEADER, ssmLen, APP_MEM_ADR_FW_APPLICATION_SSM_A_START);
+}
+
+static void xWriteBefore(uint32_t offset, uint32_t len, uint32_t externalFlashAddr)
+{
+    static uint8_t dataBuffer[STM_FLASH_PAGE_SIZE];
+    uint32_t bytesThisRound;
+
+    while ( len > 0u )
+    {
+        bytesThisRound = (len >= STM_FLASH_PAGE_SIZE) ? STM_FLASH_PAGE_SIZE : len;
+        memcpy(dataBuffer, &xInternal[offset], bytesThisRound);
+        FLASH_write(externalFlashAddr, dataBuffer, bytesThisRound);
+        len -= bytesThisRound;
+        offset += bytesThisRound;
+        externalFlashAddr += bytesThisRound;
+    }
+}
+
+static void xStartRun(void)
+{
+    xErases = 0u;
+    xPrograms = 0u;
+    xReads = 0u;
+    xNowNs = 0u;
+}
+
+static void xEndRun(run_t * p_run)
+{
+    p_run->erases = xErases;
+    p_run->programs = xPrograms;
+    p_run->reads = xReads;
+    p_run->elapsedNs = xNowNs;
+}
+
+static void xPrintRun(const char * p_name, const run_t * p_run)
+{
+    printf("  %s: %4u erases, %5u programs, %5u reads, %6.2f s\n",
+           p_name, p_run->erases, p_run->programs, p_run->reads, p_run->elapsedNs / 1e9);
+}
+
+// The MT29F1.c calls flashHandler.c makes
+
+mt29f_status_t FlashUnlockAll(void)
+{
+    return Flash_Success;
+}
+
+mt29f_status_t Build_Address(uint16_t block, uint8_t page, uint16_t col, uint32_t* addr)
+{
+    if ( (block >= NUM_BLOCKS) || (page >= NUM_PAGE_BLOCK) || (col >= PAGE_SIZE) )
+    {
+        return Flash_AddressInvalid;
+    }
+
+    *addr = ((uint32_t)block << 17) | ((uint32_t)page << 11) | col;
+
+    return Flash_Success;
+}
+
+mt29f_status_t Build_RowAddressNoCmd(uint16_t block, uint8_t page, uint32_t* addr)
+{
+    if ( (block >= NUM_BLOCKS) || (page >= NUM_PAGE_BLOCK) )
+    {
+        return Flash_AddressInvalid;
+    }
+
+    *addr = ((uint32_t)block << 6) | page;
+
+    return Flash_Success;
+}
+
+mt29f_status_t FlashBlockErase(uAddrType udBlockAddr)
+{
+    uint32_t block = udBlockAddr >> 6;
+
+    if ( ((udBlockAddr & 0x3Fu) != 0u) || (block >= NUM_BLOCKS) )
+    {
+        xViolation("erase row is not the first page of a block");
+        return Flash_AddressInvalid;
+    }
+
+    memset(xBlock(block), 0xFF, BLOCK_SIZE);
+    memset(xProgrammed[block], 0, sizeof(xProgrammed[block]));
+    xErases++;
+    xNowNs += (CMD_BYTES * SPI_BYTE_NS) + T_ERS_NS;
+
+    return Flash_Success;
+}
+
+mt29f_status_t FlashPageRead(uAddrType udAddr, uint8_t *pArray)
+{
+    uint32_t block = udAddr >> 6;
+    uint32_t page = udAddr & 0x3Fu;
+
+    if ( block >= NUM_BLOCKS )
+    {
+        return Flash_AddressInvalid;
+    }
+
+    memcpy(pArray, &xBlock(block)[page * PAGE_DATA_SIZE], PAGE_DATA_SIZE);
+    if ( (xFlipReadAt != NO_FAULT) && (xFlipReadAt-- == 0u) )
+    {
+        pArray[PAGE_DATA_SIZE / 3u] ^= 0x10u;
+    }
+    xReads++;
+    xNowNs += ((CMD_BYTES + PAGE_DATA_SIZE) * SPI_BYTE_NS) + T_RD_NS;
+
+    return Flash_Success;
+}
+
+mt29f_status_t FlashPageProgram(uAddrType udAddr, uint8_t *pArray, uint32_t udNrOfElementsInArray)
+{
+    uint32_t block = udAddr >> 6;
+    uint32_t page = udAddr & 0x3Fu;
+    uint8_t * p_page;
+    uint32_t i;
+
+    if ( (block >= NUM_BLOCKS) || (udNrOfElementsInArray > PAGE_DATA_SIZE) )
+    {
+        return Flash_AddressInvalid;
+    }
+
+    if ( (xFailProgramAt != NO_FAULT) && (xFailProgramAt-- == 0u) )
+    {
+        return Flash_ProgramFailed;
+    }
+
+    p_page = &xBlock(block)[page * PAGE_DATA_SIZE];
+    if ( xProgrammed[block][page] == true )
+    {
+        xViolation("page programmed twice without an erase");
+    }
+    for ( i = 0u; i < udNrOfElementsInArray; i++ )
+    {
+        p_page[i] &= pArray[i];
+    }
+    xProgrammed[block][page] = true;
+    xPrograms++;
+    xNowNs += ((CMD_BYTES + udNrOfElementsInArray) * SPI_BYTE_NS) + T_PROG_NS;
+
+    return Flash_Success;
+}
+
+// The HAL and the logger
+
+void HAL_GPIO_WritePin(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef * GPIOx, GPIO_InitTypeDef * GPIO_Init)
+{
+}
+
+void logCore(const char * fileName, const char * functionName, int lineNumber, tLogLvl loggingLevel, const char * formatStr, ...)
+{
+    char line[LOG_LINE_LEN];
+    va_list args;
+
+    va_start(args, formatStr);
+    vsnprintf(line, sizeof(line), formatStr, args);
+    va_end(args);
+
+    if ( loggingLevel >= eLogLvlError )
+    {
+        strcpy(xLastError, line);
+        xErrors++;
+    }
+
+    if ( getenv("HOST_VERBOSE") != NULL )
+    {
+        printf("    [%s] %s\n", functionName, line);
+    }
+}
@@ -38,6 +38,17 @@ static asp_msg_t Rx_Msg = {};
 static uint8_t rsp[100];
 static uint8_t rspLen = 0;
 
+// The SSM link starts at the slowest SPI clock. After this many good response frames in a row it is
+// stepped up one speed, a bad frame steps it back down and caps it there until the next boot.
+#define ASP_LINK_GOOD_FRAMES_TO_SPEED_UP        4u
+
+static uint8_t xLinkGoodFrames = 0;
+static uint8_t xLinkMaxSpeed = (SPI_SSM_NUM_SPEEDS - 1);
+static bool xLinkSpeedUpPending = false;
+static uint32_t xLinkFramesGood = 0;
+static uint32_t xLinkFramesBad = 0;
+static uint32_t xLinkTransferFails = 0;
+
 aspMessageCode_t ASP_SendCommandMsg(asp_commands_t cmd,  uint8_t response_id, uint8_t expected_bytes, uint8_t *rspBuffer, uint8_t *rspLen);
 aspMessageCode_t ASP_GetSSMStatus(asp_status_payload_t * ssmStat);
 aspMessageCode_t ASP_GetAttnSrcList(asp_attn_source_payload_t * attnSources);
@@ -50,6 +61,11 @@ aspMessageCode_t ASP_SensorDataStoredToFlash(void);
 aspMessageCode_t ASP_SetTime(uint32_t time);
 aspMessageCode_t ASP_SendConfigs(uint16_t transmissionRateDays, bool strokeAlgIsOn, uint16_t redFlagOnThresh, uint16_t redFlagOffThresh);
 aspMessageCode_t ASP_SendAttnSrcAckMsg(asp_attn_source_payload_t *pMsg);
+void ASP_ReportLinkStats(void);
+
+static spiStatus_t xSsmTransfer(const spiData_t* pDataToSend, spiData_t* pDataReceived, bool idempotent);
+static bool xResponseFrameIsGood(const spiData_t* pDataReceived);
+static void xLinkStepDown(bool capSpeed);
 
 // Transmit the provided command message with the provided to command.
 aspMessageCode_t ASP_SendCommandMsg(asp_commands_t cmd,  uint8_t response_id, uint8_t expected_bytes, uint8_t *rspBuffer, uint8_t *rspLen)
@@ -75,7 +91,8 @@ aspMessageCode_t ASP_SendCommandMsg(asp_commands_t cmd,  uint8_t response_id, ui
         Tx_Msg.fields.responseID = response_id;
         Tx_Msg.fields.payload.bytes[Tx_Msg.fields.payloadLen] = Tx_Msg.fields.checksum;  // Move checksum to end of payload.
 
-        if ( SPI_ssmTransfer(&tx_data, &rx_data, OpsInitTransfer) != spiSuccess )
+        //only the read commands are safe to repeat if the first try at a new clock speed fails
+        if ( xSsmTransfer(&tx_data, &rx_data, ((cmd == CMD_GET_STATUS) || (cmd == CMD_GET_ATTN_SRC) || (cmd == CMD_GET_ENTRIES_IN_LOG))) != spiSuccess )
         {
             elogError("COMMAND MESSAGE FAILED");
             result = TIMEOUT;
@@ -116,7 +133,7 @@ aspMessageCode_t ASP_GetSensorData(uint16_t entriesToGet, asp_sensor_data_entry_
     Tx_Msg.fields.checksum = (uint8_t) ASP_ComputeChecksum(&Tx_Msg);
     Tx_Msg.fields.payload.bytes[Tx_Msg.fields.payloadLen] = Tx_Msg.fields.checksum;  // Move checksum to end of payload.
 
-    if ( SPI_ssmTransfer(&tx_data, &rx_data, OpsInitTransfer) != spiSuccess )
+    if ( xSsmTransfer(&tx_data, &rx_data, true) != spiSuccess )
     {
         elogError("Get Data message failed");
         result = TIMEOUT;
@@ -203,7 +220,7 @@ aspMessageCode_t ASP_SetTime(uint32_t time)
     Tx_Msg.fields.checksum = (uint8_t) ASP_ComputeChecksum(&Tx_Msg);
     Tx_Msg.fields.payload.bytes[Tx_Msg.fields.payloadLen] = Tx_Msg.fields.checksum;  // Move checksum to end of payload.
 
-    if ( SPI_ssmTransfer(&tx_data, &rx_data, OpsInitTransfer) != spiSuccess )
+    if ( xSsmTransfer(&tx_data, &rx_data, false) != spiSuccess )
     {
         elogError("SET TIME FAILED TO SEND/RX");
         result = TIMEOUT;
@@ -262,7 +279,7 @@ aspMessageCode_t ASP_SendConfigs(uint16_t transmissionRateDays, bool strokeAlgIs
     Tx_Msg.fields.checksum = (uint8_t) ASP_ComputeChecksum(&Tx_Msg);
     Tx_Msg.fields.payload.bytes[Tx_Msg.fields.payloadLen] = Tx_Msg.fields.checksum;  // Move checksum to end of payload.
 
-    if ( SPI_ssmTransfer(&tx_data, &rx_data, OpsInitTransfer) != spiSuccess )
+    if ( xSsmTransfer(&tx_data, &rx_data, false) != spiSuccess )
     {
         elogError("CONFIG FAILED TO SEND/RX");
         result = TIMEOUT;
@@ -317,7 +334,7 @@ aspMessageCode_t ASP_SendAttnSrcAckMsg(asp_attn_source_payload_t *pMsg)
     Tx_Msg.fields.checksum = (uint8_t) ASP_ComputeChecksum(&Tx_Msg);
     Tx_Msg.fields.payload.bytes[Tx_Msg.fields.payloadLen] = Tx_Msg.fields.checksum;  // Move checksum to end of payload.
 
-    if ( SPI_ssmTransfer(&tx_data, &rx_data, OpsInitTransfer) != spiSuccess )
+    if ( xSsmTransfer(&tx_data, &rx_data, false) != spiSuccess )
     {
         elogError("SEND ATTN SRC ACK MSG FAILED");
         result = TIMEOUT;
@@ -479,20 +496,32 @@ aspMessageCode_t ASP_GetSSMStatus(asp_status_payload_t * ssmStat)
 {
     aspMessageCode_t result = BAD_REQUEST;
     asp_msg_t formatted;
+    uint16_t frameLen = 0;
 
     result = ASP_SendCommandMsg(CMD_GET_STATUS, ASP_STATUS_MSG_ID, (ASP_TOTAL_OVERHEAD_BYTES + ASP_STATUS_PAYLOAD_BYTES), (uint8_t*)&rsp, &rspLen);
 
     if (result == COM_SUCCESS )
     {
-        //unpack the rsp
-        result = ASP_ProcessIncomingBuffer((uint8_t*)&rsp, rspLen, &formatted);
+        //unpack the rsp, an SSM from before the profile fields answers with a shorter frame
+        frameLen = (uint16_t)rsp[1] + ASP_TOTAL_OVERHEAD_BYTES;
+        result = ASP_ProcessIncomingBuffer((uint8_t*)&rsp, (frameLen < rspLen) ? frameLen : rspLen, &formatted);
 
         if (result == VALID_MSG)
         {
             if ( formatted.fields.messageID == ASP_STATUS_MSG_ID )
             {
-                *ssmStat = formatted.fields.payload.status;
-                result = SUCCESSFUL_REQUEST;
+                //only take the fields that were sent, the profile fields read 0 when they were not
+                if ( formatted.fields.payloadLen < ASP_STATUS_MIN_PAYLOAD_BYTES )
+                {
+                    result = INVALID_LEN;
+                }
+                else
+                {
+                    memset(ssmStat, 0, sizeof(asp_status_payload_t));
+                    memcpy(ssmStat, &formatted.fields.payload.status,
+                           (formatted.fields.payloadLen < ASP_STATUS_PAYLOAD_BYTES) ? formatted.fields.payloadLen : ASP_STATUS_PAYLOAD_BYTES);
+                    result = SUCCESSFUL_REQUEST;
+                }
             }
             else if ( formatted.fields.messageID == ASP_NACK_MSG_ID )
             {
@@ -606,4 +635,103 @@ aspMessageCode_t ASP_GetAttnSrcList(asp_attn_source_payload_t * attnSources)
     return result;
 }
 
+// Print the SSM link speed and frame counts.
+void ASP_ReportLinkStats(void)
+{
+    elogInfo("SSM link speed %d/%d (%lu Hz), max %d", SPI_ssmGetSpeed(), (SPI_SSM_NUM_SPEEDS - 1),
+             SPI_ssmGetBitRate(), xLinkMaxSpeed);
+    elogInfo("SSM frames good: %lu, bad: %lu, failed transfers: %lu", xLinkFramesGood, xLinkFramesBad,
+             xLinkTransferFails);
+}
+
+// Every exchange with the SSM goes through here so the response frames can grade the link.
+// A faster clock is only tried on an idempotent request, a request that changes state on the
+// SSM (increment tail, set time, ...) must not be the one that finds out the new speed is too fast.
+static spiStatus_t xSsmTransfer(const spiData_t* pDataToSend, spiData_t* pDataReceived, bool idempotent)
+{
+    spiStatus_t status;
+
+    if ( (xLinkSpeedUpPending == true) && (idempotent == true) )
+    {
+        xLinkSpeedUpPending = false;
+
+        if ( SPI_ssmSetSpeed(SPI_ssmGetSpeed() + 1u) == true )
+        {
+            elogInfo("SSM link up to %lu Hz", SPI_ssmGetBitRate());
+        }
+    }
+
+    status = SPI_ssmTransfer(pDataToSend, pDataReceived, OpsInitTransfer);
+
+    if ( status != spiSuccess )
+    {
+        xLinkTransferFails++;
+
+        //the SSM may just have been busy, step down but keep trying this speed later
+        xLinkStepDown(false);
+    }
+    else if ( xResponseFrameIsGood(pDataReceived) == false )
+    {
+        xLinkFramesBad++;
+        xLinkStepDown(true);
+    }
+    else
+    {
+        xLinkFramesGood++;
+        xLinkGoodFrames++;
+
+        if ( (xLinkGoodFrames >= ASP_LINK_GOOD_FRAMES_TO_SPEED_UP) && (SPI_ssmGetSpeed() < xLinkMaxSpeed) )
+        {
+            xLinkGoodFrames = 0;
+            xLinkSpeedUpPending = true;
+        }
+    }
+
+    return status;
+}
+
+// The SSM answers with a frame of its own length (a NACK is shorter than the response asked for),
+// only that frame is checked.  A NACK with a good checksum is a good frame, the SSM NACKs requests
+// it can not serve as well as ones that came in garbled.
+static bool xResponseFrameIsGood(const spiData_t* pDataReceived)
+{
+    asp_msg_t formatted;
+    uint16_t frameLen = 0;
+
+    if ( pDataReceived->length < ASP_TOTAL_OVERHEAD_BYTES )
+    {
+        return false;
+    }
+
+    frameLen = (uint16_t)pDataReceived->pChar[1] + ASP_TOTAL_OVERHEAD_BYTES;
+
+    if ( frameLen > pDataReceived->length )
+    {
+        return false;
+    }
+
+    return (ASP_ProcessIncomingBuffer(pDataReceived->pChar, frameLen, &formatted) == VALID_MSG);
+}
+
+static void xLinkStepDown(bool capSpeed)
+{
+    uint8_t speed = SPI_ssmGetSpeed();
+
+    xLinkGoodFrames = 0;
+    xLinkSpeedUpPending = false;
+
+    if ( speed > 0u )
+    {
+        speed--;
+
+        if ( capSpeed == true )
+        {
+            xLinkMaxSpeed = speed;
+        }
+
+        SPI_ssmSetSpeed(speed);
+        elogOffNominal("SSM link down to %lu Hz", SPI_ssmGetBitRate());
+    }
+}
+
 #endif //AM_BUILD
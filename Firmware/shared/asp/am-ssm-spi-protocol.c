@@ -36,128 +36,75 @@ typedef enum asp_message_state
     ASP_RECEIVE_CHECKSUM      /*< Receiving checksum */
 }asp_message_state_t;
 
-static asp_msg_t Tx_Msg = {};
-
 // SHARED FUNCTIONS ---------------------------------------------------------
 uint8_t ASP_ComputeChecksum(asp_msg_t * p_msg);
-asp_msg_t * ASP_GetTxBuffer(void);
 aspMessageCode_t ASP_ProcessIncomingBuffer(uint8_t *bytes, uint16_t bufferLen, asp_msg_t *formattedMsg);
 
 
 #if defined(SSM_BUILD)
 
-void ASP_ProcessIncomingByte(uint8_t byte);
+void ASP_ProcessIncomingFrame(asp_msg_t * p_msg, uint8_t len);
+asp_msg_t * ASP_GetTxBuffer(void);
 static void HandleValidMsg(asp_msg_t * p_msg);
 
-static asp_msg_t Rx_Msg = {};
+// Responses are built in one buffer while the other one may still be going out
+static asp_msg_t Tx_Msg[2] = {};
+static uint8_t Tx_Msg_Idx = 0;
 
-// A message is being or has been received.  Parse the header info and
-// checksum and make sure it is good before calling the handler.
-void ASP_ProcessIncomingByte(uint8_t byte)
+// A complete frame has been received by uC_SPI (it found the start byte and counted the bytes).
+// Check the header info and checksum and make sure it is good before calling the handler.
+void ASP_ProcessIncomingFrame(asp_msg_t * p_msg, uint8_t len)
 {
-	static uint8_t payload_bytes_expected = 0;
-	static uint8_t payload_bytes_received = 0;
-    static uint8_t receive_state = ASP_LOOK_FOR_START;
-
-    /* - A byte has been received.  State machine to process it. */
-	switch ( receive_state )
-	{
-		case ASP_LOOK_FOR_START:
-		{
-            /* If we found the magic value, prepare to start saving the message. */
-			if ( byte == ASP_START_FRAME_MAGIC )
-			{
-			    payload_bytes_expected = 0;
-				receive_state = ASP_RECEIVE_LEN;
-			}
-			break;
-		}
-		case ASP_RECEIVE_LEN:
-		{
-            /* - if length is valid, look for ID */
-			if ( byte <= sizeof(asp_payload_t) )
-			{
-				Rx_Msg.fields.payloadLen = byte;
-				receive_state = ASP_RECEIVE_ID;
-			}
-			else
-			{
-                /* - Length is invalid.  Start over. */
-			    ASP_HandleErroneousMsg();
-				receive_state = ASP_LOOK_FOR_START;
-			}
-			break;
-		}
-		case ASP_RECEIVE_ID:
-		{
-			switch ( byte )
-			{
-                case ASP_CONFIG_MSG_ID                       :
-                case ASP_COMMAND_MSG_ID                      :
-                case ASP_SET_RTC_MSG_ID                      :
-                case ASP_STATUS_MSG_ID                       :
-                case ASP_ATTN_SRC_MSG_ID                     :
-                case ASP_ATTN_SRC_ACK_MSG_ID                 :
-                case ASP_GET_SENSOR_DATA_ENTRIES_MSG_ID      :
-				{
-                    /* - Valid ID received */
-					Rx_Msg.fields.messageID = byte;
+    bool valid = false;
 
-					if ( Rx_Msg.fields.payloadLen > 0 )
-					{
-                        /* - There is a payload so prepare to receive it.  (NACKs can have zero payload) */
-						payload_bytes_expected = Rx_Msg.fields.payloadLen;
-						payload_bytes_received = 0;
-						receive_state = ASP_RECEIVE_PAYLOAD;
-					}
-					else
-					{
-                        /* - No payload, receive checksum */
-						receive_state = ASP_RECEIVE_CHECKSUM;
-					}
-					break;
-				}
-				default:
-				{
-                    /* - Invalid ID.  Restart */
-				    ASP_HandleErroneousMsg();
-					receive_state = ASP_LOOK_FOR_START;
-					break;
-				}
-			}
-			break;
-		}
-		case ASP_RECEIVE_PAYLOAD:
-		{
-            /* - Receive the expected number of bytes */
-			Rx_Msg.fields.payload.bytes[payload_bytes_received] = byte;
-			payload_bytes_received++;
-			if ( payload_bytes_received >= payload_bytes_expected )
+    if ( (p_msg != NULL) &&
+         (p_msg->fields.startFrame == ASP_START_FRAME_MAGIC) &&
+         (p_msg->fields.payloadLen <= sizeof(asp_payload_t)) &&
+         (len == (p_msg->fields.payloadLen + ASP_TOTAL_OVERHEAD_BYTES)) )
+    {
+        switch ( p_msg->fields.messageID )
+        {
+            case ASP_CONFIG_MSG_ID                       :
+            case ASP_COMMAND_MSG_ID                      :
+            case ASP_SET_RTC_MSG_ID                      :
+            case ASP_STATUS_MSG_ID                       :
+            case ASP_ATTN_SRC_MSG_ID                     :
+            case ASP_ATTN_SRC_ACK_MSG_ID                 :
+            case ASP_GET_SENSOR_DATA_ENTRIES_MSG_ID      :
             {
-				receive_state = ASP_RECEIVE_CHECKSUM;
+                /* - Valid ID received, the checksum follows the payload */
+                valid = (ASP_ComputeChecksum(p_msg) == p_msg->bytes[(p_msg->fields.payloadLen + ASP_HEADER_BYTES)]);
+                break;
             }
-			break;
-		}
-	 	case ASP_RECEIVE_CHECKSUM:
-	 	{
-             /* Validate the checksum */
-	 		if ( ASP_ComputeChecksum(&Rx_Msg) == byte )
-	 		{
-                 /* - Checksum is good.  Call the handler. */
-	 		    HandleValidMsg(&Rx_Msg);
-	 		}
-	 		else
-	 		{
-                /* Checksum is incorrect. */
-                ASP_HandleErroneousMsg();
-	 		}
-             /* - Reset state machine.  */
-             receive_state = ASP_LOOK_FOR_START;
-	 		break;
-		}
-	}
+            default:
+            {
+                /* - Invalid ID */
+                break;
+            }
+        }
+    }
+
+    if ( valid == true )
+    {
+        /* - Checksum is good.  Call the handler. */
+        HandleValidMsg(p_msg);
+    }
+    else
+    {
+        ASP_HandleErroneousMsg();
+    }
 }
 
+// Get a pointer to the transmit buffer.  Never the one uC_SPI is still sending from.
+asp_msg_t * ASP_GetTxBuffer(void)
+{
+    if ( uC_SPI_IsSending(Tx_Msg[Tx_Msg_Idx].bytes) == true )
+    {
+        Tx_Msg_Idx ^= 1u;
+    }
+
+    return &Tx_Msg[Tx_Msg_Idx];
+}
 
 // A validly constructed message has been received.  Now send it to the handler.
 static void HandleValidMsg(asp_msg_t * p_msg)
@@ -203,12 +150,6 @@ static void HandleValidMsg(asp_msg_t * p_msg)
 
 #endif
 
-// Get a pointer to the transmit buffer.
-asp_msg_t * ASP_GetTxBuffer(void)
-{
-    return &Tx_Msg;
-}
-
 #ifdef AM_BUILD
 //Pass in a full received message (on the AM) and this function formats the msg and determines
 //if it is valid OR the reason that it is an invalid msg
@@ -23,6 +23,7 @@
 #ifndef HANDLERS_AM_SSM_SPI_PROTOCOL_H_
 #define HANDLERS_AM_SSM_SPI_PROTOCOL_H_
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "APP_NVM_Cfg_Shared.h"
@@ -190,6 +191,9 @@ typedef struct __attribute__ ((packed)) asp_status_payload
     uint32_t activatedDate;
     uint32_t unexpectedResetCount;
     uint32_t timeLastReset;
+    uint16_t algoMeanUs;                // algorithm nest run time since the SSM profile was cleared
+    uint16_t algoMaxUs;
+    uint16_t loopMaxUs;                 // longest pass of the SSM background loop, 0xFFFF if over 60 ms
 }asp_status_payload_t;
 
 
@@ -268,6 +272,7 @@ typedef struct __attribute__ ((packed)) asp_attn_source_payload
 //SSM -> AM
 #define ASP_STATUS_MSG_ID                         (0x20)
 #define ASP_STATUS_PAYLOAD_BYTES                  (sizeof(asp_status_payload_t))
+#define ASP_STATUS_MIN_PAYLOAD_BYTES              (offsetof(asp_status_payload_t, algoMeanUs))   // SSM without the profile fields
 #define ASP_SENSOR_DATA_MSG_ID                    (0x21)
 #define ASP_SENSOR_DATA_PAYLOAD_BYTES             (sizeof(asp_sensor_data_payload_t))
 #define ASP_NUM_DATA_ENTRIES_MSG_ID               (0x24)
@@ -329,11 +334,14 @@ extern aspMessageCode_t ASP_ProcessIncomingBuffer(uint8_t *bytes, uint16_t buffe
 extern aspMessageCode_t ASP_SendHwReset(void);
 extern aspMessageCode_t ASP_SendResetAlarmsCmd(void);
 extern aspMessageCode_t ASP_SendConfigs(uint16_t transmissionRateDays, bool  strokeAlgIsOn,  uint16_t redFlagOnThresh, uint16_t redFlagOffThresh);
+extern void ASP_ReportLinkStats(void);
 
 // SSM FUNCTIONS --------------------------------------------------------
 #elif defined(SSM_BUILD)
 
 extern void ASP_SSM_Periodic(void);
+extern void ASP_ProcessIncomingFrame(asp_msg_t * p_msg, uint8_t len);
+extern asp_msg_t * ASP_GetTxBuffer(void);
 extern void ASP_HandleCommandMsg(asp_msg_t * p_msg);
 extern void ASP_TransmitBytesInSensorDataLog(void);
 extern void ASP_HandleGetSensorDataMsg(void);
@@ -352,7 +360,5 @@ extern void ASP_HandleConfigMsg(asp_msg_t *pMsg);
 
 // SHARED FUNCTIONS -----------------------------------------------------
 extern uint8_t ASP_ComputeChecksum(asp_msg_t * p_msg);
-extern void ASP_ProcessIncomingByte(uint8_t ubByte);
-extern asp_msg_t * ASP_GetTxBuffer(void);
 
 #endif /* HANDLERS_AM_SSM_SPI_PROTOCOL_H_ */
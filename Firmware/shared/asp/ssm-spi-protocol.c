@@ -27,13 +27,15 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
-#include "HW_RTC.h"
+#include <string.h>
+#include "HW_CLK.h"
 #include "APP_ALGO.h"
 #include "version.h"
 #include "HW.h"
 #include "HW_BAT.h"
 #include "APP.h"
 #include "APP_NVM.h"
+#include "APP_PROF.h"
 
 void ASP_SSM_Periodic(void);
 void ASP_HandleCommandMsg(asp_msg_t * p_msg);
@@ -47,11 +49,25 @@ void ASP_HandleConfigMsg(asp_msg_t *pMsg);
 void ASP_TransmitAck(uint8_t ackId);
 void ASP_HandleErroneousMsg(void);
 
-// Periodic function for ASP coms.
+// Periodic function for ASP coms.  uC_SPI has already framed the bytes, handle whole frames.
 void ASP_SSM_Periodic(void)
 {
-	while ( uC_SPI_BytesReady() )
-		ASP_ProcessIncomingByte( uC_SPI_GetNextByte() );
+    uint8_t len = 0;
+    asp_msg_t * p_msg = NULL;
+
+    uC_SPI_Periodic();
+
+    if ( uC_SPI_TakeFramingError() == true )
+    {
+        ASP_HandleErroneousMsg();
+    }
+
+    while ( uC_SPI_FrameReady() )
+    {
+        p_msg = (asp_msg_t *)uC_SPI_GetFrame(&len);
+        ASP_ProcessIncomingFrame(p_msg, len);
+        uC_SPI_ReleaseFrame();
+    }
 }
 
 // A get log message was received.  Identify the command and respond.
@@ -80,7 +96,7 @@ void ASP_HandleSetRTCMsg(asp_msg_t * p_msg)
 
     time = (p_msg->fields.payload.setRTC.RTC_time);
 
-    if (HW_RTC_SetTimeEpoch(time))
+    if (HW_CLK_SetEpoch(time))
     {
         APP_setTimeUpdated();
     }
@@ -135,6 +151,8 @@ void ASP_HandleCommandMsg(asp_msg_t * p_msg)
         case CMD_GET_ENTRIES_IN_LOG:
         {
             ASP_TransmitBytesInSensorDataLog();
+            // the AM drains the log next, read ahead while it does
+            APP_NVM_Custom_StartSensorDataPrefetch();
             break;
         }
         case CMD_GET_ATTN_SRC:
@@ -203,7 +221,7 @@ void ASP_TransmitStatus(void)
     p_msg->fields.payload.status.ssmFwVersion.fwMin = VERSION_MINOR;
     p_msg->fields.payload.status.ssmFwVersion.fwBuild = VERSION_BUILD;
     p_msg->fields.payload.status.errorBits = APP_getErrorBits();
-    p_msg->fields.payload.status.timestamp = HW_RTC_GetEpochTime();
+    p_msg->fields.payload.status.timestamp = HW_CLK_GetEpochTime();
     p_msg->fields.payload.status.voltageMv = HW_BAT_GetVoltage();
     p_msg->fields.payload.status.powerRemainingPercent = 50;
     p_msg->fields.payload.status.breakdown = false;
@@ -211,6 +229,9 @@ void ASP_TransmitStatus(void)
     p_msg->fields.payload.status.activatedDate = APP_NVM_Custom_GetActivatedDate();
     p_msg->fields.payload.status.unexpectedResetCount = APP_NVM_Custom_GetUnexpectedResetCount();
     p_msg->fields.payload.status.timeLastReset = APP_NVM_Custom_GetTimestampLastUnexpectedReset();
+    p_msg->fields.payload.status.algoMeanUs = APP_PROF_GetMean(PROF_ALGO_NEST);
+    p_msg->fields.payload.status.algoMaxUs = APP_PROF_GetStats(PROF_ALGO_NEST)->max;
+    p_msg->fields.payload.status.loopMaxUs = APP_PROF_GetStats(PROF_LOOP)->max;
 
     p_msg->fields.checksum = ASP_ComputeChecksum(p_msg);
     p_msg->bytes[(p_msg->fields.payloadLen + ASP_HEADER_BYTES)] = p_msg->fields.checksum;
@@ -28,11 +28,16 @@
 #include "am-ssm-spi-protocol.h"
 #include "HW_GPIO.h"
 #include "HW_RTC.h"
+#include "HW_CLK.h"
 #include "HW_BAT.h"
 #include "uC_TIME.h"
 #include "APP.h"
 #include "HW_ENV.h"
 #include "HW_MAG.h"
+#include "APP_MAG.h"
+#include "HW_TRACE.h"
+#include "uC_UART.h"
+#include "APP_PROF.h"
 
 //this is non configurable
 #define WAKE_RATE_DEACTIVATED_DAYS          28
@@ -150,7 +155,6 @@ void APP_init(void)
 {
     APP_CLI_Init();
     APP_NVM_Init();
-    APP_ALGO_Init();
 
     //Get the high level state and reset state(tells us if there have been any non planned resets)
     xCurrentState = (app_state_t)APP_NVM_Custom_GetHighLevelState();
@@ -175,17 +179,21 @@ void APP_init(void)
 
     sprintf((char *)appString, "\n\rHigh level state: %d \n\r Tx rate %d\n\r", xCurrentState, xTransmissionRateInDays);
     HW_TERM_Print(appString);
+    HW_TRACE_2(TRACE_BOOT, xCurrentState, xResetState);
 
     //init attention source list
     memset(&xCurrentAttnList, 0, sizeof(asp_attn_source_payload_t));
 
     //check the rtc
-    xValidTimestamp = HW_RTC_CheckValidTime();
+    xValidTimestamp = HW_CLK_Sync();
+
+    //after the clock, a checkpoint from this hour keeps its hourly totals
+    APP_ALGO_WarmStart();
 
     if ( xValidTimestamp == true )
     {
-        xCurrentTimeStamp = HW_RTC_GetEpochTime();
-        xLastRtcEpoch = HW_RTC_GetEpochTime();
+        xCurrentTimeStamp = HW_CLK_GetEpochTime();
+        xLastRtcEpoch = xCurrentTimeStamp;
 
         //if activated, see when the next hour will be
         //otherwise adjust the '1 day' time period for accounting
@@ -224,6 +232,7 @@ void APP_periodic(void)
 {
     uint64_t xCurrentRuntimeTickVal = uC_TIME_GetRuntimeTicks();
     uint32_t xCurrentRuntimeSecVal = uC_TIME_GetRuntimeSeconds();
+    appProfStamp_t algoStart;
 
     //retry once/day to get a time from the AM if we are without a valid time
     if ( xValidTimestamp == false &&
@@ -273,7 +282,9 @@ void APP_periodic(void)
         xRunAlgoDiagnostics(xlastAlgorithmRun, xCurrentRuntimeTickVal);
         xlastAlgorithmRun = xCurrentRuntimeTickVal;
 
+        algoStart = APP_PROF_Begin();
         APP_ALGO_Nest(activeSampling);
+        APP_PROF_End(PROF_ALGO_NEST, algoStart);
 
         if (xCurrentState != ACTIVATED)
         {
@@ -424,10 +435,10 @@ void APP_periodic(void)
         HW_TERM_Print("1 day time adjust");
 
         //make an adjustment to the next transmission rate based on drift for this day
-        xLastWakeupTime -= (int)(SEC_PER_DAY - (HW_RTC_GetEpochTime() - xLastRtcEpoch));
+        xLastWakeupTime -= (int)(SEC_PER_DAY - (HW_CLK_GetEpochTime() - xLastRtcEpoch));
 
         //set last updated epoch time:
-        xLastRtcEpoch = HW_RTC_GetEpochTime();
+        xLastRtcEpoch = HW_CLK_GetEpochTime();
 
         //reset any algo diagnostic errors for the day
         sensorData.errorBits &= (~AVG_SAMPLE_PERIOD_DRIFT);
@@ -518,6 +529,7 @@ void APP_indicateInvalidSpiMsg(void)
 {
     //We reset the AM after bad communication
     HW_TERM_Print("Invalid SPI message. \n");
+    HW_TRACE_0(TRACE_SPI_INVALID);
 }
 
 void APP_handleAttnSourceRequest(void)
@@ -561,12 +573,8 @@ void APP_indicateActivation(void)
 
 void APP_indicateMagnetometerThresholdInterrupt(void)
 {
-    //turn on sampling and update algorithm to run stroke detection
-    APP_ALGO_setStrokeDetectionIsOn(true);
-    HW_MAG_InitSampleRateAndPowerModeOn();
-
-    //TODO Will actually probably call a 'compute dry strokes' function or something
-    //like that instead based on convo this morning. Stubbing out here for now.
+    //handle moved while the magnetometer was idle, go back to full rate sampling
+    APP_MAG_Wake();
 }
 
 void APP_indicateError(uint32_t errorBit)
@@ -630,7 +638,7 @@ void APP_handleActivateCmd(void)
         APP_NVM_Custom_WriteHighLevelState(xCurrentState);
 
         //get time and update the activated date
-        xCurrentTimeStamp = HW_RTC_GetEpochTime();
+        xCurrentTimeStamp = HW_CLK_GetEpochTime();
         APP_NVM_Custom_WriteActivatedDate(xCurrentTimeStamp);
 
         //init hourly data updating if we have a time
@@ -669,7 +677,7 @@ void APP_handleDeactivateCmd(void)
         //Write state to eeprom
         APP_NVM_Custom_WriteHighLevelState(xCurrentState);
 
-        xCurrentTimeStamp = HW_RTC_GetEpochTime();
+        xCurrentTimeStamp = HW_CLK_GetEpochTime();
         APP_NVM_Custom_WriteDeactivatedDate(xCurrentTimeStamp);
 
         //wipe activated date
@@ -716,6 +724,7 @@ void APP_setPumpActive(bool active)
     if ( activeSampling == true )
     {
         APP_ALGO_wakeUpInit();
+        APP_MAG_Wake();
     }
 }
 
@@ -815,6 +824,7 @@ static void xUpdateSensorData(void)
 
     sprintf((char *)printStr, "\n\rHour %d \n\r", logBufferIdx);
     HW_TERM_Print(printStr);
+    HW_TRACE_1(TRACE_HOUR, logBufferIdx);
 
     //first hour of the day we will update the timestamp:
     if ( xFirstHourOfSensorData == true )
@@ -896,6 +906,8 @@ static void xWakeAm(void)
     xTimerForVoltageReadingOn = true;
     xTimerForVoltReadingStartTime = currentTime;
 
+    HW_TRACE_1(TRACE_AM_WAKE, xCurrentAttnList.attnSourceList);
+
     //Assert the wake/attention source line
     HW_GPIO_Set_WAKE_AP();
 }
@@ -925,6 +937,7 @@ static void xPollBootPinAndEnterBslIfRequested(void)
         APP_NVM_Custom_WriteResetState(STATE_SWR);
 
         HW_TERM_Print("Ready for OTA - Jumping to BSL \n");
+        uC_UART_Flush();
 
         //Update program counter to put us in BL mode
         __disable_interrupt();
@@ -952,8 +965,8 @@ static void xInitCurrentRtcHrIdxAndResetAlgoData(bool resetAlgoHourlyData)
             HW_RTC_ReportTime();
 
             //get seconds till the next hour and the current hour
-            HW_RTC_GetSecToNextHour(&secToNextHr);
-            HW_RTC_GetHour(&rtcHr);
+            HW_CLK_GetSecToNextHour(&secToNextHr);
+            HW_CLK_GetHour(&rtcHr);
 
             //if there are less than 5 minutes until the next hour,
             //wait one hour extra hr for the next hourly time adjustment to
@@ -992,7 +1005,7 @@ static void xInitCurrentRtcHrIdxAndResetAlgoData(bool resetAlgoHourlyData)
         //Adjust the "day" period - mostly for the deactivated case but lets
         //do it while activated in case we need this in the future
         xLastDailyTimeAdjust = currentRuntimeS;
-        xLastRtcEpoch = HW_RTC_GetEpochTime();
+        xLastRtcEpoch = HW_CLK_GetEpochTime();
     }
 }
 
@@ -1006,7 +1019,7 @@ static void xCheckRtcAlignmentAndSensorDataLogging(void)
     //if its been ~ 1 hour since the last time we checked
     if (  secsSinceLastAdjustment >= (int32_t)SEC_PER_HOUR )
     {
-        uint32_t secsSinceMidnight = HW_RTC_GetSecondsSinceMidnight();
+        uint32_t secsSinceMidnight = HW_CLK_GetSecondsSinceMidnight();
 
         //get the last hour
         //TODO some refactoring in this function and xUpdateSensorData()
@@ -1106,6 +1119,7 @@ static void xRunAlgoDiagnostics(uint64_t timeLastRan, uint64_t currentTime)
     if ( currentTime - timeLastRan > UC_TIME_TICKS_PER_50MS )
     {
         algLastRanGreaterThan50MsCounts++;
+        HW_TRACE_2(TRACE_ALGO_LATE, (currentTime - timeLastRan), algLastRanGreaterThan50MsCounts);
 
         //2. Dropped a sample:
         if ( currentTime - timeLastRan > UC_TIME_TICKS_PER_100MS )
@@ -1196,7 +1210,7 @@ static void xRunAlgoDiagnostics(uint64_t timeLastRan, uint64_t currentTime)
 static void xAddTimestampToDataLog(void)
 {
     xFirstHourOfSensorData = false;
-    sensorData.timestamp = HW_RTC_GetEpochTime();
+    sensorData.timestamp = HW_CLK_GetEpochTime();
 }
 
 static void xResetSensorData(void)
@@ -23,6 +23,7 @@
 ***************************************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 #include "HW_MAG.h"
 #include "APP_WTR.h"
 #include "APP_ALGO.h"
@@ -31,18 +32,26 @@
 #include "APP_NVM_Cfg.h"
 #include "am-ssm-spi-protocol.h"
 #include "APP_NVM_Custom.h"
+#include "APP_STATS.h"
+#include "APP_MAG.h"
+#include "CAPT_App.h"
+#include "HW_TRACE.h"
+#include "APP_CAPTURE.h"
+#include "uC_TIME.h"
+#include "APP_PROF.h"
+#include "APP_CKPT.h"
+#include "APP_PADF.h"
+#include "APP_STRK.h"
+#include "HW_CLK.h"
 
 /* Algorithm Includes */
 #include "algo-c-code/calculateWaterVolume/calculateWaterVolume.h"
 #include "algo-c-code/clearMagWindowProcess/clearMagWindowProcess.h"
 #include "algo-c-code/clearPadWindowProcess/clearPadWindowProcess.h"
 #include "algo-c-code/cliResetStrokeCount/cliResetStrokeCount.h"
-#include "algo-c-code/detectStrokes/detectStrokes.h"
-#include "algo-c-code/detectTransitions/detectTransitions.h"
 #include "algo-c-code/hourlyStrokeCount/hourlyStrokeCount.h"
 #include "algo-c-code/hourlyWaterVolume/hourlyWaterVolume.h"
 #include "algo-c-code/initializeMagCalibration/initializeMagCalibration.h"
-#include "algo-c-code/initializeStrokeAlgorithm/initializeStrokeAlgorithm.h"
 #include "algo-c-code/initializeWaterAlgorithm/initializeWaterAlgorithm.h"
 #include "algo-c-code/initializeWindows/initializeWindows.h"
 #include "algo-c-code/magnetometerCalibration/magnetometerCalibration.h"
@@ -56,10 +65,15 @@
 #define DEBUG_STRLEN                50
 #define STATIC_SAMPLE_COUNT_MAX     200
 #define WEEKS_FOR_RED_FLAG_CALC     4
-#define DAYS_PER_WEEK               7
-#define DAYS_FOR_RED_FLAG_CALC      WEEKS_FOR_RED_FLAG_CALC * DAYS_PER_WEEK
-#define PERCENTAGE_DIVISOR          100
+#define DAYS_FOR_RED_FLAG_CALC      WEEKS_FOR_RED_FLAG_CALC * APP_STATS_DAYS_PER_WEEK
 #define MAX_RETURNED_REASON_CODES   8
+#define CHECKPOINT_INTERVAL_RUNS    1200u       // a minute of 50 ms nest runs
+#define MAG_STATUS_NEW_DATA         15u         // x, y and z all new, anything else is a repeat to writeMagSample
+
+// Reason codes that mean the water or magnetometer calibration moved, checkpointed right away
+#define CALIBRATION_ERROR_BITS      (ORIENTATION_CALIB | OFFSET_CALIB | MAGNET_PRESENT | CALIB_PRESENT_RESET | \
+                                     WATER_CALIB | WATER_CALIB_RESET | CALIB_MAJOR_CHANGE_RESET | CALIB_ORIENT_RESET | \
+                                     CALIB_NEW_OFFSET_VAL_1)
 
 typedef enum {
     WATERPAD_PROCESSING,
@@ -71,17 +85,12 @@ static magWindows_t magWindow;
 static padSample_t currentPadSample;
 static padSample_t lastPadSample;
 static magSample_t magSample;
+static magSample_t heldMagSample;
 static waterAlgoData_t waterAlgoData;
 static waterCalibration_t waterCalibration;
 static padFilteringData_t padFilterData;
-static strokeTransitionInfo_t transitionInfo;
-static strokeTransitionBuffer_t transitionBuffer;
-static strokeBuffer_t strokeBuffer;
-static strokeDetectInfo_t strokeInfo;
 static magCalibration_t magCalibration;
 static bool runStrokeDetection = false; // set to true when activated either on power up or when we hit 50 liters
-static uint16_t redFlagOnThreshold = 0;
-static uint16_t redFlagOffThreshold = 0;
 static algoNestProcessingStates_t state;
 static hourlyStrokeInfo_t hourlyStrokeInfo;
 static accumStrokeCount_t strokeCount;
@@ -91,20 +100,9 @@ static pumpUsage_t pumpUsage;
 static hourlyPumpHealthInfo_t pumpHealth;
 static hourlyWaterInfo_t hourlyWaterInfo;
 
-//we use this array for average liter & red flag calculations. Once it is filled it will look something like this:
-/* ( use mod 7 to split the array up into weeks)
- * Sun  Mon  Tues Wed  Thur Fri  Sat
-   3276 2654 3356 3275 3176 2985 2871
-   3158 2713 3245 3182 3008 3060 2994
-   3314 2694 3158 3074 3157 2956 3012
-   3214 2718 3215 3013 3089 3021 2852
- *
- */
-static uint16_t dailyLitersOverPastMonth[DAYS_FOR_RED_FLAG_CALC] = {};
-static bool isRedFlagConditionSet = false;
-static uint8_t dailyLiterIdx = 0u;
-static bool oneMonthOfDataPresent = false;
 static uint8_t pumpHealthHr = 0;
+static uint16_t checkpointRuns = 0u;
+static bool checkpointDue = false;
 
 static void xGetLatestSamples(bool activeSampling);
 static void xWaterpadProcess(void);
@@ -114,31 +112,85 @@ static void xReportAlgoErrors(APP_NVM_SENSOR_DATA_T *sensorData);
 static void xCalcDailyLiters(APP_NVM_SENSOR_DATA_T *sensorData);
 static void xCalcAvgLitersAndCheckForBreakdown(APP_NVM_SENSOR_DATA_T *sensorData);
 static void xUpdateTotalLiters(APP_NVM_SENSOR_DATA_T *sensorData);
+static void xInitAlgorithm(void);
+static void xCheckpoint(void);
 
+// Start the algorithm over, deliberately, so a reset must not bring the old state back either
 void APP_ALGO_Init(void)
 {
-    initializeWindows( &padWindow, &magWindow );
-    initializeWaterAlgorithm( &waterAlgoData, &waterCalibration, &padFilterData, &pumpUsage );
-    initializeStrokeAlgorithm( &transitionInfo, &strokeInfo, &strokeCount );
-    initializeMagCalibration( &magCalibration );
-    state = WATERPAD_PROCESSING;
+    xInitAlgorithm();
+    APP_CKPT_Clear();
+}
+
+// Boot time start. With a good checkpoint the calibration, pump usage and pump health pick up where
+// they left off and only the session and windows start over, as after a sleep. The hourly totals are
+// kept if the checkpoint is from this same hour, so the clock has to be synced before this is called.
+void APP_ALGO_WarmStart(void)
+{
+    uint32_t epoch = HW_CLK_GetEpochTime();
+    uint32_t checkpointEpoch = 0u;
+
+    xInitAlgorithm();
+
+    if ( APP_CKPT_Load( &waterAlgoData, &waterCalibration, &magCalibration, &pumpUsage, &strokeCount, &pumpHealth,
+                        &checkpointEpoch ) == false )
+    {
+        HW_TERM_Print("algorithm cold start");
+        return;
+    }
+
+    wakeupDataReset( &padWindow, &magWindow, &waterAlgoData, &padFilterData );
+
+    if ( (epoch == 0u) || (checkpointEpoch == 0u) || ((epoch / SEC_PER_HOUR) != (checkpointEpoch / SEC_PER_HOUR)) )
+    {
+        //counted in some other hour, or we can't tell
+        waterAlgoData.water_volume_sum = 0;
+        waterAlgoData.accum_processed_sample_cnt = 0;
+        waterAlgoData.accum_water_sample_cnt = 0;
+        cliResetStrokeCount( &strokeCount );
+    }
+
+    HW_TERM_Print("algorithm warm start");
 }
 
 void APP_ALGO_wakeUpInit(void)
 {
+    //the windows start over, finish the one the stroke detector is reading first
+    APP_STRK_Drain();
     wakeupDataReset( &padWindow, &magWindow, &waterAlgoData, &padFilterData );
 }
 
 void APP_ALGO_Nest(bool activeSampling)
 {
+    appProfStamp_t stageStart;
+
+    stageStart = APP_PROF_Begin();
     xGetLatestSamples(activeSampling);
+    APP_PROF_End(PROF_GET_SAMPLES, stageStart);
+
+    APP_CAPTURE_AddSample( (uint32_t)uC_TIME_GetRuntimeTicks(),
+                           (uint8_t)(((activeSampling == true) ? APP_CAPTURE_FLAG_ACTIVE : 0u) | ((runStrokeDetection == true) ? APP_CAPTURE_FLAG_STROKES : 0u)),
+                           &currentPadSample, &magSample );
 
-    waterPadFiltering( &currentPadSample, &padFilterData, &currentPadSample );
+    stageStart = APP_PROF_Begin();
+    APP_PADF_Smooth( &currentPadSample, &padFilterData, &currentPadSample );
+    APP_PROF_End(PROF_PAD_FILTERING, stageStart);
     writePadSample( &padWindow,  &currentPadSample );
 
-    if (runStrokeDetection)
+    //a tick without a new sample repeats the one held since the magnetometer was turned on, the window
+    //code would write 0s for a held sample at the start of a block. Nothing is written until there is one.
+    if ( runStrokeDetection )
     {
-        writeMagSample( &magWindow, &magSample );
+        if ( magSample.status == MAG_STATUS_NEW_DATA )
+        {
+            writeMagSample( &magWindow, &magSample );
+        }
+        else if ( HW_MAG_IsSampleHeld() == true )
+        {
+            heldMagSample = magSample;
+            heldMagSample.status = MAG_STATUS_NEW_DATA;
+            writeMagSample( &magWindow, &heldMagSample );
+        }
     }
 
     switch (state)
@@ -166,12 +218,26 @@ void APP_ALGO_Nest(bool activeSampling)
         default:
             break;
     }
+
+    stageStart = APP_PROF_Begin();
+    APP_STRK_Run();
+    APP_PROF_End(PROF_STROKE_RUN, stageStart);
+
+    checkpointRuns++;
+
+    if ( (checkpointDue == true) || (checkpointRuns >= CHECKPOINT_INTERVAL_RUNS) )
+    {
+        xCheckpoint();
+    }
 }
 
 void APP_ALGO_setStrokeDetectionIsOn(bool algIsOn)
 {
     runStrokeDetection = algIsOn;
 
+    //magnetometer mode is set by the caller, start the sampling scheduler over
+    APP_MAG_Reset();
+
     if ( algIsOn == true )
     {
         HW_TERM_Print("enabling stroke detection");
@@ -188,23 +254,13 @@ void APP_ALGO_setStrokeDetectionIsOn(bool algIsOn)
 
 void APP_ALGO_initRedFlagThresholds(uint16_t onThreshold, uint16_t offThreshold)
 {
-    redFlagOnThreshold = onThreshold;
-    redFlagOffThreshold = offThreshold;
+    APP_STATS_SetThresholds(onThreshold, offThreshold);
 }
 
 void APP_ALGO_resetRedFlagData(void)
 {
-    //set the data array to 0
-    memset(&dailyLitersOverPastMonth, 0, sizeof(dailyLitersOverPastMonth));
-
-    //set red flag state
-    isRedFlagConditionSet = false;
-
-    //we dont have 1 month of data
-    oneMonthOfDataPresent = false;
-
-    //next day is day 0
-    dailyLiterIdx = 0;
+    //clear the daily statistics, red flag state and day of week
+    APP_STATS_Reset();
 }
 
 bool APP_ALGO_isWaterPresent(void)
@@ -221,6 +277,7 @@ void APP_ALGO_computePumpHealth(uint8_t hour)
 {
     computePumpHealth(&hourlyWaterInfo, &hourlyStrokeInfo, &pumpHealth);
     pumpHealthHr = hour;
+    checkpointDue = true;
 }
 
 uint32_t APP_ALGO_monitorTotalLiters(void)
@@ -233,7 +290,7 @@ void APP_ALGO_updateHourlyFields(APP_NVM_SENSOR_DATA_T *sensorData, uint8_t hour
     ReasonCodes reasonCode;
 
     //compute hourly water volume
-    hourlyWaterVolume( &waterAlgoData, &pumpUsage, hoursIdx, (dailyLiterIdx % DAYS_PER_WEEK), &reasonCode, &hourlyWaterInfo);
+    hourlyWaterVolume( &waterAlgoData, &pumpUsage, hoursIdx, APP_STATS_GetDayOfWeek(), &reasonCode, &hourlyWaterInfo);
 
     //check reason code
     if ( reasonCode != reason_code_none )
@@ -247,6 +304,9 @@ void APP_ALGO_updateHourlyFields(APP_NVM_SENSOR_DATA_T *sensorData, uint8_t hour
     APP_ALGO_calculateHourlyStrokes();
     sensorData->strokesPerHour[hoursIdx] = hourlyStrokeInfo.combined_stroke_count;
     sensorData->strokeHeightPerHour[hoursIdx] = hourlyStrokeInfo.c_combined_stroke_avg_displacem;
+
+    //the hourly totals were just taken, don't count them again after a reset
+    checkpointDue = true;
 }
 
 void APP_ALGO_updateDailyFields(APP_NVM_SENSOR_DATA_T *sensorData)
@@ -271,19 +331,21 @@ uint16_t APP_ALGO_getHourlyWaterVolume(void)
     ReasonCodes reasonCode;
 
     hourlyWaterVolume( &waterAlgoData, &pumpUsage, 0, 0, &reasonCode, &hourlyWaterInfo);
+    checkpointDue = true;
 
     return (uint16_t)hourlyWaterInfo.volume;
 }
 
 void APP_ALGO_calculateHourlyStrokes(void)
 {
+    APP_STRK_Drain();
     hourlyStrokeCount( &strokeCount, &hourlyStrokeInfo );
 }
 
 uint8_t APP_ALGO_getMaxHourUsage(void)
 {
     //based on the percent of time used
-    return getMaxUsageTime(&pumpUsage, (dailyLiterIdx % DAYS_PER_WEEK));
+    return getMaxUsageTime(&pumpUsage, APP_STATS_GetDayOfWeek());
 }
 
 uint16_t APP_ALGO_getHourlyStrokeCount(void)
@@ -303,12 +365,16 @@ uint16_t APP_ALGO_getMagWindowsProcessed(void)
 
 void APP_ALGO_resetHourlyStrokeCount(void)
 {
+    APP_STRK_Drain();
     cliResetStrokeCount( &strokeCount );
+    checkpointDue = true;
 }
 
 static void xGetLatestSamples(bool activeSampling)
 {
     static uint8_t staticDataCount = 0;
+    static uint32_t lastScanCount = 0;
+    uint32_t scanCount = CAPT_appGetScanCount();
 
     // Pad Samples - Notice that pad X does NOT correspond with channel X
     // This is intentional and related to the way that the cap sense peripheral is initialized/sampling order.
@@ -323,8 +389,8 @@ static void xGetLatestSamples(bool activeSampling)
 
     if ( activeSampling == true )
     {
-        //compare this sample to the last one to check for static data
-        if ( memcmp(&currentPadSample, &lastPadSample, sizeof(currentPadSample)) == 0 )
+        //compare this sample to the last one to check for static data, no new scan since the last tick is static too
+        if ( (scanCount == lastScanCount) || (memcmp(&currentPadSample, &lastPadSample, sizeof(currentPadSample)) == 0) )
         {
             staticDataCount++;
 
@@ -332,6 +398,7 @@ static void xGetLatestSamples(bool activeSampling)
             if ( staticDataCount > STATIC_SAMPLE_COUNT_MAX )
             {
                 HW_TERM_Print("\n\rSTATIC CAP SENSE DATA\n\r");
+                HW_TRACE_0(TRACE_STATIC_PADS);
 
                 APP_indicateError(CAP_SENSE_NO_DATA);
                 staticDataCount = 0;
@@ -355,7 +422,10 @@ static void xGetLatestSamples(bool activeSampling)
         staticDataCount = 0;
     }
 
-    // Mag Samples
+    lastScanCount = scanCount;
+
+    // Mag Samples - only a new sample is read off the bus, otherwise the last one is held
+    HW_MAG_ReadSampleIfReady();
     HW_MAG_GetLatestMagAndTempData( &magSample.x_lsb, &magSample.y_lsb, &magSample.z_lsb, &magSample.temp_lsb, &magSample.status );
 }
 
@@ -363,8 +433,17 @@ static void xWaterpadProcess(void)
 {
     int8_t i = 0;
     ReasonCodes reasonCodes[MAX_RETURNED_REASON_CODES];
+    appProfStamp_t stageStart;
 
+    stageStart = APP_PROF_Begin();
     calculateWaterVolume( &waterAlgoData, &waterCalibration, &padWindow, reasonCodes );
+    APP_PROF_End(PROF_WATER_VOLUME, stageStart);
+
+    //water flowing, make sure the magnetometer is sampling at full rate
+    if ( waterAlgoData.present != 0u )
+    {
+        APP_MAG_Wake();
+    }
 
     for (i = 0; i< MAX_RETURNED_REASON_CODES; i++)
     {
@@ -384,10 +463,11 @@ static void xMagnetometerProcess(void)
     //buffer of reason codes for calibration
     ReasonCodes reasonCodes[MAX_RETURNED_REASON_CODES];
 
-    //singular reason code
-    ReasonCodes reason;
+    appProfStamp_t stageStart;
 
+    stageStart = APP_PROF_Begin();
     magnetometerCalibration( &magWindow, &magCalibration, &waterAlgoData, reasonCodes );
+    APP_PROF_End(PROF_MAG_CALIBRATION, stageStart);
 
     for (i = 0; i< MAX_RETURNED_REASON_CODES; i++)
     {
@@ -397,19 +477,14 @@ static void xMagnetometerProcess(void)
         }
     }
 
-    reason = detectTransitions( &magWindow, &magCalibration, &transitionBuffer, &transitionInfo );
+    //the samples are read over the next nest runs, see APP_STRK_Run()
+    stageStart = APP_PROF_Begin();
+    APP_STRK_AcceptWindow( &magWindow, &magCalibration, &waterAlgoData, &strokeCount );
+    APP_PROF_End(PROF_STROKE_ACCEPT, stageStart);
 
-    if ( reason != reason_code_none)
-    {
-        xHandleError(reason);
-    }
-
-    reason = detectStrokes( &transitionBuffer, &strokeBuffer, &strokeInfo, &strokeCount, &magCalibration, & waterAlgoData );
-
-    if ( reason != reason_code_none)
-    {
-        xHandleError(reason);
-    }
+    //let the sampling scheduler drop to idle if nothing is going on
+    APP_MAG_WindowProcessed( (waterAlgoData.present != 0u) || (APP_STRK_IsActive() == true),
+                             magSample.x_lsb, magSample.y_lsb, magSample.z_lsb );
 
     clearMagWindowProcess( &magWindow );
 }
@@ -490,6 +565,11 @@ static void xHandleError(ReasonCodes reason)
     }
 
     algoErrorBits |= tempErrorBits;
+
+    if ( (tempErrorBits & CALIBRATION_ERROR_BITS) != 0u )
+    {
+        checkpointDue = true;
+    }
 }
 
 
@@ -512,74 +592,21 @@ static void xCalcDailyLiters(APP_NVM_SENSOR_DATA_T *sensorData)
 
 static void xCalcAvgLitersAndCheckForBreakdown(APP_NVM_SENSOR_DATA_T *sensorData)
 {
-    uint8_t idx = 0;
-    uint32_t dailyLitersSum = 0;
-    uint32_t avgForThisdayOverPastMonth = 0u;
-
-    //if we have 4 weeks worth of data, compute average for this day, look for red flag
-    if ( oneMonthOfDataPresent == true )
-    {
-        //calculate the average for this day of the week over the past 4 weeks, start on value of 0 - 6
-        for ( idx = (dailyLiterIdx % DAYS_PER_WEEK); idx < DAYS_FOR_RED_FLAG_CALC; idx += DAYS_PER_WEEK )
-        {
-            dailyLitersSum += dailyLitersOverPastMonth[idx];
-        }
-
-        //get average
-        avgForThisdayOverPastMonth = (dailyLitersSum/WEEKS_FOR_RED_FLAG_CALC);
-
-        //update the sensor data field with the average
-        sensorData->avgLiters = avgForThisdayOverPastMonth;
-
-        //check for red flag, which is when todays liters are less than X% of the
-        //average for this day:
-        if ( sensorData->dailyLiters < ((avgForThisdayOverPastMonth * redFlagOnThreshold)/PERCENTAGE_DIVISOR) )
-        {
-            isRedFlagConditionSet = true;
-            HW_TERM_Print("red flag true");
-        }
-        else
-        {
-            //check if red flag was previously set:
-            if ( isRedFlagConditionSet == true )
-            {
-                //check if recovered, which is when todays liters are back to X% of the average for this day
-                if ( sensorData->dailyLiters >= ((avgForThisdayOverPastMonth * redFlagOffThreshold)/PERCENTAGE_DIVISOR) )
-                {
-                    //reset red flag
-                    isRedFlagConditionSet = false;
+    bool wasRedFlagSet = APP_STATS_IsRedFlagSet();
 
-                    HW_TERM_Print("red flag cleared");
+    //once the baseline has 4 weeks of data, the average for this day of the week is filled in
+    //and todays liters are checked against the on/off thresholds and the change detector
+    sensorData->breakdown = APP_STATS_UpdateDaily(sensorData->dailyLiters, &sensorData->avgLiters);
+    HW_TRACE_3(TRACE_DAILY_LITERS, sensorData->dailyLiters, sensorData->avgLiters, sensorData->breakdown);
 
-                    //add the value to the map
-                    dailyLitersOverPastMonth[dailyLiterIdx] = sensorData->dailyLiters;
-                }
-            }
-            else
-            {
-                //add the value to the map
-                dailyLitersOverPastMonth[dailyLiterIdx] = sensorData->dailyLiters;
-            }
-        }
-    }
-    else
+    //only print when the flag changes
+    if ( (sensorData->breakdown == true) && (wasRedFlagSet == false) )
     {
-        //just add the value to the map since we dont have a full 4 weeks worth of data yet
-        dailyLitersOverPastMonth[dailyLiterIdx] = sensorData->dailyLiters;
-
-        //set average to 0
-        sensorData->avgLiters = 0;
+        HW_TERM_Print("red flag true");
     }
-
-    //set sensor data breakdown flag to match the red flag state
-    sensorData->breakdown = isRedFlagConditionSet;
-
-    //increment the daily liter counter and wrap around if the end of the month
-    dailyLiterIdx++;
-    if ( dailyLiterIdx >= DAYS_FOR_RED_FLAG_CALC)
+    else if ( (sensorData->breakdown == false) && (wasRedFlagSet == true) )
     {
-        dailyLiterIdx = 0u;
-        oneMonthOfDataPresent = true;
+        HW_TERM_Print("red flag cleared");
     }
 }
 
@@ -591,14 +618,13 @@ void APP_ALGO_populateRedFlagArrayWithFakeData(void)
 {
     int i = 0;
 
-    //manipulate the data map and associated variables
+    //feed 4 weeks of fake days into the baseline, which leaves the next day as day 0
+    APP_STATS_Reset();
+
     for(i = 0; i< DAYS_FOR_RED_FLAG_CALC; i++)
     {
-       dailyLitersOverPastMonth[i] = 3000 + (i*2);
+       APP_STATS_LearnDay(3000 + (i*2));
     }
-
-    dailyLiterIdx = 0;
-    oneMonthOfDataPresent = true;
 }
 
 static void xUpdateTotalLiters(APP_NVM_SENSOR_DATA_T *sensorData)
@@ -606,3 +632,29 @@ static void xUpdateTotalLiters(APP_NVM_SENSOR_DATA_T *sensorData)
     sensorData->totalLiters = APP_NVM_Custom_GetTotalLiters() + sensorData->dailyLiters;
     APP_NVM_Custom_WriteTotalLiters(sensorData->totalLiters);
 }
+
+static void xInitAlgorithm(void)
+{
+    initializeWindows( &padWindow, &magWindow );
+    initializeWaterAlgorithm( &waterAlgoData, &waterCalibration, &padFilterData, &pumpUsage );
+    APP_STRK_Reset( &strokeCount );
+    initializeMagCalibration( &magCalibration );
+    state = WATERPAD_PROCESSING;
+    checkpointRuns = 0u;
+    checkpointDue = false;
+}
+
+static void xCheckpoint(void)
+{
+    checkpointRuns = 0u;
+    checkpointDue = false;
+
+    //save the counts with the current window in them
+    APP_STRK_Drain();
+
+    if ( APP_CKPT_Save( &waterAlgoData, &waterCalibration, &magCalibration, &pumpUsage, &strokeCount, &pumpHealth,
+                        HW_CLK_GetEpochTime() ) == false )
+    {
+        HW_TERM_Print("algorithm checkpoint failed");
+    }
+}
@@ -0,0 +1,278 @@
+/**************************************************************************************************
+* \file     APP_CAPTURE.c
+* \brief    Engineering capture of the algorithm inputs over the terminal UART
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <msp430.h>
+#include "driverlib.h"
+#include <stdio.h>
+#include <string.h>
+#include "APP_CAPTURE.h"
+#include "HW_TERM.h"
+#include "uC_UART.h"
+
+// The algorithm runs every 50 ms
+#define CAPTURE_RATE_HZ             20u
+#define KEY_FRAME_INTERVAL          CAPTURE_RATE_HZ
+
+// Status bit in the changed mask of a delta frame
+#define STATUS_CHANGED              (1u << APP_CAPTURE_NUM_CHANNELS)
+
+// Worst case a delta frame could take before it is swapped for the key frame
+#define MAX_VARINT_LEN              3u
+#define MAX_DELTA_BODY_LEN          (1u + 2u + (MAX_VARINT_LEN * APP_CAPTURE_NUM_CHANNELS) + 1u)
+
+// Every frame has to fit the line at the capture rate, 10 bits per byte on the wire, with a fifth of
+// the line left for terminal text and trace records
+#if ((APP_CAPTURE_MAX_FRAME_LEN * CAPTURE_RATE_HZ * 10u) > ((HW_TERM_BAUD_RATE * 4u) / 5u))
+#error "Capture frames do not fit the terminal baud rate"
+#endif
+
+#define DEBUG_STRLEN                80
+
+static bool xRunning = false;
+static bool xNeedKey = true;
+static uint8_t xSequence = 0u;
+static uint8_t xSinceKey = 0u;
+static uint32_t xLastTick = 0u;
+static int16_t xLastChannels[APP_CAPTURE_NUM_CHANNELS];
+static uint8_t xLastStatus = 0u;
+
+static uint32_t xFramesSent = 0u;
+static uint32_t xFramesDropped = 0u;
+static uint32_t xBytesSent = 0u;
+static uint8_t xLongestFrame = 0u;
+
+void APP_CAPTURE_Start(void);
+void APP_CAPTURE_Stop(void);
+bool APP_CAPTURE_IsRunning(void);
+void APP_CAPTURE_AddSample(uint32_t tick, uint8_t flags, const padSample_t * p_pads, const magSample_t * p_mag);
+void APP_CAPTURE_Report(void);
+
+static void xGetChannels(int16_t * p_channels, const padSample_t * p_pads, const magSample_t * p_mag);
+static uint8_t xEncodeKeyBody(uint8_t * p_body, uint32_t tick, const int16_t * p_channels, uint8_t status);
+static uint8_t xEncodeDeltaBody(uint8_t * p_body, uint32_t tick, const int16_t * p_channels, uint8_t status);
+static uint8_t xPutVarint(uint8_t * p_buf, uint16_t value);
+static uint16_t xCrc16(const uint8_t * p_data, uint8_t len);
+
+// Start a capture, the first frame is a key frame
+void APP_CAPTURE_Start(void)
+{
+    xRunning = true;
+    xNeedKey = true;
+    xSequence = 0u;
+    xFramesSent = 0u;
+    xFramesDropped = 0u;
+    xBytesSent = 0u;
+    xLongestFrame = 0u;
+}
+
+void APP_CAPTURE_Stop(void)
+{
+    xRunning = false;
+}
+
+bool APP_CAPTURE_IsRunning(void)
+{
+    return xRunning;
+}
+
+// Called by the algorithm nest with the samples it is about to process
+void APP_CAPTURE_AddSample(uint32_t tick, uint8_t flags, const padSample_t * p_pads, const magSample_t * p_mag)
+{
+    uint8_t frame[1u + 1u + 2u + MAX_DELTA_BODY_LEN + 2u];
+    int16_t channels[APP_CAPTURE_NUM_CHANNELS];
+    uint8_t bodyLen = 0u;
+    uint8_t len;
+    uint16_t crc;
+
+    if ( xRunning == false )
+    {
+        return;
+    }
+
+    xGetChannels(channels, p_pads, p_mag);
+
+    flags &= (APP_CAPTURE_FLAG_ACTIVE | APP_CAPTURE_FLAG_STROKES);
+
+    if ( (xNeedKey == false) && (xSinceKey < KEY_FRAME_INTERVAL) && ((tick - xLastTick) <= UINT8_MAX) )
+    {
+        bodyLen = xEncodeDeltaBody(&frame[4], tick, channels, p_mag->status);
+    }
+
+    // lots of big changes can make a delta frame longer than a key frame
+    if ( (bodyLen == 0u) || (bodyLen > APP_CAPTURE_KEY_BODY_LEN) )
+    {
+        bodyLen = xEncodeKeyBody(&frame[4], tick, channels, p_mag->status);
+        flags |= APP_CAPTURE_FLAG_KEY;
+    }
+
+    frame[0] = APP_CAPTURE_SYNC;
+    frame[1] = (uint8_t)(2u + bodyLen);
+    frame[2] = xSequence;
+    frame[3] = flags;
+    len = 4u + bodyLen;
+
+    crc = xCrc16(&frame[1], (uint8_t)(len - 1u));
+    frame[len++] = (uint8_t)crc;
+    frame[len++] = (uint8_t)(crc >> 8);
+
+    xSequence++;
+
+    if ( uC_UART_TxNoWait(frame, len) == true )
+    {
+        xLastTick = tick;
+        memcpy(xLastChannels, channels, sizeof(xLastChannels));
+        xLastStatus = p_mag->status;
+        xNeedKey = false;
+        xSinceKey = ((flags & APP_CAPTURE_FLAG_KEY) != 0u) ? 1u : (uint8_t)(xSinceKey + 1u);
+
+        xFramesSent++;
+        xBytesSent += len;
+        if ( len > xLongestFrame )
+        {
+            xLongestFrame = len;
+        }
+    }
+    else
+    {
+        // the host can't rebuild anything after a lost frame until it gets a key frame
+        xNeedKey = true;
+        xFramesDropped++;
+    }
+}
+
+void APP_CAPTURE_Report(void)
+{
+    uint8_t str[DEBUG_STRLEN];
+
+    sprintf((char *)str, "\n\rCapture %s, %lu frames, %lu dropped\n\r", (xRunning == true) ? "running" : "stopped", xFramesSent, xFramesDropped);
+    HW_TERM_Print(str);
+
+    sprintf((char *)str, "%lu bytes, longest frame %u, limit %u\n\r", xBytesSent, xLongestFrame, APP_CAPTURE_MAX_FRAME_LEN);
+    HW_TERM_Print(str);
+}
+
+static void xGetChannels(int16_t * p_channels, const padSample_t * p_pads, const magSample_t * p_mag)
+{
+    p_channels[0] = p_pads->pad1;
+    p_channels[1] = p_pads->pad2;
+    p_channels[2] = p_pads->pad3;
+    p_channels[3] = p_pads->pad4;
+    p_channels[4] = p_pads->pad5;
+    p_channels[5] = p_pads->pad6;
+    p_channels[6] = p_pads->pad7;
+    p_channels[7] = p_pads->pad8;
+    p_channels[8] = p_mag->x_lsb;
+    p_channels[9] = p_mag->y_lsb;
+    p_channels[10] = p_mag->z_lsb;
+    p_channels[11] = p_mag->temp_lsb;
+}
+
+// Returns the body length
+static uint8_t xEncodeKeyBody(uint8_t * p_body, uint32_t tick, const int16_t * p_channels, uint8_t status)
+{
+    uint8_t len = 0u;
+    uint8_t i;
+
+    p_body[len++] = (uint8_t)(tick);
+    p_body[len++] = (uint8_t)(tick >> 8);
+    p_body[len++] = (uint8_t)(tick >> 16);
+    p_body[len++] = (uint8_t)(tick >> 24);
+
+    for ( i = 0u; i < APP_CAPTURE_NUM_CHANNELS; i++ )
+    {
+        p_body[len++] = (uint8_t)(p_channels[i]);
+        p_body[len++] = (uint8_t)((uint16_t)p_channels[i] >> 8);
+    }
+
+    p_body[len++] = status;
+
+    return len;
+}
+
+// Returns the body length
+static uint8_t xEncodeDeltaBody(uint8_t * p_body, uint32_t tick, const int16_t * p_channels, uint8_t status)
+{
+    uint16_t mask = 0u;
+    uint16_t delta;
+    uint8_t len = 3u;
+    uint8_t i;
+
+    p_body[0] = (uint8_t)(tick - xLastTick);
+
+    for ( i = 0u; i < APP_CAPTURE_NUM_CHANNELS; i++ )
+    {
+        // the difference wraps at 16 bits, so does the host
+        delta = (uint16_t)p_channels[i] - (uint16_t)xLastChannels[i];
+
+        if ( delta != 0u )
+        {
+            mask |= (1u << i);
+
+            // zigzag, small differences of either sign become small numbers
+            len += xPutVarint(&p_body[len], (uint16_t)((delta << 1) ^ (((delta & 0x8000u) != 0u) ? 0xFFFFu : 0u)));
+        }
+    }
+
+    if ( status != xLastStatus )
+    {
+        mask |= STATUS_CHANGED;
+        p_body[len++] = status;
+    }
+
+    p_body[1] = (uint8_t)(mask);
+    p_body[2] = (uint8_t)(mask >> 8);
+
+    return len;
+}
+
+static uint8_t xPutVarint(uint8_t * p_buf, uint16_t value)
+{
+    uint8_t len = 0u;
+
+    while ( value >= 0x80u )
+    {
+        p_buf[len++] = (uint8_t)(value | 0x80u);
+        value >>= 7;
+    }
+
+    p_buf[len++] = (uint8_t)value;
+
+    return len;
+}
+
+// The CRC16 module computes CRC-CCITT, bytes written through the bit reversed data register come out
+// in the usual (MSB first) bit order
+static uint16_t xCrc16(const uint8_t * p_data, uint8_t len)
+{
+    uint8_t i;
+
+    CRC_setSeed(CRC_BASE, 0xFFFFu);
+
+    for ( i = 0u; i < len; i++ )
+    {
+        CRC_set8BitDataReversed(CRC_BASE, p_data[i]);
+    }
+
+    return CRC_getResult(CRC_BASE);
+}
@@ -0,0 +1,265 @@
+/**************************************************************************************************
+* \file     APP_CKPT.c
+* \brief    Checkpoint of the converged algorithm state in FRAM, for a warm start after a reset
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <msp430.h>
+#include "driverlib.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "APP_CKPT.h"
+#include "HW_TERM.h"
+
+#define CKPT_MAGIC                  0xC4A7u
+#define CKPT_NUM_SLOTS              2u
+#define CKPT_NO_SLOT                0xFEu       // no good record
+#define CKPT_NOT_SCANNED            0xFFu       // not looked for since boot
+
+#define DEBUG_STRLEN                80
+
+typedef struct
+{
+    waterAlgoData_t algoData;
+    waterCalibration_t waterCalibration;
+    magCalibration_t magCalibration;
+    pumpUsage_t pumpUsage;
+    accumStrokeCount_t strokeCount;
+    hourlyPumpHealthInfo_t pumpHealth;
+}appCkptState_t;
+
+typedef struct
+{
+    uint16_t magic;         // written last, cleared first, so a torn save is never picked up
+    uint16_t version;
+    uint16_t length;        // sizeof(appCkptState_t) of the build that saved it
+    uint16_t sequence;      // one more than the record it replaced, wraps
+    uint32_t epoch;         // clock time of the save, 0 if the clock was not set
+    appCkptState_t state;
+    uint16_t crc;           // CRC16 from version up to here, padding included
+}appCkptRecord_t;
+
+#define CKPT_CRC_LEN                (offsetof(appCkptRecord_t, crc) - offsetof(appCkptRecord_t, version))
+
+// Main FRAM, kept through a reset and a reflash of the same image
+#pragma PERSISTENT(xRecords)
+static appCkptRecord_t xRecords[CKPT_NUM_SLOTS] = {0};
+
+static uint8_t xNewest = CKPT_NOT_SCANNED;
+static uint16_t xSaves = 0u;
+
+bool APP_CKPT_Save(const waterAlgoData_t * p_algoData, const waterCalibration_t * p_waterCalibration,
+                   const magCalibration_t * p_magCalibration, const pumpUsage_t * p_pumpUsage,
+                   const accumStrokeCount_t * p_strokeCount, const hourlyPumpHealthInfo_t * p_pumpHealth,
+                   uint32_t epoch);
+bool APP_CKPT_Load(waterAlgoData_t * p_algoData, waterCalibration_t * p_waterCalibration,
+                   magCalibration_t * p_magCalibration, pumpUsage_t * p_pumpUsage,
+                   accumStrokeCount_t * p_strokeCount, hourlyPumpHealthInfo_t * p_pumpHealth,
+                   uint32_t * p_epoch);
+void APP_CKPT_Clear(void);
+void APP_CKPT_Report(void);
+
+static uint8_t xFindNewest(void);
+static bool xIsValid(uint8_t slot);
+static uint16_t xCrc16(const uint8_t * p_data, uint16_t len);
+
+// Writes over the older record. Returns false if the record did not read back good.
+bool APP_CKPT_Save(const waterAlgoData_t * p_algoData, const waterCalibration_t * p_waterCalibration,
+                   const magCalibration_t * p_magCalibration, const pumpUsage_t * p_pumpUsage,
+                   const accumStrokeCount_t * p_strokeCount, const hourlyPumpHealthInfo_t * p_pumpHealth,
+                   uint32_t epoch)
+{
+    appCkptRecord_t * p_record;
+    uint16_t sequence = 0u;
+    uint8_t newest = xFindNewest();
+    uint8_t slot = 0u;
+
+    if ( newest != CKPT_NO_SLOT )
+    {
+        sequence = (uint16_t)(xRecords[newest].sequence + 1u);
+        slot = (uint8_t)(newest ^ 1u);
+    }
+
+    p_record = &xRecords[slot];
+
+    SysCtl_enableFRAMWrite(SYSCTL_FRAMWRITEPROTECTION_PROGRAM);
+
+    p_record->magic = 0u;
+    p_record->version = APP_CKPT_VERSION;
+    p_record->length = sizeof(appCkptState_t);
+    p_record->sequence = sequence;
+    p_record->epoch = epoch;
+    memcpy(&p_record->state.algoData, p_algoData, sizeof(waterAlgoData_t));
+    memcpy(&p_record->state.waterCalibration, p_waterCalibration, sizeof(waterCalibration_t));
+    memcpy(&p_record->state.magCalibration, p_magCalibration, sizeof(magCalibration_t));
+    memcpy(&p_record->state.pumpUsage, p_pumpUsage, sizeof(pumpUsage_t));
+    memcpy(&p_record->state.strokeCount, p_strokeCount, sizeof(accumStrokeCount_t));
+    memcpy(&p_record->state.pumpHealth, p_pumpHealth, sizeof(hourlyPumpHealthInfo_t));
+
+    p_record->crc = xCrc16((const uint8_t *)&p_record->version, CKPT_CRC_LEN);
+    p_record->magic = CKPT_MAGIC;
+
+    SysCtl_protectFRAMWrite(SYSCTL_FRAMWRITEPROTECTION_PROGRAM);
+
+    xSaves++;
+
+    if ( xIsValid(slot) == false )
+    {
+        // the other record, if there is one, is still the newest
+        return false;
+    }
+
+    xNewest = slot;
+
+    return true;
+}
+
+// Copies the newest good record out. Returns false, and leaves the state alone, if there is none.
+bool APP_CKPT_Load(waterAlgoData_t * p_algoData, waterCalibration_t * p_waterCalibration,
+                   magCalibration_t * p_magCalibration, pumpUsage_t * p_pumpUsage,
+                   accumStrokeCount_t * p_strokeCount, hourlyPumpHealthInfo_t * p_pumpHealth,
+                   uint32_t * p_epoch)
+{
+    const appCkptRecord_t * p_record;
+    uint8_t newest = xFindNewest();
+
+    if ( newest == CKPT_NO_SLOT )
+    {
+        return false;
+    }
+
+    p_record = &xRecords[newest];
+
+    memcpy(p_algoData, &p_record->state.algoData, sizeof(waterAlgoData_t));
+    memcpy(p_waterCalibration, &p_record->state.waterCalibration, sizeof(waterCalibration_t));
+    memcpy(p_magCalibration, &p_record->state.magCalibration, sizeof(magCalibration_t));
+    memcpy(p_pumpUsage, &p_record->state.pumpUsage, sizeof(pumpUsage_t));
+    memcpy(p_strokeCount, &p_record->state.strokeCount, sizeof(accumStrokeCount_t));
+    memcpy(p_pumpHealth, &p_record->state.pumpHealth, sizeof(hourlyPumpHealthInfo_t));
+    *p_epoch = p_record->epoch;
+
+    return true;
+}
+
+// Forget both records, the next boot starts the algorithm cold
+void APP_CKPT_Clear(void)
+{
+    uint8_t i;
+
+    SysCtl_enableFRAMWrite(SYSCTL_FRAMWRITEPROTECTION_PROGRAM);
+
+    for ( i = 0u; i < CKPT_NUM_SLOTS; i++ )
+    {
+        xRecords[i].magic = 0u;
+    }
+
+    SysCtl_protectFRAMWrite(SYSCTL_FRAMWRITEPROTECTION_PROGRAM);
+
+    xNewest = CKPT_NO_SLOT;
+}
+
+void APP_CKPT_Report(void)
+{
+    uint8_t str[DEBUG_STRLEN];
+    uint8_t newest = xFindNewest();
+    uint8_t i;
+
+    sprintf((char *)str, "\n\rcheckpoint v%u, %u bytes, %u saves since boot\n\r", APP_CKPT_VERSION, (uint16_t)sizeof(appCkptRecord_t), xSaves);
+    HW_TERM_Print(str);
+
+    for ( i = 0u; i < CKPT_NUM_SLOTS; i++ )
+    {
+        if ( xIsValid(i) == true )
+        {
+            sprintf((char *)str, "slot %u: sequence %u, epoch %lu%s\n\r", i, xRecords[i].sequence, xRecords[i].epoch,
+                    (i == newest) ? ", newest" : "");
+        }
+        else
+        {
+            sprintf((char *)str, "slot %u: empty\n\r", i);
+        }
+
+        HW_TERM_Print(str);
+    }
+}
+
+static uint8_t xFindNewest(void)
+{
+    bool valid0;
+    bool valid1;
+
+    if ( xNewest != CKPT_NOT_SCANNED )
+    {
+        return xNewest;
+    }
+
+    valid0 = xIsValid(0u);
+    valid1 = xIsValid(1u);
+
+    if ( (valid0 == true) && (valid1 == true) )
+    {
+        xNewest = ((int16_t)(xRecords[1].sequence - xRecords[0].sequence) > 0) ? 1u : 0u;
+    }
+    else if ( valid0 == true )
+    {
+        xNewest = 0u;
+    }
+    else if ( valid1 == true )
+    {
+        xNewest = 1u;
+    }
+    else
+    {
+        xNewest = CKPT_NO_SLOT;
+    }
+
+    return xNewest;
+}
+
+static bool xIsValid(uint8_t slot)
+{
+    const appCkptRecord_t * p_record = &xRecords[slot];
+
+    if ( (p_record->magic != CKPT_MAGIC) || (p_record->version != APP_CKPT_VERSION) ||
+         (p_record->length != sizeof(appCkptState_t)) )
+    {
+        return false;
+    }
+
+    return (xCrc16((const uint8_t *)&p_record->version, CKPT_CRC_LEN) == p_record->crc);
+}
+
+// The CRC16 module computes CRC-CCITT, bytes written through the bit reversed data register come out
+// in the usual (MSB first) bit order
+static uint16_t xCrc16(const uint8_t * p_data, uint16_t len)
+{
+    uint16_t i;
+
+    CRC_setSeed(CRC_BASE, 0xFFFFu);
+
+    for ( i = 0u; i < len; i++ )
+    {
+        CRC_set8BitDataReversed(CRC_BASE, p_data[i]);
+    }
+
+    return CRC_getResult(CRC_BASE);
+}
@@ -30,6 +30,7 @@
 #include "HW_TERM.h"
 #include "HW_ENV.h"
 #include "HW_RTC.h"
+#include "HW_CLK.h"
 #include "HW_EEP.h"
 #include <stdio.h>
 #include <version-git-info.h>
@@ -42,6 +43,11 @@
 #include "uC_UART.h"
 #include "uC_TIME.h"
 #include "APP_ALGO.h"
+#include "APP_MAG.h"
+#include "HW_TRACE.h"
+#include "APP_CAPTURE.h"
+#include "APP_PROF.h"
+#include "APP_CKPT.h"
 
 #ifdef ENGINEERING_DATA
 const APP_NVM_SENSOR_DATA_T Test_Sensor_Data =
@@ -87,6 +93,9 @@ static void HandleReadDiscrete(int argc, char **argv);
 static void HandleWriteDiscrete(int argc, char **argv);
 static void HandleRuntime(int argc, char **argv);
 static void HandleTerm(int argc, char **argv);
+static void HandleTrace(int argc, char **argv);
+static void HandleCapture(int argc, char **argv);
+static void HandleProfile(int argc, char **argv);
 static void HandleSensorData(int argc, char **argv);
 static void HandleReset(int argc, char **argv);
 static void HandleAm(int argc, char **argv);
@@ -147,6 +156,21 @@ void APP_CLI_Init(void)
     handler.pszUsageString = "{\"enable\"|\"disable\"} - Turn printing on or off.";
     gvCLD_Register_This_Command_Handler(&handler);
 
+    handler.pfnPtrFunction = &HandleTrace;
+    handler.pszCmdString   = "trace";
+    handler.pszUsageString = "{\"on\"|\"off\"|\"stats\"} - Binary trace records, decode with ssm_trace_decode.py.";
+    gvCLD_Register_This_Command_Handler(&handler);
+
+    handler.pfnPtrFunction = &HandleCapture;
+    handler.pszCmdString   = "capture";
+    handler.pszUsageString = "{\"on\"|\"off\"|\"stats\"} - Stream the algorithm inputs, record with ssm_capture.py.";
+    gvCLD_Register_This_Command_Handler(&handler);
+
+    handler.pfnPtrFunction = &HandleProfile;
+    handler.pszCmdString   = "prof";
+    handler.pszUsageString = "{\"reset\"} - Execution times (us) of the main loop and algorithm stages, or clear them.";
+    gvCLD_Register_This_Command_Handler(&handler);
+
     handler.pfnPtrFunction = &HandleRuntime;
     handler.pszCmdString   = "runt";
     handler.pszUsageString = "Run time. {\"set\" <seconds> } - Display or set run time.";
@@ -177,6 +201,8 @@ void APP_CLI_Init(void)
     handler.pszUsageString = " \"watervolume\" - get water volume | \n \
        \t\"strokecount\" - get stroke count | \n \
        \t\"strokereset\" - reset stroke count | \n \
+       \t\"ckpt\" - warm start checkpoint | \n \
+       \t\"ckptclear\" - cold start after the next reset | \n \
        \t\"rawdata\" - raw pad values";
     gvCLD_Register_This_Command_Handler(&handler);
 
@@ -189,7 +215,8 @@ void APP_CLI_Init(void)
     handler.pfnPtrFunction = &HandleMag;
     handler.pszCmdString   = "mag";
     handler.pszUsageString =  " \"sample\" - get latest magnetometer sample | \n \
-     \t\"on\" - enable sampling";
+     \t\"on\" - enable sampling | \n \
+     \t\"sched\" - sampling scheduler state";
     gvCLD_Register_This_Command_Handler(&handler);
 
     PrintPrompt();
@@ -424,6 +451,11 @@ static void HandleMag(int argc, char **argv)
         HW_MAG_InitSampleRateAndPowerModeOn();
         HW_TERM_Print("Magnetometer is on");
     }
+    else if ((argc == ONE_ARGUMENT) && (strcmp(argv[FIRST_ARG_IDX], "sched") == 0))
+    {
+        //sampling scheduler state and number of samples read off the bus
+        APP_MAG_Report();
+    }
     else
     {
         HW_TERM_Print("Invalid parameter format.");
@@ -534,6 +566,7 @@ static void HandleRTC(int argc, char **argv)
         if ((argc == ONE_ARGUMENT) && (strcmp(argv[FIRST_ARG_IDX], "rt") == 0))
         {
             HW_RTC_ReportTime();
+            HW_CLK_Report();
         }
         // set time
         else if ((argc == NINE_ARGUMENTS) && (strcmp(argv[FIRST_ARG_IDX], "st") == 0))
@@ -549,6 +582,7 @@ static void HandleRTC(int argc, char **argv)
                                 == true)
             {
                 HW_TERM_Print("Time set: \n");
+                HW_CLK_Sync();
                 HW_RTC_ReportTime();
             }
             else
@@ -670,6 +704,70 @@ static void HandleTerm(int argc, char **argv)
     }
 }
 
+static void HandleTrace(int argc, char **argv)
+{
+    uint8_t str[40];
+
+    if ((argc == ONE_ARGUMENT) && (strcmp(argv[FIRST_ARG_IDX], "on") == 0))
+    {
+        HW_TRACE_Enable(true);
+        HW_TERM_Print("\r\nTrace on\r\n");
+    }
+    else if ((argc == ONE_ARGUMENT) && (strcmp(argv[FIRST_ARG_IDX], "off") == 0))
+    {
+        HW_TRACE_Enable(false);
+        HW_TERM_Print("\r\nTrace off\r\n");
+    }
+    else if ((argc == ONE_ARGUMENT) && (strcmp(argv[FIRST_ARG_IDX], "stats") == 0))
+    {
+        sprintf((char *)str, "Trace %s, %u records dropped\n", (HW_TRACE_IsEnabled() == true) ? "on" : "off", HW_TRACE_GetDroppedCount());
+        HW_TERM_Print(str);
+    }
+    else
+    {
+        HW_TERM_Print("Invalid parameter format.");
+    }
+}
+
+static void HandleCapture(int argc, char **argv)
+{
+    if ((argc == ONE_ARGUMENT) && (strcmp(argv[FIRST_ARG_IDX], "on") == 0))
+    {
+        HW_TERM_Print("\r\nCapture on\r\n");
+        APP_CAPTURE_Start();
+    }
+    else if ((argc == ONE_ARGUMENT) && (strcmp(argv[FIRST_ARG_IDX], "off") == 0))
+    {
+        APP_CAPTURE_Stop();
+        HW_TERM_Print("\r\nCapture off\r\n");
+    }
+    else if ((argc == ONE_ARGUMENT) && (strcmp(argv[FIRST_ARG_IDX], "stats") == 0))
+    {
+        APP_CAPTURE_Report();
+    }
+    else
+    {
+        HW_TERM_Print("Invalid parameter format.");
+    }
+}
+
+static void HandleProfile(int argc, char **argv)
+{
+    if (argc == ZERO_ARGUMENTS)
+    {
+        APP_PROF_Report();
+    }
+    else if ((argc == ONE_ARGUMENT) && (strcmp(argv[FIRST_ARG_IDX], "reset") == 0))
+    {
+        APP_PROF_Reset();
+        HW_TERM_Print("\r\nProfile cleared\r\n");
+    }
+    else
+    {
+        HW_TERM_Print("Invalid parameter format.");
+    }
+}
+
 static void HandleRuntime(int argc, char **argv)
 {
     uint8_t str[40];
@@ -736,6 +834,15 @@ static void HandleAlgorithm(int argc, char **argv)
         APP_ALGO_resetHourlyStrokeCount();
         HW_TERM_Print("Stroke Count Reset\n");
     }
+    else if ((argc == ONE_ARGUMENT) && (0 == strcmp(argv[FIRST_ARG_IDX], "ckpt")))
+    {
+        APP_CKPT_Report();
+    }
+    else if ((argc == ONE_ARGUMENT) && (0 == strcmp(argv[FIRST_ARG_IDX], "ckptclear")))
+    {
+        APP_CKPT_Clear();
+        HW_TERM_Print("Checkpoint cleared\n");
+    }
     else if ((argc == ONE_ARGUMENT) && (0 == strcmp(argv[FIRST_ARG_IDX], "rawdata")))
     {
         HW_TERM_ReportPadValues();
@@ -0,0 +1,116 @@
+/**************************************************************************************************
+* \file     APP_MAG.c
+* \brief    Magnetometer sampling scheduler (active / idle)
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdio.h>
+#include "HW_MAG.h"
+#include "HW_TERM.h"
+#include "APP_MAG.h"
+#include "HW_TRACE.h"
+
+// When no stroke activity and no water has been seen for this many magnetometer windows the
+// magnetometer is dropped to its 10 Hz low power threshold mode and I2C reads stop. Each window
+// is 70 new samples (3.5 s at 20 Hz) so this is roughly one minute.
+#define IDLE_WINDOW_COUNT           17
+#define DEBUG_STRLEN                60
+
+static app_mag_state_t xState = APP_MAG_ACTIVE;
+static uint8_t xQuietWindowCount = 0u;
+static uint16_t xIdleEntryCount = 0u;
+
+void APP_MAG_Reset(void);
+void APP_MAG_WindowProcessed(bool activityDetected, int16_t xLsb, int16_t yLsb, int16_t zLsb);
+void APP_MAG_Wake(void);
+app_mag_state_t APP_MAG_GetState(void);
+void APP_MAG_Report(void);
+
+// Stroke detection was turned on or off, the caller owns the magnetometer mode at this point
+void APP_MAG_Reset(void)
+{
+    xState = APP_MAG_ACTIVE;
+    xQuietWindowCount = 0u;
+}
+
+// Called after every magnetometer window with whether the algorithm saw anything worth watching.
+// The last sample is used as the hard iron offset so the threshold interrupt fires on movement
+// away from where the handle is resting now.
+void APP_MAG_WindowProcessed(bool activityDetected, int16_t xLsb, int16_t yLsb, int16_t zLsb)
+{
+    if ( xState == APP_MAG_ACTIVE )
+    {
+        if ( activityDetected == true )
+        {
+            xQuietWindowCount = 0u;
+        }
+        else
+        {
+            xQuietWindowCount++;
+
+            if ( xQuietWindowCount >= IDLE_WINDOW_COUNT )
+            {
+                HW_MAG_EnableThresholdInterrupt(xLsb, yLsb, zLsb);
+
+                xState = APP_MAG_IDLE;
+                xQuietWindowCount = 0u;
+
+                if ( xIdleEntryCount < UINT16_MAX )
+                {
+                    xIdleEntryCount++;
+                }
+
+                HW_TERM_Print("mag idle\n");
+                HW_TRACE_1(TRACE_MAG_IDLE, xIdleEntryCount);
+            }
+        }
+    }
+}
+
+// Threshold interrupt, pump handle proximity or water detected - go back to full rate sampling.
+// While idle the last good sample is held so the window timing is unchanged.
+void APP_MAG_Wake(void)
+{
+    xQuietWindowCount = 0u;
+
+    if ( xState == APP_MAG_IDLE )
+    {
+        xState = APP_MAG_ACTIVE;
+        HW_MAG_InitSampleRateAndPowerModeOn();
+
+        HW_TERM_Print("mag active\n");
+        HW_TRACE_0(TRACE_MAG_ACTIVE);
+    }
+}
+
+app_mag_state_t APP_MAG_GetState(void)
+{
+    return xState;
+}
+
+void APP_MAG_Report(void)
+{
+    uint8_t str[DEBUG_STRLEN];
+
+    sprintf((char *)str, "mag %s, idle entries: %u, reads: %lu\n", (xState == APP_MAG_IDLE) ? "idle" : "active",
+            xIdleEntryCount, HW_MAG_GetSampleReadCount());
+    HW_TERM_Print(str);
+}
@@ -44,7 +44,7 @@ void APP_NVM_ReadCurrentEntry(uint8_t map_index, uint8_t * p_data_buffer);
 void APP_NVM_DefaultAll(void);
 void APP_NVM_DefaultSensorDataLogs(void);
 void APP_NVM_ReadSectionHeader(uint8_t map_index, APP_NVM_SECTION_HDR_T * p_hdr);
-void APP_NVM_ReadBytes(uint16_t addr, uint16_t num_bytes, uint8_t * p_bytes);
+bool APP_NVM_ReadBytes(uint16_t addr, uint16_t num_bytes, uint8_t * p_bytes);
 uint8_t APP_NVM_ComputeChecksum(uint8_t * p_data, uint16_t num_bytes);
 void APP_NVM_DefaultSection(uint8_t map_index);
 
@@ -192,17 +192,12 @@ static void WriteBytes(uint16_t addr, uint16_t num_bytes, uint8_t * p_bytes)
     }
 }
 
-void APP_NVM_ReadBytes(uint16_t addr, uint16_t num_bytes, uint8_t * p_bytes)
+// Returns false if the EEP could not be read
+bool APP_NVM_ReadBytes(uint16_t addr, uint16_t num_bytes, uint8_t * p_bytes)
 {
-    uint8_t i = 0;
-
-    if (p_bytes == NULL) return;
+    if (p_bytes == NULL) return false;
 
-    for (i = 0; i < num_bytes; i++)
-    {
-        *(uint8_t *)p_bytes = HW_EEP_ReadByte((addr + i));
-        p_bytes = (uint8_t *)p_bytes + 1;
-    }
+    return HW_EEP_ReadBlock(addr, p_bytes, num_bytes);
 }
 
 // Based upon the configuration specified in the section map, default the section header and default values.
@@ -219,6 +214,12 @@ void APP_NVM_DefaultSection(uint8_t map_index)
 
     if (map_index > (APP_NVM_NUM_SECTIONS - 1)) return;
 
+    if (map_index == APP_NVM_SECT_TYPE_SENSOR_DATA)
+    {
+        // Entries staged for the AM are gone
+        APP_NVM_Custom_StopSensorDataPrefetch();
+    }
+
     // For each entry specified by the number of entries in the section map, fill in the default values and checksum.
     for (entry_index = 0; entry_index < Section_Map[map_index].default_num_entries; entry_index++)
     {
@@ -22,6 +22,7 @@
 *
 ***************************************************************************************************/
 
+#include <string.h>
 #include "APP_NVM.h"
 #include "APP_NVM_Types.h"
 #include "APP_NVM_Cfg.h"
@@ -37,23 +38,44 @@ void APP_NVM_Custom_InitDeviceInfo(void);
 void APP_NVM_Custom_WriteResetState(uint8_t reset_state);
 bool APP_NVM_GetSensorData(APP_NVM_SENSOR_DATA_T *sensorData);
 void APP_NVM_SensorDataMsgAcked(void);
+void APP_NVM_Custom_StartSensorDataPrefetch(void);
+void APP_NVM_Custom_StopSensorDataPrefetch(void);
+void APP_NVM_Custom_PrefetchSensorData(void);
 uint8_t APP_NVM_Custom_GetSensorDataNumEntries(void);
 void APP_NVM_Custom_IndicateBufferFull(bool bufferIsFull);
 bool APP_NVM_GenericCheckData(uint8_t map_index);
 bool APP_NVM_VerifyChecksum(uint8_t * p_buf, uint8_t buf_len, uint8_t expected_checksum);
 
 static bool CheckDeviceInfo(uint8_t map_index);
+static uint8_t SensorDataNumEntries(void);
+
+// The AM drains the log one entry at a time (get entry, store it to flash, increment the tail) after it
+// has asked how many there are. From then on the next few entries are read from EEP in the main loop
+// while the AM is busy with the one before, so each get is answered from RAM.
+#define SENSOR_DATA_PREFETCH_DEPTH      2u
+
+typedef enum {
+    SENSOR_DATA_ENTRY_GOOD,
+    SENSOR_DATA_ENTRY_BAD_CHECKSUM,
+    SENSOR_DATA_ENTRY_NOT_READ,         // The EEP did not answer, the buffer holds whatever came in.
+}sensorDataEntryStatus_t;
+
+static sensorDataEntryStatus_t ReadSensorDataEntry(uint8_t pos, APP_NVM_SENSOR_DATA_T * p_entry);
 
 static APP_NVM_DEVICE_INFO_T Dev_Info = {};
 static APP_NVM_SECTION_HDR_T SensorDataHdr = {};
 
 static bool xSensorDataIsFull = false;
 
+static APP_NVM_SENSOR_DATA_T Prefetch_Entry[SENSOR_DATA_PREFETCH_DEPTH];
+static uint8_t Prefetch_Pos[SENSOR_DATA_PREFETCH_DEPTH];        // Log position of each staged entry.
+static uint8_t Prefetch_First = 0;                              // Staged entry for the tail.
+static uint8_t Prefetch_Count = 0;
+static bool Prefetch_Active = false;
+
 // Read the specified number of sensor data records
 bool APP_NVM_GetSensorData(APP_NVM_SENSOR_DATA_T *sensorData)
 {
-    uint16_t addr = 0;
-    uint8_t * p_report = (uint8_t *) sensorData;
     uint8_t pos = 0;
 
     // Get number of entries, return number of entries
@@ -66,13 +88,68 @@ bool APP_NVM_GetSensorData(APP_NVM_SENSOR_DATA_T *sensorData)
     // Update and increment the position to read from
     pos = SensorDataHdr.tail;
 
-    // New entries available
-    addr = (Section_Map[APP_NVM_SECT_TYPE_SENSOR_DATA].start_addr + sizeof(APP_NVM_SECTION_HDR_T) + (pos * sizeof(APP_NVM_SENSOR_DATA_T)));
-    APP_NVM_ReadBytes(addr, sizeof(APP_NVM_SENSOR_DATA_T), (uint8_t *) p_report);
+    // Serve it from RAM if the prefetch has it.  The AM may ask again, it is only dropped once acked.
+    if ( (Prefetch_Count > 0) && (Prefetch_Pos[Prefetch_First] == pos) )
+    {
+        memcpy(sensorData, &Prefetch_Entry[Prefetch_First], sizeof(APP_NVM_SENSOR_DATA_T));
+        return true;
+    }
+
+    // Not staged (no drain announced or the log moved under it), start over from the tail
+    Prefetch_First = 0;
+    Prefetch_Count = 0;
+
+    // New entries available.  One with a bad checksum is still sent, a failed read is not.
+    if ( ReadSensorDataEntry(pos, sensorData) == SENSOR_DATA_ENTRY_NOT_READ )
+    {
+        return false;
+    }
 
     return true;
 }
 
+// Start reading ahead, the AM just asked for the number of entries.
+void APP_NVM_Custom_StartSensorDataPrefetch(void)
+{
+    APP_NVM_Custom_StopSensorDataPrefetch();
+    Prefetch_Active = true;
+}
+
+// Drop everything staged.  Must be called whenever the log is written or defaulted.
+void APP_NVM_Custom_StopSensorDataPrefetch(void)
+{
+    Prefetch_Active = false;
+    Prefetch_First = 0;
+    Prefetch_Count = 0;
+}
+
+// Periodic function, stages one more entry per call so the main loop gets back to the AM in between.
+void APP_NVM_Custom_PrefetchSensorData(void)
+{
+    uint8_t pos = 0;
+    uint8_t slot = 0;
+
+    if ( (Prefetch_Active == false) || (Prefetch_Count >= SENSOR_DATA_PREFETCH_DEPTH) ) return;
+
+    // SensorDataHdr is current while a drain is running, only the AM moves the tail and logging stops the prefetch.
+    if ( Prefetch_Count >= SensorDataNumEntries() ) return;
+
+    pos = (SensorDataHdr.tail + Prefetch_Count) % MAX_SENSOR_DATA_LOGS;
+    slot = (Prefetch_First + Prefetch_Count) % SENSOR_DATA_PREFETCH_DEPTH;
+
+    if ( ReadSensorDataEntry(pos, &Prefetch_Entry[slot]) == SENSOR_DATA_ENTRY_GOOD )
+    {
+        Prefetch_Pos[slot] = pos;
+        Prefetch_Count++;
+    }
+    else
+    {
+        // Drop the ring, the gets go to EEP from here on.  A bad entry is read again when it is asked for,
+        // like it always was, and a failed read leaves nothing staged that the bus may have mangled.
+        APP_NVM_Custom_StopSensorDataPrefetch();
+    }
+}
+
 void APP_NVM_SensorDataMsgAcked(void)
 {
     if (  APP_NVM_Custom_GetBufferFullFlag() == true )
@@ -85,6 +162,18 @@ void APP_NVM_SensorDataMsgAcked(void)
         APP_NVM_UpdateCurrentEntry(APP_NVM_SECT_TYPE_DEVICE_INFO,  (uint8_t *) &Dev_Info, false);
     }
 
+    // The entry the AM just stored is done with
+    if ( (Prefetch_Count > 0) && (Prefetch_Pos[Prefetch_First] == SensorDataHdr.tail) )
+    {
+        Prefetch_First = (Prefetch_First + 1) % SENSOR_DATA_PREFETCH_DEPTH;
+        Prefetch_Count--;
+    }
+    else
+    {
+        Prefetch_First = 0;
+        Prefetch_Count = 0;
+    }
+
     SensorDataHdr.tail = (SensorDataHdr.tail + 1) % MAX_SENSOR_DATA_LOGS;
     SensorDataHdr.checksum = APP_NVM_ComputeChecksum((uint8_t *)&SensorDataHdr, (sizeof(APP_NVM_SECTION_HDR_T)-1));
     HW_EEP_WriteBlock(Section_Map[APP_NVM_SECT_TYPE_SENSOR_DATA].start_addr, (uint8_t *) &SensorDataHdr, sizeof(APP_NVM_SECTION_HDR_T));
@@ -104,6 +193,12 @@ uint8_t APP_NVM_Custom_GetSensorDataNumEntries(void)
 {
     APP_NVM_ReadSectionHeader(APP_NVM_SECT_TYPE_SENSOR_DATA, &SensorDataHdr);
 
+    return SensorDataNumEntries();
+}
+
+// Number of entries according to the RAM copy of the header
+static uint8_t SensorDataNumEntries(void)
+{
     if ( APP_NVM_Custom_GetBufferFullFlag() != true )
     {
         if(SensorDataHdr.head >= SensorDataHdr.tail)
@@ -247,6 +342,9 @@ void APP_NVM_Custom_WriteHighLevelState(uint8_t state)
 
 void APP_NVM_Custom_LogSensorData(APP_NVM_SENSOR_DATA_T * p_sensorData)
 {
+    // A full log overwrites the tail entry, anything staged may be stale
+    APP_NVM_Custom_StopSensorDataPrefetch();
+
     APP_NVM_UpdateCurrentEntry(APP_NVM_SECT_TYPE_SENSOR_DATA, (uint8_t *)p_sensorData, true);
 
     if ( APP_NVM_Custom_GetBufferFullFlag() == true )
@@ -413,3 +511,31 @@ static bool CheckDeviceInfo(uint8_t map_index)
 
     return section_good;
 }
+
+// Read the sensor data entry at the given log position.  Tried twice if the read fails or the checksum is bad
+// (a bus error would not repeat, a bad entry in EEP would).
+static sensorDataEntryStatus_t ReadSensorDataEntry(uint8_t pos, APP_NVM_SENSOR_DATA_T * p_entry)
+{
+    uint16_t addr = (Section_Map[APP_NVM_SECT_TYPE_SENSOR_DATA].start_addr + sizeof(APP_NVM_SECTION_HDR_T) + (pos * sizeof(APP_NVM_SENSOR_DATA_T)));
+    uint8_t tries = 0;
+    sensorDataEntryStatus_t status = SENSOR_DATA_ENTRY_NOT_READ;
+
+    while ( (tries < 2) && (status != SENSOR_DATA_ENTRY_GOOD) )
+    {
+        if ( APP_NVM_ReadBytes(addr, sizeof(APP_NVM_SENSOR_DATA_T), (uint8_t *) p_entry) == false )
+        {
+            status = SENSOR_DATA_ENTRY_NOT_READ;
+        }
+        else if ( APP_NVM_ComputeChecksum((uint8_t *) p_entry, (sizeof(APP_NVM_SENSOR_DATA_T) - 1)) == p_entry->checksum )
+        {
+            status = SENSOR_DATA_ENTRY_GOOD;
+        }
+        else
+        {
+            status = SENSOR_DATA_ENTRY_BAD_CHECKSUM;
+        }
+        tries++;
+    }
+
+    return status;
+}
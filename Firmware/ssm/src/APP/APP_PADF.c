@@ -0,0 +1,210 @@
+/**************************************************************************************************
+* \file     APP_PADF.c
+* \brief    Water pad filters, run over all of the pads in one loop
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "APP_PADF.h"
+
+#define PADF_NUM_PADS               8u
+#define PADF_FILL                   5u          // samples taken in before the filters start
+
+// Smoothing: all six entries are a ring. Once full, buffer_idx runs 5 to 10 and the next sample goes
+// in entry buffer_idx % 6, which is entry 5 first, right after the five the fill left in 0 to 4.
+#define SMOOTH_RING_LEN             6u
+#define SMOOTH_IDX_LAST             (PADF_FILL + SMOOTH_RING_LEN - 1u)
+
+// Delta: entries 0 to 3 are a ring of the last four samples and entry 5 keeps the last delta. Once full,
+// buffer_idx runs 5 to 8 with the oldest sample in entry buffer_idx - 5. The generated code wrote the
+// first sample after the fill over the fifth one, so that one was never in the window and the ring
+// starts from the first four.
+#define DELTA_RING_LEN              4u
+#define DELTA_IDX_LAST              (PADF_FILL + DELTA_RING_LEN - 1u)
+#define DELTA_LAST_ENTRY            5u
+
+// Where each pad lives in the generated structures
+static const uint8_t xBufferOffset[PADF_NUM_PADS] =
+{
+    offsetof(padFilteringData_t, pad_1_buffer), offsetof(padFilteringData_t, pad_2_buffer),
+    offsetof(padFilteringData_t, pad_3_buffer), offsetof(padFilteringData_t, pad_4_buffer),
+    offsetof(padFilteringData_t, pad_5_buffer), offsetof(padFilteringData_t, pad_6_buffer),
+    offsetof(padFilteringData_t, pad_7_buffer), offsetof(padFilteringData_t, pad_8_buffer),
+};
+
+static const uint8_t xSampleOffset[PADF_NUM_PADS] =
+{
+    offsetof(padSample_t, pad1), offsetof(padSample_t, pad2), offsetof(padSample_t, pad3), offsetof(padSample_t, pad4),
+    offsetof(padSample_t, pad5), offsetof(padSample_t, pad6), offsetof(padSample_t, pad7), offsetof(padSample_t, pad8),
+};
+
+void APP_PADF_Smooth(const padSample_t * p_sample, padFilteringData_t * p_data, padSample_t * p_filtered);
+void APP_PADF_Delta(const padSample_t * p_sample, padFilteringData_t * p_data, padSample_t * p_delta);
+
+static inline int16_T * xBuffer(padFilteringData_t * p_data, uint8_t pad);
+static inline int16_T xGetPad(const padSample_t * p_sample, uint8_t pad);
+static inline void xSetPad(padSample_t * p_sample, uint8_t pad, int16_T value);
+static void xFill(const padSample_t * p_sample, padFilteringData_t * p_data);
+static uint8_t xRingBack(uint8_t entry);
+
+// Weighted average of the newest sample (6/8) and the three before it (1/8, 1/16, 1/16). The first
+// five samples after a reset go through as they are.
+void APP_PADF_Smooth(const padSample_t * p_sample, padFilteringData_t * p_data, padSample_t * p_filtered)
+{
+    int16_T * p_buffer;
+    int16_T sample;
+    uint8_t next;
+    uint8_t back1;
+    uint8_t back2;
+    uint8_t back3;
+    uint8_t pad;
+
+    if ( p_data->buffer_idx < PADF_FILL )
+    {
+        xFill(p_sample, p_data);
+        *p_filtered = *p_sample;
+        return;
+    }
+
+    next = (p_data->buffer_idx == PADF_FILL) ? PADF_FILL : (uint8_t)(p_data->buffer_idx - SMOOTH_RING_LEN);
+    back1 = xRingBack(next);
+    back2 = xRingBack(back1);
+    back3 = xRingBack(back2);
+
+    for ( pad = 0u; pad < PADF_NUM_PADS; pad++ )
+    {
+        p_buffer = xBuffer(p_data, pad);
+        sample = xGetPad(p_sample, pad);
+        p_buffer[next] = sample;
+
+        //the generated expression as is, so it wraps and rounds the same
+        xSetPad(p_filtered, pad, (int16_T)((uint16_T)(((6 * sample + p_buffer[back1]) +
+                                 (int16_T)((uint16_T)p_buffer[back2] >> 1)) + (int16_T)((uint16_T)p_buffer[back3] >> 1)) >> 3));
+    }
+
+    p_data->buffer_idx = (p_data->buffer_idx == SMOOTH_IDX_LAST) ? PADF_FILL : (uint8_t)(p_data->buffer_idx + 1u);
+}
+
+// Range of the newest five samples, signed by whether the pad went down since the oldest of them, and
+// averaged with the last delta (rounded away from zero). Zero for the first five samples after a reset.
+void APP_PADF_Delta(const padSample_t * p_sample, padFilteringData_t * p_data, padSample_t * p_delta)
+{
+    int16_T * p_buffer;
+    int16_T sample;
+    int16_T max;
+    int16_T min;
+    int16_T delta;
+    uint8_t oldest;
+    uint8_t pad;
+    uint8_t i;
+
+    if ( p_data->buffer_idx < PADF_FILL )
+    {
+        xFill(p_sample, p_data);
+
+        for ( pad = 0u; pad < PADF_NUM_PADS; pad++ )
+        {
+            xSetPad(p_delta, pad, 0);
+        }
+        return;
+    }
+
+    oldest = (uint8_t)(p_data->buffer_idx - PADF_FILL);
+
+    for ( pad = 0u; pad < PADF_NUM_PADS; pad++ )
+    {
+        p_buffer = xBuffer(p_data, pad);
+        sample = xGetPad(p_sample, pad);
+
+        max = sample;
+        min = sample;
+
+        for ( i = 0u; i < DELTA_RING_LEN; i++ )
+        {
+            if ( p_buffer[i] > max )
+            {
+                max = p_buffer[i];
+            }
+            else if ( p_buffer[i] < min )
+            {
+                min = p_buffer[i];
+            }
+        }
+
+        if ( sample - p_buffer[oldest] < 1 )
+        {
+            delta = (min - max) + p_buffer[DELTA_LAST_ENTRY];
+        }
+        else
+        {
+            delta = (max - min) + p_buffer[DELTA_LAST_ENTRY];
+        }
+
+        if ( delta < 0 )
+        {
+            delta = 1 - delta;
+            delta = -(int16_T)((uint16_T)delta >> 1);
+        }
+        else
+        {
+            delta = (int16_T)((uint16_T)(delta + 1) >> 1);
+        }
+
+        p_buffer[DELTA_LAST_ENTRY] = delta;
+        p_buffer[oldest] = sample;
+        xSetPad(p_delta, pad, delta);
+    }
+
+    p_data->buffer_idx = (p_data->buffer_idx == DELTA_IDX_LAST) ? PADF_FILL : (uint8_t)(p_data->buffer_idx + 1u);
+}
+
+static inline int16_T * xBuffer(padFilteringData_t * p_data, uint8_t pad)
+{
+    return (int16_T *)((uint8_t *)p_data + xBufferOffset[pad]);
+}
+
+static inline int16_T xGetPad(const padSample_t * p_sample, uint8_t pad)
+{
+    return *(const int16_T *)((const uint8_t *)p_sample + xSampleOffset[pad]);
+}
+
+static inline void xSetPad(padSample_t * p_sample, uint8_t pad, int16_T value)
+{
+    *(int16_T *)((uint8_t *)p_sample + xSampleOffset[pad]) = value;
+}
+
+static void xFill(const padSample_t * p_sample, padFilteringData_t * p_data)
+{
+    uint8_t pad;
+
+    for ( pad = 0u; pad < PADF_NUM_PADS; pad++ )
+    {
+        xBuffer(p_data, pad)[p_data->buffer_idx] = xGetPad(p_sample, pad);
+    }
+
+    p_data->buffer_idx++;
+}
+
+static uint8_t xRingBack(uint8_t entry)
+{
+    return (entry == 0u) ? (uint8_t)(SMOOTH_RING_LEN - 1u) : (uint8_t)(entry - 1u);
+}
@@ -0,0 +1,204 @@
+/**************************************************************************************************
+* \file     APP_PROF.c
+* \brief    Execution time profile of the background loop and the algorithm stages
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "APP_PROF.h"
+#include "HW_TERM.h"
+#include "uC_TIME.h"
+
+// The microsecond counter wraps after 6.5 ticks. A stage that spans 6 or more ticks may have wrapped
+// it, so it is counted as saturated rather than trusted.
+#define SATURATE_TICKS              6u
+
+#define FIRST_BUCKET_SHIFT          4u          // below 16 us
+#define BUCKET_SHIFT                2u          // each bucket is 4 times wider than the last
+#define LAST_TIMED_BUCKET           (APP_PROF_NUM_BUCKETS - 2u)
+
+// Even, so halving count and sum together keeps the mean
+#define COUNT_LIMIT                 (UINT16_MAX - 1u)
+
+#define DEBUG_STRLEN                120
+
+#define APP_PROF_NAME_ENTRY(stage, name)        name,
+
+static const char * const xStageNames[PROF_STAGE_COUNT] = { APP_PROF_STAGES(APP_PROF_NAME_ENTRY) };
+
+static appProfStats_t xStats[PROF_STAGE_COUNT];
+
+void APP_PROF_Reset(void);
+appProfStamp_t APP_PROF_Begin(void);
+void APP_PROF_End(appProfStage_t stage, appProfStamp_t start);
+void APP_PROF_Add(appProfStage_t stage, uint16_t us);
+const appProfStats_t * APP_PROF_GetStats(appProfStage_t stage);
+uint16_t APP_PROF_GetMean(appProfStage_t stage);
+void APP_PROF_Report(void);
+
+static uint8_t xGetBucket(uint16_t us);
+
+void APP_PROF_Reset(void)
+{
+    uint8_t i;
+
+    memset(xStats, 0, sizeof(xStats));
+
+    for ( i = 0u; i < PROF_STAGE_COUNT; i++ )
+    {
+        xStats[i].min = UINT16_MAX;
+    }
+}
+
+appProfStamp_t APP_PROF_Begin(void)
+{
+    appProfStamp_t stamp;
+
+    stamp.ticks = (uint16_t)uC_TIME_GetRuntimeTicks();
+    stamp.us = uC_TIME_GetMicroseconds();
+
+    return stamp;
+}
+
+void APP_PROF_End(appProfStage_t stage, appProfStamp_t start)
+{
+    uint16_t us = uC_TIME_GetMicroseconds();
+    uint16_t ticks = (uint16_t)uC_TIME_GetRuntimeTicks();
+
+    if ( (uint16_t)(ticks - start.ticks) >= SATURATE_TICKS )
+    {
+        us = APP_PROF_SATURATED;
+    }
+    else
+    {
+        us -= start.us;
+    }
+
+    APP_PROF_Add(stage, us);
+}
+
+// Add one measurement, for times that were taken some other way
+void APP_PROF_Add(appProfStage_t stage, uint16_t us)
+{
+    appProfStats_t * p_stats;
+    uint8_t bucket = xGetBucket(us);
+    uint8_t i;
+
+    if ( stage >= PROF_STAGE_COUNT )
+    {
+        return;
+    }
+
+    p_stats = &xStats[stage];
+
+    // sum can't overflow, it holds at most COUNT_LIMIT samples of at most UINT16_MAX
+    if ( p_stats->count == COUNT_LIMIT )
+    {
+        p_stats->count >>= 1;
+        p_stats->sum >>= 1;
+    }
+
+    p_stats->count++;
+    p_stats->sum += us;
+
+    if ( us < p_stats->min )
+    {
+        p_stats->min = us;
+    }
+    if ( us > p_stats->max )
+    {
+        p_stats->max = us;
+    }
+
+    if ( p_stats->buckets[bucket] == UINT16_MAX )
+    {
+        for ( i = 0u; i < APP_PROF_NUM_BUCKETS; i++ )
+        {
+            p_stats->buckets[i] >>= 1;
+        }
+    }
+
+    p_stats->buckets[bucket]++;
+}
+
+const appProfStats_t * APP_PROF_GetStats(appProfStage_t stage)
+{
+    return (stage < PROF_STAGE_COUNT) ? &xStats[stage] : NULL;
+}
+
+uint16_t APP_PROF_GetMean(appProfStage_t stage)
+{
+    if ( (stage >= PROF_STAGE_COUNT) || (xStats[stage].count == 0u) )
+    {
+        return 0u;
+    }
+
+    return (uint16_t)(xStats[stage].sum / xStats[stage].count);
+}
+
+void APP_PROF_Report(void)
+{
+    uint8_t str[DEBUG_STRLEN];
+    const appProfStats_t * p_stats;
+    uint8_t i;
+
+    HW_TERM_Print("\n\rstage                       count   min  mean   max |   <16   <64  <256   <1k   <4k  <16k  >16k   sat\n\r");
+
+    for ( i = 0u; i < PROF_STAGE_COUNT; i++ )
+    {
+        p_stats = &xStats[i];
+
+        if ( p_stats->count == 0u )
+        {
+            sprintf((char *)str, "%-26s      0\n\r", xStageNames[i]);
+        }
+        else
+        {
+            sprintf((char *)str, "%-26s %6u %5u %5u %5u |%6u%6u%6u%6u%6u%6u%6u%6u\n\r", xStageNames[i],
+                    p_stats->count, p_stats->min, APP_PROF_GetMean((appProfStage_t)i), p_stats->max,
+                    p_stats->buckets[0], p_stats->buckets[1], p_stats->buckets[2], p_stats->buckets[3],
+                    p_stats->buckets[4], p_stats->buckets[5], p_stats->buckets[6], p_stats->buckets[7]);
+        }
+
+        HW_TERM_Print(str);
+    }
+}
+
+static uint8_t xGetBucket(uint16_t us)
+{
+    uint8_t bucket = 0u;
+
+    if ( us == APP_PROF_SATURATED )
+    {
+        return (APP_PROF_NUM_BUCKETS - 1u);
+    }
+
+    us >>= FIRST_BUCKET_SHIFT;
+
+    while ( (us != 0u) && (bucket < LAST_TIMED_BUCKET) )
+    {
+        bucket++;
+        us >>= BUCKET_SHIFT;
+    }
+
+    return bucket;
+}
@@ -0,0 +1,312 @@
+/**************************************************************************************************
+* \file     APP_STATS.c
+* \brief    Streaming daily usage statistics and breakdown (red flag) detection
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <string.h>
+#include "APP_STATS.h"
+
+// Every statistic below is updated in constant time once per day, no raw daily history is kept.
+//
+// Per weekday baseline:  a decaying sum S = S - S/N + liters, with N = 2^BASELINE_WEEKS_SHIFT.
+//                        S/N tracks the average for that day of the week over roughly the last N weeks.
+// Daily liters:          exponentially weighted mean (Q4) of every day, used to floor the deviation.
+// Residual variance:     exponentially weighted variance of (weekday baseline - liters).
+// CUSUM:                 one sided (lower) cumulative sum of the shortfall below the off level plus a
+//                        slack of half a standard deviation (at most the baseline less the slack). A
+//                        sustained partial drop in usage will accumulate until it crosses
+//                        CUSUM_ALARM_SIGMAS standard deviations. Measuring from the off level rather than
+//                        the baseline keeps the baseline's lag behind a seasonal swing from adding up to
+//                        an alarm.
+#define BASELINE_WEEKS_SHIFT                3       // 8 week baseline, same RAM as the old 4 week array
+#define WARMUP_DAYS                         28      // need 4 weeks of data before we look for red flags
+#define EW_SHIFT                            3       // alpha = 1/8 for the mean and variance
+#define MEAN_Q_SHIFT                        4       // daily mean is stored in Q4 for resolution
+#define SIGMA_FLOOR_DIVISOR                 16      // sigma is never treated as less than 1/16 of the daily mean
+#define CUSUM_ALARM_SIGMAS                  5
+#define CUSUM_MAX                           0x00FFFFFFul
+#define RESIDUAL_CLAMP                      32767l
+#define PERCENTAGE_DIVISOR                  100
+
+static uint32_t weekdaySum[APP_STATS_DAYS_PER_WEEK] = {};
+static uint8_t weekdaySeenMask = 0u;
+static uint32_t ewMeanLitersQ4 = 0u;
+static uint32_t ewResidualVar = 0u;
+static uint32_t cusum = 0u;
+static uint16_t daysSeen = 0u;
+static uint8_t dayIdx = 0u;
+static bool isRedFlagConditionSet = false;
+static uint16_t redFlagOnThreshold = 0u;
+static uint16_t redFlagOffThreshold = 0u;
+
+void APP_STATS_Reset(void);
+void APP_STATS_SetThresholds(uint16_t onThreshold, uint16_t offThreshold);
+bool APP_STATS_UpdateDaily(uint16_t dailyLiters, uint16_t *avgLiters);
+void APP_STATS_LearnDay(uint16_t dailyLiters);
+uint8_t APP_STATS_GetDayOfWeek(void);
+bool APP_STATS_IsBaselineReady(void);
+bool APP_STATS_IsRedFlagSet(void);
+
+static void xLearn(uint16_t dailyLiters);
+static void xAdvanceDay(void);
+static uint16_t xGetBaseline(void);
+static uint16_t xGetSigma(void);
+static uint32_t xEwUpdate(uint32_t average, uint32_t sample);
+static uint16_t xIsqrt(uint32_t value);
+
+void APP_STATS_Reset(void)
+{
+    memset(&weekdaySum, 0, sizeof(weekdaySum));
+    weekdaySeenMask = 0u;
+    ewMeanLitersQ4 = 0u;
+    ewResidualVar = 0u;
+    cusum = 0u;
+    daysSeen = 0u;
+
+    //next day is day 0
+    dayIdx = 0u;
+    isRedFlagConditionSet = false;
+}
+
+void APP_STATS_SetThresholds(uint16_t onThreshold, uint16_t offThreshold)
+{
+    redFlagOnThreshold = onThreshold;
+    redFlagOffThreshold = offThreshold;
+}
+
+// Called once per day with the total liters for the day. Returns the red flag state and fills
+// in the baseline for this day of the week (0 until the baseline has warmed up).
+bool APP_STATS_UpdateDaily(uint16_t dailyLiters, uint16_t *avgLiters)
+{
+    uint16_t baseline = 0u;
+    uint16_t sigma = 0u;
+    uint32_t onLevel = 0u;
+    uint32_t offLevel = 0u;
+    uint32_t reference = 0u;
+    uint32_t cap = 0u;
+    int32_t step = 0;
+
+    if ( APP_STATS_IsBaselineReady() == true )
+    {
+        baseline = xGetBaseline();
+        sigma = xGetSigma();
+        onLevel = ((uint32_t)baseline * redFlagOnThreshold) / PERCENTAGE_DIVISOR;
+        offLevel = ((uint32_t)baseline * redFlagOffThreshold) / PERCENTAGE_DIVISOR;
+
+        //accumulate the shortfall below the off level plus the slack, but never nearer the baseline than the slack
+        reference = offLevel + (sigma / 2u);
+        //the slack can be more than the baseline on a quiet day, sigma is shared by all days of the week
+        cap = (baseline > (sigma / 2u)) ? ((uint32_t)baseline - (sigma / 2u)) : 0u;
+        if ( reference > cap )
+        {
+            reference = cap;
+        }
+
+        step = (int32_t)reference - (int32_t)dailyLiters;
+
+        if ( step < 0 && (uint32_t)(-step) >= cusum )
+        {
+            cusum = 0u;
+        }
+        else
+        {
+            cusum += step;
+
+            if ( cusum > CUSUM_MAX )
+            {
+                cusum = CUSUM_MAX;
+            }
+        }
+
+        //todays liters are less than X% of the average for this day
+        if ( dailyLiters < onLevel )
+        {
+            isRedFlagConditionSet = true;
+        }
+        else if ( isRedFlagConditionSet == true )
+        {
+            //recovered when todays liters are back to X% of the average for this day
+            if ( dailyLiters >= offLevel )
+            {
+                isRedFlagConditionSet = false;
+                cusum = 0u;
+                xLearn(dailyLiters);
+            }
+        }
+        //a smaller drop that has persisted long enough, only flag it if today would not clear it right away
+        else if ( (cusum > ((uint32_t)sigma * CUSUM_ALARM_SIGMAS)) && (dailyLiters < offLevel) )
+        {
+            isRedFlagConditionSet = true;
+        }
+        else
+        {
+            xLearn(dailyLiters);
+        }
+    }
+    else
+    {
+        //just learn since we dont have enough data yet
+        xLearn(dailyLiters);
+    }
+
+    *avgLiters = baseline;
+
+    xAdvanceDay();
+
+    return isRedFlagConditionSet;
+}
+
+// Feed a day into the baseline without running the detector
+void APP_STATS_LearnDay(uint16_t dailyLiters)
+{
+    xLearn(dailyLiters);
+    xAdvanceDay();
+}
+
+uint8_t APP_STATS_GetDayOfWeek(void)
+{
+    return dayIdx;
+}
+
+bool APP_STATS_IsBaselineReady(void)
+{
+    return ( daysSeen >= WARMUP_DAYS );
+}
+
+bool APP_STATS_IsRedFlagSet(void)
+{
+    return isRedFlagConditionSet;
+}
+
+static void xLearn(uint16_t dailyLiters)
+{
+    int32_t residual = 0;
+    uint8_t dayMask = (uint8_t)(1u << dayIdx);
+
+    if ( (weekdaySeenMask & dayMask) == 0u )
+    {
+        //first sample for this day of the week seeds the whole sum
+        weekdaySum[dayIdx] = (uint32_t)dailyLiters << BASELINE_WEEKS_SHIFT;
+        weekdaySeenMask |= dayMask;
+    }
+    else
+    {
+        residual = (int32_t)xGetBaseline() - (int32_t)dailyLiters;
+
+        if ( residual > RESIDUAL_CLAMP )
+        {
+            residual = RESIDUAL_CLAMP;
+        }
+        else if ( residual < -RESIDUAL_CLAMP )
+        {
+            residual = -RESIDUAL_CLAMP;
+        }
+
+        ewResidualVar = xEwUpdate(ewResidualVar, (uint32_t)(residual * residual));
+        weekdaySum[dayIdx] = weekdaySum[dayIdx] - (weekdaySum[dayIdx] >> BASELINE_WEEKS_SHIFT) + dailyLiters;
+    }
+
+    if ( daysSeen == 0u )
+    {
+        ewMeanLitersQ4 = (uint32_t)dailyLiters << MEAN_Q_SHIFT;
+    }
+    else
+    {
+        ewMeanLitersQ4 = xEwUpdate(ewMeanLitersQ4, (uint32_t)dailyLiters << MEAN_Q_SHIFT);
+    }
+}
+
+static void xAdvanceDay(void)
+{
+    dayIdx++;
+    if ( dayIdx >= APP_STATS_DAYS_PER_WEEK )
+    {
+        dayIdx = 0u;
+    }
+
+    if ( daysSeen < WARMUP_DAYS )
+    {
+        daysSeen++;
+    }
+}
+
+static uint16_t xGetBaseline(void)
+{
+    return (uint16_t)(weekdaySum[dayIdx] >> BASELINE_WEEKS_SHIFT);
+}
+
+static uint16_t xGetSigma(void)
+{
+    uint16_t sigma = xIsqrt(ewResidualVar);
+    uint16_t sigmaFloor = (uint16_t)((ewMeanLitersQ4 >> MEAN_Q_SHIFT) / SIGMA_FLOOR_DIVISOR);
+
+    if ( sigma < sigmaFloor )
+    {
+        sigma = sigmaFloor;
+    }
+
+    return sigma;
+}
+
+// average += (sample - average) * 2^-EW_SHIFT, without relying on signed shifts
+static uint32_t xEwUpdate(uint32_t average, uint32_t sample)
+{
+    if ( sample >= average )
+    {
+        average += (sample - average) >> EW_SHIFT;
+    }
+    else
+    {
+        average -= (average - sample) >> EW_SHIFT;
+    }
+
+    return average;
+}
+
+// Bitwise integer square root, 16 iterations with no divides
+static uint16_t xIsqrt(uint32_t value)
+{
+    uint32_t root = 0u;
+    uint32_t bit = 1ul << 30;
+
+    while ( bit > value )
+    {
+        bit >>= 2;
+    }
+
+    while ( bit != 0u )
+    {
+        if ( value >= root + bit )
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+
+        bit >>= 2;
+    }
+
+    return (uint16_t)root;
+}
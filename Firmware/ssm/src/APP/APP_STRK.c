@@ -0,0 +1,608 @@
+/**************************************************************************************************
+* \file     APP_STRK.c
+* \brief    Streaming stroke detection, transitions and strokes a few samples at a time
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdint.h>
+#include "APP_STRK.h"
+#include "HW_TRACE.h"
+#include "algo-c-code/initializeStrokeAlgorithm/initializeStrokeAlgorithm.h"
+
+// Window layout, see writeMagSample(). A window is 120 samples, the first 50 are the last 50 of the
+// window before, so only 51 to 120 are new once the detector has started.
+#define STRK_WINDOW_LEN             120u
+#define STRK_OVERLAP_LEN            50u
+#define STRK_BLOCK_LEN              20u
+#define STRK_NEW_LEN                (STRK_WINDOW_LEN - STRK_OVERLAP_LEN)
+#define STRK_IDLE                   0u          // no window being read
+
+// The writer goes OA, A, OB, B, 140 samples around. After a window closes the 20 samples of the block
+// outside it are written first, then each write lands on the oldest sample of the window, so index k
+// is written over by the (k + 20)th write after the close.
+#define STRK_WRITE_CYCLE            140u
+#define STRK_CLOSE_POS_A            120u        // write position just after window A closes
+#define STRK_CLOSE_POS_B            50u
+
+// Work per nest run, a window's 70 new samples take 35 runs of the 70 between windows
+#define STRK_SAMPLES_PER_RUN        2u
+
+// Transitions waiting for the stroke pairing, a power of two. One sample adds at most two.
+#define STRK_RING_LEN               8u
+#define STRK_RING_MASK              (STRK_RING_LEN - 1u)
+#define STRK_RING_ROOM              2u
+
+// detectTransitions() thresholds
+#define STRK_SLOPE_CNT              3u
+#define STRK_SLOPE_SUM              95
+#define STRK_SWITCH_CNT             12u
+#define STRK_COMBINED_BIAS          1500
+
+// |from - to| * 100 is under 2^22, see xPercent()
+#define STRK_PERCENT_BITS           22u
+
+#define STRK_NEGATE_X               0x01u
+#define STRK_NEGATE_Y               0x02u
+#define STRK_NEGATE_Z               0x04u
+
+typedef struct
+{
+    const int16_T * p_x;
+    const int16_T * p_y;
+    const int16_T * p_z;
+}strkBlock_t;
+
+// The window being worked through, with what detectTransitions() and detectStrokes() would have read
+// from the calibration and water data when the window was handed over
+typedef struct
+{
+    const magWindows_t * p_windows;
+    strkBlock_t blocks[3];          // indexes 1 to 50, 51 to 70 and 71 to 120
+    Window window;
+    uint8_t next;                   // next index to read, STRK_IDLE once finished
+    uint8_t negate;                 // STRK_NEGATE_ bits for the axes that are not a positive orientation
+    uint16_t bias;                  // 1500 less the offsets, mod 2^16 like the target's int
+    uint16_T presentStart;
+    uint16_T presentStop;
+    bool shiftLast;                 // last transition is from the window before, move it into this one
+    uint8_t strokes;
+    accumStrokeCount_t * p_accum;
+}strkJob_t;
+
+static strokeTransitionInfo_t xDetect;
+static strokeDetectInfo_t xPair;
+static strkJob_t xJob;
+static strokeTransition_t xRing[STRK_RING_LEN];
+static uint8_t xRingHead = 0u;
+static uint8_t xRingCount = 0u;
+static uint8_t xLastStrokes = 0u;   // strokes in the last window finished
+
+// Percent displacement as a multiply, remade when the calibrated range moves
+static int16_t xRange = 0;
+static uint32_t xRecip = 0uL;
+static uint8_t xRecipShift = 0u;
+
+void APP_STRK_Reset(accumStrokeCount_t * p_accum);
+void APP_STRK_AcceptWindow(const magWindows_t * p_windows, const magCalibration_t * p_calib,
+                           const waterAlgoData_t * p_water, accumStrokeCount_t * p_accum);
+void APP_STRK_Run(void);
+void APP_STRK_Drain(void);
+bool APP_STRK_IsActive(void);
+
+static void xSetBlocks(const magWindows_t * p_windows);
+static void xSetRange(int16_t range);
+static void xRunTo(uint8_t last);
+static uint8_t xDueIndex(void);
+static int16_t xCombined(uint8_t index);
+static void xSample(int16_t index);
+static void xPush(TransitionType type, int16_t val, int16_t index);
+static void xPairAll(void);
+static void xStroke(const strokeTransition_t * p_from, const strokeTransition_t * p_to);
+static int16_t xPercent(int16_t from, int16_t to);
+
+// Same starting state as initializeStrokeAlgorithm(), the accumulated counts are cleared too
+void APP_STRK_Reset(accumStrokeCount_t * p_accum)
+{
+    initializeStrokeAlgorithm( &xDetect, &xPair, p_accum );
+
+    xJob.next = STRK_IDLE;
+    xJob.p_accum = p_accum;
+    xRingHead = 0u;
+    xRingCount = 0u;
+    xLastStrokes = 0u;
+    xSetRange(0);
+}
+
+// Called once per window, after magnetometerCalibration() on it
+void APP_STRK_AcceptWindow(const magWindows_t * p_windows, const magCalibration_t * p_calib,
+                           const waterAlgoData_t * p_water, accumStrokeCount_t * p_accum)
+{
+    //the last one is normally done long before, never leave it half read
+    APP_STRK_Drain();
+
+    xJob.p_windows = p_windows;
+    xJob.window = p_windows->read_window;
+    xJob.strokes = 0u;
+    xJob.presentStart = p_water->present_start_idx;
+    xJob.presentStop = p_water->present_stop_idx;
+    xJob.p_accum = p_accum;
+
+    //the per window part of detectStrokes()
+    xJob.shiftLast = (xPair.is_first == 0u);
+    xPair.is_first = 0u;
+    p_accum->num_windows_processed++;
+
+    if ( p_calib->calibration_changed != 0u )
+    {
+        p_accum->mag_calibration_changed = 1u;
+    }
+
+    //same 16 bit difference the generated code takes
+    if ( (int16_t)(p_calib->max_val - p_calib->min_val) != xRange )
+    {
+        xSetRange((int16_t)(p_calib->max_val - p_calib->min_val));
+    }
+
+    if ( (p_calib->magnet_present == 0u) || (p_calib->orientation_calibrated == 0u) || (p_calib->offset_calibrated == 0u) )
+    {
+        //not calibrated, the window is skipped
+        xJob.next = STRK_IDLE;
+        xLastStrokes = 0u;
+        return;
+    }
+
+    xSetBlocks(p_windows);
+    xJob.negate = (uint8_t)(((p_calib->x_orientation != positive) ? STRK_NEGATE_X : 0u) |
+                            ((p_calib->y_orientation != positive) ? STRK_NEGATE_Y : 0u) |
+                            ((p_calib->z_orientation != positive) ? STRK_NEGATE_Z : 0u));
+    xJob.bias = (uint16_t)STRK_COMBINED_BIAS;
+    xJob.bias = ((xJob.negate & STRK_NEGATE_X) != 0u) ? (uint16_t)(xJob.bias + (uint16_t)p_calib->x_offset) : (uint16_t)(xJob.bias - (uint16_t)p_calib->x_offset);
+    xJob.bias = ((xJob.negate & STRK_NEGATE_Y) != 0u) ? (uint16_t)(xJob.bias + (uint16_t)p_calib->y_offset) : (uint16_t)(xJob.bias - (uint16_t)p_calib->y_offset);
+    xJob.bias = ((xJob.negate & STRK_NEGATE_Z) != 0u) ? (uint16_t)(xJob.bias + (uint16_t)p_calib->z_offset) : (uint16_t)(xJob.bias - (uint16_t)p_calib->z_offset);
+
+    if ( xDetect.is_first == 0u )
+    {
+        //the peak index is from the window before
+        xDetect.peak_idx -= (int16_t)STRK_NEW_LEN;
+        xJob.next = STRK_OVERLAP_LEN + 1u;
+    }
+    else
+    {
+        //start from no activity at the first sample
+        xDetect.is_first = 0u;
+        xDetect.prev_val = xCombined(1u);
+        xPush(no_transition_activity, 0, 1);
+        xPairAll();
+        xJob.next = 2u;
+    }
+}
+
+// Called every nest run, after the window writes and processing
+void APP_STRK_Run(void)
+{
+    uint8_t last;
+    uint8_t due;
+
+    if ( xJob.next == STRK_IDLE )
+    {
+        return;
+    }
+
+    last = (uint8_t)(xJob.next - 1u + STRK_SAMPLES_PER_RUN);
+    due = xDueIndex();
+
+    //a window handed over late has to catch up before its samples are written over
+    if ( due > last )
+    {
+        last = due;
+    }
+
+    xRunTo(last);
+}
+
+// Finish the window now, before the counts are read or the windows reset
+void APP_STRK_Drain(void)
+{
+    if ( xJob.next != STRK_IDLE )
+    {
+        xRunTo(STRK_WINDOW_LEN);
+    }
+}
+
+bool APP_STRK_IsActive(void)
+{
+    return ( (xDetect.state != no_activity) || (xLastStrokes > 0u) );
+}
+
+static void xSetBlocks(const magWindows_t * p_windows)
+{
+    const b_magBlock_t * p_first = (xJob.window == windowA) ? &p_windows->blockOA : &p_windows->blockOB;
+    const magBlock_t * p_middle = (xJob.window == windowA) ? &p_windows->blockA : &p_windows->blockB;
+    const b_magBlock_t * p_last = (xJob.window == windowA) ? &p_windows->blockOB : &p_windows->blockOA;
+
+    xJob.blocks[0].p_x = p_first->x_lsb;
+    xJob.blocks[0].p_y = p_first->y_lsb;
+    xJob.blocks[0].p_z = p_first->z_lsb;
+    xJob.blocks[1].p_x = p_middle->x_lsb;
+    xJob.blocks[1].p_y = p_middle->y_lsb;
+    xJob.blocks[1].p_z = p_middle->z_lsb;
+    xJob.blocks[2].p_x = p_last->x_lsb;
+    xJob.blocks[2].p_y = p_last->y_lsb;
+    xJob.blocks[2].p_z = p_last->z_lsb;
+}
+
+// floor(n / range) is (n * xRecip) >> xRecipShift for every n under 2^22, with the shift 22 plus the
+// bits in range rounded up and xRecip 2^shift / range rounded up. The divide is here, once per change.
+static void xSetRange(int16_t range)
+{
+    xRange = range;
+    xRecip = 0uL;
+    xRecipShift = STRK_PERCENT_BITS;
+
+    if ( range <= 0 )
+    {
+        return;
+    }
+
+    while ( ((uint32_t)1u << (xRecipShift - STRK_PERCENT_BITS)) < (uint32_t)range )
+    {
+        xRecipShift++;
+    }
+
+    xRecip = (uint32_t)((((uint64_t)1u << xRecipShift) + (uint64_t)(range - 1)) / (uint64_t)range);
+}
+
+static void xRunTo(uint8_t last)
+{
+    if ( last > STRK_WINDOW_LEN )
+    {
+        last = STRK_WINDOW_LEN;
+    }
+
+    while ( xJob.next <= last )
+    {
+        //hold off the detector until the pairing has taken what is waiting
+        if ( xRingCount > (STRK_RING_LEN - STRK_RING_ROOM) )
+        {
+            xPairAll();
+        }
+
+        xSample((int16_t)xJob.next);
+        xJob.next++;
+    }
+
+    xPairAll();
+
+    if ( xJob.next > STRK_WINDOW_LEN )
+    {
+        xJob.next = STRK_IDLE;
+        xLastStrokes = xJob.strokes;
+    }
+}
+
+// Highest index that has to be read before the next write, 0 if none yet
+static uint8_t xDueIndex(void)
+{
+    uint16_t pos = xJob.p_windows->write_idx;
+    uint16_t written;
+
+    switch ( xJob.p_windows->write_block )
+    {
+        case b_blockA:
+            pos += STRK_OVERLAP_LEN;
+            break;
+
+        case b_blockOB:
+            pos += STRK_OVERLAP_LEN + STRK_BLOCK_LEN;
+            break;
+
+        case b_blockB:
+            pos += STRK_WINDOW_LEN;
+            break;
+
+        default:
+            break;
+    }
+
+    written = (uint16_t)((pos + STRK_WRITE_CYCLE - ((xJob.window == windowA) ? STRK_CLOSE_POS_A : STRK_CLOSE_POS_B)) % STRK_WRITE_CYCLE);
+
+    return (written >= STRK_BLOCK_LEN) ? (uint8_t)(written + 1u - STRK_BLOCK_LEN) : 0u;
+}
+
+// applyCalibrationAndCombineAxes() of detectTransitions(), each axis turned by its orientation less
+// its offset, summed and lifted by 1500. The offsets are folded into the bias, the sum wraps the same.
+static int16_t xCombined(uint8_t index)
+{
+    const strkBlock_t * p_block;
+    uint16_t sum = xJob.bias;
+    uint8_t i;
+
+    if ( xJob.window == no_window )
+    {
+        //every axis reads -500
+        return 0;
+    }
+
+    if ( index <= STRK_OVERLAP_LEN )
+    {
+        p_block = &xJob.blocks[0];
+        i = (uint8_t)(index - 1u);
+    }
+    else if ( index <= (STRK_OVERLAP_LEN + STRK_BLOCK_LEN) )
+    {
+        p_block = &xJob.blocks[1];
+        i = (uint8_t)(index - STRK_OVERLAP_LEN - 1u);
+    }
+    else
+    {
+        p_block = &xJob.blocks[2];
+        i = (uint8_t)(index - STRK_OVERLAP_LEN - STRK_BLOCK_LEN - 1u);
+    }
+
+    sum = ((xJob.negate & STRK_NEGATE_X) != 0u) ? (uint16_t)(sum - (uint16_t)p_block->p_x[i]) : (uint16_t)(sum + (uint16_t)p_block->p_x[i]);
+    sum = ((xJob.negate & STRK_NEGATE_Y) != 0u) ? (uint16_t)(sum - (uint16_t)p_block->p_y[i]) : (uint16_t)(sum + (uint16_t)p_block->p_y[i]);
+    sum = ((xJob.negate & STRK_NEGATE_Z) != 0u) ? (uint16_t)(sum - (uint16_t)p_block->p_z[i]) : (uint16_t)(sum + (uint16_t)p_block->p_z[i]);
+
+    return (int16_t)sum;
+}
+
+// One pass of the detectTransitions() loop
+static void xSample(int16_t index)
+{
+    int16_t curr = xCombined((uint8_t)index);
+
+    switch ( xDetect.state )
+    {
+        case no_activity:
+            xDetect.state_switch_cnt = 0u;
+
+            if ( curr > xDetect.prev_val )
+            {
+                xDetect.downslope_cnt = 0u;
+                xDetect.downslope_sum = 0;
+                xDetect.upslope_cnt++;
+                xDetect.upslope_sum = (int16_t)((xDetect.upslope_sum + curr) - xDetect.prev_val);
+
+                //leaving the flat part on the way up, it started from a valley
+                if ( (xDetect.upslope_cnt >= STRK_SLOPE_CNT) && (xDetect.upslope_sum >= STRK_SLOPE_SUM) )
+                {
+                    xDetect.state = finding_peak;
+                    xDetect.peak_val = curr;
+                    xDetect.peak_idx = index;
+                    xPush(transition_valley, xDetect.prev_val, index - 1);
+                }
+            }
+            else if ( curr < xDetect.prev_val )
+            {
+                xDetect.upslope_cnt = 0u;
+                xDetect.upslope_sum = 0;
+                xDetect.downslope_cnt++;
+                xDetect.downslope_sum = (int16_t)((xDetect.downslope_sum + xDetect.prev_val) - curr);
+
+                if ( (xDetect.downslope_cnt >= STRK_SLOPE_CNT) && (xDetect.downslope_sum >= STRK_SLOPE_SUM) )
+                {
+                    xDetect.state = finding_valley;
+                    xDetect.peak_val = curr;
+                    xDetect.peak_idx = index;
+                    xPush(transition_peak, xDetect.prev_val, index - 1);
+                }
+            }
+            else
+            {
+                xDetect.upslope_cnt = 0u;
+                xDetect.upslope_sum = 0;
+                xDetect.downslope_cnt = 0u;
+                xDetect.downslope_sum = 0;
+            }
+            break;
+
+        case finding_peak:
+            if ( curr >= xDetect.prev_val )
+            {
+                if ( curr >= xDetect.peak_val )
+                {
+                    xDetect.peak_val = curr;
+                    xDetect.peak_idx = index;
+                }
+
+                //count the turns from down to up
+                if ( xDetect.downslope_cnt > 0u )
+                {
+                    xDetect.state_switch_cnt++;
+                }
+
+                xDetect.downslope_cnt = 0u;
+                xDetect.downslope_sum = 0;
+            }
+            else
+            {
+                xDetect.upslope_cnt = 0u;
+                xDetect.upslope_sum = 0;
+                xDetect.downslope_cnt++;
+                xDetect.downslope_sum = (int16_t)((xDetect.downslope_sum + xDetect.prev_val) - curr);
+
+                if ( (xDetect.downslope_cnt >= STRK_SLOPE_CNT) && (xDetect.downslope_sum >= STRK_SLOPE_SUM) )
+                {
+                    xPush(transition_peak, xDetect.peak_val, xDetect.peak_idx);
+                    xDetect.state = finding_valley;
+                    xDetect.state_switch_cnt = 0u;
+                    xDetect.peak_val = curr;
+                    xDetect.peak_idx = index;
+                }
+            }
+
+            //wobbling without a stroke, close out the peak and go back to flat
+            if ( xDetect.state_switch_cnt >= STRK_SWITCH_CNT )
+            {
+                xDetect.state = no_activity;
+                xPush(transition_peak, xDetect.peak_val, xDetect.peak_idx);
+                xPush(no_transition_activity, 0, index);
+            }
+            break;
+
+        default:
+            if ( curr <= xDetect.prev_val )
+            {
+                if ( curr <= xDetect.peak_val )
+                {
+                    xDetect.peak_val = curr;
+                    xDetect.peak_idx = index;
+                }
+
+                //count the turns from up to down
+                if ( xDetect.upslope_cnt > 0u )
+                {
+                    xDetect.state_switch_cnt++;
+                }
+
+                xDetect.upslope_cnt = 0u;
+                xDetect.upslope_sum = 0;
+            }
+            else
+            {
+                xDetect.downslope_cnt = 0u;
+                xDetect.downslope_sum = 0;
+                xDetect.upslope_cnt++;
+                xDetect.upslope_sum = (int16_t)((xDetect.upslope_sum + curr) - xDetect.prev_val);
+
+                if ( (xDetect.upslope_cnt >= STRK_SLOPE_CNT) && (xDetect.upslope_sum >= STRK_SLOPE_SUM) )
+                {
+                    xPush(transition_valley, xDetect.peak_val, xDetect.peak_idx);
+                    xDetect.state = finding_peak;
+                    xDetect.state_switch_cnt = 0u;
+                    xDetect.peak_val = curr;
+                    xDetect.peak_idx = index;
+                }
+            }
+
+            if ( xDetect.state_switch_cnt >= STRK_SWITCH_CNT )
+            {
+                xDetect.state = no_activity;
+                xPush(transition_valley, xDetect.peak_val, xDetect.peak_idx);
+                xPush(no_transition_activity, 0, index);
+            }
+            break;
+    }
+
+    xDetect.prev_val = curr;
+}
+
+// xRunTo() keeps room for a sample's transitions, the ring is never written over. With tracing on from
+// the CLI every transition and stroke is also a trace record.
+static void xPush(TransitionType type, int16_t val, int16_t index)
+{
+    strokeTransition_t * p_slot = &xRing[(xRingHead + xRingCount) & STRK_RING_MASK];
+
+    p_slot->type = type;
+    p_slot->val = val;
+    p_slot->idx = index;
+    xRingCount++;
+
+    HW_TRACE_3(TRACE_TRANSITION, type, val, index);
+}
+
+// The detectStrokes() loop, one transition at a time. The pairing keeps only the last transition.
+static void xPairAll(void)
+{
+    const strokeTransition_t * p_next;
+
+    while ( xRingCount > 0u )
+    {
+        p_next = &xRing[xRingHead];
+
+        //the first transition of a window moves the last one into its index range
+        if ( xJob.shiftLast == true )
+        {
+            xPair.last_transition.idx -= (int16_t)STRK_NEW_LEN;
+            xJob.shiftLast = false;
+        }
+
+        if ( xPair.last_transition.type != no_transition )
+        {
+            xStroke(&xPair.last_transition, p_next);
+        }
+
+        xPair.last_transition = *p_next;
+        xRingHead = (uint8_t)((xRingHead + 1u) & STRK_RING_MASK);
+        xRingCount--;
+    }
+}
+
+// A peak then a valley is the rod going up, a valley then a peak the rod going down
+static void xStroke(const strokeTransition_t * p_from, const strokeTransition_t * p_to)
+{
+    accumStrokeCount_t * p_accum = xJob.p_accum;
+    int16_t index;
+    int16_t percent;
+    bool dry;
+
+    if ( !(((p_from->type == transition_peak) && (p_to->type == transition_valley)) ||
+           ((p_from->type == transition_valley) && (p_to->type == transition_peak))) )
+    {
+        return;
+    }
+
+    index = (int16_t)(p_from->idx + p_to->idx) >> 1;
+    percent = xPercent(p_from->val, p_to->val);
+    dry = ((int32_T)index < (int32_T)xJob.presentStart) || ((uint16_T)index > xJob.presentStop);
+
+    HW_TRACE_3(TRACE_STROKE, index, percent, dry);
+
+    if ( percent < 0 )
+    {
+        percent = (int16_t)-percent;
+    }
+
+    if ( dry == true )
+    {
+        p_accum->dry_stroke_count_sum++;
+        p_accum->dry_percent_displacement_sum += percent;
+    }
+    else
+    {
+        p_accum->wet_stroke_count_sum++;
+        p_accum->wet_percent_displacement_sum += percent;
+    }
+
+    if ( xJob.strokes < UINT8_MAX )
+    {
+        xJob.strokes++;
+    }
+}
+
+// (from - to) * 100 / range, truncated toward zero and cut to 16 bits like the generated code, with
+// the divide done as a multiply by the reciprocal from xSetRange()
+static int16_t xPercent(int16_t from, int16_t to)
+{
+    int16_t diff = (int16_t)(from - to);
+    uint32_t n;
+    uint32_t q;
+
+    if ( xRecip == 0uL )
+    {
+        return 0;
+    }
+
+    n = ((diff < 0) ? (uint32_t)(-(int32_t)diff) : (uint32_t)diff) * 100uL;
+    q = (uint32_t)(((uint64_t)n * xRecip) >> xRecipShift);
+
+    return (diff < 0) ? (int16_t)(-(int32_t)q) : (int16_t)q;
+}
@@ -52,61 +52,6 @@ uint16_t APP_WTR_GetPadValue(APP_WTR_PAD_CHANNELS_T pad);
 
 void APP_WTR_CollectData(uint32_t ticks);
 
-uint32_t Stream_Records = 0;
-void StreamSensorData(APP_NVM_SENSOR_DATA_T * p_sensorData);
-
-void StreamSensorData(APP_NVM_SENSOR_DATA_T * p_sensorData)
-{
-    if (APP_CLI_BinaryData() == true)
-    {
-        uint8_t magic_val = 0xa5;
-        uC_UART_Tx((uint8_t *)&magic_val, 1);
-        uC_UART_Tx((uint8_t *)p_sensorData, sizeof(APP_NVM_SENSOR_DATA_T));
-    }
-    else
-    {
-        char str[100];
-
-        HW_TERM_Print("\n------------------------\n");
-        sprintf(str, "[RECORD %lu]\n", Stream_Records);
-        HW_TERM_Print((uint8_t *)str);
-        HW_TERM_Print("------------------------\n");
-
-        sprintf(str, "0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X,0x%02X,0x%02X,0x%02X, 0x%02X, ",
-                ((uint8_t)p_sensorData->timestamp),
-                ((uint8_t)(p_sensorData->timestamp>>8)),
-                ((uint8_t)(p_sensorData->timestamp>>16)),
-                ((uint8_t)(p_sensorData->timestamp>>24)),
-                ((uint8_t)p_sensorData->pads[0]),
-                ((uint8_t)(p_sensorData->pads[0]>>8)),
-                ((uint8_t)p_sensorData->pads[1]),
-                ((uint8_t)(p_sensorData->pads[1]>>8)),
-                ((uint8_t)p_sensorData->pads[2]),
-                ((uint8_t)(p_sensorData->pads[2]>>8)),
-                ((uint8_t)p_sensorData->pads[3]),
-                ((uint8_t)(p_sensorData->pads[3]>>8)),
-                ((uint8_t)p_sensorData->pads[4]),
-                ((uint8_t)(p_sensorData->pads[4]>>8)),
-                ((uint8_t)p_sensorData->pads[5]),
-                ((uint8_t)(p_sensorData->pads[5]>>8)),
-                ((uint8_t)(p_sensorData->pads[5]>>8)),
-                ((uint8_t)p_sensorData->pads[6]),
-                ((uint8_t)(p_sensorData->pads[6]>>8)),
-                ((uint8_t)p_sensorData->pads[7]),
-                ((uint8_t)(p_sensorData->pads[7]>>8)),
-                p_sensorData->magnetometerX,
-                p_sensorData->magnetometerY,
-                p_sensorData->magnetometerZ,
-                p_sensorData->temp_c_raw,
-                ((uint8_t)p_sensorData->checksum));
-
-        HW_TERM_Print((uint8_t *)str);
-    }
-
-    Stream_Records++;
-}
-
-
 void APP_WTR_CollectData(uint32_t ticks)
 {
     APP_WTR_PADS_T i = APP_WTR_LOWEST_PAD;
@@ -129,17 +74,9 @@ void APP_WTR_CollectData(uint32_t ticks)
     //get latest magnetometer XYZ, temperature, and status register
     HW_MAG_GetLatestMagAndTempData(&sensorData.magnetometerX, &sensorData.magnetometerY, &sensorData.magnetometerZ, &sensorData.tempLsb, &sensorData.magStatBitFlags);
 
+    // When streaming, the raw pad and magnetometer samples go out as capture frames (APP_CAPTURE, "capture on")
     #ifndef STREAM_ENGINEERING_DATA
     APP_NVM_Custom_LogSensorData(&sensorData);
-    #else
-
-    // Compute the checksum that would have been computed by the NVM app had we been storing to NVM instead of streaming.
-    // That way we can still confirm the data without having to store to eeprom
-    sensorData.checksum = APP_NVM_ComputeChecksum((uint8_t *)&sensorData, (sizeof(APP_NVM_SENSOR_DATA_T)-1));
-
-    //send data out over UART
-    StreamSensorData(&sensorData);
-
     #endif// STREAM_ENGINEERING_DATA
 }
 #endif // ENGINEERING_DATA
@@ -50,6 +50,7 @@
 #define CALIB_BAD_PLACEMENT                 BIT_18
 
 extern void APP_ALGO_Init(void);
+extern void APP_ALGO_WarmStart(void);
 extern void APP_ALGO_wakeUpInit(void);
 extern void APP_ALGO_Nest(bool activeSampling);
 extern void APP_ALGO_updateHourlyFields(APP_NVM_SENSOR_DATA_T *sensorData, uint8_t hoursIdx);
@@ -0,0 +1,68 @@
+/**************************************************************************************************
+* \file     APP_CAPTURE.h
+* \brief    Engineering capture of the algorithm inputs over the terminal UART
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef APP_INC_APP_CAPTURE_H_
+#define APP_INC_APP_CAPTURE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "algo-c-code/writePadSample/writePadSample_types.h"
+#include "algo-c-code/writeMagSample/writeMagSample_types.h"
+
+// One frame per algorithm tick, mixed in with the terminal text and trace records. Multi byte fields
+// are little endian.
+//
+//      0x1F | length | sequence | flags | body | CRC16
+//
+// The length counts sequence, flags and body. The CRC is CRC-16/CCITT-FALSE over length through the
+// end of the body. The flags say whether the body is a key frame and carry the sampling state:
+//
+//      key frame:      tick (4) | 12 channels (2 each) | magnetometer status (1)
+//      delta frame:    tick delta (1) | changed mask (2) | changed channels | status (1, if changed)
+//
+// The channels are pad1 - pad8 in algorithm order, then magnetometer x, y, z and temperature. A delta
+// frame sends the channels whose bit is set in the mask as the zigzag varint (7 bits per byte, low
+// first) of the difference from the previous frame. Mask bit 12 means the status changed.
+//
+// Frames never wait for the UART. A frame that does not fit is dropped, the sequence number still
+// counts it and the next frame is a key frame, so the host sees exactly what was lost. There is a key
+// frame every second anyway so a capture can be picked up at any point.
+// Firmware/ssm/tools/ssm_capture.py turns a capture into a CSV file.
+#define APP_CAPTURE_SYNC                0x1Fu
+#define APP_CAPTURE_NUM_CHANNELS        12u
+
+#define APP_CAPTURE_FLAG_KEY            0x80u
+#define APP_CAPTURE_FLAG_ACTIVE         0x01u       // activeSampling for the tick
+#define APP_CAPTURE_FLAG_STROKES        0x02u       // stroke detection on, the magnetometer sample was used
+
+#define APP_CAPTURE_KEY_BODY_LEN        (4u + (2u * APP_CAPTURE_NUM_CHANNELS) + 1u)
+#define APP_CAPTURE_MAX_FRAME_LEN       (1u + 1u + 2u + APP_CAPTURE_KEY_BODY_LEN + 2u)
+
+extern void APP_CAPTURE_Start(void);
+extern void APP_CAPTURE_Stop(void);
+extern bool APP_CAPTURE_IsRunning(void);
+extern void APP_CAPTURE_AddSample(uint32_t tick, uint8_t flags, const padSample_t * p_pads, const magSample_t * p_mag);
+extern void APP_CAPTURE_Report(void);
+
+#endif /* APP_INC_APP_CAPTURE_H_ */
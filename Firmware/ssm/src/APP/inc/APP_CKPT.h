@@ -0,0 +1,55 @@
+/**************************************************************************************************
+* \file     APP_CKPT.h
+* \brief    Checkpoint of the converged algorithm state in FRAM, for a warm start after a reset
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef APP_INC_APP_CKPT_H_
+#define APP_INC_APP_CKPT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "algo-c-code/initializeWaterAlgorithm/initializeWaterAlgorithm_types.h"
+#include "algo-c-code/initializeMagCalibration/initializeMagCalibration_types.h"
+#include "algo-c-code/initializeStrokeAlgorithm/initializeStrokeAlgorithm_types.h"
+#include "algo-c-code/computePumpHealth/computePumpHealth_types.h"
+
+// The water and magnetometer calibration, the pump usage history, the hourly totals and the last pump
+// health result, the state that takes the algorithm minutes to hours to build back up. Two records
+// alternate in FRAM, each with a sequence number and a CRC16 over the whole record, so a reset in
+// the middle of a save leaves the previous one good.
+//
+// A record is only used if its version and length match this build. Bump APP_CKPT_VERSION whenever
+// the generated algorithm code changes one of these structures without changing its size.
+#define APP_CKPT_VERSION            2u
+
+extern bool APP_CKPT_Save(const waterAlgoData_t * p_algoData, const waterCalibration_t * p_waterCalibration,
+                          const magCalibration_t * p_magCalibration, const pumpUsage_t * p_pumpUsage,
+                          const accumStrokeCount_t * p_strokeCount, const hourlyPumpHealthInfo_t * p_pumpHealth,
+                          uint32_t epoch);
+extern bool APP_CKPT_Load(waterAlgoData_t * p_algoData, waterCalibration_t * p_waterCalibration,
+                          magCalibration_t * p_magCalibration, pumpUsage_t * p_pumpUsage,
+                          accumStrokeCount_t * p_strokeCount, hourlyPumpHealthInfo_t * p_pumpHealth,
+                          uint32_t * p_epoch);
+extern void APP_CKPT_Clear(void);
+extern void APP_CKPT_Report(void);
+
+#endif /* APP_INC_APP_CKPT_H_ */
@@ -0,0 +1,43 @@
+/**************************************************************************************************
+* \file     APP_MAG.h
+* \brief    Magnetometer sampling scheduler (active / idle)
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef APP_INC_APP_MAG_H_
+#define APP_INC_APP_MAG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+    APP_MAG_ACTIVE,     // data ready interrupt, one read per 50ms algorithm tick
+    APP_MAG_IDLE,       // 10Hz low power threshold interrupt, no reads, samples are held
+} app_mag_state_t;
+
+extern void APP_MAG_Reset(void);
+extern void APP_MAG_WindowProcessed(bool activityDetected, int16_t xLsb, int16_t yLsb, int16_t zLsb);
+extern void APP_MAG_Wake(void);
+extern app_mag_state_t APP_MAG_GetState(void);
+extern void APP_MAG_Report(void);
+
+#endif /* APP_INC_APP_MAG_H_ */
@@ -35,7 +35,7 @@ extern void APP_NVM_ReadCurrentEntry(uint8_t map_index, uint8_t * p_data_buffer)
 extern void APP_NVM_DefaultAll(void);
 extern void APP_NVM_DefaultSensorDataLogs(void);
 extern void APP_NVM_ReadSectionHeader(uint8_t map_index, APP_NVM_SECTION_HDR_T * p_hdr);
-extern void APP_NVM_ReadBytes(uint16_t addr, uint16_t num_bytes, uint8_t * p_bytes);
+extern bool APP_NVM_ReadBytes(uint16_t addr, uint16_t num_bytes, uint8_t * p_bytes);
 extern uint8_t APP_NVM_ComputeChecksum(uint8_t * p_data, uint16_t num_bytes);
 extern void APP_NVM_DefaultSection(uint8_t map_index);
 
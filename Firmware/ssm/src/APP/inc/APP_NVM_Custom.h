@@ -52,6 +52,9 @@ extern bool APP_NVM_GetSensorData(APP_NVM_SENSOR_DATA_T *sensorData);
 extern void APP_NVM_Custom_IndicateBufferFull(bool bufferIsFull);
 extern bool APP_NVM_Custom_GetBufferFullFlag(void);
 extern void APP_NVM_SensorDataMsgAcked(void);
+extern void APP_NVM_Custom_StartSensorDataPrefetch(void);
+extern void APP_NVM_Custom_StopSensorDataPrefetch(void);
+extern void APP_NVM_Custom_PrefetchSensorData(void);
 
 extern uint8_t APP_NVM_Custom_GetRtcTimeStatus(void);
 extern bool APP_NVM_Custom_WriteRtcTimeStatus(uint8_t status);
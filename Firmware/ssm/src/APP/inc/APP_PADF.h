@@ -0,0 +1,38 @@
+/**************************************************************************************************
+* \file     APP_PADF.h
+* \brief    Water pad filters, run over all of the pads in one loop
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef APP_INC_APP_PADF_H_
+#define APP_INC_APP_PADF_H_
+
+#include "algo-c-code/waterPadFiltering/waterPadFiltering_types.h"
+
+// Same outputs, bit for bit, as the generated waterPadFiltering() and the add_to_buffer() step of
+// calculateWaterVolume(), which unroll the same arithmetic once per pad. The history is kept in the
+// generated padFilteringData_t as a ring instead of being shifted down every sample, so buffer_idx
+// counts 0 to 5 while it fills (as before) and then holds the ring position, see APP_PADF.c. State
+// made by the generated init and reset functions (buffer_idx 0, all zero) is a good empty state.
+extern void APP_PADF_Smooth(const padSample_t * p_sample, padFilteringData_t * p_data, padSample_t * p_filtered);
+extern void APP_PADF_Delta(const padSample_t * p_sample, padFilteringData_t * p_data, padSample_t * p_delta);
+
+#endif /* APP_INC_APP_PADF_H_ */
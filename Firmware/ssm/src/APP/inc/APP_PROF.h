@@ -0,0 +1,87 @@
+/**************************************************************************************************
+* \file     APP_PROF.h
+* \brief    Execution time profile of the background loop and the algorithm stages
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef APP_INC_APP_PROF_H_
+#define APP_INC_APP_PROF_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A stage is bracketed with APP_PROF_Begin() and APP_PROF_End(), which read the microsecond counter
+// (uC_TIME_GetMicroseconds) and keep min, max, mean and a histogram per stage. Times are in us, anything
+// over about 60 ms is counted as APP_PROF_SATURATED. The counter stops in LPM3, a stage is timed while
+// the CPU is awake (LPM0 waits count).
+//
+// Histogram buckets (us): <16, <64, <256, <1024, <4096, <16384, longer, saturated
+#define APP_PROF_NUM_BUCKETS        8u
+#define APP_PROF_SATURATED          UINT16_MAX
+
+// X(stage, name)
+#define APP_PROF_STAGES(X) \
+    X(PROF_LOOP,                "loop") \
+    X(PROF_CAPT_HANDLER,        "CAPT_appHandler") \
+    X(PROF_CLI_PERIODIC,        "APP_CLI_Periodic") \
+    X(PROF_ASP_PERIODIC,        "ASP_SSM_Periodic") \
+    X(PROF_MAG_MONITOR,         "HW_MAG_Monitor") \
+    X(PROF_APP_PERIODIC,        "APP_periodic") \
+    X(PROF_ALGO_NEST,           "APP_ALGO_Nest") \
+    X(PROF_GET_SAMPLES,         "xGetLatestSamples") \
+    X(PROF_PAD_FILTERING,       "waterPadFiltering") \
+    X(PROF_WATER_VOLUME,        "calculateWaterVolume") \
+    X(PROF_MAG_CALIBRATION,     "magnetometerCalibration") \
+    X(PROF_STROKE_ACCEPT,       "APP_STRK_AcceptWindow") \
+    X(PROF_STROKE_RUN,          "APP_STRK_Run")
+
+#define APP_PROF_ENUM_ENTRY(stage, name)        stage,
+
+typedef enum
+{
+    APP_PROF_STAGES(APP_PROF_ENUM_ENTRY)
+    PROF_STAGE_COUNT
+}appProfStage_t;
+
+typedef struct
+{
+    uint16_t us;
+    uint16_t ticks;         // low bits of the 10 ms runtime ticks, to catch a counter wrap
+}appProfStamp_t;
+
+typedef struct
+{
+    uint16_t count;         // halved along with sum when it fills, the mean stays recent
+    uint16_t min;
+    uint16_t max;
+    uint32_t sum;
+    uint16_t buckets[APP_PROF_NUM_BUCKETS];     // all halved when one fills
+}appProfStats_t;
+
+extern void APP_PROF_Reset(void);
+extern appProfStamp_t APP_PROF_Begin(void);
+extern void APP_PROF_End(appProfStage_t stage, appProfStamp_t start);
+extern void APP_PROF_Add(appProfStage_t stage, uint16_t us);
+extern const appProfStats_t * APP_PROF_GetStats(appProfStage_t stage);
+extern uint16_t APP_PROF_GetMean(appProfStage_t stage);
+extern void APP_PROF_Report(void);
+
+#endif /* APP_INC_APP_PROF_H_ */
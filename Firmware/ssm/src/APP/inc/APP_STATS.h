@@ -0,0 +1,41 @@
+/**************************************************************************************************
+* \file     APP_STATS.h
+* \brief    Streaming daily usage statistics and breakdown (red flag) detection
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef APP_INC_APP_STATS_H_
+#define APP_INC_APP_STATS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define APP_STATS_DAYS_PER_WEEK             7
+
+extern void APP_STATS_Reset(void);
+extern void APP_STATS_SetThresholds(uint16_t onThreshold, uint16_t offThreshold);
+extern bool APP_STATS_UpdateDaily(uint16_t dailyLiters, uint16_t *avgLiters);
+extern void APP_STATS_LearnDay(uint16_t dailyLiters);
+extern uint8_t APP_STATS_GetDayOfWeek(void);
+extern bool APP_STATS_IsBaselineReady(void);
+extern bool APP_STATS_IsRedFlagSet(void);
+
+#endif /* APP_INC_APP_STATS_H_ */
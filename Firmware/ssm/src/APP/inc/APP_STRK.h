@@ -0,0 +1,49 @@
+/**************************************************************************************************
+* \file     APP_STRK.h
+* \brief    Streaming stroke detection, transitions and strokes a few samples at a time
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef APP_INC_APP_STRK_H_
+#define APP_INC_APP_STRK_H_
+
+#include <stdbool.h>
+#include "algo-c-code/initializeStrokeAlgorithm/initializeStrokeAlgorithm_types.h"
+#include "algo-c-code/magnetometerCalibration/magnetometerCalibration_types.h"
+
+// Does the work of the generated detectTransitions() and detectStrokes() with the same results, but
+// spread out. A window is handed over with APP_STRK_AcceptWindow() right after its calibration, then
+// APP_STRK_Run() goes through its new samples a couple per nest run. Each sample's transitions go
+// through a small ring to the stroke pairing and each stroke goes straight into the accumulated
+// counts, so there is no per window limit and no stroke is dropped. APP_STRK_Run() always reads a
+// sample before writeMagSample() writes over it. APP_STRK_Drain() finishes the window now, before the
+// counts are read out or the windows are reset.
+extern void APP_STRK_Reset(accumStrokeCount_t * p_accum);
+extern void APP_STRK_AcceptWindow(const magWindows_t * p_windows, const magCalibration_t * p_calib,
+                                  const waterAlgoData_t * p_water, accumStrokeCount_t * p_accum);
+extern void APP_STRK_Run(void);
+extern void APP_STRK_Drain(void);
+
+// Stroke activity for the magnetometer sampling scheduler, true if the detector is in a stroke or the
+// last window it finished had strokes
+extern bool APP_STRK_IsActive(void);
+
+#endif /* APP_INC_APP_STRK_H_ */
@@ -30,6 +30,8 @@
 #include "HW_MAG.h"
 #include "HW_EEP.h"
 #include "HW_GPIO.h"
+#include "HW_OWI.h"
+#include "uC_UART.h"
 #include <msp430.h>                      // Generic MSP430 Device Include
 #include "driverlib.h"                   // MSPWare Driver Library
 #include "am-ssm-spi-protocol.h"
@@ -48,6 +50,7 @@ void HW_Init(void)
     HW_RTC_Init();
     HW_EEP_Init();
     HW_GPIO_Init();
+    HW_OWI_Init();
     HW_FUEL_GAUGE_Initialize();
 }
 
@@ -55,6 +58,7 @@ void HW_Init(void)
 void HW_PerformSwReset(void)
 {
     HW_TERM_Print("HW: Commanded reset.\n\n");
+    uC_UART_Flush();
     APP_NVM_Custom_WriteResetState(STATE_SWR);
     WDTCTL = 0xFFFF;
 }
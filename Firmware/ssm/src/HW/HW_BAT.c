@@ -31,6 +31,7 @@
 #include "HW_TERM.h"
 #include "uC_ADC.h"
 #include "HW_BAT.h"
+#include "HW_OWI.h"
 
 //------------------------------------------------------------------------------
 // Single-wire commands Registers
@@ -55,25 +56,6 @@
 #define READ_ZERO_MAX_VALUE     0xFE
 #define READ_ONE_VALUE          0xFF
 
-// Timer clock frequency (MHz)
-#define CLKFREQ                 16u
-
-//------------------------------------------------------------------------------
-// Define Single-wire Protocol Related Timing Constants
-//------------------------------------------------------------------------------
-#define RESET_LOW               (500 * CLKFREQ)            // Set line low (500us)
-#define RESET_DETECT            (80 * CLKFREQ)             // Reset detect (80us)
-#define RESET_DELAY             (360 * CLKFREQ)            // Reset delay (280us)
-
-#define WRITE_ONE               (6 * CLKFREQ)              // Write byte 1 (6us)
-#define DELAY_ONE               (64 * CLKFREQ)             // Write delay 1 (64us)
-#define WRITE_ZERO              (60 * CLKFREQ)             // Write byte 0 (60us)
-#define DELAY_ZERO              (10 * CLKFREQ)             // Write delay 0 (10us)
-
-#define READ_LOW                (6 * CLKFREQ)              // Set line low (6us)
-#define READ_DETECT             (9 * CLKFREQ)              // Slave response (9us)
-#define READ_DELAY              (55 * CLKFREQ)             // Slave release (55us)
-
 //FUEL GAUGE SPECIFIC:
 #define DS2740U_PICO_V_PER_CURR_LSB     1562500 //1.5625uV
 #define DS2740U_PICO_V_HR_PER_ACR_LSB   6250000 //6.250uV
@@ -122,8 +104,17 @@ typedef enum
     OWI_SUCCESS,
     OWI_INVALID_PARAMS,
     OWI_NO_DEVICE_DETECTED,
+    OWI_BUSY,
 }owiStatus_t;
 
+typedef enum
+{
+    GAUGE_INIT_IDLE,
+    GAUGE_INIT_READ_ROM,
+    GAUGE_INIT_WRITE_STATUS,
+    GAUGE_INIT_READ_STATUS,
+}gaugeInitStep_t;
+
 typedef struct
 {
     uint8_t netAddrCmd;
@@ -133,65 +124,105 @@ typedef struct
     uint8_t data1;
 }__attribute__((packed)) fuelGaugeOwiTxData_t;
 
-static uint8_t rxDataByte;
 static uint8_t printBuffer[25];
 static uint8_t fuelGaugeId[SERIAL_NUM_LEN];
 static bool isBatteryCriticallyLow = false;
 static uint16_t latestBatteryVoltageMv = 0u;
+static gaugeInitStep_t gaugeInitStep = GAUGE_INIT_IDLE;
+static fuelGaugeOwiTxData_t gaugeInitTxData;
+static uint8_t gaugeInitStatusRegVal;
 
-static void xSingleReset(void);
-static void xSingleWrite(uint8_t);
-static uint8_t xSingleRead(void);
-static void sortVoltages(uint16_t *arrayOfVoltages , uint8_t length);
+static void xInsertVoltage(uint16_t sortedVoltages[], uint8_t count, uint16_t voltage);
 static uint16_t findVoltageMedian(uint16_t arrayOfVoltages[] , uint8_t length);
 static owiStatus_t xOwiWriteRead(uint8_t* txData, uint8_t txLen, uint8_t* rxData, uint8_t rxLen);
 static fuelGaugeStatus_t xReadRegister(uint8_t addr, uint8_t* data, uint8_t len);
 static fuelGaugeStatus_t xWriteRegister(uint8_t addr, uint8_t* data, uint8_t len);
+static void xGaugeInitStep(hwOwiResult_t result);
 
+// Read the serial number and put the fuel gauge to sleep. This runs in the background, each step is
+// started from the completion callback of the one before it.
 fuelGaugeStatus_t HW_FUEL_GAUGE_Initialize(void)
 {
-    GPIO_setAsOutputPin(GPIO_PORT_P2, GPIO_PIN2);
-    GPIO_setOutputHighOnPin(GPIO_PORT_P2, GPIO_PIN2);
-
-    uint8_t statusRegVal = 0;
-    uint8_t idByte = 0;
-
-    xSingleReset();
-    xSingleWrite(READ_ROM);
+    static const uint8_t readRomCmd = READ_ROM;
 
     //read the ID on power up and save it
-    for(idByte = 0; idByte<SERIAL_NUM_LEN; idByte++)
+    if ( HW_OWI_Start(&readRomCmd, 1, fuelGaugeId, SERIAL_NUM_LEN, xGaugeInitStep) != HW_OWI_SUCCESS )
     {
-        fuelGaugeId[idByte] = xSingleRead();
+        HW_TERM_Print("\r\nFuel Gauge busy");
+        return GAUGE_OWI_ERROR;
     }
 
-    //PUT FUEL GAUGE INTO SLEEP MODE:
+    gaugeInitStep = GAUGE_INIT_READ_ROM;
 
-    //enable sleep in the status register
-    statusRegVal |= (BIT6);
-    HW_FUEL_GAUGE_WriteStatusReg(statusRegVal);
+    return GAUGE_SUCCESS;
+}
 
-    statusRegVal=0xFF;
-    __delay_cycles(RESET_LOW);
+// Completion callback for each step of HW_FUEL_GAUGE_Initialize(), called from HW_OWI_Monitor()
+static void xGaugeInitStep(hwOwiResult_t result)
+{
+    gaugeInitStep_t step = gaugeInitStep;
 
-    //read it back
-    HW_FUEL_GAUGE_ReadStatusReg(&statusRegVal);
+    gaugeInitStep = GAUGE_INIT_IDLE;
 
-    if ( statusRegVal & BIT6 )
+    if ( result != HW_OWI_SUCCESS )
     {
-        HW_TERM_Print("\r\nFuel Gauge Sleep Mode Enabled\r\n");
+        HW_TERM_Print("\r\nFuel Gauge not detected");
+        step = GAUGE_INIT_IDLE;
     }
-    else
+
+    switch ( step )
     {
-        HW_TERM_Print("\r\nFuel Gauge Sleep NOT Enabled");
-        sprintf((char *)printBuffer, "\r\n reg: 0x%X", statusRegVal);
-        HW_TERM_Print(printBuffer);
+        case GAUGE_INIT_READ_ROM:
+        {
+            //PUT FUEL GAUGE INTO SLEEP MODE:
+
+            //enable sleep in the status register
+            gaugeInitTxData.netAddrCmd = SKIP_NET_ADDR_CMD;
+            gaugeInitTxData.functCmd = WRITE_DATA_CMD;
+            gaugeInitTxData.addr = STATUS_REG_ADDR;
+            gaugeInitTxData.data0 = STATUS_REG_SMOD_MASK;
+            if ( HW_OWI_Start((uint8_t*)&gaugeInitTxData, 3+STATUS_REG_LEN, NULL, 0, xGaugeInitStep) == HW_OWI_SUCCESS )
+            {
+                gaugeInitStep = GAUGE_INIT_WRITE_STATUS;
+            }
+            break;
+        }
+        case GAUGE_INIT_WRITE_STATUS:
+        {
+            //read it back
+            gaugeInitTxData.functCmd = READ_DATA_CMD;
+            gaugeInitStatusRegVal = 0xFF;
+            if ( HW_OWI_Start((uint8_t*)&gaugeInitTxData, 3, &gaugeInitStatusRegVal, STATUS_REG_LEN, xGaugeInitStep) == HW_OWI_SUCCESS )
+            {
+                gaugeInitStep = GAUGE_INIT_READ_STATUS;
+            }
+            break;
+        }
+        case GAUGE_INIT_READ_STATUS:
+        {
+            if ( gaugeInitStatusRegVal & STATUS_REG_SMOD_MASK )
+            {
+                HW_TERM_Print("\r\nFuel Gauge Sleep Mode Enabled\r\n");
+            }
+            else
+            {
+                HW_TERM_Print("\r\nFuel Gauge Sleep NOT Enabled");
+                sprintf((char *)printBuffer, "\r\n reg: 0x%X", gaugeInitStatusRegVal);
+                HW_TERM_Print(printBuffer);
+            }
+            break;
+        }
+        default:
+        {
+            break;
+        }
     }
 
-    //CLEAR data line to put the fuel gauge to sleep
-    GPIO_setOutputLowOnPin(GPIO_PORT_P2, GPIO_PIN2);
-
-    return GAUGE_SUCCESS;
+    if ( gaugeInitStep == GAUGE_INIT_IDLE )
+    {
+        //CLEAR data line to put the fuel gauge to sleep
+        GPIO_setOutputLowOnPin(GPIO_PORT_P2, GPIO_PIN2);
+    }
 }
 
 void HW_FUEL_GAUGE_PrintSerialNumber(void)
@@ -240,12 +271,13 @@ void HW_BAT_TakeNewVoltageMeasurement(void)
     //Propagation delay from turning on the FET to reaching full voltage, allow a few hundred microseconds
     __delay_cycles(CYCLES_PROP_DELAY);
 
+   //samples go straight into their sorted place, so the median is ready as soon as the last one is in
    for ( idx = 0; idx < SAMPLES_PER_MEASUREMENT; idx++ )
    {
        voltageReading = uC_ADC_newConversionCh0();
 
        //Apply voltage divider math to the measurement
-       battVoltageMv[idx] = (voltageReading * BAT_VOLTAGE_DIVIDER_MULT) / BAT_VOLTAGE_DIVIDER_DIVISOR;
+       xInsertVoltage(battVoltageMv, idx, (voltageReading * BAT_VOLTAGE_DIVIDER_MULT) / BAT_VOLTAGE_DIVIDER_DIVISOR);
    }
 
     //disable FET to prevent excess current draw
@@ -253,8 +285,6 @@ void HW_BAT_TakeNewVoltageMeasurement(void)
 
     //now get the median - we do this instead of an average to prevent outliers
     //impacting the result since we know this could be noisy
-    sortVoltages((uint16_t*)&battVoltageMv, SAMPLES_PER_MEASUREMENT);
-
     medianVoltageMv = findVoltageMedian(battVoltageMv, SAMPLES_PER_MEASUREMENT);
 
     //update voltage with the median
@@ -268,23 +298,18 @@ void HW_BAT_TakeNewVoltageMeasurement(void)
     }
 }
 
-// function to sort the array in ascending order
-static void sortVoltages(uint16_t *arrayOfVoltages , uint8_t length)
+// Insert a sample into the first count (already sorted) entries, keeping them in ascending order
+static void xInsertVoltage(uint16_t sortedVoltages[], uint8_t count, uint16_t voltage)
 {
-    int i = 0 , j = 0 , temp = 0;
+    uint8_t idx = count;
 
-    for( i = 0; i < length; i++ )
+    while ( (idx > 0u) && (sortedVoltages[idx - 1u] > voltage) )
     {
-        for( j = 0; j < length-1; j++ )
-        {
-            if( arrayOfVoltages[j] > arrayOfVoltages[j+1] )
-            {
-                temp = arrayOfVoltages[j];
-                arrayOfVoltages[j] = arrayOfVoltages[j+1];
-                arrayOfVoltages[j+1] = temp;
-            }
-        }
+        sortedVoltages[idx] = sortedVoltages[idx - 1u];
+        idx--;
     }
+
+    sortedVoltages[idx] = voltage;
 }
 
 static uint16_t findVoltageMedian(uint16_t arrayOfVoltages[] , uint8_t length)
@@ -379,7 +404,7 @@ static fuelGaugeStatus_t xWriteRegister(uint8_t addr, uint8_t* data, uint8_t len
     owiTxData.functCmd = WRITE_DATA_CMD;
     owiTxData.addr = addr;
     owiTxData.data0 = data[0];
-    owiTxData.data1 = data[1];
+    owiTxData.data1 = (len > 1) ? data[1] : 0;
     owiStatus = xOwiWriteRead((uint8_t*)&owiTxData, 3+len, NULL, 0);
 
     if(owiStatus != OWI_SUCCESS)
@@ -419,87 +444,35 @@ fuelGaugeStatus_t HW_FUEL_GAUGE_WriteStatusReg(uint8_t data)
 
 static owiStatus_t xOwiWriteRead(uint8_t* txData, uint8_t txLen, uint8_t* rxData, uint8_t rxLen)
 {
-    uint32_t byteIdx;
+    owiStatus_t owiStatus = OWI_SUCCESS;
 
     if(txData==0 || txLen==0)
     {
         return OWI_INVALID_PARAMS;
     }
 
-    xSingleReset();
-
-    // Send each bit of data (LSb first) as a full byte of UART data
-    for(byteIdx=0; byteIdx<txLen; byteIdx++)
-    {
-
-       xSingleWrite(txData[byteIdx]);
-    }
-
-    if(rxData != 0 && rxLen != 0)
+    switch ( HW_OWI_Transfer(txData, txLen, rxData, rxLen) )
     {
-        memset(rxData, 0, rxLen); // Start with cleared data for bit-wise logic below to work
-        for(byteIdx=0; byteIdx<rxLen; byteIdx++)
+        case HW_OWI_SUCCESS:
         {
-            rxDataByte = xSingleRead();
-            rxData[byteIdx] = rxDataByte;
+            break;
         }
-    }
-
-    return OWI_SUCCESS;
-}
-
-
-static void xSingleReset(void)
-{
-    P2OUT &= (~BIT2);                           // P2.2 driven low
-    __delay_cycles(RESET_LOW);                  // Set delay
-    P2DIR = 0x00;                               // P2.2 input
-    P2OUT |=  BIT2;                             // select pull-up mode, 1
-    P2REN |= BIT2;                              // enable internal pull up, 1
-    __delay_cycles(RESET_DELAY);                // Set delay
-    P2OUT = BIT2;                               // Reset P2.2 to output high
-    P2DIR = BIT2;
-}
-
-static void xSingleWrite(uint8_t Data)
-{
-    uint8_t bit;                                // Initialize bit counter
-    for (bit = 0; bit < 8; bit++)               // Loop 8 bits to write a byte
-    {
-        P2OUT &= (~BIT2);                       // Set P2.2 low
-        if((Data >> bit) & 0x01)                // If bit is a 1
+        case HW_OWI_NO_DEVICE_DETECTED:
         {
-            __delay_cycles(WRITE_ONE);          // Set delay
-            P2OUT |= BIT2;                      // Set P2.2 back to high
-            __delay_cycles(DELAY_ONE);          // Set delay
+            owiStatus = OWI_NO_DEVICE_DETECTED;
+            break;
         }
-        else                                    // Else if a 0
+        case HW_OWI_BUSY:
         {
-            __delay_cycles(WRITE_ZERO);         // Set delay
-            P2OUT |= BIT2;                      // Set P2.2 back to high
-            __delay_cycles(DELAY_ZERO);         // Set delay
+            owiStatus = OWI_BUSY;
+            break;
+        }
+        default:
+        {
+            owiStatus = OWI_INVALID_PARAMS;
+            break;
         }
-    }
-}
-
-
-static uint8_t xSingleRead(void)
-{
-    uint8_t bit;                                // Initialize bit counter
-    uint8_t Data = 0;                           // Initialize return data byte
-    for (bit = 0; bit < 8; bit++)               // Loop 8 bits to read a byte
-    {
-        P2OUT &= (~BIT2);                       // P2.2 driven low
-        __delay_cycles(READ_LOW);               // Set delay
-        P2DIR = 0x00;                           // P2.2 input
-        P2OUT |=  BIT2;                         // select pull-up mode, 1
-        P2REN |= BIT2;                          // enable internal pull up, 1
-        __delay_cycles(READ_DETECT);            // Set delay
-        if(P2IN & BIT2) Data |= (0x01 << bit);  // If high then read 1, else 0
-        __delay_cycles(READ_DELAY);             // Set delay
-        P2OUT |= BIT2;                           // Reset P2.2 to output high
-        P2DIR = BIT2;
     }
 
-    return Data;
+    return owiStatus;
 }
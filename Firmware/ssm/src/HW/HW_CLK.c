@@ -0,0 +1,242 @@
+/**************************************************************************************************
+* \file     HW_CLK.c
+* \brief    Software epoch clock run from the uC_TIME seconds tick and disciplined by the M41T62 RTC
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "HW_CLK.h"
+#include "HW_RTC.h"
+#include "HW_TERM.h"
+#include "uC_TIME.h"
+
+// Reading the RTC costs 9 I2C register reads and a 35 ms mktime() call, so the epoch time is kept here
+// from the runtime seconds tick instead. The tick runs off the 32 kHz crystal like the RTC but not from
+// the same one (and its compare period is one cycle short), so it drifts by a few seconds a day. Once an
+// hour the RTC is read and the error is slewed out one second at a time, the clock never goes backwards
+// for drift. Only a set time or an RTC that was changed behind our back steps it.
+//
+// Both clocks only have whole seconds and their second boundaries are not lined up, so a single read
+// can be one second off either way. A one second error is only corrected if the next read agrees.
+
+#define DEBUG_STRLEN                80
+
+static bool xValid = false;
+static uint32_t xBaseEpoch = 0u;                // epoch time at xBaseRuntime
+static uint32_t xBaseRuntime = 0u;
+static int32_t xPendingSlew = 0;                // correction being slewed in since xBaseRuntime
+static int32_t xLastError = 0;
+static uint32_t xLastDisciplineRuntime = 0u;
+
+static uint16_t xStepCount = 0u;
+static uint16_t xDisciplineCount = 0u;
+static uint16_t xRtcFailCount = 0u;
+static uint32_t xSlewedSeconds = 0u;
+
+bool HW_CLK_Sync(void);
+bool HW_CLK_SetEpoch(uint32_t epoch_time);
+void HW_CLK_Monitor(void);
+uint32_t HW_CLK_GetEpochTime(void);
+uint32_t HW_CLK_GetSecondsSinceMidnight(void);
+void HW_CLK_GetHour(uint8_t * hour);
+void HW_CLK_GetSecToNextHour(uint16_t * secondsToNextHour);
+void HW_CLK_Report(void);
+
+static int32_t xAppliedSlew(uint32_t runtime);
+static uint32_t xLocalEpoch(uint32_t runtime);
+static void xStep(uint32_t epoch_time, uint32_t runtime);
+static void xDiscipline(uint32_t runtime);
+
+// Read the RTC and set the clock from it. Returns false if the RTC does not have a valid time.
+bool HW_CLK_Sync(void)
+{
+    uint32_t runtime = uC_TIME_GetRuntimeSeconds();
+    uint32_t rtcEpoch = HW_RTC_GetEpochTime();
+    bool validTime = false;
+
+    xLastDisciplineRuntime = runtime;
+
+    if ( rtcEpoch != 0u )
+    {
+        xStep(rtcEpoch, runtime);
+        validTime = true;
+    }
+    else
+    {
+        xRtcFailCount++;
+    }
+
+    return validTime;
+}
+
+// Set the RTC and step the clock to the new time
+bool HW_CLK_SetEpoch(uint32_t epoch_time)
+{
+    bool timeSet = HW_RTC_SetTimeEpoch(epoch_time);
+
+    if ( timeSet == true )
+    {
+        uint32_t runtime = uC_TIME_GetRuntimeSeconds();
+
+        xStep(epoch_time, runtime);
+        xLastDisciplineRuntime = runtime;
+    }
+
+    return timeSet;
+}
+
+// Periodic function, reads the RTC once every discipline period
+void HW_CLK_Monitor(void)
+{
+    uint32_t runtime = uC_TIME_GetRuntimeSeconds();
+
+    if ( (runtime - xLastDisciplineRuntime) >= HW_CLK_DISCIPLINE_PERIOD_SECS )
+    {
+        xDiscipline(runtime);
+    }
+}
+
+// Seconds since 1970, 0 if the RTC has never had a valid time
+uint32_t HW_CLK_GetEpochTime(void)
+{
+    uint32_t epoch = 0u;
+
+    if ( xValid == true )
+    {
+        epoch = xLocalEpoch(uC_TIME_GetRuntimeSeconds());
+    }
+
+    return epoch;
+}
+
+// The RTC is kept in UTC so the time of day falls straight out of the epoch time
+uint32_t HW_CLK_GetSecondsSinceMidnight(void)
+{
+    return (HW_CLK_GetEpochTime() % SEC_PER_DAY);
+}
+
+void HW_CLK_GetHour(uint8_t * hour)
+{
+    *hour = (uint8_t)(HW_CLK_GetSecondsSinceMidnight() / SEC_PER_HOUR);
+}
+
+// Same count as HW_RTC_GetSecToNextHour(), 3599 at the top of the hour
+void HW_CLK_GetSecToNextHour(uint16_t * secondsToNextHour)
+{
+    *secondsToNextHour = (uint16_t)((SEC_PER_HOUR - 1u) - (HW_CLK_GetSecondsSinceMidnight() % SEC_PER_HOUR));
+}
+
+void HW_CLK_Report(void)
+{
+    uint8_t str[DEBUG_STRLEN];
+    uint32_t runtime = uC_TIME_GetRuntimeSeconds();
+
+    sprintf((char *)str, "HW_CLK Epoch: 0x%lX, pending: %ld s, slewed: %lu s\n",
+            HW_CLK_GetEpochTime(), (xPendingSlew - xAppliedSlew(runtime)), (xSlewedSeconds + (uint32_t)labs(xAppliedSlew(runtime))));
+    HW_TERM_Print(str);
+
+    sprintf((char *)str, "HW_CLK steps: %u, RTC reads: %u, RTC failures: %u\n",
+            xStepCount, xDisciplineCount, xRtcFailCount);
+    HW_TERM_Print(str);
+}
+
+// Part of the pending correction that has been applied by this runtime. When slewing back the one second
+// taken off lands on the same tick as the runtime second, so the epoch time holds for one second.
+static int32_t xAppliedSlew(uint32_t runtime)
+{
+    int32_t slewed = (int32_t)((runtime - xBaseRuntime) / HW_CLK_SLEW_PERIOD_SECS);
+    int32_t applied = xPendingSlew;
+
+    if ( xPendingSlew > slewed )
+    {
+        applied = slewed;
+    }
+    else if ( xPendingSlew < -slewed )
+    {
+        applied = -slewed;
+    }
+
+    return applied;
+}
+
+static uint32_t xLocalEpoch(uint32_t runtime)
+{
+    return (xBaseEpoch + (runtime - xBaseRuntime) + (uint32_t)xAppliedSlew(runtime));
+}
+
+static void xStep(uint32_t epoch_time, uint32_t runtime)
+{
+    xBaseEpoch = epoch_time;
+    xBaseRuntime = runtime;
+    xPendingSlew = 0;
+    xLastError = 0;
+    xValid = true;
+
+    xStepCount++;
+}
+
+static void xDiscipline(uint32_t runtime)
+{
+    uint32_t rtcEpoch = HW_RTC_GetEpochTime();
+    int32_t error = 0;
+
+    xLastDisciplineRuntime = runtime;
+
+    if ( rtcEpoch == 0u )
+    {
+        //keep running on the tick and try again next period
+        xRtcFailCount++;
+    }
+    else if ( xValid == false )
+    {
+        xStep(rtcEpoch, runtime);
+    }
+    else
+    {
+        xDisciplineCount++;
+        error = (int32_t)(rtcEpoch - xLocalEpoch(runtime));
+
+        if ( (error >= HW_CLK_STEP_THRESHOLD_SECS) || (error <= -HW_CLK_STEP_THRESHOLD_SECS) )
+        {
+            HW_TERM_Print("HW_CLK: RTC moved, stepping\n");
+            xStep(rtcEpoch, runtime);
+        }
+        else
+        {
+            //restart the slew from here, whatever was not applied yet is part of the new error
+            xSlewedSeconds += (uint32_t)labs(xAppliedSlew(runtime));
+            xBaseEpoch = xLocalEpoch(runtime);
+            xBaseRuntime = runtime;
+
+            if ( (error > 1) || (error < -1) || ((error != 0) && (error == xLastError)) )
+            {
+                xPendingSlew = error;
+            }
+            else
+            {
+                xPendingSlew = 0;
+            }
+
+            xLastError = error;
+        }
+    }
+}
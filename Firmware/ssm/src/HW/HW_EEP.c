@@ -22,6 +22,7 @@
 *
 ***************************************************************************************************/
 
+#include <string.h>
 #include <msp430.h>                      // Generic MSP430 Device Include
 #include <uC/inc/uC_I2C.h>
 #include "driverlib.h"                   // MSPWare Driver Library
@@ -53,6 +54,7 @@ uint8_t HW_EEP_Write_Buf[HW_EEP_PAGE_LEN_BYTES + HW_EEP_ADDR_SIZE_BYTES];
 void HW_EEP_Init(void);
 void HW_EEP_DoTest(void);
 uint8_t HW_EEP_ReadByte(uint16_t addr);
+bool HW_EEP_ReadBlock(uint16_t addr, uint8_t * p_data, uint16_t num_bytes);
 void HW_EEP_WriteByte(uint16_t addr, uint8_t value);
 void HW_EEP_EraseAll(void);
 void HW_EEP_WriteBlock(uint16_t addr, uint8_t * p_values, uint8_t num_bytes);
@@ -125,6 +127,48 @@ uint8_t HW_EEP_ReadByte(uint16_t addr)
     return rx_data;
 }
 
+// Read a block of bytes from EEP with one address write and a sequential read.  The EEP streams out
+// consecutive bytes for as long as we keep clocking, so a block costs about one bus byte per data byte
+// instead of the five (address write plus read) HW_EEP_ReadByte() spends on each.
+bool HW_EEP_ReadBlock(uint16_t addr, uint8_t * p_data, uint16_t num_bytes)
+{
+    uint8_t cmd[HW_EEP_ADDR_SIZE_BYTES];
+    uint8_t retry = COMM_RETRIES;
+    bool stat = false;
+
+    if ( (p_data == NULL) || (num_bytes == 0) ) return false;
+
+    while ( retry > 0 && stat == false )
+    {
+        // "Dummy" write to set up address pointer.
+        cmd[HW_EEP_ADDR_MSB_POSITION] = ((uint8_t)(addr >> 8));
+        cmd[HW_EEP_ADDR_LSB_POSITION] = ((uint8_t)addr);
+
+        if (uC_I2C_WriteMulti(HW_EEP_SLAVE_ADDR, cmd, HW_EEP_ADDR_SIZE_BYTES, false) == true)    // Send it as a multi-byte transmission.
+        {
+            stat = uC_I2C_ReadMulti(HW_EEP_SLAVE_ADDR, p_data, num_bytes);
+
+            if ( stat == false )
+            {
+                HW_TERM_Print("HW_EEP: ERROR.  EEP read timed out.\n");
+            }
+        }
+        else
+        {
+            HW_TERM_Print("HW_EEP: ERROR.  Could not read EEP.\n");
+        }
+
+        retry--;
+    }
+
+    if ( stat == false )
+    {
+        HW_TERM_Print("HW_EEP: ERROR.  Could not read EEP - FAILED RETRIES .\n");
+        APP_indicateError(EEPROM_READ_ERROR);
+    }
+
+    return stat;
+}
 
 uint8_t BytesToEndOfPage(uint16_t addr)
 {
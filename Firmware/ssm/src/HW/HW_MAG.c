@@ -35,7 +35,7 @@
 #include "HW_MAG.h"
 
 #define READ_SIZE_BYTES         1
-#define WRITE_SIZE_BYTES        2
+#define WRITE_SIZE_BYTES        7       // register and the 6 hard iron offset bytes
 
 #define MAG_HANDLE_VALUE        1
 
@@ -50,6 +50,8 @@
 #define THRESH_TO_TRIGGER_LSB   35
 #define THRESH_TO_TRIGGER_MSB   0
 
+#define NEW_DATA_FLAGS_MASK     0x0F
+
 #define X_POSITION              0
 #define Y_POSITION              1
 #define Z_POSITION              2
@@ -92,6 +94,10 @@ static lis2mdl_status_reg_t statusReg = {};
 static uint32_t lastInterruptTime = 0u;
 static bool xMagnetometerSamplingInitialized = false;
 static bool xThresholdModeEnabled = false;
+static bool xNewSampleReady = false;
+static uint8_t xLatestSampleStatus = 0u;
+static bool xGoodSampleHeld = false;
+static uint32_t xSampleReadCount = 0u;
 
 /* init the magnetometer bus and read out the ID of the chip */
 void HW_MAG_InitBusAndDevice(void)
@@ -128,6 +134,9 @@ void HW_MAG_TurnOffSampling(void)
     xMagnetometerSamplingInitialized = false;
     xThresholdModeEnabled = false;
     dataRdy = false;
+    xNewSampleReady = false;
+    xLatestSampleStatus = 0u;
+    xGoodSampleHeld = false;
 
     //Set the magnetometer to do a reboot, which will start it up in IDLE mode
     //When putting the magnetometer into IDLE mode after its been sampling it
@@ -158,8 +167,9 @@ void HW_MAG_Monitor(void)
         }
         else
         {
-            //data is ready, pull the data from the magnetometer
-            xReadLatestSampleFromMag();
+            //data is ready, it is pulled from the magnetometer when the algorithm asks for
+            //its next sample so the bus only runs at the algorithm rate, not the ODR
+            xNewSampleReady = true;
         }
 
         //reset flag
@@ -213,9 +223,52 @@ static void xReadLatestSampleFromMag(void)
         /* read out the NEW magnetometer data */
         lis2mdl_magnetic_raw_get(&magControl, data_raw_magnetic.u8bit);
         lis2mdl_temperature_raw_get(&magControl, data_raw_temperature.u8bit);
+
+        //the ODR is faster than the algorithm rate so overruns are expected, only keep the new data flags
+        memcpy(&xLatestSampleStatus, &statusReg, sizeof(lis2mdl_status_reg_t));
+        xLatestSampleStatus &= NEW_DATA_FLAGS_MASK;
+
+        xGoodSampleHeld = true;
+    }
+}
+
+/* Called once per algorithm tick. Reads the magnetometer only if it has a new sample for us,
+ * otherwise the last good sample is held and reported with a status of 0. HW_MAG_IsSampleHeld()
+ * tells the caller whether there is one to repeat.
+ * */
+void HW_MAG_ReadSampleIfReady(void)
+{
+    xLatestSampleStatus = 0u;
+
+    if ( (xMagnetometerSamplingInitialized == true) && (xThresholdModeEnabled == false) )
+    {
+        //the data ready line stays high until the sample is read out, so if it is high without a
+        //flagged edge (new data landed while we were reading the last one) read it anyway
+        if ( (xNewSampleReady == true) ||
+             (GPIO_getInputPinValue(GPIO_PORT_P2, GPIO_PIN7) == GPIO_INPUT_PIN_HIGH) )
+        {
+            xNewSampleReady = false;
+            xReadLatestSampleFromMag();
+            xSampleReadCount++;
+
+            lastInterruptTime = uC_TIME_GetRuntimeSeconds();
+        }
     }
 }
 
+/* True once a sample has been read since sampling was last turned on, the held sample is from the
+ * magnetometer as it runs now and not from before it was turned off.
+ * */
+bool HW_MAG_IsSampleHeld(void)
+{
+    return xGoodSampleHeld;
+}
+
+uint32_t HW_MAG_GetSampleReadCount(void)
+{
+    return xSampleReadCount;
+}
+
 uint8_t HW_MAG_getID(void)
 {
     uint8_t magId = 0u;
@@ -254,13 +307,11 @@ void HW_MAG_GetLatestMagAndTempData(int16_t *xLsb, int16_t *yLsb, int16_t *zLsb,
         1 : yda
         2 : zda
         3 : zyxda - new data x y AND z
-        4 : _xor  - data overrun x
-        5 : yor
-        6 : zor
-        7:  zyxor - data overrun on x y AND z
+
+        Overrun flags are masked off, all 0 means the sample was held from a previous tick
     */
 
-    memcpy(bitFlags, &statusReg, sizeof(lis2mdl_status_reg_t));
+    *bitFlags = xLatestSampleStatus;
 }
 
 
@@ -334,6 +385,7 @@ void HW_MAG_EnableThresholdInterrupt(int16_t xAxisOffset, int16_t yAxisOffset, i
     xThresholdModeEnabled = true;
     xMagnetometerSamplingInitialized = false;
     dataRdy = false;
+    xNewSampleReady = false;
 
     //enable MSP interrupt on the pin
     GPIO_enableInterrupt(GPIO_PORT_P2, GPIO_PIN7);
@@ -387,6 +439,8 @@ void HW_MAG_InitSampleRateAndPowerModeOn(void)
 
     xMagnetometerSamplingInitialized = true;
     xThresholdModeEnabled = false;
+    xNewSampleReady = false;
+    lastInterruptTime = uC_TIME_GetRuntimeSeconds();
 }
 
 void HW_MAG_ChangeSampleRate(uint8_t rateInHz)
@@ -456,7 +510,7 @@ static int32_t xWriteToChip(void *handle, uint8_t reg, uint8_t *bufp,
 {
     int32_t stat = MAG_UNKNOWN;
 
-    if (handle == &magDeviceHandle)
+    if ( (handle == &magDeviceHandle) && (len < WRITE_SIZE_BYTES) )
     {
         /* Write multiple command */
         reg |= WRITE_READ_MULTIPLE_CMD;
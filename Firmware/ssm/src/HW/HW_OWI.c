@@ -0,0 +1,367 @@
+/**************************************************************************************************
+* \file     HW_OWI.c
+* \brief    Timer driven 1-wire master for the DS2740 fuel gauge on P2.2
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <msp430.h>
+#include "driverlib.h"                   // MSPWare Driver Library
+#include <stdint.h>
+#include "stdbool.h"
+#include "string.h"
+#include "HW_OWI.h"
+
+// A transaction is a reset/presence followed by a string of 70 us bit slots. Timer_A0 runs from SMCLK/16
+// (1 us per count) and CCR0 fires at every edge that is more than a few microseconds away, so the reset
+// and the write 0 low time cost nothing. Only the edges that have to be within a few microseconds of the
+// falling edge (release of a write 1, sample of a read) are done inline in the ISR, where nothing else can
+// stretch them. Every delay is measured from the edge that was just driven, so a late interrupt only makes
+// the time the line sits high longer, which the DS2740 does not care about.
+//
+// The write 0 low time is the one interval a late interrupt can stretch. It is 62 us and allowed to be
+// 120 us, no ISR in the SSM comes close to holding off another one for 58 us.
+
+// MCLK (MHz), for the inline delays
+#define CYCLES_PER_US               16u
+
+#define OWI_PORT_BIT                BIT2
+
+//------------------------------------------------------------------------------
+// 1-wire timing (us)
+//------------------------------------------------------------------------------
+#define RESET_LOW_US                500u        // master reset pulse
+#define PRESENCE_SAMPLE_US          70u         // DS2740 presence pulse starts 15-60 us after release
+#define RESET_DELAY_US              360u        // release to first slot
+#define SLOT_US                     70u         // falling edge to falling edge
+#define WRITE_ONE_LOW_US            6u
+#define WRITE_ZERO_LOW_US           62u         // 60 us minimum, the edge is read off the counter up to 1 us late
+#define READ_LOW_US                 6u
+#define READ_SAMPLE_US              9u          // after the release, slave data is valid up to 15 us after the falling edge
+
+// Never arm the compare closer than this to the counter, it would be missed and fire a whole timer wrap later
+#define MIN_LEAD_US                 4u
+
+typedef enum
+{
+    OWI_IDLE,
+    OWI_RESET_LOW,
+    OWI_PRESENCE,
+    OWI_SLOT,
+    OWI_WRITE_ZERO_LOW,
+}owiState_t;
+
+static volatile owiState_t xState = OWI_IDLE;
+static volatile bool xDone = false;
+static volatile hwOwiResult_t xResult = HW_OWI_SUCCESS;
+static hwOwiCallback_t xCallback = NULL;
+
+static const uint8_t * xTxData = NULL;
+static uint8_t * xRxData = NULL;
+static uint8_t xTxLen = 0u;
+static uint8_t xRxLen = 0u;
+static uint8_t xByteIdx = 0u;
+static uint8_t xBitIdx = 0u;
+
+void HW_OWI_Init(void);
+hwOwiResult_t HW_OWI_Start(const uint8_t * txData, uint8_t txLen, uint8_t * rxData, uint8_t rxLen, hwOwiCallback_t callback);
+hwOwiResult_t HW_OWI_Transfer(const uint8_t * txData, uint8_t txLen, uint8_t * rxData, uint8_t rxLen);
+bool HW_OWI_IsBusy(void);
+void HW_OWI_Monitor(void);
+
+static inline void xLineLow(void);
+static inline void xLineHigh(void);
+static inline void xLineRelease(void);
+static void xScheduleFrom(uint16_t edge, uint16_t delay_us);
+static void xFinish(hwOwiResult_t result);
+static void xStartSlot(void);
+
+void HW_OWI_Init(void)
+{
+    // Idle with the line driven high, the fuel gauge sleeps when it is held low
+    P2OUT |= OWI_PORT_BIT;
+    P2DIR |= OWI_PORT_BIT;
+    P2REN |= OWI_PORT_BIT;
+
+    Timer_A_initContinuousModeParam initContParam = {0};
+    initContParam.clockSource = TIMER_A_CLOCKSOURCE_SMCLK;
+    initContParam.clockSourceDivider = TIMER_A_CLOCKSOURCE_DIVIDER_16;
+    initContParam.timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_DISABLE;
+    initContParam.timerClear = TIMER_A_DO_CLEAR;
+    initContParam.startTimer = false;
+    Timer_A_initContinuousMode(TIMER_A0_BASE, &initContParam);
+
+    xState = OWI_IDLE;
+    xDone = false;
+}
+
+// Start a reset, txLen bytes out and rxLen bytes in. The buffers belong to the engine until the callback
+// is called (from HW_OWI_Monitor), the callback may be NULL.
+hwOwiResult_t HW_OWI_Start(const uint8_t * txData, uint8_t txLen, uint8_t * rxData, uint8_t rxLen, hwOwiCallback_t callback)
+{
+    uint16_t edge;
+
+    if ( (txData == NULL) || (txLen == 0u) || ((rxData == NULL) && (rxLen != 0u)) )
+    {
+        return HW_OWI_INVALID_PARAMS;
+    }
+
+    // a finished transaction has to be handed back before the next one starts
+    if ( (xState != OWI_IDLE) || (xDone == true) )
+    {
+        return HW_OWI_BUSY;
+    }
+
+    if ( rxLen != 0u )
+    {
+        memset(rxData, 0, rxLen);
+    }
+
+    xTxData = txData;
+    xTxLen = txLen;
+    xRxData = rxData;
+    xRxLen = rxLen;
+    xByteIdx = 0u;
+    xBitIdx = 0u;
+    xCallback = callback;
+    xResult = HW_OWI_SUCCESS;
+
+    Timer_A_clear(TIMER_A0_BASE);
+    Timer_A_startCounter(TIMER_A0_BASE, TIMER_A_CONTINUOUS_MODE);
+
+    xState = OWI_RESET_LOW;
+    xLineLow();
+    edge = TA0R;
+    xScheduleFrom(edge, RESET_LOW_US);
+    TA0CCTL0 = CCIE;
+
+    return HW_OWI_SUCCESS;
+}
+
+// Blocking transfer for callers that need the answer right away (init, CLI). Sleeps in LPM0 so the
+// interrupts keep being serviced while the transaction runs.
+hwOwiResult_t HW_OWI_Transfer(const uint8_t * txData, uint8_t txLen, uint8_t * rxData, uint8_t rxLen)
+{
+    hwOwiResult_t result = HW_OWI_Start(txData, txLen, rxData, rxLen, NULL);
+
+    if ( result == HW_OWI_SUCCESS )
+    {
+        __disable_interrupt();
+        while ( xState != OWI_IDLE )
+        {
+            __bis_SR_register(LPM0_bits | GIE);
+            __disable_interrupt();
+        }
+        __enable_interrupt();
+
+        result = xResult;
+        xDone = false;
+    }
+
+    return result;
+}
+
+bool HW_OWI_IsBusy(void)
+{
+    return (xState != OWI_IDLE);
+}
+
+// Periodic function, hands a finished background transaction to its owner
+void HW_OWI_Monitor(void)
+{
+    hwOwiCallback_t callback = xCallback;
+
+    if ( xDone == true )
+    {
+        xDone = false;
+        xCallback = NULL;
+
+        if ( callback != NULL )
+        {
+            callback(xResult);
+        }
+    }
+}
+
+static inline void xLineLow(void)
+{
+    P2OUT &= (~OWI_PORT_BIT);
+    P2DIR |= OWI_PORT_BIT;
+}
+
+static inline void xLineHigh(void)
+{
+    P2OUT |= OWI_PORT_BIT;
+    P2DIR |= OWI_PORT_BIT;
+}
+
+// input with the pull-up, the slave can pull it low
+static inline void xLineRelease(void)
+{
+    P2DIR &= (~OWI_PORT_BIT);
+    P2OUT |= OWI_PORT_BIT;
+}
+
+static void xScheduleFrom(uint16_t edge, uint16_t delay_us)
+{
+    uint16_t next = edge + delay_us;
+
+    if ( (int16_t)(next - TA0R) < (int16_t)MIN_LEAD_US )
+    {
+        next = TA0R + MIN_LEAD_US;
+    }
+
+    TA0CCR0 = next;
+}
+
+static void xFinish(hwOwiResult_t result)
+{
+    xLineHigh();
+
+    TA0CCTL0 = 0u;
+    Timer_A_stop(TIMER_A0_BASE);
+
+    xResult = result;
+    xState = OWI_IDLE;
+    xDone = true;
+}
+
+// Drive the next bit slot, or finish if all of them are done
+static void xStartSlot(void)
+{
+    uint16_t edge;
+    uint8_t mask = (uint8_t)(0x01u << xBitIdx);
+
+    if ( xByteIdx >= (uint8_t)(xTxLen + xRxLen) )
+    {
+        xFinish(HW_OWI_SUCCESS);
+        return;
+    }
+
+    if ( xByteIdx < xTxLen )
+    {
+        if ( xTxData[xByteIdx] & mask )
+        {
+            xLineLow();
+            edge = TA0R;
+            __delay_cycles(WRITE_ONE_LOW_US * CYCLES_PER_US);
+            xLineHigh();
+        }
+        else
+        {
+            xLineLow();
+            edge = TA0R;
+            xState = OWI_WRITE_ZERO_LOW;
+        }
+    }
+    else
+    {
+        xLineLow();
+        edge = TA0R;
+        __delay_cycles(READ_LOW_US * CYCLES_PER_US);
+        xLineRelease();
+        __delay_cycles(READ_SAMPLE_US * CYCLES_PER_US);
+
+        if ( P2IN & OWI_PORT_BIT )
+        {
+            xRxData[xByteIdx - xTxLen] |= mask;
+        }
+    }
+
+    xScheduleFrom(edge, (xState == OWI_WRITE_ZERO_LOW) ? WRITE_ZERO_LOW_US : SLOT_US);
+
+    xBitIdx++;
+    if ( xBitIdx >= 8u )
+    {
+        xBitIdx = 0u;
+        xByteIdx++;
+    }
+}
+
+//******************************************************************************
+//
+//This is the TIMER0_A0 interrupt vector service routine.
+//
+//******************************************************************************
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(TIMER0_A0_VECTOR)))
+#endif
+void TIMER0_A0_ISR (void)
+{
+    uint16_t edge;
+
+    switch ( xState )
+    {
+        case OWI_RESET_LOW:
+        {
+            // latch the falling edge of the presence pulse in P2IFG (the pin interrupt stays disabled), so a
+            // late sample can't miss a short one
+            P2IES |= OWI_PORT_BIT;
+            P2IFG &= (~OWI_PORT_BIT);
+            xLineRelease();
+            edge = TA0R;
+            xState = OWI_PRESENCE;
+            xScheduleFrom(edge, PRESENCE_SAMPLE_US);
+            break;
+        }
+        case OWI_PRESENCE:
+        {
+            if ( ((P2IFG & OWI_PORT_BIT) == 0u) && (P2IN & OWI_PORT_BIT) )
+            {
+                // nobody pulled the line low
+                xFinish(HW_OWI_NO_DEVICE_DETECTED);
+            }
+            else
+            {
+                // the first slot starts RESET_DELAY_US after the release, which was PRESENCE_SAMPLE_US before this compare
+                xState = OWI_SLOT;
+                xScheduleFrom(TA0CCR0, (RESET_DELAY_US - PRESENCE_SAMPLE_US));
+            }
+            break;
+        }
+        case OWI_WRITE_ZERO_LOW:
+        {
+            // the slot was counted when it started, only the recovery is left
+            xLineHigh();
+            edge = TA0R;
+            xState = OWI_SLOT;
+            xScheduleFrom(edge, (SLOT_US - WRITE_ZERO_LOW_US));
+            break;
+        }
+        case OWI_SLOT:
+        {
+            xStartSlot();
+            break;
+        }
+        default:
+        {
+            xFinish(HW_OWI_INVALID_PARAMS);
+            break;
+        }
+    }
+
+    if ( xDone == true )
+    {
+        __bic_SR_register_on_exit(LPM3_bits);
+    }
+}
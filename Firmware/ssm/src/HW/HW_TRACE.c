@@ -0,0 +1,135 @@
+/**************************************************************************************************
+* \file     HW_TRACE.c
+* \brief    Compact binary trace records on the terminal UART, rendered to text on the host
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdint.h>
+#include "stdbool.h"
+#include "HW_TRACE.h"
+#include "uC_UART.h"
+#include "uC_TIME.h"
+
+// A record costs about the same as copying a short string, there is no formatting on the SSM. Tracing is
+// off after a reset and is turned on from the CLI.
+
+static bool xTraceEnabled = false;
+static uint16_t xDroppedCount = 0u;     // since the last TRACE_DROPPED record went out
+static uint16_t xDroppedTotal = 0u;
+
+void HW_TRACE_Enable(bool isEnabled);
+bool HW_TRACE_IsEnabled(void);
+void HW_TRACE_Log(hwTraceEvent_t event, uint8_t numArgs, uint16_t arg0, uint16_t arg1, uint16_t arg2, uint16_t arg3);
+uint16_t HW_TRACE_GetDroppedCount(void);
+
+static bool xSendRecord(hwTraceEvent_t event, uint8_t numArgs, const uint16_t * p_args);
+static uint8_t xBuildRecord(uint8_t * p_record, hwTraceEvent_t event, uint8_t numArgs, const uint16_t * p_args);
+
+void HW_TRACE_Enable(bool isEnabled)
+{
+    xTraceEnabled = isEnabled;
+    xDroppedCount = 0u;
+}
+
+bool HW_TRACE_IsEnabled(void)
+{
+    return xTraceEnabled;
+}
+
+uint16_t HW_TRACE_GetDroppedCount(void)
+{
+    return xDroppedTotal;
+}
+
+// Queue one record. Unused arguments are ignored.
+void HW_TRACE_Log(hwTraceEvent_t event, uint8_t numArgs, uint16_t arg0, uint16_t arg1, uint16_t arg2, uint16_t arg3)
+{
+    uint16_t args[HW_TRACE_MAX_ARGS];
+
+    if ( xTraceEnabled == false )
+    {
+        return;
+    }
+
+    // the host hears about a gap before the next record that makes it out
+    if ( (xDroppedCount != 0u) && (xSendRecord(TRACE_DROPPED, 1u, &xDroppedCount) == true) )
+    {
+        xDroppedCount = 0u;
+    }
+
+    args[0] = arg0;
+    args[1] = arg1;
+    args[2] = arg2;
+    args[3] = arg3;
+
+    if ( (xDroppedCount != 0u) ||
+         (xSendRecord(event, (numArgs > HW_TRACE_MAX_ARGS) ? HW_TRACE_MAX_ARGS : numArgs, args) == false) )
+    {
+        if ( xDroppedCount < UINT16_MAX )
+        {
+            xDroppedCount++;
+        }
+        if ( xDroppedTotal < UINT16_MAX )
+        {
+            xDroppedTotal++;
+        }
+    }
+}
+
+static bool xSendRecord(hwTraceEvent_t event, uint8_t numArgs, const uint16_t * p_args)
+{
+    uint8_t record[HW_TRACE_MAX_RECORD_LEN];
+    uint8_t len = xBuildRecord(record, event, numArgs, p_args);
+
+    return uC_UART_TxNoWait(record, len);
+}
+
+// Returns the record length
+static uint8_t xBuildRecord(uint8_t * p_record, hwTraceEvent_t event, uint8_t numArgs, const uint16_t * p_args)
+{
+    uint32_t tick = (uint32_t)uC_TIME_GetRuntimeTicks();
+    uint8_t len = 0u;
+    uint8_t sum = 0u;
+    uint8_t i;
+
+    p_record[len++] = HW_TRACE_SYNC;
+    p_record[len++] = (uint8_t)event;
+    p_record[len++] = numArgs;
+    p_record[len++] = (uint8_t)(tick);
+    p_record[len++] = (uint8_t)(tick >> 8);
+    p_record[len++] = (uint8_t)(tick >> 16);
+    p_record[len++] = (uint8_t)(tick >> 24);
+
+    for ( i = 0u; i < numArgs; i++ )
+    {
+        p_record[len++] = (uint8_t)(p_args[i]);
+        p_record[len++] = (uint8_t)(p_args[i] >> 8);
+    }
+
+    for ( i = 1u; i < len; i++ )
+    {
+        sum += p_record[i];
+    }
+
+    p_record[len++] = (uint8_t)(0u - sum);
+
+    return len;
+}
@@ -53,6 +53,13 @@
  // Define this if you want engineering data to go to the terminal instead of EEPROM.
 //#define STREAM_ENGINEERING_DATA
 
+// Terminal line rate, uC_UART_Init has the matching divider settings
+#ifdef STREAM_ENGINEERING_DATA
+#define HW_TERM_BAUD_RATE           19200u
+#else
+#define HW_TERM_BAUD_RATE           9600u
+#endif
+
 #ifdef STREAM_ENGINEERING_DATA
 #ifndef ENGINEERING_DATA
 #error "Must define ENGINEERING_DATA if using STREAM_ENGINEERING_DATA"
@@ -0,0 +1,49 @@
+/**************************************************************************************************
+* \file     HW_CLK.h
+* \brief    Software epoch clock run from the uC_TIME seconds tick and disciplined by the M41T62 RTC
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef HW_CLK_H
+#define HW_CLK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The RTC is read this often to correct the drift of the runtime seconds tick
+#define HW_CLK_DISCIPLINE_PERIOD_SECS           3600lu
+
+// Errors up to this size are slewed out, larger ones are stepped (the RTC was set behind our back)
+#define HW_CLK_STEP_THRESHOLD_SECS              64l
+
+// One second of a pending correction is applied every this many runtime seconds
+#define HW_CLK_SLEW_PERIOD_SECS                 10lu
+
+extern bool HW_CLK_Sync(void);
+extern bool HW_CLK_SetEpoch(uint32_t epoch_time);
+extern void HW_CLK_Monitor(void);
+extern uint32_t HW_CLK_GetEpochTime(void);
+extern uint32_t HW_CLK_GetSecondsSinceMidnight(void);
+extern void HW_CLK_GetHour(uint8_t * hour);
+extern void HW_CLK_GetSecToNextHour(uint16_t * secondsToNextHour);
+extern void HW_CLK_Report(void);
+
+#endif /* HW_CLK_H */
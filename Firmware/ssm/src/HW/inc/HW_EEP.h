@@ -35,6 +35,7 @@
 extern void HW_EEP_Init(void);
 extern void HW_EEP_DoTest(void);
 extern uint8_t HW_EEP_ReadByte(uint16_t addr);
+extern bool HW_EEP_ReadBlock(uint16_t addr, uint8_t * p_data, uint16_t num_bytes);
 extern void HW_EEP_WriteByte(uint16_t addr, uint8_t value);
 extern void HW_EEP_EraseAll(void);
 extern void HW_EEP_WriteBlock(uint16_t addr, uint8_t * p_data, uint8_t num_bytes);
@@ -26,10 +26,14 @@
 #define HW_INC_HW_MAG_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 extern void HW_MAG_InitBusAndDevice(void);
 extern uint8_t HW_MAG_getID(void);
 extern void HW_MAG_GetLatestMagAndTempData(int16_t *xLsb, int16_t *yLsb, int16_t *zLsb, int16_t *tempLsb, uint8_t *bitFlags);
+extern void HW_MAG_ReadSampleIfReady(void);
+extern bool HW_MAG_IsSampleHeld(void);
+extern uint32_t HW_MAG_GetSampleReadCount(void);
 extern void HW_MAG_SampleAndReport(void);
 extern void HW_MAG_ChangeSampleRate(uint8_t rateInHz);
 extern void HW_MAG_ChangeOperatingMode(uint8_t mode);
@@ -0,0 +1,48 @@
+/**************************************************************************************************
+* \file     HW_OWI.h
+* \brief    Timer driven 1-wire master for the DS2740 fuel gauge on P2.2
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef HW_OWI_H
+#define HW_OWI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+    HW_OWI_SUCCESS,
+    HW_OWI_BUSY,
+    HW_OWI_INVALID_PARAMS,
+    HW_OWI_NO_DEVICE_DETECTED,
+}hwOwiResult_t;
+
+// Called from HW_OWI_Monitor() (the background loop) once a transaction started with HW_OWI_Start() is done
+typedef void (*hwOwiCallback_t)(hwOwiResult_t result);
+
+extern void HW_OWI_Init(void);
+extern hwOwiResult_t HW_OWI_Start(const uint8_t * txData, uint8_t txLen, uint8_t * rxData, uint8_t rxLen, hwOwiCallback_t callback);
+extern hwOwiResult_t HW_OWI_Transfer(const uint8_t * txData, uint8_t txLen, uint8_t * rxData, uint8_t rxLen);
+extern bool HW_OWI_IsBusy(void);
+extern void HW_OWI_Monitor(void);
+
+#endif /* HW_OWI_H */
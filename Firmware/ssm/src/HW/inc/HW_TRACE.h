@@ -0,0 +1,78 @@
+/**************************************************************************************************
+* \file     HW_TRACE.h
+* \brief    Compact binary trace records on the terminal UART, rendered to text on the host
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef HW_TRACE_H
+#define HW_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A record is queued behind any terminal text and never waits for room, when the UART is behind the record
+// is dropped and counted. Records are only written from the background loop.
+//
+// Record layout, multi byte fields little endian:
+//      0x1E | event | argument count | tick (4 bytes, 10 ms) | arguments (2 bytes each) | checksum
+// The checksum makes the sum of every byte after the sync zero. The SSM never prints 0x1E, so the host
+// can pick the records out of the text. Firmware/ssm/tools/ssm_trace_decode.py reads the event list below
+// to render them, adding an event here is all it takes.
+#define HW_TRACE_SYNC               0x1Eu
+#define HW_TRACE_MAX_ARGS           4u
+#define HW_TRACE_HEADER_LEN         7u
+#define HW_TRACE_MAX_RECORD_LEN     (HW_TRACE_HEADER_LEN + (2u * HW_TRACE_MAX_ARGS) + 1u)
+
+// X(event, format) - printf style, one %u, %d or %x per argument
+#define HW_TRACE_EVENTS(X) \
+    X(TRACE_DROPPED,            "%u trace records dropped") \
+    X(TRACE_BOOT,               "boot, app state %u, reset state %u") \
+    X(TRACE_ALGO_LATE,          "algorithm ran %u ticks after the last run, %u late runs") \
+    X(TRACE_STATIC_PADS,        "static cap sense data") \
+    X(TRACE_HOUR,               "hour %u") \
+    X(TRACE_DAILY_LITERS,       "daily liters %u, average %u, red flag %u") \
+    X(TRACE_MAG_IDLE,           "magnetometer idle, %u idle entries") \
+    X(TRACE_MAG_ACTIVE,         "magnetometer active") \
+    X(TRACE_AM_WAKE,            "waking the AM, attention sources 0x%x") \
+    X(TRACE_SPI_INVALID,        "invalid SPI message") \
+    X(TRACE_TRANSITION,         "stroke transition %u, value %d, index %d") \
+    X(TRACE_STROKE,             "stroke at index %d, %d percent, dry %u")
+
+#define HW_TRACE_ENUM_ENTRY(event, format)      event,
+
+typedef enum
+{
+    HW_TRACE_EVENTS(HW_TRACE_ENUM_ENTRY)
+    TRACE_EVENT_COUNT
+}hwTraceEvent_t;
+
+extern void HW_TRACE_Enable(bool isEnabled);
+extern bool HW_TRACE_IsEnabled(void);
+extern void HW_TRACE_Log(hwTraceEvent_t event, uint8_t numArgs, uint16_t arg0, uint16_t arg1, uint16_t arg2, uint16_t arg3);
+extern uint16_t HW_TRACE_GetDroppedCount(void);
+
+#define HW_TRACE_0(event)                   HW_TRACE_Log((event), 0u, 0u, 0u, 0u, 0u)
+#define HW_TRACE_1(event, a)                HW_TRACE_Log((event), 1u, (uint16_t)(a), 0u, 0u, 0u)
+#define HW_TRACE_2(event, a, b)             HW_TRACE_Log((event), 2u, (uint16_t)(a), (uint16_t)(b), 0u, 0u)
+#define HW_TRACE_3(event, a, b, c)          HW_TRACE_Log((event), 3u, (uint16_t)(a), (uint16_t)(b), (uint16_t)(c), 0u)
+#define HW_TRACE_4(event, a, b, c, d)       HW_TRACE_Log((event), 4u, (uint16_t)(a), (uint16_t)(b), (uint16_t)(c), (uint16_t)(d))
+
+#endif /* HW_TRACE_H */
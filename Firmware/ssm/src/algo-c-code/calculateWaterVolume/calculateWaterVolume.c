@@ -3,6 +3,11 @@
  *
  * MATLAB Coder version            : 5.0
  * C/C++ source code generated on  : 27-Oct-2022 08:10:46
+ *
+ * Hand edited: add_to_buffer() hands the eight pads to APP_PADF_Delta() and
+ * includes APP_PADF.h. Carry this over on the next pull, see ../README.md.
+ * The file as generated is tools/test/ref/calculateWaterVolume.c, test_padf
+ * checks the two give the same results.
  */
 
 /* Include Files */
@@ -11,6 +16,7 @@
 #include "detectWaterChange.h"
 #include "promotePadStates.h"
 #include "waterCalibration.h"
+#include "APP_PADF.h"
 
 /* Custom Source Code */
 
@@ -139,329 +145,28 @@ static void add_to_buffer(int16_T pad_sample_pad1, int16_T pad_sample_pad2,
   *pad_delta_data_pad6, int16_T *pad_delta_data_pad7, int16_T
   *pad_delta_data_pad8)
 {
-  int16_T pad1_max;
-  int16_T pad1_min;
-  int16_T pad2_max;
-  int16_T pad2_min;
-  int16_T pad3_max;
-  int16_T pad3_min;
-  int16_T pad4_max;
-  int16_T pad4_min;
-  int16_T pad5_max;
-  int16_T pad5_min;
-  int16_T pad6_max;
-  int16_T pad6_min;
-  int16_T pad7_max;
-  int16_T pad7_min;
-  int16_T pad8_max;
-  int16_T pad8_min;
-  int16_T i;
-  int16_T b_i;
-  int16_T c_i;
-
-  /*         %% */
-  /*  Note the buffer uses 1-7 to store the raw values and 8 to store the past delta point  */
-  /*         %% */
-  /*  If the buffer index is at 7 we add the new point, average and shift the */
-  /*  buffer and remain at index of 7 */
-  if (pad_filtering_data->buffer_idx == 5) {
-    /*  Add the newest point to the buffers */
-    pad_filtering_data->pad_1_buffer[4] = pad_sample_pad1;
-    pad_filtering_data->pad_2_buffer[4] = pad_sample_pad2;
-    pad_filtering_data->pad_3_buffer[4] = pad_sample_pad3;
-    pad_filtering_data->pad_4_buffer[4] = pad_sample_pad4;
-    pad_filtering_data->pad_5_buffer[4] = pad_sample_pad5;
-    pad_filtering_data->pad_6_buffer[4] = pad_sample_pad6;
-    pad_filtering_data->pad_7_buffer[4] = pad_sample_pad7;
-    pad_filtering_data->pad_8_buffer[4] = pad_sample_pad8;
-
-    /*  Set the initial values for the max and mins */
-    pad1_max = pad_filtering_data->pad_1_buffer[0];
-    pad1_min = pad_filtering_data->pad_1_buffer[0];
-    pad2_max = pad_filtering_data->pad_2_buffer[0];
-    pad2_min = pad_filtering_data->pad_2_buffer[0];
-    pad3_max = pad_filtering_data->pad_3_buffer[0];
-    pad3_min = pad_filtering_data->pad_3_buffer[0];
-    pad4_max = pad_filtering_data->pad_4_buffer[0];
-    pad4_min = pad_filtering_data->pad_4_buffer[0];
-    pad5_max = pad_filtering_data->pad_5_buffer[0];
-    pad5_min = pad_filtering_data->pad_5_buffer[0];
-    pad6_max = pad_filtering_data->pad_6_buffer[0];
-    pad6_min = pad_filtering_data->pad_6_buffer[0];
-    pad7_max = pad_filtering_data->pad_7_buffer[0];
-    pad7_min = pad_filtering_data->pad_7_buffer[0];
-    pad8_max = pad_filtering_data->pad_8_buffer[0];
-    pad8_min = pad_filtering_data->pad_8_buffer[0];
-
-    /*  Loop through current array and keep track of max/min values */
-    for (i = 0; i < 5; i++) {
-      if (pad_filtering_data->pad_1_buffer[i] > pad1_max) {
-        pad1_max = pad_filtering_data->pad_1_buffer[i];
-      } else {
-        if (pad_filtering_data->pad_1_buffer[i] < pad1_min) {
-          pad1_min = pad_filtering_data->pad_1_buffer[i];
-        }
-      }
-
-      if (pad_filtering_data->pad_2_buffer[i] > pad2_max) {
-        pad2_max = pad_filtering_data->pad_2_buffer[i];
-      } else {
-        if (pad_filtering_data->pad_2_buffer[i] < pad2_min) {
-          pad2_min = pad_filtering_data->pad_2_buffer[i];
-        }
-      }
-
-      if (pad_filtering_data->pad_3_buffer[i] > pad3_max) {
-        pad3_max = pad_filtering_data->pad_3_buffer[i];
-      } else {
-        if (pad_filtering_data->pad_3_buffer[i] < pad3_min) {
-          pad3_min = pad_filtering_data->pad_3_buffer[i];
-        }
-      }
-
-      if (pad_filtering_data->pad_4_buffer[i] > pad4_max) {
-        pad4_max = pad_filtering_data->pad_4_buffer[i];
-      } else {
-        if (pad_filtering_data->pad_4_buffer[i] < pad4_min) {
-          pad4_min = pad_filtering_data->pad_4_buffer[i];
-        }
-      }
-
-      if (pad_filtering_data->pad_5_buffer[i] > pad5_max) {
-        pad5_max = pad_filtering_data->pad_5_buffer[i];
-      } else {
-        if (pad_filtering_data->pad_5_buffer[i] < pad5_min) {
-          pad5_min = pad_filtering_data->pad_5_buffer[i];
-        }
-      }
-
-      if (pad_filtering_data->pad_6_buffer[i] > pad6_max) {
-        pad6_max = pad_filtering_data->pad_6_buffer[i];
-      } else {
-        if (pad_filtering_data->pad_6_buffer[i] < pad6_min) {
-          pad6_min = pad_filtering_data->pad_6_buffer[i];
-        }
-      }
-
-      if (pad_filtering_data->pad_7_buffer[i] > pad7_max) {
-        pad7_max = pad_filtering_data->pad_7_buffer[i];
-      } else {
-        if (pad_filtering_data->pad_7_buffer[i] < pad7_min) {
-          pad7_min = pad_filtering_data->pad_7_buffer[i];
-        }
-      }
-
-      if (pad_filtering_data->pad_8_buffer[i] > pad8_max) {
-        pad8_max = pad_filtering_data->pad_8_buffer[i];
-      } else {
-        if (pad_filtering_data->pad_8_buffer[i] < pad8_min) {
-          pad8_min = pad_filtering_data->pad_8_buffer[i];
-        }
-      }
-    }
-
-    /*  Calculate the delta using the max and the min values and */
-    /*  average with the past delta value */
-    /*             %% PAD 1 DELTA AND AVERAGING */
-    if (pad_sample_pad1 - pad_filtering_data->pad_1_buffer[0] < 1) {
-      *pad_delta_data_pad1 = (pad1_min - pad1_max) +
-        pad_filtering_data->pad_1_buffer[5];
-    } else {
-      *pad_delta_data_pad1 = (pad1_max - pad1_min) +
-        pad_filtering_data->pad_1_buffer[5];
-    }
-
-    if (*pad_delta_data_pad1 < 0) {
-      *pad_delta_data_pad1 = 1 - *pad_delta_data_pad1;
-      *pad_delta_data_pad1 = -(int16_T)((uint16_T)*pad_delta_data_pad1 >> 1);
-    } else {
-      *pad_delta_data_pad1 = (int16_T)((uint16_T)(*pad_delta_data_pad1 + 1) >> 1);
-    }
-
-    /*             %% PAD 2 DELTA AND AVERAGING */
-    if (pad_sample_pad2 - pad_filtering_data->pad_2_buffer[0] < 1) {
-      *pad_delta_data_pad2 = (pad2_min - pad2_max) +
-        pad_filtering_data->pad_2_buffer[5];
-    } else {
-      *pad_delta_data_pad2 = (pad2_max - pad2_min) +
-        pad_filtering_data->pad_2_buffer[5];
-    }
-
-    if (*pad_delta_data_pad2 < 0) {
-      *pad_delta_data_pad2 = 1 - *pad_delta_data_pad2;
-      *pad_delta_data_pad2 = (int16_T)((uint16_T)*pad_delta_data_pad2 >> 1);
-      *pad_delta_data_pad2 = -*pad_delta_data_pad2;
-    } else {
-      *pad_delta_data_pad2 = (int16_T)((uint16_T)(*pad_delta_data_pad2 + 1) >> 1);
-    }
-
-    /*             %% PAD 3 DELTA AND AVERAGING                 */
-    if (pad_sample_pad3 - pad_filtering_data->pad_3_buffer[0] < 1) {
-      *pad_delta_data_pad3 = (pad3_min - pad3_max) +
-        pad_filtering_data->pad_3_buffer[5];
-    } else {
-      *pad_delta_data_pad3 = (pad3_max - pad3_min) +
-        pad_filtering_data->pad_3_buffer[5];
-    }
-
-    if (*pad_delta_data_pad3 < 0) {
-      *pad_delta_data_pad3 = 1 - *pad_delta_data_pad3;
-      *pad_delta_data_pad3 = (int16_T)((uint16_T)*pad_delta_data_pad3 >> 1);
-      *pad_delta_data_pad3 = -*pad_delta_data_pad3;
-    } else {
-      *pad_delta_data_pad3 = (int16_T)((uint16_T)(*pad_delta_data_pad3 + 1) >> 1);
-    }
-
-    /*             %% PAD 4 DELTA AND AVERAGING */
-    if (pad_sample_pad4 - pad_filtering_data->pad_4_buffer[0] < 1) {
-      *pad_delta_data_pad4 = (pad4_min - pad4_max) +
-        pad_filtering_data->pad_4_buffer[5];
-    } else {
-      *pad_delta_data_pad4 = (pad4_max - pad4_min) +
-        pad_filtering_data->pad_4_buffer[5];
-    }
-
-    if (*pad_delta_data_pad4 < 0) {
-      *pad_delta_data_pad4 = 1 - *pad_delta_data_pad4;
-      *pad_delta_data_pad4 = (int16_T)((uint16_T)*pad_delta_data_pad4 >> 1);
-      *pad_delta_data_pad4 = -*pad_delta_data_pad4;
-    } else {
-      *pad_delta_data_pad4 = (int16_T)((uint16_T)(*pad_delta_data_pad4 + 1) >> 1);
-    }
-
-    /*             %% PAD 5 DELTA AND AVERAGING */
-    if (pad_sample_pad5 - pad_filtering_data->pad_5_buffer[0] < 1) {
-      *pad_delta_data_pad5 = (pad5_min - pad5_max) +
-        pad_filtering_data->pad_5_buffer[5];
-    } else {
-      *pad_delta_data_pad5 = (pad5_max - pad5_min) +
-        pad_filtering_data->pad_5_buffer[5];
-    }
-
-    if (*pad_delta_data_pad5 < 0) {
-      *pad_delta_data_pad5 = 1 - *pad_delta_data_pad5;
-      *pad_delta_data_pad5 = (int16_T)((uint16_T)*pad_delta_data_pad5 >> 1);
-      *pad_delta_data_pad5 = -*pad_delta_data_pad5;
-    } else {
-      *pad_delta_data_pad5 = (int16_T)((uint16_T)(*pad_delta_data_pad5 + 1) >> 1);
-    }
-
-    /*             %% PAD 6 DELTA AND AVERAGING */
-    if (pad_sample_pad6 - pad_filtering_data->pad_6_buffer[0] < 1) {
-      *pad_delta_data_pad6 = (pad6_min - pad6_max) +
-        pad_filtering_data->pad_6_buffer[5];
-    } else {
-      *pad_delta_data_pad6 = (pad6_max - pad6_min) +
-        pad_filtering_data->pad_6_buffer[5];
-    }
-
-    if (*pad_delta_data_pad6 < 0) {
-      *pad_delta_data_pad6 = 1 - *pad_delta_data_pad6;
-      *pad_delta_data_pad6 = (int16_T)((uint16_T)*pad_delta_data_pad6 >> 1);
-      *pad_delta_data_pad6 = -*pad_delta_data_pad6;
-    } else {
-      *pad_delta_data_pad6 = (int16_T)((uint16_T)(*pad_delta_data_pad6 + 1) >> 1);
-    }
-
-    /*             %% PAD 7 DELTA AND AVERAGING */
-    if (pad_sample_pad7 - pad_filtering_data->pad_7_buffer[0] < 1) {
-      *pad_delta_data_pad7 = (pad7_min - pad7_max) +
-        pad_filtering_data->pad_7_buffer[5];
-    } else {
-      *pad_delta_data_pad7 = (pad7_max - pad7_min) +
-        pad_filtering_data->pad_7_buffer[5];
-    }
-
-    if (*pad_delta_data_pad7 < 0) {
-      *pad_delta_data_pad7 = 1 - *pad_delta_data_pad7;
-      *pad_delta_data_pad7 = (int16_T)((uint16_T)*pad_delta_data_pad7 >> 1);
-      *pad_delta_data_pad7 = -*pad_delta_data_pad7;
-    } else {
-      *pad_delta_data_pad7 = (int16_T)((uint16_T)(*pad_delta_data_pad7 + 1) >> 1);
-    }
-
-    /*             %% PAD 2 DELTA AND AVERAGING */
-    if (pad_sample_pad8 - pad_filtering_data->pad_8_buffer[0] < 1) {
-      *pad_delta_data_pad8 = (pad8_min - pad8_max) +
-        pad_filtering_data->pad_8_buffer[5];
-    } else {
-      *pad_delta_data_pad8 = (pad8_max - pad8_min) +
-        pad_filtering_data->pad_8_buffer[5];
-    }
-
-    if (*pad_delta_data_pad8 < 0) {
-      *pad_delta_data_pad8 = 1 - *pad_delta_data_pad8;
-      *pad_delta_data_pad8 = (int16_T)((uint16_T)*pad_delta_data_pad8 >> 1);
-      *pad_delta_data_pad8 = -*pad_delta_data_pad8;
-    } else {
-      *pad_delta_data_pad8 = (int16_T)((uint16_T)(*pad_delta_data_pad8 + 1) >> 1);
-    }
-
-    /*  Set the current delta to the final value in the buffer to */
-    /*  average the next delta point */
-    pad_filtering_data->pad_1_buffer[5] = *pad_delta_data_pad1;
-    pad_filtering_data->pad_2_buffer[5] = *pad_delta_data_pad2;
-    pad_filtering_data->pad_3_buffer[5] = *pad_delta_data_pad3;
-    pad_filtering_data->pad_4_buffer[5] = *pad_delta_data_pad4;
-    pad_filtering_data->pad_5_buffer[5] = *pad_delta_data_pad5;
-    pad_filtering_data->pad_6_buffer[5] = *pad_delta_data_pad6;
-    pad_filtering_data->pad_7_buffer[5] = *pad_delta_data_pad7;
-    pad_filtering_data->pad_8_buffer[5] = *pad_delta_data_pad8;
-
-    /*  Sum the data before bitshifting and shift the buffer */
-    for (b_i = 0; b_i < 5; b_i++) {
-      if (b_i + 1 > 1) {
-        c_i = b_i - 1;
-        pad_filtering_data->pad_1_buffer[c_i] = pad_filtering_data->
-          pad_1_buffer[b_i];
-        pad_filtering_data->pad_2_buffer[c_i] = pad_filtering_data->
-          pad_2_buffer[b_i];
-        pad_filtering_data->pad_3_buffer[c_i] = pad_filtering_data->
-          pad_3_buffer[b_i];
-        pad_filtering_data->pad_4_buffer[c_i] = pad_filtering_data->
-          pad_4_buffer[b_i];
-        pad_filtering_data->pad_5_buffer[c_i] = pad_filtering_data->
-          pad_5_buffer[b_i];
-        pad_filtering_data->pad_6_buffer[c_i] = pad_filtering_data->
-          pad_6_buffer[b_i];
-        pad_filtering_data->pad_7_buffer[c_i] = pad_filtering_data->
-          pad_7_buffer[b_i];
-        pad_filtering_data->pad_8_buffer[c_i] = pad_filtering_data->
-          pad_8_buffer[b_i];
-      }
-    }
-  } else {
-    /*  Increment the buffer variable first */
-    pad_filtering_data->buffer_idx++;
-
-    /*  Add the newest point to the buffers */
-    pad_filtering_data->pad_1_buffer[pad_filtering_data->buffer_idx - 1] =
-      pad_sample_pad1;
-    pad_filtering_data->pad_2_buffer[pad_filtering_data->buffer_idx - 1] =
-      pad_sample_pad2;
-    pad_filtering_data->pad_3_buffer[pad_filtering_data->buffer_idx - 1] =
-      pad_sample_pad3;
-    pad_filtering_data->pad_4_buffer[pad_filtering_data->buffer_idx - 1] =
-      pad_sample_pad4;
-    pad_filtering_data->pad_5_buffer[pad_filtering_data->buffer_idx - 1] =
-      pad_sample_pad5;
-    pad_filtering_data->pad_6_buffer[pad_filtering_data->buffer_idx - 1] =
-      pad_sample_pad6;
-    pad_filtering_data->pad_7_buffer[pad_filtering_data->buffer_idx - 1] =
-      pad_sample_pad7;
-    pad_filtering_data->pad_8_buffer[pad_filtering_data->buffer_idx - 1] =
-      pad_sample_pad8;
-
-    /*  Return current data without filtering */
-    *pad_delta_data_pad1 = 0;
-    *pad_delta_data_pad2 = 0;
-    *pad_delta_data_pad3 = 0;
-    *pad_delta_data_pad4 = 0;
-    *pad_delta_data_pad5 = 0;
-    *pad_delta_data_pad6 = 0;
-    *pad_delta_data_pad7 = 0;
-    *pad_delta_data_pad8 = 0;
-  }
+  padSample_t pad_sample;
+  padSample_t pad_delta;
+
+  /*  The eight pads go through the same arithmetic in one loop in APP_PADF, */
+  /*  which keeps the buffer as a ring instead of shifting it every sample */
+  pad_sample.pad1 = pad_sample_pad1;
+  pad_sample.pad2 = pad_sample_pad2;
+  pad_sample.pad3 = pad_sample_pad3;
+  pad_sample.pad4 = pad_sample_pad4;
+  pad_sample.pad5 = pad_sample_pad5;
+  pad_sample.pad6 = pad_sample_pad6;
+  pad_sample.pad7 = pad_sample_pad7;
+  pad_sample.pad8 = pad_sample_pad8;
+  APP_PADF_Delta(&pad_sample, pad_filtering_data, &pad_delta);
+  *pad_delta_data_pad1 = pad_delta.pad1;
+  *pad_delta_data_pad2 = pad_delta.pad2;
+  *pad_delta_data_pad3 = pad_delta.pad3;
+  *pad_delta_data_pad4 = pad_delta.pad4;
+  *pad_delta_data_pad5 = pad_delta.pad5;
+  *pad_delta_data_pad6 = pad_delta.pad6;
+  *pad_delta_data_pad7 = pad_delta.pad7;
+  *pad_delta_data_pad8 = pad_delta.pad8;
 }
 
 /*
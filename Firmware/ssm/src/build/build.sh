@@ -131,10 +131,20 @@ FILES=( "../APP/APP" \
         "../APP/APP_CLI" \
         "../APP/APP_NVM" \
         "../APP/APP_ALGO" \
+        "../APP/APP_MAG" \
+        "../APP/APP_STATS" \
+        "../APP/APP_CAPTURE" \
+        "../APP/APP_PROF" \
+        "../APP/APP_CKPT" \
+        "../APP/APP_PADF" \
+        "../APP/APP_STRK" \
         "../HW/HW_AM" \
         "../HW/HW_BAT" \
         "../HW/HW_EEP" \
         "../HW/HW_RTC" \
+        "../HW/HW_CLK" \
+        "../HW/HW_OWI" \
+        "../HW/HW_TRACE" \
         "../HW/HW_GPIO" \
         "../HW/HW_ENV" \
 	    "../HW/HW_MAG" \
@@ -168,8 +178,6 @@ FILES=( "../APP/APP" \
         "../algo-c-code/clearPadWindowProcess/clearPadWindowProcess" \
         "../algo-c-code/cliResetStrokeCount/cliResetStrokeCount" \
         "../algo-c-code/computePumpHealth/computePumpHealth" \
-        "../algo-c-code/detectStrokes/detectStrokes" \
-        "../algo-c-code/detectTransitions/detectTransitions" \
         "../algo-c-code/hourlyStrokeCount/hourlyStrokeCount" \
         "../algo-c-code/hourlyWaterVolume/hourlyWaterVolume" \
         "../algo-c-code/getMaxUsageTime/getMaxUsageTime" \
@@ -181,7 +189,6 @@ FILES=( "../APP/APP" \
 	"../algo-c-code/magnetometerCalibration/isPeakValley" \
 	"../algo-c-code/magnetometerCalibration/trackRange" \
         "../algo-c-code/wakeupDataReset/wakeupDataReset" \
-        "../algo-c-code/waterPadFiltering/waterPadFiltering" \
         "../algo-c-code/writeMagSample/writeMagSample" \
         "../algo-c-code/writePadSample/writePadSample")
 
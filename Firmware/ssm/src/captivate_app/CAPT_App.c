@@ -42,9 +42,42 @@
 #include "HW_TERM.h"
 #include "uC_SPI.h"
 #include "HW_RTC.h"
+#include "HW_OWI.h"
+#include "uC_UART.h"
 #include "APP_NVM.h"
 #include "am-ssm-spi-protocol.h"
 #include "APP.h"
+#include "APP_ALGO.h"
+
+//*****************************************************************************
+//
+//! \def CAPT_NO_WATER_TIMEOUT_SAMPLES
+//! Active scanning is held for the full inactivity timeout while the water
+//! algorithm reports water present.  A session that never saw water (a
+//! splash, a hand on the spout) drops back to wake-on-proximity scanning
+//! after this much shorter timeout instead.
+//
+//*****************************************************************************
+#define CAPT_NO_WATER_TIMEOUT_SAMPLES  (600)   // 600 samples at 20 Hz = 30 seconds
+
+//*****************************************************************************
+//
+//! \var g_bWaterSeenThisSession
+//! Set once the water algorithm reports water during the current active
+//! session, cleared when wake-on-proximity mode is entered.
+//
+//*****************************************************************************
+static bool g_bWaterSeenThisSession = false;
+
+//*****************************************************************************
+//
+//! \var g_ui32ScanCount
+//! Incremented each time the sensors are measured in active mode so the
+//! algorithm can tell a fresh pad sample from a repeat of the last one.
+//
+//*****************************************************************************
+static uint32_t g_ui32ScanCount = 0;
+
 //*****************************************************************************
 //
 //! \def Define CAPT_WOP_VLO_LPM4 in order to use the very low power oscillator
@@ -148,6 +181,7 @@ bool CAPT_appHandler(void)
 				//
 				g_bConvTimerFlag = false;
 				CAPT_updateUI(&g_uiApp);
+				g_ui32ScanCount++;
 				bActivity = CAPT_getGlobalUIProximityStatus(&g_uiApp);
 
 				//
@@ -163,46 +197,68 @@ bool CAPT_appHandler(void)
 					//
 					g_ui16UISessionTimeoutCtr = g_uiApp.ui16InactivityTimeout;
 				}
-				else if (--g_ui16UISessionTimeoutCtr == 0)
+				else if (APP_ALGO_isWaterPresent() == true)
 				{
 					//
-					// If the session has timed out,
-					// enter autonomous mode
+					// Water is still flowing or draining, keep
+					// scanning at full rate.
 					//
-					g_uiApp.state = eUIWakeOnProx;
-					bActivity = false;
-					APP_setPumpActive(false);
-
+					g_bWaterSeenThisSession = true;
+					g_ui16UISessionTimeoutCtr = g_uiApp.ui16InactivityTimeout;
+				}
+				else
+				{
 					//
-					// Set the timer period for wake on touch interval
+					// No water this session, use the short timeout.
 					//
-					MAP_CAPT_disableISR(CAPT_TIMER_INTERRUPT);
-					MAP_CAPT_stopTimer();
-					MAP_CAPT_clearTimer();
+					if ((g_bWaterSeenThisSession == false) &&
+						(g_ui16UISessionTimeoutCtr > CAPT_NO_WATER_TIMEOUT_SAMPLES))
+					{
+						g_ui16UISessionTimeoutCtr = CAPT_NO_WATER_TIMEOUT_SAMPLES;
+					}
+
+					if (--g_ui16UISessionTimeoutCtr == 0)
+					{
+						//
+						// If the session has timed out,
+						// enter autonomous mode
+						//
+						g_uiApp.state = eUIWakeOnProx;
+						bActivity = false;
+						g_bWaterSeenThisSession = false;
+						APP_setPumpActive(false);
+
+						//
+						// Set the timer period for wake on touch interval
+						//
+						MAP_CAPT_disableISR(CAPT_TIMER_INTERRUPT);
+						MAP_CAPT_stopTimer();
+						MAP_CAPT_clearTimer();
 #ifndef CAPT_WOP_VLO_LPM4
-					MAP_CAPT_writeTimerCompRegister(CAPT_MS_TO_CYCLES(g_uiApp.ui16WakeOnProxModeScanPeriod));
+						MAP_CAPT_writeTimerCompRegister(CAPT_MS_TO_CYCLES(g_uiApp.ui16WakeOnProxModeScanPeriod));
 #else
-					MAP_CAPT_selectTimerSource(CAPT_TIMER_SRC_VLOCLK);
-					MAP_CAPT_writeTimerCompRegister(CAPT_MS_TO_CYCLES_VLO(g_uiApp.ui16WakeOnProxModeScanPeriod));
-					g_uiApp.ui8AppLPM = LPM4_bits;
+						MAP_CAPT_selectTimerSource(CAPT_TIMER_SRC_VLOCLK);
+						MAP_CAPT_writeTimerCompRegister(CAPT_MS_TO_CYCLES_VLO(g_uiApp.ui16WakeOnProxModeScanPeriod));
+						g_uiApp.ui8AppLPM = LPM4_bits;
 #endif
-					MAP_CAPT_startTimer();
-					g_bConvTimerFlag = false;
+						MAP_CAPT_startTimer();
+						g_bConvTimerFlag = false;
 #if defined(CAPT_HAS_AUTO_NOISE_IMMUNITY) &&    \
-                    (CAPT_HAS_AUTO_NOISE_IMMUNITY==true) && \
-                    (CAPT_CONDUCTED_NOISE_IMMUNITY_ENABLE==true)
-                    CAPT_startWakeOnProxModeWithEMCAuto(
-                            &CAPT_WAKEONPROX_SENSOR,
-                            0,
-                            g_uiApp.ui8WakeupInterval
-                            );
+                        (CAPT_HAS_AUTO_NOISE_IMMUNITY==true) && \
+                        (CAPT_CONDUCTED_NOISE_IMMUNITY_ENABLE==true)
+                        CAPT_startWakeOnProxModeWithEMCAuto(
+                                &CAPT_WAKEONPROX_SENSOR,
+                                0,
+                                g_uiApp.ui8WakeupInterval
+                                );
 #else
-                    CAPT_startWakeOnProxMode(
-                            &CAPT_WAKEONPROX_SENSOR,
-                            0,
-                            g_uiApp.ui8WakeupInterval
-                            );
+                        CAPT_startWakeOnProxMode(
+                                &CAPT_WAKEONPROX_SENSOR,
+                                0,
+                                g_uiApp.ui8WakeupInterval
+                                );
 #endif  // CAPT_HAS_AUTO_NOISE_IMMUNITY && CAPT_CONDUCTED_NOISE_IMMUNITY
+					}
 				}
 #endif  // CAPT_WAKEONPROX_ENABLE
 			}
@@ -323,6 +379,11 @@ bool CAPT_appHandler(void)
 	return bActivity;
 }
 
+uint32_t CAPT_appGetScanCount(void)
+{
+	return g_ui32ScanCount;
+}
+
 void CAPT_appSleep(void)
 {
 	//
@@ -331,7 +392,7 @@ void CAPT_appSleep(void)
 	//
 	if( (!(g_bConvTimerFlag || g_bDetectionFlag || g_bConvCounterFlag || g_bMaxCountErrorFlag)) &&
         (HW_TERM_CommandRdy() == false) && // Don't enter LPM if a command is ready.
-        (uC_SPI_BytesReady() == false)  // Don't enter LPM is command is coming in from AM (parse it as it comes in)
+        (uC_SPI_FrameReady() == false)  // Don't enter LPM if a frame from the AM is waiting to be handled
 #ifdef ENGINEERING_DATA
         && (APP_CLI_CollectingData() == false)) // Don't enter LPM when collecting engineering data.
 #else
@@ -339,7 +400,15 @@ void CAPT_appSleep(void)
 #endif // ENGINEERING_DATA
 
     {
-		__bis_SR_register(g_uiApp.ui8AppLPM | GIE);
+		if ( (HW_OWI_IsBusy() == true) || (uC_UART_IsTxBusy() == true) )
+		{
+			// The 1-wire timer and the terminal UART run from SMCLK, which is off in LPM3
+			__bis_SR_register(LPM0_bits | GIE);
+		}
+		else
+		{
+			__bis_SR_register(g_uiApp.ui8AppLPM | GIE);
+		}
 	}
 	else
 	{
@@ -82,4 +82,15 @@ extern bool CAPT_appHandler(void);
 //*****************************************************************************
 extern void CAPT_appSleep(void);
 
+//*****************************************************************************
+//
+// CAPT_appGetScanCount() returns the number of active mode sensor scans.
+// The count does not advance in wake-on-proximity mode, so a caller
+// sampling the pads can tell a fresh measurement from a repeated one.
+// \param none
+// \return the active mode scan count
+//
+//*****************************************************************************
+extern uint32_t CAPT_appGetScanCount(void);
+
 #endif /* CAPT_APP_H_ */
@@ -59,6 +59,7 @@
 #include "CAPT_UserConfig.h"
 
 #define INACTIVITY_TIMEOUT_SAMPLES  6000    // 6000 samples at 20 Hz = 5 minutes
+#define WAKE_ON_PROX_SCAN_PERIOD_MS 100     // idle scans only need to catch water arriving, the algorithm runs on active scans
 
 //*****************************************************************************
 //
@@ -344,7 +345,7 @@ tCaptivateApplication g_uiApp =
     .bElementDataTxEnable = true,
     .bSensorDataTxEnable = true,
     .ui16ActiveModeScanPeriod = 50,
-    .ui16WakeOnProxModeScanPeriod = 50,
+    .ui16WakeOnProxModeScanPeriod = WAKE_ON_PROX_SCAN_PERIOD_MS,
     .ui16InactivityTimeout = INACTIVITY_TIMEOUT_SAMPLES,
     .ui8WakeupInterval = CAPT_COUNTER__DISABLED,
 };
@@ -39,15 +39,21 @@
 #include "APP_NVM.h"
 #include "uC_TIME.h"
 #include "HW_RTC.h"
+#include "HW_CLK.h"
+#include "HW_OWI.h"
 #include "version.h"
 #include "version-git-info.h"
 #include "HW_AM.h"
 #include "APP_WTR.h"
 #include "am-ssm-spi-protocol.h"
 #include "HW_GPIO.h"
+#include "APP_PROF.h"
 
 void main(void)
 {
+    appProfStamp_t loopStart;
+    appProfStamp_t stageStart;
+
     //
     // Initialize the MCU
     // BSP_configureMCU() sets up the device IO and clocking
@@ -87,13 +93,19 @@ void main(void)
 
         APP_init();
 
+        APP_PROF_Reset();
+
         //
         // Background Loop
         //
         while(1)
         {
+            loopStart = APP_PROF_Begin();
+
             // Run the captivate application handler.
+            stageStart = APP_PROF_Begin();
             CAPT_appHandler();
+            APP_PROF_End(PROF_CAPT_HANDLER, stageStart);
 
             //check periodically if we have reached a critical level - if so, do nothing
             //to prevent the cell modem from being turned on (waking the AM)
@@ -102,20 +114,39 @@ void main(void)
                 //check for oscillator errors
                 HW_RTC_Monitor();
 
+                //keep the epoch clock on the RTC
+                HW_CLK_Monitor();
+
+                //finish up 1-wire transactions done in the background
+                HW_OWI_Monitor();
+
                 //Check for UART rx chars
+                stageStart = APP_PROF_Begin();
                 APP_CLI_Periodic();
+                APP_PROF_End(PROF_CLI_PERIODIC, stageStart);
 
                 //check for SPI comm
+                stageStart = APP_PROF_Begin();
                 ASP_SSM_Periodic();
+                APP_PROF_End(PROF_ASP_PERIODIC, stageStart);
+
+                //read ahead in the sensor data log while the AM drains it
+                APP_NVM_Custom_PrefetchSensorData();
 
                 //monitor the magnetometer
+                stageStart = APP_PROF_Begin();
                 HW_MAG_Monitor();
+                APP_PROF_End(PROF_MAG_MONITOR, stageStart);
 
                 //let the app run
+                stageStart = APP_PROF_Begin();
                 APP_periodic();
+                APP_PROF_End(PROF_APP_PERIODIC, stageStart);
             }
 
-            // End of background loop iteration
+            // End of background loop iteration, the time asleep is not part of it
+            APP_PROF_End(PROF_LOOP, loopStart);
+
             // Go to sleep if there is nothing left to do
             CAPT_appSleep();
         } // End background loop
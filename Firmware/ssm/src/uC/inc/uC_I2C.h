@@ -32,5 +32,6 @@ extern void uC_I2C_Init(void);
 extern void uC_I2C_WriteRegSingle(uint8_t slave_addr, uint8_t reg_addr, uint8_t value, bool retry_on_nak);
 extern bool uC_I2C_WriteMulti(uint8_t slave_addr, uint8_t * p_payload, uint8_t num_bytes,  bool retry_on_nak);
 extern uint8_t uC_I2C_ReadRegSingle(uint8_t slave_addr, uint8_t reg_addr,  bool retry_on_nak);
+extern bool uC_I2C_ReadMulti(uint8_t slave_addr, uint8_t * p_bytes, uint16_t num_bytes);
 
 #endif /* uC_I2C_H */
@@ -1,6 +1,6 @@
 /**************************************************************************************************
 * \file     uC_SPI.h
-* \brief    SPI driver
+* \brief    SPI driver, frame level transport for the AM-SSM protocol
 *
 * \par      Copyright Notice
 *           Copyright 2021 charity: water
@@ -29,8 +29,12 @@
 #include <stdint.h>
 
 extern void uC_SPI_Init(void);
-extern bool uC_SPI_BytesReady(void);
-extern uint8_t uC_SPI_GetNextByte(void);
+extern void uC_SPI_Periodic(void);
+extern bool uC_SPI_FrameReady(void);
+extern uint8_t * uC_SPI_GetFrame(uint8_t * p_len);
+extern void uC_SPI_ReleaseFrame(void);
+extern bool uC_SPI_TakeFramingError(void);
 extern bool uC_SPI_Tx(uint8_t * p_bytes, uint8_t num_bytes);
+extern bool uC_SPI_IsSending(const uint8_t * p_bytes);
 
 #endif /* uC_SPI_H */
@@ -51,8 +51,12 @@
 
 #define DATA_COLLECTION_FREQ_HZ         (1000/(UC_TIME_TICKS_PER_50MS * UC_TIMER_TICK_TIME_MS))
 
+// Timer_A2 free runs from SMCLK/16, one count per microsecond. It wraps every 65.5 ms and stops in LPM3.
+#define UC_TIME_US_PER_WRAP             (65536lu)
+
 extern void uC_TIME_Init(void);
 extern uint64_t uC_TIME_GetRuntimeTicks(void);
+extern uint16_t uC_TIME_GetMicroseconds(void);
 extern uint32_t uC_TIME_GetRuntimeSeconds(void);
 extern void uC_TIME_SetRuntime(uint32_t seconds);
 extern void HW_WatchdogStopKick(bool stop);
@@ -26,9 +26,13 @@
 #define UC_UART_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "uC.h"
 
 extern void uC_UART_Init(void);
 extern void uC_UART_Tx(uint8_t * p_buf, uint16_t len);
+extern bool uC_UART_TxNoWait(const uint8_t * p_buf, uint16_t len);
+extern bool uC_UART_IsTxBusy(void);
+extern void uC_UART_Flush(void);
 
 #endif /* UC_UART_H */
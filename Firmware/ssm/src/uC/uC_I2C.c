@@ -22,6 +22,7 @@
 *
 ***************************************************************************************************/
 
+#include <string.h>
 #include <msp430.h>                      // Generic MSP430 Device Include
 #include "driverlib.h"                   // MSPWare Driver Library
 #include "gpio.h"
@@ -34,11 +35,18 @@
 #define REVOVER_BUS_TOGGLES       32
 #define RECOVER_BUS_DELAY_TICKS   800
 
+// A byte takes 22.5 us at 400 kHz, about 20 polls at 16 MHz.  Several times that means the slave is gone or
+// something holds the bus.
+#define uC_I2C_RX_TIMEOUT_POLLS   1000
+
 void uC_I2C_WriteRegSingle(uint8_t slave_addr, uint8_t reg_addr, uint8_t value, bool retry_on_nak);
 bool uC_I2C_WriteMulti(uint8_t slave_addr, uint8_t * p_payload, uint8_t num_bytes, bool retry_on_nak);
 uint8_t uC_I2C_ReadRegSingle(uint8_t slave_addr, uint8_t reg_addr, bool retry_on_nak);
+bool uC_I2C_ReadMulti(uint8_t slave_addr, uint8_t * p_bytes, uint16_t num_bytes);
 void uC_I2C_Init(void);
 
+static bool xWaitForRx(void);
+
 static uint8_t Num_Tx_Bytes = 2;
 static uint8_t Tx_Index = 0;
 static uint8_t Tx_Data[uC_I2C_MAX_MSG_LEN] = {};
@@ -227,6 +235,91 @@ bool uC_I2C_WriteMulti(uint8_t slave_addr, uint8_t * p_payload, uint8_t num_byte
     return result;
 }
 
+// Read multiple bytes from the slave's current address (an EEPROM keeps it from the last access, see
+// HW_EEP_ReadBlock()).  Polled like the single byte reads, the slave is clocked out at the bus rate.
+// Returns false if a byte did not come in time, the stop is sent and p_bytes is only partly filled.
+bool uC_I2C_ReadMulti(uint8_t slave_addr, uint8_t * p_bytes, uint16_t num_bytes)
+{
+    uint16_t i = 0;
+    bool received = true;
+
+    if ( (p_bytes == NULL) || (num_bytes == 0) ) return false;
+
+    //Specify slave address
+    EUSCI_B_I2C_setSlaveAddress(EUSCI_B0_BASE, slave_addr);
+
+    //Set Master in receive mode
+    EUSCI_B_I2C_setMode(EUSCI_B0_BASE, EUSCI_B_I2C_RECEIVE_MODE);
+
+    //Enable I2C Module to start operations
+    EUSCI_B_I2C_enable(EUSCI_B0_BASE);
+
+    EUSCI_B_I2C_clearInterrupt(EUSCI_B0_BASE, EUSCI_B_I2C_RECEIVE_INTERRUPT0 + EUSCI_B_I2C_BYTE_COUNTER_INTERRUPT);
+
+    // WARNING: The stop has to be set while the last byte is coming in.  For a single byte that is as soon as
+    //          the address is out, interrupts stay off from the start, same as for
+    //          EUSCI_B_I2C_masterReceiveSingleByte().
+    if ( num_bytes == 1 )
+    {
+        __disable_interrupt();
+    }
+
+    EUSCI_B_I2C_masterReceiveStart(EUSCI_B0_BASE);
+
+    for (i = 0; i < (num_bytes - 1); i++)
+    {
+        if ( xWaitForRx() == false )
+        {
+            received = false;
+            break;
+        }
+
+        // WARNING: Reading the next to last byte frees the buffer and starts the last one, so interrupts stay
+        //          off from there until the stop is set.
+        if ( i == (num_bytes - 2) )
+        {
+            __disable_interrupt();
+        }
+
+        p_bytes[i] = EUSCI_B_I2C_masterReceiveMultiByteNext(EUSCI_B0_BASE);
+    }
+
+    if ( (received == true) && (num_bytes == 1) )
+    {
+        // Wait for the address to go out, a slave that does not ack it leaves the start pending
+        i = uC_I2C_RX_TIMEOUT_POLLS;
+        while ( (EUSCI_B_I2C_masterIsStartSent(EUSCI_B0_BASE) == EUSCI_B_I2C_SENDING_START) && (--i > 0) );
+        received = (i > 0);
+        i = 0;
+    }
+
+    if ( received == true )
+    {
+        received = (EUSCI_B_I2C_masterReceiveMultiByteFinishWithTimeout(EUSCI_B0_BASE, &p_bytes[i], uC_I2C_RX_TIMEOUT_POLLS) == STATUS_SUCCESS);
+    }
+    else
+    {
+        EUSCI_B_I2C_masterReceiveMultiByteStop(EUSCI_B0_BASE);
+    }
+
+    __enable_interrupt();
+
+    return received;
+}
+
+// Wait for the next byte of a read, false if it does not come
+static bool xWaitForRx(void)
+{
+    uint16_t polls = uC_I2C_RX_TIMEOUT_POLLS;
+
+    while (EUSCI_B_I2C_getInterruptStatus(EUSCI_B0_BASE, EUSCI_B_I2C_RECEIVE_INTERRUPT0) == 0)
+    {
+        if ( --polls == 0 ) return false;
+    }
+
+    return true;
+}
+
 #if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
 #pragma vector=USCI_B0_VECTOR
 __interrupt
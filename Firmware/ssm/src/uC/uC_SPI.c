@@ -1,6 +1,6 @@
 /**************************************************************************************************
 * \file     uC_SPI.c
-* \brief    SPI driver
+* \brief    SPI driver, frame level transport for the AM-SSM protocol
 *
 * \par      Copyright Notice
 *           Copyright 2021 charity: water
@@ -29,26 +29,51 @@
 #include <string.h>
 #include "HW_TERM.h"
 #include "HW_GPIO.h"
+#include "uC_TIME.h"
+#include "am-ssm-spi-protocol.h"
 
-#define UC_SPI_RX_CIRC_BUFF_LEN 250
-#define UC_SPI_TX_CIRC_BUFF_LEN 250
+// The FR2676 has no DMA controller so the eUSCI still interrupts once per byte. The ISR does the framing
+// itself (start byte, length, byte count) and only wakes the main loop when a whole frame is in, a bad
+// length is seen or a transmit finished. The protocol layer then checks the frame in one go.
+//
+// Frames are sent straight out of the caller's buffer, nothing is copied. The buffer has to stay untouched
+// until uC_SPI_IsSending() returns false for it.
 
-//buffer to store received characters
-uint8_t Rx_Circ_Buff[UC_SPI_RX_CIRC_BUFF_LEN] = {};
-uint8_t Rx_Head_Index = 0;
-uint8_t Rx_Tail_Index = 0;
+#define UC_SPI_RX_FRAMES                2u
+#define UC_SPI_FRAME_LEN_IDX            1u
 
-//buffer of characters to send
-uint8_t Tx_Buff[UC_SPI_TX_CIRC_BUFF_LEN] = {};  // Currently not circular.  One Tx at any given time. (No DMA)
-uint8_t Tx_Head_Index = 0;
-uint8_t Tx_Tail_Index = 0;
-static bool txMode = false;
+// Drop a partly received frame if no byte came in for this long. The AM clocks a frame out in one go.
+#define UC_SPI_RX_TIMEOUT_TICKS         (UC_TIME_TICKS_PER_100MS)
+
+//received frames, the ISR fills one while the main loop handles the other
+static uint8_t Rx_Frames[UC_SPI_RX_FRAMES][sizeof(asp_msg_t)] = {};
+static volatile uint8_t Rx_Frame_Len[UC_SPI_RX_FRAMES] = {};   // 0 while the slot is free
+static volatile uint8_t Rx_Write_Idx = 0;
+static uint8_t Rx_Read_Idx = 0;
+static volatile uint8_t Rx_Count = 0;           // bytes of the frame being received
+static volatile uint8_t Rx_Expected = 0;
+static volatile bool Rx_Framing_Error = false;
+
+static uint8_t Rx_Last_Count = 0;
+static uint64_t Rx_Last_Progress_Ticks = 0;
+
+//frame being sent
+static const uint8_t * Tx_Frame = NULL;
+static const uint8_t * volatile Tx_Ptr = NULL;
+static volatile uint8_t Tx_Remaining = 0;
+static volatile bool txMode = false;
 
 
 void uC_SPI_Init(void);
-bool uC_SPI_BytesReady(void);
-uint8_t uC_SPI_GetNextByte(void);
+void uC_SPI_Periodic(void);
+bool uC_SPI_FrameReady(void);
+uint8_t * uC_SPI_GetFrame(uint8_t * p_len);
+void uC_SPI_ReleaseFrame(void);
+bool uC_SPI_TakeFramingError(void);
 bool uC_SPI_Tx(uint8_t * p_bytes, uint8_t num_bytes);
+bool uC_SPI_IsSending(const uint8_t * p_bytes);
+
+static inline bool xReceiveByte(uint8_t byte);
 
 void uC_SPI_Init(void)
 {
@@ -83,63 +108,167 @@ void uC_SPI_Init(void)
     HW_GPIO_Set_SSM_RDY();
 }
 
-// Return true if bytes are waiting in the receive buffer.
-bool uC_SPI_BytesReady(void)
+// Periodic function, drops a partly received frame that stopped coming in
+void uC_SPI_Periodic(void)
+{
+    uint64_t ticks = uC_TIME_GetRuntimeTicks();
+    uint8_t count = Rx_Count;
+
+    if ( (count == 0) || (count != Rx_Last_Count) )
+    {
+        Rx_Last_Count = count;
+        Rx_Last_Progress_Ticks = ticks;
+    }
+    else if ( (ticks - Rx_Last_Progress_Ticks) >= UC_SPI_RX_TIMEOUT_TICKS )
+    {
+        __disable_interrupt();
+
+        //only drop it if the ISR did not move on in the meantime
+        if ( Rx_Count == count )
+        {
+            Rx_Count = 0;
+        }
+
+        __enable_interrupt();
+
+        Rx_Last_Count = 0;
+    }
+}
+
+// Return true if a complete frame is waiting.
+bool uC_SPI_FrameReady(void)
 {
-  return ((Rx_Head_Index == Rx_Tail_Index) ? false : true);
+    return ((Rx_Frame_Len[Rx_Read_Idx] == 0) ? false : true);
 }
 
-// Get the next byte out of the receive buffer.
-uint8_t uC_SPI_GetNextByte(void)
+// Get the oldest complete frame, start byte through checksum. NULL if there is none.
+// The frame stays valid until uC_SPI_ReleaseFrame() is called.
+uint8_t * uC_SPI_GetFrame(uint8_t * p_len)
 {
-    uint8_t byte = 0;
+    uint8_t * p_frame = NULL;
+
+    *p_len = Rx_Frame_Len[Rx_Read_Idx];
+
+    if ( *p_len != 0 )
+    {
+        p_frame = Rx_Frames[Rx_Read_Idx];
+    }
+
+    return p_frame;
+}
 
-    //pull the oldest byte from the buffer (FIFO)
-    byte = Rx_Circ_Buff[Rx_Tail_Index];
+// Hand the frame from uC_SPI_GetFrame() back to the ISR.
+void uC_SPI_ReleaseFrame(void)
+{
+    if ( Rx_Frame_Len[Rx_Read_Idx] != 0 )
+    {
+        Rx_Frame_Len[Rx_Read_Idx] = 0;
+        Rx_Read_Idx ^= 1u;
+    }
+}
 
-    //update the  rx tail
-    Rx_Tail_Index++;
+// Return true (once) if a frame with an invalid length was received since the last call.
+bool uC_SPI_TakeFramingError(void)
+{
+    bool error = false;
 
-    //wrap back around
-    if ( Rx_Tail_Index >= UC_SPI_RX_CIRC_BUFF_LEN )
+    if ( Rx_Framing_Error == true )
     {
-        Rx_Tail_Index = 0;
+        __disable_interrupt();
+        Rx_Framing_Error = false;
+        __enable_interrupt();
+
+        error = true;
     }
 
-    return byte;
+    return error;
 }
 
-// Transmit the number of bytes provided.  Returns true if data was ok.
+// Transmit the number of bytes provided straight from p_bytes.  Returns true if data was ok.
 bool uC_SPI_Tx(uint8_t * p_bytes, uint8_t num_bytes)
 {
-    if (num_bytes > UC_SPI_RX_CIRC_BUFF_LEN) return false;
+    if (num_bytes == 0) return false;
     if (p_bytes == NULL) return false;
-    if (Tx_Tail_Index != Tx_Head_Index) return false;
+    if (Tx_Remaining != 0) return false;
 
     __disable_interrupt();
 
     txMode = true;
 
-    Tx_Tail_Index = 0;
-    Tx_Head_Index = num_bytes;
-    memcpy(Tx_Buff, p_bytes, num_bytes);
+    Tx_Frame = p_bytes;
+    Tx_Ptr = (p_bytes + 1);
+    Tx_Remaining = (num_bytes - 1u);
 
     //Clear the data ready pin for the AM to get the clock started
     HW_GPIO_Clear_SSM_RDY();
 
     //begin the transfer - send first byte of the buffer
-    EUSCI_A_SPI_transmitData(EUSCI_A1_BASE,
-                             Tx_Buff[Tx_Tail_Index]);  // Currently not circular.  One Tx at any given time.
-
-    //increment the index of the buffer.
     //When the interrupt fires, it will then transmit the second byte
-    Tx_Tail_Index++;
+    UCA1TXBUF = p_bytes[0];
 
     __enable_interrupt();
 
     return true;
 }
 
+// Return true while the frame at p_bytes still has bytes to go out.
+bool uC_SPI_IsSending(const uint8_t * p_bytes)
+{
+    return ((Tx_Remaining != 0) && (Tx_Frame == p_bytes));
+}
+
+// Frame the received byte.  Returns true if the main loop has something to do.
+static inline bool xReceiveByte(uint8_t byte)
+{
+    uint8_t idx = Rx_Write_Idx;
+    uint8_t count = Rx_Count;
+    bool wake = false;
+
+    if ( Rx_Frame_Len[idx] != 0 )
+    {
+        //both frames are still waiting on the main loop, drop it.  The AM will time out on SSM_RDY.
+    }
+    else if ( count == 0 )
+    {
+        if ( byte == ASP_START_FRAME_MAGIC )
+        {
+            Rx_Frames[idx][0] = byte;
+            Rx_Count = 1;
+        }
+    }
+    else
+    {
+        Rx_Frames[idx][count] = byte;
+        count++;
+
+        if ( count == (UC_SPI_FRAME_LEN_IDX + 1u) )
+        {
+            if ( byte <= ASP_MAX_PAYLOAD )
+            {
+                Rx_Expected = (byte + ASP_TOTAL_OVERHEAD_BYTES);
+            }
+            else
+            {
+                //invalid length, start over and let the protocol NACK it
+                Rx_Framing_Error = true;
+                count = 0;
+                wake = true;
+            }
+        }
+        else if ( count == Rx_Expected )
+        {
+            Rx_Frame_Len[idx] = count;
+            Rx_Write_Idx = (idx ^ 1u);
+            count = 0;
+            wake = true;
+        }
+
+        Rx_Count = count;
+    }
+
+    return wake;
+}
+
 #if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
 #pragma vector=USCI_A1_VECTOR
 __interrupt
@@ -148,22 +277,26 @@ __attribute__((interrupt(USCI_A1_VECTOR)))
 #endif
 void USCI_A1_ISR (void)
 {
+    bool wake = false;
+
     switch(__even_in_range(UCA1IV, USCI_SPI_UCTXIFG))
     {
        // transmit interrupt
         case USCI_SPI_UCTXIFG:
         {
             //if we have more bytes, send them
-            if (( Tx_Tail_Index < Tx_Head_Index)  && txMode == true )
+            if (( Tx_Remaining != 0 ) && txMode == true )
             {
-               //Transmit data to master
-               EUSCI_A_SPI_transmitData(EUSCI_A1_BASE,
-                                        Tx_Buff[Tx_Tail_Index]);
-               Tx_Tail_Index++;
-
+                //Transmit data to master
+                UCA1TXBUF = *Tx_Ptr;
+                Tx_Ptr++;
+                Tx_Remaining--;
             }
             else
             {
+                //the interrupt keeps coming with every byte the AM clocks while idle,
+                //only wake the main loop when a transmit actually finished
+                wake = txMode;
                 txMode = false;
 
                 //no more data to send. Go back to receiving
@@ -178,30 +311,24 @@ void USCI_A1_ISR (void)
 
             //verify we are NOT transmitting
             //we actually get an RX interrupt on transmits as well and need to
-            //differentiate between what to parse and what to discard
+            //differentiate between what to parse and what to discard.
+            //Reading the rx register clears the interrupt either way.
             if ( txMode == false )
             {
-                //get the data out of the rx register, put it in the RX buffer
-                Rx_Circ_Buff[Rx_Head_Index] = EUSCI_A_SPI_receiveData(EUSCI_A1_BASE);
-
-                //now move the head pointer for the next rx
-                Rx_Head_Index++;
-
-                //wrap back around if we exceeded the buffer size
-                if ( Rx_Head_Index >= UC_SPI_RX_CIRC_BUFF_LEN )
-                {
-                    Rx_Head_Index = 0;
-                }
+                wake = xReceiveByte(UCA1RXBUF);
             }
             else
             {
-                //call the rx function to clear the interrupt
-                EUSCI_A_SPI_receiveData(EUSCI_A1_BASE);
+                (void)UCA1RXBUF;
             }
 
             break;
         default:
             break;
     }
-	__bic_SR_register_on_exit(LPM3_bits);
+
+    if ( wake == true )
+    {
+        __bic_SR_register_on_exit(LPM3_bits);
+    }
 }
@@ -41,6 +41,7 @@ static uint8_t firstHigh = 0;
 
 void uC_TIME_Init(void);
 uint64_t uC_TIME_GetRuntimeTicks(void);
+uint16_t uC_TIME_GetMicroseconds(void);
 uint32_t uC_TIME_GetRuntimeSeconds(void);
 void uC_TIME_SetRuntime(uint32_t seconds);
 
@@ -92,6 +93,15 @@ void uC_TIME_Init(void)
     Timer_A_startCounter( TIMER_A1_BASE,
             TIMER_A_CONTINUOUS_MODE );
 
+    //microsecond counter for timing code, no interrupts
+    Timer_A_initContinuousModeParam usContParam = {0};
+    usContParam.clockSource = TIMER_A_CLOCKSOURCE_SMCLK;
+    usContParam.clockSourceDivider = TIMER_A_CLOCKSOURCE_DIVIDER_16;
+    usContParam.timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_DISABLE;
+    usContParam.timerClear = TIMER_A_DO_CLEAR;
+    usContParam.startTimer = true;
+    Timer_A_initContinuousMode(TIMER_A2_BASE, &usContParam);
+
 }
 
 // Return the current number of ticks.  Each tick is UC_TIMER_TICK_TIME_MS milliseconds.
@@ -106,6 +116,13 @@ uint64_t uC_TIME_GetRuntimeTicks(void)
     return ticks;
 }
 
+// Free running microsecond count. SMCLK and MCLK come from the same DCO, the counter is synchronous
+// to the CPU and can be read directly, without a capture or a majority vote.
+uint16_t uC_TIME_GetMicroseconds(void)
+{
+    return TA2R;
+}
+
 // Return runtime in seconds.
 uint32_t uC_TIME_GetRuntimeSeconds(void)
 {
@@ -40,9 +40,26 @@
 #define GPIO_PIN_UCA0RXD        GPIO_PIN1
 #define GPIO_FUNCTION_UCA0RXD   GPIO_PRIMARY_MODULE_FUNCTION
 
+// Transmit is interrupt driven. Writers copy into a RAM ring and the TX interrupt moves one byte into TXBUF
+// per character time, so a print costs the copy instead of ~1 ms per character at 9600 baud. Only the
+// background loop writes the ring (head) and only the ISR reads it (tail). Both indexes are 16 bits, so
+// reading either one is atomic, and they run freely so (head - tail) is the fill level.
+#define UART_TX_RING_SIZE       512u        // power of two
+#define UART_TX_RING_MASK       (UART_TX_RING_SIZE - 1u)
+
+static uint8_t xTxRing[UART_TX_RING_SIZE];
+static volatile uint16_t xTxHead = 0u;
+static volatile uint16_t xTxTail = 0u;
+static volatile bool xTxWaiting = false;     // a writer sleeps until the ISR makes room
 
 void uC_UART_Init(void);
 void uC_UART_Tx(uint8_t * p_buf, uint16_t len);
+bool uC_UART_TxNoWait(const uint8_t * p_buf, uint16_t len);
+bool uC_UART_IsTxBusy(void);
+void uC_UART_Flush(void);
+
+static uint16_t xQueueTx(const uint8_t * p_buf, uint16_t len);
+static void xWaitForTx(bool untilEmpty);
 
 extern uint8_t HW_TERM_Rx_Buf[HW_TERM_RX_BUF_LEN];
 extern uint8_t HW_TERM_Rx_Buf_Idx;
@@ -69,7 +86,23 @@ void EUSCI_A0_ISR(void)
             }
         	__bic_SR_register_on_exit(LPM3_bits);
             break;
-       case USCI_UART_UCTXIFG: break;
+       case USCI_UART_UCTXIFG:
+            if ( xTxTail != xTxHead )
+            {
+                EUSCI_A_UART_transmitData(EUSCI_A0_BASE, xTxRing[xTxTail & UART_TX_RING_MASK]);
+                xTxTail++;
+            }
+            else
+            {
+                // nothing left, TXIFG stays set and fires again when the next write enables the interrupt
+                EUSCI_A_UART_disableInterrupt(EUSCI_A0_BASE, EUSCI_A_UART_TRANSMIT_INTERRUPT);
+            }
+
+            if ( xTxWaiting == true )
+            {
+                __bic_SR_register_on_exit(LPM3_bits);
+            }
+            break;
        case USCI_UART_UCSTTIFG: break;
        case USCI_UART_UCTXCPTIFG: break;
     }
@@ -78,15 +111,15 @@ void EUSCI_A0_ISR(void)
 void uC_UART_Init(void)
 {
     // Configure UART
-    // SMCLK = 250kHz, Baudrate = 9600/19200
+    // SMCLK = 16MHz, Baudrate = 9600/19200 (HW_TERM_BAUD_RATE)
     // Settings computed at http://software-dl.ti.com/msp430/msp430_public_sw/mcu/msp430/MSP430BaudRateConverter/index.html
 
     EUSCI_A_UART_initParam param = {0};
     param.selectClockSource = EUSCI_A_UART_CLOCKSOURCE_SMCLK;
     #ifdef STREAM_ENGINEERING_DATA
-    param.clockPrescalar = 3;
-    param.firstModReg = 4;
-    param.secondModReg = 4;
+    param.clockPrescalar = 52;
+    param.firstModReg = 1;
+    param.secondModReg = 0x49;
     param.overSampling = EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION;
     #else
     param.clockPrescalar = 104;
@@ -117,17 +150,98 @@ void uC_UART_Init(void)
 
 }
 
-// Transmit buffer on UART bus
+// Transmit buffer on UART bus. Returns once everything is queued, which only waits if more than a ring's
+// worth of text is already waiting to go out. Background loop only.
 void uC_UART_Tx(uint8_t * p_buf, uint16_t len)
 {
-    uint16_t i = 0;
+    uint16_t queued;
 
-    //Stop Watchdog Timer
-    WDT_A_hold(WDT_A_BASE);
+    while (len > 0u)
+    {
+        queued = xQueueTx(p_buf, len);
+        p_buf += queued;
+        len -= queued;
+
+        if ( len > 0u )
+        {
+            xWaitForTx(false);
+        }
+    }
+}
 
-    for (i =0; i < len; i++)
+// Queue all of the buffer or none of it, never waits. For output that must not hold up the loop (trace).
+bool uC_UART_TxNoWait(const uint8_t * p_buf, uint16_t len)
+{
+    if ( (uint16_t)(UART_TX_RING_SIZE - (uint16_t)(xTxHead - xTxTail)) < len )
     {
-        // Load data onto buffer.  If transmit interrupt is disabled, this checks to make sure it is safe to write.
-        EUSCI_A_UART_transmitData(EUSCI_A0_BASE, p_buf[i]);
+        return false;
     }
+
+    (void)xQueueTx(p_buf, len);
+
+    return true;
+}
+
+// True while anything is queued or still shifting out. The UART runs from SMCLK, which is off in LPM3.
+bool uC_UART_IsTxBusy(void)
+{
+    return ( (xTxHead != xTxTail) || (EUSCI_A_UART_queryStatusFlags(EUSCI_A0_BASE, EUSCI_A_UART_BUSY) != 0u) );
+}
+
+// Wait until everything queued is on the wire, before a reset or a jump to the BSL
+void uC_UART_Flush(void)
+{
+    xWaitForTx(true);
+
+    while ( EUSCI_A_UART_queryStatusFlags(EUSCI_A0_BASE, EUSCI_A_UART_BUSY) != 0u );
+}
+
+// Copy as much as fits into the ring and start the TX interrupt, returns the number of bytes queued
+static uint16_t xQueueTx(const uint8_t * p_buf, uint16_t len)
+{
+    uint16_t head = xTxHead;
+    uint16_t space = UART_TX_RING_SIZE - (uint16_t)(head - xTxTail);
+    uint16_t offset = head & UART_TX_RING_MASK;
+    uint16_t first;
+
+    if ( len > space )
+    {
+        len = space;
+    }
+
+    // up to the end of the buffer, then the rest from the start
+    first = UART_TX_RING_SIZE - offset;
+    if ( first > len )
+    {
+        first = len;
+    }
+
+    memcpy(&xTxRing[offset], p_buf, first);
+    memcpy(xTxRing, &p_buf[first], len - first);
+
+    // the bytes have to be in place before the ISR can see the head that covers them
+    xTxHead = head + len;
+
+    if ( len > 0u )
+    {
+        EUSCI_A_UART_enableInterrupt(EUSCI_A0_BASE, EUSCI_A_UART_TRANSMIT_INTERRUPT);
+    }
+
+    return len;
+}
+
+// Sleep in LPM0 (SMCLK keeps the UART running) until there is room in the ring, or until it is empty
+static void xWaitForTx(bool untilEmpty)
+{
+    __disable_interrupt();
+    xTxWaiting = true;
+
+    while ( (untilEmpty == true) ? (xTxHead != xTxTail) : ((uint16_t)(xTxHead - xTxTail) >= UART_TX_RING_SIZE) )
+    {
+        __bis_SR_register(LPM0_bits | GIE);
+        __disable_interrupt();
+    }
+
+    xTxWaiting = false;
+    __enable_interrupt();
 }
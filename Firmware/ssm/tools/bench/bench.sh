@@ -0,0 +1,182 @@
+#!/bin/bash
+
+#
+# Build the algorithm benchmark for the MSP430 simulator (ssm_bench.py) with msp430-elf-gcc and gate it
+#
+# TI's MSP430 GCC is free to download (MSP430-GCC-OPENSOURCE, with its support files), so anyone can make
+# the cycle counts without the cl430 licence src/build/build.sh needs. The options follow build.sh: the
+# large code and data model and the F5 series multiplier of the FR2676, optimised for size as
+# --opt_for_speed=0 does. The counts are of gcc's code rather than the shipped cl430 build, they move with
+# the algorithm the same way. The objects, out/bench.elf and its map go to out/. The image is then run on
+# capture.csv against the msp430 cycle counts in baseline.json, a stage or a function more than 1% over
+# fails the build (exit 1). --update writes the counts to baseline.json instead, check it in with the
+# change that moved them. Set MSP430_GCC_ROOT to where the toolchain is unpacked, the support files go
+# in its include folder.
+#
+# --host builds the same program with gcc and gcov instead, into out/host/bench_host. It reads the capture
+# on stdin and ssm_bench.py --host counts the statements each function ran. That needs no MSP430 tools,
+# so it is what test_bench.py checks against the baseline on every test run. The generated code is copied
+# to out/tree with rtwtypes.h set to the MSP430 sizes, as tools/test/test.sh does.
+#
+# Usage: ./bench.sh [--host | --update]
+#
+
+MSP430_GCC_ROOT="${MSP430_GCC_ROOT:-/opt/ti/msp430-gcc}"
+COMPILER="$MSP430_GCC_ROOT/bin/msp430-elf-gcc"
+SUPPORT_FILES="$MSP430_GCC_ROOT/include"
+OUTPUT_NAME=out/bench
+SRC="../../src"
+
+GENERIC_OPTIONS=(   -mmcu=msp430fr2676 \
+                    -mlarge \
+                    -mcode-region=either \
+                    -mhwmult=f5series \
+                    -Os \
+                    -g \
+                    -std=gnu99 \
+                    -Wall \
+                    -Wno-unused-function \
+                    -Wno-unknown-pragmas \
+                    -DTARGET_IS_MSP430FR2XX_4XX \
+                    -DSSM_BUILD \
+                    -DSSM_BENCH)
+
+# Include paths for building
+BUILD_INCLUDE_PATHS=(   -I$SUPPORT_FILES \
+                        -I. \
+                        -I$SRC \
+                        -I$SRC/APP/inc \
+                        -I$SRC/HW/inc)
+
+# Additional options for linking only, the support files have the part's linker script
+LINK_OPTIONS=(  -L$SUPPORT_FILES \
+                -Wl,-Map=$OUTPUT_NAME.map)
+
+# Files that we want to build and then link, the algorithm files as listed in src/build/build.sh
+# The *.c at the end of each file is omitted for flexibility in the BASH script
+FILES=( "bench_main" \
+        "bench_hooks" \
+        "$SRC/APP/APP_PADF" \
+        "$SRC/APP/APP_STRK" \
+        "$SRC/algo-c-code/calculateWaterVolume/addToAverage" \
+        "$SRC/algo-c-code/calculateWaterVolume/calculateWaterVolume" \
+        "$SRC/algo-c-code/calculateWaterVolume/promotePadStates" \
+        "$SRC/algo-c-code/calculateWaterVolume/checkWaterCalibration" \
+        "$SRC/algo-c-code/calculateWaterVolume/detectWaterChange" \
+        "$SRC/algo-c-code/calculateWaterVolume/waterCalibration" \
+        "$SRC/algo-c-code/clearMagWindowProcess/clearMagWindowProcess" \
+        "$SRC/algo-c-code/clearPadWindowProcess/clearPadWindowProcess" \
+        "$SRC/algo-c-code/computePumpHealth/computePumpHealth" \
+        "$SRC/algo-c-code/hourlyStrokeCount/hourlyStrokeCount" \
+        "$SRC/algo-c-code/hourlyWaterVolume/hourlyWaterVolume" \
+        "$SRC/algo-c-code/getMaxUsageTime/getMaxUsageTime" \
+        "$SRC/algo-c-code/initializeMagCalibration/initializeMagCalibration" \
+        "$SRC/algo-c-code/initializeStrokeAlgorithm/initializeStrokeAlgorithm" \
+        "$SRC/algo-c-code/initializeWaterAlgorithm/initializeWaterAlgorithm" \
+        "$SRC/algo-c-code/initializeWindows/initializeWindows" \
+        "$SRC/algo-c-code/magnetometerCalibration/magnetometerCalibration" \
+        "$SRC/algo-c-code/magnetometerCalibration/isPeakValley" \
+        "$SRC/algo-c-code/magnetometerCalibration/trackRange" \
+        "$SRC/algo-c-code/writeMagSample/writeMagSample" \
+        "$SRC/algo-c-code/writePadSample/writePadSample")
+
+# Host build options, -O0 so every statement gets its own count
+HOST_COMPILER="gcc"
+HOST_TREE="out/tree"
+HOST_OPTIONS=(  -std=gnu99 \
+                -O0 \
+                --coverage \
+                -Wall \
+                -Wno-main \
+                -Wno-unused-function \
+                -Wno-unknown-pragmas \
+                -DSSM_BUILD \
+                -DSSM_BENCH)
+
+HOST_INCLUDE_PATHS=(    -I$HOST_TREE \
+                        -I. \
+                        -I$SRC \
+                        -I$SRC/APP/inc \
+                        -I$SRC/HW/inc)
+
+mkdir -p out
+OBJECTS=()
+
+if [ "$1" == "--host" ]
+then
+    rm -rf $HOST_TREE out/host
+    mkdir -p $HOST_TREE out/host
+    cp -r $SRC/algo-c-code $HOST_TREE/
+    for TYPES in $(find $HOST_TREE -name rtwtypes.h); do
+        sed -i -e 's/^typedef int int16_T;/typedef short int16_T;/' \
+               -e 's/^typedef unsigned int uint16_T;/typedef unsigned short uint16_T;/' \
+               -e 's/^typedef long int32_T;/typedef int int32_T;/' \
+               -e 's/^typedef unsigned long uint32_T;/typedef unsigned int uint32_T;/' $TYPES
+    done
+
+    # bench_host answers the hooks, the algorithm files come from the 16 bit copy
+    for FULL_PATH in "${FILES[@]}"; do
+        FULL_PATH=${FULL_PATH/#bench_hooks/bench_host}
+        FULL_PATH=${FULL_PATH/#$SRC\/algo-c-code/$HOST_TREE\/algo-c-code}
+        OBJECT=out/host/$(basename $FULL_PATH).o
+        BUILD_COMMAND="$HOST_COMPILER ${HOST_OPTIONS[@]} ${HOST_INCLUDE_PATHS[@]} -c -o $OBJECT $FULL_PATH.c"
+        echo $BUILD_COMMAND
+        $BUILD_COMMAND
+        if [ $? -ne 0 ]
+        then
+            exit 1
+        fi
+        OBJECTS+=($OBJECT)
+    done
+
+    LINK_COMMAND="$HOST_COMPILER --coverage -o out/host/bench_host ${OBJECTS[@]}"
+    echo $LINK_COMMAND
+    $LINK_COMMAND
+    if [ $? -ne 0 ]
+    then
+        exit 1
+    fi
+    echo Finished building target: out/host/bench_host
+    exit 0
+fi
+
+if [ ! -x "$COMPILER" ]
+then
+    echo "No msp430-elf-gcc at $COMPILER, set MSP430_GCC_ROOT to TI's MSP430 GCC with its support files"
+    exit 1
+fi
+
+length=${#FILES[@]}
+
+# Build all individual files, into out/ so the src tree is left alone
+for ((i=0;i<$length;i++)); do
+    FULL_PATH=${FILES[$i]}
+    OBJECT=out/$(basename $FULL_PATH).o
+    echo Building file: $FULL_PATH.c
+    BUILD_COMMAND="$COMPILER ${GENERIC_OPTIONS[@]} ${BUILD_INCLUDE_PATHS[@]} -c -o $OBJECT $FULL_PATH.c"
+    echo $BUILD_COMMAND
+    $BUILD_COMMAND
+    if [ $? -ne 0 ]
+    then
+        exit 1
+    fi
+    OBJECTS+=($OBJECT)
+    echo Finished building: $FULL_PATH.c
+    echo
+done
+
+# Link files and generate the *.elf file
+echo
+echo Building target: $OUTPUT_NAME.elf
+LINK_COMMAND="$COMPILER ${GENERIC_OPTIONS[@]} ${LINK_OPTIONS[@]} -o $OUTPUT_NAME.elf ${OBJECTS[@]}"
+echo $LINK_COMMAND
+$LINK_COMMAND
+if [ $? -ne 0 ]
+then
+    exit 1
+fi
+echo Finished building target: $OUTPUT_NAME.elf
+echo
+
+# The gate, or the new baseline with --update
+python3 ssm_bench.py $1 $OUTPUT_NAME.elf capture.csv
@@ -0,0 +1,49 @@
+/**************************************************************************************************
+* \file     bench_hooks.c
+* \brief    Calls the benchmark runner answers in place of the real functions
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include "bench_hooks.h"
+
+bool BENCH_NextSample(int16_t * p_channels, uint8_t * p_status, uint8_t * p_flags)
+{
+    (void)p_channels;
+    (void)p_status;
+    (void)p_flags;
+
+    return false;
+}
+
+void BENCH_Rewind(void)
+{
+}
+
+void BENCH_Start(void)
+{
+}
+
+void BENCH_Done(void)
+{
+    for ( ;; )
+    {
+    }
+}
@@ -0,0 +1,48 @@
+/**************************************************************************************************
+* \file     bench_hooks.h
+* \brief    Calls the benchmark runner answers in place of the real functions
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef BENCH_HOOKS_H_
+#define BENCH_HOOKS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ssm_bench.py replaces these in the simulator, the bodies in bench_hooks.c are never run. They are in
+// their own file so the compiler can't see into them and leave the calls out. bench_host.c has the
+// answers for the gcc build.
+
+// The next recorded sample: 12 channels in capture order, the magnetometer status and the capture flags.
+// False at the end of the input.
+extern bool BENCH_NextSample(int16_t * p_channels, uint8_t * p_status, uint8_t * p_flags);
+
+// Starts the input over from the first sample
+extern void BENCH_Rewind(void);
+
+// The warm up is done, the counts start from here
+extern void BENCH_Start(void);
+
+// Stops the simulator
+extern void BENCH_Done(void);
+
+#endif /* BENCH_HOOKS_H_ */
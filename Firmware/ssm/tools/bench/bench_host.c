@@ -0,0 +1,130 @@
+/**************************************************************************************************
+* \file     bench_host.c
+* \brief    Host answers for the benchmark hooks, for the statement count build
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_hooks.h"
+#include "APP_CAPTURE.h"
+
+// bench.sh --host links this in place of bench_hooks.c. The capture CSV comes in on stdin and is kept so
+// the warm up can go over it again, the program exits when the counted run has used it up so gcov
+// writes the counts.
+
+#define CAPTURE_LINE_LEN    256
+#define CAPTURE_COLUMNS     16
+
+typedef struct
+{
+    int16_t channels[APP_CAPTURE_NUM_CHANNELS];
+    uint8_t status;
+    uint8_t flags;
+}benchRow_t;
+
+// in libgcov, clears the counts so far
+extern void __gcov_reset(void);
+
+static benchRow_t * xp_rows = NULL;
+static uint32_t xRows = 0u;
+static uint32_t xNext = 0u;
+static bool xLoaded = false;
+
+static void xLoad(void);
+
+bool BENCH_NextSample(int16_t * p_channels, uint8_t * p_status, uint8_t * p_flags)
+{
+    int i;
+
+    if ( xLoaded == false )
+    {
+        xLoad();
+    }
+
+    if ( xNext >= xRows )
+    {
+        return false;
+    }
+
+    for ( i = 0; i < APP_CAPTURE_NUM_CHANNELS; i++ )
+    {
+        p_channels[i] = xp_rows[xNext].channels[i];
+    }
+
+    *p_status = xp_rows[xNext].status;
+    *p_flags = xp_rows[xNext].flags;
+    xNext++;
+
+    return true;
+}
+
+void BENCH_Rewind(void)
+{
+    xNext = 0u;
+}
+
+void BENCH_Start(void)
+{
+    __gcov_reset();
+}
+
+void BENCH_Done(void)
+{
+    exit(0);
+}
+
+static void xLoad(void)
+{
+    char line[CAPTURE_LINE_LEN];
+    int v[CAPTURE_COLUMNS];
+    uint32_t size = 0u;
+    int i;
+
+    xLoaded = true;
+
+    while ( fgets(line, sizeof(line), stdin) != NULL )
+    {
+        //skips the header and anything else that isn't a row
+        if ( sscanf(line, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d",
+                    &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7],
+                    &v[8], &v[9], &v[10], &v[11], &v[12], &v[13], &v[14], &v[15]) != CAPTURE_COLUMNS )
+        {
+            continue;
+        }
+
+        if ( xRows == size )
+        {
+            size = (size == 0u) ? 4096u : (size * 2u);
+            xp_rows = realloc(xp_rows, size * sizeof(benchRow_t));
+        }
+
+        for ( i = 0; i < APP_CAPTURE_NUM_CHANNELS; i++ )
+        {
+            xp_rows[xRows].channels[i] = (int16_t)v[3 + i];
+        }
+
+        xp_rows[xRows].status = (uint8_t)v[15];
+        xp_rows[xRows].flags = (uint8_t)(((v[1] != 0) ? APP_CAPTURE_FLAG_ACTIVE : 0u) |
+                                         ((v[2] != 0) ? APP_CAPTURE_FLAG_STROKES : 0u));
+        xRows++;
+    }
+}
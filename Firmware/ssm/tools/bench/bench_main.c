@@ -0,0 +1,282 @@
+/**************************************************************************************************
+* \file     bench_main.c
+* \brief    Algorithm nest benchmark, runs recorded inputs through the algorithm in the simulator
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "APP_CAPTURE.h"
+#include "APP_PADF.h"
+#include "APP_STRK.h"
+#include "HW_TRACE.h"
+
+/* Algorithm Includes */
+#include "algo-c-code/calculateWaterVolume/calculateWaterVolume.h"
+#include "algo-c-code/clearMagWindowProcess/clearMagWindowProcess.h"
+#include "algo-c-code/clearPadWindowProcess/clearPadWindowProcess.h"
+#include "algo-c-code/hourlyStrokeCount/hourlyStrokeCount.h"
+#include "algo-c-code/hourlyWaterVolume/hourlyWaterVolume.h"
+#include "algo-c-code/initializeMagCalibration/initializeMagCalibration.h"
+#include "algo-c-code/initializeWaterAlgorithm/initializeWaterAlgorithm.h"
+#include "algo-c-code/initializeWindows/initializeWindows.h"
+#include "algo-c-code/magnetometerCalibration/magnetometerCalibration.h"
+#include "algo-c-code/waterPadFiltering/waterPadFiltering.h"
+#include "algo-c-code/writeMagSample/writeMagSample.h"
+#include "algo-c-code/writePadSample/writePadSample.h"
+#include "algo-c-code/getMaxUsageTime/getMaxUsageTime.h"
+#include "algo-c-code/computePumpHealth/computePumpHealth.h"
+
+#include "bench_hooks.h"
+
+// The nest runs every 50 ms
+#define SAMPLES_PER_HOUR            72000uL
+#define HOURS_PER_DAY               24u
+#define MAX_RETURNED_REASON_CODES   8
+
+// The most input the magnetometer calibration may take before the counted run, it needs over an hour of
+// pumping
+#define WARM_UP_MAX_SAMPLES         (4uL * SAMPLES_PER_HOUR)
+
+typedef enum {
+    WATERPAD_PROCESSING,
+    MAGNETOMETER_PROCESSING,
+}algoNestProcessingStates_t;
+
+// The same state APP_ALGO.c keeps, so the algorithm sees the same memory layout and the same calls
+static padWindows_t padWindow;
+static magWindows_t magWindow;
+static padSample_t currentPadSample;
+static magSample_t magSample;
+static waterAlgoData_t waterAlgoData;
+static waterCalibration_t waterCalibration;
+static padFilteringData_t padFilterData;
+static magCalibration_t magCalibration;
+static bool runStrokeDetection = false;
+static algoNestProcessingStates_t state;
+static hourlyStrokeInfo_t hourlyStrokeInfo;
+static accumStrokeCount_t strokeCount;
+static pumpUsage_t pumpUsage;
+static hourlyPumpHealthInfo_t pumpHealth;
+static hourlyWaterInfo_t hourlyWaterInfo;
+
+static void xWarmUp(void);
+static void xSetSample(const int16_t * p_channels, uint8_t status);
+static void xNest(void);
+static void xWaterpadProcess(void);
+static void xMagnetometerProcess(void);
+static void xHourly(uint8_t hour);
+
+void HW_TRACE_Log(hwTraceEvent_t event, uint8_t numArgs, uint16_t arg0, uint16_t arg1, uint16_t arg2, uint16_t arg3);
+
+void main(void)
+{
+    int16_t channels[APP_CAPTURE_NUM_CHANNELS];
+    uint8_t status;
+    uint8_t flags;
+    uint32_t samples = 0uL;
+    uint8_t hour = 0u;
+
+    initializeMagCalibration( &magCalibration );
+    xWarmUp();
+
+    initializeWindows( &padWindow, &magWindow );
+    initializeWaterAlgorithm( &waterAlgoData, &waterCalibration, &padFilterData, &pumpUsage );
+    APP_STRK_Reset( &strokeCount );
+    state = WATERPAD_PROCESSING;
+
+    BENCH_Start();
+
+    while ( BENCH_NextSample(channels, &status, &flags) == true )
+    {
+        xSetSample(channels, status);
+
+        // as APP_ALGO_setStrokeDetectionIsOn()
+        if ( (flags & APP_CAPTURE_FLAG_STROKES) != 0u )
+        {
+            runStrokeDetection = true;
+        }
+        else if ( runStrokeDetection == true )
+        {
+            runStrokeDetection = false;
+            state = WATERPAD_PROCESSING;
+        }
+
+        xNest();
+
+        samples++;
+        if ( samples == SAMPLES_PER_HOUR )
+        {
+            samples = 0uL;
+            xHourly(hour);
+            hour = (uint8_t)((hour + 1u) % HOURS_PER_DAY);
+        }
+    }
+
+    // whatever is left over counts as an hour, so short inputs still cover the hourly functions
+    xHourly(hour);
+    (void)getMaxUsageTime( &pumpUsage, 0u );
+
+    BENCH_Done();
+}
+
+// The strokes are only looked for once the magnetometer is calibrated, which takes over an hour of
+// pumping with water. Only the magnetometer path is run on the input, over and over and as if there was
+// water all the time, until it is. The counted run is then a pump that has been in use a while and not
+// one still calibrating.
+static void xWarmUp(void)
+{
+    ReasonCodes reasonCodes[MAX_RETURNED_REASON_CODES];
+    int16_t channels[APP_CAPTURE_NUM_CHANNELS];
+    uint8_t status;
+    uint8_t flags;
+    uint32_t samples = 0uL;
+    bool rewound = false;
+
+    initializeWindows( &padWindow, &magWindow );
+    initializeWaterAlgorithm( &waterAlgoData, &waterCalibration, &padFilterData, &pumpUsage );
+    waterAlgoData.present = 1u;
+
+    while ( (magCalibration.offset_calibrated == 0u) && (samples < WARM_UP_MAX_SAMPLES) )
+    {
+        if ( BENCH_NextSample(channels, &status, &flags) == false )
+        {
+            //an empty input won't calibrate anything
+            if ( rewound == true )
+            {
+                break;
+            }
+
+            BENCH_Rewind();
+            rewound = true;
+            continue;
+        }
+
+        rewound = false;
+        samples++;
+        xSetSample(channels, status);
+        writeMagSample( &magWindow, &magSample );
+
+        if (magWindow.process)
+        {
+            magnetometerCalibration( &magWindow, &magCalibration, &waterAlgoData, reasonCodes );
+            clearMagWindowProcess( &magWindow );
+        }
+    }
+
+    BENCH_Rewind();
+}
+
+static void xSetSample(const int16_t * p_channels, uint8_t status)
+{
+    currentPadSample.pad1 = p_channels[0];
+    currentPadSample.pad2 = p_channels[1];
+    currentPadSample.pad3 = p_channels[2];
+    currentPadSample.pad4 = p_channels[3];
+    currentPadSample.pad5 = p_channels[4];
+    currentPadSample.pad6 = p_channels[5];
+    currentPadSample.pad7 = p_channels[6];
+    currentPadSample.pad8 = p_channels[7];
+    magSample.x_lsb = p_channels[8];
+    magSample.y_lsb = p_channels[9];
+    magSample.z_lsb = p_channels[10];
+    magSample.temp_lsb = p_channels[11];
+    magSample.status = status;
+}
+
+// APP_ALGO_Nest() without the sample gathering, capture and profiling
+static void xNest(void)
+{
+    APP_PADF_Smooth( &currentPadSample, &padFilterData, &currentPadSample );
+    writePadSample( &padWindow, &currentPadSample );
+
+    if (runStrokeDetection)
+    {
+        writeMagSample( &magWindow, &magSample );
+    }
+
+    switch (state)
+    {
+        case WATERPAD_PROCESSING:
+            if (padWindow.process)
+            {
+                xWaterpadProcess();
+
+                if (runStrokeDetection)
+                {
+                    state = MAGNETOMETER_PROCESSING;
+                }
+            }
+            break;
+
+        case MAGNETOMETER_PROCESSING:
+            if (magWindow.process)
+            {
+                xMagnetometerProcess();
+                state = WATERPAD_PROCESSING;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    APP_STRK_Run();
+}
+
+static void xWaterpadProcess(void)
+{
+    ReasonCodes reasonCodes[MAX_RETURNED_REASON_CODES];
+
+    calculateWaterVolume( &waterAlgoData, &waterCalibration, &padWindow, reasonCodes );
+    clearPadWindowProcess( &padWindow );
+}
+
+static void xMagnetometerProcess(void)
+{
+    ReasonCodes reasonCodes[MAX_RETURNED_REASON_CODES];
+
+    magnetometerCalibration( &magWindow, &magCalibration, &waterAlgoData, reasonCodes );
+    APP_STRK_AcceptWindow( &magWindow, &magCalibration, &waterAlgoData, &strokeCount );
+    clearMagWindowProcess( &magWindow );
+}
+
+// APP_ALGO_updateHourlyFields() and APP_ALGO_computePumpHealth()
+static void xHourly(uint8_t hour)
+{
+    ReasonCodes reasonCode;
+
+    hourlyWaterVolume( &waterAlgoData, &pumpUsage, hour, 0u, &reasonCode, &hourlyWaterInfo );
+    APP_STRK_Drain();
+    hourlyStrokeCount( &strokeCount, &hourlyStrokeInfo );
+    computePumpHealth( &hourlyWaterInfo, &hourlyStrokeInfo, &pumpHealth );
+}
+
+// Tracing is off after a reset, so APP_STRK's trace records only cost the call, as they do here
+void HW_TRACE_Log(hwTraceEvent_t event, uint8_t numArgs, uint16_t arg0, uint16_t arg1, uint16_t arg2, uint16_t arg3)
+{
+    (void)event;
+    (void)numArgs;
+    (void)arg0;
+    (void)arg1;
+    (void)arg2;
+    (void)arg3;
+}
@@ -0,0 +1,814 @@
+"""MSP430X instruction set simulator that counts CPU cycles per function.
+
+Runs a linked EABI image (msp430-elf-gcc or cl430) for the CPUX core of the
+MSP430FR2676: the MSP430 and MSP430X instructions, 20 bit addresses and the
+MPY32 multiplier. The rest of the peripheral space reads and writes as plain
+memory, there are no interrupts and no low power modes.
+
+Cycle counts come from the CPUX instruction cycle tables in the MSP430FR4xx
+and MSP430FR2xx family user's guide (SLAU445, "MSP430 and MSP430X Instructions
+Execution in the MSP430X CPU"). They are CPU cycles, FRAM wait states are not
+counted. At 16 MHz the FR2676 runs FRAM with one wait state behind a cache, so
+time on the part is somewhat longer than cycles / 16 MHz.
+
+Every instruction's cycles go to the function its address is in (self). A
+call opens a frame, the cycles from the first instruction of the callee
+through its return are the callee's inclusive cycles.
+
+A function can be replaced by Python with add_hook(), which is how a benchmark
+program gets its input and says it is done.
+"""
+
+import bisect
+import struct
+
+# Status register bits
+C = 0x0001
+Z = 0x0002
+N = 0x0004
+GIE = 0x0008
+CPUOFF = 0x0010
+V = 0x0100
+
+PC = 0
+SP = 1
+SR = 2
+CG = 3
+
+# Operand sizes in bytes, an .A operand takes two words in memory
+BYTE = 1
+WORD = 2
+ADDR = 4
+
+MASK = {BYTE: 0xFF, WORD: 0xFFFF, ADDR: 0xFFFFF}
+SIGN = {BYTE: 0x80, WORD: 0x8000, ADDR: 0x80000}
+DIGITS = {BYTE: 2, WORD: 4, ADDR: 5}
+
+# MPY32, at 0x04C0 on the FR2xx parts
+MPY_BASE = 0x04C0
+MPY_END = 0x04F0
+MPYFRAC = 0x0004
+MPYSAT = 0x0008
+
+EM_MSP430 = 105
+
+# Format I cycles by source class, for a register, PC or memory destination
+FORMAT1_CYCLES = {
+    'Rn':    (1, 2, 4),
+    '@Rn':   (2, 3, 5),
+    '@Rn+':  (2, 3, 5),
+    '#N':    (2, 3, 5),
+    'X(Rn)': (3, 4, 6),
+    'EDE':   (3, 4, 6),
+    '&EDE':  (3, 4, 6),
+}
+
+# The same with an extension word, (.B/.W, .A) for each destination
+FORMAT1X_CYCLES = {
+    'Rn':    ((2, 2), (3, 3), (5, 7)),
+    '@Rn':   ((3, 4), (3, 4), (6, 9)),
+    '@Rn+':  ((3, 4), (3, 4), (6, 9)),
+    '#N':    ((3, 3), (4, 4), (6, 8)),
+    'X(Rn)': ((4, 5), (5, 6), (7, 10)),
+    'EDE':   ((4, 5), (5, 6), (7, 10)),
+    '&EDE':  ((4, 5), (5, 6), (7, 10)),
+}
+
+# MOV, BIT and CMP to memory take one cycle less, two less for the .A forms
+NO_WRITE_BACK = (0x4, 0x9, 0xB)
+
+# Format II cycles: (RRA, RRC, SWPB, SXT), PUSH, CALL
+FORMAT2_CYCLES = {
+    'Rn':    (1, 3, 4),
+    '@Rn':   (3, 3, 4),
+    '@Rn+':  (3, 3, 4),
+    '#N':    (None, 3, 4),
+    'X(Rn)': (4, 4, 5),
+    'EDE':   (4, 4, 5),
+    '&EDE':  (4, 4, 6),
+}
+
+# With an extension word: (RRAX, RRCX, RRUX, SWPBX, SXTX), PUSHX, each (.B/.W, .A)
+FORMAT2X_CYCLES = {
+    'Rn':    ((2, 2), (4, 5)),
+    '@Rn':   ((4, 5), (4, 5)),
+    '@Rn+':  ((4, 5), (4, 5)),
+    '#N':    ((None, None), (4, 5)),
+    'X(Rn)': ((5, 6), (5, 6)),
+    'EDE':   ((5, 6), (5, 6)),
+    '&EDE':  ((5, 6), (5, 6)),
+}
+
+CALLA_CYCLES = {'Rn': 5, '@Rn': 5, '@Rn+': 5, '#N': 5, 'X(Rn)': 5, 'EDE': 7, '&EDE': 7}
+
+JUMP_CYCLES = 2
+RETI_CYCLES = 5
+
+
+class SimError(Exception):
+    pass
+
+
+def sext16(value):
+    return value - 0x10000 if value & 0x8000 else value
+
+
+def sext10(value):
+    return value - 0x400 if value & 0x200 else value
+
+
+class Elf:
+    """The parts of an ELF32 little endian image the simulator needs."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1 or self.data[5] != 1:
+            raise SimError('%s is not a 32 bit little endian ELF file' % path)
+
+        (self.type, self.machine, _, self.entry, phoff, shoff, _, _,
+         phentsize, phnum, shentsize, shnum, _) = struct.unpack_from('<HHIIIIIHHHHHH', self.data, 16)
+
+        # (load address, file bytes, size in memory)
+        self.segments = []
+        for i in range(phnum):
+            p_type, offset, _, paddr, filesz, memsz, _, _ = struct.unpack_from('<IIIIIIII', self.data, phoff + i * phentsize)
+            if p_type == 1:
+                self.segments.append((paddr, self.data[offset:offset + filesz], memsz))
+
+        sections = [struct.unpack_from('<IIIIIIIIII', self.data, shoff + i * shentsize) for i in range(shnum)]
+
+        # name -> value, and (address, size, name) for every function
+        self.symbols = {}
+        self.functions = []
+        for _, sh_type, _, _, offset, size, link, _, _, entsize in sections:
+            if sh_type != 2 or entsize == 0:
+                continue
+            strtab = sections[link][4]
+            for j in range(size // entsize):
+                st_name, value, st_size, info, _, shndx = struct.unpack_from('<IIIBBH', self.data, offset + j * entsize)
+                if shndx == 0 or st_name == 0:
+                    continue
+                end = self.data.index(b'\0', strtab + st_name)
+                name = self.data[strtab + st_name:end].decode('ascii', 'replace')
+                self.symbols[name] = value
+                if info & 0xF == 2:
+                    self.functions.append((value, st_size, name))
+
+
+class Mpy32:
+    """The MPY32 hardware multiplier, without the saturation mode.
+
+    The fractional mode (IQmath uses it) shifts the result left by one as it is read, so the result is kept
+    here unshifted for the multiply and accumulate modes.
+    """
+
+    def __init__(self, sim):
+        self.sim = sim
+        self.op1 = 0
+        self.op1_32 = False
+        self.signed = False
+        self.accumulate = False
+        self.op2_low = 0
+        self.fractional = False
+        self.result = 0
+
+    def write(self, addr, value, size):
+        offset = (addr - MPY_BASE) & ~1
+        if size == BYTE:
+            # a byte write is an 8 bit operand, sign extended in the signed modes
+            if (offset in (0x02, 0x06) or (offset == 0x08 and self.signed)) and value & 0x80:
+                value |= 0xFF00
+
+        if offset in (0x00, 0x02, 0x04, 0x06):
+            self.op1 = value
+            self.op1_32 = False
+            self.signed = offset in (0x02, 0x06)
+            self.accumulate = offset in (0x04, 0x06)
+        elif offset in (0x10, 0x14, 0x18, 0x1C):
+            self.op1 = value
+            self.op1_32 = True
+            self.signed = offset in (0x14, 0x1C)
+            self.accumulate = offset in (0x18, 0x1C)
+        elif offset in (0x12, 0x16, 0x1A, 0x1E):
+            self.op1 = (self.op1 & 0xFFFF) | (value << 16)
+        elif 0x24 <= offset <= 0x2A or offset in (0x0A, 0x0C):
+            # a result preloaded for an accumulate
+            shift = 16 * ((offset - 0x24) // 2 if offset >= 0x24 else (offset - 0x0A) // 2)
+            self.result = (self.result & ~(0xFFFF << shift)) | ((value & 0xFFFF) << shift)
+        elif offset == 0x2C:
+            if value & MPYSAT:
+                raise SimError('MPY32 saturation mode is not simulated')
+            self.fractional = bool(value & MPYFRAC)
+
+        self.sim.store(addr, value, size if size != BYTE else WORD)
+
+        if offset == 0x08:
+            self._multiply(value & 0xFFFF, 16)
+        elif offset == 0x20:
+            self.op2_low = value
+        elif offset == 0x22:
+            self._multiply(self.op2_low | (value << 16), 32)
+
+    def _multiply(self, op2, op2_bits):
+        op1 = self.op1
+        op1_bits = 32 if self.op1_32 else 16
+        res_bits = 64 if (op1_bits == 32 or op2_bits == 32) else 32
+        res_mask = (1 << res_bits) - 1
+        res_sign = 1 << (res_bits - 1)
+
+        if self.signed:
+            if op1 & (1 << (op1_bits - 1)):
+                op1 -= 1 << op1_bits
+            if op2 & (1 << (op2_bits - 1)):
+                op2 -= 1 << op2_bits
+        total = op1 * op2
+
+        if self.accumulate:
+            old = self.result & res_mask
+            if self.signed and old & res_sign:
+                old -= 1 << res_bits
+            total += old
+            if self.signed:
+                sumext = 0xFFFF if total & res_sign else 0
+            else:
+                sumext = 1 if total > res_mask else 0
+        else:
+            sumext = 0xFFFF if total < 0 else 0
+
+        total &= res_mask
+        self.result = total
+        if self.fractional:
+            total = (total << 1) & res_mask
+        for i in range(res_bits // 16):
+            self.sim.store(MPY_BASE + 0x24 + 2 * i, (total >> (16 * i)) & 0xFFFF, WORD)
+        self.sim.store(MPY_BASE + 0x0A, total & 0xFFFF, WORD)
+        self.sim.store(MPY_BASE + 0x0C, (total >> 16) & 0xFFFF, WORD)
+        self.sim.store(MPY_BASE + 0x0E, sumext, WORD)
+
+
+class Msp430:
+    def __init__(self):
+        self.mem = bytearray(0x100000)
+        self.r = [0] * 16
+        self.cycles = 0
+        self.instructions = 0
+        self.halted = False
+        self.mpy = Mpy32(self)
+        self.hooks = {}
+
+        # per function statistics, by name
+        self.self_cycles = {}
+        self.inclusive = {}
+        self.calls = {}
+
+        self._starts = []
+        self._ends = []
+        self._names = []
+        self._owner = {}
+        self._frames = []
+        self._active = {}
+        self._called = None
+
+    # ---- set up ------------------------------------------------------------------------------------
+
+    def load_image(self, path):
+        elf = Elf(path)
+        if elf.machine != EM_MSP430:
+            raise SimError('%s is not an MSP430 image' % path)
+        for addr, data, memsz in elf.segments:
+            self.mem[addr:addr + len(data)] = data
+            self.mem[addr + len(data):addr + memsz] = bytes(memsz - len(data))
+        # cl430 marks its local labels ($C$L1 ...) as functions too. Assembly functions can have no size,
+        # they run up to the next function.
+        functions = sorted(f for f in elf.functions if not f[2].startswith('$'))
+        for i, (start, size, name) in enumerate(functions):
+            if self._starts and self._starts[-1] == start:
+                continue
+            if size == 0:
+                size = (functions[i + 1][0] - start) if i + 1 < len(functions) else 2
+            self._starts.append(start)
+            self._ends.append(start + size)
+            self._names.append(name)
+        self.r[PC] = elf.entry
+        return elf
+
+    def add_hook(self, addr, handler):
+        """Run handler(sim) in place of the function at addr, which must be called with CALLA.
+
+        The handler reads its arguments from R12 - R15 and leaves a return value in R12.
+        """
+        self.hooks[addr] = handler
+
+    def reset_counts(self):
+        """Starts the per function statistics over, the functions running now count from here."""
+        self.self_cycles = {}
+        self.inclusive = {}
+        self.calls = {}
+        self._frames = [(name, sp, self.cycles) for name, sp, _ in self._frames]
+
+    def function_at(self, addr):
+        name = self._owner.get(addr)
+        if name is None:
+            i = bisect.bisect_right(self._starts, addr) - 1
+            name = self._names[i] if (i >= 0 and addr < self._ends[i]) else '0x%05X' % addr
+            self._owner[addr] = name
+        return name
+
+    # ---- memory ------------------------------------------------------------------------------------
+
+    def load(self, addr, size):
+        if size == BYTE:
+            return self.mem[addr & 0xFFFFF]
+        addr &= 0xFFFFE
+        value = self.mem[addr] | (self.mem[addr + 1] << 8)
+        if size == ADDR:
+            addr = (addr + 2) & 0xFFFFF
+            value |= (self.mem[addr] & 0x0F) << 16
+        return value
+
+    def store(self, addr, value, size):
+        if size == BYTE:
+            self.mem[addr & 0xFFFFF] = value & 0xFF
+            return
+        addr &= 0xFFFFE
+        self.mem[addr] = value & 0xFF
+        self.mem[addr + 1] = (value >> 8) & 0xFF
+        if size == ADDR:
+            addr = (addr + 2) & 0xFFFFF
+            self.mem[addr] = (value >> 16) & 0x0F
+            self.mem[addr + 1] = 0
+
+    def write(self, addr, value, size):
+        if MPY_BASE <= addr < MPY_END:
+            self.mpy.write(addr, value, size)
+        else:
+            self.store(addr, value, size)
+
+    def push(self, value, size):
+        self.r[SP] = (self.r[SP] - (4 if size == ADDR else 2)) & 0xFFFFF
+        self.write(self.r[SP], value, size)
+
+    def pop(self, size):
+        value = self.load(self.r[SP], size)
+        self.r[SP] = (self.r[SP] + (4 if size == ADDR else 2)) & 0xFFFFF
+        return value
+
+    # ---- running -----------------------------------------------------------------------------------
+
+    def run(self, max_cycles=None):
+        while not self.halted:
+            pc = self.r[PC]
+            hook = self.hooks.get(pc)
+            if hook is not None:
+                hook(self)
+                self.r[PC] = self.pop(ADDR)
+            else:
+                before = self.cycles
+                self.step()
+                name = self.function_at(pc)
+                self.self_cycles[name] = self.self_cycles.get(name, 0) + self.cycles - before
+
+            if self._called is not None:
+                self._open_frame(self._called)
+                self._called = None
+            while self._frames and self.r[SP] > self._frames[-1][1]:
+                self._close_frame()
+
+            if self.r[SR] & CPUOFF:
+                raise SimError('low power mode entered at 0x%05X' % pc)
+            if max_cycles is not None and self.cycles >= max_cycles:
+                raise SimError('still running after %d cycles, at 0x%05X' % (self.cycles, self.r[PC]))
+
+        # halted from inside, the functions still running end here
+        while self._frames:
+            self._close_frame()
+
+    def _open_frame(self, target):
+        name = self.function_at(target)
+        self._frames.append((name, self.r[SP], self.cycles))
+        self._active[name] = self._active.get(name, 0) + 1
+
+    def _close_frame(self):
+        name, _, start = self._frames.pop()
+        self._active[name] -= 1
+        self.calls[name] = self.calls.get(name, 0) + 1
+        # a recursive call is already inside the outer call's cycles
+        if self._active[name] == 0:
+            self.inclusive[name] = self.inclusive.get(name, 0) + self.cycles - start
+
+    def step(self):
+        pc = self.r[PC]
+        op = self._fetch()
+        ext = None
+        if 0x1800 <= op < 0x2000:
+            ext = op
+            op = self._fetch()
+            if not (op >= 0x4000 or 0x1000 <= op < 0x1300):
+                raise SimError('extension word before 0x%04X at 0x%05X' % (op, pc))
+
+        if op >= 0x4000:
+            cycles = self._format1(op, ext)
+        elif op >= 0x2000:
+            cycles = self._jump(op)
+        elif op >= 0x1800:
+            raise SimError('two extension words at 0x%05X' % pc)
+        elif op >= 0x1400:
+            cycles = self._push_pop_multiple(op)
+        elif op >= 0x1300:
+            cycles = self._calla_reti(op, pc)
+        elif op >= 0x1000:
+            cycles = self._format2(op, ext)
+        else:
+            cycles = self._address(op, pc)
+
+        self.cycles += cycles
+        self.instructions += 1
+
+    # ---- operands ----------------------------------------------------------------------------------
+
+    def _fetch(self):
+        value = self.load(self.r[PC], WORD)
+        self.r[PC] = (self.r[PC] + 2) & 0xFFFFF
+        return value
+
+    def _indexed(self, base, x, xbits):
+        if xbits is not None:
+            return (base + ((xbits << 16) | x)) & 0xFFFFF
+        # without an extension word the index is 16 bits, and so is the address in the lower 64 KB
+        if base < 0x10000:
+            return (base + x) & 0xFFFF
+        return (base + sext16(x)) & 0xFFFFF
+
+    def _operand(self, reg, mode, size, xbits):
+        """A source style operand: (location, timing class). A location is ('r', reg), ('m', addr) or ('i', value)."""
+        if reg == CG:
+            return ('i', (0, 1, 2, MASK[size])[mode]), 'Rn'
+        if reg == SR and mode >= 2:
+            return ('i', 4 if mode == 2 else 8), 'Rn'
+        if mode == 0:
+            return ('r', reg), 'Rn'
+        if mode == 1:
+            at = self.r[PC]
+            x = self._fetch()
+            if reg == SR:
+                return ('m', x if xbits is None else ((xbits << 16) | x)), '&EDE'
+            if reg == PC:
+                return ('m', self._indexed(at, x, xbits)), 'EDE'
+            return ('m', self._indexed(self.r[reg], x, xbits)), 'X(Rn)'
+        if mode == 2:
+            return ('m', self.r[reg]), '@Rn'
+        if reg == PC:
+            x = self._fetch()
+            if xbits is not None and size == ADDR:
+                x |= xbits << 16
+            return ('i', x & MASK[size]), '#N'
+        addr = self.r[reg]
+        self.r[reg] = (addr + (2 if (size == BYTE and reg == SP) else size)) & 0xFFFFF
+        return ('m', addr), '@Rn+'
+
+    def _destination(self, reg, ad, xbits):
+        """A Format I destination: (location, 0 for a register, 1 for PC or 2 for memory)."""
+        if ad == 0:
+            return ('r', reg), (1 if reg == PC else 0)
+        at = self.r[PC]
+        x = self._fetch()
+        if reg == SR:
+            return ('m', x if xbits is None else ((xbits << 16) | x)), 2
+        return ('m', self._indexed(at if reg == PC else self.r[reg], x, xbits)), 2
+
+    def _get(self, loc, size):
+        kind, where = loc
+        if kind == 'i':
+            return where
+        if kind == 'r':
+            return self.r[where] & MASK[size]
+        return self.load(where, size)
+
+    def _put(self, loc, value, size):
+        kind, where = loc
+        if kind == 'r':
+            # .B and .W clear the register bits above them
+            if where == PC:
+                self.r[PC] = value & MASK[size] & 0xFFFFE
+            elif where != CG:
+                self.r[where] = value & MASK[size]
+        elif kind == 'm':
+            self.write(where, value & MASK[size], size)
+
+    def _extension(self, ext, bw, register_mode):
+        """(size, repeat count, zero carry, source bits 19:16, destination bits 19:16)"""
+        if ext is None:
+            return (BYTE if bw else WORD), 1, False, None, None
+        al = (ext >> 6) & 1
+        if al:
+            size = BYTE if bw else WORD
+        elif bw:
+            size = ADDR
+        else:
+            raise SimError('reserved operand size in extension word 0x%04X' % ext)
+        if register_mode:
+            count = (self.r[ext & 0xF] & 0xF) if ext & 0x80 else (ext & 0xF)
+            return size, count + 1, bool(ext & 0x100), 0, 0
+        return size, 1, False, (ext >> 7) & 0xF, ext & 0xF
+
+    # ---- flags -------------------------------------------------------------------------------------
+
+    def _set_flags(self, result, size, carry, overflow):
+        sr = self.r[SR] & ~(C | Z | N | V)
+        if result & SIGN[size]:
+            sr |= N
+        if result == 0:
+            sr |= Z
+        if carry:
+            sr |= C
+        if overflow:
+            sr |= V
+        self.r[SR] = sr
+
+    def _add(self, dst, src, carry, size):
+        total = dst + src + carry
+        result = total & MASK[size]
+        overflow = (~(dst ^ src) & (dst ^ result) & SIGN[size]) != 0
+        self._set_flags(result, size, total > MASK[size], overflow)
+        return result
+
+    def _dadd(self, dst, src, carry, size):
+        result = 0
+        for i in range(DIGITS[size]):
+            digit = ((dst >> (4 * i)) & 0xF) + ((src >> (4 * i)) & 0xF) + carry
+            carry = 1 if digit > 9 else 0
+            result |= ((digit - 10 if carry else digit) & 0xF) << (4 * i)
+        self._set_flags(result, size, carry, False)
+        return result
+
+    def _logic_flags(self, result, size, overflow=False):
+        self._set_flags(result, size, result != 0, overflow)
+
+    # ---- instructions ------------------------------------------------------------------------------
+
+    def _format1(self, op, ext):
+        opcode = op >> 12
+        sreg = (op >> 8) & 0xF
+        ad = (op >> 7) & 1
+        bw = (op >> 6) & 1
+        mode = (op >> 4) & 3
+        dreg = op & 0xF
+
+        size, repeat, zero_carry, sbits, dbits = self._extension(ext, bw, mode == 0 and ad == 0)
+        src_loc, sclass = self._operand(sreg, mode, size, sbits)
+        dst_loc, dcol = self._destination(dreg, ad, dbits)
+        mask = MASK[size]
+
+        for _ in range(repeat):
+            src = self._get(src_loc, size)
+            dst = self._get(dst_loc, size) if opcode != 0x4 else 0
+            carry = 0 if zero_carry else (self.r[SR] & C)
+
+            if opcode == 0x4:
+                self._put(dst_loc, src, size)
+            elif opcode == 0x5:
+                self._put(dst_loc, self._add(dst, src, 0, size), size)
+            elif opcode == 0x6:
+                self._put(dst_loc, self._add(dst, src, carry, size), size)
+            elif opcode == 0x7:
+                self._put(dst_loc, self._add(dst, ~src & mask, carry, size), size)
+            elif opcode == 0x8:
+                self._put(dst_loc, self._add(dst, ~src & mask, 1, size), size)
+            elif opcode == 0x9:
+                self._add(dst, ~src & mask, 1, size)
+            elif opcode == 0xA:
+                self._put(dst_loc, self._dadd(dst, src, carry, size), size)
+            elif opcode == 0xB:
+                self._logic_flags(dst & src, size)
+            elif opcode == 0xC:
+                self._put(dst_loc, dst & ~src, size)
+            elif opcode == 0xD:
+                self._put(dst_loc, dst | src, size)
+            elif opcode == 0xE:
+                result = dst ^ src
+                self._logic_flags(result, size, (dst & src & SIGN[size]) != 0)
+                self._put(dst_loc, result, size)
+            else:
+                result = dst & src
+                self._logic_flags(result, size)
+                self._put(dst_loc, result, size)
+
+        if ext is None:
+            cycles = FORMAT1_CYCLES[sclass][dcol]
+            if dcol == 2 and opcode in NO_WRITE_BACK:
+                cycles -= 1
+        else:
+            cycles = FORMAT1X_CYCLES[sclass][dcol][size == ADDR]
+            if dcol == 2 and opcode in NO_WRITE_BACK:
+                cycles -= 2 if size == ADDR else 1
+            cycles += repeat - 1
+        return cycles
+
+    def _format2(self, op, ext):
+        kind = (op >> 7) & 7
+        bw = (op >> 6) & 1
+        mode = (op >> 4) & 3
+        reg = op & 0xF
+        pc = (self.r[PC] - 2) & 0xFFFFF
+
+        size, repeat, zero_carry, _, xbits = self._extension(ext, bw, mode == 0)
+        loc, oclass = self._operand(reg, mode, size, xbits)
+        sign = SIGN[size]
+
+        if kind == 4:
+            self.push(self._get(loc, size), size)
+        elif kind == 5:
+            if ext is not None:
+                raise SimError('extended CALL at 0x%05X' % pc)
+            target = self._get(loc, WORD)
+            self.push(self.r[PC] & 0xFFFF, WORD)
+            self.r[PC] = target & 0xFFFE
+            self._called = self.r[PC]
+        else:
+            for _ in range(repeat):
+                value = self._get(loc, size)
+                if kind == 0:
+                    carry_in = 0 if zero_carry else (self.r[SR] & C)
+                    result = (value >> 1) | (sign if carry_in else 0)
+                    self._set_flags(result, size, value & 1, False)
+                    self._put(loc, result, size)
+                elif kind == 1:
+                    result = (value & 0xF0000) | ((value & 0xFF) << 8) | ((value >> 8) & 0xFF)
+                    self._put(loc, result, size)
+                elif kind == 2:
+                    result = (value >> 1) | (value & sign)
+                    self._set_flags(result, size, value & 1, False)
+                    self._put(loc, result, size)
+                elif kind == 3:
+                    # the CPUX extends the sign of a register through bit 19
+                    put_size = ADDR if loc[0] == 'r' else size
+                    result = value & 0xFF
+                    if result & 0x80:
+                        result |= MASK[put_size] & ~0xFF
+                    self._set_flags(result & MASK[size], size, (result & MASK[size]) != 0, False)
+                    self._put(loc, result, put_size)
+                else:
+                    raise SimError('invalid instruction 0x%04X at 0x%05X' % (op, pc))
+
+        group = 1 if kind == 4 else 0
+        if ext is None:
+            cycles = FORMAT2_CYCLES[oclass][2 if kind == 5 else group]
+        else:
+            cycles = FORMAT2X_CYCLES[oclass][group][size == ADDR]
+            if cycles is not None:
+                cycles += repeat - 1
+        if cycles is None:
+            raise SimError('invalid addressing mode in 0x%04X at 0x%05X' % (op, pc))
+        return cycles
+
+    def _calla_reti(self, op, pc):
+        if op == 0x1300:
+            word = self.pop(WORD)
+            self.r[SR] = word & 0x0FFF
+            self.r[PC] = (((word >> 12) & 0xF) << 16) | self.pop(WORD)
+            return RETI_CYCLES
+
+        sub = (op >> 4) & 0xF
+        reg = op & 0xF
+        if sub == 0x4:
+            target, oclass = self.r[reg], 'Rn'
+        elif sub == 0x5:
+            addr = (self.r[reg] + sext16(self._fetch())) & 0xFFFFF
+            target, oclass = self.load(addr, ADDR), 'X(Rn)'
+        elif sub == 0x6:
+            target, oclass = self.load(self.r[reg], ADDR), '@Rn'
+        elif sub == 0x7:
+            target, oclass = self.load(self.r[reg], ADDR), '@Rn+'
+            self.r[reg] = (self.r[reg] + 4) & 0xFFFFF
+        elif sub == 0x8:
+            addr = (reg << 16) | self._fetch()
+            target, oclass = self.load(addr, ADDR), '&EDE'
+        elif sub == 0x9:
+            at = self.r[PC]
+            addr = (at + ((reg << 16) | self._fetch())) & 0xFFFFF
+            target, oclass = self.load(addr, ADDR), 'EDE'
+        elif sub == 0xB:
+            target, oclass = (reg << 16) | self._fetch(), '#N'
+        else:
+            raise SimError('invalid instruction 0x%04X at 0x%05X' % (op, pc))
+
+        self.push(self.r[PC], ADDR)
+        self.r[PC] = target & 0xFFFFE
+        self._called = self.r[PC]
+        return CALLA_CYCLES[oclass]
+
+    def _push_pop_multiple(self, op):
+        kind = (op >> 8) & 3
+        count = ((op >> 4) & 0xF) + 1
+        reg = op & 0xF
+        size = ADDR if kind in (0, 2) else WORD
+
+        if kind < 2:
+            # PUSHM names the highest register
+            for i in range(count):
+                self.push(self.r[(reg - i) & 0xF], size)
+        else:
+            # POPM names the lowest register
+            for i in range(count):
+                self.r[(reg + i) & 0xF] = self.pop(size)
+
+        return 2 + (2 * count if size == ADDR else count)
+
+    def _jump(self, op):
+        cond = (op >> 10) & 7
+        sr = self.r[SR]
+        if cond == 0:
+            taken = not sr & Z
+        elif cond == 1:
+            taken = bool(sr & Z)
+        elif cond == 2:
+            taken = not sr & C
+        elif cond == 3:
+            taken = bool(sr & C)
+        elif cond == 4:
+            taken = bool(sr & N)
+        elif cond == 5:
+            taken = bool(sr & N) == bool(sr & V)
+        elif cond == 6:
+            taken = bool(sr & N) != bool(sr & V)
+        else:
+            taken = True
+        if taken:
+            self.r[PC] = (self.r[PC] + 2 * sext10(op & 0x3FF)) & 0xFFFFF
+        return JUMP_CYCLES
+
+    def _address(self, op, pc):
+        src = (op >> 8) & 0xF
+        kind = (op >> 4) & 0xF
+        dst = op & 0xF
+        to_pc = 1 if dst == PC else 0
+
+        if kind == 0x0:
+            self._set_reg20(dst, self.load(self.r[src], ADDR))
+            return 3 + to_pc
+        if kind == 0x1:
+            value = self.load(self.r[src], ADDR)
+            self.r[src] = (self.r[src] + 4) & 0xFFFFF
+            self._set_reg20(dst, value)
+            return 3 + to_pc
+        if kind == 0x2:
+            self._set_reg20(dst, self.load((src << 16) | self._fetch(), ADDR))
+            return 4 + to_pc
+        if kind == 0x3:
+            addr = (self.r[src] + sext16(self._fetch())) & 0xFFFFF
+            self._set_reg20(dst, self.load(addr, ADDR))
+            return 4 + to_pc
+        if kind in (0x4, 0x5):
+            return self._rotate_multiple(op, ADDR if kind == 0x4 else WORD)
+        if kind == 0x6:
+            self.write((dst << 16) | self._fetch(), self.r[src], ADDR)
+            return 4
+        if kind == 0x7:
+            addr = (self.r[dst] + sext16(self._fetch())) & 0xFFFFF
+            self.write(addr, self.r[src], ADDR)
+            return 4
+        if kind >= 0x8:
+            immediate = kind < 0xC
+            value = ((src << 16) | self._fetch()) if immediate else self.r[src]
+            operation = kind & 3
+            if operation == 0:
+                self._set_reg20(dst, value)
+                return 3 if to_pc else (2 if immediate else 1)
+            if operation == 1:
+                self._add(self.r[dst], ~value & 0xFFFFF, 1, ADDR)
+            elif operation == 2:
+                self._set_reg20(dst, self._add(self.r[dst], value, 0, ADDR))
+            else:
+                self._set_reg20(dst, self._add(self.r[dst], ~value & 0xFFFFF, 1, ADDR))
+            return 3 if (immediate or to_pc) else 1
+        raise SimError('invalid instruction 0x%04X at 0x%05X' % (op, pc))
+
+    def _set_reg20(self, reg, value):
+        if reg == PC:
+            self.r[PC] = value & 0xFFFFE
+        elif reg != CG:
+            self.r[reg] = value & 0xFFFFF
+
+    def _rotate_multiple(self, op, size):
+        count = ((op >> 10) & 3) + 1
+        which = (op >> 8) & 3
+        reg = op & 0xF
+        mask = MASK[size]
+        sign = SIGN[size]
+        value = self.r[reg] & mask
+        carry = self.r[SR] & C
+
+        for _ in range(count):
+            if which == 0:
+                value, carry = (value >> 1) | (sign if carry else 0), value & 1
+            elif which == 1:
+                value, carry = (value >> 1) | (value & sign), value & 1
+            elif which == 2:
+                value, carry = (value << 1) & mask, value & sign
+            else:
+                value, carry = value >> 1, value & 1
+
+        self._set_flags(value, size, carry, False)
+        self.r[reg] = value
+        return count
@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+"""Cycle counts of the SSM algorithm on recorded inputs, against a baseline.
+
+bench.sh builds the algorithm with msp430-elf-gcc and the SSM options into
+out/bench.elf. This runs it in the MSP430 simulator (msp430_sim.py) on a
+capture CSV from ssm_capture.py, one nest call per row, and prints the calls,
+inclusive cycles (with the functions it calls) and self cycles of every
+function that ran, next to the change from baseline.json.
+
+--host runs out/host/bench_host from bench.sh --host instead, the same program
+built with gcc and gcov, and counts the statements each function ran. Those
+are not cycles, but they move with the algorithm and need no MSP430 tools, so
+test_bench.py checks them on every test run. Compiler option changes need the
+cycle counts.
+
+bench_main.c first runs the magnetometer path alone over the input until the
+magnetometer is calibrated, the counts start after that (BENCH_Start) so they
+are of a pump in use with the stroke detector running.
+
+The functions are also summed into the stages of the nest (as APP_PROF times
+them on the part): a stage's cycles are the inclusive cycles of its entry
+functions, its statements are those of its source files.
+
+Nothing here needs the hardware or a network, the same image and input give
+the same counts every time. A stage or a function more than --tolerance
+percent over the baseline fails the run (exit 1), so an algorithm or compiler
+option change can be checked before it is tried on a part. So does a baseline
+without counts for the mode, until --update makes them.
+
+baseline.json keeps the counts for capture.csv here, a synthetic 4 1/2 minutes
+with two pumping sessions with water (the second one fast), a knock on the
+handle and the pads draining, modelled as in tools/test/test_mag_sched.c.
+
+Usage: ./ssm_bench.py [--host] [--update] [--tolerance PCT] [--limit N] [--baseline JSON] <image> <capture.csv>
+       e.g. ./ssm_bench.py out/bench.elf capture.csv      (./bench.sh builds and runs this)
+            ./bench.sh --host && ./ssm_bench.py --host out/host/bench_host capture.csv
+       --update writes the counts to the baseline, check it in with the change that moved them.
+"""
+
+import argparse
+import csv
+import hashlib
+import json
+import glob
+import os
+import subprocess
+import sys
+
+import msp430_sim
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+import ssm_capture  # noqa: E402
+
+BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'baseline.json')
+CHANNELS = ssm_capture.COLUMNS[3:3 + ssm_capture.NUM_CHANNELS]
+
+# Well beyond a day of samples, only a runaway gets here
+MAX_CYCLES_PER_SAMPLE = 2000000
+
+# As in bench_main.c, the samples the magnetometer calibration may take before the counted run
+WARM_UP_MAX_SAMPLES = 4 * 72000
+
+# The nest stages: the functions bench_main.c calls for each, and the source files behind them
+STAGES = (
+    ('pad filtering', ('APP_PADF_Smooth',), ('APP/APP_PADF.c',)),
+    ('windows', ('writePadSample', 'writeMagSample', 'clearPadWindowProcess', 'clearMagWindowProcess'),
+     ('/writePadSample/', '/writeMagSample/', '/clearPadWindowProcess/', '/clearMagWindowProcess/')),
+    ('water volume', ('calculateWaterVolume',), ('/calculateWaterVolume/',)),
+    ('mag calibration', ('magnetometerCalibration',), ('/magnetometerCalibration/',)),
+    ('strokes', ('APP_STRK_Run', 'APP_STRK_AcceptWindow', 'APP_STRK_Drain'), ('APP/APP_STRK.c',)),
+    ('hourly', ('hourlyWaterVolume', 'hourlyStrokeCount', 'computePumpHealth', 'getMaxUsageTime'),
+     ('/hourlyWaterVolume/', '/hourlyStrokeCount/', '/computePumpHealth/', '/getMaxUsageTime/')),
+)
+
+# What is compared against the baseline in each mode
+METRIC = {'msp430': 'inclusive', 'host': 'statements'}
+
+
+def read_capture(path, limit):
+    with open(path, newline='') as f:
+        reader = csv.DictReader(f)
+        missing = [c for c in ssm_capture.COLUMNS if c not in reader.fieldnames]
+        if missing:
+            sys.exit('%s: not a capture file, no %s column' % (path, ', '.join(missing)))
+        rows = []
+        for row in reader:
+            if limit is not None and len(rows) >= limit:
+                break
+            flags = ((ssm_capture.FLAG_ACTIVE if int(row['active']) else 0) |
+                     (ssm_capture.FLAG_STROKES if int(row['strokes']) else 0))
+            rows.append(([int(row[c]) for c in CHANNELS], int(row['mag_status']), flags))
+    return rows
+
+
+def run(image, rows):
+    sim = msp430_sim.Msp430()
+    elf = sim.load_image(image)
+    for name in ('BENCH_NextSample', 'BENCH_Rewind', 'BENCH_Start', 'BENCH_Done'):
+        if name not in elf.symbols:
+            sys.exit('%s: no %s, build it with bench.sh' % (image, name))
+
+    position = [0]
+
+    def next_sample(s):
+        # BENCH_NextSample(int16_t * p_channels, uint8_t * p_status, uint8_t * p_flags)
+        if position[0] >= len(rows):
+            s.r[12] = 0
+            return
+        channels, status, flags = rows[position[0]]
+        position[0] += 1
+        for i, value in enumerate(channels):
+            s.store(s.r[12] + 2 * i, value & 0xFFFF, msp430_sim.WORD)
+        s.store(s.r[13], status, msp430_sim.BYTE)
+        s.store(s.r[14], flags, msp430_sim.BYTE)
+        s.r[12] = 1
+
+    def rewind(s):
+        position[0] = 0
+
+    def start(s):
+        s.reset_counts()
+
+    def done(s):
+        s.halted = True
+
+    sim.add_hook(elf.symbols['BENCH_NextSample'], next_sample)
+    sim.add_hook(elf.symbols['BENCH_Rewind'], rewind)
+    sim.add_hook(elf.symbols['BENCH_Start'], start)
+    sim.add_hook(elf.symbols['BENCH_Done'], done)
+    sim.run(max_cycles=MAX_CYCLES_PER_SAMPLE * (len(rows) + WARM_UP_MAX_SAMPLES + 1))
+
+    functions = {}
+    for name in set(sim.calls) | set(sim.self_cycles):
+        if name.startswith('BENCH_'):
+            continue
+        functions[name] = {'calls': sim.calls.get(name, 0),
+                           'inclusive': sim.inclusive.get(name, 0),
+                           'self': sim.self_cycles.get(name, 0)}
+
+    stages = {}
+    for stage, entries, _ in STAGES:
+        stages[stage] = sum(functions.get(name, {}).get('inclusive', 0) for name in entries)
+    return functions, stages
+
+
+def run_host(image, capture, limit):
+    """Runs the gcov build on the capture and sums the line counts of every function it ran."""
+    folder = os.path.dirname(os.path.abspath(image))
+    for old in glob.glob(os.path.join(folder, '*.gcda')):
+        os.remove(old)
+
+    with open(capture) as f:
+        lines = f.readlines()
+    if limit is not None:
+        lines = lines[:limit + 1]
+    subprocess.run([os.path.abspath(image)], input=''.join(lines), universal_newlines=True, check=True)
+
+    # one JSON document per source file, paths as bench.sh gave them to gcc
+    out = subprocess.run(['gcov', '--json-format', '--stdout', '-o', folder] +
+                         sorted(glob.glob(os.path.join(folder, '*.gcda'))),
+                         cwd=os.path.dirname(BASELINE), stdout=subprocess.PIPE, universal_newlines=True,
+                         check=True).stdout
+    counted = []
+    for line in out.splitlines():
+        for source in json.loads(line)['files']:
+            path = source['file']
+            if os.path.basename(path).startswith('bench_'):
+                continue
+            statements = {}
+            for counts in source['lines']:
+                name = counts.get('function_name')
+                statements[name] = statements.get(name, 0) + counts['count']
+            for function in source['functions']:
+                if function['execution_count'] or statements.get(function['name']):
+                    counted.append((path, function['name'], function['execution_count'],
+                                    statements.get(function['name'], 0)))
+
+    # the generated files each have their own static helpers, those are named with their file
+    names = [name for _, name, _, _ in counted]
+    functions = {}
+    stages = dict((stage, 0) for stage, _, _ in STAGES)
+    for path, name, calls, statements in counted:
+        if names.count(name) > 1:
+            name = '%s (%s)' % (name, os.path.basename(path))
+        functions[name] = {'calls': calls, 'statements': statements}
+        for stage, _, sources in STAGES:
+            if any(part in path for part in sources):
+                stages[stage] += statements
+    return functions, stages
+
+
+def change(now, then):
+    if then is None:
+        return 'new'
+    if then == 0:
+        return '' if now == 0 else '+inf'
+    return '%+.1f%%' % (100.0 * (now - then) / then)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='SSM algorithm cycle counts against a baseline')
+    parser.add_argument('--host', action='store_true', help='statement counts of bench.sh --host')
+    parser.add_argument('--update', action='store_true', help='write the counts to the baseline')
+    parser.add_argument('--tolerance', type=float, default=1.0, help='allowed slow down in percent (1)')
+    parser.add_argument('--limit', type=int, help='only the first N samples')
+    parser.add_argument('--baseline', default=BASELINE, help='baseline file (baseline.json here)')
+    parser.add_argument('image')
+    parser.add_argument('capture')
+    args = parser.parse_args()
+
+    mode = 'host' if args.host else 'msp430'
+    metric = METRIC[mode]
+    rows = read_capture(args.capture, args.limit)
+    with open(args.capture, 'rb') as f:
+        digest = hashlib.sha1(f.read()).hexdigest()
+
+    if args.host:
+        functions, stages = run_host(args.image, args.capture, args.limit)
+    else:
+        functions, stages = run(args.image, rows)
+
+    baseline = None
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if baseline['input_sha1'] != digest or baseline['samples'] != len(rows):
+            if not args.update:
+                sys.exit('%s is for %s (%d samples), not this input'
+                         % (args.baseline, baseline['input'], baseline['samples']))
+            baseline = None
+    old = baseline.get(mode) if baseline and not args.update else None
+
+    print('%d samples from %s' % (len(rows), os.path.basename(args.capture)))
+    regressions = []
+
+    def compare(name, now, then):
+        if then and now > then * (1.0 + args.tolerance / 100.0):
+            regressions.append(name)
+        return change(now, then) if old else ''
+
+    print('%-32s %13s %9s' % ('stage', metric, 'change'))
+    for stage, _, _ in STAGES:
+        then = old['stages'].get(stage) if old else None
+        print('%-32s %13d %9s' % (stage, stages[stage], compare(stage, stages[stage], then)))
+    print()
+
+    if args.host:
+        print('%-40s %9s %13s %10s %9s' % ('function', 'calls', 'statements', 'per call', 'change'))
+    else:
+        print('%-40s %9s %13s %10s %13s %9s' % ('function', 'calls', 'inclusive', 'per call', 'self', 'change'))
+    for name in sorted(functions, key=lambda n: (-functions[n][metric], n)):
+        f = functions[name]
+        then = old['functions'].get(name, {}).get(metric) if old else None
+        per_call = f[metric] // f['calls'] if f['calls'] else 0
+        if args.host:
+            print('%-40s %9d %13d %10d %9s' % (name, f['calls'], f[metric], per_call,
+                                              compare(name, f[metric], then)))
+        else:
+            print('%-40s %9d %13d %10d %13d %9s' % (name, f['calls'], f[metric], per_call, f['self'],
+                                                   compare(name, f[metric], then)))
+
+    if args.update:
+        # the other mode's counts stay if they are for the same input
+        if baseline is None:
+            baseline = {'input': os.path.basename(args.capture), 'input_sha1': digest, 'samples': len(rows)}
+        baseline[mode] = {'stages': stages, 'functions': functions}
+        with open(args.baseline, 'w') as f:
+            json.dump(baseline, f, indent=1, sort_keys=True)
+            f.write('\n')
+        print('%s counts updated in %s' % (mode, os.path.basename(args.baseline)))
+    elif old is None:
+        # no counts is no gate, that has to be fixed rather than pass
+        print('no %s counts in %s yet, make them with --update' % (mode, os.path.basename(args.baseline)))
+        sys.exit(1)
+
+    if regressions:
+        print('over the baseline by more than %.1f%%: %s' % (args.tolerance, ', '.join(regressions)))
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
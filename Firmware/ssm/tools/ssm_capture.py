@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""Record an SSM engineering capture ("capture on" in the CLI) to a CSV file.
+
+The capture frames (see src/APP/inc/APP_CAPTURE.h) are picked out of the
+terminal stream and rebuilt into one row per algorithm tick:
+
+    tick,active,strokes,pad1,...,pad8,mag_x,mag_y,mag_z,mag_temp,mag_status
+
+which is what the algorithm nest was given for that tick. The terminal text
+and trace records around the frames are shown on stdout as usual. Lost or
+corrupted frames are reported on stderr and never written, the rows after a
+gap start again at the next key frame.
+
+Usage: ./ssm_capture.py <output.csv> [capture file]   (reads stdin without one)
+       e.g. stty -F /dev/ttyUSB0 9600 raw && ./ssm_capture.py run1.csv /dev/ttyUSB0
+"""
+
+import sys
+
+import ssm_trace_decode
+
+SYNC = 0x1F
+NUM_CHANNELS = 12
+FLAG_KEY = 0x80
+FLAG_ACTIVE = 0x01
+FLAG_STROKES = 0x02
+STATUS_CHANGED = 1 << NUM_CHANNELS
+KEY_BODY_LEN = 4 + 2 * NUM_CHANNELS + 1
+MAX_BODY_LEN = 1 + 2 + 3 * NUM_CHANNELS + 1
+
+COLUMNS = (['tick', 'active', 'strokes'] + ['pad%d' % i for i in range(1, 9)] +
+           ['mag_x', 'mag_y', 'mag_z', 'mag_temp', 'mag_status'])
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, what the SSM CRC16 module computes."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def to_int16(value):
+    value &= 0xFFFF
+    return value - 0x10000 if value & 0x8000 else value
+
+
+class CaptureDecoder:
+    """Feed it the raw stream, it returns the rebuilt rows and the other text."""
+
+    def __init__(self, events=None):
+        self.text = ssm_trace_decode.Decoder(events if events is not None else ssm_trace_decode.load_events())
+        self.pending = bytearray()
+        self.expected_seq = None
+        self.tick = None
+        self.channels = None
+        self.status = None
+        self.frames = 0
+        self.lost = 0
+        self.bad_frames = 0
+        self.undecodable = 0
+
+    def feed(self, data):
+        self.pending += data
+        rows = []
+        text = []
+
+        while self.pending:
+            sync = self.pending.find(SYNC)
+            if sync != 0:
+                end = len(self.pending) if sync < 0 else sync
+                text.append(self.text.feed(bytes(self.pending[:end])))
+                del self.pending[:end]
+                continue
+
+            if len(self.pending) < 2:
+                break
+            length = self.pending[1]
+            if length < 2 or length > 2 + MAX_BODY_LEN:
+                self._not_a_frame(text)
+                continue
+            if len(self.pending) < 2 + length + 2:
+                break
+            frame = bytes(self.pending[:2 + length + 2])
+            if crc16(frame[1:2 + length]) != int.from_bytes(frame[-2:], 'little'):
+                self._not_a_frame(text)
+                continue
+            del self.pending[:len(frame)]
+
+            row = self._frame(frame[2], frame[3], frame[4:2 + length])
+            if row is not None:
+                rows.append(row)
+
+        return rows, ''.join(text)
+
+    def _not_a_frame(self, text):
+        # a 0x1F inside a trace record, or a damaged frame: pass the byte on and look further
+        self.bad_frames += 1
+        text.append(self.text.feed(bytes(self.pending[:1])))
+        del self.pending[:1]
+
+    def _frame(self, seq, flags, body):
+        self.frames += 1
+        if self.expected_seq is not None and seq != self.expected_seq:
+            self.lost += (seq - self.expected_seq) & 0xFF
+            self.channels = None
+        self.expected_seq = (seq + 1) & 0xFF
+
+        if flags & FLAG_KEY:
+            if len(body) != KEY_BODY_LEN:
+                self.undecodable += 1
+                self.channels = None
+                return None
+            self.tick = int.from_bytes(body[0:4], 'little')
+            self.channels = [to_int16(int.from_bytes(body[4 + 2 * i:6 + 2 * i], 'little'))
+                             for i in range(NUM_CHANNELS)]
+            self.status = body[4 + 2 * NUM_CHANNELS]
+        elif self.channels is None:
+            # nothing to apply the changes to until the next key frame
+            self.undecodable += 1
+            return None
+        elif not self._apply_delta(body):
+            self.undecodable += 1
+            self.channels = None
+            return None
+
+        return ([self.tick, int(bool(flags & FLAG_ACTIVE)), int(bool(flags & FLAG_STROKES))] +
+                self.channels + [self.status])
+
+    def _apply_delta(self, body):
+        if len(body) < 3:
+            return False
+        tick = (self.tick + body[0]) & 0xFFFFFFFF
+        mask = body[1] | (body[2] << 8)
+        channels = list(self.channels)
+        status = self.status
+        pos = 3
+
+        for i in range(NUM_CHANNELS):
+            if mask & (1 << i):
+                value, shift = 0, 0
+                while True:
+                    if pos >= len(body) or shift > 14:
+                        return False
+                    byte = body[pos]
+                    pos += 1
+                    value |= (byte & 0x7F) << shift
+                    shift += 7
+                    if not byte & 0x80:
+                        break
+                delta = (value >> 1) ^ (0xFFFF if value & 1 else 0)
+                channels[i] = to_int16(channels[i] + delta)
+        if mask & STATUS_CHANGED:
+            if pos >= len(body):
+                return False
+            status = body[pos]
+            pos += 1
+        if pos != len(body):
+            return False
+
+        self.tick, self.channels, self.status = tick, channels, status
+        return True
+
+    def summary(self):
+        return ('%d frames, %d lost, %d undecodable after a loss, %d bad frames'
+                % (self.frames, self.lost, self.undecodable, self.bad_frames))
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+
+    source = open(sys.argv[2], 'rb', buffering=0) if len(sys.argv) > 2 else sys.stdin.buffer
+    decoder = CaptureDecoder()
+
+    with open(sys.argv[1], 'w') as out:
+        out.write(','.join(COLUMNS) + '\n')
+        try:
+            while True:
+                data = source.read(256) if source is not sys.stdin.buffer else source.read1(256)
+                if not data:
+                    break
+                rows, text = decoder.feed(data)
+                for row in rows:
+                    out.write(','.join(str(v) for v in row) + '\n')
+                sys.stdout.write(text)
+                sys.stdout.flush()
+        except KeyboardInterrupt:
+            # the usual way to end a capture from a serial port
+            pass
+
+    sys.stderr.write(decoder.summary() + '\n')
+
+
+if __name__ == '__main__':
+    main()
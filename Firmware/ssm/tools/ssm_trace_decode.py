@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Render the SSM terminal output with its binary trace records as text.
+
+The SSM interleaves trace records (see src/HW/inc/HW_TRACE.h) with its normal
+terminal text. Text is passed through unchanged, each record is printed on its
+own line as "[seconds since boot] event text". The event names and formats
+are read from HW_TRACE.h, so the decoder always matches the firmware it sits
+next to.
+
+Usage: ./ssm_trace_decode.py [capture file]     (reads stdin without one)
+       e.g. stty -F /dev/ttyUSB0 9600 raw && ./ssm_trace_decode.py /dev/ttyUSB0
+"""
+
+import os
+import re
+import sys
+
+SYNC = 0x1E
+HEADER_LEN = 7
+MAX_ARGS = 4
+TICK_SECONDS = 0.01
+
+DEFAULT_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              '..', 'src', 'HW', 'inc', 'HW_TRACE.h')
+
+
+def load_events(header_path=DEFAULT_HEADER):
+    """Event formats in enum order, from the HW_TRACE_EVENTS list."""
+    with open(header_path) as f:
+        text = f.read()
+    body = text[text.index('#define HW_TRACE_EVENTS(X)'):]
+    body = body[:body.index('#define HW_TRACE_ENUM_ENTRY')]
+    return re.findall(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', body)
+
+
+def format_args(fmt, args):
+    """Apply a firmware format string to the 16 bit arguments."""
+    values = iter(args)
+
+    def convert(match):
+        value = next(values, 0)
+        if match.group(1) == 'd':
+            return str(value - 0x10000 if value & 0x8000 else value)
+        if match.group(1) == 'x':
+            return '%x' % value
+        return str(value)
+
+    return re.sub(r'%([udx])', convert, fmt)
+
+
+class Decoder:
+    """Feed it bytes as they arrive, it returns the text that is complete."""
+
+    def __init__(self, events):
+        self.events = events
+        self.pending = bytearray()
+        self.bad_records = 0
+        self.at_line_start = True
+
+    def feed(self, data):
+        self.pending += data
+        out = []
+
+        while self.pending:
+            sync = self.pending.find(SYNC)
+            if sync != 0:
+                end = len(self.pending) if sync < 0 else sync
+                out.append(self.pending[:end].decode('ascii', 'replace'))
+                del self.pending[:end]
+                continue
+
+            if len(self.pending) < HEADER_LEN:
+                break
+            num_args = self.pending[2]
+            if num_args > MAX_ARGS or self.pending[1] >= len(self.events):
+                self._reject(out)
+                continue
+            length = HEADER_LEN + 2 * num_args + 1
+            if len(self.pending) < length:
+                break
+            record = self.pending[:length]
+            if sum(record[1:]) & 0xFF:
+                self._reject(out)
+                continue
+
+            out.append(self._line(out, self._render(record, num_args)))
+            del self.pending[:length]
+
+        text = ''.join(out)
+        if text:
+            self.at_line_start = text.endswith('\n')
+        return text
+
+    def _reject(self, out):
+        # not a record after all (or a corrupted one), resync on the next sync byte
+        self.bad_records += 1
+        out.append(self._line(out, '<bad trace record>'))
+        del self.pending[:1]
+
+    def _line(self, out, text):
+        # a record interrupting a text line starts a new one
+        at_line_start = out[-1].endswith('\n') if out else self.at_line_start
+        return ('' if at_line_start else '\n') + text + '\n'
+
+    def _render(self, record, num_args):
+        tick = int.from_bytes(record[3:7], 'little')
+        args = [int.from_bytes(record[HEADER_LEN + 2 * i:HEADER_LEN + 2 * i + 2], 'little')
+                for i in range(num_args)]
+        name, fmt = self.events[record[1]]
+        return '[%10.2f] %s: %s' % (tick * TICK_SECONDS, name, format_args(fmt, args))
+
+
+def main():
+    source = open(sys.argv[1], 'rb', buffering=0) if len(sys.argv) > 1 else sys.stdin.buffer
+    decoder = Decoder(load_events())
+
+    while True:
+        data = source.read(256) if source is not sys.stdin.buffer else source.read1(256)
+        if not data:
+            break
+        sys.stdout.write(decoder.feed(data))
+        sys.stdout.flush()
+
+    if decoder.bad_records:
+        sys.stderr.write('%d bad trace records\n' % decoder.bad_records)
+
+
+if __name__ == '__main__':
+    main()
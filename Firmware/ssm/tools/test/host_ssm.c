@@ -0,0 +1,544 @@
+/**************************************************************************************************
+* \file     host_ssm.c
+* \brief    Host stand-ins for the SSM modules a test does not build, and a capture reader
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_ssm.h"
+#include "driverlib.h"
+#include "CAPT_App.h"
+#include "APP.h"
+#include "APP_WTR.h"
+#include "APP_MAG.h"
+#include "APP_PROF.h"
+#include "APP_CAPTURE.h"
+#include "APP_ALGO.h"
+#include "APP_NVM_Custom.h"
+#include "HW.h"
+#include "HW_BAT.h"
+#include "HW_CLK.h"
+#include "HW_MAG.h"
+#include "HW_TERM.h"
+#include "HW_TRACE.h"
+#include "uC_TIME.h"
+
+#define HOST_WEAK               __attribute__((weak))
+#define CAPTURE_COLUMNS         16
+#define CAPTURE_LINE_LEN        256
+#define CRC_CCITT_POLY          0x1021u
+#define MAG_STATUS_NEW_DATA     0x0Fu
+
+static uint64_t xTimeMs = 0u;
+static uint32_t xEpochBase = 0u;
+static hostCaptureRow_t xRow = {};
+static uint32_t xScanCount = 0u;
+static uint32_t xErrorBits = 0u;
+static uint32_t xTotalLiters = 0u;
+static uint16_t xCrc = 0u;
+static bool xFramWritable = false;
+static uint32_t xWakeCount = 0u;
+static bool xMagSampleHeld = false;
+static appProfStats_t xProfStats = {};
+
+// eUSCI_A1 registers
+volatile uint8_t UCA1RXBUF = 0u;
+volatile uint8_t UCA1TXBUF = 0u;
+volatile uint16_t UCA1IV = 0u;
+
+// eUSCI_B0 registers
+volatile uint16_t UCB0IV = 0u;
+
+// Port 2 and Timer_A0 registers
+volatile uint8_t P2OUT = 0u;
+volatile uint8_t P2DIR = 0u;
+volatile uint8_t P2REN = 0u;
+volatile uint8_t P2IES = 0u;
+volatile uint8_t P2IFG = 0u;
+volatile uint16_t TA0CCR0 = 0u;
+volatile uint16_t TA0CCTL0 = 0u;
+
+// Reads an ssm_capture.py CSV file, the rows are malloc'd and never freed. Exits if it can't be read.
+uint32_t HOST_LoadCapture(const char * p_path, hostCaptureRow_t ** pp_rows)
+{
+    FILE * p_file = fopen(p_path, "r");
+    char line[CAPTURE_LINE_LEN];
+    hostCaptureRow_t * p_rows = NULL;
+    uint32_t count = 0u;
+    uint32_t size = 0u;
+    int v[CAPTURE_COLUMNS];
+    int i;
+
+    if ( p_file == NULL )
+    {
+        printf("can't open %s\n", p_path);
+        exit(1);
+    }
+
+    while ( fgets(line, sizeof(line), p_file) != NULL )
+    {
+        //skips the header and anything else that isn't a row
+        if ( sscanf(line, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d",
+                    &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7],
+                    &v[8], &v[9], &v[10], &v[11], &v[12], &v[13], &v[14], &v[15]) != CAPTURE_COLUMNS )
+        {
+            continue;
+        }
+
+        if ( count == size )
+        {
+            size = (size == 0u) ? 4096u : (size * 2u);
+            p_rows = realloc(p_rows, size * sizeof(hostCaptureRow_t));
+        }
+
+        p_rows[count].tick = (uint32_t)v[0];
+        p_rows[count].active = (v[1] != 0);
+        p_rows[count].strokes = (v[2] != 0);
+
+        for ( i = 0; i < HOST_NUM_PADS; i++ )
+        {
+            p_rows[count].pads[i] = (int16_t)v[3 + i];
+        }
+
+        p_rows[count].magX = (int16_t)v[11];
+        p_rows[count].magY = (int16_t)v[12];
+        p_rows[count].magZ = (int16_t)v[13];
+        p_rows[count].magTemp = (int16_t)v[14];
+        p_rows[count].magStatus = (uint8_t)v[15];
+        count++;
+    }
+
+    fclose(p_file);
+
+    if ( count == 0u )
+    {
+        printf("no capture rows in %s\n", p_path);
+        exit(1);
+    }
+
+    *pp_rows = p_rows;
+    return count;
+}
+
+void HOST_SetTimeMs(uint64_t ms)
+{
+    xTimeMs = ms;
+}
+
+uint64_t HOST_GetTimeMs(void)
+{
+    return xTimeMs;
+}
+
+void HOST_SetEpochBase(uint32_t epoch)
+{
+    xEpochBase = epoch;
+}
+
+// The pads and magnetometer sample the stand-ins hand out until the next row, a new CapTIvate scan
+void HOST_SetRow(const hostCaptureRow_t * p_row)
+{
+    xRow = *p_row;
+    xScanCount++;
+
+    //a capture row without new data holds the last sample read, if there has been one
+    if ( p_row->magStatus == MAG_STATUS_NEW_DATA )
+    {
+        xMagSampleHeld = true;
+    }
+}
+
+uint32_t HOST_GetErrorBits(void)
+{
+    return xErrorBits;
+}
+
+bool HOST_IsFramWritable(void)
+{
+    return xFramWritable;
+}
+
+// Times an ISR woke the main loop
+uint32_t HOST_GetWakeCount(void)
+{
+    return xWakeCount;
+}
+
+void HOST_WakeOnExit(uint16_t bits)
+{
+    xWakeCount++;
+}
+
+// APP
+HOST_WEAK void APP_indicateError(uint32_t errorBit)
+{
+    xErrorBits |= errorBit;
+}
+
+HOST_WEAK uint32_t APP_getErrorBits(void)
+{
+    return xErrorBits;
+}
+
+HOST_WEAK void APP_indicateErrorResolved(uint32_t errorBit)
+{
+    xErrorBits &= ~errorBit;
+}
+
+HOST_WEAK void APP_indicateMagnetometerThresholdInterrupt(void)
+{
+}
+
+// What the ASP handlers in ssm-spi-protocol.c call, a device that stays deactivated and takes no commands
+HOST_WEAK app_state_t APP_getState(void)
+{
+    return DEACTIVATED;
+}
+
+HOST_WEAK reset_state_t APP_getResetState(void)
+{
+    return STATE_OK;
+}
+
+HOST_WEAK void APP_indicateInvalidSpiMsg(void)
+{
+}
+
+HOST_WEAK void APP_setTimeUpdated(void)
+{
+}
+
+HOST_WEAK void APP_setTimeFailed(void)
+{
+}
+
+HOST_WEAK void APP_handleConfigs(uint32_t transmissRate, bool strokeAlgIsOn, uint16_t redFlagOnThresh, uint16_t redFlagOffThresh)
+{
+}
+
+HOST_WEAK void APP_handleAttnSourceRequest(void)
+{
+}
+
+HOST_WEAK void APP_handleAttnSourceAck(asp_attn_source_payload_t *pMsg)
+{
+}
+
+HOST_WEAK void APP_handleActivateCmd(void)
+{
+}
+
+HOST_WEAK void APP_handleDeactivateCmd(void)
+{
+}
+
+HOST_WEAK void APP_handleIncrementSensorDataCmd(void)
+{
+}
+
+HOST_WEAK void APP_handleHwResetCommand(void)
+{
+}
+
+HOST_WEAK void APP_handleResetAlarmsCommand(void)
+{
+}
+
+HOST_WEAK bool APP_ALGO_isMagnetPresent(void)
+{
+    return false;
+}
+
+HOST_WEAK void APP_CAPTURE_AddSample(uint32_t tick, uint8_t flags, const padSample_t * p_pads, const magSample_t * p_mag)
+{
+}
+
+HOST_WEAK uint32_t APP_NVM_Custom_GetTotalLiters(void)
+{
+    return xTotalLiters;
+}
+
+HOST_WEAK bool APP_NVM_Custom_WriteTotalLiters(uint32_t liters)
+{
+    xTotalLiters = liters;
+    return true;
+}
+
+HOST_WEAK appProfStamp_t APP_PROF_Begin(void)
+{
+    appProfStamp_t stamp = {};
+
+    return stamp;
+}
+
+HOST_WEAK void APP_PROF_End(appProfStage_t stage, appProfStamp_t start)
+{
+}
+
+HOST_WEAK const appProfStats_t * APP_PROF_GetStats(appProfStage_t stage)
+{
+    return &xProfStats;
+}
+
+HOST_WEAK uint16_t APP_PROF_GetMean(appProfStage_t stage)
+{
+    return 0u;
+}
+
+HOST_WEAK uint16_t APP_WTR_GetPadValue(APP_WTR_PAD_CHANNELS_T pad)
+{
+    return (uint16_t)xRow.pads[pad];
+}
+
+HOST_WEAK void APP_MAG_Reset(void)
+{
+}
+
+HOST_WEAK void APP_MAG_Wake(void)
+{
+}
+
+HOST_WEAK void APP_MAG_WindowProcessed(bool activityDetected, int16_t xLsb, int16_t yLsb, int16_t zLsb)
+{
+}
+
+// HW
+HOST_WEAK uint32_t HW_CLK_GetEpochTime(void)
+{
+    return (xEpochBase == 0u) ? 0u : (xEpochBase + (uint32_t)(xTimeMs / MS_PER_S));
+}
+
+HOST_WEAK bool HW_CLK_SetEpoch(uint32_t epoch_time)
+{
+    xEpochBase = epoch_time - (uint32_t)(xTimeMs / MS_PER_S);
+    return true;
+}
+
+HOST_WEAK uint16_t HW_BAT_GetVoltage(void)
+{
+    return 0u;
+}
+
+HOST_WEAK void HW_PerformSwReset(void)
+{
+}
+
+HOST_WEAK void HW_MAG_ReadSampleIfReady(void)
+{
+}
+
+HOST_WEAK bool HW_MAG_IsSampleHeld(void)
+{
+    return xMagSampleHeld;
+}
+
+HOST_WEAK void HW_MAG_GetLatestMagAndTempData(int16_t *xLsb, int16_t *yLsb, int16_t *zLsb, int16_t *tempLsb, uint8_t *bitFlags)
+{
+    *xLsb = xRow.magX;
+    *yLsb = xRow.magY;
+    *zLsb = xRow.magZ;
+    *tempLsb = xRow.magTemp;
+    *bitFlags = xRow.magStatus;
+}
+
+HOST_WEAK void HW_TERM_Print(uint8_t * p_str)
+{
+    if ( getenv("HOST_VERBOSE") != NULL )
+    {
+        printf("  term: %s\n", (char *)p_str);
+    }
+}
+
+HOST_WEAK void HW_TRACE_Log(hwTraceEvent_t event, uint8_t numArgs, uint16_t arg0, uint16_t arg1, uint16_t arg2, uint16_t arg3)
+{
+}
+
+HOST_WEAK uint32_t CAPT_appGetScanCount(void)
+{
+    return xScanCount;
+}
+
+HOST_WEAK bool HW_TERM_CommandRdy(void)
+{
+    return false;
+}
+
+HOST_WEAK bool HW_OWI_IsBusy(void)
+{
+    return false;
+}
+
+// uC
+HOST_WEAK bool uC_SPI_FrameReady(void)
+{
+    return false;
+}
+
+HOST_WEAK bool uC_UART_IsTxBusy(void)
+{
+    return false;
+}
+
+HOST_WEAK uint64_t uC_TIME_GetRuntimeTicks(void)
+{
+    return xTimeMs / UC_TIMER_TICK_TIME_MS;
+}
+
+HOST_WEAK uint32_t uC_TIME_GetRuntimeSeconds(void)
+{
+    return (uint32_t)(xTimeMs / MS_PER_S);
+}
+
+// driverlib, the CRC module is CRC-CCITT and the FRAM write protection is only tracked
+HOST_WEAK void CRC_setSeed(uint16_t baseAddress, uint16_t seed)
+{
+    xCrc = seed;
+}
+
+HOST_WEAK void CRC_set8BitDataReversed(uint16_t baseAddress, uint8_t dataIn)
+{
+    uint8_t bit;
+
+    xCrc ^= (uint16_t)dataIn << 8;
+
+    for ( bit = 0u; bit < 8u; bit++ )
+    {
+        xCrc = ((xCrc & 0x8000u) != 0u) ? (uint16_t)((xCrc << 1) ^ CRC_CCITT_POLY) : (uint16_t)(xCrc << 1);
+    }
+}
+
+HOST_WEAK uint16_t CRC_getResult(uint16_t baseAddress)
+{
+    return xCrc;
+}
+
+// The line reads back what is driven and the timer stands still, test_owi runs both
+HOST_WEAK uint8_t HOST_ReadP2In(void)
+{
+    return P2OUT;
+}
+
+HOST_WEAK uint16_t HOST_ReadTA0R(void)
+{
+    return 0u;
+}
+
+HOST_WEAK void HOST_DelayCycles(uint32_t cycles)
+{
+}
+
+HOST_WEAK void HOST_Sleep(uint16_t bits)
+{
+}
+
+HOST_WEAK void Timer_A_initContinuousMode(uint16_t baseAddress, Timer_A_initContinuousModeParam *param)
+{
+}
+
+HOST_WEAK void Timer_A_clear(uint16_t baseAddress)
+{
+}
+
+HOST_WEAK void Timer_A_startCounter(uint16_t baseAddress, uint16_t timerMode)
+{
+}
+
+HOST_WEAK void Timer_A_stop(uint16_t baseAddress)
+{
+}
+
+HOST_WEAK void WDT_A_hold(uint16_t baseAddress)
+{
+}
+
+HOST_WEAK void EUSCI_A_SPI_initSlave(uint16_t baseAddress, EUSCI_A_SPI_initSlaveParam *param)
+{
+}
+
+HOST_WEAK void EUSCI_A_SPI_enable(uint16_t baseAddress)
+{
+}
+
+HOST_WEAK void EUSCI_A_SPI_clearInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+}
+
+HOST_WEAK void EUSCI_A_SPI_enableInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+}
+
+HOST_WEAK void EUSCI_A_SPI_transmitData(uint16_t baseAddress, uint8_t transmitData)
+{
+    UCA1TXBUF = transmitData;
+}
+
+HOST_WEAK void SysCtl_enableFRAMWrite(uint8_t memorySelect)
+{
+    xFramWritable = true;
+}
+
+HOST_WEAK void SysCtl_protectFRAMWrite(uint8_t memorySelect)
+{
+    xFramWritable = false;
+}
+
+HOST_WEAK void GPIO_setAsOutputPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+}
+
+HOST_WEAK void GPIO_setAsInputPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+}
+
+HOST_WEAK void GPIO_setAsPeripheralModuleFunctionOutputPin(uint8_t selectedPort, uint16_t selectedPins, uint8_t mode)
+{
+}
+
+HOST_WEAK void GPIO_setOutputHighOnPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+}
+
+HOST_WEAK void GPIO_setOutputLowOnPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+}
+
+HOST_WEAK uint8_t GPIO_getInputPinValue(uint8_t selectedPort, uint16_t selectedPins)
+{
+    return GPIO_INPUT_PIN_LOW;
+}
+
+HOST_WEAK void GPIO_enableInterrupt(uint8_t selectedPort, uint16_t selectedPins)
+{
+}
+
+HOST_WEAK void GPIO_disableInterrupt(uint8_t selectedPort, uint16_t selectedPins)
+{
+}
+
+HOST_WEAK void GPIO_clearInterrupt(uint8_t selectedPort, uint16_t selectedPins)
+{
+}
+
+HOST_WEAK void GPIO_selectInterruptEdge(uint8_t selectedPort, uint16_t selectedPins, uint8_t edgeSelect)
+{
+}
@@ -0,0 +1,65 @@
+/**************************************************************************************************
+* \file     host_ssm.h
+* \brief    Host stand-ins for the SSM modules a test does not build, and a capture reader
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef HOST_SSM_H_
+#define HOST_SSM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// host_ssm.c gives every test the functions the algorithm modules call into the rest of the firmware
+// (pads, magnetometer, time, errors, NVM, terminal, trace, profiler, CRC and FRAM protection). They are
+// weak, so a test that builds the real module, or needs its own behavior, just defines them.
+//
+// Time is simulated in ms and set by the test, the 10 ms runtime ticks, runtime seconds and the epoch
+// all follow it. Set HOST_VERBOSE in the environment to see the terminal output.
+
+#define HOST_NUM_PADS           8
+#define HOST_MS_PER_SAMPLE      50u
+
+// One 50 ms tick of an ssm_capture.py CSV file
+typedef struct
+{
+    uint32_t tick;
+    bool active;
+    bool strokes;
+    int16_t pads[HOST_NUM_PADS];    // pad1 to pad8, APP_WTR_PAD_CHANNELS_T order
+    int16_t magX;
+    int16_t magY;
+    int16_t magZ;
+    int16_t magTemp;
+    uint8_t magStatus;
+}hostCaptureRow_t;
+
+extern uint32_t HOST_LoadCapture(const char * p_path, hostCaptureRow_t ** pp_rows);
+
+extern void HOST_SetTimeMs(uint64_t ms);
+extern uint64_t HOST_GetTimeMs(void);
+extern void HOST_SetEpochBase(uint32_t epoch);
+extern void HOST_SetRow(const hostCaptureRow_t * p_row);
+extern uint32_t HOST_GetErrorBits(void);
+extern bool HOST_IsFramWritable(void);
+extern uint32_t HOST_GetWakeCount(void);
+
+#endif /* HOST_SSM_H_ */
@@ -0,0 +1,101 @@
+/**************************************************************************************************
+* \file     captivate.h
+* \brief    Host stand-in for the CapTIvate library header, the parts CAPT_App.c uses
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef STUBS_CAPTIVATE_H_
+#define STUBS_CAPTIVATE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "CAPT_UserConfig.h"
+#include "CAPT_App.h"
+
+// Build options as in captivate_config/CAPT_UserConfig.h
+#define __CAPT_NO_INTERFACE__                   0
+#define __CAPT_UART_INTERFACE__                 1
+#define __CAPT_BULKI2C_INTERFACE__              2
+#define CAPT_INTERFACE                          (__CAPT_NO_INTERFACE__)
+#define CAPT_WAKEONPROX_ENABLE                  (true)
+#define CAPT_WAKEONPROX_SENSOR                  (WaterPads)
+#define CAPT_CONDUCTED_NOISE_IMMUNITY_ENABLE    (false)
+#define CAPT_HAS_AUTO_NOISE_IMMUNITY            (true)
+#define CAPT_MS_TO_CYCLES(ms)                   (ms * 32)
+
+#define CAPT_TIMER_SRC_ACLK                     1
+#define CAPT_TIMER_CLKDIV__1                    0
+#define CAPT_TIMER_INTERRUPT                    0x04
+#define CAPT_COUNTER__DISABLED                  0
+
+#define GIE                                     0x0008
+#define LPM0_bits                               0x0010
+#define LPM3_bits                               0x00D0
+
+typedef enum
+{
+    eUIActive,
+    eUIWakeOnProx,
+}tCaptivateApplicationState;
+
+typedef struct
+{
+    uint8_t ui8NrOfElements;
+}tSensor;
+
+typedef struct
+{
+    tCaptivateApplicationState state;
+    uint8_t ui8AppLPM;
+    uint16_t ui16ActiveModeScanPeriod;
+    uint16_t ui16WakeOnProxModeScanPeriod;
+    uint16_t ui16InactivityTimeout;
+    uint8_t ui8WakeupInterval;
+}tCaptivateApplication;
+
+extern tCaptivateApplication g_uiApp;
+extern tSensor WaterPads;
+extern volatile bool g_bConvTimerFlag;
+extern volatile bool g_bDetectionFlag;
+extern volatile bool g_bConvCounterFlag;
+extern volatile bool g_bMaxCountErrorFlag;
+
+extern void CAPT_initUI(tCaptivateApplication * pApp);
+extern void CAPT_calibrateUI(tCaptivateApplication * pApp);
+extern void CAPT_updateUI(tCaptivateApplication * pApp);
+extern bool CAPT_getGlobalUIProximityStatus(tCaptivateApplication * pApp);
+extern void CAPT_startWakeOnProxMode(tSensor * pSensor, uint8_t ui8Frequency, uint8_t ui8Counter);
+extern void CAPT_stopWakeOnProxMode(tSensor * pSensor, uint8_t ui8Frequency);
+extern void CAPT_writeTimerCompRegister(uint16_t ui16Cycles);
+
+// Only the scan period matters to the tests, the rest of the timer is not modeled
+#define MAP_CAPT_stopTimer()
+#define MAP_CAPT_clearTimer()
+#define MAP_CAPT_startTimer()
+#define MAP_CAPT_selectTimerSource(source)
+#define MAP_CAPT_selectTimerSourceDivider(divider)
+#define MAP_CAPT_enableISR(interrupts)
+#define MAP_CAPT_disableISR(interrupts)
+#define MAP_CAPT_writeTimerCompRegister(cycles) CAPT_writeTimerCompRegister(cycles)
+#define CAPT_clearIFG(interrupts)
+#define __bis_SR_register(bits)
+
+#endif /* STUBS_CAPTIVATE_H_ */
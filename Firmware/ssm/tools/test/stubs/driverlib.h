@@ -0,0 +1,192 @@
+/**************************************************************************************************
+* \file     driverlib.h
+* \brief    Host stand-in for the MSPWare driver library, only what the tested sources use
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef STUBS_DRIVERLIB_H_
+#define STUBS_DRIVERLIB_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Values as in driverlib/MSP430FR2xx_4xx, the tests supply the functions
+
+#define GPIO_PORT_P2                        2
+#define GPIO_PORT_P3                        3
+#define GPIO_PIN2                           (0x0004)
+#define GPIO_PIN7                           (0x0080)
+#define GPIO_HIGH_TO_LOW_TRANSITION         (0x01)
+#define GPIO_LOW_TO_HIGH_TRANSITION         (0x00)
+#define GPIO_INPUT_PIN_HIGH                 (0x01)
+#define GPIO_INPUT_PIN_LOW                  (0x00)
+
+#define WDT_A_BASE                          0
+#define EUSCI_A0_BASE                       0
+#define EUSCI_A1_BASE                       0
+#define STATUS_FAIL                         0x00
+
+#define EUSCI_A_SPI_MSB_FIRST               0x80
+#define EUSCI_A_SPI_PHASE_DATA_CAPTURED_ONFIRST_CHANGED_ON_NEXT 0x00
+#define EUSCI_A_SPI_CLOCKPOLARITY_INACTIVITY_LOW 0x00
+#define EUSCI_A_SPI_3PIN                    0x00
+#define EUSCI_A_SPI_TRANSMIT_INTERRUPT      0x02
+#define EUSCI_A_SPI_RECEIVE_INTERRUPT       0x01
+
+typedef struct EUSCI_A_SPI_initSlaveParam {
+    uint16_t msbFirst;
+    uint16_t clockPhase;
+    uint16_t clockPolarity;
+    uint16_t spiMode;
+} EUSCI_A_SPI_initSlaveParam;
+
+#define GPIO_PORT_P1                        1
+#define GPIO_PIN0                           (0x0001)
+#define GPIO_PIN1                           (0x0002)
+#define GPIO_PRIMARY_MODULE_FUNCTION        (0x01)
+
+#define EUSCI_A_UART_NO_PARITY              0x00
+#define EUSCI_A_UART_LSB_FIRST              0x00
+#define EUSCI_A_UART_MODE                   0x00
+#define EUSCI_A_UART_CLOCKSOURCE_SMCLK      0x80
+#define EUSCI_A_UART_ONE_STOP_BIT           0x00
+#define EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION 0x01
+#define EUSCI_A_UART_RECEIVE_INTERRUPT      0x01
+#define EUSCI_A_UART_TRANSMIT_INTERRUPT     0x02
+#define EUSCI_A_UART_BUSY                   0x01
+
+typedef struct EUSCI_A_UART_initParam {
+    uint8_t selectClockSource;
+    uint16_t clockPrescalar;
+    uint8_t firstModReg;
+    uint8_t secondModReg;
+    uint8_t parity;
+    uint16_t msborLsbFirst;
+    uint16_t numberofStopBits;
+    uint16_t uartMode;
+    uint8_t overSampling;
+} EUSCI_A_UART_initParam;
+
+#define TIMER_A0_BASE                       0x0380
+#define TIMER_A_CLOCKSOURCE_SMCLK           0x0200
+#define TIMER_A_CLOCKSOURCE_DIVIDER_16      0x0F
+#define TIMER_A_TAIE_INTERRUPT_DISABLE      0x00
+#define TIMER_A_DO_CLEAR                    0x0004
+#define TIMER_A_CONTINUOUS_MODE             0x0020
+
+typedef struct Timer_A_initContinuousModeParam {
+    uint16_t clockSource;
+    uint16_t clockSourceDivider;
+    uint16_t timerInterruptEnable_TAIE;
+    uint16_t timerClear;
+    bool startTimer;
+} Timer_A_initContinuousModeParam;
+
+#define GPIO_PIN3                           (0x0008)
+#define EUSCI_B0_BASE                       0
+#define STATUS_SUCCESS                      0x01
+#define EUSCI_B_I2C_CLOCKSOURCE_SMCLK       0x80
+#define EUSCI_B_I2C_SET_DATA_RATE_400KBPS   400000
+#define EUSCI_B_I2C_NO_AUTO_STOP            0x00
+#define EUSCI_B_I2C_TRANSMIT_MODE           0x10
+#define EUSCI_B_I2C_RECEIVE_MODE            0x00
+#define EUSCI_B_I2C_NAK_INTERRUPT           0x20
+#define EUSCI_B_I2C_TRANSMIT_INTERRUPT0     0x02
+#define EUSCI_B_I2C_RECEIVE_INTERRUPT0      0x01
+#define EUSCI_B_I2C_BYTE_COUNTER_INTERRUPT  0x40
+#define EUSCI_B_I2C_BUS_BUSY                0x10
+#define EUSCI_B_I2C_BUS_NOT_BUSY            0x00
+#define EUSCI_B_I2C_START_SEND_COMPLETE     0x00
+#define EUSCI_B_I2C_SENDING_START           0x02
+
+typedef struct EUSCI_B_I2C_initMasterParam {
+    uint8_t selectClockSource;
+    uint32_t i2cClk;
+    uint32_t dataRate;
+    uint8_t byteCounterThreshold;
+    uint8_t autoSTOPGeneration;
+} EUSCI_B_I2C_initMasterParam;
+
+#define CRC_BASE                            0
+#define SYSCTL_FRAMWRITEPROTECTION_DATA     0x2
+#define SYSCTL_FRAMWRITEPROTECTION_PROGRAM  0x1
+
+extern void GPIO_setAsOutputPin(uint8_t selectedPort, uint16_t selectedPins);
+extern void GPIO_setOutputHighOnPin(uint8_t selectedPort, uint16_t selectedPins);
+extern void GPIO_setOutputLowOnPin(uint8_t selectedPort, uint16_t selectedPins);
+extern uint8_t GPIO_getInputPinValue(uint8_t selectedPort, uint16_t selectedPins);
+extern void GPIO_enableInterrupt(uint8_t selectedPort, uint16_t selectedPins);
+extern void GPIO_disableInterrupt(uint8_t selectedPort, uint16_t selectedPins);
+extern void GPIO_clearInterrupt(uint8_t selectedPort, uint16_t selectedPins);
+extern void GPIO_selectInterruptEdge(uint8_t selectedPort, uint16_t selectedPins, uint8_t edgeSelect);
+
+extern void CRC_setSeed(uint16_t baseAddress, uint16_t seed);
+extern void CRC_set8BitDataReversed(uint16_t baseAddress, uint8_t dataIn);
+extern uint16_t CRC_getResult(uint16_t baseAddress);
+
+extern void Timer_A_initContinuousMode(uint16_t baseAddress, Timer_A_initContinuousModeParam *param);
+extern void Timer_A_clear(uint16_t baseAddress);
+extern void Timer_A_startCounter(uint16_t baseAddress, uint16_t timerMode);
+extern void Timer_A_stop(uint16_t baseAddress);
+
+extern void WDT_A_hold(uint16_t baseAddress);
+extern void EUSCI_A_SPI_initSlave(uint16_t baseAddress, EUSCI_A_SPI_initSlaveParam *param);
+extern void EUSCI_A_SPI_enable(uint16_t baseAddress);
+extern void EUSCI_A_SPI_clearInterrupt(uint16_t baseAddress, uint8_t mask);
+extern void EUSCI_A_SPI_enableInterrupt(uint16_t baseAddress, uint8_t mask);
+extern void EUSCI_A_SPI_transmitData(uint16_t baseAddress, uint8_t transmitData);
+
+extern bool EUSCI_A_UART_init(uint16_t baseAddress, EUSCI_A_UART_initParam *param);
+extern void EUSCI_A_UART_enable(uint16_t baseAddress);
+extern void EUSCI_A_UART_transmitData(uint16_t baseAddress, uint8_t transmitData);
+extern uint8_t EUSCI_A_UART_receiveData(uint16_t baseAddress);
+extern void EUSCI_A_UART_enableInterrupt(uint16_t baseAddress, uint8_t mask);
+extern void EUSCI_A_UART_disableInterrupt(uint16_t baseAddress, uint8_t mask);
+extern void EUSCI_A_UART_clearInterrupt(uint16_t baseAddress, uint8_t mask);
+extern uint8_t EUSCI_A_UART_queryStatusFlags(uint16_t baseAddress, uint8_t mask);
+
+extern void GPIO_setAsInputPin(uint8_t selectedPort, uint16_t selectedPins);
+extern void GPIO_setAsPeripheralModuleFunctionOutputPin(uint8_t selectedPort, uint16_t selectedPins, uint8_t mode);
+extern void EUSCI_B_I2C_initMaster(uint16_t baseAddress, EUSCI_B_I2C_initMasterParam *param);
+extern void EUSCI_B_I2C_setSlaveAddress(uint16_t baseAddress, uint8_t slaveAddress);
+extern void EUSCI_B_I2C_setMode(uint16_t baseAddress, uint8_t mode);
+extern void EUSCI_B_I2C_enable(uint16_t baseAddress);
+extern void EUSCI_B_I2C_enableInterrupt(uint16_t baseAddress, uint16_t mask);
+extern void EUSCI_B_I2C_disableInterrupt(uint16_t baseAddress, uint16_t mask);
+extern void EUSCI_B_I2C_clearInterrupt(uint16_t baseAddress, uint16_t mask);
+extern uint16_t EUSCI_B_I2C_getInterruptStatus(uint16_t baseAddress, uint16_t mask);
+extern uint16_t EUSCI_B_I2C_isBusBusy(uint16_t baseAddress);
+extern uint16_t EUSCI_B_I2C_masterIsStartSent(uint16_t baseAddress);
+extern void EUSCI_B_I2C_masterSendSingleByte(uint16_t baseAddress, uint8_t txData);
+extern bool EUSCI_B_I2C_masterSendSingleByteWithTimeout(uint16_t baseAddress, uint8_t txData, uint32_t timeout);
+extern void EUSCI_B_I2C_masterSendMultiByteStart(uint16_t baseAddress, uint8_t txData);
+extern bool EUSCI_B_I2C_masterSendMultiByteStartWithTimeout(uint16_t baseAddress, uint8_t txData, uint32_t timeout);
+extern void EUSCI_B_I2C_masterSendMultiByteNext(uint16_t baseAddress, uint8_t txData);
+extern void EUSCI_B_I2C_masterSendMultiByteStop(uint16_t baseAddress);
+extern uint8_t EUSCI_B_I2C_masterReceiveSingleByte(uint16_t baseAddress);
+extern void EUSCI_B_I2C_masterReceiveStart(uint16_t baseAddress);
+extern uint8_t EUSCI_B_I2C_masterReceiveMultiByteNext(uint16_t baseAddress);
+extern bool EUSCI_B_I2C_masterReceiveMultiByteFinishWithTimeout(uint16_t baseAddress, uint8_t *txData, uint32_t timeout);
+extern void EUSCI_B_I2C_masterReceiveMultiByteStop(uint16_t baseAddress);
+extern void SysCtl_enableFRAMWrite(uint8_t memorySelect);
+extern void SysCtl_protectFRAMWrite(uint8_t memorySelect);
+
+#endif /* STUBS_DRIVERLIB_H_ */
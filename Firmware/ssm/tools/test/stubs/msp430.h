@@ -0,0 +1,104 @@
+/**************************************************************************************************
+* \file     msp430.h
+* \brief    Host stand-in for the TI device header, for the host tests
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#ifndef STUBS_MSP430_H_
+#define STUBS_MSP430_H_
+
+#include <stdint.h>
+
+#define __interrupt
+#define __no_operation()
+
+// Interrupt service routines build as plain functions the test calls, __attribute__((interrupt(vector)))
+// becomes __attribute__((unused))
+#define interrupt(vector)                   unused
+
+// One thread runs both the main loop and the ISRs, there is nothing to mask
+#define __disable_interrupt()
+#define __enable_interrupt()
+#define __even_in_range(value, range)       (value)
+
+// Waking the main loop from an ISR is counted, see HOST_GetWakeCount()
+#define LPM3_bits                           0x00D0u
+#define __bic_SR_register_on_exit(bits)     HOST_WakeOnExit(bits)
+
+extern void HOST_WakeOnExit(uint16_t bits);
+
+// eUSCI_A1 in SPI mode, the test sets UCA1IV and UCA1RXBUF and calls the ISR
+#define USCI_A1_VECTOR                      0
+#define USCI_SPI_UCRXIFG                    0x0002u
+#define USCI_SPI_UCTXIFG                    0x0004u
+
+extern volatile uint8_t UCA1RXBUF;
+extern volatile uint8_t UCA1TXBUF;
+extern volatile uint16_t UCA1IV;
+
+// eUSCI_A0 in UART mode for the terminal, the test sets UCA0IV and calls the ISR
+#define USCI_A0_VECTOR                      0
+#define USCI_NONE                           0x0000u
+#define USCI_UART_UCRXIFG                   0x0002u
+#define USCI_UART_UCTXIFG                   0x0004u
+#define USCI_UART_UCSTTIFG                  0x0006u
+#define USCI_UART_UCTXCPTIFG                0x0008u
+
+extern volatile uint16_t UCA0IV;
+
+// eUSCI_B0 in I2C master mode for the EEP, the test sets UCB0IV and calls the ISR
+#define USCI_B0_VECTOR                      0
+#define USCI_I2C_UCALIFG                    0x0002u
+#define USCI_I2C_UCNACKIFG                  0x0004u
+#define USCI_I2C_UCRXIFG0                   0x0016u
+#define USCI_I2C_UCTXIFG0                   0x0018u
+#define USCI_I2C_UCBIT9IFG                  0x001Eu
+
+extern volatile uint16_t UCB0IV;
+
+// Port 2 and Timer_A0 for the 1-wire engine. The port registers are plain bytes, the pin input, the
+// counter, the inline delays and LPM0 go through functions so a test can run the line and the clock.
+#define BIT2                                0x04u
+#define BIT6                                0x40u
+#define GIE                                 0x0008u
+#define LPM0_bits                           0x0010u
+#define CCIE                                0x0010u
+#define TIMER0_A0_VECTOR                    0
+
+#define P2IN                                HOST_ReadP2In()
+#define TA0R                                HOST_ReadTA0R()
+#define __delay_cycles(cycles)              HOST_DelayCycles(cycles)
+#define __bis_SR_register(bits)             HOST_Sleep(bits)
+
+extern volatile uint8_t P2OUT;
+extern volatile uint8_t P2DIR;
+extern volatile uint8_t P2REN;
+extern volatile uint8_t P2IES;
+extern volatile uint8_t P2IFG;
+extern volatile uint16_t TA0CCR0;
+extern volatile uint16_t TA0CCTL0;
+
+extern uint8_t HOST_ReadP2In(void);
+extern uint16_t HOST_ReadTA0R(void);
+extern void HOST_DelayCycles(uint32_t cycles);
+extern void HOST_Sleep(uint16_t bits);
+
+#endif /* STUBS_MSP430_H_ */
@@ -0,0 +1,169 @@
+#!/bin/bash
+
+#
+# Build and run the SSM host tests with gcc
+#
+# Each test_*.c here is built with the firmware sources it checks and run, each test_*.py is run with
+# python3. The generated algorithm code is copied to out/tree with rtwtypes.h set to the MSP430 sizes
+# (16 bit int16_T, 32 bit int32_T) so it wraps the same as on the part. Run from this folder, everything
+# goes to out/. Exits 1 if any test fails.
+#
+# Usage: ./test.sh [test ...]     e.g. ./test.sh test_stats
+#
+
+CC="gcc"
+SRC="../../src"
+TREE="out/tree"
+
+GENERIC_OPTIONS=(   -std=gnu99 \
+                    -O2 \
+                    -g \
+                    -Wall \
+                    -Wno-unused-function \
+                    -Wno-unknown-pragmas \
+                    -Wno-pointer-sign \
+                    -Wno-format \
+                    -Wno-address-of-packed-member \
+                    -DSSM_BUILD \
+                    -DSSM_HOST_TEST)
+
+# out/tree is first so the generated headers come from the 16 bit copy
+INCLUDE_PATHS=( -I$TREE \
+                -I. \
+                -Istubs \
+                -I$SRC \
+                -I$SRC/APP/inc \
+                -I$SRC/HW/inc \
+                -I$SRC/uC/inc \
+                -I$SRC/driverlib/lis2mdl \
+                -I$SRC/captivate_app \
+                -I../../../shared/nvm/inc \
+                -I../../../shared/asp/inc)
+
+# The generated code src/build/build.sh builds, from the 16 bit copy
+ALGO="$TREE/algo-c-code/calculateWaterVolume/addToAverage \
+      $TREE/algo-c-code/calculateWaterVolume/calculateWaterVolume \
+      $TREE/algo-c-code/calculateWaterVolume/promotePadStates \
+      $TREE/algo-c-code/calculateWaterVolume/checkWaterCalibration \
+      $TREE/algo-c-code/calculateWaterVolume/detectWaterChange \
+      $TREE/algo-c-code/calculateWaterVolume/waterCalibration \
+      $TREE/algo-c-code/clearMagWindowProcess/clearMagWindowProcess \
+      $TREE/algo-c-code/clearPadWindowProcess/clearPadWindowProcess \
+      $TREE/algo-c-code/cliResetStrokeCount/cliResetStrokeCount \
+      $TREE/algo-c-code/computePumpHealth/computePumpHealth \
+      $TREE/algo-c-code/hourlyStrokeCount/hourlyStrokeCount \
+      $TREE/algo-c-code/hourlyWaterVolume/hourlyWaterVolume \
+      $TREE/algo-c-code/getMaxUsageTime/getMaxUsageTime \
+      $TREE/algo-c-code/initializeMagCalibration/initializeMagCalibration \
+      $TREE/algo-c-code/initializeStrokeAlgorithm/initializeStrokeAlgorithm \
+      $TREE/algo-c-code/initializeWaterAlgorithm/initializeWaterAlgorithm \
+      $TREE/algo-c-code/initializeWindows/initializeWindows \
+      $TREE/algo-c-code/magnetometerCalibration/magnetometerCalibration \
+      $TREE/algo-c-code/magnetometerCalibration/isPeakValley \
+      $TREE/algo-c-code/magnetometerCalibration/trackRange \
+      $TREE/algo-c-code/wakeupDataReset/wakeupDataReset \
+      $TREE/algo-c-code/writeMagSample/writeMagSample \
+      $TREE/algo-c-code/writePadSample/writePadSample"
+
+# APP_ALGO.c and what it needs to run, host_ssm stands in for the rest of the firmware
+ALGO_APP="host_ssm \
+          $SRC/APP/APP_ALGO \
+          $SRC/APP/APP_STATS \
+          $SRC/APP/APP_STRK \
+          $SRC/APP/APP_PADF \
+          $SRC/APP/APP_CKPT \
+          $ALGO"
+
+# Firmware sources of each test, the *.c is omitted as in src/build/build.sh
+declare -A SOURCES
+SOURCES[test_stats]="$SRC/APP/APP_STATS"
+SOURCES[test_prof]="$SRC/APP/APP_PROF"
+SOURCES[test_mag_sched]="$ALGO_APP $SRC/APP/APP_MAG $SRC/HW/HW_MAG $SRC/driverlib/lis2mdl/lis2mdl_reg"
+SOURCES[test_capt_scan]="$ALGO_APP $SRC/captivate_app/CAPT_App"
+SOURCES[test_ckpt]="$ALGO_APP"
+SOURCES[test_padf]="$ALGO_APP $TREE/algo-c-code/waterPadFiltering/waterPadFiltering"
+SOURCES[test_strk]="$ALGO_APP $TREE/algo-c-code/detectTransitions/detectTransitions $TREE/algo-c-code/detectStrokes/detectStrokes"
+SOURCES[test_clock]="host_ssm $SRC/HW/HW_CLK"
+SOURCES[test_owi]="host_ssm $SRC/HW/HW_OWI $SRC/HW/HW_BAT"
+SOURCES[test_spi_link]="host_ssm $SRC/uC/uC_SPI ../../../shared/asp/am-ssm-spi-protocol"
+SOURCES[test_trace]="host_ssm $SRC/HW/HW_TRACE $SRC/uC/uC_UART"
+SOURCES[test_capture]="host_ssm $SRC/APP/APP_CAPTURE $SRC/HW/HW_TRACE $SRC/uC/uC_UART"
+SOURCES[test_eep_prefetch]="host_ssm $SRC/uC/uC_SPI $SRC/uC/uC_I2C $SRC/HW/HW_EEP $SRC/APP/APP_NVM $SRC/APP/APP_NVM_Cfg $SRC/APP/APP_NVM_Custom ../../../shared/asp/am-ssm-spi-protocol ../../../shared/asp/ssm-spi-protocol"
+
+# Extra link options, --wrap lets a test watch calls between firmware modules
+declare -A LINK_OPTIONS
+LINK_OPTIONS[test_mag_sched]="-Wl,--wrap=APP_MAG_WindowProcessed -Wl,--wrap=writeMagSample -Wl,--wrap=HW_MAG_GetLatestMagAndTempData"
+LINK_OPTIONS[test_capture]="-Wl,--wrap=uC_UART_TxNoWait"
+LINK_OPTIONS[test_ckpt]="-Wl,--wrap=APP_CKPT_Save"
+LINK_OPTIONS[test_padf]="-Wl,--wrap=calculateWaterVolume"
+LINK_OPTIONS[test_strk]="-Wl,--wrap=APP_STRK_AcceptWindow -Wl,--wrap=hourlyStrokeCount -Wl,--wrap=APP_CKPT_Save"
+
+# Run in this order when no test is named
+TESTS=( "test_stats" \
+        "test_prof" \
+        "test_mag_sched" \
+        "test_capt_scan" \
+        "test_ckpt" \
+        "test_padf" \
+        "test_strk" \
+        "test_clock" \
+        "test_spi_link" \
+        "test_owi" \
+        "test_trace" \
+        "test_trace_decode" \
+        "test_capture" \
+        "test_capture_decode" \
+        "test_eep_prefetch" \
+        "test_bench" \
+        "test_msp430_sim")
+
+mkdir -p out
+
+# The generated code, with the part's type sizes
+rm -rf $TREE
+mkdir -p $TREE
+cp -r $SRC/algo-c-code $TREE/
+for TYPES in $(find $TREE -name rtwtypes.h); do
+    sed -i -e 's/^typedef int int16_T;/typedef short int16_T;/' \
+           -e 's/^typedef unsigned int uint16_T;/typedef unsigned short uint16_T;/' \
+           -e 's/^typedef long int32_T;/typedef int int32_T;/' \
+           -e 's/^typedef unsigned long uint32_T;/typedef unsigned int uint32_T;/' $TYPES
+done
+
+# calculateWaterVolume.c before the add_to_buffer() hand edit, next to its headers for test_padf
+cp ref/calculateWaterVolume.c $TREE/algo-c-code/calculateWaterVolume/calculateWaterVolume_gen.c
+
+if [ $# -ne 0 ]
+then
+    TESTS=( "$@" )
+fi
+
+FAILED=()
+
+for TEST in "${TESTS[@]}"; do
+    echo Running: $TEST
+    if [ -f $TEST.py ]
+    then
+        python3 $TEST.py
+    else
+        OBJECTS=()
+        for FILE in ${SOURCES[$TEST]}; do
+            OBJECTS+=($FILE.c)
+        done
+        BUILD_COMMAND="$CC ${GENERIC_OPTIONS[@]} ${INCLUDE_PATHS[@]} -o out/$TEST $TEST.c ${OBJECTS[@]} ${LINK_OPTIONS[$TEST]} -lm"
+        echo $BUILD_COMMAND
+        $BUILD_COMMAND && out/$TEST
+    fi
+    if [ $? -ne 0 ]
+    then
+        FAILED+=($TEST)
+    fi
+    echo
+done
+
+if [ ${#FAILED[@]} -ne 0 ]
+then
+    echo Failed: ${FAILED[@]}
+    exit 1
+fi
+echo All ${#TESTS[@]} tests passed
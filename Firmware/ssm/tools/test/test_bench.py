@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""Checks of the benchmark gate, ssm_bench.py --host on the checked in input.
+
+Builds the statement count benchmark (bench.sh --host) and runs it on
+bench/capture.csv against bench/baseline.json, which has to pass: an algorithm
+change that makes a stage or a function run more than 1% more statements fails
+here until the baseline is updated with it. The gate is then run against
+copies of the baseline made a little smaller, so the same counts look like a
+slow down: past the tolerance in one stage or one function has to fail and
+name it, inside the tolerance has to pass, and a baseline with no counts for
+the mode has to fail. The warm up has to have calibrated the magnetometer, or
+the stroke detector would not run at all.
+
+Usage: python3 test_bench.py      (from this folder, test.sh runs it)
+"""
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+BENCH = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'bench')
+BASELINE = os.path.join(BENCH, 'baseline.json')
+CAPTURE = os.path.join(BENCH, 'capture.csv')
+IMAGE = os.path.join(BENCH, 'out', 'host', 'bench_host')
+
+TOLERANCE_PERCENT = 1.0
+
+passed = True
+
+
+def check(condition, what):
+    global passed
+    print('  %s: %s' % ('ok  ' if condition else 'FAIL', what))
+    passed = passed and condition
+
+
+def gate(baseline, *extra):
+    result = subprocess.run([sys.executable, os.path.join(BENCH, 'ssm_bench.py'), '--host',
+                             '--tolerance', str(TOLERANCE_PERCENT), '--baseline', baseline] +
+                            list(extra) + [IMAGE, CAPTURE],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    return result.returncode, result.stdout
+
+
+def over(output):
+    lines = [line for line in output.splitlines() if line.startswith('over the baseline')]
+    return lines[0].split(': ', 1)[1].split(', ') if lines else []
+
+
+def main():
+    build = subprocess.run(['./bench.sh', '--host'], cwd=BENCH, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                           universal_newlines=True)
+    check(build.returncode == 0, 'bench.sh --host builds')
+    if build.returncode != 0:
+        print(build.stdout)
+        print('FAIL')
+        return 1
+
+    with open(BASELINE) as f:
+        baseline = json.load(f)
+    host = baseline.get('host')
+    check(host is not None, 'baseline.json has host counts for %s' % baseline['input'])
+    if host is None:
+        print('FAIL')
+        return 1
+
+    code, output = gate(BASELINE)
+    check(code == 0 and not over(output), 'the checked in input runs within %.1f%% of baseline.json' % TOLERANCE_PERCENT)
+    if code != 0:
+        print(output)
+
+    strokes = host['functions'].get('xStroke', {}).get('calls', 0)
+    check(strokes > 0 and host['stages']['strokes'] > 0, 'the stroke detector ran, xStroke called %d times' % strokes)
+
+    with tempfile.TemporaryDirectory() as folder:
+        def shrunk(stages, functions, percent):
+            copy = json.loads(json.dumps(baseline))
+            for name in stages:
+                copy['host']['stages'][name] = int(copy['host']['stages'][name] / (1.0 + percent / 100.0))
+            for name in functions:
+                copy['host']['functions'][name]['statements'] = \
+                    int(copy['host']['functions'][name]['statements'] / (1.0 + percent / 100.0))
+            path = os.path.join(folder, 'baseline.json')
+            with open(path, 'w') as f:
+                json.dump(copy, f)
+            return path
+
+        for stage in sorted(host['stages']):
+            if host['stages'][stage] < 1000:
+                continue
+            code, output = gate(shrunk([stage], [], 2.0))
+            check(code == 1 and over(output) == [stage], '%s 2%% over the baseline fails' % stage)
+
+        code, output = gate(shrunk(['water volume'], [], 0.5))
+        check(code == 0, 'water volume 0.5% over the baseline passes')
+
+        code, output = gate(shrunk([], ['xStroke'], 5.0))
+        check(code == 1 and over(output) == ['xStroke'], 'xStroke alone 5% over the baseline fails')
+
+        code, output = gate(BASELINE, '--limit', '1000')
+        check(code != 0 and 'not this input' in output, 'a baseline for another input is refused')
+
+        copy = json.loads(json.dumps(baseline))
+        del copy['host']
+        path = os.path.join(folder, 'baseline.json')
+        with open(path, 'w') as f:
+            json.dump(copy, f)
+        code, output = gate(path)
+        check(code == 1 and 'no host counts' in output, 'a baseline without counts for the mode fails the gate')
+
+    print('PASS' if passed else 'FAIL')
+    return 0 if passed else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,508 @@
+/**************************************************************************************************
+* \file     test_capt_scan.c
+* \brief    Replay of the CapTIvate scan mode against the water volume
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "host_ssm.h"
+#include "captivate.h"
+#include "APP_ALGO.h"
+#include "uC_TIME.h"
+
+// Runs CAPT_appHandler() and the real APP_ALGO over pump sessions, and does the same with the scan mode
+// logic CAPT_App.c had before it followed the water algorithm (xOldAppHandler: wake on proximity scans
+// every 50 ms, back to them 5 minutes after the last proximity detection). The new logic leaves active
+// scanning 30 s after a touch that brings no water, so a pump that takes a while to prime starts its
+// session on the wake on proximity scan that sees the water arrive, and the algorithm windows start over
+// there. The liters of each session type, summed over NUM_PHASES runs with the sessions shifted by
+// PHASE_STEP_MS each time, have to agree within LITERS_TOLERANCE_PERCENT.
+//
+// Proximity is a hand near the pads or water over them: any pad more than PROX_COUNTS from its dry
+// count, the long term average is halted during proximity so standing water holds it.
+//
+// Usage: test_capt_scan
+
+#define SYNTH_HOURS                 8u
+#define MS_PER_HOUR                 3600000ul
+#define LOOP_TICK_MS                10u
+
+#define SESSION_EVERY_MS            (12ul * 60ul * 1000ul)
+#define NUM_SESSION_TYPES           6u
+#define PAD_DRY_COUNT               1200
+#define PAD_WET_DROP                260
+#define PROX_COUNTS                 20
+#define SEC_PER_PAD_RISE            3.0
+#define SEC_PER_PAD_DRAIN           4.0
+
+#define NUM_PHASES                  10u
+#define PHASE_STEP_MS               10u
+#define LITERS_TOLERANCE_PERCENT    3u
+#define OLD_WOP_SCAN_PERIOD_MS      50u
+
+// As in captivate_config/CAPT_UserConfig.c
+#define ACTIVE_SCAN_PERIOD_MS       50u
+#define WAKE_ON_PROX_SCAN_PERIOD_MS 100u
+#define INACTIVITY_TIMEOUT_SAMPLES  6000u
+
+typedef struct
+{
+    const char * p_name;
+    double touchSec;        // hand near the pads from the start of the session
+    double primeSec;        // pumping before the water gets to the bottom pad
+    double flowSec;         // water flowing, 0 for none
+    double depthPads;       // how far up the pads the water stands while flowing
+    double gapSec;          // a second draw this long after the first ends, 0 for none
+}sessionType_t;
+
+typedef struct
+{
+    uint32_t liters;
+    uint32_t typeLiters[NUM_SESSION_TYPES];
+    uint32_t activeScans;
+    uint32_t wopScans;
+    uint32_t activeMs;
+    uint32_t wakes;
+}runResult_t;
+
+static const sessionType_t xSessionTypes[NUM_SESSION_TYPES] =
+{
+    { "normal",       2.0,  5.0, 200.0, 7.2,  0.0 },
+    { "slow prime",   3.0, 45.0, 150.0, 7.2,  0.0 },    // water arrives after the 30 s no water timeout
+    { "touch",       10.0,  0.0,   0.0, 0.0,  0.0 },
+    { "two draws",    2.0,  5.0,  60.0, 7.2, 60.0 },
+    { "trickle",      2.0, 10.0, 120.0, 2.2,  0.0 },    // only the bottom pads see it
+    { "late prime",   2.0, 70.0,  90.0, 7.2,  0.0 },
+};
+
+tCaptivateApplication g_uiApp =
+{
+    .state = eUIActive,
+    .ui8AppLPM = LPM3_bits,
+    .ui16ActiveModeScanPeriod = ACTIVE_SCAN_PERIOD_MS,
+    .ui16WakeOnProxModeScanPeriod = WAKE_ON_PROX_SCAN_PERIOD_MS,
+    .ui16InactivityTimeout = INACTIVITY_TIMEOUT_SAMPLES,
+    .ui8WakeupInterval = CAPT_COUNTER__DISABLED,
+};
+tSensor WaterPads = { .ui8NrOfElements = HOST_NUM_PADS };
+volatile bool g_bConvTimerFlag = false;
+volatile bool g_bDetectionFlag = false;
+volatile bool g_bConvCounterFlag = false;
+volatile bool g_bMaxCountErrorFlag = false;
+
+static bool xPumpActive = false;
+static uint16_t xScanPeriodMs = ACTIVE_SCAN_PERIOD_MS;
+static uint64_t xNowMs = 0u;
+static uint32_t xPhaseMs = 0u;
+static runResult_t xResult;
+
+static void xSynthRow(uint64_t ms, hostCaptureRow_t * p_row, bool * p_touch);
+static bool xProximity(uint64_t ms);
+static uint32_t xHash(uint32_t value);
+static void xOldAppHandler(void);
+static void xRunOne(bool oldScanMode, runResult_t * p_result);
+static bool xRunForked(bool oldScanMode, runResult_t * p_result);
+static void xAddResult(runResult_t * p_total, const runResult_t * p_run);
+
+// Host stand-ins for the CapTIvate library, a scan takes the pads of the current 50 ms row
+
+void CAPT_initUI(tCaptivateApplication * pApp)
+{
+}
+
+void CAPT_calibrateUI(tCaptivateApplication * pApp)
+{
+}
+
+void CAPT_updateUI(tCaptivateApplication * pApp)
+{
+    hostCaptureRow_t row;
+    bool touch;
+
+    xSynthRow(xNowMs, &row, &touch);
+    HOST_SetRow(&row);
+    xResult.activeScans++;
+}
+
+bool CAPT_getGlobalUIProximityStatus(tCaptivateApplication * pApp)
+{
+    return xProximity(xNowMs);
+}
+
+void CAPT_startWakeOnProxMode(tSensor * pSensor, uint8_t ui8Frequency, uint8_t ui8Counter)
+{
+}
+
+void CAPT_stopWakeOnProxMode(tSensor * pSensor, uint8_t ui8Frequency)
+{
+}
+
+void CAPT_writeTimerCompRegister(uint16_t ui16Cycles)
+{
+    xScanPeriodMs = ui16Cycles / CAPT_MS_TO_CYCLES(1u);
+}
+
+// What APP.c does with it
+void APP_setPumpActive(bool active)
+{
+    xPumpActive = active;
+
+    if ( active == true )
+    {
+        APP_ALGO_wakeUpInit();
+        xResult.wakes++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    runResult_t old;
+    runResult_t new;
+    runResult_t oldRun;
+    runResult_t newRun;
+    uint32_t oldMin = UINT32_MAX;
+    uint32_t oldMax = 0u;
+    bool pass = true;
+    uint32_t diff;
+    uint32_t i;
+    uint32_t phase;
+
+    printf("replaying %u synthetic hours %u times, a session every %lu minutes:", SYNTH_HOURS, NUM_PHASES, SESSION_EVERY_MS / 60000ul);
+
+    for ( i = 0u; i < NUM_SESSION_TYPES; i++ )
+    {
+        printf(" %s%s", xSessionTypes[i].p_name, (i + 1u < NUM_SESSION_TYPES) ? "," : "\n");
+    }
+
+    memset(&old, 0, sizeof(old));
+    memset(&new, 0, sizeof(new));
+
+    //a 10 ms shift in when the water arrives moves a session by a few percent either way, so the two
+    //scan modes are compared over the same set of shifts
+    for ( phase = 0u; phase < NUM_PHASES; phase++ )
+    {
+        xPhaseMs = phase * PHASE_STEP_MS;
+
+        if ( (xRunForked(true, &oldRun) == false) || (xRunForked(false, &newRun) == false) )
+        {
+            printf("FAIL: replay did not finish\n");
+            return 1;
+        }
+
+        xAddResult(&old, &oldRun);
+        xAddResult(&new, &newRun);
+        oldMin = (oldRun.liters < oldMin) ? oldRun.liters : oldMin;
+        oldMax = (oldRun.liters > oldMax) ? oldRun.liters : oldMax;
+        printf("  shift %2u ms: %u liters with the 5 min timeout, %u water driven\n", xPhaseMs, oldRun.liters, newRun.liters);
+    }
+
+    printf("  5 min timeout liters move %.1f%% between shifts\n", (100.0 * (oldMax - oldMin)) / oldMin);
+    printf("\n                          5 min timeout   water driven\n");
+    printf("  liters                  %8u        %8u\n", old.liters, new.liters);
+    printf("  active scans            %8u        %8u  (%.0f%%)\n", old.activeScans, new.activeScans, (100.0 * new.activeScans) / old.activeScans);
+    printf("  wake on prox scans      %8u        %8u\n", old.wopScans, new.wopScans);
+    printf("  active                  %7.0f%%        %7.0f%%\n", (100.0 * old.activeMs) / (NUM_PHASES * SYNTH_HOURS * MS_PER_HOUR),
+           (100.0 * new.activeMs) / (NUM_PHASES * SYNTH_HOURS * MS_PER_HOUR));
+    printf("  sessions started        %8u        %8u\n", old.wakes, new.wakes);
+
+    for ( i = 0u; i < NUM_SESSION_TYPES; i++ )
+    {
+        diff = (old.typeLiters[i] > new.typeLiters[i]) ? (old.typeLiters[i] - new.typeLiters[i]) : (new.typeLiters[i] - old.typeLiters[i]);
+        printf("  %-12s liters      %8u        %8u  (%+.1f%%)\n", xSessionTypes[i].p_name, old.typeLiters[i], new.typeLiters[i],
+               (old.typeLiters[i] == 0u) ? 0.0 : ((100.0 * ((double)new.typeLiters[i] - old.typeLiters[i])) / old.typeLiters[i]));
+
+        if ( (diff * 100u) > (old.typeLiters[i] * LITERS_TOLERANCE_PERCENT) )
+        {
+            printf("  FAIL: %s sessions are more than %u%% off\n", xSessionTypes[i].p_name, LITERS_TOLERANCE_PERCENT);
+            pass = false;
+        }
+    }
+
+    if ( old.liters == 0u )
+    {
+        printf("  FAIL: no water counted\n");
+        pass = false;
+    }
+
+    if ( new.activeMs >= old.activeMs )
+    {
+        printf("  FAIL: no less time in active scanning\n");
+        pass = false;
+    }
+
+    printf("%s\n", (pass == true) ? "PASS" : "FAIL");
+
+    return (pass == true) ? 0 : 1;
+}
+
+static void xAddResult(runResult_t * p_total, const runResult_t * p_run)
+{
+    uint32_t i;
+
+    p_total->liters += p_run->liters;
+    p_total->activeScans += p_run->activeScans;
+    p_total->wopScans += p_run->wopScans;
+    p_total->activeMs += p_run->activeMs;
+    p_total->wakes += p_run->wakes;
+
+    for ( i = 0u; i < NUM_SESSION_TYPES; i++ )
+    {
+        p_total->typeLiters[i] += p_run->typeLiters[i];
+    }
+}
+
+// Each run starts the firmware modules from their power up state, so it gets its own process
+static bool xRunForked(bool oldScanMode, runResult_t * p_result)
+{
+    int fds[2];
+    pid_t pid;
+    int status = 0;
+    bool done;
+
+    if ( pipe(fds) != 0 )
+    {
+        return false;
+    }
+
+    fflush(stdout);
+    pid = fork();
+
+    if ( pid == 0 )
+    {
+        close(fds[0]);
+        xRunOne(oldScanMode, p_result);
+        done = (write(fds[1], p_result, sizeof(runResult_t)) == sizeof(runResult_t));
+        _exit((done == true) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    done = (read(fds[0], p_result, sizeof(runResult_t)) == sizeof(runResult_t));
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    return (done == true) && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+// The CapTIvate timer sets the conversion flag every active scan period, in wake on proximity mode the
+// hardware scans on its own and sets the detection flag. The background loop runs the handler and the
+// algorithm nest every 50 ms as main.c and APP.c do.
+static void xRunOne(bool oldScanMode, runResult_t * p_result)
+{
+    APP_NVM_SENSOR_DATA_T sensorData;
+    uint64_t ms;
+    uint64_t lastScanMs = 0u;
+    uint32_t session;
+
+    memset(&xResult, 0, sizeof(xResult));
+    memset(&sensorData, 0, sizeof(sensorData));
+
+    APP_ALGO_Init();
+    CAPT_appStart();
+    APP_setPumpActive(true);
+
+    for ( ms = 0u; ms < (SYNTH_HOURS * MS_PER_HOUR); ms += LOOP_TICK_MS )
+    {
+        xNowMs = ms;
+        HOST_SetTimeMs(ms);
+
+        if ( (ms - lastScanMs) >= xScanPeriodMs )
+        {
+            lastScanMs = ms;
+
+            if ( g_uiApp.state == eUIActive )
+            {
+                g_bConvTimerFlag = true;
+            }
+            else
+            {
+                xResult.wopScans++;
+
+                if ( xProximity(ms) == true )
+                {
+                    g_bDetectionFlag = true;
+                }
+            }
+        }
+
+        if ( oldScanMode == true )
+        {
+            xOldAppHandler();
+        }
+        else
+        {
+            CAPT_appHandler();
+        }
+
+        if ( g_uiApp.state == eUIActive )
+        {
+            xResult.activeMs += LOOP_TICK_MS;
+        }
+
+        if ( (ms % HOST_MS_PER_SAMPLE) != 0u )
+        {
+            continue;
+        }
+
+        APP_ALGO_Nest(xPumpActive);
+
+        //the volume is taken at the end of each session rather than each hour
+        if ( ((ms + HOST_MS_PER_SAMPLE) % SESSION_EVERY_MS) == 0u )
+        {
+            session = (uint32_t)(ms / SESSION_EVERY_MS);
+            APP_ALGO_updateHourlyFields(&sensorData, (uint8_t)(session % HOUR_PER_DAY));
+            xResult.typeLiters[session % NUM_SESSION_TYPES] += sensorData.litersPerHour[session % HOUR_PER_DAY];
+            xResult.liters += sensorData.litersPerHour[session % HOUR_PER_DAY];
+        }
+    }
+
+    *p_result = xResult;
+}
+
+// CAPT_appHandler() as it was: back to wake on proximity 5 minutes after the last proximity detection
+static void xOldAppHandler(void)
+{
+    static uint16_t sessionTimeout = 1u;
+
+    if ( g_uiApp.state == eUIActive )
+    {
+        if ( g_bConvTimerFlag == true )
+        {
+            g_bConvTimerFlag = false;
+            CAPT_updateUI(&g_uiApp);
+
+            if ( CAPT_getGlobalUIProximityStatus(&g_uiApp) == true )
+            {
+                sessionTimeout = g_uiApp.ui16InactivityTimeout;
+            }
+            else if ( --sessionTimeout == 0u )
+            {
+                g_uiApp.state = eUIWakeOnProx;
+                APP_setPumpActive(false);
+                CAPT_writeTimerCompRegister(CAPT_MS_TO_CYCLES(OLD_WOP_SCAN_PERIOD_MS));
+                g_bConvTimerFlag = false;
+            }
+        }
+    }
+    else if ( g_bDetectionFlag == true )
+    {
+        g_bDetectionFlag = false;
+        g_uiApp.state = eUIActive;
+        sessionTimeout = g_uiApp.ui16InactivityTimeout;
+        APP_setPumpActive(true);
+        CAPT_writeTimerCompRegister(CAPT_MS_TO_CYCLES(g_uiApp.ui16ActiveModeScanPeriod));
+    }
+}
+
+static bool xProximity(uint64_t ms)
+{
+    hostCaptureRow_t row;
+    bool touch;
+    int i;
+
+    xSynthRow(ms, &row, &touch);
+
+    for ( i = 0; i < HOST_NUM_PADS; i++ )
+    {
+        if ( abs(row.pads[i] - (PAD_DRY_COUNT + (10 * i))) > PROX_COUNTS )
+        {
+            touch = true;
+        }
+    }
+
+    return touch;
+}
+
+// The pads at any ms: the water rises up from pad8 once the pump has primed, sloshes with each stroke
+// and drains when the pumping stops
+static void xSynthRow(uint64_t ms, hostCaptureRow_t * p_row, bool * p_touch)
+{
+    const sessionType_t * p_type;
+    double sec;
+    double flowStart;
+    double flowEnd;
+    double level = 0.0;
+    double cover;
+    uint32_t sample = (uint32_t)(ms / HOST_MS_PER_SAMPLE);
+    uint32_t noise;
+    int i;
+
+    //the sessions of each run are shifted a little against the scan and sample times
+    ms += xPhaseMs;
+    p_type = &xSessionTypes[(ms / SESSION_EVERY_MS) % NUM_SESSION_TYPES];
+    sec = (double)(ms % SESSION_EVERY_MS) / 1000.0;
+    flowStart = p_type->primeSec;
+    flowEnd = flowStart + p_type->flowSec;
+
+    //the second draw is the first one again
+    if ( (p_type->gapSec > 0.0) && (sec >= (flowEnd + p_type->gapSec)) )
+    {
+        sec -= flowEnd + p_type->gapSec;
+    }
+
+    if ( p_type->flowSec > 0.0 )
+    {
+        if ( (sec >= flowStart) && (sec < flowEnd) )
+        {
+            level = fmin(p_type->depthPads, (sec - flowStart) / SEC_PER_PAD_RISE) + (0.4 * sin(2.0 * M_PI * 1.5 * sec));
+        }
+        else if ( sec >= flowEnd )
+        {
+            level = fmax(0.0, p_type->depthPads - ((sec - flowEnd) / SEC_PER_PAD_DRAIN));
+        }
+    }
+
+    memset(p_row, 0, sizeof(hostCaptureRow_t));
+    p_row->tick = sample;
+    p_row->magStatus = 0u;
+
+    //pad8 is at the bottom and covers first
+    for ( i = 0; i < HOST_NUM_PADS; i++ )
+    {
+        cover = fmin(1.0, fmax(0.0, level - (HOST_NUM_PADS - 1 - i)));
+        noise = xHash((sample * HOST_NUM_PADS) + (uint32_t)i);
+        p_row->pads[i] = (int16_t)(PAD_DRY_COUNT + (10 * i) - (int)(PAD_WET_DROP * cover) + (int)(noise % 5u) - 2);
+
+        if ( cover > 0.0 )
+        {
+            p_row->pads[i] += (int16_t)((int)((noise >> 8) % 13u) - 6);
+        }
+    }
+
+    *p_touch = (sec < p_type->touchSec) && ((ms % SESSION_EVERY_MS) / 1000.0 < p_type->touchSec);
+}
+
+static uint32_t xHash(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x7FEB352Du;
+    value ^= value >> 15;
+    value *= 0x846CA68Bu;
+    value ^= value >> 16;
+
+    return value;
+}
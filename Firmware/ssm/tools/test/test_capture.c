@@ -0,0 +1,685 @@
+/**************************************************************************************************
+* \file     test_capture.c
+* \brief    Host test of the capture frame encoder and of its throughput at the terminal baud rate
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <msp430.h>
+#include "driverlib.h"
+#include "host_ssm.h"
+#include "HW.h"
+#include "APP_CAPTURE.h"
+#include "HW_TRACE.h"
+#include "uC_UART.h"
+
+// Runs APP_CAPTURE.c, HW_TRACE.c and uC_UART.c against the simulated eUSCI_A0 of test_trace, with MCLK
+// counted in cycles and the line rate set per run. uC_UART_TxNoWait() is wrapped to see every frame the
+// encoder queues or drops.
+//
+// traces/capture_stream.bin is what the fixed sequence below puts on the wire: realistic pad and
+// magnetometer samples with terminal text and trace records between the frames, a tick gap, the 32 bit
+// tick wrapping, channels swinging across the whole 16 bit range, then random (all key frame) samples
+// while text bursts fill the ring so frames are dropped, then realistic samples again.
+// traces/capture_stream.csv has the samples given to APP_CAPTURE_AddSample() in ssm_capture.py's CSV
+// columns, with DROPPED for the frames that did not fit. Both were recorded with --record and the
+// encoder has to give them back byte for byte. test_capture_decode.py decodes the stream with
+// ssm_capture.py and has to get every sent row back.
+//
+// Then the budget: at 9600 and 19200 baud (STREAM_ENGINEERING_DATA) the longest frame at 20 Hz has to
+// fit 80% of the line, a minute of worst case frames with the status line and field trace events must
+// not drop one, and 10 minutes of realistic frames with the CLI bursts on top must not drop one either.
+//
+// Usage: test_capture               run the checks
+//        test_capture --record      write the fixed sequence to traces/capture_stream.bin and .csv
+
+#define STREAM_PATH                 "traces/capture_stream.bin"
+#define TRUTH_PATH                  "traces/capture_stream.csv"
+#define TRUTH_COLUMNS               "tick,active,strokes,pad1,pad2,pad3,pad4,pad5,pad6,pad7,pad8,mag_x,mag_y,mag_z,mag_temp,mag_status"
+
+#define CYCLES_PER_MS               16000u
+#define MCLK_HZ                     16000000u
+#define ISR_CYCLES                  45u             // entry, one byte or the disable, reti
+#define POLL_CYCLES                 8u              // one pass of a loop on the status flags
+#define ENCODE_CYCLES               2900u           // encode, CRC and queue a worst case frame
+#define ALGO_CYCLES                 (6u * CYCLES_PER_MS)
+#define SPRINTF_CYCLES              2400u
+#define COPY_CYCLES(len)            (100u + (6u * (len)))
+#define TRACE_CYCLES                350u
+
+#define CAPTURE_RATE_HZ             20u
+#define MS_PER_TICK                 50u
+#define RUNTIME_TICKS_PER_TICK      5u              // the frame tick is the 10 ms runtime tick
+#define TICK_CYCLES                 (MS_PER_TICK * CYCLES_PER_MS)
+#define STATUS_LEN                  72u
+#define STATUS_PERIOD_TICKS         20u
+#define CLI_LINES                   10u
+#define CLI_LEN                     38u
+#define CLI_PERIOD_TICKS            300u
+#define EVENT_PERIOD_TICKS          20u
+#define WORST_CASE_TICKS            (60u * CAPTURE_RATE_HZ)
+#define REALISTIC_TICKS             (600u * CAPTURE_RATE_HZ)
+#define LINE_SHARE_PERCENT          80u
+#define BITS_PER_BYTE               10u             // start and stop bits
+
+#define WIRE_BYTES                  (1024u * 1024u)
+#define TRUTH_BYTES                 (1024u * 1024u)
+#define BURST_LEN                   500u
+#define NUM_BAUD_RATES              2u
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t dropped;
+    uint32_t frameBytes;
+    uint32_t longest;
+    uint32_t textBytes;
+    uint32_t records;
+    uint32_t wireBytes;
+}stream_t;
+
+static const uint32_t xBaudRates[NUM_BAUD_RATES] = { 9600u, 19200u };
+
+volatile uint16_t UCA0IV;
+
+extern void EUSCI_A0_ISR(void);
+extern bool __real_uC_UART_TxNoWait(const uint8_t * p_buf, uint16_t len);
+
+static bool xPass = true;
+static uint64_t xCycles = 0u;
+static uint32_t xCharCycles = 0u;
+static bool xShifting = false;
+static uint64_t xShiftEnd = 0u;
+static uint8_t xShiftByte = 0u;
+static bool xTxBufFull = false;
+static uint8_t xTxBuf = 0u;
+static bool xTxIe = false;
+static bool xInIsr = false;
+static uint8_t * xWire = NULL;
+static uint32_t xWireLen = 0u;
+static char * xTruth = NULL;
+static uint32_t xTruthLen = 0u;
+static uint32_t xSeed = 1u;
+
+// what the wrap saw of the capture frames
+static stream_t xStream;
+static bool xLastQueued = true;
+static uint8_t xNextSequence = 0u;
+static uint32_t xSequenceErrors = 0u;
+static uint32_t xNotKeyAfterDrop = 0u;
+
+static void xCheck(bool condition, const char * p_what);
+static void xDispatch(void);
+static void xShiftDone(void);
+static void xRun(uint64_t cycles);
+static void xIdle(uint64_t until);
+static void xReset(uint32_t baud);
+static void xText(const char * p_text);
+static void xPrint(uint16_t len);
+static uint16_t xRandom(void);
+static void xRealistic(uint32_t n, padSample_t * p_pads, magSample_t * p_mag);
+static void xWorstCase(padSample_t * p_pads, magSample_t * p_mag);
+static void xSample(uint32_t tick, uint8_t flags, const padSample_t * p_pads, const magSample_t * p_mag);
+static void xRecordSequence(void);
+static void xRunStream(uint32_t baud, bool worstCase, bool cliBursts, uint32_t ticks);
+static bool xReadFile(const char * p_path, uint8_t ** pp_data, uint32_t * p_len);
+static bool xWriteFile(const char * p_path, const void * p_data, uint32_t len);
+
+int main(int argc, char * argv[])
+{
+    uint8_t * p_reference = NULL;
+    uint32_t referenceLen = 0u;
+    uint32_t baud;
+    uint32_t i;
+    char what[120];
+
+    xWire = malloc(WIRE_BYTES);
+    xTruth = malloc(TRUTH_BYTES);
+
+    if ( (argc > 1) && (strcmp(argv[1], "--record") == 0) )
+    {
+        xRecordSequence();
+        if ( (xWriteFile(STREAM_PATH, xWire, xWireLen) == false) || (xWriteFile(TRUTH_PATH, xTruth, xTruthLen) == false) )
+        {
+            printf("can not write %s or %s\n", STREAM_PATH, TRUTH_PATH);
+            return 1;
+        }
+        printf("%u bytes written to %s, %u frames and %u dropped in %s\n", xWireLen, STREAM_PATH, xStream.frames,
+               xStream.dropped, TRUTH_PATH);
+        return 0;
+    }
+
+    printf("  frames on the wire:\n");
+    xRecordSequence();
+    printf("    %u frames, %u dropped, %u B of frames, %u B on the wire\n", xStream.frames, xStream.dropped,
+           xStream.frameBytes, xWireLen);
+    xCheck(xReadFile(STREAM_PATH, &p_reference, &referenceLen) == true, "the reference stream is there");
+    xCheck((xWireLen == referenceLen) && (memcmp(xWire, p_reference, xWireLen) == 0),
+           "frames, text and records come out as " STREAM_PATH ", byte for byte");
+    xCheck(xReadFile(TRUTH_PATH, &p_reference, &referenceLen) == true, "the reference samples are there");
+    xCheck((xTruthLen == referenceLen) && (memcmp(xTruth, p_reference, xTruthLen) == 0),
+           "the samples and drops are those in " TRUTH_PATH);
+    xCheck((xStream.dropped > 0u) && (xStream.dropped < xStream.frames), "the text bursts make some frames drop");
+    xCheck(xSequenceErrors == 0u, "the sequence number counts every frame, dropped ones too");
+    xCheck(xNotKeyAfterDrop == 0u, "the frame after a drop is a key frame");
+    xCheck(xStream.longest == APP_CAPTURE_MAX_FRAME_LEN, "the random samples reach the longest frame and no further");
+
+    printf("  throughput, terminal built for %u baud:\n", HW_TERM_BAUD_RATE);
+    for ( i = 0u; i < NUM_BAUD_RATES; i++ )
+    {
+        baud = xBaudRates[i];
+        printf("  %u baud:\n", baud);
+
+        sprintf(what, "the longest frame, %u B at %u Hz, takes %u%% of the line, at most %u%%", APP_CAPTURE_MAX_FRAME_LEN,
+                CAPTURE_RATE_HZ, (APP_CAPTURE_MAX_FRAME_LEN * CAPTURE_RATE_HZ * BITS_PER_BYTE * 100u) / baud, LINE_SHARE_PERCENT);
+        xCheck((APP_CAPTURE_MAX_FRAME_LEN * CAPTURE_RATE_HZ * BITS_PER_BYTE * 100u) <= (baud * LINE_SHARE_PERCENT), what);
+
+        xRunStream(baud, true, false, WORST_CASE_TICKS);
+        printf("    worst case:  %5u frames, %4u dropped, %7u B of frames, %5u B/s of %u B/s, %u B of text and records\n",
+               xStream.frames, xStream.dropped, xStream.frameBytes, (xStream.frameBytes * CAPTURE_RATE_HZ) / xStream.frames,
+               baud / BITS_PER_BYTE, xStream.textBytes);
+        xCheck((xStream.dropped == 0u) && (xStream.frames == WORST_CASE_TICKS),
+               "a minute of worst case frames with the status line and trace records drops none");
+        xCheck(xStream.longest == APP_CAPTURE_MAX_FRAME_LEN, "every worst case frame is a key frame");
+        xCheck((xStream.frameBytes * CAPTURE_RATE_HZ * BITS_PER_BYTE * 100u) <= (xStream.frames * baud * LINE_SHARE_PERCENT),
+               "the frames take at most 80% of the line");
+        xCheck(xStream.wireBytes == (xStream.frameBytes + xStream.textBytes), "every byte queued is sent");
+
+        xRunStream(baud, false, true, REALISTIC_TICKS);
+        printf("    realistic:   %5u frames, %4u dropped, %7u B of frames, %5u B/s of %u B/s, %u B of text and records\n",
+               xStream.frames, xStream.dropped, xStream.frameBytes, (xStream.frameBytes * CAPTURE_RATE_HZ) / xStream.frames,
+               baud / BITS_PER_BYTE, xStream.textBytes);
+        xCheck((xStream.dropped == 0u) && (xStream.frames == REALISTIC_TICKS),
+               "10 minutes of realistic frames with the CLI bursts drops none");
+        xCheck(xStream.wireBytes == (xStream.frameBytes + xStream.textBytes), "every byte queued is sent");
+    }
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// The TX interrupt runs while it is enabled and TXBUF is empty
+static void xDispatch(void)
+{
+    while ( (xTxIe == true) && (xTxBufFull == false) && (xInIsr == false) )
+    {
+        xInIsr = true;
+        UCA0IV = USCI_UART_UCTXIFG;
+        EUSCI_A0_ISR();
+        xInIsr = false;
+        xCycles += ISR_CYCLES;
+    }
+}
+
+// The byte in the shift register is on the wire, TXBUF moves in and its interrupt can run
+static void xShiftDone(void)
+{
+    xCycles = xShiftEnd;
+    if ( xWireLen < WIRE_BYTES )
+    {
+        xWire[xWireLen++] = xShiftByte;
+    }
+
+    if ( xTxBufFull == true )
+    {
+        xShiftByte = xTxBuf;
+        xTxBufFull = false;
+        xShiftEnd += xCharCycles;
+    }
+    else
+    {
+        xShifting = false;
+    }
+
+    xDispatch();
+}
+
+// Background work, the interrupts taken on the way stretch it
+static void xRun(uint64_t cycles)
+{
+    while ( (xShifting == true) && ((xShiftEnd - xCycles) <= cycles) )
+    {
+        cycles -= xShiftEnd - xCycles;
+        xShiftDone();
+    }
+
+    xCycles += cycles;
+}
+
+static void xIdle(uint64_t until)
+{
+    while ( (xShifting == true) && (xShiftEnd <= until) )
+    {
+        xShiftDone();
+    }
+
+    if ( xCycles < until )
+    {
+        xCycles = until;
+    }
+}
+
+// Empty line at the new rate, nothing counted yet
+static void xReset(uint32_t baud)
+{
+    uC_UART_Flush();
+    xCharCycles = (MCLK_HZ * BITS_PER_BYTE) / baud;
+    xWireLen = 0u;
+    xTruthLen = 0u;
+    xSeed = 1u;
+    memset(&xStream, 0, sizeof(xStream));
+    xLastQueued = true;
+    xNextSequence = 0u;
+    xSequenceErrors = 0u;
+    xNotKeyAfterDrop = 0u;
+}
+
+static void xText(const char * p_text)
+{
+    uC_UART_Tx((uint8_t *)p_text, (uint16_t)strlen(p_text));
+    xStream.textBytes += strlen(p_text);
+}
+
+// A line of terminal text: format it, then uC_UART_Tx copies it into the ring
+static void xPrint(uint16_t len)
+{
+    static uint8_t line[STATUS_LEN];
+
+    memset(line, 'a', sizeof(line));
+    xRun(SPRINTF_CYCLES + COPY_CYCLES(len));
+    uC_UART_Tx(line, len);
+    xStream.textBytes += len;
+}
+
+// Fixed generator so the stream is the same on every host
+static uint16_t xRandom(void)
+{
+    xSeed = (xSeed * 1103515245u) + 12345u;
+    return (uint16_t)(xSeed >> 16);
+}
+
+// Pads a few counts of noise around levels that step as the water moves, the magnetometer swinging
+// with the handle at about 0.8 Hz (a 25 tick triangle) and the temperature creeping
+static void xRealistic(uint32_t n, padSample_t * p_pads, magSample_t * p_mag)
+{
+    int16_t level = (int16_t)(((n / 40u) % 3u) * 350u);
+    int16_t swing = (int16_t)(n % 25u);
+
+    swing = (swing < 13) ? swing : (int16_t)(25 - swing);
+
+    p_pads->pad1 = (int16_t)(2000 + level + (xRandom() % 7u));
+    p_pads->pad2 = (int16_t)(2040 + level + (xRandom() % 7u));
+    p_pads->pad3 = (int16_t)(2080 + level + (xRandom() % 7u));
+    p_pads->pad4 = (int16_t)(2120 + (xRandom() % 7u));
+    p_pads->pad5 = (int16_t)(2160 + (xRandom() % 7u));
+    p_pads->pad6 = (int16_t)(2200 + (xRandom() % 7u));
+    p_pads->pad7 = (int16_t)(2240 + (xRandom() % 7u));
+    p_pads->pad8 = (int16_t)(2280 + (xRandom() % 7u));
+    p_mag->x_lsb = (int16_t)((swing * 48) - 300);
+    p_mag->y_lsb = (int16_t)(220 - (swing * 35));
+    p_mag->z_lsb = (int16_t)(900 + (xRandom() % 3u));
+    p_mag->temp_lsb = (int16_t)(200 + (n / 600u));
+    p_mag->status = 0x0Fu;
+}
+
+// Every channel anywhere in its range, no delta frame can beat the key frame
+static void xWorstCase(padSample_t * p_pads, magSample_t * p_mag)
+{
+    p_pads->pad1 = (int16_t)xRandom();
+    p_pads->pad2 = (int16_t)xRandom();
+    p_pads->pad3 = (int16_t)xRandom();
+    p_pads->pad4 = (int16_t)xRandom();
+    p_pads->pad5 = (int16_t)xRandom();
+    p_pads->pad6 = (int16_t)xRandom();
+    p_pads->pad7 = (int16_t)xRandom();
+    p_pads->pad8 = (int16_t)xRandom();
+    p_mag->x_lsb = (int16_t)xRandom();
+    p_mag->y_lsb = (int16_t)xRandom();
+    p_mag->z_lsb = (int16_t)xRandom();
+    p_mag->temp_lsb = (int16_t)xRandom();
+    p_mag->status = (uint8_t)xRandom();
+}
+
+// Give the encoder a sample and write it down as ssm_capture.py would, or DROPPED
+static void xSample(uint32_t tick, uint8_t flags, const padSample_t * p_pads, const magSample_t * p_mag)
+{
+    xRun(ENCODE_CYCLES);
+    APP_CAPTURE_AddSample(tick, flags, p_pads, p_mag);
+
+    if ( xLastQueued == false )
+    {
+        xTruthLen += sprintf(&xTruth[xTruthLen], "DROPPED\n");
+        return;
+    }
+
+    xTruthLen += sprintf(&xTruth[xTruthLen], "%u,%u,%u,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%u\n", tick,
+                         ((flags & APP_CAPTURE_FLAG_ACTIVE) != 0u) ? 1u : 0u, ((flags & APP_CAPTURE_FLAG_STROKES) != 0u) ? 1u : 0u,
+                         p_pads->pad1, p_pads->pad2, p_pads->pad3, p_pads->pad4, p_pads->pad5, p_pads->pad6, p_pads->pad7,
+                         p_pads->pad8, p_mag->x_lsb, p_mag->y_lsb, p_mag->z_lsb, p_mag->temp_lsb, p_mag->status);
+}
+
+// Realistic frames with text and records, the edges of the encoding, drops, then realistic frames again
+static void xRecordSequence(void)
+{
+    padSample_t pads;
+    magSample_t mag;
+    uint8_t burst[BURST_LEN];
+    char line[40];
+    uint64_t next;
+    uint32_t tick = 1000u;
+    uint32_t n;
+
+    xReset(HW_TERM_BAUD_RATE);
+    xTruthLen = sprintf(xTruth, "%s\n", TRUTH_COLUMNS);
+    HW_TRACE_Enable(true);
+    APP_CAPTURE_Start();
+    next = xCycles;
+
+    for ( n = 0u; n < 200u; n++ )
+    {
+        HOST_SetTimeMs((uint64_t)tick * 10u);
+        if ( (n % STATUS_PERIOD_TICKS) == 10u )
+        {
+            sprintf(line, "Liters %u\r\n", n / 10u);
+            xText(line);
+            HW_TRACE_1(TRACE_HOUR, n / STATUS_PERIOD_TICKS);
+        }
+        xRealistic(n, &pads, &mag);
+        xSample(tick, ((n / 30u) & 1u) | APP_CAPTURE_FLAG_STROKES, &pads, &mag);
+        next += TICK_CYCLES;
+        xIdle(next);
+        tick += RUNTIME_TICKS_PER_TICK;
+    }
+
+    // a gap too long for the tick delta, then the tick wrapping over a few delta frames
+    tick += 300u * RUNTIME_TICKS_PER_TICK;
+    xSample(tick, 0u, &pads, &mag);
+    tick = 0xFFFFFFF0u;
+    for ( n = 0u; n < 8u; n++ )
+    {
+        xRealistic(n, &pads, &mag);
+        xSample(tick, APP_CAPTURE_FLAG_ACTIVE, &pads, &mag);
+        next += TICK_CYCLES;
+        xIdle(next);
+        tick += RUNTIME_TICKS_PER_TICK;
+    }
+
+    // the largest steps either way, where the difference wraps, and a status change
+    for ( n = 0u; n < 8u; n++ )
+    {
+        pads.pad1 = ((n & 1u) == 0u) ? INT16_MIN : INT16_MAX;
+        pads.pad2 = ((n & 1u) == 0u) ? INT16_MAX : INT16_MIN;
+        pads.pad3 = ((n & 2u) == 0u) ? 0 : -1;
+        mag.x_lsb = ((n & 1u) == 0u) ? -16384 : 16383;
+        mag.status = (uint8_t)(0x0Fu + (n / 4u));
+        xSample(tick, APP_CAPTURE_FLAG_ACTIVE | APP_CAPTURE_FLAG_STROKES, &pads, &mag);
+        next += TICK_CYCLES;
+        xIdle(next);
+        tick += RUNTIME_TICKS_PER_TICK;
+    }
+
+    // random samples with text bursts that fill the ring, the frames behind them are dropped
+    memset(burst, '-', sizeof(burst));
+    burst[BURST_LEN - 2u] = '\r';
+    burst[BURST_LEN - 1u] = '\n';
+    for ( n = 0u; n < 40u; n++ )
+    {
+        if ( (n % 10u) == 0u )
+        {
+            uC_UART_Tx(burst, sizeof(burst));
+            xStream.textBytes += sizeof(burst);
+            next = (xCycles > next) ? xCycles : next;
+        }
+        xWorstCase(&pads, &mag);
+        xSample(tick, APP_CAPTURE_FLAG_STROKES, &pads, &mag);
+        next += TICK_CYCLES;
+        xIdle(next);
+        tick += RUNTIME_TICKS_PER_TICK;
+    }
+
+    for ( n = 0u; n < 60u; n++ )
+    {
+        xRealistic(n, &pads, &mag);
+        xSample(tick, APP_CAPTURE_FLAG_ACTIVE, &pads, &mag);
+        next += TICK_CYCLES;
+        xIdle(next);
+        tick += RUNTIME_TICKS_PER_TICK;
+    }
+
+    APP_CAPTURE_Stop();
+    uC_UART_Flush();
+    HW_TRACE_Enable(false);
+}
+
+// The background loop with the capture on: a frame and the algorithm every tick, the status line every
+// second, the field trace events, and the CLI output every 15 s when asked for
+static void xRunStream(uint32_t baud, bool worstCase, bool cliBursts, uint32_t ticks)
+{
+    padSample_t pads;
+    magSample_t mag;
+    uint64_t next;
+    uint32_t n;
+    uint32_t line;
+    uint16_t droppedBefore;
+
+    xReset(baud);
+    HW_TRACE_Enable(true);
+    droppedBefore = HW_TRACE_GetDroppedCount();
+    APP_CAPTURE_Start();
+    next = xCycles;
+
+    for ( n = 0u; n < ticks; n++ )
+    {
+        HOST_SetTimeMs((uint64_t)n * MS_PER_TICK);
+
+        if ( worstCase == true )
+        {
+            xWorstCase(&pads, &mag);
+        }
+        else
+        {
+            xRealistic(n, &pads, &mag);
+        }
+        xSample(n * RUNTIME_TICKS_PER_TICK, APP_CAPTURE_FLAG_ACTIVE | APP_CAPTURE_FLAG_STROKES, &pads, &mag);
+        xTruthLen = 0u;
+        xRun(ALGO_CYCLES);
+
+        if ( (n % STATUS_PERIOD_TICKS) == (STATUS_PERIOD_TICKS - 1u) )
+        {
+            xPrint(STATUS_LEN);
+        }
+
+        if ( (cliBursts == true) && ((n % CLI_PERIOD_TICKS) == (CLI_PERIOD_TICKS - 1u)) )
+        {
+            for ( line = 0u; line < CLI_LINES; line++ )
+            {
+                xPrint(CLI_LEN);
+            }
+        }
+
+        if ( (n % EVENT_PERIOD_TICKS) == (EVENT_PERIOD_TICKS / 2u) )
+        {
+            xRun(TRACE_CYCLES);
+            HW_TRACE_1(TRACE_MAG_IDLE, 1u);
+            xRun(TRACE_CYCLES);
+            HW_TRACE_1(TRACE_AM_WAKE, 0x8Au);
+            xStream.records += 2u;
+        }
+
+        next += TICK_CYCLES;
+        xIdle(next);
+    }
+
+    APP_CAPTURE_Stop();
+    uC_UART_Flush();
+    HW_TRACE_Enable(false);
+
+    // a dropped record counts as a dropped frame here, both are lost to the host
+    xStream.dropped += HW_TRACE_GetDroppedCount() - droppedBefore;
+    xStream.textBytes += xStream.records * (HW_TRACE_HEADER_LEN + 2u + 1u);
+    xStream.wireBytes = xWireLen;
+}
+
+static bool xReadFile(const char * p_path, uint8_t ** pp_data, uint32_t * p_len)
+{
+    FILE * p_file = fopen(p_path, "rb");
+
+    if ( p_file == NULL )
+    {
+        return false;
+    }
+
+    *pp_data = malloc(WIRE_BYTES);
+    *p_len = (uint32_t)fread(*pp_data, 1u, WIRE_BYTES, p_file);
+    fclose(p_file);
+
+    return true;
+}
+
+static bool xWriteFile(const char * p_path, const void * p_data, uint32_t len)
+{
+    FILE * p_file = fopen(p_path, "wb");
+    bool written;
+
+    if ( p_file == NULL )
+    {
+        return false;
+    }
+
+    written = (fwrite(p_data, 1u, len, p_file) == len);
+    fclose(p_file);
+
+    return written;
+}
+
+// Frames start with the capture sync byte, trace records with their own
+bool __wrap_uC_UART_TxNoWait(const uint8_t * p_buf, uint16_t len)
+{
+    bool queued = __real_uC_UART_TxNoWait(p_buf, len);
+
+    if ( (len < 4u) || (p_buf[0] != APP_CAPTURE_SYNC) )
+    {
+        return queued;
+    }
+
+    xSequenceErrors += (p_buf[2] != xNextSequence) ? 1u : 0u;
+    xNextSequence = (uint8_t)(p_buf[2] + 1u);
+    xStream.frames++;
+
+    if ( queued == true )
+    {
+        xNotKeyAfterDrop += ((xLastQueued == false) && ((p_buf[3] & APP_CAPTURE_FLAG_KEY) == 0u)) ? 1u : 0u;
+        xStream.frameBytes += len;
+        xStream.longest = (len > xStream.longest) ? len : xStream.longest;
+    }
+    else
+    {
+        xStream.dropped++;
+    }
+    xLastQueued = queued;
+
+    return queued;
+}
+
+// LPM0 until the next interrupt, the only one running here is the TX interrupt
+void HOST_Sleep(uint16_t bits)
+{
+    if ( xShifting == false )
+    {
+        printf("  FAIL: sleeping for the UART with nothing to wake it\nFAIL\n");
+        exit(1);
+    }
+
+    xShiftDone();
+}
+
+bool EUSCI_A_UART_init(uint16_t baseAddress, EUSCI_A_UART_initParam *param)
+{
+    return true;
+}
+
+void EUSCI_A_UART_enable(uint16_t baseAddress)
+{
+}
+
+void EUSCI_A_UART_transmitData(uint16_t baseAddress, uint8_t transmitData)
+{
+    if ( xShifting == false )
+    {
+        xShifting = true;
+        xShiftByte = transmitData;
+        xShiftEnd = xCycles + xCharCycles;
+    }
+    else
+    {
+        xTxBufFull = true;
+        xTxBuf = transmitData;
+    }
+}
+
+uint8_t EUSCI_A_UART_receiveData(uint16_t baseAddress)
+{
+    return 0u;
+}
+
+void EUSCI_A_UART_enableInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+    if ( (mask & EUSCI_A_UART_TRANSMIT_INTERRUPT) != 0u )
+    {
+        xTxIe = true;
+        xDispatch();
+    }
+}
+
+void EUSCI_A_UART_disableInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+    if ( (mask & EUSCI_A_UART_TRANSMIT_INTERRUPT) != 0u )
+    {
+        xTxIe = false;
+    }
+}
+
+void EUSCI_A_UART_clearInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+}
+
+// Polled in a loop by uC_UART_Flush(), so each read takes a little time
+uint8_t EUSCI_A_UART_queryStatusFlags(uint16_t baseAddress, uint8_t mask)
+{
+    xRun(POLL_CYCLES);
+    return ((xShifting == true) && ((mask & EUSCI_A_UART_BUSY) != 0u)) ? EUSCI_A_UART_BUSY : 0u;
+}
+
+void HW_TERM_RxByte(uint8_t byte)
+{
+}
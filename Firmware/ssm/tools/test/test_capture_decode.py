@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Checks of ssm_capture.py on the stream test_capture checks APP_CAPTURE.c against.
+
+traces/capture_stream.bin is capture frames with terminal text and trace
+records between them, and traces/capture_stream.csv the samples the encoder
+was given, DROPPED where the frame did not fit in the UART ring. The decoder
+has to rebuild every sent sample bit for bit, count the dropped ones as lost,
+pass the text and records through, give the same rows however the bytes are
+split between reads, and never make up a row from a damaged stream.
+
+Usage: python3 test_capture_decode.py      (from this folder, test.sh runs it)
+"""
+
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+TOOLS = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+sys.path.insert(0, TOOLS)
+import ssm_capture  # noqa: E402
+
+TRACES = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'traces')
+STREAM = os.path.join(TRACES, 'capture_stream.bin')
+TRUTH = os.path.join(TRACES, 'capture_stream.csv')
+
+FIXED_CHUNKS = (1, 2, 7, 33, 256)
+RANDOM_SPLITS = 50
+CORRUPT_RUNS = 100
+CORRUPT_BITS = 5
+KEY_FRAME_INTERVAL = 20
+
+passed = True
+
+
+def check(condition, what):
+    global passed
+    print('  %s: %s' % ('ok  ' if condition else 'FAIL', what))
+    passed = passed and condition
+
+
+def decode(data, chunks):
+    decoder = ssm_capture.CaptureDecoder()
+    rows = []
+    text = []
+    for start, end in chunks:
+        got, out = decoder.feed(data[start:end])
+        rows += [','.join(str(v) for v in row) for row in got]
+        text.append(out)
+    return rows, ''.join(text), decoder
+
+
+def fixed(data, size):
+    return [(start, start + size) for start in range(0, len(data), size)]
+
+
+def random_split(data, rng):
+    cuts = sorted(rng.sample(range(1, len(data)), rng.randrange(1, 200)))
+    return list(zip([0] + cuts, cuts + [len(data)]))
+
+
+def main():
+    with open(STREAM, 'rb') as f:
+        stream = f.read()
+    with open(TRUTH) as f:
+        truth = f.read().splitlines()
+
+    header, samples = truth[0], truth[1:]
+    sent = [line for line in samples if line != 'DROPPED']
+    dropped = samples.count('DROPPED')
+
+    check(ssm_capture.crc16(b'123456789') == 0x29B1, 'the CRC is CRC-16/CCITT-FALSE')
+    check(header == ','.join(ssm_capture.COLUMNS), 'the reference samples have the CSV columns')
+
+    rows, text, decoder = decode(stream, [(0, len(stream))])
+    print('    %d samples, %d dropped by the SSM, %s' % (len(samples), dropped, decoder.summary()))
+    check(rows == sent, 'every sent sample comes back bit for bit, in order')
+    check(decoder.lost == dropped and decoder.undecodable == 0, 'the dropped frames are counted as lost, nothing else')
+    check(decoder.frames == len(sent), 'every frame on the wire is found')
+    check('Liters 9\r\n' in text and text.count('TRACE_HOUR: hour') == 10, 'the text and trace records are passed through')
+    check('\x1f' not in text, 'no frame bytes leak into the text')
+
+    rng = random.Random(44)
+    same = all(decode(stream, fixed(stream, size))[:2] == (rows, text) for size in FIXED_CHUNKS)
+    same = same and all(decode(stream, random_split(stream, rng))[:2] == (rows, text) for _ in range(RANDOM_SPLITS))
+    check(same, 'the same rows and text for reads of 1 to 256 bytes and %d random splits' % RANDOM_SPLITS)
+
+    truth_rows = set(sent)
+    false_rows = 0
+    most_lost = 0
+    for _ in range(CORRUPT_RUNS):
+        bad = bytearray(stream)
+        for _ in range(CORRUPT_BITS):
+            bad[rng.randrange(len(bad))] ^= 1 << rng.randrange(8)
+        got = decode(bytes(bad), fixed(bad, 64))[0]
+        false_rows += sum(1 for row in got if row not in truth_rows)
+        most_lost = max(most_lost, len(sent) - len(got))
+    check(false_rows == 0, 'no made up rows from %d streams with %d flipped bits each' % (CORRUPT_RUNS, CORRUPT_BITS))
+    check(most_lost <= CORRUPT_BITS * KEY_FRAME_INTERVAL,
+          'a flipped bit costs at most the rows up to the next key frame, %d rows at worst' % most_lost)
+
+    with tempfile.TemporaryDirectory() as folder:
+        out = os.path.join(folder, 'capture.csv')
+        result = subprocess.run([sys.executable, os.path.join(TOOLS, 'ssm_capture.py'), out, STREAM],
+                                stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        with open(out) as f:
+            written = f.read().splitlines()
+    check(result.returncode == 0 and written == [header] + sent, 'ssm_capture.py writes the sent samples to the CSV file')
+
+    print('PASS' if passed else 'FAIL')
+    return 0 if passed else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,452 @@
+/**************************************************************************************************
+* \file     test_ckpt.c
+* \brief    Replay of the algorithm checkpoint with a reset injected, with and without the restore
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "host_ssm.h"
+#include "APP_ALGO.h"
+#include "APP_CKPT.h"
+#include "uC_TIME.h"
+
+// Replays synthetic pump sessions through the real APP_ALGO and APP_CKPT three times: without a reset
+// (the reference), with a reset part way through a session that boots with APP_ALGO_WarmStart() as
+// APP.c does (restore), and with the same reset booting the way the firmware did before the
+// checkpoint, APP_ALGO_Init() (no restore). Every boot is its own process, so RAM starts from its power
+// up state. FRAM is carried over the reset by loading the newest checkpoint record in the process that
+// is reset and saving it back in the next one before it boots.
+//
+// With the restore the magnetometer is still calibrated on the first tick after the boot, and the
+// hours after the reset hour have to match the reference within HOUR_TOLERANCE_PERCENT. The reset hour
+// itself loses at most what was counted since the last checkpoint and the session the reset cut. Without
+// the restore the magnetometer has to calibrate again and the strokes of the hour after the reset have
+// to be lost, or the reset isn't one the restore matters for.
+//
+// Usage: test_ckpt
+
+#define SYNTH_HOURS                 7u
+#define MAX_REPORT_HOURS            SYNTH_HOURS
+#define MS_PER_HOUR                 3600000ul
+#define SAMPLES_PER_HOUR            (MS_PER_HOUR / HOST_MS_PER_SAMPLE)
+#define EPOCH_BASE                  1792000800ul            // the top of an hour
+
+// 100 s into the first session of the 25th minute of hour 4, while the water is flowing
+#define RESET_MS                    ((4ul * MS_PER_HOUR) + (24ul * 60000ul) + 100000ul)
+#define RESET_HOUR                  (RESET_MS / MS_PER_HOUR)
+
+#define SESSION_EVERY_MS            (6ul * 60ul * 1000ul)
+#define NUM_SESSION_TYPES           4u
+#define WATER_DEPTH_PADS            7.2
+#define PAD_DRY_COUNT               1200
+#define PAD_WET_DROP                260
+#define REST_X                      1500
+#define REST_Y                      -800
+#define REST_Z                      300
+#define MAG_STATUS_NEW_DATA         15u
+
+#define HOUR_TOLERANCE_PERCENT      2u
+#define RESET_HOUR_LOSS_PERCENT     10u
+#define CHECKPOINT_EVERY_MS         60000ul
+
+typedef struct
+{
+    double strokeHz;
+    uint32_t lengthMs;
+    bool water;
+    bool active;            // somebody at the pump, the pad proximity wakes the algorithm
+}sessionType_t;
+
+typedef enum
+{
+    BOOT_FIRST,             // APP_ALGO_Init(), a new unit
+    BOOT_RESTORE,           // APP_ALGO_WarmStart()
+    BOOT_NO_RESTORE,        // APP_ALGO_Init(), as before the checkpoint
+}bootType_t;
+
+// The newest checkpoint record, what FRAM holds over the reset
+typedef struct
+{
+    bool valid;
+    uint32_t epoch;
+    waterAlgoData_t algoData;
+    waterCalibration_t waterCalibration;
+    magCalibration_t magCalibration;
+    pumpUsage_t pumpUsage;
+    accumStrokeCount_t strokeCount;
+    hourlyPumpHealthInfo_t pumpHealth;
+}framImage_t;
+
+typedef struct
+{
+    uint32_t hourlyStrokes[MAX_REPORT_HOURS];
+    uint32_t hourlyLiters[MAX_REPORT_HOURS];
+    uint32_t saves;
+    uint32_t framLeftWritable;
+    int32_t magnetPresentMs;    // after the boot, -1 if never
+    bool warmStart;
+    framImage_t fram;
+}runResult_t;
+
+static const sessionType_t xSessionTypes[NUM_SESSION_TYPES] =
+{
+    { 1.5, 200000ul, true,  true  },
+    { 2.4, 150000ul, true,  true  },    // hard pumping
+    { 1.0, 240000ul, true,  true  },
+    { 1.5,  20000ul, false, false },    // the handle knocked
+};
+
+static runResult_t xResult;
+
+// APP_CKPT_Save() is wrapped to count the saves
+extern bool __real_APP_CKPT_Save(const waterAlgoData_t * p_algoData, const waterCalibration_t * p_waterCalibration,
+                                 const magCalibration_t * p_magCalibration, const pumpUsage_t * p_pumpUsage,
+                                 const accumStrokeCount_t * p_strokeCount, const hourlyPumpHealthInfo_t * p_pumpHealth,
+                                 uint32_t epoch);
+bool __wrap_APP_CKPT_Save(const waterAlgoData_t * p_algoData, const waterCalibration_t * p_waterCalibration,
+                          const magCalibration_t * p_magCalibration, const pumpUsage_t * p_pumpUsage,
+                          const accumStrokeCount_t * p_strokeCount, const hourlyPumpHealthInfo_t * p_pumpHealth,
+                          uint32_t epoch);
+
+static void xRunOne(bootType_t boot, const framImage_t * p_fram, uint64_t startMs, uint64_t endMs, runResult_t * p_result);
+static bool xRunForked(bootType_t boot, const framImage_t * p_fram, uint64_t startMs, uint64_t endMs, runResult_t * p_result);
+static void xSynthRow(uint32_t sample, hostCaptureRow_t * p_row);
+static uint32_t xHash(uint32_t value);
+static bool xCheck(bool condition, const char * p_what);
+static uint32_t xPercentOff(uint32_t value, uint32_t reference);
+
+bool __wrap_APP_CKPT_Save(const waterAlgoData_t * p_algoData, const waterCalibration_t * p_waterCalibration,
+                          const magCalibration_t * p_magCalibration, const pumpUsage_t * p_pumpUsage,
+                          const accumStrokeCount_t * p_strokeCount, const hourlyPumpHealthInfo_t * p_pumpHealth,
+                          uint32_t epoch)
+{
+    xResult.saves++;
+
+    return __real_APP_CKPT_Save(p_algoData, p_waterCalibration, p_magCalibration, p_pumpUsage, p_strokeCount,
+                                p_pumpHealth, epoch);
+}
+
+void HW_TERM_Print(uint8_t * p_str)
+{
+    if ( strcmp((const char *)p_str, "algorithm warm start") == 0 )
+    {
+        xResult.warmStart = true;
+    }
+
+    if ( getenv("HOST_VERBOSE") != NULL )
+    {
+        printf("  term: %s\n", (const char *)p_str);
+    }
+}
+
+int main(void)
+{
+    runResult_t reference;
+    runResult_t beforeReset;
+    runResult_t restore;
+    runResult_t noRestore;
+    uint64_t endMs = SYNTH_HOURS * MS_PER_HOUR;
+    uint32_t resetHourRestore;
+    uint32_t resetHourNoRestore;
+    uint32_t worst = 0u;
+    uint32_t hr;
+    bool pass = true;
+
+    printf("replaying %u synthetic hours, reset at %lu s\n", SYNTH_HOURS, RESET_MS / 1000ul);
+
+    if ( (xRunForked(BOOT_FIRST, NULL, 0u, endMs, &reference) == false) ||
+         (xRunForked(BOOT_FIRST, NULL, 0u, RESET_MS, &beforeReset) == false) ||
+         (xRunForked(BOOT_RESTORE, &beforeReset.fram, RESET_MS, endMs, &restore) == false) ||
+         (xRunForked(BOOT_NO_RESTORE, &beforeReset.fram, RESET_MS, endMs, &noRestore) == false) )
+    {
+        printf("FAIL: replay did not finish\n");
+        return 1;
+    }
+
+    //the hours before the reset come from the first boot, the counts of the reset hour carry on in the second
+    for ( hr = 0u; hr < RESET_HOUR; hr++ )
+    {
+        restore.hourlyStrokes[hr] = beforeReset.hourlyStrokes[hr];
+        restore.hourlyLiters[hr] = beforeReset.hourlyLiters[hr];
+        noRestore.hourlyStrokes[hr] = beforeReset.hourlyStrokes[hr];
+        noRestore.hourlyLiters[hr] = beforeReset.hourlyLiters[hr];
+    }
+
+    printf("\n          reference    restore    no restore   (strokes/liters)\n");
+    for ( hr = 0u; hr < SYNTH_HOURS; hr++ )
+    {
+        printf("  hour %u  %5u/%-4u  %5u/%-4u  %5u/%-4u%s\n", hr, reference.hourlyStrokes[hr], reference.hourlyLiters[hr],
+               restore.hourlyStrokes[hr], restore.hourlyLiters[hr], noRestore.hourlyStrokes[hr], noRestore.hourlyLiters[hr],
+               (hr == RESET_HOUR) ? "   <- reset" : "");
+    }
+    printf("  magnet present after the boot: restore %ld ms, no restore %ld ms\n",
+           (long)restore.magnetPresentMs, (long)noRestore.magnetPresentMs);
+    printf("  checkpoints saved before the reset: %u in %lu s\n\n", beforeReset.saves, RESET_MS / 1000ul);
+
+    pass &= xCheck(reference.hourlyStrokes[RESET_HOUR - 1u] > 0u, "the magnetometer is calibrated before the reset hour");
+    pass &= xCheck(beforeReset.fram.valid == true, "there is a checkpoint in FRAM at the reset");
+    pass &= xCheck(beforeReset.saves >= (RESET_MS / CHECKPOINT_EVERY_MS), "a checkpoint at least every minute");
+    pass &= xCheck((beforeReset.framLeftWritable + restore.framLeftWritable + noRestore.framLeftWritable) == 0u,
+                   "FRAM write protected again after every tick");
+    pass &= xCheck((restore.warmStart == true) && (noRestore.warmStart == false), "only the restore boot warm starts");
+    pass &= xCheck(restore.magnetPresentMs == 0, "restore: magnetometer calibrated on the first tick after the boot");
+
+    for ( hr = RESET_HOUR + 1u; hr < SYNTH_HOURS; hr++ )
+    {
+        worst = (xPercentOff(restore.hourlyStrokes[hr], reference.hourlyStrokes[hr]) > worst) ?
+                xPercentOff(restore.hourlyStrokes[hr], reference.hourlyStrokes[hr]) : worst;
+        worst = (xPercentOff(restore.hourlyLiters[hr], reference.hourlyLiters[hr]) > worst) ?
+                xPercentOff(restore.hourlyLiters[hr], reference.hourlyLiters[hr]) : worst;
+    }
+    pass &= xCheck(worst <= HOUR_TOLERANCE_PERCENT, "restore: the hours after the reset hour match the reference");
+
+    resetHourRestore = (xPercentOff(restore.hourlyStrokes[RESET_HOUR], reference.hourlyStrokes[RESET_HOUR]) >
+                        xPercentOff(restore.hourlyLiters[RESET_HOUR], reference.hourlyLiters[RESET_HOUR])) ?
+                       xPercentOff(restore.hourlyStrokes[RESET_HOUR], reference.hourlyStrokes[RESET_HOUR]) :
+                       xPercentOff(restore.hourlyLiters[RESET_HOUR], reference.hourlyLiters[RESET_HOUR]);
+    resetHourNoRestore = xPercentOff(noRestore.hourlyStrokes[RESET_HOUR], reference.hourlyStrokes[RESET_HOUR]);
+    printf("  reset hour off the reference: restore %u%%, no restore %u%% of the strokes\n", resetHourRestore, resetHourNoRestore);
+    pass &= xCheck(resetHourRestore <= RESET_HOUR_LOSS_PERCENT, "restore: the reset hour keeps its counts up to the last checkpoint");
+
+    pass &= xCheck(noRestore.magnetPresentMs != 0, "no restore: the magnetometer calibrates over again");
+    pass &= xCheck((noRestore.hourlyStrokes[RESET_HOUR + 1u] * 2u) < reference.hourlyStrokes[RESET_HOUR + 1u],
+                   "no restore: the strokes of the hour after the reset are lost");
+
+    printf("%s\n", (pass == true) ? "PASS" : "FAIL");
+
+    return (pass == true) ? 0 : 1;
+}
+
+static bool xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+
+    return condition;
+}
+
+static uint32_t xPercentOff(uint32_t value, uint32_t reference)
+{
+    uint32_t diff = (value > reference) ? (value - reference) : (reference - value);
+
+    if ( reference == 0u )
+    {
+        return (value == 0u) ? 0u : 100u;
+    }
+
+    return (diff * 100u + reference - 1u) / reference;
+}
+
+// Each boot starts the firmware modules from their power up state, so it gets its own process
+static bool xRunForked(bootType_t boot, const framImage_t * p_fram, uint64_t startMs, uint64_t endMs, runResult_t * p_result)
+{
+    int fds[2];
+    pid_t pid;
+    int status = 0;
+    bool done;
+
+    if ( pipe(fds) != 0 )
+    {
+        return false;
+    }
+
+    fflush(stdout);
+    pid = fork();
+
+    if ( pid == 0 )
+    {
+        close(fds[0]);
+        xRunOne(boot, p_fram, startMs, endMs, p_result);
+        done = (write(fds[1], p_result, sizeof(runResult_t)) == sizeof(runResult_t));
+        _exit((done == true) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    done = (read(fds[0], p_result, sizeof(runResult_t)) == sizeof(runResult_t));
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    return (done == true) && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+// Boots as APP.c does and runs the nest every 50 ms from startMs up to the reset or the end
+static void xRunOne(bootType_t boot, const framImage_t * p_fram, uint64_t startMs, uint64_t endMs, runResult_t * p_result)
+{
+    APP_NVM_SENSOR_DATA_T sensorData;
+    hostCaptureRow_t row;
+    framImage_t * p_out = &xResult.fram;
+    bool wasActive = false;
+    uint32_t sample;
+    uint32_t hour;
+    uint64_t ms;
+
+    memset(&xResult, 0, sizeof(xResult));
+    memset(&sensorData, 0, sizeof(sensorData));
+    xResult.magnetPresentMs = -1;
+
+    HOST_SetEpochBase(EPOCH_BASE);
+    HOST_SetTimeMs(startMs);
+
+    //what the last boot left in FRAM
+    if ( (p_fram != NULL) && (p_fram->valid == true) )
+    {
+        (void)__real_APP_CKPT_Save(&p_fram->algoData, &p_fram->waterCalibration, &p_fram->magCalibration,
+                                   &p_fram->pumpUsage, &p_fram->strokeCount, &p_fram->pumpHealth, p_fram->epoch);
+    }
+
+    APP_ALGO_setStrokeDetectionIsOn(true);
+
+    if ( boot == BOOT_RESTORE )
+    {
+        APP_ALGO_WarmStart();
+    }
+    else
+    {
+        APP_ALGO_Init();
+    }
+
+    for ( ms = startMs; ms < endMs; ms += HOST_MS_PER_SAMPLE )
+    {
+        sample = (uint32_t)(ms / HOST_MS_PER_SAMPLE);
+        HOST_SetTimeMs(ms);
+        xSynthRow(sample, &row);
+        HOST_SetRow(&row);
+
+        //APP_setPumpActive()
+        if ( (row.active == true) && (wasActive == false) )
+        {
+            APP_ALGO_wakeUpInit();
+        }
+
+        wasActive = row.active;
+
+        if ( (xResult.magnetPresentMs < 0) && (APP_ALGO_isMagnetPresent() == true) )
+        {
+            xResult.magnetPresentMs = (int32_t)(ms - startMs);
+        }
+
+        APP_ALGO_Nest(row.active);
+
+        if ( HOST_IsFramWritable() == true )
+        {
+            xResult.framLeftWritable++;
+        }
+
+        if ( ((sample + 1u) % SAMPLES_PER_HOUR) == 0u )
+        {
+            hour = sample / SAMPLES_PER_HOUR;
+            APP_ALGO_updateHourlyFields(&sensorData, (uint8_t)(hour % HOUR_PER_DAY));
+
+            if ( hour < MAX_REPORT_HOURS )
+            {
+                xResult.hourlyStrokes[hour] = sensorData.strokesPerHour[hour % HOUR_PER_DAY];
+                xResult.hourlyLiters[hour] = sensorData.litersPerHour[hour % HOUR_PER_DAY];
+            }
+        }
+    }
+
+    //the power goes, only FRAM is left
+    p_out->valid = APP_CKPT_Load(&p_out->algoData, &p_out->waterCalibration, &p_out->magCalibration, &p_out->pumpUsage,
+                                 &p_out->strokeCount, &p_out->pumpHealth, &p_out->epoch);
+
+    *p_result = xResult;
+}
+
+// One 50 ms row: sessions every 6 minutes, the water rises up the pads from pad8 and sloshes with each
+// stroke of the magnet on the handle, as in test_mag_sched
+static void xSynthRow(uint32_t sample, hostCaptureRow_t * p_row)
+{
+    uint64_t ms = (uint64_t)sample * HOST_MS_PER_SAMPLE;
+    const sessionType_t * p_type = &xSessionTypes[(ms / SESSION_EVERY_MS) % NUM_SESSION_TYPES];
+    double sec = (double)(ms % SESSION_EVERY_MS) / 1000.0;
+    double lengthSec = p_type->lengthMs / 1000.0;
+    double phase = 2.0 * M_PI * p_type->strokeHz * sec;
+    bool pumping = (sec < lengthSec);
+    double level = 0.0;
+    double cover;
+    uint32_t noise;
+    int i;
+
+    if ( p_type->water == true )
+    {
+        if ( pumping == true )
+        {
+            level = fmin(WATER_DEPTH_PADS, sec / 3.0) + ((sec > 25.0) ? (0.6 * sin(phase)) : 0.0);
+        }
+        else
+        {
+            level = fmax(0.0, WATER_DEPTH_PADS - ((sec - lengthSec) / 4.0));
+        }
+    }
+
+    memset(p_row, 0, sizeof(hostCaptureRow_t));
+    p_row->tick = sample;
+    p_row->strokes = true;
+    p_row->active = (p_type->active == true) && ((pumping == true) || (level > 0.0));
+
+    //pad8 is at the bottom and covers first
+    for ( i = 0; i < HOST_NUM_PADS; i++ )
+    {
+        cover = fmin(1.0, fmax(0.0, level - (HOST_NUM_PADS - 1 - i)));
+        noise = xHash((sample * HOST_NUM_PADS) + (uint32_t)i);
+        p_row->pads[i] = (int16_t)(PAD_DRY_COUNT + (10 * i) - (int)(PAD_WET_DROP * cover) + (int)(noise % 5u) - 2);
+
+        if ( cover > 0.0 )
+        {
+            p_row->pads[i] += (int16_t)((int)((noise >> 8) % 13u) - 6);
+        }
+    }
+
+    noise = xHash((uint32_t)ms);
+
+    if ( pumping == true )
+    {
+        p_row->magX = (int16_t)(REST_X + (int)(420.0 * sin(phase)) + (int)(noise % 7u) - 3);
+        p_row->magY = (int16_t)(REST_Y + (int)(260.0 * sin(phase + 0.4)) + (int)((noise >> 8) % 7u) - 3);
+        p_row->magZ = (int16_t)(REST_Z + (int)(330.0 * sin(phase)) + (int)((noise >> 16) % 7u) - 3);
+    }
+    else
+    {
+        p_row->magX = (int16_t)(REST_X + (int)(noise % 5u) - 2);
+        p_row->magY = (int16_t)(REST_Y + (int)((noise >> 8) % 5u) - 2);
+        p_row->magZ = (int16_t)(REST_Z + (int)((noise >> 16) % 5u) - 2);
+    }
+
+    p_row->magTemp = 2400;
+    p_row->magStatus = MAG_STATUS_NEW_DATA;
+}
+
+static uint32_t xHash(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x7FEB352Du;
+    value ^= value >> 15;
+    value *= 0x846CA68Bu;
+    value ^= value >> 16;
+
+    return value;
+}
@@ -0,0 +1,264 @@
+/**************************************************************************************************
+* \file     test_clock.c
+* \brief    Epoch clock discipline against a drifting tick and RTC
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "HW_CLK.h"
+#include "HW_RTC.h"
+#include "uC_TIME.h"
+
+// Runs HW_CLK.c against a simulated runtime seconds tick and RTC, with true time kept in us. The tick and
+// the RTC crystal each have their own ppm error and the second boundaries of the two are not lined up.
+// Every tick is seen up to MAX_ISR_LATENCY_US late, and the main loop calls HW_CLK_Monitor() every
+// LOOP_PERIOD_US with a stall of up to MAX_STALL_US now and then.
+//
+// Over each run the epoch time has to stay within MAX_ERROR_SECS of the RTC, never go backwards and never
+// skip an hour, with about one RTC read an hour. Then the time is set the way ASP_HandleSetRTCMsg() does
+// (HW_CLK_SetEpoch()) in both directions, the RTC is moved behind the clock's back by more and by less
+// than the step threshold, and RTC reads fail for a while.
+//
+// Usage: test_clock
+
+#define US_PER_SEC                  1000000ll
+#define LOOP_PERIOD_US              10000ll
+#define STALL_ONE_IN                200
+#define MAX_STALL_US                200000
+#define MAX_ISR_LATENCY_US          20000
+#define NUM_LATENCIES               (1u << 16)
+#define MAX_ERROR_SECS              2l
+#define START_EPOCH                 1792000000.0
+#define SYNC_AT_US                  (3ll * US_PER_SEC)     // APP_init() runs a few seconds after power up
+#define RTC_FAILURES                5
+
+typedef struct {
+    long maxError;
+    uint32_t backwards;
+    uint32_t hourSkips;
+}runStats_t;
+
+static int64_t xNowUs = 0;
+static double xTickPpm = 0.0;
+static double xRtcPpm = 0.0;
+static int64_t xTickPhaseUs = 0;             // true time of the first runtime second
+static double xRtcAtZero = 0.0;              // RTC time, with its fraction, at true time 0
+static uint32_t xRtcReads = 0u;
+static uint32_t xRtcFailNext = 0u;
+static int32_t xLatencyUs[NUM_LATENCIES];
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static void xScenario(const char * p_label, double tickPpm, double rtcPpm, uint32_t days);
+static runStats_t xRunFor(double seconds, bool checkError);
+static long xError(void);
+static double xRtcNow(void);
+
+int main(void)
+{
+    runStats_t stats;
+    uint32_t before;
+    uint32_t start;
+    long error;
+
+    srand(1234);
+
+    printf("  drift:\n");
+    xScenario("tick one cycle short", 30.5, 0.0, 30u);
+    xScenario("tick fast, RTC slow", 50.0, -20.0, 30u);
+    xScenario("tick slow, RTC fast", -20.0, 20.0, 30u);
+    xScenario("matched crystals", 0.0, 0.0, 10u);
+
+    printf("  events:\n");
+    xScenario("a day before the events", 30.5, 0.0, 1u);
+
+    //ASP set time, the clock steps to it at once in both directions
+    before = HW_CLK_GetEpochTime();
+    xCheck(HW_CLK_SetEpoch(before + 3600u) == true, "the time is set forward");
+    xCheck(HW_CLK_GetEpochTime() == (before + 3600u), "the clock steps forward to it");
+    stats = xRunFor(2.0 * 86400.0, true);
+    printf("    %-36s max error %ld s, %u backwards\n", "ASP set +1 h, then 2 days", stats.maxError, stats.backwards);
+    xCheck((stats.maxError <= MAX_ERROR_SECS) && (stats.backwards == 0u), "the clock tracks the RTC after a set time");
+
+    before = HW_CLK_GetEpochTime();
+    xCheck(HW_CLK_SetEpoch(before - 7200u) == true, "the time is set back");
+    xCheck(HW_CLK_GetEpochTime() == (before - 7200u), "the clock steps back to it");
+    stats = xRunFor(86400.0, true);
+    printf("    %-36s max error %ld s, %u backwards\n", "ASP set -2 h, then 1 day", stats.maxError, stats.backwards);
+    xCheck((stats.maxError <= MAX_ERROR_SECS) && (stats.backwards == 0u), "the clock tracks the RTC after a set back");
+
+    //RTC moved past the step threshold without going through the clock, the next read steps
+    xRtcAtZero += 300.0;
+    xRunFor((double)HW_CLK_DISCIPLINE_PERIOD_SECS + 100.0, false);
+    error = xError();
+    printf("    %-36s error after the next read %ld s\n", "RTC moved +300 s behind our back", error);
+    xCheck(error <= MAX_ERROR_SECS, "an RTC moved past the threshold is stepped to");
+
+    //moved back by less, slewed out one second per slew period and never backwards
+    xRtcAtZero -= 40.0;
+    xRunFor((double)HW_CLK_DISCIPLINE_PERIOD_SECS + 30.0, false);
+    start = HW_CLK_GetEpochTime();
+    stats = xRunFor(600.0, false);
+    error = xError();
+    printf("    %-36s %u backwards, advanced %u s in 600 s, error after %ld s\n", "RTC moved -40 s behind our back",
+           stats.backwards, HW_CLK_GetEpochTime() - start, error);
+    xCheck((stats.backwards == 0u) && (error <= MAX_ERROR_SECS), "an RTC moved back by less is slewed to");
+
+    //the clock runs on the tick through failed reads
+    xRtcFailNext = RTC_FAILURES;
+    stats = xRunFor(6.0 * 3600.0, true);
+    printf("    %-36s max error %ld s\n", "5 failed RTC reads", stats.maxError);
+    xCheck(stats.maxError <= (MAX_ERROR_SECS + 1l), "the clock free runs through failed reads");
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// Power up with these crystal errors, sync as APP_init() does and run for days
+static void xScenario(const char * p_label, double tickPpm, double rtcPpm, uint32_t days)
+{
+    runStats_t stats;
+    uint32_t i;
+
+    xNowUs = 0;
+    xTickPpm = tickPpm;
+    xRtcPpm = rtcPpm;
+    xRtcReads = 0u;
+    xTickPhaseUs = rand() % US_PER_SEC;
+    xRtcAtZero = START_EPOCH + ((rand() % 1000) / 1000.0);
+
+    for ( i = 0u; i < NUM_LATENCIES; i++ )
+    {
+        xLatencyUs[i] = rand() % MAX_ISR_LATENCY_US;
+    }
+
+    xNowUs = SYNC_AT_US;
+    xCheck(HW_CLK_Sync() == true, "the clock syncs to the RTC");
+    stats = xRunFor(days * 86400.0, true);
+
+    printf("    %-24s tick %+5.1f ppm, RTC %+5.1f ppm, %2u days: max error %ld s, %u backwards, %u hours skipped, %u RTC reads\n",
+           p_label, tickPpm, rtcPpm, days, stats.maxError, stats.backwards, stats.hourSkips, xRtcReads);
+    xCheck(stats.maxError <= MAX_ERROR_SECS, "the clock stays within 2 s of the RTC");
+    xCheck(stats.backwards == 0u, "the clock never goes backwards");
+    xCheck(stats.hourSkips == 0u, "every hour comes in order");
+    xCheck(xRtcReads <= ((days * 24u) + 2u), "the RTC is read about once an hour");
+}
+
+// The main loop, calling HW_CLK_Monitor() every loop period and stalling now and then
+static runStats_t xRunFor(double seconds, bool checkError)
+{
+    runStats_t stats = { 0 };
+    int64_t endUs = xNowUs + (int64_t)(seconds * US_PER_SEC);
+    uint32_t last = HW_CLK_GetEpochTime();
+    uint32_t epoch;
+    uint8_t lastHour;
+    uint8_t hour;
+    long error;
+
+    HW_CLK_GetHour(&lastHour);
+
+    while ( xNowUs < endUs )
+    {
+        xNowUs += LOOP_PERIOD_US + (((rand() % STALL_ONE_IN) == 0) ? (rand() % MAX_STALL_US) : 0);
+        HW_CLK_Monitor();
+
+        epoch = HW_CLK_GetEpochTime();
+        error = xError();
+        HW_CLK_GetHour(&hour);
+
+        stats.backwards += (epoch < last) ? 1u : 0u;
+        stats.maxError = ((checkError == true) && (error > stats.maxError)) ? error : stats.maxError;
+
+        if ( hour != lastHour )
+        {
+            stats.hourSkips += (hour != (uint8_t)((lastHour + 1u) % 24u)) ? 1u : 0u;
+            lastHour = hour;
+        }
+
+        last = epoch;
+    }
+
+    return stats;
+}
+
+static long xError(void)
+{
+    return labs((long)HW_CLK_GetEpochTime() - (long)floor(xRtcNow()));
+}
+
+static double xRtcNow(void)
+{
+    return xRtcAtZero + (((double)xNowUs / US_PER_SEC) * (1.0 + (xRtcPpm * 1e-6)));
+}
+
+// Second n ticks at phase + n periods, and is only counted once its ISR has run
+uint32_t uC_TIME_GetRuntimeSeconds(void)
+{
+    double periodUs = US_PER_SEC * (1.0 - (xTickPpm * 1e-6));
+    int64_t n = (int64_t)floor((double)(xNowUs - xTickPhaseUs) / periodUs);
+    int64_t seenAtUs;
+
+    if ( n < 0 )
+    {
+        return 0u;
+    }
+
+    seenAtUs = xTickPhaseUs + (int64_t)(n * periodUs) + xLatencyUs[n % NUM_LATENCIES];
+
+    return (uint32_t)((xNowUs < seenAtUs) ? n : (n + 1));
+}
+
+// The M41T62 only has whole seconds, 0 when the read fails
+uint32_t HW_RTC_GetEpochTime(void)
+{
+    xRtcReads++;
+
+    if ( xRtcFailNext > 0u )
+    {
+        xRtcFailNext--;
+        return 0u;
+    }
+
+    return (uint32_t)floor(xRtcNow());
+}
+
+bool HW_RTC_SetTimeEpoch(uint32_t epoch_time)
+{
+    xRtcAtZero = (double)epoch_time - (((double)xNowUs / US_PER_SEC) * (1.0 + (xRtcPpm * 1e-6)));
+
+    return true;
+}
@@ -0,0 +1,702 @@
+/**************************************************************************************************
+* \file     test_eep_prefetch.c
+* \brief    Sensor data log drain over a modelled I2C EEP, with and without the prefetch ring
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <msp430.h>
+#include "driverlib.h"
+#include "am-ssm-spi-protocol.h"
+#include "APP.h"
+#include "APP_NVM.h"
+#include "APP_NVM_Cfg.h"
+#include "APP_NVM_Custom.h"
+#include "HW_EEP.h"
+#include "uC_I2C.h"
+#include "uC_SPI.h"
+#include "host_ssm.h"
+
+// Drains the sensor data log the way the AM does (get the number of entries, then get an entry, store it
+// and increment the tail, one at a time) through uC_SPI.c and the real ASP handlers in ssm-spi-protocol.c,
+// down through APP_NVM_Custom.c, APP_NVM.c, HW_EEP.c and uC_I2C.c to a CAT24C512 modelled under the
+// driverlib eUSCI_B calls. The model has 128 byte pages (a write wraps inside its page, a read runs on
+// across them), NACKs its address for the 5 ms write cycle, ignores writes while WP is high and can be
+// told to stop answering part way through the next reads. Time only moves on the bus: 22.5 us a byte
+// at 400 kHz, plus 250 ns for each pass of a status poll.
+//
+// xLoop() is the main loop with ASP_SSM_Periodic() and, for the prefetch runs, the read ahead after it.
+// The service time of an entry is the bus time spent handling its get, from the frame in to the
+// response queued, what the AM waits on SSM_RDY for. The log's first entries run over a page boundary,
+// so every staged read crosses one.
+//
+// Failures: the slave stops after part of an entry while it is being staged, which has to drop the ring
+// and log the EEP read error, with the gets after it served straight from EEP with the right data. A
+// get whose own read fails has to be NACKed and the next one answered.
+//
+// Usage: test_eep_prefetch
+
+#define LOG_ENTRIES                 24u
+#define DRAIN_ENTRIES               16u
+#define AM_BUSY_LOOPS               3u          // main loop passes while the AM stores an entry
+#define EEP_BYTES                   65536u
+#define EEP_PAGE_BYTES              128u
+#define EEP_WRITE_NS                5000000u    // tWR
+#define BUS_BYTE_NS                 22500u      // 9 clocks at 400 kHz
+#define POLL_NS                     250u        // one pass of a status poll, 4 MCLK cycles at 16 MHz
+#define IDLE_BYTE                   0xFFu
+#define MAX_FRAME                   (ASP_MAX_PAYLOAD + ASP_TOTAL_OVERHEAD_BYTES)
+#define FAIL_AFTER_BYTES            100u        // an entry read that stops here has crossed a page
+#define READS_PER_FAILED_ENTRY      4u          // 2 tries in ReadSensorDataEntry(), 2 in HW_EEP_ReadBlock()
+
+void USCI_A1_ISR(void);
+void USCIB0_ISR(void);
+
+typedef struct
+{
+    uint32_t entries;
+    uint64_t serviceNs;
+    uint64_t maxServiceNs;
+    uint64_t prefetchNs;
+    uint32_t servedFromRam;
+    uint32_t mismatches;
+}drainStats_t;
+
+// CAT24C512
+static uint8_t xMem[EEP_BYTES];
+static uint16_t xPtr = 0u;
+static uint64_t xWriteDoneNs = 0u;
+static bool xWp = true;
+static uint8_t xSlave = 0u;
+
+static bool xTxActive = false;
+static uint16_t xTxCount = 0u;
+static uint16_t xPageBase = 0u;
+static uint8_t xPage[EEP_PAGE_BYTES];
+static uint8_t xPageWritten[EEP_PAGE_BYTES];
+static uint16_t xPendingIv = USCI_NONE;
+
+static bool xRxActive = false;
+static bool xRxFailing = false;
+static uint64_t xRxDueNs = 0u;
+static uint16_t xRxCount = 0u;
+static uint16_t xRxStart = 0u;
+
+static uint16_t xLogStart = 0u;
+static uint16_t xFailReads = 0u;
+static uint16_t xFailAfter = 0u;
+
+static uint64_t xNowNs = 0u;
+static uint64_t xPrefetchNs = 0u;
+static uint32_t xReads = 0u;
+static uint32_t xEntryReads = 0u;
+static uint32_t xFailedReads = 0u;
+static uint32_t xPageCrossReads = 0u;
+static uint32_t xPageWrites = 0u;
+static uint32_t xWrapWrites = 0u;
+
+// AM side
+static bool xReady = false;
+static APP_NVM_SENSOR_DATA_T xLog[LOG_ENTRIES];
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static void xLoop(bool prefetch, uint64_t * p_aspNs);
+static uint8_t xClockByte(uint8_t mosi);
+static uint8_t xTransact(const uint8_t * p_frame, uint8_t len, bool prefetch, uint8_t * p_response, uint64_t * p_aspNs);
+static uint8_t xBuildCommand(uint8_t * p_frame, uint8_t cmd);
+static uint8_t xBuildGet(uint8_t * p_frame);
+static void xFillLog(uint8_t tail, uint8_t head);
+static uint8_t xEepTail(void);
+static bool xDrain(bool prefetch, bool announce, uint8_t count, drainStats_t * p_stats);
+static bool xAddressSlave(void);
+static void xWriteByte(uint8_t value);
+static bool xRxByteIn(void);
+static uint8_t xRxTake(void);
+static void xRxEnd(void);
+
+int main(void)
+{
+    drainStats_t before = {};
+    drainStats_t after = {};
+    drainStats_t failed = {};
+    uint8_t frame[MAX_FRAME];
+    asp_msg_t response;
+    uint8_t len = 0u;
+    uint32_t reads = 0u;
+    uint32_t errors = 0u;
+    uint64_t aspNs = 0u;
+    uint64_t failNs = 0u;
+    bool ok = true;
+
+    srand(37);
+    xLogStart = Section_Map[APP_NVM_SECT_TYPE_SENSOR_DATA].start_addr + sizeof(APP_NVM_SECTION_HDR_T);
+    uC_SPI_Init();
+    uC_I2C_Init();
+    HW_EEP_Init();
+
+    printf("  %u byte entries from 0x%04X, entry 0 ends at 0x%04X\n", (unsigned)sizeof(APP_NVM_SENSOR_DATA_T),
+           (unsigned)xLogStart, (unsigned)(xLogStart + sizeof(APP_NVM_SENSOR_DATA_T) - 1u));
+    xCheck((xLogStart / EEP_PAGE_BYTES) != ((xLogStart + sizeof(APP_NVM_SENSOR_DATA_T) - 1u) / EEP_PAGE_BYTES),
+           "the first entry runs over a page boundary");
+
+    // Without the read ahead every get reads its entry from EEP
+    xFillLog(0u, LOG_ENTRIES);
+    ok = xDrain(false, true, DRAIN_ENTRIES, &before);
+    xCheck(ok && (before.mismatches == 0u), "direct: every entry comes back as it is in EEP");
+    xCheck(xEepTail() == DRAIN_ENTRIES, "direct: the tail in EEP follows the increments");
+
+    xFillLog(0u, LOG_ENTRIES);
+    reads = xPageCrossReads;
+    ok = xDrain(true, true, DRAIN_ENTRIES, &after);
+    xCheck(ok && (after.mismatches == 0u), "prefetch: every entry comes back as it is in EEP");
+    xCheck(after.servedFromRam == DRAIN_ENTRIES, "prefetch: every get is answered from the ring, only the header is read");
+    xCheck((xPageCrossReads - reads) >= DRAIN_ENTRIES, "prefetch: the staged reads cross pages");
+    xCheck(xEepTail() == DRAIN_ENTRIES, "prefetch: the tail in EEP follows the increments");
+    xCheck(after.maxServiceNs < (before.serviceNs / before.entries), "prefetch: the slowest get beats the direct mean");
+
+    // The slave goes away part way through staging the second entry, the first was staged with the count
+    xFillLog(0u, LOG_ENTRIES);
+    len = xBuildCommand(frame, CMD_GET_ENTRIES_IN_LOG);
+    (void)xTransact(frame, len, true, response.bytes, NULL);
+    errors = HOST_GetErrorBits();
+    reads = xFailedReads;
+    xFailReads = READS_PER_FAILED_ENTRY;
+    xFailAfter = FAIL_AFTER_BYTES;
+    failNs = xPrefetchNs;
+    xLoop(true, NULL);
+    failNs = (xPrefetchNs - failNs);
+    xCheck((xFailedReads - reads) == READS_PER_FAILED_ENTRY, "fail: every retry of the staged read times out");
+    xCheck(((HOST_GetErrorBits() & ~errors) & EEPROM_READ_ERROR) != 0u, "fail: the EEP read error is raised");
+    APP_indicateErrorResolved(EEPROM_READ_ERROR);
+
+    ok = xDrain(true, false, 4u, &failed);
+    xCheck(ok && (failed.mismatches == 0u), "fail: the entries after it still come back as they are in EEP");
+    xCheck(failed.servedFromRam == 0u, "fail: the ring is dropped, the gets go to EEP until the next drain");
+
+    // The get's own read fails, it is NACKed and asked again
+    reads = xFailedReads;
+    xFailReads = READS_PER_FAILED_ENTRY;
+    xFailAfter = 0u;
+    len = xBuildGet(frame);
+    (void)xTransact(frame, len, true, response.bytes, &aspNs);
+    xCheck((response.fields.messageID == ASP_NACK_MSG_ID) && ((xFailedReads - reads) == READS_PER_FAILED_ENTRY),
+           "fail: a get whose read times out is NACKed");
+    xCheck((aspNs / 1000u) < 10000u, "fail: the NACK comes back inside 10 ms");
+    ok = xDrain(true, false, 1u, &failed);
+    xCheck(ok && (failed.mismatches == 0u), "fail: the get after it is answered");
+    APP_indicateErrorResolved(EEPROM_READ_ERROR);
+
+    xCheck(xWrapWrites == 0u, "no write wrapped inside its page");
+
+    printf("  %u entries, service time is the bus time from the get in to the response queued:\n", (unsigned)DRAIN_ENTRIES);
+    printf("    direct:   %7.1f us mean %7.1f us max per entry\n",
+           (double)before.serviceNs / before.entries / 1000.0, (double)before.maxServiceNs / 1000.0);
+    printf("    prefetch: %7.1f us mean %7.1f us max per entry, %7.1f us per entry staged in the main loop\n",
+           (double)after.serviceNs / after.entries / 1000.0, (double)after.maxServiceNs / 1000.0,
+           (double)after.prefetchNs / after.entries / 1000.0);
+    printf("    failed staging: %u reads of %u bytes and a timeout, %7.1f us\n", (unsigned)READS_PER_FAILED_ENTRY,
+           (unsigned)FAIL_AFTER_BYTES, (double)failNs / 1000.0);
+    printf("  EEP: %u reads (%u over a page boundary, %u timed out), %u page writes\n", (unsigned)xReads,
+           (unsigned)xPageCrossReads, (unsigned)xFailedReads, (unsigned)xPageWrites);
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// One pass of the main loop, as in main.c. Fills in the bus time of the ASP half, the read ahead's adds up.
+static void xLoop(bool prefetch, uint64_t * p_aspNs)
+{
+    uint64_t start = xNowNs;
+
+    ASP_SSM_Periodic();
+    if ( p_aspNs != NULL )
+    {
+        *p_aspNs = (xNowNs - start);
+    }
+
+    start = xNowNs;
+    if ( prefetch == true )
+    {
+        APP_NVM_Custom_PrefetchSensorData();
+    }
+    xPrefetchNs += (xNowNs - start);
+}
+
+// One byte clocked by the AM, returns what the SSM sent back
+static uint8_t xClockByte(uint8_t mosi)
+{
+    uint8_t miso = UCA1TXBUF;
+
+    UCA1IV = USCI_SPI_UCTXIFG;
+    USCI_A1_ISR();
+    UCA1RXBUF = mosi;
+    UCA1IV = USCI_SPI_UCRXIFG;
+    USCI_A1_ISR();
+
+    return miso;
+}
+
+// Clocks a frame in, runs the main loop until SSM_RDY drops and clocks the response out. Returns its length,
+// 0 if there was none. Fills in the bus time of the pass that handled the frame.
+static uint8_t xTransact(const uint8_t * p_frame, uint8_t len, bool prefetch, uint8_t * p_response, uint64_t * p_aspNs)
+{
+    uint8_t responseLen = 0u;
+
+    for ( uint8_t i = 0u; i < len; i++ )
+    {
+        (void)xClockByte(p_frame[i]);
+    }
+
+    xLoop(prefetch, p_aspNs);
+    if ( xReady == true )
+    {
+        return 0u;
+    }
+
+    p_response[0] = xClockByte(IDLE_BYTE);
+    p_response[1] = xClockByte(IDLE_BYTE);
+    responseLen = (p_response[1] + ASP_TOTAL_OVERHEAD_BYTES);
+    for ( uint8_t i = 2u; i < responseLen; i++ )
+    {
+        p_response[i] = xClockByte(IDLE_BYTE);
+    }
+    (void)xClockByte(IDLE_BYTE);
+
+    return responseLen;
+}
+
+static uint8_t xBuildCommand(uint8_t * p_frame, uint8_t cmd)
+{
+    asp_msg_t msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.fields.startFrame = ASP_START_FRAME_MAGIC;
+    msg.fields.payloadLen = ASP_COMMAND_PAYLOAD_BYTES;
+    msg.fields.messageID = ASP_COMMAND_MSG_ID;
+    msg.fields.payload.cmd.cmd = cmd;
+    memcpy(p_frame, msg.bytes, ASP_COMMAND_PAYLOAD_BYTES + ASP_HEADER_BYTES);
+    p_frame[ASP_COMMAND_PAYLOAD_BYTES + ASP_HEADER_BYTES] = ASP_ComputeChecksum(&msg);
+
+    return (ASP_COMMAND_PAYLOAD_BYTES + ASP_TOTAL_OVERHEAD_BYTES);
+}
+
+static uint8_t xBuildGet(uint8_t * p_frame)
+{
+    asp_msg_t msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.fields.startFrame = ASP_START_FRAME_MAGIC;
+    msg.fields.payloadLen = ASP_GET_SENSOR_DATA_ENTRIES_PAYLOAD_BYTES;
+    msg.fields.messageID = ASP_GET_SENSOR_DATA_ENTRIES_MSG_ID;
+    msg.fields.payload.getLog.getNextEntry = 1u;
+    memcpy(p_frame, msg.bytes, ASP_GET_SENSOR_DATA_ENTRIES_PAYLOAD_BYTES + ASP_HEADER_BYTES);
+    p_frame[ASP_GET_SENSOR_DATA_ENTRIES_PAYLOAD_BYTES + ASP_HEADER_BYTES] = ASP_ComputeChecksum(&msg);
+
+    return (ASP_GET_SENSOR_DATA_ENTRIES_PAYLOAD_BYTES + ASP_TOTAL_OVERHEAD_BYTES);
+}
+
+// Random entries with good checksums and a header, written straight into the EEP
+static void xFillLog(uint8_t tail, uint8_t head)
+{
+    APP_NVM_SECTION_HDR_T hdr = {};
+    uint16_t start = Section_Map[APP_NVM_SECT_TYPE_SENSOR_DATA].start_addr;
+
+    for ( uint8_t n = 0u; n < LOG_ENTRIES; n++ )
+    {
+        uint8_t * p_bytes = (uint8_t *)&xLog[n];
+
+        for ( uint16_t i = 0u; i < sizeof(APP_NVM_SENSOR_DATA_T); i++ )
+        {
+            p_bytes[i] = (uint8_t)rand();
+        }
+        xLog[n].checksum = APP_NVM_ComputeChecksum(p_bytes, (sizeof(APP_NVM_SENSOR_DATA_T) - 1u));
+        memcpy(&xMem[start + sizeof(hdr) + (n * sizeof(APP_NVM_SENSOR_DATA_T))], p_bytes, sizeof(APP_NVM_SENSOR_DATA_T));
+    }
+
+    hdr.type = APP_NVM_SECT_TYPE_SENSOR_DATA;
+    hdr.head = head;
+    hdr.tail = tail;
+    hdr.entry_len = sizeof(APP_NVM_SENSOR_DATA_T);
+    hdr.current_addr = start + sizeof(hdr) + (head * sizeof(APP_NVM_SENSOR_DATA_T));
+    hdr.checksum = APP_NVM_ComputeChecksum((uint8_t *)&hdr, (sizeof(hdr) - 1u));
+    memcpy(&xMem[start], &hdr, sizeof(hdr));
+}
+
+static uint8_t xEepTail(void)
+{
+    APP_NVM_SECTION_HDR_T hdr;
+
+    memcpy(&hdr, &xMem[Section_Map[APP_NVM_SECT_TYPE_SENSOR_DATA].start_addr], sizeof(hdr));
+    return hdr.tail;
+}
+
+// The AM's drain of count entries from the current tail: the number of entries first (unless announce is
+// false, a drain that carries on), then get, store and increment for each. Adds up the service times and
+// checks every entry against the log.
+static bool xDrain(bool prefetch, bool announce, uint8_t count, drainStats_t * p_stats)
+{
+    uint8_t frame[MAX_FRAME];
+    asp_msg_t msg;
+    uint8_t * response = msg.bytes;
+    uint8_t len = 0u;
+    uint8_t tail = xEepTail();
+    uint64_t aspNs = 0u;
+    uint64_t prefetchNs = xPrefetchNs;
+    uint32_t reads = 0u;
+    asp_msg_t * p_msg = &msg;
+    bool ok = true;
+
+    if ( announce == true )
+    {
+        len = xBuildCommand(frame, CMD_GET_ENTRIES_IN_LOG);
+        len = xTransact(frame, len, prefetch, response, NULL);
+        ok &= (len != 0u) && (p_msg->fields.messageID == ASP_NUM_DATA_ENTRIES_MSG_ID);
+    }
+
+    for ( uint8_t n = 0u; n < count; n++ )
+    {
+        for ( uint8_t i = 0u; i < AM_BUSY_LOOPS; i++ )
+        {
+            xLoop(prefetch, NULL);
+        }
+
+        reads = xEntryReads;
+        len = xBuildGet(frame);
+        len = xTransact(frame, len, prefetch, response, &aspNs);
+        ok &= (len == (ASP_SENSOR_DATA_PAYLOAD_BYTES + ASP_TOTAL_OVERHEAD_BYTES));
+        ok &= (p_msg->fields.messageID == ASP_SENSOR_DATA_MSG_ID);
+        ok &= (ASP_ComputeChecksum(p_msg) == response[len - 1u]);
+        if ( memcmp(&p_msg->fields.payload.sensorData, &xLog[(tail + n) % LOG_ENTRIES], sizeof(APP_NVM_SENSOR_DATA_T)) != 0 )
+        {
+            p_stats->mismatches++;
+        }
+
+        p_stats->entries++;
+        p_stats->serviceNs += aspNs;
+        p_stats->maxServiceNs = (aspNs > p_stats->maxServiceNs) ? aspNs : p_stats->maxServiceNs;
+        p_stats->servedFromRam += (xEntryReads == reads) ? 1u : 0u;
+
+        // stored, the tail goes up
+        len = xBuildCommand(frame, CMD_INCREMENT_SENSOR_DATA_TAIL);
+        len = xTransact(frame, len, prefetch, response, NULL);
+        ok &= (len != 0u) && (p_msg->fields.messageID == ASP_ACK_MSG_ID);
+    }
+
+    p_stats->prefetchNs += (xPrefetchNs - prefetchNs);
+    return ok;
+}
+
+// START and the address byte. The EEP NACKs while a write cycle runs.
+static bool xAddressSlave(void)
+{
+    xNowNs += BUS_BYTE_NS;
+    return (xSlave == HW_EEP_SLAVE_ADDR) && (xNowNs >= xWriteDoneNs);
+}
+
+// A byte written to the EEP, the address and then data into the page latch
+static void xWriteByte(uint8_t value)
+{
+    xNowNs += BUS_BYTE_NS;
+
+    if ( xTxCount == 0u )
+    {
+        xPtr = (uint16_t)(value << 8);
+    }
+    else if ( xTxCount == 1u )
+    {
+        xPtr |= value;
+        xPageBase = (xPtr & ~(EEP_PAGE_BYTES - 1u));
+        memset(xPageWritten, 0, sizeof(xPageWritten));
+    }
+    else
+    {
+        uint16_t offset = (xPtr + (xTxCount - 2u)) % EEP_PAGE_BYTES;
+
+        //the address counter only runs inside the page, past its end it writes over the start
+        if ( ((xPtr % EEP_PAGE_BYTES) + (xTxCount - 2u)) >= EEP_PAGE_BYTES )
+        {
+            xWrapWrites++;
+        }
+        xPage[offset] = value;
+        xPageWritten[offset] = 1u;
+    }
+
+    xTxCount++;
+}
+
+// driverlib eUSCI_B I2C, what the EEP sees of it
+void EUSCI_B_I2C_initMaster(uint16_t baseAddress, EUSCI_B_I2C_initMasterParam *param)
+{
+}
+
+void EUSCI_B_I2C_setSlaveAddress(uint16_t baseAddress, uint8_t slaveAddress)
+{
+    xSlave = slaveAddress;
+}
+
+void EUSCI_B_I2C_setMode(uint16_t baseAddress, uint8_t mode)
+{
+}
+
+void EUSCI_B_I2C_enable(uint16_t baseAddress)
+{
+}
+
+void EUSCI_B_I2C_enableInterrupt(uint16_t baseAddress, uint16_t mask)
+{
+}
+
+void EUSCI_B_I2C_disableInterrupt(uint16_t baseAddress, uint16_t mask)
+{
+}
+
+void EUSCI_B_I2C_clearInterrupt(uint16_t baseAddress, uint16_t mask)
+{
+}
+
+// TXIFG0 is set as soon as the start goes out, the byte loaded is only sent if the address is ACKed
+void EUSCI_B_I2C_masterSendMultiByteStart(uint16_t baseAddress, uint8_t txData)
+{
+    xTxActive = true;
+    xTxCount = 0u;
+
+    if ( xAddressSlave() == true )
+    {
+        xWriteByte(txData);
+        xPendingIv = USCI_I2C_UCTXIFG0;
+    }
+    else
+    {
+        xPendingIv = USCI_I2C_UCNACKIFG;
+    }
+}
+
+bool EUSCI_B_I2C_masterSendMultiByteStartWithTimeout(uint16_t baseAddress, uint8_t txData, uint32_t timeout)
+{
+    EUSCI_B_I2C_masterSendMultiByteStart(baseAddress, txData);
+    return STATUS_SUCCESS;
+}
+
+void EUSCI_B_I2C_masterSendMultiByteNext(uint16_t baseAddress, uint8_t txData)
+{
+    xWriteByte(txData);
+    xPendingIv = USCI_I2C_UCTXIFG0;
+}
+
+// A stop after data starts the write cycle, unless WP is high
+void EUSCI_B_I2C_masterSendMultiByteStop(uint16_t baseAddress)
+{
+    if ( (xTxCount > 2u) && (xWp == false) )
+    {
+        for ( uint16_t i = 0u; i < EEP_PAGE_BYTES; i++ )
+        {
+            if ( xPageWritten[i] != 0u )
+            {
+                xMem[xPageBase + i] = xPage[i];
+            }
+        }
+        xWriteDoneNs = xNowNs + EEP_WRITE_NS;
+        xPageWrites++;
+    }
+
+    xTxActive = false;
+    xTxCount = 0u;
+    xPendingIv = USCI_NONE;
+}
+
+void EUSCI_B_I2C_masterSendSingleByte(uint16_t baseAddress, uint8_t txData)
+{
+    EUSCI_B_I2C_masterSendMultiByteStart(baseAddress, txData);
+    EUSCI_B_I2C_masterSendMultiByteStop(baseAddress);
+}
+
+bool EUSCI_B_I2C_masterSendSingleByteWithTimeout(uint16_t baseAddress, uint8_t txData, uint32_t timeout)
+{
+    EUSCI_B_I2C_masterSendSingleByte(baseAddress, txData);
+    return STATUS_SUCCESS;
+}
+
+// Busy while a transfer runs. A pending interrupt is taken here, the loops that poll this are where the
+// firmware waits for the ISR to finish a write.
+uint16_t EUSCI_B_I2C_isBusBusy(uint16_t baseAddress)
+{
+    if ( xPendingIv != USCI_NONE )
+    {
+        UCB0IV = xPendingIv;
+        xPendingIv = USCI_NONE;
+        USCIB0_ISR();
+        return EUSCI_B_I2C_BUS_BUSY;
+    }
+
+    xNowNs += POLL_NS;
+    return (xTxActive == true) ? EUSCI_B_I2C_BUS_BUSY : EUSCI_B_I2C_BUS_NOT_BUSY;
+}
+
+// A read runs on from the address pointer, over page boundaries. The next xFailReads reads of log entries
+// stop answering after xFailAfter bytes.
+void EUSCI_B_I2C_masterReceiveStart(uint16_t baseAddress)
+{
+    bool entry = (xPtr >= xLogStart);
+
+    xReads++;
+    xEntryReads += (entry == true) ? 1u : 0u;
+    xRxActive = xAddressSlave();
+    xRxCount = 0u;
+    xRxStart = xPtr;
+    xRxDueNs = xNowNs + BUS_BYTE_NS;
+    xRxFailing = ((xFailReads > 0u) && (entry == true)) || (xRxActive == false);
+
+    if ( (xFailReads > 0u) && (entry == true) )
+    {
+        xFailReads--;
+    }
+    if ( xRxFailing == true )
+    {
+        xFailedReads++;
+    }
+}
+
+static bool xRxByteIn(void)
+{
+    return (xRxActive == true) && ((xRxFailing == false) || (xRxCount < xFailAfter)) && (xNowNs >= xRxDueNs);
+}
+
+static uint8_t xRxTake(void)
+{
+    uint8_t value = xMem[xPtr];
+
+    xPtr++;
+    xRxCount++;
+    xRxDueNs = xNowNs + BUS_BYTE_NS;
+
+    return value;
+}
+
+static void xRxEnd(void)
+{
+    if ( (xRxCount > 0u) && ((xRxStart / EEP_PAGE_BYTES) != ((uint16_t)(xPtr - 1u) / EEP_PAGE_BYTES)) )
+    {
+        xPageCrossReads++;
+    }
+    xRxActive = false;
+}
+
+uint16_t EUSCI_B_I2C_getInterruptStatus(uint16_t baseAddress, uint16_t mask)
+{
+    xNowNs += POLL_NS;
+    return (((mask & EUSCI_B_I2C_RECEIVE_INTERRUPT0) != 0u) && (xRxByteIn() == true)) ? EUSCI_B_I2C_RECEIVE_INTERRUPT0 : 0u;
+}
+
+uint8_t EUSCI_B_I2C_masterReceiveMultiByteNext(uint16_t baseAddress)
+{
+    return xRxTake();
+}
+
+uint16_t EUSCI_B_I2C_masterIsStartSent(uint16_t baseAddress)
+{
+    xNowNs += POLL_NS;
+    return ((xRxActive == true) && (xRxFailing == false)) ? EUSCI_B_I2C_START_SEND_COMPLETE : EUSCI_B_I2C_SENDING_START;
+}
+
+// The stop goes with the last byte, which the timeout is counted in polls for
+bool EUSCI_B_I2C_masterReceiveMultiByteFinishWithTimeout(uint16_t baseAddress, uint8_t *txData, uint32_t timeout)
+{
+    while ( xRxByteIn() == false )
+    {
+        xNowNs += POLL_NS;
+        if ( --timeout == 0u )
+        {
+            xRxEnd();
+            return STATUS_FAIL;
+        }
+    }
+
+    *txData = xRxTake();
+    xRxEnd();
+    return STATUS_SUCCESS;
+}
+
+void EUSCI_B_I2C_masterReceiveMultiByteStop(uint16_t baseAddress)
+{
+    xRxEnd();
+}
+
+uint8_t EUSCI_B_I2C_masterReceiveSingleByte(uint16_t baseAddress)
+{
+    uint8_t value = 0u;
+
+    EUSCI_B_I2C_masterReceiveStart(baseAddress);
+    (void)EUSCI_B_I2C_masterReceiveMultiByteFinishWithTimeout(baseAddress, &value, 1000u);
+    return value;
+}
+
+// SDA is high, the bus does not need recovering
+uint8_t GPIO_getInputPinValue(uint8_t selectedPort, uint16_t selectedPins)
+{
+    return GPIO_INPUT_PIN_HIGH;
+}
+
+// WP, SSM_RDY and WAKE_AP
+void HW_GPIO_Set_WP_EEPRM(void)
+{
+    xWp = true;
+}
+
+void HW_GPIO_Clear_WP_EEPRM(void)
+{
+    xWp = false;
+}
+
+void HW_GPIO_Set_SSM_RDY(void)
+{
+    xReady = true;
+}
+
+void HW_GPIO_Clear_SSM_RDY(void)
+{
+    xReady = false;
+}
+
+void HW_GPIO_Clear_WAKE_AP(void)
+{
+}
+
+// APP.c passes the increment on to the log
+void APP_handleIncrementSensorDataCmd(void)
+{
+    APP_NVM_SensorDataMsgAcked();
+}
@@ -0,0 +1,749 @@
+/**************************************************************************************************
+* \file     test_mag_sched.c
+* \brief    Replay of the magnetometer sampling scheduler against a simulated LIS2MDL
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "host_ssm.h"
+#include "driverlib.h"
+#include "lis2mdl_reg.h"
+#include "APP_ALGO.h"
+#include "APP_MAG.h"
+#include "HW_MAG.h"
+#include "uC_TIME.h"
+#include "algo-c-code/writeMagSample/writeMagSample.h"
+
+// Runs the real APP_ALGO, APP_MAG and HW_MAG against a LIS2MDL model on the I2C and GPIO stand-ins,
+// once with the scheduler as built (adaptive) and once held at full rate (fixed), and compares the
+// strokes, liters and magnetometer reads. The chip runs off its own clock, a little fast or slow of the
+// 50 ms algorithm tick, so some ticks get no new sample and the held sample path is used all the time.
+// Every write to a magnetometer window must be a real sample, a held one has to repeat the last real
+// sample: a zero vector at the start of a block is what the window code writes for a non new sample it
+// has nothing to repeat. The new data flags are only reported on a tick the sample was read.
+//
+// Once an hour, between sessions, the magnetometer is turned off and on again as APP.c does when stroke
+// detection is switched. Nothing held from before it was turned off may be written after.
+//
+// The field is synthetic (pump sessions with water every 6 minutes at a few stroke rates, plus a knock on
+// the handle with nobody at the pump), or the magnetometer and pad columns of an ssm_capture.py file.
+//
+// Usage: test_mag_sched [capture.csv]
+
+#define SYNTH_HOURS                 8u
+#define MAX_REPORT_HOURS            24u
+#define MS_PER_HOUR                 3600000ul
+#define SAMPLES_PER_HOUR            (MS_PER_HOUR / HOST_MS_PER_SAMPLE)
+#define LOOP_TICK_MS                10u
+
+#define SESSION_EVERY_MS            (6ul * 60ul * 1000ul)
+#define NUM_SESSION_TYPES           4u
+#define WATER_DEPTH_PADS            7.2
+#define PAD_WET_DROP                260
+#define REST_X                      1500
+#define REST_Y                      -800
+#define REST_Z                      300
+
+#define CHIP_DRIFT_PERMILLE         7       // ODR error of the chip clock, tried both ways
+#define MAG_OFF_AT_MS               300000ul    // into the hour, the first session has drained by then
+#define MAG_ON_AT_MS                330000ul
+#define STROKE_TOLERANCE_PERCENT    1u
+
+// LIS2MDL bits used by HW_MAG
+#define WHO_AM_I_REG                0x4Fu
+#define CFG_A_MD_MASK               0x03u
+#define CFG_A_ODR_SHIFT             2u
+#define CFG_A_ODR_MASK              0x03u
+#define CFG_A_SOFT_RST              0x20u
+#define CFG_A_REBOOT                0x40u
+#define CFG_A_IDLE                  0x03u
+#define CFG_C_DRDY_ON_PIN           0x01u
+#define CFG_C_INT_ON_PIN            0x40u
+#define INT_CTRL_IEA                0x04u
+#define INT_CTRL_IEN                0x01u
+#define INT_SOURCE_INT              0x01u
+#define STATUS_NEW_DATA             0x0Fu
+#define STATUS_OVERRUN              0xF0u
+#define REG_ADDR_MASK               0x7Fu
+#define NUM_REGS                    0x80u
+
+typedef struct
+{
+    double strokeHz;
+    uint32_t lengthMs;
+    bool water;
+    bool active;            // somebody at the pump, the pad proximity wakes the algorithm
+}sessionType_t;
+
+typedef struct
+{
+    uint32_t strokes;
+    uint32_t liters;
+    uint32_t hourlyStrokes[MAX_REPORT_HOURS];
+    uint32_t hourlyLiters[MAX_REPORT_HOURS];
+    uint32_t hours;
+    uint32_t magReads;
+    uint32_t i2cTransfers;
+    uint32_t windowWrites;
+    uint32_t repeatWrites;
+    uint32_t zeroWrites;
+    uint32_t staleStatus;   // new data flags reported without a read, or a read reported without them
+    uint32_t staleWrites;   // written after the magnetometer was turned on again, before its first read
+    uint32_t restarts;
+    uint32_t idleWindows;
+    uint32_t idleMs;
+}runResult_t;
+
+static const sessionType_t xSessionTypes[NUM_SESSION_TYPES] =
+{
+    { 1.5, 200000ul, true,  true  },
+    { 2.4, 150000ul, true,  true  },    // hard pumping
+    { 1.0, 240000ul, true,  true  },
+    { 1.5,  20000ul, false, false },    // the handle knocked, only the threshold interrupt sees it
+};
+
+// LIS2MDL model
+static uint8_t xRegs[NUM_REGS];
+static double xNextSampleMs = 0.0;
+static double xChipScale = 1.0;
+static bool xPinHigh = false;
+static bool xPinIfg = false;
+static bool xPinIntEnabled = false;
+static uint8_t xPinEdge = GPIO_LOW_TO_HIGH_TRANSITION;
+static uint32_t xI2cTransfers = 0u;
+
+// Run state
+static const hostCaptureRow_t * xp_capture = NULL;
+static uint32_t xCaptureRows = 0u;
+static bool xFixedRate = false;
+static runResult_t xResult;
+static uint64_t xNowMs = 0u;
+static bool xAwaitingFirstRead = false;
+
+static void xSynthRow(uint32_t sample, hostCaptureRow_t * p_row);
+static void xField(uint64_t ms, int16_t * p_xyz);
+static uint32_t xHash(uint32_t value);
+static void xChipReset(void);
+static void xChipAdvance(uint64_t ms);
+static void xChipUpdatePin(void);
+static void xChipSample(uint64_t ms);
+static void xRunOne(bool fixedRate, int driftPermille, uint32_t samples, runResult_t * p_result);
+static bool xRunForked(bool fixedRate, int driftPermille, uint32_t samples, runResult_t * p_result);
+static bool xCompare(int driftPermille, const runResult_t * p_fixed, const runResult_t * p_adaptive);
+
+// Host stand-ins for the bus and pin, both go to the chip model
+
+bool uC_I2C_WriteMulti(uint8_t slave_addr, uint8_t * p_payload, uint8_t num_bytes, bool retry_on_nak)
+{
+    uint8_t reg = p_payload[0] & REG_ADDR_MASK;
+    uint8_t i;
+
+    xI2cTransfers++;
+
+    for ( i = 1u; i < num_bytes; i++, reg++ )
+    {
+        if ( reg == LIS2MDL_CFG_REG_A )
+        {
+            if ( (p_payload[i] & (CFG_A_SOFT_RST | CFG_A_REBOOT)) != 0u )
+            {
+                xChipReset();
+                continue;
+            }
+
+            //a new mode or rate starts the sample clock over
+            xNextSampleMs = (double)xNowMs + ((1000.0 / (10u << ((p_payload[i] >> CFG_A_ODR_SHIFT) & CFG_A_ODR_MASK))) * xChipScale);
+        }
+
+        xRegs[reg] = p_payload[i];
+    }
+
+    xChipUpdatePin();
+
+    return true;
+}
+
+uint8_t uC_I2C_ReadRegSingle(uint8_t slave_addr, uint8_t reg_addr, bool retry_on_nak)
+{
+    uint8_t reg = reg_addr & REG_ADDR_MASK;
+    uint8_t value = xRegs[reg];
+
+    xI2cTransfers++;
+
+    if ( reg == LIS2MDL_OUTZ_H_REG )
+    {
+        //reading the last output byte frees the output registers
+        xRegs[LIS2MDL_STATUS_REG] = 0u;
+    }
+    else if ( reg == LIS2MDL_INT_SOURCE_REG )
+    {
+        xRegs[LIS2MDL_INT_SOURCE_REG] = 0u;
+    }
+
+    xChipUpdatePin();
+
+    return value;
+}
+
+uint8_t GPIO_getInputPinValue(uint8_t selectedPort, uint16_t selectedPins)
+{
+    return (xPinHigh == true) ? GPIO_INPUT_PIN_HIGH : GPIO_INPUT_PIN_LOW;
+}
+
+void GPIO_enableInterrupt(uint8_t selectedPort, uint16_t selectedPins)
+{
+    xPinIntEnabled = true;
+    xChipUpdatePin();
+}
+
+void GPIO_disableInterrupt(uint8_t selectedPort, uint16_t selectedPins)
+{
+    xPinIntEnabled = false;
+}
+
+void GPIO_clearInterrupt(uint8_t selectedPort, uint16_t selectedPins)
+{
+    xPinIfg = false;
+}
+
+void GPIO_selectInterruptEdge(uint8_t selectedPort, uint16_t selectedPins, uint8_t edgeSelect)
+{
+    xPinEdge = edgeSelect;
+}
+
+// What APP.c does with it
+void APP_indicateMagnetometerThresholdInterrupt(void)
+{
+    APP_MAG_Wake();
+}
+
+// Held at full rate for the fixed run
+void __real_APP_MAG_WindowProcessed(bool activityDetected, int16_t xLsb, int16_t yLsb, int16_t zLsb);
+void __wrap_APP_MAG_WindowProcessed(bool activityDetected, int16_t xLsb, int16_t yLsb, int16_t zLsb)
+{
+    __real_APP_MAG_WindowProcessed((activityDetected == true) || (xFixedRate == true), xLsb, yLsb, zLsb);
+
+    if ( APP_MAG_GetState() == APP_MAG_IDLE )
+    {
+        xResult.idleWindows++;
+    }
+}
+
+// Every sample that goes into a window
+void __real_writeMagSample(magWindows_t *mag_windows, const magSample_t *mag_sample);
+void __wrap_writeMagSample(magWindows_t *mag_windows, const magSample_t *mag_sample)
+{
+    static uint32_t lastReadCount = 0u;
+
+    xResult.windowWrites++;
+
+    //no read since the last write, the sample was held
+    if ( HW_MAG_GetSampleReadCount() == lastReadCount )
+    {
+        xResult.repeatWrites++;
+    }
+
+    lastReadCount = HW_MAG_GetSampleReadCount();
+
+    if ( xAwaitingFirstRead == true )
+    {
+        xResult.staleWrites++;
+    }
+
+    if ( (mag_sample->status != STATUS_NEW_DATA) && (mag_windows->write_idx == 0u) )
+    {
+        xResult.zeroWrites++;
+    }
+
+    __real_writeMagSample(mag_windows, mag_sample);
+}
+
+// The status APP_ALGO gets each tick, right after HW_MAG_ReadSampleIfReady()
+void __real_HW_MAG_GetLatestMagAndTempData(int16_t *xLsb, int16_t *yLsb, int16_t *zLsb, int16_t *tempLsb, uint8_t *bitFlags);
+void __wrap_HW_MAG_GetLatestMagAndTempData(int16_t *xLsb, int16_t *yLsb, int16_t *zLsb, int16_t *tempLsb, uint8_t *bitFlags)
+{
+    static uint32_t lastReadCount = 0u;
+    bool read = (HW_MAG_GetSampleReadCount() != lastReadCount);
+
+    lastReadCount = HW_MAG_GetSampleReadCount();
+    __real_HW_MAG_GetLatestMagAndTempData(xLsb, yLsb, zLsb, tempLsb, bitFlags);
+
+    if ( *bitFlags != ((read == true) ? STATUS_NEW_DATA : 0u) )
+    {
+        xResult.staleStatus++;
+    }
+
+    if ( read == true )
+    {
+        xAwaitingFirstRead = false;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t samples = SYNTH_HOURS * SAMPLES_PER_HOUR;
+    runResult_t fixed;
+    runResult_t adaptive;
+    bool pass = true;
+    int drift;
+
+    if ( argc > 1 )
+    {
+        hostCaptureRow_t * p_rows = NULL;
+
+        xCaptureRows = HOST_LoadCapture(argv[1], &p_rows);
+        xp_capture = p_rows;
+        samples = xCaptureRows;
+        printf("replaying %s, %u samples\n", argv[1], samples);
+    }
+    else
+    {
+        printf("replaying %u synthetic hours\n", SYNTH_HOURS);
+    }
+
+    for ( drift = -CHIP_DRIFT_PERMILLE; drift <= CHIP_DRIFT_PERMILLE; drift += 2 * CHIP_DRIFT_PERMILLE )
+    {
+        if ( (xRunForked(true, drift, samples, &fixed) == false) || (xRunForked(false, drift, samples, &adaptive) == false) )
+        {
+            printf("FAIL: replay did not finish\n");
+            return 1;
+        }
+
+        pass &= xCompare(drift, &fixed, &adaptive);
+    }
+
+    printf("%s\n", (pass == true) ? "PASS" : "FAIL");
+
+    return (pass == true) ? 0 : 1;
+}
+
+static bool xCompare(int driftPermille, const runResult_t * p_fixed, const runResult_t * p_adaptive)
+{
+    bool pass = true;
+    uint32_t strokeDiff;
+    uint32_t hr;
+
+    printf("\nchip clock %+d permille        fixed   adaptive\n", driftPermille);
+    printf("  strokes               %8u   %8u\n", p_fixed->strokes, p_adaptive->strokes);
+    printf("  liters                %8u   %8u\n", p_fixed->liters, p_adaptive->liters);
+    printf("  magnetometer reads    %8u   %8u  (%.0f%%)\n", p_fixed->magReads, p_adaptive->magReads,
+           (100.0 * p_adaptive->magReads) / p_fixed->magReads);
+    printf("  I2C transfers         %8u   %8u  (%.0f%%)\n", p_fixed->i2cTransfers, p_adaptive->i2cTransfers,
+           (100.0 * p_adaptive->i2cTransfers) / p_fixed->i2cTransfers);
+    printf("  window writes         %8u   %8u\n", p_fixed->windowWrites, p_adaptive->windowWrites);
+    printf("  held samples written  %8u   %8u\n", p_fixed->repeatWrites, p_adaptive->repeatWrites);
+    printf("  zero vectors written  %8u   %8u\n", p_fixed->zeroWrites, p_adaptive->zeroWrites);
+    printf("  restarts              %8u   %8u\n", p_fixed->restarts, p_adaptive->restarts);
+    printf("  stale status          %8u   %8u\n", p_fixed->staleStatus, p_adaptive->staleStatus);
+    printf("  stale samples written %8u   %8u\n", p_fixed->staleWrites, p_adaptive->staleWrites);
+    printf("  idle                  %8s   %7.0f%%  (%u windows)\n", "-",
+           (100.0 * p_adaptive->idleMs) / ((double)p_adaptive->hours * MS_PER_HOUR), p_adaptive->idleWindows);
+
+    for ( hr = 0u; hr < p_fixed->hours; hr++ )
+    {
+        printf("  hour %u                %4u/%-4u  %4u/%-4u  (strokes/liters)\n", hr, p_fixed->hourlyStrokes[hr], p_fixed->hourlyLiters[hr],
+               p_adaptive->hourlyStrokes[hr], p_adaptive->hourlyLiters[hr]);
+    }
+
+    if ( (p_fixed->zeroWrites != 0u) || (p_adaptive->zeroWrites != 0u) )
+    {
+        printf("  FAIL: a held sample was written as a zero vector\n");
+        pass = false;
+    }
+
+    if ( (p_fixed->staleStatus != 0u) || (p_adaptive->staleStatus != 0u) )
+    {
+        printf("  FAIL: the new data flags did not follow the reads\n");
+        pass = false;
+    }
+
+    if ( (p_fixed->restarts == 0u) || (p_fixed->staleWrites != 0u) || (p_adaptive->staleWrites != 0u) )
+    {
+        printf("  FAIL: a sample from before the magnetometer was turned off was written after it came back\n");
+        pass = false;
+    }
+
+    strokeDiff = (p_fixed->strokes > p_adaptive->strokes) ? (p_fixed->strokes - p_adaptive->strokes) : (p_adaptive->strokes - p_fixed->strokes);
+
+    if ( (strokeDiff * 100u) > (p_fixed->strokes * STROKE_TOLERANCE_PERCENT) )
+    {
+        printf("  FAIL: adaptive strokes are more than %u%% off the fixed rate count\n", STROKE_TOLERANCE_PERCENT);
+        pass = false;
+    }
+
+    if ( p_fixed->strokes == 0u )
+    {
+        printf("  FAIL: no strokes counted, the replay never calibrated\n");
+        pass = false;
+    }
+
+    if ( memcmp(p_fixed->hourlyLiters, p_adaptive->hourlyLiters, sizeof(p_fixed->hourlyLiters)) != 0 )
+    {
+        printf("  FAIL: liters differ\n");
+        pass = false;
+    }
+
+    if ( p_adaptive->magReads >= p_fixed->magReads )
+    {
+        printf("  FAIL: the scheduler saved no reads\n");
+        pass = false;
+    }
+
+    return pass;
+}
+
+// Each run starts the firmware modules from their power up state, so it gets its own process
+static bool xRunForked(bool fixedRate, int driftPermille, uint32_t samples, runResult_t * p_result)
+{
+    int fds[2];
+    pid_t pid;
+    int status = 0;
+    bool done;
+
+    if ( pipe(fds) != 0 )
+    {
+        return false;
+    }
+
+    fflush(stdout);
+    pid = fork();
+
+    if ( pid == 0 )
+    {
+        close(fds[0]);
+        xRunOne(fixedRate, driftPermille, samples, p_result);
+        done = (write(fds[1], p_result, sizeof(runResult_t)) == sizeof(runResult_t));
+        _exit((done == true) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    done = (read(fds[0], p_result, sizeof(runResult_t)) == sizeof(runResult_t));
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    return (done == true) && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+// The main loop as main.c and APP.c run it: wake every 10 ms tick or on the pin interrupt, monitor the
+// magnetometer, and run the algorithm nest every 50 ms
+static void xRunOne(bool fixedRate, int driftPermille, uint32_t samples, runResult_t * p_result)
+{
+    APP_NVM_SENSOR_DATA_T sensorData;
+    hostCaptureRow_t row;
+    bool wasActive = false;
+    bool dataReadyWake = false;
+    uint32_t hour;
+    uint64_t ms;
+    uint64_t endMs = (uint64_t)samples * HOST_MS_PER_SAMPLE;
+
+    memset(&xResult, 0, sizeof(xResult));
+    memset(&sensorData, 0, sizeof(sensorData));
+    xFixedRate = fixedRate;
+    xChipScale = 1.0 + (driftPermille / 1000.0);
+    xChipReset();
+
+    HW_MAG_InitBusAndDevice();
+    APP_ALGO_Init();
+    HW_MAG_InitSampleRateAndPowerModeOn();
+    APP_ALGO_setStrokeDetectionIsOn(true);
+
+    for ( ms = 0u; ms < endMs; ms++ )
+    {
+        xNowMs = ms;
+        HOST_SetTimeMs(ms);
+        dataReadyWake = false;
+        xChipAdvance(ms);
+
+        if ( (xPinIfg == true) && (xPinIntEnabled == true) )
+        {
+            //P2_ISR
+            xPinIfg = false;
+            HW_Mag_DataReadyIntOccured();
+            dataReadyWake = true;
+        }
+
+        if ( APP_MAG_GetState() == APP_MAG_IDLE )
+        {
+            xResult.idleMs++;
+        }
+
+        if ( (dataReadyWake == false) && ((ms % LOOP_TICK_MS) != 0u) )
+        {
+            continue;
+        }
+
+        HW_MAG_Monitor();
+
+        if ( (ms % HOST_MS_PER_SAMPLE) != 0u )
+        {
+            continue;
+        }
+
+        //stroke detection switched off and on again, see APP_handleConfigs()
+        if ( (ms % MS_PER_HOUR) == MAG_OFF_AT_MS )
+        {
+            HW_MAG_TurnOffSampling();
+            APP_ALGO_setStrokeDetectionIsOn(false);
+        }
+        else if ( (ms % MS_PER_HOUR) == MAG_ON_AT_MS )
+        {
+            HW_MAG_InitSampleRateAndPowerModeOn();
+            APP_ALGO_setStrokeDetectionIsOn(true);
+            xAwaitingFirstRead = true;
+            xResult.restarts++;
+        }
+
+        if ( xp_capture != NULL )
+        {
+            row = xp_capture[ms / HOST_MS_PER_SAMPLE];
+        }
+        else
+        {
+            xSynthRow((uint32_t)(ms / HOST_MS_PER_SAMPLE), &row);
+        }
+
+        HOST_SetRow(&row);
+
+        //APP_setPumpActive()
+        if ( (row.active == true) && (wasActive == false) )
+        {
+            APP_ALGO_wakeUpInit();
+            APP_MAG_Wake();
+        }
+
+        wasActive = row.active;
+
+        APP_ALGO_Nest(row.active);
+
+        if ( (((ms / HOST_MS_PER_SAMPLE) + 1u) % SAMPLES_PER_HOUR) == 0u )
+        {
+            hour = (uint32_t)(ms / MS_PER_HOUR);
+            APP_ALGO_updateHourlyFields(&sensorData, (uint8_t)(hour % HOUR_PER_DAY));
+
+            if ( hour < (sizeof(xResult.hourlyStrokes) / sizeof(xResult.hourlyStrokes[0])) )
+            {
+                xResult.hourlyStrokes[hour] = sensorData.strokesPerHour[hour % HOUR_PER_DAY];
+                xResult.hourlyLiters[hour] = sensorData.litersPerHour[hour % HOUR_PER_DAY];
+                xResult.hours = hour + 1u;
+            }
+
+            xResult.strokes += sensorData.strokesPerHour[hour % HOUR_PER_DAY];
+            xResult.liters += sensorData.litersPerHour[hour % HOUR_PER_DAY];
+        }
+    }
+
+    xResult.magReads = HW_MAG_GetSampleReadCount();
+    xResult.i2cTransfers = xI2cTransfers;
+    *p_result = xResult;
+}
+
+// One 50 ms row of the synthetic capture: the pads see the water rise, slosh with each stroke and drain
+static void xSynthRow(uint32_t sample, hostCaptureRow_t * p_row)
+{
+    uint64_t ms = (uint64_t)sample * HOST_MS_PER_SAMPLE;
+    const sessionType_t * p_type = &xSessionTypes[(ms / SESSION_EVERY_MS) % NUM_SESSION_TYPES];
+    double sec = (double)(ms % SESSION_EVERY_MS) / 1000.0;
+    double lengthSec = p_type->lengthMs / 1000.0;
+    bool pumping = (sec < lengthSec);
+    double level = 0.0;
+    double cover;
+    uint32_t noise;
+    int16_t xyz[3];
+    int i;
+
+    if ( p_type->water == true )
+    {
+        if ( pumping == true )
+        {
+            level = fmin(WATER_DEPTH_PADS, sec / 3.0) + ((sec > 25.0) ? (0.6 * sin(2.0 * M_PI * p_type->strokeHz * sec)) : 0.0);
+        }
+        else
+        {
+            level = fmax(0.0, WATER_DEPTH_PADS - ((sec - lengthSec) / 4.0));
+        }
+    }
+
+    memset(p_row, 0, sizeof(hostCaptureRow_t));
+    p_row->tick = sample;
+    p_row->strokes = true;
+    p_row->active = (p_type->active == true) && ((pumping == true) || (level > 0.0));
+
+    //pad8 is at the bottom and covers first
+    for ( i = 0; i < HOST_NUM_PADS; i++ )
+    {
+        cover = fmin(1.0, fmax(0.0, level - (HOST_NUM_PADS - 1 - i)));
+        noise = xHash((sample * HOST_NUM_PADS) + (uint32_t)i);
+        p_row->pads[i] = (int16_t)(1200 + (10 * i) - (int)(PAD_WET_DROP * cover) + (int)(noise % 5u) - 2);
+
+        if ( cover > 0.0 )
+        {
+            p_row->pads[i] += (int16_t)((int)((noise >> 8) % 13u) - 6);
+        }
+    }
+
+    xField(ms, xyz);
+    p_row->magX = xyz[0];
+    p_row->magY = xyz[1];
+    p_row->magZ = xyz[2];
+    p_row->magTemp = 2400;
+    p_row->magStatus = STATUS_NEW_DATA;
+}
+
+// The field at the chip at any ms: a magnet on the handle swinging with each stroke
+static void xField(uint64_t ms, int16_t * p_xyz)
+{
+    const sessionType_t * p_type = &xSessionTypes[(ms / SESSION_EVERY_MS) % NUM_SESSION_TYPES];
+    double sec = (double)(ms % SESSION_EVERY_MS) / 1000.0;
+    double phase = 2.0 * M_PI * p_type->strokeHz * sec;
+    uint32_t noise = xHash((uint32_t)ms);
+    uint32_t row;
+
+    if ( xp_capture != NULL )
+    {
+        row = (uint32_t)(ms / HOST_MS_PER_SAMPLE);
+        row = (row < xCaptureRows) ? row : (xCaptureRows - 1u);
+        p_xyz[0] = xp_capture[row].magX;
+        p_xyz[1] = xp_capture[row].magY;
+        p_xyz[2] = xp_capture[row].magZ;
+    }
+    else if ( (ms % SESSION_EVERY_MS) < p_type->lengthMs )
+    {
+        p_xyz[0] = (int16_t)(REST_X + (int)(420.0 * sin(phase)) + (int)(noise % 7u) - 3);
+        p_xyz[1] = (int16_t)(REST_Y + (int)(260.0 * sin(phase + 0.4)) + (int)((noise >> 8) % 7u) - 3);
+        p_xyz[2] = (int16_t)(REST_Z + (int)(330.0 * sin(phase)) + (int)((noise >> 16) % 7u) - 3);
+    }
+    else
+    {
+        p_xyz[0] = (int16_t)(REST_X + (int)(noise % 5u) - 2);
+        p_xyz[1] = (int16_t)(REST_Y + (int)((noise >> 8) % 5u) - 2);
+        p_xyz[2] = (int16_t)(REST_Z + (int)((noise >> 16) % 5u) - 2);
+    }
+}
+
+static uint32_t xHash(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x7FEB352Du;
+    value ^= value >> 15;
+    value *= 0x846CA68Bu;
+    value ^= value >> 16;
+
+    return value;
+}
+
+// Power on, or a soft reset / reboot: idle with the interrupts off
+static void xChipReset(void)
+{
+    memset(xRegs, 0, sizeof(xRegs));
+    xRegs[WHO_AM_I_REG] = LIS2MDL_ID;
+    xRegs[LIS2MDL_CFG_REG_A] = CFG_A_IDLE;
+    xChipUpdatePin();
+}
+
+static void xChipAdvance(uint64_t ms)
+{
+    uint8_t cfgA = xRegs[LIS2MDL_CFG_REG_A];
+    double periodMs = (1000.0 / (10u << ((cfgA >> CFG_A_ODR_SHIFT) & CFG_A_ODR_MASK))) * xChipScale;
+
+    //only continuous mode is used
+    if ( (cfgA & CFG_A_MD_MASK) != 0u )
+    {
+        return;
+    }
+
+    while ( (double)ms >= xNextSampleMs )
+    {
+        xChipSample(ms);
+        xNextSampleMs += periodMs;
+    }
+}
+
+static void xChipSample(uint64_t ms)
+{
+    int16_t field[3];
+    int16_t offset;
+    int16_t out;
+    uint16_t threshold = (uint16_t)(xRegs[LIS2MDL_INT_THS_L_REG] | (xRegs[LIS2MDL_INT_THS_H_REG] << 8));
+    uint8_t axis;
+
+    xField(ms, field);
+
+    if ( (xRegs[LIS2MDL_STATUS_REG] & STATUS_NEW_DATA) != 0u )
+    {
+        xRegs[LIS2MDL_STATUS_REG] |= STATUS_OVERRUN;
+    }
+
+    xRegs[LIS2MDL_STATUS_REG] |= STATUS_NEW_DATA;
+
+    for ( axis = 0u; axis < 3u; axis++ )
+    {
+        //hard iron offsets are taken off the output
+        offset = (int16_t)(xRegs[LIS2MDL_OFFSET_X_REG_L + (2u * axis)] | (xRegs[LIS2MDL_OFFSET_X_REG_H + (2u * axis)] << 8));
+        out = (int16_t)(field[axis] - offset);
+        xRegs[LIS2MDL_OUTX_L_REG + (2u * axis)] = (uint8_t)out;
+        xRegs[LIS2MDL_OUTX_H_REG + (2u * axis)] = (uint8_t)((uint16_t)out >> 8);
+
+        //latched threshold interrupt, X enable is bit 7
+        if ( ((xRegs[LIS2MDL_INT_CRTL_REG] & INT_CTRL_IEN) != 0u) &&
+             ((xRegs[LIS2MDL_INT_CRTL_REG] & (0x80u >> axis)) != 0u) && (abs(out) > threshold) )
+        {
+            xRegs[LIS2MDL_INT_SOURCE_REG] |= (uint8_t)(INT_SOURCE_INT | (0x80u >> axis));
+        }
+    }
+
+    xRegs[LIS2MDL_TEMP_OUT_L_REG] = 0x60u;
+    xRegs[LIS2MDL_TEMP_OUT_H_REG] = 0x09u;
+
+    xChipUpdatePin();
+}
+
+// INT/DRDY pin, P2.7 sets its flag on the selected edge
+static void xChipUpdatePin(void)
+{
+    bool high = false;
+    bool intActive = ((xRegs[LIS2MDL_INT_SOURCE_REG] & INT_SOURCE_INT) != 0u);
+
+    if ( (xRegs[LIS2MDL_CFG_REG_C] & CFG_C_INT_ON_PIN) != 0u )
+    {
+        high = ((xRegs[LIS2MDL_INT_CRTL_REG] & INT_CTRL_IEA) != 0u) ? intActive : !intActive;
+    }
+    else if ( (xRegs[LIS2MDL_CFG_REG_C] & CFG_C_DRDY_ON_PIN) != 0u )
+    {
+        high = ((xRegs[LIS2MDL_STATUS_REG] & STATUS_NEW_DATA) == STATUS_NEW_DATA);
+    }
+
+    if ( (high == true) && (xPinHigh == false) && (xPinEdge == GPIO_LOW_TO_HIGH_TRANSITION) )
+    {
+        xPinIfg = true;
+    }
+    else if ( (high == false) && (xPinHigh == true) && (xPinEdge == GPIO_HIGH_TO_LOW_TRANSITION) )
+    {
+        xPinIfg = true;
+    }
+
+    xPinHigh = high;
+}
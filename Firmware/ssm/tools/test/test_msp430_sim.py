@@ -0,0 +1,419 @@
+#!/usr/bin/env python3
+"""Checks of msp430_sim.py, the simulator the cycle benchmark runs on.
+
+Hand assembled instructions are stepped one at a time and their cycles
+compared with the CPUX tables of SLAU445 (MSP430FR4xx and MSP430FR2xx family
+user's guide, "MSP430 and MSP430X Instructions Execution in the MSP430X CPU"):
+every source addressing mode of a Format I instruction into a register, the PC
+and memory, the Format II instructions, the MSP430X address instructions and a
+few extended ones. CALLA and RETA have to keep the 20 bit return address, and
+the per function counts of a small image (written here as an ELF file) have to
+split the cycles between caller and callee. The MPY32 checks cover the signed,
+unsigned and accumulate modes, byte operands, 32 bit operands and the
+fractional mode IQmath uses.
+
+Usage: python3 test_msp430_sim.py      (from this folder, test.sh runs it)
+"""
+
+import os
+import struct
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'bench'))
+import msp430_sim  # noqa: E402
+from msp430_sim import PC, SP, SR, C, Z, N, BYTE, WORD, ADDR  # noqa: E402
+
+CODE = 0x8000
+RAM = 0x2000
+STACK = 0x3000
+
+# MPY32 registers of the FR2xx parts
+MPY = 0x04C0
+MPYS = 0x04C2
+MAC = 0x04C4
+MACS = 0x04C6
+OP2 = 0x04C8
+RESLO = 0x04CA
+RESHI = 0x04CC
+SUMEXT = 0x04CE
+MPY32L = 0x04D0
+MPY32H = 0x04D2
+MPYS32L = 0x04D4
+MPYS32H = 0x04D6
+OP2L = 0x04E0
+OP2H = 0x04E2
+RES0 = 0x04E4
+MPY32CTL0 = 0x04EC
+
+# CALLA EDE at 0x10000 back down to RAM + 0x0100, the offset wraps through 20 bits
+EDE_BACK = (RAM + 0x0100 - 0x10002) & 0xFFFFF
+
+# Source addressing modes: (register, As, extension words), R5 and the words point into RAM
+SOURCES = {
+    'Rn':    (5, 0, []),
+    '@Rn':   (5, 2, []),
+    '@Rn+':  (5, 3, []),
+    '#N':    (PC, 3, [0x9000]),
+    'X(Rn)': (5, 1, [0x0010]),
+    'EDE':   (PC, 1, [(RAM + 0x0100 - (CODE + 2)) & 0xFFFF]),
+    '&EDE':  (SR, 1, [RAM + 0x0200]),
+}
+
+# SLAU445 cycles of ADD into a register and into memory, and of MOV into the PC and into memory
+ADD_CYCLES = {'Rn': (1, 4), '@Rn': (2, 5), '@Rn+': (2, 5), '#N': (2, 5), 'X(Rn)': (3, 6), 'EDE': (3, 6), '&EDE': (3, 6)}
+MOV_CYCLES = {'Rn': (2, 3), '@Rn': (3, 4), '@Rn+': (3, 4), '#N': (3, 4), 'X(Rn)': (4, 5), 'EDE': (4, 5), '&EDE': (4, 5)}
+
+# SLAU445 cycles of RRA, PUSH and CALL, None where the mode is not allowed
+FORMAT2_CYCLES = {
+    'Rn':    (1, 3, 4),
+    '@Rn':   (3, 3, 4),
+    '@Rn+':  (3, 3, 4),
+    '#N':    (None, 3, 4),
+    'X(Rn)': (4, 4, 5),
+    'EDE':   (4, 4, 5),
+    '&EDE':  (4, 4, 6),
+}
+
+passed = True
+
+
+def check(condition, what):
+    global passed
+    print('  %s: %s' % ('ok  ' if condition else 'FAIL', what))
+    passed = passed and condition
+
+
+def format1(opcode, sreg, source_as, dreg, ad, bw=0):
+    return (opcode << 12) | (sreg << 8) | (ad << 7) | (bw << 6) | (source_as << 4) | dreg
+
+
+def format2(kind, reg, source_as, bw=0):
+    return 0x1000 | (kind << 7) | (bw << 6) | (source_as << 4) | reg
+
+
+def new_sim(words, at=CODE):
+    """A simulator with the words at at, the PC on the first one, R5 and R6 pointing into RAM."""
+    sim = msp430_sim.Msp430()
+    for i, word in enumerate(words):
+        sim.store(at + 2 * i, word, WORD)
+    sim.r[PC] = at
+    sim.r[SP] = STACK
+    sim.r[5] = RAM
+    sim.r[6] = RAM + 0x0300
+    # whatever a source reads is a valid branch target
+    for addr in (RAM, RAM + 0x0010, RAM + 0x0100, RAM + 0x0200):
+        sim.store(addr, 0x9000, WORD)
+    return sim
+
+
+def step(sim):
+    before = sim.cycles
+    sim.step()
+    return sim.cycles - before
+
+
+def check_format1():
+    add_ok = []
+    mov_ok = []
+    for name, (sreg, source_as, words) in sorted(SOURCES.items()):
+        to_reg, to_mem = ADD_CYCLES[name]
+        to_pc, mov_to_mem = MOV_CYCLES[name]
+        got = (step(new_sim([format1(0x5, sreg, source_as, 6, 0)] + words)),
+               step(new_sim([format1(0x5, sreg, source_as, 6, 1)] + words + [0x0004])),
+               step(new_sim([format1(0x4, sreg, source_as, PC, 0)] + words)),
+               step(new_sim([format1(0x4, sreg, source_as, 6, 1)] + words + [0x0004])))
+        add_ok.append(got[:2] == (to_reg, to_mem))
+        mov_ok.append(got[2:] == (to_pc, mov_to_mem))
+        if got != (to_reg, to_mem, to_pc, mov_to_mem):
+            print('  %s: ADD Rm %d, ADD x(Rm) %d, MOV PC %d, MOV x(Rm) %d' % ((name,) + got))
+    check(all(add_ok), 'ADD from every source mode into a register and into memory')
+    check(all(mov_ok), 'MOV from every source mode into the PC, and into memory a cycle less')
+
+    # the constant generators are register cycles whatever As says
+    sim = new_sim([format1(0x4, 3, 1, 6, 0), format1(0x4, SR, 3, 7, 0), format1(0x4, 3, 3, 8, 0)])
+    cycles = (step(sim), step(sim), step(sim))
+    check(cycles == (1, 1, 1) and (sim.r[6], sim.r[7], sim.r[8]) == (1, 8, 0xFFFF),
+          'MOV #1, #8 and #-1 come from the constant generators in a cycle')
+
+    sim = new_sim([format1(0x5, 5, 3, 6, 0)])
+    step(sim)
+    check(sim.r[5] == RAM + 2 and sim.r[6] == RAM + 0x0300 + 0x9000, 'ADD @R5+ reads the word and steps R5 by 2')
+
+    sim = new_sim([format1(0x8, 5, 0, 6, 0)])
+    sim.r[5] = 1
+    sim.r[6] = 0
+    step(sim)
+    check(sim.r[6] == 0xFFFF and (sim.r[SR] & (C | Z | N)) == N, 'SUB 1 from 0 borrows: 0xFFFF, N set, C clear')
+
+
+def check_format2():
+    ok = True
+    for name, (reg, source_as, words) in sorted(SOURCES.items()):
+        rra, push, call = FORMAT2_CYCLES[name]
+        got = (step(new_sim([format2(2, reg, source_as)] + words)) if rra is not None else None,
+               step(new_sim([format2(4, reg, source_as)] + words)),
+               step(new_sim([format2(5, reg, source_as)] + words)))
+        if got != (rra, push, call):
+            print('  %s: RRA %s, PUSH %d, CALL %d' % ((name,) + got))
+            ok = False
+    check(ok, 'RRA, PUSH and CALL from every addressing mode')
+
+    sim = new_sim([format2(5, PC, 3), 0x9000])
+    step(sim)
+    check(sim.r[PC] == 0x9000 and sim.r[SP] == STACK - 2 and sim.load(STACK - 2, WORD) == CODE + 4,
+          'CALL #N pushes a 16 bit return address')
+
+    # a jump is two cycles taken or not
+    sim = new_sim([0x2001, 0x4303, 0x2401])
+    sim.r[SR] = 0
+    cycles = (step(sim), step(sim))
+    check(cycles == (2, 2) and sim.r[PC] == CODE + 6, 'JNE taken and JEQ not taken are two cycles each')
+
+
+def check_address():
+    cases = (
+        ('MOVA @R5,R6', [0x0506], 3),
+        ('MOVA @R5+,R6', [0x0516], 3),
+        ('MOVA &abs20,R6', [0x0126, 0x2345], 4),
+        ('MOVA z16(R5),R6', [0x0536, 0x0010], 4),
+        ('MOVA R5,&abs20', [0x0561, 0x2345], 4),
+        ('MOVA R5,z16(R6)', [0x0576, 0x0010], 4),
+        ('MOVA #imm20,R6', [0x0186, 0x2345], 2),
+        ('CMPA #imm20,R6', [0x0196, 0x2345], 3),
+        ('ADDA #imm20,R6', [0x01A6, 0x2345], 3),
+        ('SUBA #imm20,R6', [0x01B6, 0x2345], 3),
+        ('MOVA R5,R6', [0x05C6], 1),
+        ('CMPA R5,R6', [0x05D6], 1),
+        ('ADDA R5,R6', [0x05E6], 1),
+        ('SUBA R5,R6', [0x05F6], 1),
+        ('BRA #imm20', [0x0180, 0x2344], 3),
+        ('BRA R5', [0x05C0], 3),
+        ('PUSHM.A #3,R10', [0x142A], 8),
+        ('PUSHM.W #3,R10', [0x152A], 5),
+        ('RRAM.A #3,R6', [0x0946], 3),
+        ('RLAM.W #2,R6', [0x0656], 2),
+    )
+    ok = True
+    for name, words, cycles in cases:
+        got = step(new_sim(words))
+        if got != cycles:
+            print('  %s: %d cycles, %d in SLAU445' % (name, got, cycles))
+            ok = False
+    check(ok, 'the MSP430X address instructions, PUSHM and the multiple bit shifts')
+
+    sim = new_sim([0x0086, 0xFFFF, 0x00A6, 0x0001])
+    step(sim)
+    step(sim)
+    check(sim.r[6] == 0x10000, 'ADDA carries into bits 19:16: 0x0FFFF + 1 = 0x10000')
+
+    sim = new_sim([0x0A86, 0xBCDE, 0x0661, 0x2345, 0x0127, 0x2345])
+    step(sim)
+    step(sim)
+    step(sim)
+    check(sim.r[7] == 0xABCDE, 'MOVA keeps 20 bits through memory: #0xABCDE to &0x12345 and back')
+
+    # extension words
+    sim = new_sim([0x1800, format1(0x5, 5, 0, 6, 0, bw=1)])
+    sim.r[5] = 0x0F000
+    sim.r[6] = 0x01000
+    cycles = step(sim)
+    check(cycles == 2 and sim.r[6] == 0x10000, 'ADDX.A R5,R6 adds 20 bits in 2 cycles')
+
+    sim = new_sim([0x1800 | (0xA << 7), format1(0x4, PC, 3, 6, 0, bw=1), 0xBCDE])
+    cycles = step(sim)
+    check(cycles == 3 and sim.r[6] == 0xABCDE, 'MOVX.A #imm20,R6 is 3 cycles')
+
+    sim = new_sim([0x1843, format2(2, 5, 0)])
+    sim.r[5] = 0x8000
+    cycles = step(sim)
+    check(cycles == 5 and sim.r[5] == 0xF800, 'RPT #4 RRAX.W R5 shifts four times in n + 1 cycles')
+
+
+def check_calla_reta():
+    target = 0x12340
+    cases = (
+        ('CALLA R5', [0x1345], 5, None),
+        ('CALLA X(R5)', [0x1355, 0x0010], 5, RAM + 0x0010),
+        ('CALLA @R5', [0x1365], 5, RAM),
+        ('CALLA @R5+', [0x1375], 5, RAM),
+        ('CALLA &abs20', [0x1380, RAM + 0x0100], 7, RAM + 0x0100),
+        ('CALLA EDE', [0x1390 | (EDE_BACK >> 16), EDE_BACK & 0xFFFF], 7, RAM + 0x0100),
+        ('CALLA #imm20', [0x13B1, 0x2340], 5, None),
+    )
+    ok = True
+    for name, words, cycles, pointer in cases:
+        sim = new_sim(words, at=0x10000)
+        if pointer is None:
+            sim.r[5] = target
+        else:
+            sim.store(pointer, target, ADDR)
+        got = step(sim)
+        back = 0x10000 + 2 * len(words)
+        good = (got == cycles and sim.r[PC] == target and sim.r[SP] == STACK - 4 and
+                sim.load(STACK - 4, ADDR) == back)
+        if name == 'CALLA @R5+':
+            good = good and sim.r[5] == RAM + 4
+        if not good:
+            print('  %s: %d cycles (%d in SLAU445), PC 0x%05X, SP 0x%04X, return 0x%05X'
+                  % (name, got, cycles, sim.r[PC], sim.r[SP], sim.load(STACK - 4, ADDR)))
+            ok = False
+    check(ok, 'CALLA in every mode pushes the 20 bit return address and lands on a 20 bit target')
+
+    sim = new_sim([0x0110], at=target)
+    sim.r[SP] = STACK - 4
+    sim.store(STACK - 4, 0x1ABCE, ADDR)
+    cycles = step(sim)
+    check(cycles == 4 and sim.r[PC] == 0x1ABCE and sim.r[SP] == STACK, 'RETA pops the 20 bit address in 4 cycles')
+
+    sim = new_sim([0x142A, 0x1628])
+    sim.r[8], sim.r[9], sim.r[10] = 0xA1234, 0xB5678, 0xC9ABC
+    cycles = step(sim)
+    sim.r[8] = sim.r[9] = sim.r[10] = 0
+    cycles = (cycles, step(sim))
+    check(cycles == (8, 8) and (sim.r[8], sim.r[9], sim.r[10]) == (0xA1234, 0xB5678, 0xC9ABC) and sim.r[SP] == STACK,
+          'PUSHM.A #3,R10 and POPM.A #3,R8 move 20 bit registers in 2 + 2n cycles')
+
+
+def write_elf(path, base, code, functions):
+    """An ELF file with code loaded at base and a function symbol for each (name, address, size)."""
+    strtab = b'\0'
+    symtab = bytes(16)
+    for name, addr, size in functions:
+        symtab += struct.pack('<IIIBBH', len(strtab), addr, size, 0x12, 0, 1)
+        strtab += name.encode('ascii') + b'\0'
+    code_at = 52 + 32
+    symtab_at = code_at + len(code)
+    strtab_at = symtab_at + len(symtab)
+    sections_at = strtab_at + len(strtab)
+    header = b'\x7fELF\x01\x01\x01' + bytes(9) + struct.pack('<HHIIIIIHHHHHH', 2, msp430_sim.EM_MSP430, 1, base, 52,
+                                                             sections_at, 0, 52, 32, 1, 40, 3, 0)
+    segment = struct.pack('<IIIIIIII', 1, code_at, base, base, len(code), len(code), 5, 2)
+    sections = (bytes(40) +
+                struct.pack('<IIIIIIIIII', 0, 2, 0, 0, symtab_at, len(symtab), 2, 1, 4, 16) +
+                struct.pack('<IIIIIIIIII', 0, 3, 0, 0, strtab_at, len(strtab), 0, 0, 1, 0))
+    with open(path, 'wb') as f:
+        f.write(header + segment + code + symtab + strtab + sections)
+
+
+def check_frames():
+    # main calls outer, outer calls inner, then main calls done, which the hook stops on
+    main, outer, inner, done = 0x10000, 0x10010, 0x10020, 0x10030
+    words = {
+        main:  [0x13B1, 0x0010, 0x13B1, 0x0030],
+        outer: [0x4303, 0x13B1, 0x0020, 0x0110],
+        inner: [0x4303, 0x0110],
+        done:  [0x3FFF],
+    }
+    code = bytearray(0x40)
+    for addr, function in words.items():
+        for i, word in enumerate(function):
+            struct.pack_into('<H', code, addr - main + 2 * i, word)
+
+    with tempfile.TemporaryDirectory() as folder:
+        path = os.path.join(folder, 'frames.elf')
+        write_elf(path, main, bytes(code), [('main', main, 8), ('outer', outer, 8), ('inner', inner, 4),
+                                            ('done', done, 2)])
+        sim = msp430_sim.Msp430()
+        elf = sim.load_image(path)
+        sim.r[SP] = STACK
+
+        def stop(s):
+            s.halted = True
+
+        sim.add_hook(elf.symbols['done'], stop)
+        sim.run(max_cycles=1000)
+
+    # MOV R3,R3 1, CALLA #imm20 5, RETA 4
+    check(sim.calls.get('outer') == 1 and sim.calls.get('inner') == 1, 'one call each of outer and inner')
+    check(sim.inclusive.get('inner') == 1 + 4 and sim.self_cycles.get('inner') == 1 + 4,
+          'inner: its MOV and RETA, 5 cycles')
+    check(sim.inclusive.get('outer') == 1 + 5 + 5 + 4 and sim.self_cycles.get('outer') == 1 + 5 + 4,
+          'outer: 15 cycles with inner, 10 of its own')
+    check(sim.self_cycles.get('main') == 5 + 5, 'main: its two CALLAs, the callees are not its own')
+
+
+def check_mpy32():
+    sim = msp430_sim.Msp430()
+
+    def read(addr):
+        return sim.load(addr, WORD)
+
+    def result64():
+        return sum(read(RES0 + 2 * i) << (16 * i) for i in range(4))
+
+    sim.write(MPY, 0xFFFF, WORD)
+    sim.write(OP2, 0xFFFF, WORD)
+    check((read(RESHI) << 16 | read(RESLO)) == 0xFFFE0001 and read(SUMEXT) == 0, 'MPY 0xFFFF * 0xFFFF')
+
+    sim.write(MPYS, 0xFFFE, WORD)
+    sim.write(OP2, 3, WORD)
+    check((read(RESHI), read(RESLO), read(SUMEXT)) == (0xFFFF, 0xFFFA, 0xFFFF), 'MPYS -2 * 3 = -6, SUMEXT 0xFFFF')
+
+    sim.write(MACS, 4, WORD)
+    sim.write(OP2, 5, WORD)
+    check((read(RESHI), read(RESLO), read(SUMEXT)) == (0, 14, 0), 'MACS adds 4 * 5 to the -6: 14')
+
+    sim.write(MPY, 0x8000, WORD)
+    sim.write(OP2, 0x8000, WORD)
+    sim.write(MAC, 0x8000, WORD)
+    sim.write(OP2, 0x8000, WORD)
+    check((read(RESHI), read(RESLO), read(SUMEXT)) == (0x8000, 0, 0), 'MAC 0x8000 * 0x8000 twice: 0x80000000')
+    sim.write(MAC, 0xFFFF, WORD)
+    sim.write(OP2, 0xFFFF, WORD)
+    check(read(SUMEXT) == 1, 'MAC past 32 bits sets SUMEXT to the carry')
+
+    sim.write(MPYS, 0xFE, BYTE)
+    sim.write(OP2, 0x03, BYTE)
+    check((read(RESHI), read(RESLO)) == (0xFFFF, 0xFFFA), 'MPYS.B sign extends the byte operand: -2 * 3')
+
+    sim.write(MPY32L, 0x5678, WORD)
+    sim.write(MPY32H, 0x1234, WORD)
+    sim.write(OP2L, 0xDEF0, WORD)
+    sim.write(OP2H, 0x9ABC, WORD)
+    check(result64() == 0x12345678 * 0x9ABCDEF0, 'MPY32 0x12345678 * 0x9ABCDEF0 into RES0 - RES3')
+
+    sim.write(MPYS32L, 0xFFFF, WORD)
+    sim.write(MPYS32H, 0xFFFF, WORD)
+    sim.write(OP2L, 0xFFFF, WORD)
+    sim.write(OP2H, 0x7FFF, WORD)
+    check(result64() == (-0x7FFFFFFF) & 0xFFFFFFFFFFFFFFFF, 'MPYS32 -1 * 0x7FFFFFFF')
+
+    sim.write(MPY, 0x0002, WORD)
+    sim.write(OP2L, 0x0000, WORD)
+    sim.write(OP2H, 0x8000, WORD)
+    check(result64() == 0x100000000, 'MPY of 16 bits by a 32 bit OP2 gives 64 bits')
+
+    # Q15 0.5 * 0.5 is 0.25, read shifted up by one in the fractional mode
+    sim.write(MPY32CTL0, 0x0004, WORD)
+    sim.write(MPYS, 0x4000, WORD)
+    sim.write(OP2, 0x4000, WORD)
+    check(read(RESHI) == 0x2000, 'MPYS in the fractional mode: Q15 0.5 * 0.5 = 0.25')
+    sim.write(MACS, 0x4000, WORD)
+    sim.write(OP2, 0x4000, WORD)
+    check(read(RESHI) == 0x4000, 'MACS in the fractional mode accumulates before the shift: 0.5')
+    sim.write(MPY32CTL0, 0, WORD)
+
+    # through instructions, as the compiler's helpers use it: MOV #0x1234,&MPY, MOV #0x100,&OP2, MOV &RESHI,R12
+    code = [format1(0x4, PC, 3, SR, 1), 0x1234, MPY, format1(0x4, PC, 3, SR, 1), 0x0100, OP2,
+            format1(0x4, SR, 1, 12, 0), RESHI, format1(0x4, SR, 1, 13, 0), RESLO]
+    sim = new_sim(code)
+    cycles = sum(step(sim) for _ in range(4))
+    check((sim.r[12], sim.r[13]) == (0x0012, 0x3400) and cycles == 4 + 4 + 3 + 3,
+          'MOV to &MPY and &OP2 multiplies, the result reads back from &RESHI and &RESLO')
+
+
+def main():
+    check_format1()
+    check_format2()
+    check_address()
+    check_calla_reta()
+    check_frames()
+    check_mpy32()
+
+    print('PASS' if passed else 'FAIL')
+    return 0 if passed else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,854 @@
+/**************************************************************************************************
+* \file     test_owi.c
+* \brief    DS2740 1-wire engine and battery median against reference traces
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <msp430.h>
+#include "driverlib.h"
+#include "HW_BAT.h"
+#include "HW_OWI.h"
+#include "uC_ADC.h"
+
+// Runs HW_OWI.c and HW_BAT.c against a DS2740 model on a simulated P2.2 with MCLK counted in cycles.
+// Timer_A0 counts MCLK/16, the CCR0 interrupt is taken up to a random latency late, the inline delays
+// advance the clock and count as busy time. Every edge the master drives is checked against the DS2740
+// limits (reset low, write 0/1 low, read low and sample point, recovery, slot period, driving high while
+// the gauge pulls low) and turned into a slot string: P reset, 0/1 written bits, l/h bits read.
+//
+// traces/owi_ds2740.trace was recorded with --record from the bit-bang driver this engine replaced
+// (HW_BAT.c before the change, built against this model). The boot init chain and two status register
+// write/reads have to put exactly the same slots on the wire at every latency, with less busy time.
+//
+// traces/bat_adc.csv holds the ADC counts of one voltage measurement per line. The median of each has to
+// match the bubble sort and median HW_BAT.c used before, bit for bit.
+//
+// Usage: test_owi                 run the checks
+//        test_owi --record        print the trace of the linked driver in the owi_ds2740.trace format
+
+#define TRACE_PATH                  "traces/owi_ds2740.trace"
+#define ADC_PATH                    "traces/bat_adc.csv"
+
+#define CYCLES_PER_US               16u
+#define TIMER_DIVIDER               16u
+#define US(cycles)                  ((double)(cycles) / CYCLES_PER_US)
+
+// DS2740 timing (us)
+#define RESET_LOW_MIN_US            480.0
+#define RESET_LOW_MAX_US            960.0
+#define PRESENCE_DELAY_MIN_US       15u
+#define PRESENCE_DELAY_RANGE_US     46u
+#define PRESENCE_LOW_MIN_US         60u
+#define PRESENCE_LOW_RANGE_US       181u
+#define SLAVE_READ_ZERO_US          30u
+#define SLOT_MIN_US                 60.0
+#define RECOVERY_MIN_US             1.0
+#define WRITE_ONE_LOW_MAX_US        15.0
+#define WRITE_ZERO_LOW_MIN_US       60.0
+#define WRITE_ZERO_LOW_MAX_US       120.0
+#define READ_SAMPLE_MAX_US          15.0
+#define COMPARE_MAX_AHEAD_US        2000u
+
+#define MAX_TXNS                    8u
+#define MAX_SLOTS                   128u
+#define MAX_NAME                    32u
+#define MAX_VIOLATIONS_SHOWN        10u
+#define RANDOM_ROUNDS               500u
+#define SAMPLES_PER_MEASUREMENT     21u
+#define CRITICAL_VOLTAGE_MV         2700u
+
+// DS2740 commands, as in HW_BAT.c
+#define READ_ROM                    0x33u
+#define SKIP_NET_ADDR_CMD           0xCCu
+#define READ_DATA_CMD               0x69u
+#define WRITE_DATA_CMD              0x6Cu
+#define STATUS_REG_ADDR             0x01u
+#define STATUS_REG_SMOD             0x40u
+
+typedef enum
+{
+    SLAVE_IDLE,
+    SLAVE_ROM_CMD,
+    SLAVE_FUNC_CMD,
+    SLAVE_ADDR,
+    SLAVE_TX,
+    SLAVE_RX_DATA,
+}slaveState_t;
+
+typedef struct
+{
+    bool present;
+    uint8_t rom[8];
+    uint8_t regs[256];
+    slaveState_t state;
+    uint8_t func;
+    uint8_t addr;
+    uint8_t shift;
+    uint8_t bits;
+    const uint8_t * p_tx;
+    uint16_t txIdx;
+    uint64_t presenceStart;
+    uint64_t presenceEnd;
+    uint64_t lowUntil;
+}slave_t;
+
+// One transaction on the wire, from the falling edge of its reset
+typedef struct
+{
+    char name[MAX_NAME];
+    char slots[MAX_SLOTS];
+    uint16_t numSlots;
+    uint64_t start;
+    uint64_t end;
+    uint64_t busyStart;
+    double wireUs;
+    double busyUs;
+}owiTxn_t;
+
+typedef struct
+{
+    owiTxn_t txns[MAX_TXNS];
+    uint8_t numTxns;
+}owiTrace_t;
+
+static const char * const xTxnNames[] = { "rom", "smod_write", "smod_read", "write_5a", "read_5a", "write_a5", "read_a5" };
+
+void TIMER0_A0_ISR(void);
+
+static uint64_t xCycles = 1000u;
+static uint64_t xTimerBase = 0u;
+static bool xTimerRunning = false;
+static uint64_t xBusyCycles = 0u;
+static uint64_t xLastIsr = 0u;
+static uint32_t xIsrs = 0u;
+static uint32_t xLatencyUs = 0u;
+static slave_t xSlave;
+static bool xMasterWasLow = false;
+static uint64_t xFall = 0u;
+static uint64_t xRise = 0u;
+static uint64_t xBusyAtFall = 0u;
+static bool xSlotSinceReset = false;
+static owiTrace_t xTrace;
+static uint32_t xViolations = 0u;
+static char xTermLog[512];
+static const uint16_t * xAdcSamples = NULL;
+static uint8_t xAdcIdx = 0u;
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static void xViolation(const char * p_what, double value);
+static bool xMasterLow(void);
+static bool xMasterHigh(void);
+static bool xSlaveLow(uint64_t now);
+static void xLineUpdate(void);
+static void xSlot(double lowUs);
+static void xSlaveByte(uint8_t byte);
+static void xResetModel(bool present);
+static void xRunCompare(void);
+static void xRunBackground(void);
+static bool xRunScenario(uint32_t latencyUs);
+static void xFinishTrace(void);
+static bool xLoadTrace(const char * p_path, owiTrace_t * p_trace);
+static bool xSameSlots(const owiTrace_t * p_a, const owiTrace_t * p_b);
+static double xTotalBusyUs(const owiTrace_t * p_trace);
+static uint16_t xOldMedian(const uint16_t * p_adc);
+static uint32_t xCheckMedians(const char * p_path, uint32_t * p_mismatches);
+
+int main(int argc, char * argv[])
+{
+    static const uint32_t latencies[] = {0u, 5u, 20u, 40u};
+    owiTrace_t reference;
+    uint32_t mismatches = 0u;
+    uint32_t measurements = 0u;
+    bool ok = true;
+
+    srand(36);
+    HW_OWI_Init();
+
+    if ( (argc > 1) && (strcmp(argv[1], "--record") == 0) )
+    {
+        xRunScenario(0u);
+        printf("# DS2740 transactions, recorded by test_owi --record at 0 us interrupt latency\n");
+        printf("# name wire_us busy_us slots (P reset, 0/1 written, l/h read)\n");
+        for ( uint8_t i = 0u; i < xTrace.numTxns; i++ )
+        {
+            printf("%s %.1f %.1f %s\n", xTrace.txns[i].name, xTrace.txns[i].wireUs, xTrace.txns[i].busyUs, xTrace.txns[i].slots);
+        }
+        return (xViolations == 0u) ? 0 : 1;
+    }
+
+    if ( xLoadTrace(TRACE_PATH, &reference) == false )
+    {
+        printf("  FAIL: can't read %s\n", TRACE_PATH);
+        return 1;
+    }
+
+    printf("  1-wire, against the bit-bang trace:\n");
+    for ( uint8_t i = 0u; i < (sizeof(latencies) / sizeof(latencies[0])); i++ )
+    {
+        ok = xRunScenario(latencies[i]);
+        printf("    latency <= %2u us: %u transactions, %5.0f us busy (bit-bang %5.0f us), %u ISRs, %u timing violations\n",
+               (unsigned)latencies[i], (unsigned)xTrace.numTxns, xTotalBusyUs(&xTrace), xTotalBusyUs(&reference),
+               (unsigned)xIsrs, (unsigned)xViolations);
+        xCheck(ok && xSameSlots(&xTrace, &reference) && (xViolations == 0u),
+               "the same slots as the bit-bang driver, within the DS2740 limits");
+
+        if ( latencies[i] == 0u )
+        {
+            for ( uint8_t t = 0u; t < xTrace.numTxns; t++ )
+            {
+                printf("      %-10s wire %6.0f us (bit-bang %6.0f), busy %5.0f us (bit-bang %5.0f)\n", xTrace.txns[t].name,
+                       xTrace.txns[t].wireUs, reference.txns[t].wireUs, xTrace.txns[t].busyUs, reference.txns[t].busyUs);
+                ok &= (xTrace.txns[t].busyUs < (reference.txns[t].busyUs / 4.0));
+            }
+            xCheck(ok, "every transaction is busy for under a quarter of the bit-bang time");
+        }
+    }
+
+    xLatencyUs = 20u;
+    xResetModel(true);
+    ok = true;
+    for ( uint32_t n = 0u; n < RANDOM_ROUNDS; n++ )
+    {
+        uint8_t value = (uint8_t)rand();
+        uint8_t readBack = (uint8_t)~value;
+
+        ok &= (HW_FUEL_GAUGE_WriteStatusReg(value) == GAUGE_SUCCESS);
+        ok &= (HW_FUEL_GAUGE_ReadStatusReg(&readBack) == GAUGE_SUCCESS);
+        ok &= (readBack == value) && (xSlave.regs[STATUS_REG_ADDR] == value);
+    }
+    xCheck(ok && (xViolations == 0u), "500 random status writes read back at up to 20 us latency");
+
+    xResetModel(false);
+    {
+        uint8_t value = 0u;
+        xCheck(HW_FUEL_GAUGE_ReadStatusReg(&value) == GAUGE_OWI_ERROR, "a read with no gauge on the line fails");
+    }
+    xCheck(HW_FUEL_GAUGE_Initialize() == GAUGE_SUCCESS, "the background init starts with no gauge");
+    xRunBackground();
+    xCheck(strstr(xTermLog, "not detected") != NULL, "the missing gauge is reported");
+    xCheck((HW_OWI_IsBusy() == false) && (xViolations == 0u), "the engine is idle again");
+
+    printf("  battery median:\n");
+    measurements = xCheckMedians(ADC_PATH, &mismatches);
+    printf("    %u measurements from %s, %u differ from the sort\n", (unsigned)measurements, ADC_PATH, (unsigned)mismatches);
+    xCheck((measurements > 0u) && (mismatches == 0u), "the insertion median matches the bubble sort bit for bit");
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+static void xViolation(const char * p_what, double value)
+{
+    if ( xViolations < MAX_VIOLATIONS_SHOWN )
+    {
+        printf("    violation at %.1f us: %s %.1f\n", US(xCycles), p_what, value);
+    }
+    xViolations++;
+}
+
+static bool xMasterLow(void)
+{
+    return ((P2DIR & BIT2) != 0u) && ((P2OUT & BIT2) == 0u);
+}
+
+static bool xMasterHigh(void)
+{
+    return ((P2DIR & BIT2) != 0u) && ((P2OUT & BIT2) != 0u);
+}
+
+static bool xSlaveLow(uint64_t now)
+{
+    return xSlave.present &&
+           (((now >= xSlave.presenceStart) && (now < xSlave.presenceEnd)) || (now < xSlave.lowUntil));
+}
+
+// Called whenever the firmware can have changed the line: it reads the counter or the pin, delays, or an
+// ISR or driverlib call returns. Nothing moves the clock in between, so an edge is seen at its time.
+static void xLineUpdate(void)
+{
+    bool low = xMasterLow();
+    uint64_t now = xCycles;
+    double lowUs = 0.0;
+
+    if ( xMasterHigh() && xSlaveLow(now) )
+    {
+        xViolation("master drives high while the gauge pulls low", 0.0);
+    }
+
+    if ( low == xMasterWasLow )
+    {
+        return;
+    }
+    xMasterWasLow = low;
+
+    if ( low == true )
+    {
+        if ( (xSlotSinceReset == true) && (US(now - xRise) < RECOVERY_MIN_US) )
+        {
+            xViolation("recovery (us)", US(now - xRise));
+        }
+        if ( (xSlotSinceReset == true) && (US(now - xFall) < SLOT_MIN_US) )
+        {
+            xViolation("slot period (us)", US(now - xFall));
+        }
+
+        xFall = now;
+        xBusyAtFall = xBusyCycles;
+
+        //the gauge holds the line for a 0 from the falling edge of a read slot
+        if ( xSlave.present && (xSlave.state == SLAVE_TX) && (((xSlave.p_tx[xSlave.txIdx] >> xSlave.bits) & 1u) == 0u) )
+        {
+            xSlave.lowUntil = now + ((uint64_t)SLAVE_READ_ZERO_US * CYCLES_PER_US);
+        }
+        return;
+    }
+
+    xRise = now;
+    lowUs = US(now - xFall);
+
+    if ( lowUs >= RESET_LOW_MIN_US )
+    {
+        if ( lowUs > RESET_LOW_MAX_US )
+        {
+            xViolation("reset low (us)", lowUs);
+        }
+
+        if ( xTrace.numTxns < MAX_TXNS )
+        {
+            owiTxn_t * p_txn = &xTrace.txns[xTrace.numTxns++];
+
+            memset(p_txn, 0, sizeof(*p_txn));
+            snprintf(p_txn->name, sizeof(p_txn->name), "%s",
+                     (xTrace.numTxns <= (sizeof(xTxnNames) / sizeof(xTxnNames[0]))) ? xTxnNames[xTrace.numTxns - 1u] : "extra");
+            p_txn->slots[p_txn->numSlots++] = 'P';
+            p_txn->start = xFall;
+            p_txn->busyStart = xBusyAtFall;
+            p_txn->end = now;
+        }
+
+        xSlotSinceReset = false;
+        if ( xSlave.present )
+        {
+            uint32_t delayUs = PRESENCE_DELAY_MIN_US + ((uint32_t)rand() % PRESENCE_DELAY_RANGE_US);
+            uint32_t widthUs = PRESENCE_LOW_MIN_US + ((uint32_t)rand() % PRESENCE_LOW_RANGE_US);
+
+            xSlave.presenceStart = now + ((uint64_t)delayUs * CYCLES_PER_US);
+            xSlave.presenceEnd = xSlave.presenceStart + ((uint64_t)widthUs * CYCLES_PER_US);
+            xSlave.state = SLAVE_ROM_CMD;
+            xSlave.bits = 0u;
+            xSlave.shift = 0u;
+        }
+        return;
+    }
+
+    if ( (xSlotSinceReset == false) && xSlave.present && (xFall < xSlave.presenceEnd) )
+    {
+        xViolation("first slot during the presence pulse, us early", US(xSlave.presenceEnd - xFall));
+    }
+    xSlotSinceReset = true;
+
+    xSlot(lowUs);
+}
+
+// A bit slot ended with the rising edge, lowUs after it started
+static void xSlot(double lowUs)
+{
+    owiTxn_t * p_txn = (xTrace.numTxns != 0u) ? &xTrace.txns[xTrace.numTxns - 1u] : NULL;
+    char symbol = '?';
+
+    if ( xSlave.present && (xSlave.state == SLAVE_TX) )
+    {
+        symbol = (((xSlave.p_tx[xSlave.txIdx] >> xSlave.bits) & 1u) != 0u) ? 'h' : 'l';
+        if ( (lowUs < RECOVERY_MIN_US) || (lowUs > READ_SAMPLE_MAX_US) )
+        {
+            xViolation("read low (us)", lowUs);
+        }
+
+        xSlave.bits++;
+        if ( xSlave.bits == 8u )
+        {
+            xSlave.bits = 0u;
+            xSlave.txIdx++;
+        }
+    }
+    else
+    {
+        bool bit = (lowUs <= WRITE_ONE_LOW_MAX_US);
+
+        symbol = (bit == true) ? '1' : '0';
+        if ( (bit == true) && (lowUs < RECOVERY_MIN_US) )
+        {
+            xViolation("write 1 low (us)", lowUs);
+        }
+        else if ( (bit == false) && ((lowUs < WRITE_ZERO_LOW_MIN_US) || (lowUs > WRITE_ZERO_LOW_MAX_US)) )
+        {
+            xViolation("write 0 low (us)", lowUs);
+        }
+
+        if ( xSlave.present )
+        {
+            xSlave.shift |= (uint8_t)((bit ? 1u : 0u) << xSlave.bits);
+            xSlave.bits++;
+            if ( xSlave.bits == 8u )
+            {
+                uint8_t byte = xSlave.shift;
+
+                xSlave.bits = 0u;
+                xSlave.shift = 0u;
+                xSlaveByte(byte);
+            }
+        }
+    }
+
+    if ( (p_txn != NULL) && (p_txn->numSlots < (MAX_SLOTS - 1u)) )
+    {
+        p_txn->slots[p_txn->numSlots++] = symbol;
+        p_txn->end = xRise;
+    }
+}
+
+// The DS2740 net address and function commands the driver uses
+static void xSlaveByte(uint8_t byte)
+{
+    switch ( xSlave.state )
+    {
+        case SLAVE_ROM_CMD:
+        {
+            if ( byte == READ_ROM )
+            {
+                xSlave.state = SLAVE_TX;
+                xSlave.p_tx = xSlave.rom;
+                xSlave.txIdx = 0u;
+            }
+            else
+            {
+                xSlave.state = (byte == SKIP_NET_ADDR_CMD) ? SLAVE_FUNC_CMD : SLAVE_IDLE;
+            }
+            break;
+        }
+        case SLAVE_FUNC_CMD:
+        {
+            xSlave.func = byte;
+            xSlave.state = SLAVE_ADDR;
+            break;
+        }
+        case SLAVE_ADDR:
+        {
+            xSlave.addr = byte;
+            if ( xSlave.func == READ_DATA_CMD )
+            {
+                xSlave.state = SLAVE_TX;
+                xSlave.p_tx = xSlave.regs;
+                xSlave.txIdx = byte;
+            }
+            else
+            {
+                xSlave.state = (xSlave.func == WRITE_DATA_CMD) ? SLAVE_RX_DATA : SLAVE_IDLE;
+            }
+            break;
+        }
+        case SLAVE_RX_DATA:
+        {
+            xSlave.regs[xSlave.addr++] = byte;
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+static void xResetModel(bool present)
+{
+    static const uint8_t rom[8] = {0x36u, 0x11u, 0x22u, 0x33u, 0x44u, 0x55u, 0x66u, 0xA7u};
+
+    memset(&xSlave, 0, sizeof(xSlave));
+    memcpy(xSlave.rom, rom, sizeof(rom));
+    xSlave.present = present;
+    memset(&xTrace, 0, sizeof(xTrace));
+    xTermLog[0] = '\0';
+    xViolations = 0u;
+    xIsrs = 0u;
+    xSlotSinceReset = false;
+}
+
+// Sleep until the armed compare, take the interrupt up to xLatencyUs late
+static void xRunCompare(void)
+{
+    uint16_t ahead = 0u;
+    uint64_t tick = 0u;
+
+    if ( ((TA0CCTL0 & CCIE) == 0u) || (xTimerRunning == false) )
+    {
+        xViolation("asleep with no compare armed", 0.0);
+        return;
+    }
+
+    ahead = (uint16_t)(TA0CCR0 - HOST_ReadTA0R());
+    if ( ahead > COMPARE_MAX_AHEAD_US )
+    {
+        xViolation("compare armed far ahead or missed (us)", ahead);
+    }
+
+    tick = xCycles - ((xCycles - xTimerBase) % TIMER_DIVIDER);
+    xCycles = tick + ((uint64_t)ahead * TIMER_DIVIDER);
+    if ( xLatencyUs != 0u )
+    {
+        xCycles += (uint64_t)rand() % ((uint64_t)xLatencyUs * CYCLES_PER_US + 1u);
+    }
+
+    //P2IFG latches the falling edge of the presence pulse while P2IES selects it
+    if ( ((P2IES & BIT2) != 0u) && xSlave.present && (xSlave.presenceStart > xLastIsr) && (xSlave.presenceStart <= xCycles) )
+    {
+        P2IFG |= BIT2;
+    }
+
+    xLastIsr = xCycles;
+    TIMER0_A0_ISR();
+    xIsrs++;
+    xLineUpdate();
+
+    //the rest of the main loop, nothing here is timing critical
+    if ( (rand() % 2) == 0 )
+    {
+        xCycles += 3u * CYCLES_PER_US;
+    }
+}
+
+// The main loop while a background transaction (and the ones its callback starts) runs
+static void xRunBackground(void)
+{
+    for ( uint32_t guard = 0u; guard < 100000u; guard++ )
+    {
+        if ( HW_OWI_IsBusy() == true )
+        {
+            xRunCompare();
+        }
+        else
+        {
+            HW_OWI_Monitor();
+            if ( HW_OWI_IsBusy() == false )
+            {
+                return;
+            }
+        }
+    }
+
+    xViolation("the background transaction never finished", 0.0);
+}
+
+// Boot init chain and two status write/reads, the same calls the bit-bang driver was recorded with
+static bool xRunScenario(uint32_t latencyUs)
+{
+    static const uint8_t values[] = {0x5Au, 0xA5u};
+    uint8_t readBack = 0u;
+    bool ok = true;
+
+    xLatencyUs = latencyUs;
+    xResetModel(true);
+
+    ok &= (HW_FUEL_GAUGE_Initialize() == GAUGE_SUCCESS);
+    xRunBackground();
+    ok &= (xSlave.regs[STATUS_REG_ADDR] == STATUS_REG_SMOD) && (strstr(xTermLog, "Sleep Mode Enabled") != NULL);
+
+    for ( uint8_t i = 0u; i < sizeof(values); i++ )
+    {
+        ok &= (HW_FUEL_GAUGE_WriteStatusReg(values[i]) == GAUGE_SUCCESS);
+        ok &= (HW_FUEL_GAUGE_ReadStatusReg(&readBack) == GAUGE_SUCCESS) && (readBack == values[i]);
+    }
+
+    xFinishTrace();
+
+    return ok;
+}
+
+static void xFinishTrace(void)
+{
+    for ( uint8_t i = 0u; i < xTrace.numTxns; i++ )
+    {
+        owiTxn_t * p_txn = &xTrace.txns[i];
+        uint64_t busyEnd = ((i + 1u) < xTrace.numTxns) ? xTrace.txns[i + 1u].busyStart : xBusyCycles;
+
+        p_txn->slots[p_txn->numSlots] = '\0';
+        p_txn->wireUs = US(p_txn->end - p_txn->start);
+        p_txn->busyUs = US(busyEnd - p_txn->busyStart);
+    }
+}
+
+static bool xLoadTrace(const char * p_path, owiTrace_t * p_trace)
+{
+    FILE * p_file = fopen(p_path, "r");
+    char line[MAX_SLOTS + 64u];
+
+    memset(p_trace, 0, sizeof(*p_trace));
+    if ( p_file == NULL )
+    {
+        return false;
+    }
+
+    while ( (fgets(line, sizeof(line), p_file) != NULL) && (p_trace->numTxns < MAX_TXNS) )
+    {
+        owiTxn_t * p_txn = &p_trace->txns[p_trace->numTxns];
+
+        if ( (line[0] == '#') || (line[0] == '\n') )
+        {
+            continue;
+        }
+
+        if ( sscanf(line, "%31s %lf %lf %127s", p_txn->name, &p_txn->wireUs, &p_txn->busyUs, p_txn->slots) == 4 )
+        {
+            p_txn->numSlots = (uint16_t)strlen(p_txn->slots);
+            p_trace->numTxns++;
+        }
+    }
+
+    fclose(p_file);
+
+    return (p_trace->numTxns != 0u);
+}
+
+static bool xSameSlots(const owiTrace_t * p_a, const owiTrace_t * p_b)
+{
+    bool same = (p_a->numTxns == p_b->numTxns);
+
+    for ( uint8_t i = 0u; (same == true) && (i < p_a->numTxns); i++ )
+    {
+        same = (strcmp(p_a->txns[i].name, p_b->txns[i].name) == 0) && (strcmp(p_a->txns[i].slots, p_b->txns[i].slots) == 0);
+        if ( same == false )
+        {
+            printf("    %s differs:\n      %s\n      %s\n", p_a->txns[i].name, p_a->txns[i].slots, p_b->txns[i].slots);
+        }
+    }
+
+    return same;
+}
+
+static double xTotalBusyUs(const owiTrace_t * p_trace)
+{
+    double busyUs = 0.0;
+
+    for ( uint8_t i = 0u; i < p_trace->numTxns; i++ )
+    {
+        busyUs += p_trace->txns[i].busyUs;
+    }
+
+    return busyUs;
+}
+
+// HW_BAT_TakeNewVoltageMeasurement() before the change: divider math, bubble sort, middle sample
+static uint16_t xOldMedian(const uint16_t * p_adc)
+{
+    uint16_t mv[SAMPLES_PER_MEASUREMENT];
+
+    for ( uint8_t i = 0u; i < SAMPLES_PER_MEASUREMENT; i++ )
+    {
+        mv[i] = (uint16_t)((p_adc[i] * 9u) / 5u);
+    }
+
+    for ( uint8_t i = 0u; i < SAMPLES_PER_MEASUREMENT; i++ )
+    {
+        for ( uint8_t j = 0u; j < (SAMPLES_PER_MEASUREMENT - 1u); j++ )
+        {
+            if ( mv[j] > mv[j + 1u] )
+            {
+                uint16_t temp = mv[j];
+                mv[j] = mv[j + 1u];
+                mv[j + 1u] = temp;
+            }
+        }
+    }
+
+    return mv[SAMPLES_PER_MEASUREMENT / 2u];
+}
+
+// Each line of the file is one measurement. Returns how many were run, fills in how many differ.
+static uint32_t xCheckMedians(const char * p_path, uint32_t * p_mismatches)
+{
+    FILE * p_file = fopen(p_path, "r");
+    char line[256];
+    uint32_t measurements = 0u;
+    bool low = false;
+
+    *p_mismatches = 0u;
+    if ( p_file == NULL )
+    {
+        return 0u;
+    }
+
+    while ( fgets(line, sizeof(line), p_file) != NULL )
+    {
+        uint16_t adc[SAMPLES_PER_MEASUREMENT];
+        uint16_t expected = 0u;
+        char * p_field = line;
+        uint8_t count = 0u;
+
+        if ( line[0] == '#' )
+        {
+            continue;
+        }
+
+        while ( (count < SAMPLES_PER_MEASUREMENT) && (*p_field != '\0') )
+        {
+            char * p_end = NULL;
+            unsigned long value = strtoul(p_field, &p_end, 10);
+
+            if ( p_end == p_field )
+            {
+                break;
+            }
+            adc[count++] = (uint16_t)value;
+            p_field = (*p_end == ',') ? (p_end + 1) : p_end;
+        }
+
+        if ( count != SAMPLES_PER_MEASUREMENT )
+        {
+            continue;
+        }
+
+        xAdcSamples = adc;
+        xAdcIdx = 0u;
+        HW_BAT_TakeNewVoltageMeasurement();
+
+        expected = xOldMedian(adc);
+        low |= (expected <= CRITICAL_VOLTAGE_MV);
+        if ( (HW_BAT_GetVoltage() != expected) || (xAdcIdx != SAMPLES_PER_MEASUREMENT) || (HW_BAT_IsBatteryLow() != low) )
+        {
+            if ( *p_mismatches < MAX_VIOLATIONS_SHOWN )
+            {
+                printf("    line %u: %u mV, the sort gives %u mV\n", (unsigned)(measurements + 1u), HW_BAT_GetVoltage(), expected);
+            }
+            (*p_mismatches)++;
+        }
+        measurements++;
+    }
+
+    fclose(p_file);
+
+    return measurements;
+}
+
+// The clock, the line and the ADC
+uint8_t HOST_ReadP2In(void)
+{
+    bool high = false;
+
+    xLineUpdate();
+    high = !(xMasterLow() || xSlaveLow(xCycles));
+
+    if ( ((P2DIR & BIT2) == 0u) && ((P2REN & BIT2) == 0u) && (high == true) )
+    {
+        xViolation("released without the pull-up", 0.0);
+    }
+    if ( xSlotSinceReset && (xSlave.state == SLAVE_TX) && xMasterWasLow == false && (US(xCycles - xFall) > READ_SAMPLE_MAX_US) )
+    {
+        xViolation("read sampled late (us)", US(xCycles - xFall));
+    }
+
+    return (high == true) ? BIT2 : 0u;
+}
+
+uint16_t HOST_ReadTA0R(void)
+{
+    xLineUpdate();
+    return (uint16_t)((xCycles - xTimerBase) / TIMER_DIVIDER);
+}
+
+void HOST_DelayCycles(uint32_t cycles)
+{
+    xLineUpdate();
+    xCycles += cycles;
+    xBusyCycles += cycles;
+}
+
+void HOST_Sleep(uint16_t bits)
+{
+    xRunCompare();
+}
+
+void Timer_A_clear(uint16_t baseAddress)
+{
+    xTimerBase = xCycles;
+}
+
+void Timer_A_startCounter(uint16_t baseAddress, uint16_t timerMode)
+{
+    xTimerRunning = true;
+}
+
+void Timer_A_stop(uint16_t baseAddress)
+{
+    xTimerRunning = false;
+}
+
+void GPIO_setAsOutputPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+    if ( selectedPort == GPIO_PORT_P2 )
+    {
+        P2DIR |= (uint8_t)selectedPins;
+        xLineUpdate();
+    }
+}
+
+void GPIO_setOutputHighOnPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+    if ( selectedPort == GPIO_PORT_P2 )
+    {
+        P2OUT |= (uint8_t)selectedPins;
+        xLineUpdate();
+    }
+}
+
+void GPIO_setOutputLowOnPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+    if ( selectedPort == GPIO_PORT_P2 )
+    {
+        P2OUT &= (uint8_t)~selectedPins;
+        xLineUpdate();
+    }
+}
+
+uint16_t uC_ADC_newConversionCh0(void)
+{
+    return xAdcSamples[xAdcIdx++];
+}
+
+void HW_TERM_Print(uint8_t * p_str)
+{
+    strncat(xTermLog, (const char *)p_str, sizeof(xTermLog) - strlen(xTermLog) - 1u);
+}
@@ -0,0 +1,406 @@
+/**************************************************************************************************
+* \file     test_padf.c
+* \brief    Host test of APP_PADF against the generated pad filters and calculateWaterVolume() it changed
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "host_ssm.h"
+
+// calculateWaterVolume.c as MATLAB Coder made it, before the add_to_buffer() hand edit. test.sh copies
+// ref/calculateWaterVolume.c next to the generated headers in out/tree.
+#define calculateWaterVolume xGenCalculateWaterVolume
+#include "algo-c-code/calculateWaterVolume/calculateWaterVolume_gen.c"
+#undef calculateWaterVolume
+
+#include "algo-c-code/waterPadFiltering/waterPadFiltering.h"
+#include "APP_ALGO.h"
+#include "APP_PADF.h"
+#include "uC_TIME.h"
+
+// Checks that APP_PADF and the hand edited calculateWaterVolume() give the same outputs, bit for bit,
+// as the generated code they replaced:
+//
+// - filters: every sample goes through the generated waterPadFiltering() and add_to_buffer() and
+//   through APP_PADF_Smooth() (in place, as APP_ALGO calls it) and APP_PADF_Delta(), each with its own
+//   state. Inputs are random in five modes (full range, slow drift, rails, steps, ties around zero)
+//   with the state reset every few thousand samples, then the pads of traces/capture_stream.csv.
+// - calculateWaterVolume: synthetic pump sessions, with pad spikes and rails in some, go through the
+//   real APP_ALGO. calculateWaterVolume() is wrapped to run the generated one on a copy of the state
+//   first, and every field of the state, the calibration and the reason codes have to match after each
+//   window. delta_buffer is the one field that holds the history differently (a ring in APP_PADF), so
+//   the generated one keeps its own.
+//
+// Usage: test_padf
+
+#define RANDOM_MODES                5u
+#define RANDOM_SAMPLES_PER_MODE     1000000ul
+#define RANDOM_RESET_EVERY          5000u
+#define CAPTURE_PATH                "traces/capture_stream.csv"
+
+#define SYNTH_HOURS                 3u
+#define MS_PER_HOUR                 3600000ul
+#define SESSION_EVERY_MS            (6ul * 60ul * 1000ul)
+#define NUM_SESSION_TYPES           4u
+#define WATER_DEPTH_PADS            7.2
+#define PAD_DRY_COUNT               1200
+#define PAD_WET_DROP                260
+#define SPIKE_EVERY                 97u     // samples between pad spikes in the sessions that have them
+#define MIN_WINDOWS_WITH_WATER      100u
+
+typedef struct
+{
+    double sloshHz;
+    uint32_t lengthMs;
+    bool water;
+    bool spikes;            // a pad jumps to a rail or a random count now and then
+}sessionType_t;
+
+typedef struct
+{
+    padFilteringData_t genSmooth;
+    padFilteringData_t newSmooth;
+    padFilteringData_t genDelta;
+    padFilteringData_t newDelta;
+    uint32_t samples;
+    uint32_t resets;
+    uint32_t mismatches;
+}filterRun_t;
+
+static const sessionType_t xSessionTypes[NUM_SESSION_TYPES] =
+{
+    { 1.5, 200000ul, true,  false },
+    { 2.4, 150000ul, true,  true  },
+    { 1.0, 240000ul, true,  true  },
+    { 1.5,  20000ul, false, true  },
+};
+
+static filterRun_t xFilters;
+static padFilteringData_t xGenDeltaBuffer;
+static uint32_t xWindows = 0u;
+static uint32_t xWindowsWithWater = 0u;
+static uint32_t xWindowMismatches = 0u;
+static int32_t xFirstMismatchWindow = -1;
+static uint32_t xRandomState = 12345u;
+
+extern void __real_calculateWaterVolume(waterAlgoData_t * algo_data, waterCalibration_t * water_calib,
+                                        const padWindows_t * pad_window, ReasonCodes reason_codes[8]);
+void __wrap_calculateWaterVolume(waterAlgoData_t * algo_data, waterCalibration_t * water_calib,
+                                 const padWindows_t * pad_window, ReasonCodes reason_codes[8]);
+
+static void xFilterReset(void);
+static void xFilterStep(const padSample_t * p_sample);
+static int16_t xPickRandom(uint32_t mode, int16_t last);
+static bool xFilterCapture(void);
+static uint32_t xReplaySynth(void);
+static void xSynthRow(uint32_t sample, hostCaptureRow_t * p_row);
+static uint32_t xRandom(void);
+static uint32_t xHash(uint32_t value);
+static bool xCheck(bool condition, const char * p_what);
+
+// The state is copied before the real call, so both start each window from the same place
+void __wrap_calculateWaterVolume(waterAlgoData_t * algo_data, waterCalibration_t * water_calib,
+                                 const padWindows_t * pad_window, ReasonCodes reason_codes[8])
+{
+    waterAlgoData_t genData = *algo_data;
+    waterCalibration_t genCalib = *water_calib;
+    ReasonCodes genCodes[8];
+
+    memcpy(genCodes, reason_codes, sizeof(genCodes));
+
+    //initializeWaterAlgorithm() empties it, buffer_idx is never 0 again once APP_PADF_Delta() has run
+    if ( algo_data->delta_buffer.buffer_idx == 0u )
+    {
+        memset(&xGenDeltaBuffer, 0, sizeof(xGenDeltaBuffer));
+    }
+
+    genData.delta_buffer = xGenDeltaBuffer;
+    xGenCalculateWaterVolume(&genData, &genCalib, pad_window, genCodes);
+    __real_calculateWaterVolume(algo_data, water_calib, pad_window, reason_codes);
+
+    xGenDeltaBuffer = genData.delta_buffer;
+    genData.delta_buffer = algo_data->delta_buffer;
+
+    if ( (memcmp(&genData, algo_data, sizeof(genData)) != 0) || (memcmp(&genCalib, water_calib, sizeof(genCalib)) != 0) ||
+         (memcmp(genCodes, reason_codes, sizeof(genCodes)) != 0) )
+    {
+        if ( xFirstMismatchWindow < 0 )
+        {
+            xFirstMismatchWindow = (int32_t)xWindows;
+        }
+
+        xWindowMismatches++;
+    }
+
+    if ( algo_data->present != 0u )
+    {
+        xWindowsWithWater++;
+    }
+
+    xWindows++;
+}
+
+int main(void)
+{
+    padSample_t sample;
+    int16_T * p_pads = &sample.pad1;
+    uint32_t mode;
+    uint32_t i;
+    uint32_t pad;
+    uint32_t hourlyLiters;
+    bool pass = true;
+
+    memset(&sample, 0, sizeof(sample));
+
+    for ( mode = 0u; mode < RANDOM_MODES; mode++ )
+    {
+        xFilterReset();
+
+        for ( i = 0u; i < RANDOM_SAMPLES_PER_MODE; i++ )
+        {
+            for ( pad = 0u; pad < 8u; pad++ )
+            {
+                p_pads[pad] = xPickRandom(mode, p_pads[pad]);
+            }
+
+            if ( (xRandom() % RANDOM_RESET_EVERY) == 0u )
+            {
+                xFilterReset();
+            }
+
+            xFilterStep(&sample);
+        }
+    }
+
+    printf("random: %u samples in %u modes, %u resets, %u differ\n", xFilters.samples, RANDOM_MODES, xFilters.resets,
+           xFilters.mismatches);
+    pass &= xCheck(xFilters.mismatches == 0u, "random: APP_PADF_Smooth() and APP_PADF_Delta() match the generated filters");
+    pass &= xCheck(xFilterCapture() == true, "capture: APP_PADF matches the generated filters on " CAPTURE_PATH);
+
+    hourlyLiters = xReplaySynth();
+    printf("synthetic: %u hours, %u windows, %u with water, %u liters in the last hour, %u differ (first %d)\n",
+           SYNTH_HOURS, xWindows, xWindowsWithWater, hourlyLiters, xWindowMismatches, (int)xFirstMismatchWindow);
+    pass &= xCheck((xWindowsWithWater >= MIN_WINDOWS_WITH_WATER) && (hourlyLiters > 0u),
+                   "synthetic: the sessions are seen as water and counted");
+    pass &= xCheck(xWindowMismatches == 0u, "synthetic: calculateWaterVolume() matches the generated one on every window");
+
+    printf("%s\n", (pass == true) ? "PASS" : "FAIL");
+
+    return (pass == true) ? 0 : 1;
+}
+
+static bool xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+
+    return condition;
+}
+
+// padFilteringData_t all zero is what the generated init and reset functions leave
+static void xFilterReset(void)
+{
+    memset(&xFilters.genSmooth, 0, sizeof(padFilteringData_t));
+    memset(&xFilters.newSmooth, 0, sizeof(padFilteringData_t));
+    memset(&xFilters.genDelta, 0, sizeof(padFilteringData_t));
+    memset(&xFilters.newDelta, 0, sizeof(padFilteringData_t));
+    xFilters.resets++;
+}
+
+static void xFilterStep(const padSample_t * p_sample)
+{
+    padSample_t genSmoothed;
+    padSample_t newSmoothed = *p_sample;
+    padSample_t genDelta;
+    padSample_t newDelta;
+
+    waterPadFiltering(p_sample, &xFilters.genSmooth, &genSmoothed);
+    APP_PADF_Smooth(&newSmoothed, &xFilters.newSmooth, &newSmoothed);
+
+    add_to_buffer(p_sample->pad1, p_sample->pad2, p_sample->pad3, p_sample->pad4, p_sample->pad5, p_sample->pad6,
+                  p_sample->pad7, p_sample->pad8, &xFilters.genDelta, &genDelta.pad1, &genDelta.pad2, &genDelta.pad3,
+                  &genDelta.pad4, &genDelta.pad5, &genDelta.pad6, &genDelta.pad7, &genDelta.pad8);
+    APP_PADF_Delta(p_sample, &xFilters.newDelta, &newDelta);
+
+    if ( (memcmp(&genSmoothed, &newSmoothed, sizeof(padSample_t)) != 0) ||
+         (memcmp(&genDelta, &newDelta, sizeof(padSample_t)) != 0) )
+    {
+        if ( xFilters.mismatches == 0u )
+        {
+            printf("  first difference at sample %u: smoothed pad1 %d vs %d, delta pad1 %d vs %d\n", xFilters.samples,
+                   genSmoothed.pad1, newSmoothed.pad1, genDelta.pad1, newDelta.pad1);
+        }
+
+        xFilters.mismatches++;
+    }
+
+    xFilters.samples++;
+}
+
+static int16_t xPickRandom(uint32_t mode, int16_t last)
+{
+    switch ( mode )
+    {
+        case 0u:
+            return (int16_t)xRandom();
+        case 1u:
+            return (int16_t)(last + (int16_t)(xRandom() % 21u) - 10);
+        case 2u:
+            return ((xRandom() & 1u) != 0u) ? INT16_MAX : INT16_MIN;
+        case 3u:
+            return ((xRandom() % 8u) != 0u) ? last : (int16_t)(xRandom() % 4096u);
+        default:
+            return (int16_t)(xRandom() % 3u);
+    }
+}
+
+static bool xFilterCapture(void)
+{
+    hostCaptureRow_t * p_rows = NULL;
+    padSample_t sample;
+    uint32_t rows = HOST_LoadCapture(CAPTURE_PATH, &p_rows);
+    uint32_t mismatchesBefore = xFilters.mismatches;
+    uint32_t i;
+
+    xFilterReset();
+
+    for ( i = 0u; i < rows; i++ )
+    {
+        memcpy(&sample.pad1, p_rows[i].pads, sizeof(sample));
+        xFilterStep(&sample);
+    }
+
+    free(p_rows);
+    printf("capture: %u samples\n", rows);
+
+    return (rows > 0u) && (xFilters.mismatches == mismatchesBefore);
+}
+
+// Runs the nest every 50 ms as APP.c does, returns the liters of the last hour
+static uint32_t xReplaySynth(void)
+{
+    APP_NVM_SENSOR_DATA_T sensorData;
+    hostCaptureRow_t row;
+    uint32_t samplesPerHour = MS_PER_HOUR / HOST_MS_PER_SAMPLE;
+    uint32_t sample;
+    uint32_t hour = 0u;
+    bool wasActive = false;
+
+    memset(&sensorData, 0, sizeof(sensorData));
+    APP_ALGO_Init();
+
+    for ( sample = 0u; sample < (SYNTH_HOURS * samplesPerHour); sample++ )
+    {
+        HOST_SetTimeMs((uint64_t)sample * HOST_MS_PER_SAMPLE);
+        xSynthRow(sample, &row);
+        HOST_SetRow(&row);
+
+        //APP_setPumpActive()
+        if ( (row.active == true) && (wasActive == false) )
+        {
+            APP_ALGO_wakeUpInit();
+        }
+
+        wasActive = row.active;
+        APP_ALGO_Nest(row.active);
+
+        if ( ((sample + 1u) % samplesPerHour) == 0u )
+        {
+            hour = sample / samplesPerHour;
+            APP_ALGO_updateHourlyFields(&sensorData, (uint8_t)(hour % HOUR_PER_DAY));
+        }
+    }
+
+    return sensorData.litersPerHour[hour % HOUR_PER_DAY];
+}
+
+// One 50 ms row of pads: sessions every 6 minutes, the water rises up the pads from pad8 and sloshes,
+// as in test_ckpt. Only the pads matter here.
+static void xSynthRow(uint32_t sample, hostCaptureRow_t * p_row)
+{
+    uint64_t ms = (uint64_t)sample * HOST_MS_PER_SAMPLE;
+    const sessionType_t * p_type = &xSessionTypes[(ms / SESSION_EVERY_MS) % NUM_SESSION_TYPES];
+    double sec = (double)(ms % SESSION_EVERY_MS) / 1000.0;
+    double lengthSec = p_type->lengthMs / 1000.0;
+    bool pumping = (sec < lengthSec);
+    double level = 0.0;
+    double cover;
+    uint32_t noise;
+    int i;
+
+    if ( p_type->water == true )
+    {
+        if ( pumping == true )
+        {
+            level = fmin(WATER_DEPTH_PADS, sec / 3.0) + ((sec > 25.0) ? (0.6 * sin(2.0 * M_PI * p_type->sloshHz * sec)) : 0.0);
+        }
+        else
+        {
+            level = fmax(0.0, WATER_DEPTH_PADS - ((sec - lengthSec) / 4.0));
+        }
+    }
+
+    memset(p_row, 0, sizeof(hostCaptureRow_t));
+    p_row->tick = sample;
+    p_row->active = (pumping == true) || (level > 0.0);
+
+    //pad8 is at the bottom and covers first
+    for ( i = 0; i < HOST_NUM_PADS; i++ )
+    {
+        cover = fmin(1.0, fmax(0.0, level - (HOST_NUM_PADS - 1 - i)));
+        noise = xHash((sample * HOST_NUM_PADS) + (uint32_t)i);
+        p_row->pads[i] = (int16_t)(PAD_DRY_COUNT + (10 * i) - (int)(PAD_WET_DROP * cover) + (int)(noise % 5u) - 2);
+
+        if ( cover > 0.0 )
+        {
+            p_row->pads[i] += (int16_t)((int)((noise >> 8) % 13u) - 6);
+        }
+
+        if ( (p_type->spikes == true) && ((xHash(noise) % (SPIKE_EVERY * HOST_NUM_PADS)) == 0u) )
+        {
+            p_row->pads[i] = ((noise & 1u) != 0u) ? INT16_MAX : (int16_t)(noise >> 16);
+        }
+    }
+}
+
+// xorshift32, the random filter inputs
+static uint32_t xRandom(void)
+{
+    xRandomState ^= xRandomState << 13;
+    xRandomState ^= xRandomState >> 17;
+    xRandomState ^= xRandomState << 5;
+
+    return xRandomState;
+}
+
+static uint32_t xHash(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x7FEB352Du;
+    value ^= value >> 15;
+    value *= 0x846CA68Bu;
+    value ^= value >> 16;
+
+    return value;
+}
@@ -0,0 +1,326 @@
+/**************************************************************************************************
+* \file     test_prof.c
+* \brief    Host test of the stage profiler against a mock microsecond timer
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "APP_PROF.h"
+#include "uC_TIME.h"
+
+// Runs APP_PROF.c against a mock of Timer_A2 and the 10 ms runtime tick, both read from one simulated
+// time in us: the 16 bit microsecond counter is its low bits, the tick counter is it over 10000.
+//
+// Checks the histogram bucket edges, the stage times across the counter wrap and where they saturate,
+// that halving count and sum together keeps the mean over 70k and 200k samples and lets it follow a
+// step, that a full bucket halves the whole histogram, and the report layout.
+//
+// Usage: test_prof
+
+#define US_PER_TICK                 10000u
+#define COUNTER_WRAP_US             65536u
+#define SATURATE_US                 60000u      // 6 ticks, always counted as saturated from here
+#define TRUSTED_US                  50000u      // 5 ticks, never counted as saturated below this
+#define SWEEP_STEP_US               7u
+#define SWEEP_MAX_US                (COUNTER_WRAP_US + US_PER_TICK)
+#define REPORT_LEN                  4096u
+#define LINE_LEN                    120u
+
+typedef struct
+{
+    uint16_t us;
+    uint8_t bucket;
+}bucketEdge_t;
+
+// first and last time of each bucket
+static const bucketEdge_t xEdges[] =
+{
+    { 0u, 0u },     { 15u, 0u },
+    { 16u, 1u },    { 63u, 1u },
+    { 64u, 2u },    { 255u, 2u },
+    { 256u, 3u },   { 1023u, 3u },
+    { 1024u, 4u },  { 4095u, 4u },
+    { 4096u, 5u },  { 16383u, 5u },
+    { 16384u, 6u }, { 65534u, 6u },
+    { APP_PROF_SATURATED, 7u },
+};
+
+static bool xPass = true;
+static uint64_t xNowUs = 0u;
+static char xReport[REPORT_LEN];
+static uint32_t xReportLen = 0u;
+
+static void xCheck(bool condition, const char * p_what);
+static uint16_t xTimeStage(uint64_t startUs, uint32_t us);
+static int8_t xBucketOf(uint16_t us);
+static void xCheckEdges(void);
+static void xCheckTiming(void);
+static void xCheckMean(void);
+static void xCheckHistogram(void);
+static void xCheckReport(void);
+
+int main(int argc, char * argv[])
+{
+    xCheckEdges();
+    xCheckTiming();
+    xCheckMean();
+    xCheckHistogram();
+    xCheckReport();
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// One stage of the given length starting at the given time, returns what the profiler recorded
+static uint16_t xTimeStage(uint64_t startUs, uint32_t us)
+{
+    appProfStamp_t start;
+
+    APP_PROF_Reset();
+    xNowUs = startUs;
+    start = APP_PROF_Begin();
+    xNowUs += us;
+    APP_PROF_End(PROF_LOOP, start);
+
+    return APP_PROF_GetStats(PROF_LOOP)->max;
+}
+
+// The bucket a single sample lands in, -1 if it is not exactly one
+static int8_t xBucketOf(uint16_t us)
+{
+    const appProfStats_t * p_stats = APP_PROF_GetStats(PROF_ALGO_NEST);
+    int8_t bucket = -1;
+    uint8_t i;
+
+    APP_PROF_Reset();
+    APP_PROF_Add(PROF_ALGO_NEST, us);
+
+    for ( i = 0u; i < APP_PROF_NUM_BUCKETS; i++ )
+    {
+        if ( p_stats->buckets[i] == 1u )
+        {
+            bucket = (bucket < 0) ? (int8_t)i : (int8_t)APP_PROF_NUM_BUCKETS;
+        }
+        else if ( p_stats->buckets[i] != 0u )
+        {
+            return -1;
+        }
+    }
+
+    return (bucket < (int8_t)APP_PROF_NUM_BUCKETS) ? bucket : -1;
+}
+
+static void xCheckEdges(void)
+{
+    const appProfStats_t * p_stats;
+    bool edgesOk = true;
+    uint32_t i;
+
+    printf("  statistics:\n");
+    APP_PROF_Reset();
+    p_stats = APP_PROF_GetStats(PROF_LOOP);
+    xCheck((p_stats->count == 0u) && (p_stats->min == UINT16_MAX) && (p_stats->max == 0u) && (APP_PROF_GetMean(PROF_LOOP) == 0u),
+           "a reset stage has no samples, min at the top and a mean of 0");
+
+    for ( i = 0u; i < (sizeof(xEdges) / sizeof(xEdges[0])); i++ )
+    {
+        if ( xBucketOf(xEdges[i].us) != (int8_t)xEdges[i].bucket )
+        {
+            printf("    %u us went to bucket %d, not %u\n", xEdges[i].us, xBucketOf(xEdges[i].us), xEdges[i].bucket);
+            edgesOk = false;
+        }
+    }
+    xCheck(edgesOk, "each bucket starts and ends where the report heading says");
+
+    APP_PROF_Reset();
+    APP_PROF_Add(PROF_CLI_PERIODIC, 300u);
+    APP_PROF_Add(PROF_CLI_PERIODIC, 20u);
+    APP_PROF_Add(PROF_CLI_PERIODIC, 1000u);
+    p_stats = APP_PROF_GetStats(PROF_CLI_PERIODIC);
+    xCheck((p_stats->count == 3u) && (p_stats->min == 20u) && (p_stats->max == 1000u) && (p_stats->sum == 1320u) &&
+           (APP_PROF_GetMean(PROF_CLI_PERIODIC) == 440u), "count, min, max, sum and mean of three samples");
+    xCheck(APP_PROF_GetStats(PROF_LOOP)->count == 0u, "the other stages are untouched");
+
+    APP_PROF_Add(PROF_STAGE_COUNT, 5u);
+    xCheck((APP_PROF_GetStats(PROF_STAGE_COUNT) == NULL) && (APP_PROF_GetMean(PROF_STAGE_COUNT) == 0u),
+           "a stage out of range is ignored");
+}
+
+// Every stage length up to a tick past the counter wrap, from start times all over the tick and the counter
+static void xCheckTiming(void)
+{
+    uint32_t exact = 0u;
+    uint32_t saturated = 0u;
+    uint32_t wrong = 0u;
+    uint32_t wrapped = 0u;
+    uint64_t startUs;
+    uint32_t us;
+    uint16_t recorded;
+
+    printf("  timing:\n");
+    xCheck(xTimeStage(123456u, 1234u) == 1234u, "a 1234 us stage is 1234 us");
+    xCheck(xTimeStage(COUNTER_WRAP_US - 500u, 1000u) == 1000u, "a stage over the counter wrap is timed right");
+    xCheck(xTimeStage(5u * COUNTER_WRAP_US, 0u) == 0u, "an empty stage is 0 us");
+
+    srand(45);
+    for ( us = 0u; us <= SWEEP_MAX_US; us += SWEEP_STEP_US )
+    {
+        startUs = ((uint64_t)rand() << 16) ^ (uint64_t)rand();
+        recorded = xTimeStage(startUs, us);
+        wrapped += ((uint16_t)((startUs % COUNTER_WRAP_US) + us) < (uint16_t)(startUs % COUNTER_WRAP_US)) ? 1u : 0u;
+
+        if ( recorded == APP_PROF_SATURATED )
+        {
+            saturated++;
+            wrong += (us < TRUSTED_US) ? 1u : 0u;
+        }
+        else
+        {
+            exact += (recorded == us) ? 1u : 0u;
+            wrong += ((recorded != us) || (us >= SATURATE_US)) ? 1u : 0u;
+        }
+    }
+    printf("    %u stage lengths, %u timed exactly, %u saturated, %u across the counter wrap\n",
+           (SWEEP_MAX_US / SWEEP_STEP_US) + 1u, exact, saturated, wrapped);
+    xCheck((wrong == 0u) && (wrapped > 0u),
+           "every stage is timed exactly or saturated, never under 50 ms and always from 60 ms");
+
+    xCheck(xTimeStage(7u * US_PER_TICK, COUNTER_WRAP_US + 100u) == APP_PROF_SATURATED,
+           "a stage that wrapped the counter right round is saturated, not 100 us");
+}
+
+static void xCheckMean(void)
+{
+    const appProfStats_t * p_stats = APP_PROF_GetStats(PROF_ALGO_NEST);
+    bool bounded = true;
+    uint32_t i;
+
+    printf("  mean:\n");
+    APP_PROF_Reset();
+    for ( i = 0u; i < 70000u; i++ )
+    {
+        APP_PROF_Add(PROF_ALGO_NEST, ((i & 1u) == 0u) ? 1500u : 2500u);
+        bounded = bounded && (p_stats->count <= (UINT16_MAX - 1u));
+    }
+    xCheck(bounded && (p_stats->count < 70000u) && (APP_PROF_GetMean(PROF_ALGO_NEST) == 2000u),
+           "the mean of 70k samples is kept when count and sum are halved");
+
+    for ( i = 0u; i < 130000u; i++ )
+    {
+        APP_PROF_Add(PROF_ALGO_NEST, ((i % 4u) == 0u) ? 1000u : 3000u);
+        bounded = bounded && (p_stats->count <= (UINT16_MAX - 1u));
+    }
+    printf("    after 70k samples of 2000 us and 130k of 2500 us the mean is %u us\n", APP_PROF_GetMean(PROF_ALGO_NEST));
+    xCheck(bounded && (APP_PROF_GetMean(PROF_ALGO_NEST) >= 2450u) && (APP_PROF_GetMean(PROF_ALGO_NEST) <= 2500u),
+           "over 200k samples the mean follows the step to the recent samples");
+    xCheck((p_stats->min == 1000u) && (p_stats->max == 3000u), "min and max cover all 200k samples");
+
+    APP_PROF_Reset();
+    for ( i = 0u; i < 200000u; i++ )
+    {
+        APP_PROF_Add(PROF_ALGO_NEST, APP_PROF_SATURATED);
+    }
+    xCheck(APP_PROF_GetMean(PROF_ALGO_NEST) == APP_PROF_SATURATED, "200k saturated samples do not overflow the sum");
+}
+
+static void xCheckHistogram(void)
+{
+    const appProfStats_t * p_stats = APP_PROF_GetStats(PROF_MAG_MONITOR);
+    uint32_t i;
+
+    printf("  histogram:\n");
+    APP_PROF_Reset();
+    for ( i = 0u; i < 10u; i++ )
+    {
+        APP_PROF_Add(PROF_MAG_MONITOR, 500u);
+    }
+    for ( i = 0u; i < 70000u; i++ )
+    {
+        APP_PROF_Add(PROF_MAG_MONITOR, 10u);
+    }
+    xCheck((p_stats->buckets[0] == (32767u + 1u + (70000u - 65536u))) && (p_stats->buckets[3] == 5u),
+           "a full bucket halves them all, the shape is kept");
+}
+
+static void xCheckReport(void)
+{
+    char * p_line;
+    char * p_next;
+    uint32_t lines = 0u;
+    bool widthOk = true;
+
+    printf("  report:\n");
+    APP_PROF_Reset();
+    APP_PROF_Add(PROF_LOOP, 12u);
+    APP_PROF_Add(PROF_LOOP, 7000u);
+    APP_PROF_Add(PROF_LOOP, APP_PROF_SATURATED);
+    APP_PROF_Add(PROF_ALGO_NEST, 4321u);
+    xReportLen = 0u;
+    APP_PROF_Report();
+
+    for ( p_line = xReport; (p_next = strstr(p_line, "\n\r")) != NULL; p_line = p_next + 2 )
+    {
+        widthOk = widthOk && ((p_next - p_line) < LINE_LEN);
+        lines += (p_next != p_line) ? 1u : 0u;
+    }
+    xCheck(lines == (PROF_STAGE_COUNT + 1u), "a heading and a line per stage");
+    xCheck(widthOk, "every line fits the 120 character buffer");
+    xCheck(strstr(xReport, "stage                       count   min  mean   max |   <16   <64  <256   <1k   <4k  <16k  >16k   sat\n\r") != NULL,
+           "the heading");
+    xCheck(strstr(xReport, "\n\rloop                            3    12 24182 65535 |     1     0     0     0     0     1     0     1\n\r") != NULL,
+           "the loop line has count, min, mean, max and the buckets");
+    xCheck(strstr(xReport, "\n\rAPP_ALGO_Nest                   1  4321  4321  4321 |     0     0     0     0     0     1     0     0\n\r") != NULL,
+           "the algorithm line");
+    xCheck(strstr(xReport, "\n\rCAPT_appHandler                 0\n\r") != NULL, "a stage with no samples only shows the count");
+
+    if ( getenv("HOST_VERBOSE") != NULL )
+    {
+        printf("%s", xReport);
+    }
+}
+
+// Timer_A2, one count per us
+uint16_t uC_TIME_GetMicroseconds(void)
+{
+    return (uint16_t)xNowUs;
+}
+
+uint64_t uC_TIME_GetRuntimeTicks(void)
+{
+    return xNowUs / US_PER_TICK;
+}
+
+void HW_TERM_Print(uint8_t * p_str)
+{
+    xReportLen += snprintf(&xReport[xReportLen], REPORT_LEN - xReportLen, "%s", (char *)p_str);
+}
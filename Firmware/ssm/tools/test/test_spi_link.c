@@ -0,0 +1,353 @@
+/**************************************************************************************************
+* \file     test_spi_link.c
+* \brief    AM-SSM frame transport over a loopback SPI master
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <msp430.h>
+#include "am-ssm-spi-protocol.h"
+#include "uC_SPI.h"
+#include "uC_TIME.h"
+#include "host_ssm.h"
+
+// Runs uC_SPI.c and the SSM half of am-ssm-spi-protocol.c under a simulated AM SPI master. Every byte the
+// master clocks raises the transmit interrupt (the SSM loads its next MISO byte) and then the receive
+// interrupt (the MOSI byte is in), the same order the eUSCI gives them. xPeriodic() is the main loop half,
+// the same steps as ASP_SSM_Periodic() in ssm-spi-protocol.c, which is not linked since its handlers pull
+// in most of the application.
+//
+// The config handler here echoes the payload back as a maximum size sensor data frame, so every round
+// trip carries ASP_MAX_PAYLOAD bytes each way. Each frame has to wake the main loop once, not once a
+// byte, and come back byte for byte. Then noise, bad frames, a stalled frame, back to back frames and the
+// two transmit buffers are checked, and the time a maximum size frame takes at each AM SPI2 speed is
+// printed.
+//
+// Usage: test_spi_link
+
+#define ROUND_TRIPS                 1000u
+#define MAX_FRAME                   (ASP_MAX_PAYLOAD + ASP_TOTAL_OVERHEAD_BYTES)
+#define IDLE_BYTE                   0xFFu
+#define AM_PCLK1_HZ                 3000000.0       // 48 MHz MSI / 16, SPI2 is on APB1
+#define SSM_MCLK_HZ                 16000000.0      // DCO_FREQ, CAPT_BSP.h
+
+void USCI_A1_ISR(void);
+
+static bool xReady = false;
+static uint32_t xIsrCalls = 0u;
+static uint32_t xHandled = 0u;
+static uint32_t xNacks = 0u;
+static uint8_t xEchoLen = 0u;
+static uint8_t xEchoPayload[ASP_MAX_PAYLOAD];
+static bool xPass = true;
+
+static void xCheck(bool condition, const char * p_what);
+static void xPeriodic(void);
+static uint8_t xClockByte(uint8_t mosi);
+static void xClockFrame(const uint8_t * p_frame, uint8_t len);
+static uint8_t xBuildFrame(uint8_t * p_frame, uint8_t id, uint8_t payloadLen);
+static bool xRoundTrips(uint32_t * p_isrCalls, uint32_t * p_wakes);
+
+int main(void)
+{
+    static const uint16_t dividers[] = {256u, 128u, 64u, 32u};
+    uint8_t frame[MAX_FRAME];
+    uint8_t len = 0u;
+    uint32_t handled = 0u;
+    uint32_t nacks = 0u;
+    uint32_t isrCalls = 0u;
+    uint32_t wakes = 0u;
+    asp_msg_t * p_first = NULL;
+    asp_msg_t * p_second = NULL;
+
+    srand(35);
+    uC_SPI_Init();
+    xCheck(xReady == true, "SSM_RDY is set after init");
+
+    printf("  frames:\n");
+    xCheck(xRoundTrips(&isrCalls, &wakes) == true, "1000 max payload frames come back byte for byte, one wake each");
+    printf("    %u byte frame each way: %u ISR entries, %u main loop wakes\n", (unsigned)MAX_FRAME,
+           (unsigned)isrCalls, (unsigned)wakes);
+
+    len = xBuildFrame(frame, ASP_COMMAND_MSG_ID, 1u);
+    handled = xHandled;
+    (void)xClockByte(0x00u);
+    (void)xClockByte(0x13u);
+    xClockFrame(frame, len);
+    xPeriodic();
+    xCheck(xHandled == (handled + 1u), "noise before the start byte is skipped");
+
+    len = xBuildFrame(frame, ASP_COMMAND_MSG_ID, 1u);
+    frame[len - 1u] ^= 1u;
+    nacks = xNacks;
+    xClockFrame(frame, len);
+    xPeriodic();
+    xCheck(xNacks == (nacks + 1u), "a bad checksum is NACKed");
+
+    len = xBuildFrame(frame, 0x77u, 4u);
+    nacks = xNacks;
+    xClockFrame(frame, len);
+    xPeriodic();
+    xCheck(xNacks == (nacks + 1u), "an unknown message ID is NACKed");
+
+    nacks = xNacks;
+    wakes = HOST_GetWakeCount();
+    (void)xClockByte(ASP_START_FRAME_MAGIC);
+    (void)xClockByte(ASP_MAX_PAYLOAD + 1u);
+    xCheck(HOST_GetWakeCount() == (wakes + 1u), "a length over the maximum wakes the main loop at once");
+    xPeriodic();
+    xCheck(xNacks == (nacks + 1u), "a length over the maximum is NACKed");
+    len = xBuildFrame(frame, ASP_COMMAND_MSG_ID, 1u);
+    handled = xHandled;
+    xClockFrame(frame, len);
+    xPeriodic();
+    xCheck(xHandled == (handled + 1u), "the frame after it is received");
+
+    len = xBuildFrame(frame, ASP_COMMAND_MSG_ID, 1u);
+    handled = xHandled;
+    xClockFrame(frame, 3u);
+    for ( uint32_t ms = 0u; ms <= 120u; ms += 10u )
+    {
+        HOST_SetTimeMs(HOST_GetTimeMs() + 10u);
+        xPeriodic();
+    }
+    xClockFrame(frame, len);
+    xPeriodic();
+    xCheck(xHandled == (handled + 1u), "a stalled frame is dropped after 100 ms and the next one is received");
+
+    len = xBuildFrame(frame, ASP_COMMAND_MSG_ID, 1u);
+    handled = xHandled;
+    xClockFrame(frame, len);
+    xClockFrame(frame, len);
+    xPeriodic();
+    xCheck(xHandled == (handled + 2u), "two frames in before the main loop runs are both handled");
+
+    p_first = ASP_GetTxBuffer();
+    p_first->bytes[0] = ASP_START_FRAME_MAGIC;
+    xCheck(uC_SPI_Tx(p_first->bytes, 10u) == true, "a frame starts going out");
+    (void)xClockByte(IDLE_BYTE);
+    p_second = ASP_GetTxBuffer();
+    xCheck(p_second != p_first, "the next response is built in the other buffer");
+    xCheck(uC_SPI_Tx(p_second->bytes, 10u) == false, "a second transmit is refused until the first is out");
+    for ( uint8_t i = 0u; i < 10u; i++ )
+    {
+        (void)xClockByte(IDLE_BYTE);
+    }
+    xCheck((ASP_GetTxBuffer() == p_second) && (xReady == true), "SSM_RDY is set again once the frame is out");
+
+    printf("  AM SPI2 at PCLK1 %.0f MHz, %u byte frame:\n", AM_PCLK1_HZ / 1e6, (unsigned)MAX_FRAME);
+    for ( uint8_t i = 0u; i < (sizeof(dividers) / sizeof(dividers[0])); i++ )
+    {
+        double hz = AM_PCLK1_HZ / dividers[i];
+        double ms = (MAX_FRAME * 8.0 * 1000.0) / hz;
+        double usPerByte = (8.0 * 1e6) / hz;
+
+        printf("    speed %u (/%3u): %7.0f Hz %7.1f ms/frame %6.2f kB/s %5.0f us/byte, %5.0f SSM cycles/byte\n",
+               (unsigned)i, (unsigned)dividers[i], hz, ms, MAX_FRAME / ms, usPerByte, (usPerByte * SSM_MCLK_HZ) / 1e6);
+    }
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// ASP_SSM_Periodic()
+static void xPeriodic(void)
+{
+    uint8_t len = 0;
+    asp_msg_t * p_msg = NULL;
+
+    uC_SPI_Periodic();
+
+    if ( uC_SPI_TakeFramingError() == true )
+    {
+        ASP_HandleErroneousMsg();
+    }
+
+    while ( uC_SPI_FrameReady() )
+    {
+        p_msg = (asp_msg_t *)uC_SPI_GetFrame(&len);
+        ASP_ProcessIncomingFrame(p_msg, len);
+        uC_SPI_ReleaseFrame();
+    }
+}
+
+// One byte clocked by the AM, returns what the SSM sent back
+static uint8_t xClockByte(uint8_t mosi)
+{
+    uint8_t miso = UCA1TXBUF;
+
+    UCA1IV = USCI_SPI_UCTXIFG;
+    USCI_A1_ISR();
+    UCA1RXBUF = mosi;
+    UCA1IV = USCI_SPI_UCRXIFG;
+    USCI_A1_ISR();
+    xIsrCalls += 2u;
+
+    return miso;
+}
+
+static void xClockFrame(const uint8_t * p_frame, uint8_t len)
+{
+    for ( uint8_t i = 0u; i < len; i++ )
+    {
+        (void)xClockByte(p_frame[i]);
+    }
+}
+
+// A frame the way the AM builds it, with a random payload. Returns its length.
+static uint8_t xBuildFrame(uint8_t * p_frame, uint8_t id, uint8_t payloadLen)
+{
+    asp_msg_t msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.fields.startFrame = ASP_START_FRAME_MAGIC;
+    msg.fields.payloadLen = payloadLen;
+    msg.fields.messageID = id;
+    for ( uint8_t i = 0u; i < payloadLen; i++ )
+    {
+        msg.fields.payload.bytes[i] = (uint8_t)rand();
+    }
+
+    memcpy(p_frame, msg.bytes, payloadLen + ASP_HEADER_BYTES);
+    p_frame[payloadLen + ASP_HEADER_BYTES] = ASP_ComputeChecksum(&msg);
+
+    return (payloadLen + ASP_TOTAL_OVERHEAD_BYTES);
+}
+
+// Max payload config frames in, sensor data frames back. Fills in the ISR entries and wakes of the last one.
+static bool xRoundTrips(uint32_t * p_isrCalls, uint32_t * p_wakes)
+{
+    uint8_t frame[MAX_FRAME];
+    uint8_t response[MAX_FRAME];
+    asp_msg_t check;
+    bool ok = true;
+
+    for ( uint32_t n = 0u; n < ROUND_TRIPS; n++ )
+    {
+        uint8_t len = xBuildFrame(frame, ASP_CONFIG_MSG_ID, ASP_MAX_PAYLOAD);
+        uint32_t isrCalls = xIsrCalls;
+        uint32_t wakes = HOST_GetWakeCount();
+        uint32_t handled = xHandled;
+
+        xClockFrame(frame, len);
+        ok &= (HOST_GetWakeCount() == (wakes + 1u));
+
+        xPeriodic();
+        ok &= (xHandled == (handled + 1u)) && (xEchoLen == ASP_MAX_PAYLOAD);
+        ok &= (memcmp(xEchoPayload, &frame[ASP_HEADER_BYTES], ASP_MAX_PAYLOAD) == 0);
+        ok &= (xReady == false);
+
+        //the AM sees SSM_RDY low and clocks the response out, then one more byte for the done interrupt
+        for ( uint8_t i = 0u; i < len; i++ )
+        {
+            response[i] = xClockByte(IDLE_BYTE);
+        }
+        (void)xClockByte(IDLE_BYTE);
+        ok &= (xReady == true) && (HOST_GetWakeCount() == (wakes + 2u));
+
+        memcpy(check.bytes, response, len);
+        ok &= (response[0] == ASP_START_FRAME_MAGIC) && (response[1] == ASP_MAX_PAYLOAD);
+        ok &= (response[2] == ASP_SENSOR_DATA_MSG_ID) && (ASP_ComputeChecksum(&check) == response[len - 1u]);
+        ok &= (memcmp(&response[ASP_HEADER_BYTES], &frame[ASP_HEADER_BYTES], ASP_MAX_PAYLOAD) == 0);
+
+        *p_isrCalls = (xIsrCalls - isrCalls);
+        *p_wakes = (HOST_GetWakeCount() - wakes);
+    }
+
+    return ok;
+}
+
+// SSM_RDY and WAKE_AP
+void HW_GPIO_Set_SSM_RDY(void)
+{
+    xReady = true;
+}
+
+void HW_GPIO_Clear_SSM_RDY(void)
+{
+    xReady = false;
+}
+
+void HW_GPIO_Clear_WAKE_AP(void)
+{
+}
+
+// Message handlers, config is the loopback
+void ASP_HandleCommandMsg(asp_msg_t * p_msg)
+{
+    xHandled++;
+}
+
+void ASP_HandleGetSensorDataMsg(void)
+{
+    xHandled++;
+}
+
+void ASP_HandleSetRTCMsg(asp_msg_t * p_msg)
+{
+    xHandled++;
+}
+
+void ASP_HandleAttnSourceAckMsg(asp_attn_source_payload_t * p_msg)
+{
+    xHandled++;
+}
+
+void ASP_HandleErroneousMsg(void)
+{
+    xNacks++;
+}
+
+void ASP_HandleConfigMsg(asp_msg_t * p_msg)
+{
+    asp_msg_t * p_tx = ASP_GetTxBuffer();
+    uint8_t len = p_msg->fields.payloadLen;
+
+    xHandled++;
+    xEchoLen = len;
+    memcpy(xEchoPayload, p_msg->fields.payload.bytes, len);
+
+    p_tx->fields.startFrame = ASP_START_FRAME_MAGIC;
+    p_tx->fields.payloadLen = len;
+    p_tx->fields.messageID = ASP_SENSOR_DATA_MSG_ID;
+    memcpy(p_tx->fields.payload.bytes, xEchoPayload, len);
+    p_tx->bytes[len + ASP_HEADER_BYTES] = ASP_ComputeChecksum(p_tx);
+
+    if ( uC_SPI_Tx(p_tx->bytes, (len + ASP_TOTAL_OVERHEAD_BYTES)) == false )
+    {
+        xPass = false;
+    }
+}
@@ -0,0 +1,581 @@
+/**************************************************************************************************
+* \file     test_stats.c
+* \brief    Host test of the breakdown (red flag) detector in APP_STATS against the old 4 week array
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "APP_STATS.h"
+
+// Replays daily liter series through APP_STATS and through the detector APP_ALGO.c had before it (the
+// 28 day array, kept here as xOld*), and compares when each raises the red flag. The series are
+// synthetic: a weekday pattern with noise, a seasonal swing and the odd low day that isn't a
+// breakdown, with full and partial breakdowns dropped in. Daily series recorded in the field can be
+// replayed too, as CSV files of "liters,broken" lines (broken is 1 on days the pump was known to be
+// down) given on the command line.
+//
+// A well that is busy on market days and next to idle the rest of the week is run on its own. Sigma is
+// learned over all days and the baseline per day of the week, so on the quiet days sigma / 2 is larger
+// than the baseline. The change detector must not raise the flag there, the well never breaks down.
+//
+// Usage: test_stats [series.csv ...]
+
+#define SERIES_COUNT                200
+#define SERIES_DAYS                 548         // 18 months
+#define FIRST_EVENT_DAY             70          // after the 4 week warm-up and a month of normal use
+#define MAX_DAYS                    4000
+#define DAYS_PER_YEAR               365.0
+#define NOISY_WELLS                 50
+#define NOISY_DAYS                  730
+
+// The old detector, as it was in APP_ALGO.c
+#define OLD_WEEKS                   4
+#define OLD_DAYS                    (OLD_WEEKS * APP_STATS_DAYS_PER_WEEK)
+
+typedef enum {
+    EVENT_NONE,
+    EVENT_FULL,                 // pump down, next to no water
+    EVENT_PARTIAL,              // pump still gives some water, between the on and off thresholds
+    EVENT_TYPES
+}eventType_t;
+
+typedef struct {
+    uint16_t liters[MAX_DAYS];
+    uint8_t event[MAX_DAYS];    // eventType_t of the breakdown going on that day
+    uint16_t days;
+}series_t;
+
+typedef struct {
+    uint32_t events[EVENT_TYPES];
+    uint32_t detected[EVENT_TYPES];
+    uint32_t delaySum[EVENT_TYPES];
+    uint32_t delayMax[EVENT_TYPES];
+    uint32_t falseAlarms;       // flag raised on a day with no breakdown going on
+    uint32_t normalDays;
+}result_t;
+
+typedef bool (*detector_t)(uint16_t liters, uint16_t * p_avg);
+
+typedef struct {
+    uint16_t on;
+    uint16_t off;
+    bool checked;               // false: reported only, see xThresholds
+}thresholds_t;
+
+// On/off percentages the synthetic series are run with. With the off level at 90% a normal day often
+// falls below it, the change detector finds most partial breakdowns there but raises more false alarms
+// than the old detector, so that pair is only reported.
+static const thresholds_t xThresholds[] =
+{
+    { 50u, 80u, true },
+    { 40u, 70u, true },
+    { 30u, 60u, true },
+    { 60u, 90u, false },
+};
+
+static uint16_t oldOnThreshold;
+static uint16_t oldOffThreshold;
+static uint16_t oldDaily[OLD_DAYS];
+static uint8_t oldIdx;
+static bool oldMonthPresent;
+static bool oldFlag;
+
+static uint32_t xSeed;
+static int xFailures;
+
+static void xOldReset(void);
+static void xOldPopulateFake(void);
+static bool xOldUpdate(uint16_t liters, uint16_t * p_avg);
+static bool xNewUpdate(uint16_t liters, uint16_t * p_avg);
+static void xNewPopulateFake(void);
+static uint32_t xRand(void);
+static uint32_t xRange(uint32_t lo, uint32_t hi);
+static void xMakeSeries(series_t * p_series);
+static void xReplay(const series_t * p_series, detector_t detector, result_t * p_result);
+static void xReport(const char * p_name, const result_t * p_result, double years);
+static void xCheck(bool ok, const char * p_what);
+static void xTestFakeMonth(void);
+static void xTestSynthetic(const thresholds_t * p_thresholds);
+static void xTestFile(const char * p_path);
+static void xTestNoisyLowUsage(void);
+static void xSetThresholds(uint16_t on, uint16_t off);
+
+int main(int argc, char ** argv)
+{
+    unsigned i;
+
+    xSetThresholds(xThresholds[0].on, xThresholds[0].off);
+    xTestFakeMonth();
+
+    for ( i = 0u; i < (sizeof(xThresholds) / sizeof(xThresholds[0])); i++ )
+    {
+        xTestSynthetic(&xThresholds[i]);
+    }
+
+    xSetThresholds(xThresholds[0].on, xThresholds[0].off);
+    xTestNoisyLowUsage();
+
+    xSetThresholds(xThresholds[0].on, xThresholds[0].off);
+    for ( i = 1u; i < (unsigned)argc; i++ )
+    {
+        xTestFile(argv[i]);
+    }
+
+    printf("%s\n", (xFailures == 0) ? "PASS" : "FAIL");
+    return (xFailures == 0) ? 0 : 1;
+}
+
+static void xOldReset(void)
+{
+    memset(oldDaily, 0, sizeof(oldDaily));
+    oldIdx = 0u;
+    oldMonthPresent = false;
+    oldFlag = false;
+}
+
+static void xOldPopulateFake(void)
+{
+    int i;
+
+    for ( i = 0; i < OLD_DAYS; i++ )
+    {
+        oldDaily[i] = 3000 + (i * 2);
+    }
+
+    oldIdx = 0u;
+    oldMonthPresent = true;
+}
+
+static bool xOldUpdate(uint16_t liters, uint16_t * p_avg)
+{
+    uint32_t sum = 0u;
+    uint32_t avg;
+    uint8_t idx;
+
+    if ( oldMonthPresent == true )
+    {
+        for ( idx = (oldIdx % APP_STATS_DAYS_PER_WEEK); idx < OLD_DAYS; idx += APP_STATS_DAYS_PER_WEEK )
+        {
+            sum += oldDaily[idx];
+        }
+
+        avg = sum / OLD_WEEKS;
+        *p_avg = (uint16_t)avg;
+
+        if ( liters < ((avg * oldOnThreshold) / 100u) )
+        {
+            oldFlag = true;
+        }
+        else if ( oldFlag == true )
+        {
+            if ( liters >= ((avg * oldOffThreshold) / 100u) )
+            {
+                oldFlag = false;
+                oldDaily[oldIdx] = liters;
+            }
+        }
+        else
+        {
+            oldDaily[oldIdx] = liters;
+        }
+    }
+    else
+    {
+        oldDaily[oldIdx] = liters;
+        *p_avg = 0u;
+    }
+
+    oldIdx++;
+    if ( oldIdx >= OLD_DAYS )
+    {
+        oldIdx = 0u;
+        oldMonthPresent = true;
+    }
+
+    return oldFlag;
+}
+
+static void xSetThresholds(uint16_t on, uint16_t off)
+{
+    oldOnThreshold = on;
+    oldOffThreshold = off;
+    APP_STATS_SetThresholds(on, off);
+}
+
+static bool xNewUpdate(uint16_t liters, uint16_t * p_avg)
+{
+    return APP_STATS_UpdateDaily(liters, p_avg);
+}
+
+// What APP_ALGO_populateRedFlagArrayWithFakeData() does now
+static void xNewPopulateFake(void)
+{
+    int i;
+
+    APP_STATS_Reset();
+
+    for ( i = 0; i < OLD_DAYS; i++ )
+    {
+        APP_STATS_LearnDay(3000 + (i * 2));
+    }
+}
+
+// Numerical Recipes LCG, the same series on every host
+static uint32_t xRand(void)
+{
+    xSeed = (xSeed * 1664525u) + 1013904223u;
+    return xSeed >> 8;
+}
+
+static uint32_t xRange(uint32_t lo, uint32_t hi)
+{
+    return lo + (xRand() % (hi - lo + 1u));
+}
+
+static void xMakeSeries(series_t * p_series)
+{
+    static const int16_t weekdayPermille[APP_STATS_DAYS_PER_WEEK] = { 1080, 880, 1100, 1070, 1030, 980, 950 };
+    uint32_t base = xRange(1500u, 4000u);
+    uint32_t seasonPhase = xRange(0u, 364u);
+    uint32_t nextEvent = xRange(FIRST_EVENT_DAY, FIRST_EVENT_DAY + 60u);
+    uint32_t eventEnd = 0u;
+    uint32_t eventLevel = 1000u;
+    eventType_t eventType = EVENT_NONE;
+    uint32_t day;
+    int32_t permille;
+    int32_t season;
+    int32_t noise;
+    int i;
+
+    p_series->days = SERIES_DAYS;
+
+    for ( day = 0u; day < SERIES_DAYS; day++ )
+    {
+        if ( day == nextEvent )
+        {
+            if ( (xRand() & 1u) == 0u )
+            {
+                eventType = EVENT_FULL;
+                eventLevel = xRange(0u, 30u);
+                eventEnd = day + xRange(2u, 21u);
+            }
+            else
+            {
+                eventType = EVENT_PARTIAL;
+                eventLevel = xRange(550u, 720u);
+                eventEnd = day + xRange(14u, 60u);
+            }
+        }
+
+        if ( (eventType != EVENT_NONE) && (day >= eventEnd) )
+        {
+            eventType = EVENT_NONE;
+            eventLevel = 1000u;
+            nextEvent = day + xRange(45u, 150u);
+        }
+
+        //weekday pattern, +/-15% over the year (wet and dry seasons), roughly 8% day to day noise
+        permille = weekdayPermille[day % APP_STATS_DAYS_PER_WEEK];
+        season = (int32_t)((day + seasonPhase) % 365u);
+        permille += (season < 182) ? (((season * 300) / 182) - 150) : (150 - (((season - 182) * 300) / 183));
+        noise = 0;
+        for ( i = 0; i < 4; i++ )
+        {
+            noise += (int32_t)xRange(0u, 140u) - 70;
+        }
+        permille += noise;
+
+        //a market day, a holiday, a wedding: a low day now and then that isn't a breakdown
+        if ( (eventType == EVENT_NONE) && (xRange(0u, 59u) == 0u) )
+        {
+            permille = (permille * (int32_t)xRange(300u, 650u)) / 1000;
+        }
+
+        permille = (permille * (int32_t)eventLevel) / 1000;
+        if ( permille < 0 )
+        {
+            permille = 0;
+        }
+
+        p_series->liters[day] = (uint16_t)((base * (uint32_t)permille) / 1000u);
+        p_series->event[day] = (uint8_t)eventType;
+    }
+}
+
+static void xReplay(const series_t * p_series, detector_t detector, result_t * p_result)
+{
+    uint16_t avg;
+    uint16_t day;
+    uint16_t onset = 0u;
+    bool flag;
+    bool lastFlag = false;
+    bool counted = false;
+
+    for ( day = 0u; day < p_series->days; day++ )
+    {
+        eventType_t type = (eventType_t)p_series->event[day];
+
+        if ( (type != EVENT_NONE) && ((day == 0u) || (p_series->event[day - 1u] != type)) )
+        {
+            onset = day;
+            counted = false;
+            p_result->events[type]++;
+        }
+
+        flag = detector(p_series->liters[day], &avg);
+
+        if ( type == EVENT_NONE )
+        {
+            p_result->normalDays++;
+
+            if ( (flag == true) && (lastFlag == false) )
+            {
+                p_result->falseAlarms++;
+            }
+        }
+        else if ( (flag == true) && (counted == false) )
+        {
+            counted = true;
+            p_result->detected[type]++;
+            p_result->delaySum[type] += (uint32_t)(day - onset);
+
+            if ( (uint32_t)(day - onset) > p_result->delayMax[type] )
+            {
+                p_result->delayMax[type] = (uint32_t)(day - onset);
+            }
+        }
+
+        lastFlag = flag;
+    }
+}
+
+static void xReport(const char * p_name, const result_t * p_result, double years)
+{
+    static const char * const typeName[EVENT_TYPES] = { "", "full", "partial" };
+    int type;
+
+    printf("  %-8s", p_name);
+
+    for ( type = EVENT_FULL; type < EVENT_TYPES; type++ )
+    {
+        printf("  %s %4u/%-4u delay mean %5.2f max %2u d", typeName[type],
+               p_result->detected[type], p_result->events[type],
+               (p_result->detected[type] != 0u) ? (double)p_result->delaySum[type] / p_result->detected[type] : 0.0,
+               p_result->delayMax[type]);
+    }
+
+    printf("  false alarms %4u (%.2f/yr)\n", p_result->falseAlarms, p_result->falseAlarms / years);
+}
+
+static void xCheck(bool ok, const char * p_what)
+{
+    if ( ok == false )
+    {
+        printf("  FAILED: %s\n", p_what);
+        xFailures++;
+    }
+}
+
+// APP_ALGO_populateRedFlagArrayWithFakeData() fills 4 weeks of about 3000 liters a day, the next day
+// then has no water and must raise the flag at midnight. A normal day after must not.
+static void xTestFakeMonth(void)
+{
+    uint16_t oldAvg;
+    uint16_t newAvg;
+    bool oldOn;
+    bool newOn;
+    int day;
+
+    printf("fake month\n");
+
+    xOldReset();
+    xOldPopulateFake();
+    xNewPopulateFake();
+
+    oldOn = xOldUpdate(0u, &oldAvg);
+    newOn = xNewUpdate(0u, &newAvg);
+    printf("  zero day: old flag %d avg %u, new flag %d avg %u\n", oldOn, oldAvg, newOn, newAvg);
+    xCheck((oldOn == true) && (newOn == true), "fake month then a dry day raises the flag");
+    xCheck(abs((int)newAvg - (int)oldAvg) <= (int)(oldAvg / 100u), "same weekday average within 1%");
+
+    for ( day = 0; day < 3; day++ )
+    {
+        oldOn = xOldUpdate(3000u, &oldAvg);
+        newOn = xNewUpdate(3000u, &newAvg);
+    }
+    printf("  3000 liter days: old flag %d, new flag %d\n", oldOn, newOn);
+    xCheck((oldOn == false) && (newOn == false), "a normal day clears the flag");
+
+    xOldReset();
+    xOldPopulateFake();
+    xNewPopulateFake();
+
+    for ( day = 0; day < 56; day++ )
+    {
+        oldOn = xOldUpdate((uint16_t)(2950u + (day % 5) * 25u), &oldAvg);
+        newOn = xNewUpdate((uint16_t)(2950u + (day % 5) * 25u), &newAvg);
+        xCheck((oldOn == false) && (newOn == false), "no flag on 8 normal weeks after the fake month");
+    }
+}
+
+static void xTestSynthetic(const thresholds_t * p_thresholds)
+{
+    static series_t series;
+    result_t oldResult;
+    result_t newResult;
+    double years;
+    int n;
+
+    printf("synthetic, %d series of %d days, on %u%% off %u%%%s\n", SERIES_COUNT, SERIES_DAYS,
+           p_thresholds->on, p_thresholds->off, (p_thresholds->checked == true) ? "" : " (reported only)");
+
+    xSetThresholds(p_thresholds->on, p_thresholds->off);
+
+    memset(&oldResult, 0, sizeof(oldResult));
+    memset(&newResult, 0, sizeof(newResult));
+
+    for ( n = 0; n < SERIES_COUNT; n++ )
+    {
+        xSeed = 26u + (uint32_t)n;
+        xMakeSeries(&series);
+
+        xOldReset();
+        xReplay(&series, xOldUpdate, &oldResult);
+
+        APP_STATS_Reset();
+        xReplay(&series, xNewUpdate, &newResult);
+    }
+
+    years = (double)newResult.normalDays / DAYS_PER_YEAR;
+    xReport("old", &oldResult, years);
+    xReport("new", &newResult, years);
+
+    xCheck(newResult.detected[EVENT_FULL] >= oldResult.detected[EVENT_FULL], "every full breakdown the old one saw");
+    xCheck(newResult.delayMax[EVENT_FULL] <= oldResult.delayMax[EVENT_FULL], "full breakdowns no later");
+    xCheck(newResult.detected[EVENT_PARTIAL] >= oldResult.detected[EVENT_PARTIAL], "every partial breakdown count the old one had");
+
+    if ( p_thresholds->checked == true )
+    {
+        xCheck(newResult.falseAlarms <= oldResult.falseAlarms + (oldResult.falseAlarms / 10u), "false alarms within 10% of the old");
+    }
+}
+
+static void xTestFile(const char * p_path)
+{
+    static series_t series;
+    result_t oldResult;
+    result_t newResult;
+    FILE * p_file = fopen(p_path, "r");
+    char line[64];
+    unsigned liters;
+    unsigned broken;
+
+    printf("%s\n", p_path);
+
+    if ( p_file == NULL )
+    {
+        xCheck(false, "can't open the series");
+        return;
+    }
+
+    series.days = 0u;
+    while ( (fgets(line, sizeof(line), p_file) != NULL) && (series.days < MAX_DAYS) )
+    {
+        broken = 0u;
+        if ( sscanf(line, "%u,%u", &liters, &broken) >= 1 )
+        {
+            series.liters[series.days] = (uint16_t)liters;
+            series.event[series.days] = (broken != 0u) ? EVENT_FULL : EVENT_NONE;
+            series.days++;
+        }
+    }
+    fclose(p_file);
+
+    memset(&oldResult, 0, sizeof(oldResult));
+    memset(&newResult, 0, sizeof(newResult));
+    xOldReset();
+    xReplay(&series, xOldUpdate, &oldResult);
+    APP_STATS_Reset();
+    xReplay(&series, xNewUpdate, &newResult);
+
+    xReport("old", &oldResult, (double)newResult.normalDays / DAYS_PER_YEAR);
+    xReport("new", &newResult, (double)newResult.normalDays / DAYS_PER_YEAR);
+}
+
+// Market days 220 to 380 liters, the other days 4 to 8. No breakdowns, so a flag raised on a day at or
+// above the on level can only come from the change detector.
+static void xTestNoisyLowUsage(void)
+{
+    static const bool marketDay[APP_STATS_DAYS_PER_WEEK] = { true, false, true, false, false, true, false };
+    uint32_t cusumFlags = 0u;
+    uint32_t onLevelFlags = 0u;
+    uint16_t liters;
+    uint16_t avg;
+    bool wasOn;
+    bool on;
+    int n;
+    int day;
+
+    printf("noisy low usage, %d wells of %d days, on %u%% off %u%%\n", NOISY_WELLS, NOISY_DAYS,
+           xThresholds[0].on, xThresholds[0].off);
+
+    for ( n = 0; n < NOISY_WELLS; n++ )
+    {
+        xSeed = 7000u + (uint32_t)n;
+        APP_STATS_Reset();
+        wasOn = false;
+
+        for ( day = 0; day < NOISY_DAYS; day++ )
+        {
+            if ( marketDay[day % APP_STATS_DAYS_PER_WEEK] == true )
+            {
+                liters = (uint16_t)xRange(220u, 380u);
+            }
+            else
+            {
+                liters = (uint16_t)xRange(4u, 8u);
+            }
+
+            on = APP_STATS_UpdateDaily(liters, &avg);
+
+            if ( (on == true) && (wasOn == false) )
+            {
+                if ( ((uint32_t)liters * 100u) >= ((uint32_t)avg * xThresholds[0].on) )
+                {
+                    cusumFlags++;
+                }
+                else
+                {
+                    onLevelFlags++;
+                }
+            }
+
+            wasOn = on;
+        }
+    }
+
+    printf("  flags: %u under the on level, %u from the change detector\n", onLevelFlags, cusumFlags);
+    xCheck(cusumFlags == 0u, "no change detector flag on a noisy low usage well");
+}
@@ -0,0 +1,587 @@
+/**************************************************************************************************
+* \file     test_strk.c
+* \brief    Host test of APP_STRK against the generated detectTransitions() and detectStrokes()
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "host_ssm.h"
+#include "APP_ALGO.h"
+#include "APP_CKPT.h"
+#include "APP_STRK.h"
+#include "HW_TRACE.h"
+#include "uC_TIME.h"
+#include "algo-c-code/detectTransitions/detectTransitions.h"
+#include "algo-c-code/detectStrokes/detectStrokes.h"
+#include "algo-c-code/hourlyStrokeCount/hourlyStrokeCount.h"
+#include "algo-c-code/initializeStrokeAlgorithm/initializeStrokeAlgorithm.h"
+
+// Replays synthetic pump sessions through the real APP_ALGO and checks that APP_STRK finds the same
+// transitions and strokes, in the same order, as the generated detectTransitions() and detectStrokes()
+// it replaced. APP_STRK_AcceptWindow() is wrapped to run the generated pair on the window first, with
+// their own state, as APP_ALGO did before. APP_STRK's TRACE_TRANSITION and TRACE_STROKE records are
+// caught here and matched one by one against what the generated code put in its buffers. The
+// accumulated counts have to match at every checkpoint and every hourly readout.
+//
+// After the magnetometer has calibrated, the sessions go through normal, hard and high rate pumping
+// (3.3 strokes a second, about six samples a stroke) and a stress session: pumping with samples on the
+// rails, jumps, flat runs and wobble, so the 16 bit sums wrap and the detector drops back to no
+// activity. The generated buffers hold 30 entries a window, if they had overflowed the outputs would
+// differ by design, so that has to not happen.
+//
+// The generated percent, (from - to) * 100L / range, subtracts in int. The target's int is 16 bits, so
+// where the rails make the difference pass +-32767 it wraps on the part and not here. The wrapper works
+// that percent out again with the target's int for each stroke the generated code found (APP_STRK does
+// the same), and moves the accumulated sums to match.
+//
+// Usage: test_strk
+
+#define SYNTH_HOURS                 6u
+#define WARM_UP_HOURS               2u
+#define MS_PER_HOUR                 3600000ul
+#define SAMPLES_PER_HOUR            (MS_PER_HOUR / HOST_MS_PER_SAMPLE)
+
+#define SESSION_EVERY_MS            (6ul * 60ul * 1000ul)
+#define NUM_WARM_UP_TYPES           3u
+#define NUM_SESSION_TYPES           5u
+#define WATER_DEPTH_PADS            7.2
+#define PAD_DRY_COUNT               1200
+#define PAD_WET_DROP                260
+#define REST_X                      1500
+#define REST_Y                      -800
+#define REST_Z                      300
+#define MAG_STATUS_NEW_DATA         15u
+
+#define MAX_EVENTS                  200000u
+#define MIN_HIGH_RATE_STROKES       1000u
+
+typedef enum
+{
+    SESSION_PLAIN,
+    SESSION_HIGH_RATE,
+    SESSION_STRESS,
+}sessionKind_t;
+
+typedef struct
+{
+    double strokeHz;
+    uint32_t lengthMs;
+    bool water;
+    bool active;            // somebody at the pump, the pad proximity wakes the algorithm
+    sessionKind_t kind;
+}sessionType_t;
+
+// What the generated code found and what APP_STRK traced, in order
+typedef struct
+{
+    strokeTransition_t transitions[MAX_EVENTS];
+    stroke_t strokes[MAX_EVENTS];
+    uint32_t numTransitions;
+    uint32_t numStrokes;
+}eventList_t;
+
+static const sessionType_t xWarmUpTypes[NUM_WARM_UP_TYPES] =
+{
+    { 1.5, 200000ul, true,  true,  SESSION_PLAIN },
+    { 2.4, 150000ul, true,  true,  SESSION_PLAIN },
+    { 1.0, 240000ul, true,  true,  SESSION_PLAIN },
+};
+
+static const sessionType_t xSessionTypes[NUM_SESSION_TYPES] =
+{
+    { 1.5, 200000ul, true,  true,  SESSION_PLAIN },
+    { 3.3, 150000ul, true,  true,  SESSION_HIGH_RATE },
+    { 1.8, 200000ul, true,  true,  SESSION_STRESS },
+    { 2.4, 150000ul, true,  true,  SESSION_PLAIN },
+    { 1.5,  20000ul, false, false, SESSION_PLAIN },     // the handle knocked
+};
+
+// The generated detectors, run beside APP_STRK
+static strokeTransitionInfo_t xGenTransitionInfo;
+static strokeTransitionBuffer_t xGenTransitions;
+static strokeDetectInfo_t xGenStrokeInfo;
+static strokeBuffer_t xGenStrokes;
+static accumStrokeCount_t xGenAccum;
+
+static eventList_t xGen;
+static eventList_t xNew;
+static uint32_t xTransitionMismatches = 0u;
+static uint32_t xStrokeMismatches = 0u;
+static uint32_t xGenOverflows = 0u;
+static uint32_t xWrappedPercents = 0u;
+static uint32_t xPairingErrors = 0u;
+static uint32_t xWindows = 0u;
+static uint32_t xCalibratedWindows = 0u;
+static uint32_t xAccumChecks = 0u;
+static uint32_t xAccumMismatches = 0u;
+static uint32_t xHighRateStrokes = 0u;
+static uint32_t xStressStrokes = 0u;
+static sessionKind_t xKind = SESSION_PLAIN;
+
+extern void __real_APP_STRK_AcceptWindow(const magWindows_t * p_windows, const magCalibration_t * p_calib,
+                                         const waterAlgoData_t * p_water, accumStrokeCount_t * p_accum);
+void __wrap_APP_STRK_AcceptWindow(const magWindows_t * p_windows, const magCalibration_t * p_calib,
+                                  const waterAlgoData_t * p_water, accumStrokeCount_t * p_accum);
+extern void __real_hourlyStrokeCount(accumStrokeCount_t * accum_stroke_count, hourlyStrokeInfo_t * hourly_stroke_info);
+void __wrap_hourlyStrokeCount(accumStrokeCount_t * accum_stroke_count, hourlyStrokeInfo_t * hourly_stroke_info);
+extern bool __real_APP_CKPT_Save(const waterAlgoData_t * p_algoData, const waterCalibration_t * p_waterCalibration,
+                                 const magCalibration_t * p_magCalibration, const pumpUsage_t * p_pumpUsage,
+                                 const accumStrokeCount_t * p_strokeCount, const hourlyPumpHealthInfo_t * p_pumpHealth,
+                                 uint32_t epoch);
+bool __wrap_APP_CKPT_Save(const waterAlgoData_t * p_algoData, const waterCalibration_t * p_waterCalibration,
+                          const magCalibration_t * p_magCalibration, const pumpUsage_t * p_pumpUsage,
+                          const accumStrokeCount_t * p_strokeCount, const hourlyPumpHealthInfo_t * p_pumpHealth,
+                          uint32_t epoch);
+
+static void xTargetPercents(strokeTransition_t last, const magCalibration_t * p_calib);
+static void xCheckAccum(const accumStrokeCount_t * p_accum);
+static void xReplay(void);
+static const sessionType_t * xSessionAt(uint64_t ms);
+static void xSynthRow(uint32_t sample, hostCaptureRow_t * p_row);
+static void xStressMag(uint32_t sample, double phase, hostCaptureRow_t * p_row);
+static uint32_t xHash(uint32_t value);
+static bool xCheck(bool condition, const char * p_what);
+
+// The generated pair sees the window as it is handed over, APP_STRK reads it over the next nest runs
+void __wrap_APP_STRK_AcceptWindow(const magWindows_t * p_windows, const magCalibration_t * p_calib,
+                                  const waterAlgoData_t * p_water, accumStrokeCount_t * p_accum)
+{
+    strokeTransition_t last;
+    uint8_T i;
+
+    if ( detectTransitions(p_windows, p_calib, &xGenTransitions, &xGenTransitionInfo) != reason_code_none )
+    {
+        xGenOverflows++;
+    }
+
+    last = xGenStrokeInfo.last_transition;
+
+    if ( detectStrokes(&xGenTransitions, &xGenStrokes, &xGenStrokeInfo, &xGenAccum, p_calib, p_water) != reason_code_none )
+    {
+        xGenOverflows++;
+    }
+
+    xTargetPercents(last, p_calib);
+
+    for ( i = 0u; (i < xGenTransitions.idx) && (xGen.numTransitions < MAX_EVENTS); i++ )
+    {
+        xGen.transitions[xGen.numTransitions++] = xGenTransitions.buff[i];
+    }
+
+    for ( i = 0u; (i < xGenStrokes.idx) && (xGen.numStrokes < MAX_EVENTS); i++ )
+    {
+        xGen.strokes[xGen.numStrokes++] = xGenStrokes.buff[i];
+    }
+
+    if ( xKind == SESSION_HIGH_RATE )
+    {
+        xHighRateStrokes += xGenStrokes.idx;
+    }
+    else if ( xKind == SESSION_STRESS )
+    {
+        xStressStrokes += xGenStrokes.idx;
+    }
+
+    if ( (p_calib->magnet_present != 0u) && (p_calib->orientation_calibrated != 0u) && (p_calib->offset_calibrated != 0u) )
+    {
+        xCalibratedWindows++;
+    }
+
+    xWindows++;
+    __real_APP_STRK_AcceptWindow(p_windows, p_calib, p_water, p_accum);
+}
+
+// APP_ALGO drains APP_STRK before the readout, the generated counts are as of the same window
+void __wrap_hourlyStrokeCount(accumStrokeCount_t * accum_stroke_count, hourlyStrokeInfo_t * hourly_stroke_info)
+{
+    hourlyStrokeInfo_t genInfo;
+
+    memset(&genInfo, 0, sizeof(genInfo));
+    xCheckAccum(accum_stroke_count);
+    __real_hourlyStrokeCount(accum_stroke_count, hourly_stroke_info);
+    __real_hourlyStrokeCount(&xGenAccum, &genInfo);
+
+    if ( memcmp(&genInfo, hourly_stroke_info, sizeof(genInfo)) != 0 )
+    {
+        xAccumMismatches++;
+    }
+}
+
+bool __wrap_APP_CKPT_Save(const waterAlgoData_t * p_algoData, const waterCalibration_t * p_waterCalibration,
+                          const magCalibration_t * p_magCalibration, const pumpUsage_t * p_pumpUsage,
+                          const accumStrokeCount_t * p_strokeCount, const hourlyPumpHealthInfo_t * p_pumpHealth,
+                          uint32_t epoch)
+{
+    xCheckAccum(p_strokeCount);
+
+    return __real_APP_CKPT_Save(p_algoData, p_waterCalibration, p_magCalibration, p_pumpUsage, p_strokeCount,
+                                p_pumpHealth, epoch);
+}
+
+// APP_STRK's records, each one is matched against the generated event at the same place in the order
+void HW_TRACE_Log(hwTraceEvent_t event, uint8_t numArgs, uint16_t arg0, uint16_t arg1, uint16_t arg2, uint16_t arg3)
+{
+    const strokeTransition_t * p_transition;
+    const stroke_t * p_stroke;
+
+    (void)numArgs;
+    (void)arg3;
+
+    if ( event == TRACE_TRANSITION )
+    {
+        p_transition = &xGen.transitions[xNew.numTransitions];
+
+        if ( (xNew.numTransitions >= xGen.numTransitions) || (p_transition->type != (TransitionType)arg0) ||
+             (p_transition->val != (int16_T)arg1) || (p_transition->idx != (int16_T)arg2) )
+        {
+            if ( xTransitionMismatches == 0u )
+            {
+                printf("  transition %u: APP_STRK %u %d %d, generated %u %d %d\n", xNew.numTransitions, arg0,
+                       (int16_T)arg1, (int16_T)arg2, p_transition->type, p_transition->val, p_transition->idx);
+            }
+
+            xTransitionMismatches++;
+        }
+
+        xNew.numTransitions++;
+    }
+    else if ( event == TRACE_STROKE )
+    {
+        p_stroke = &xGen.strokes[xNew.numStrokes];
+
+        if ( (xNew.numStrokes >= xGen.numStrokes) || (p_stroke->idx != (int16_T)arg0) ||
+             (p_stroke->percent_displacement != (int16_T)arg1) || (p_stroke->dry != (uint8_T)arg2) )
+        {
+            if ( xStrokeMismatches == 0u )
+            {
+                printf("  stroke %u: APP_STRK %d %d%% dry %u, generated %d %d%% dry %u\n", xNew.numStrokes,
+                       (int16_T)arg0, (int16_T)arg1, arg2, p_stroke->idx, p_stroke->percent_displacement, p_stroke->dry);
+            }
+
+            xStrokeMismatches++;
+        }
+
+        xNew.numStrokes++;
+    }
+}
+
+int main(void)
+{
+    bool pass = true;
+
+    printf("replaying %u synthetic hours, %u of them normal pumping while the magnetometer calibrates\n",
+           SYNTH_HOURS, WARM_UP_HOURS);
+
+    xReplay();
+
+    printf("  %u windows, %u with the magnetometer calibrated\n", xWindows, xCalibratedWindows);
+    printf("  transitions: generated %u, APP_STRK %u, %u differ\n", xGen.numTransitions, xNew.numTransitions,
+           xTransitionMismatches);
+    printf("  strokes: generated %u (%u high rate, %u stress), APP_STRK %u, %u differ\n", xGen.numStrokes,
+           xHighRateStrokes, xStressStrokes, xNew.numStrokes, xStrokeMismatches);
+    printf("  %u percents wrap with the target's 16 bit int, %u strokes not paired as the generated code did\n",
+           xWrappedPercents, xPairingErrors);
+    printf("  accumulated counts checked %u times, %u differ\n\n", xAccumChecks, xAccumMismatches);
+
+    pass &= xCheck((xCalibratedWindows * 2u) > xWindows, "the magnetometer is calibrated for most of the windows");
+    pass &= xCheck((xGen.numTransitions < MAX_EVENTS) && (xGen.numStrokes < MAX_EVENTS), "every event is kept");
+    pass &= xCheck(xGenOverflows == 0u, "the generated buffers never overflow");
+    pass &= xCheck(xPairingErrors == 0u, "every generated stroke is a pair of its transitions");
+    pass &= xCheck(xWrappedPercents > 0u, "the stress sessions wrap the percent difference");
+    pass &= xCheck(xHighRateStrokes >= MIN_HIGH_RATE_STROKES, "high rate pumping is counted");
+    pass &= xCheck(xStressStrokes > 0u, "the stress sessions are counted");
+    pass &= xCheck((xTransitionMismatches == 0u) && (xNew.numTransitions == xGen.numTransitions),
+                   "the same transitions, in the same order");
+    pass &= xCheck((xStrokeMismatches == 0u) && (xNew.numStrokes == xGen.numStrokes),
+                   "the same strokes, in the same order, wet and dry");
+    pass &= xCheck((xAccumChecks >= (SYNTH_HOURS * 60u)) && (xAccumMismatches == 0u),
+                   "the same accumulated counts at every checkpoint and hourly readout");
+
+    printf("%s\n", (pass == true) ? "PASS" : "FAIL");
+
+    return (pass == true) ? 0 : 1;
+}
+
+static bool xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+
+    return condition;
+}
+
+// Goes through the window's transitions in pairs as detectStrokes() does, starting from the last one of
+// the window before, to get the two values of each stroke it found
+static void xTargetPercents(strokeTransition_t last, const magCalibration_t * p_calib)
+{
+    strokeTransition_t prev = last;
+    const strokeTransition_t * p_next;
+    stroke_t * p_stroke;
+    int16_t range = (int16_t)(p_calib->max_val - p_calib->min_val);
+    int16_t percent;
+    uint32_T * p_sum;
+    uint8_T next = 0u;
+    uint8_T stroke = 0u;
+
+    if ( xGenTransitions.idx == 0u )
+    {
+        return;
+    }
+
+    if ( prev.type == no_transition )
+    {
+        prev = xGenTransitions.buff[0];
+        next = 1u;
+    }
+
+    for ( ; (next < xGenTransitions.idx) && (stroke < xGenStrokes.idx); next++ )
+    {
+        p_next = &xGenTransitions.buff[next];
+
+        if ( ((prev.type == transition_peak) && (p_next->type == transition_valley)) ||
+             ((prev.type == transition_valley) && (p_next->type == transition_peak)) )
+        {
+            p_stroke = &xGenStrokes.buff[stroke++];
+
+            //the stroke's value is the mean of the two, with no wrap on the host
+            if ( (p_stroke->val != (int16_T)((prev.val + p_next->val) >> 1)) ||
+                 (p_stroke->type != ((prev.type == transition_peak) ? rod_up : rod_down)) )
+            {
+                xPairingErrors++;
+            }
+
+            percent = (range > 0) ? (int16_t)(((int32_t)(int16_t)(prev.val - p_next->val) * 100L) / range) : 0;
+
+            if ( percent != p_stroke->percent_displacement )
+            {
+                p_sum = (p_stroke->dry != 0u) ? &xGenAccum.dry_percent_displacement_sum : &xGenAccum.wet_percent_displacement_sum;
+                *p_sum = *p_sum - (uint32_T)abs(p_stroke->percent_displacement) + (uint32_T)abs(percent);
+                p_stroke->percent_displacement = percent;
+                xWrappedPercents++;
+            }
+        }
+
+        prev = *p_next;
+    }
+
+    if ( stroke != xGenStrokes.idx )
+    {
+        xPairingErrors++;
+    }
+}
+
+static void xCheckAccum(const accumStrokeCount_t * p_accum)
+{
+    if ( (p_accum->num_windows_processed != xGenAccum.num_windows_processed) ||
+         (p_accum->wet_stroke_count_sum != xGenAccum.wet_stroke_count_sum) ||
+         (p_accum->wet_percent_displacement_sum != xGenAccum.wet_percent_displacement_sum) ||
+         (p_accum->dry_stroke_count_sum != xGenAccum.dry_stroke_count_sum) ||
+         (p_accum->dry_percent_displacement_sum != xGenAccum.dry_percent_displacement_sum) ||
+         (p_accum->mag_calibration_changed != xGenAccum.mag_calibration_changed) )
+    {
+        xAccumMismatches++;
+    }
+
+    xAccumChecks++;
+}
+
+// Boots as APP.c does and runs the nest every 50 ms
+static void xReplay(void)
+{
+    APP_NVM_SENSOR_DATA_T sensorData;
+    hostCaptureRow_t row;
+    bool wasActive = false;
+    uint32_t sample;
+    uint32_t hour;
+
+    memset(&sensorData, 0, sizeof(sensorData));
+    initializeStrokeAlgorithm(&xGenTransitionInfo, &xGenStrokeInfo, &xGenAccum);
+
+    APP_ALGO_setStrokeDetectionIsOn(true);
+    APP_ALGO_Init();
+
+    for ( sample = 0u; sample < (SYNTH_HOURS * SAMPLES_PER_HOUR); sample++ )
+    {
+        HOST_SetTimeMs((uint64_t)sample * HOST_MS_PER_SAMPLE);
+        xSynthRow(sample, &row);
+        HOST_SetRow(&row);
+
+        //APP_setPumpActive()
+        if ( (row.active == true) && (wasActive == false) )
+        {
+            APP_ALGO_wakeUpInit();
+        }
+
+        wasActive = row.active;
+        APP_ALGO_Nest(row.active);
+
+        if ( ((sample + 1u) % SAMPLES_PER_HOUR) == 0u )
+        {
+            hour = sample / SAMPLES_PER_HOUR;
+            APP_ALGO_updateHourlyFields(&sensorData, (uint8_t)(hour % HOUR_PER_DAY));
+        }
+    }
+
+    //the last window, read out as at the end of an hour
+    APP_ALGO_calculateHourlyStrokes();
+}
+
+static const sessionType_t * xSessionAt(uint64_t ms)
+{
+    uint32_t session = (uint32_t)(ms / SESSION_EVERY_MS);
+
+    if ( ms < (WARM_UP_HOURS * MS_PER_HOUR) )
+    {
+        return &xWarmUpTypes[session % NUM_WARM_UP_TYPES];
+    }
+
+    return &xSessionTypes[session % NUM_SESSION_TYPES];
+}
+
+// One 50 ms row: sessions every 6 minutes, the water rises up the pads from pad8 and sloshes with each
+// stroke of the magnet on the handle, as in test_ckpt
+static void xSynthRow(uint32_t sample, hostCaptureRow_t * p_row)
+{
+    uint64_t ms = (uint64_t)sample * HOST_MS_PER_SAMPLE;
+    const sessionType_t * p_type = xSessionAt(ms);
+    double sec = (double)(ms % SESSION_EVERY_MS) / 1000.0;
+    double lengthSec = p_type->lengthMs / 1000.0;
+    double phase = 2.0 * M_PI * p_type->strokeHz * sec;
+    bool pumping = (sec < lengthSec);
+    double level = 0.0;
+    double cover;
+    uint32_t noise;
+    int i;
+
+    xKind = p_type->kind;
+
+    if ( p_type->water == true )
+    {
+        if ( pumping == true )
+        {
+            level = fmin(WATER_DEPTH_PADS, sec / 3.0) + ((sec > 25.0) ? (0.6 * sin(phase)) : 0.0);
+        }
+        else
+        {
+            level = fmax(0.0, WATER_DEPTH_PADS - ((sec - lengthSec) / 4.0));
+        }
+    }
+
+    memset(p_row, 0, sizeof(hostCaptureRow_t));
+    p_row->tick = sample;
+    p_row->strokes = true;
+    p_row->active = (p_type->active == true) && ((pumping == true) || (level > 0.0));
+
+    //pad8 is at the bottom and covers first
+    for ( i = 0; i < HOST_NUM_PADS; i++ )
+    {
+        cover = fmin(1.0, fmax(0.0, level - (HOST_NUM_PADS - 1 - i)));
+        noise = xHash((sample * HOST_NUM_PADS) + (uint32_t)i);
+        p_row->pads[i] = (int16_t)(PAD_DRY_COUNT + (10 * i) - (int)(PAD_WET_DROP * cover) + (int)(noise % 5u) - 2);
+
+        if ( cover > 0.0 )
+        {
+            p_row->pads[i] += (int16_t)((int)((noise >> 8) % 13u) - 6);
+        }
+    }
+
+    noise = xHash((uint32_t)ms);
+
+    if ( pumping == true )
+    {
+        p_row->magX = (int16_t)(REST_X + (int)(420.0 * sin(phase)) + (int)(noise % 7u) - 3);
+        p_row->magY = (int16_t)(REST_Y + (int)(260.0 * sin(phase + 0.4)) + (int)((noise >> 8) % 7u) - 3);
+        p_row->magZ = (int16_t)(REST_Z + (int)(330.0 * sin(phase)) + (int)((noise >> 16) % 7u) - 3);
+
+        if ( p_type->kind == SESSION_STRESS )
+        {
+            xStressMag(sample, phase, p_row);
+        }
+    }
+    else
+    {
+        p_row->magX = (int16_t)(REST_X + (int)(noise % 5u) - 2);
+        p_row->magY = (int16_t)(REST_Y + (int)((noise >> 8) % 5u) - 2);
+        p_row->magZ = (int16_t)(REST_Z + (int)((noise >> 16) % 5u) - 2);
+    }
+
+    p_row->magTemp = 2400;
+    p_row->magStatus = MAG_STATUS_NEW_DATA;
+}
+
+// The stress session goes through a few seconds of each: plain strokes, an axis on a rail now and then,
+// jumps of up to +-2000, the sample held flat, and a small wobble that never makes a stroke
+static void xStressMag(uint32_t sample, double phase, hostCaptureRow_t * p_row)
+{
+    uint32_t noise = xHash(sample ^ 0x5EEDu);
+    uint32_t part = (sample / 60u) % 5u;
+    int16_t * p_axis = (noise % 3u == 0u) ? &p_row->magX : ((noise % 3u == 1u) ? &p_row->magY : &p_row->magZ);
+
+    switch ( part )
+    {
+        case 1u:
+            if ( ((noise >> 4) % 7u) == 0u )
+            {
+                *p_axis = ((noise & 0x100u) != 0u) ? INT16_MAX : INT16_MIN;
+            }
+            break;
+
+        case 2u:
+            if ( ((noise >> 4) % 5u) == 0u )
+            {
+                *p_axis = (int16_t)(*p_axis + (int)((noise >> 8) % 4001u) - 2000);
+            }
+            break;
+
+        case 3u:
+            //held for a few samples at a time
+            if ( ((sample / 4u) % 2u) == 0u )
+            {
+                p_row->magX = (int16_t)(REST_X + 420);
+                p_row->magY = (int16_t)(REST_Y + 260);
+                p_row->magZ = (int16_t)(REST_Z + 330);
+            }
+            break;
+
+        case 4u:
+            p_row->magX = (int16_t)(REST_X + (int)(40.0 * sin(phase * 3.0)) + (int)(noise % 31u) - 15);
+            p_row->magY = (int16_t)(REST_Y + (int)(25.0 * sin(phase * 3.0)));
+            p_row->magZ = (int16_t)(REST_Z + (int)(30.0 * sin(phase * 3.0)));
+            break;
+
+        default:
+            break;
+    }
+}
+
+static uint32_t xHash(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x7FEB352Du;
+    value ^= value >> 15;
+    value *= 0x846CA68Bu;
+    value ^= value >> 16;
+
+    return value;
+}
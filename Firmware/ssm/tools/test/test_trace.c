@@ -0,0 +1,582 @@
+/**************************************************************************************************
+* \file     test_trace.c
+* \brief    Host test of the trace records and the terminal TX ring, and of the main loop jitter with tracing on
+*
+* \par      Copyright Notice
+*           Copyright 2021 charity: water
+*
+*           Licensed under the Apache License, Version 2.0 (the "License");
+*           you may not use this file except in compliance with the License.
+*           You may obtain a copy of the License at
+*
+*               http://www.apache.org/licenses/LICENSE-2.0
+*
+*           Unless required by applicable law or agreed to in writing, software
+*           distributed under the License is distributed on an "AS IS" BASIS,
+*           WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*           See the License for the specific language governing permissions and
+*           limitations under the License.
+*
+* \date     10/18/2026
+* \author   Twisthink
+*
+***************************************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <msp430.h>
+#include "driverlib.h"
+#include "host_ssm.h"
+#include "HW_TRACE.h"
+#include "uC_UART.h"
+
+// Runs HW_TRACE.c and uC_UART.c against a simulated eUSCI_A0 at 9600 baud with MCLK counted in cycles. The
+// shift register takes a character time per byte, TXBUF holds one more, and the TX interrupt runs whenever
+// it is enabled and TXBUF is empty, stretching whatever the background loop was doing. Every byte that
+// leaves the shift register is kept as the wire capture.
+//
+// traces/trace_capture.bin is what the fixed sequence below puts on the wire: terminal text with records
+// between it, records dropped while the ring is full and the TRACE_DROPPED record that reports them.
+// It was recorded with --record and has to come out byte for byte. test_trace_decode.py decodes it with
+// ssm_trace_decode.py.
+//
+// Then 10 minutes of the background loop: the algorithm every 50 ms tick, a status line every second, a
+// burst of CLI output every 15 s and the hour rollover every minute, with tracing off, with the field
+// events, and with a record every tick. The lateness of each tick against its 50 ms slot is the jitter,
+// tracing must not add to it. The CPU costs of the work around the driver are estimates for the 16 MHz part.
+//
+// Usage: test_trace               run the checks
+//        test_trace --record      write the wire capture of the fixed sequence to traces/trace_capture.bin
+
+#define CAPTURE_PATH                "traces/trace_capture.bin"
+
+#define CYCLES_PER_US               16u
+#define CYCLES_PER_MS               (CYCLES_PER_US * 1000u)
+#define CHAR_CYCLES                 16667u          // 10 bits at 9600 baud
+#define ISR_CYCLES                  45u             // entry, one byte or the disable, reti
+#define ALGO_CYCLES                 (6u * CYCLES_PER_MS)
+#define SPRINTF_CYCLES              2400u
+#define COPY_CYCLES(len)            (100u + (6u * (len)))
+#define TRACE_CYCLES                350u            // build and queue one record
+#define POLL_CYCLES                 8u              // one pass of a loop on the status flags
+#define US(cycles)                  ((double)(cycles) / CYCLES_PER_US)
+
+#define TICK_CYCLES                 (50u * CYCLES_PER_MS)
+#define RUN_CYCLES                  (600ull * 1000u * CYCLES_PER_MS)
+#define STATUS_PERIOD_CYCLES        (1000u * CYCLES_PER_MS)
+#define STATUS_LEN                  72u
+#define CLI_PERIOD_CYCLES           (15000u * CYCLES_PER_MS)
+#define CLI_LINES                   10u
+#define CLI_LEN                     38u
+#define HOUR_PERIOD_CYCLES          (60000u * CYCLES_PER_MS)
+#define HOUR_LEN                    20u
+#define EVENT_PERIOD_CYCLES         (1000u * CYCLES_PER_MS)
+#define LATE_CYCLES                 (10u * CYCLES_PER_MS)
+#define JITTER_MARGIN_CYCLES        (100u * CYCLES_PER_US)
+#define MEAN_MARGIN_CYCLES          (5u * CYCLES_PER_US)
+
+#define WIRE_BYTES                  (1024u * 1024u)
+#define FILL_LEN                    508u            // leaves 6 bytes, less than the smallest record
+#define RECORD_LEN(args)            (HW_TRACE_HEADER_LEN + (2u * (args)) + 1u)
+
+typedef enum
+{
+    TRACE_OFF,
+    TRACE_FIELD_EVENTS,
+    TRACE_EVERY_TICK,
+    TRACE_MODES,
+}traceMode_t;
+
+typedef struct
+{
+    uint32_t ticks;
+    uint32_t lateTicks;
+    uint64_t sumLate;
+    uint64_t maxLate;
+    uint32_t records;
+    uint32_t dropped;
+    uint32_t textBytes;
+    uint32_t wireBytes;
+    uint32_t wireRecords;
+    uint32_t badRecords;
+    uint64_t isrCycles;
+}jitter_t;
+
+static const char * const xModeNames[TRACE_MODES] = { "tracing off", "field events", "a record every tick" };
+
+volatile uint16_t UCA0IV;
+
+extern void EUSCI_A0_ISR(void);
+
+static bool xPass = true;
+static uint64_t xCycles = 0u;
+static bool xShifting = false;
+static uint64_t xShiftEnd = 0u;
+static uint8_t xShiftByte = 0u;
+static bool xTxBufFull = false;
+static uint8_t xTxBuf = 0u;
+static bool xTxIe = false;
+static bool xInIsr = false;
+static uint64_t xIsrCycles = 0u;
+static uint8_t * xWire = NULL;
+static uint32_t xWireLen = 0u;
+
+static void xCheck(bool condition, const char * p_what);
+static void xDispatch(void);
+static void xShiftDone(void);
+static void xRun(uint64_t cycles);
+static void xIdle(uint64_t until);
+static void xReset(void);
+static void xText(const char * p_text);
+static void xRecordSequence(void);
+static bool xReadFile(const char * p_path, uint8_t ** pp_data, uint32_t * p_len);
+static void xPrint(uint16_t len);
+static void xTrace(hwTraceEvent_t event, uint16_t arg0, uint16_t arg1);
+static void xRunLoop(traceMode_t mode, jitter_t * p_jitter);
+static void xReport(traceMode_t mode, const jitter_t * p_jitter);
+
+int main(int argc, char * argv[])
+{
+    jitter_t jitter[TRACE_MODES];
+    uint8_t * p_reference = NULL;
+    uint32_t referenceLen = 0u;
+    uint64_t before;
+    uint16_t droppedBefore;
+    traceMode_t mode;
+    FILE * p_file;
+
+    xWire = malloc(WIRE_BYTES);
+
+    if ( (argc > 1) && (strcmp(argv[1], "--record") == 0) )
+    {
+        xRecordSequence();
+        p_file = fopen(CAPTURE_PATH, "wb");
+        if ( (p_file == NULL) || (fwrite(xWire, 1u, xWireLen, p_file) != xWireLen) )
+        {
+            printf("can not write %s\n", CAPTURE_PATH);
+            return 1;
+        }
+        fclose(p_file);
+        printf("%u bytes written to %s\n", xWireLen, CAPTURE_PATH);
+        return 0;
+    }
+
+    printf("  records on the wire:\n");
+    xRecordSequence();
+    xCheck(xReadFile(CAPTURE_PATH, &p_reference, &referenceLen) == true, "the reference capture is there");
+    xCheck((xWireLen == referenceLen) && (memcmp(xWire, p_reference, xWireLen) == 0),
+           "text and records come out as " CAPTURE_PATH ", byte for byte");
+    xCheck(HW_TRACE_GetDroppedCount() == 2u, "two records are dropped while the ring is full");
+
+    // a record that does not fit never waits for the UART
+    xReset();
+    HW_TRACE_Enable(true);
+    {
+        uint8_t fill[FILL_LEN];
+        memset(fill, '.', sizeof(fill));
+        uC_UART_Tx(fill, sizeof(fill));
+    }
+    before = xCycles;
+    droppedBefore = HW_TRACE_GetDroppedCount();
+    HW_TRACE_4(TRACE_DAILY_LITERS, 1u, 2u, 3u, 4u);
+    xCheck((xCycles == before) && (HW_TRACE_GetDroppedCount() == (droppedBefore + 1u)), "a record that does not fit is dropped at once");
+    HW_TRACE_Enable(false);
+    before = xCycles;
+    HW_TRACE_0(TRACE_MAG_ACTIVE);
+    xCheck((xCycles == before) && (HW_TRACE_GetDroppedCount() == (droppedBefore + 1u)), "with tracing off nothing is queued or counted");
+    uC_UART_Flush();
+
+    printf("  main loop for 10 minutes, 50 ms ticks, terminal at 9600 baud:\n");
+    for ( mode = TRACE_OFF; mode < TRACE_MODES; mode++ )
+    {
+        xRunLoop(mode, &jitter[mode]);
+        xReport(mode, &jitter[mode]);
+    }
+
+    for ( mode = TRACE_OFF; mode < TRACE_MODES; mode++ )
+    {
+        printf("  %s:\n", xModeNames[mode]);
+        xCheck(jitter[mode].lateTicks == 0u, "no tick is 10 ms late");
+        xCheck((jitter[mode].dropped == 0u) && (jitter[mode].wireRecords == jitter[mode].records) && (jitter[mode].badRecords == 0u),
+               "every record reaches the wire intact");
+        xCheck(jitter[mode].wireBytes == (jitter[mode].textBytes + (jitter[mode].records * RECORD_LEN(2u))), "every byte queued is sent");
+        if ( mode != TRACE_OFF )
+        {
+            xCheck(jitter[mode].maxLate <= (jitter[TRACE_OFF].maxLate + JITTER_MARGIN_CYCLES),
+                   "the worst tick is within 100 us of tracing off");
+            xCheck((jitter[mode].sumLate / jitter[mode].ticks) <= ((jitter[TRACE_OFF].sumLate / jitter[TRACE_OFF].ticks) + MEAN_MARGIN_CYCLES),
+                   "the mean lateness is within 5 us of tracing off");
+            xCheck(jitter[mode].ticks == jitter[TRACE_OFF].ticks, "no tick is missed");
+        }
+    }
+
+    printf("%s\n", (xPass == true) ? "PASS" : "FAIL");
+    return (xPass == true) ? 0 : 1;
+}
+
+static void xCheck(bool condition, const char * p_what)
+{
+    printf("  %s: %s\n", (condition == true) ? "ok  " : "FAIL", p_what);
+    if ( condition == false )
+    {
+        xPass = false;
+    }
+}
+
+// The TX interrupt runs while it is enabled and TXBUF is empty
+static void xDispatch(void)
+{
+    while ( (xTxIe == true) && (xTxBufFull == false) && (xInIsr == false) )
+    {
+        xInIsr = true;
+        UCA0IV = USCI_UART_UCTXIFG;
+        EUSCI_A0_ISR();
+        xInIsr = false;
+        xCycles += ISR_CYCLES;
+        xIsrCycles += ISR_CYCLES;
+    }
+}
+
+// The byte in the shift register is on the wire, TXBUF moves in and its interrupt can run
+static void xShiftDone(void)
+{
+    xCycles = xShiftEnd;
+    if ( xWireLen < WIRE_BYTES )
+    {
+        xWire[xWireLen++] = xShiftByte;
+    }
+
+    if ( xTxBufFull == true )
+    {
+        xShiftByte = xTxBuf;
+        xTxBufFull = false;
+        xShiftEnd += CHAR_CYCLES;
+    }
+    else
+    {
+        xShifting = false;
+    }
+
+    xDispatch();
+}
+
+// Background work, the interrupts taken on the way stretch it
+static void xRun(uint64_t cycles)
+{
+    while ( (xShifting == true) && ((xShiftEnd - xCycles) <= cycles) )
+    {
+        cycles -= xShiftEnd - xCycles;
+        xShiftDone();
+    }
+
+    xCycles += cycles;
+}
+
+static void xIdle(uint64_t until)
+{
+    while ( (xShifting == true) && (xShiftEnd <= until) )
+    {
+        xShiftDone();
+    }
+
+    if ( xCycles < until )
+    {
+        xCycles = until;
+    }
+}
+
+static void xReset(void)
+{
+    uC_UART_Flush();
+    xWireLen = 0u;
+    xIsrCycles = 0u;
+}
+
+static void xText(const char * p_text)
+{
+    uC_UART_Tx((uint8_t *)p_text, (uint16_t)strlen(p_text));
+}
+
+// Text, records, a full ring and the gap report, with the ticks at the edges of the 32 bit field
+static void xRecordSequence(void)
+{
+    uint8_t fill[FILL_LEN];
+
+    xReset();
+    HW_TRACE_Enable(true);
+
+    HOST_SetTimeMs(0u);
+    xText("High level state\r\n");
+    HOST_SetTimeMs(120u);
+    HW_TRACE_2(TRACE_BOOT, 3u, 1u);
+    xText("Hour 5\r\n");
+    HOST_SetTimeMs(3600000u);
+    HW_TRACE_1(TRACE_HOUR, 5u);
+    HW_TRACE_1(TRACE_AM_WAKE, 0x8Au);
+    HW_TRACE_3(TRACE_DAILY_LITERS, 1234u, (uint16_t)-1, 65535u);
+    uC_UART_Flush();
+
+    memset(fill, '.', sizeof(fill));
+    fill[FILL_LEN - 2u] = '\r';
+    fill[FILL_LEN - 1u] = '\n';
+    uC_UART_Tx(fill, sizeof(fill));
+    HW_TRACE_0(TRACE_MAG_ACTIVE);
+    HW_TRACE_0(TRACE_MAG_ACTIVE);
+    uC_UART_Flush();
+
+    HOST_SetTimeMs(0xFFFFFFFFull * 10u);
+    HW_TRACE_2(TRACE_ALGO_LATE, 7u, 2u);
+    xText("done\r\n");
+    uC_UART_Flush();
+
+    HW_TRACE_Enable(false);
+}
+
+static bool xReadFile(const char * p_path, uint8_t ** pp_data, uint32_t * p_len)
+{
+    FILE * p_file = fopen(p_path, "rb");
+
+    if ( p_file == NULL )
+    {
+        return false;
+    }
+
+    *pp_data = malloc(WIRE_BYTES);
+    *p_len = (uint32_t)fread(*pp_data, 1u, WIRE_BYTES, p_file);
+    fclose(p_file);
+
+    return true;
+}
+
+// A line of terminal text: format it, then uC_UART_Tx copies it into the ring
+static void xPrint(uint16_t len)
+{
+    static uint8_t line[STATUS_LEN];
+
+    memset(line, 'a', sizeof(line));
+    xRun(SPRINTF_CYCLES + COPY_CYCLES(len));
+    uC_UART_Tx(line, len);
+}
+
+static void xTrace(hwTraceEvent_t event, uint16_t arg0, uint16_t arg1)
+{
+    xRun(TRACE_CYCLES);
+    HW_TRACE_2(event, arg0, arg1);
+}
+
+// The background loop: whatever is due runs, then it sleeps until the next thing is due. The prints are
+// due just before a tick, where they delay it the most.
+static void xRunLoop(traceMode_t mode, jitter_t * p_jitter)
+{
+    uint64_t start;
+    uint64_t nextTick;
+    uint64_t nextStatus;
+    uint64_t nextCli;
+    uint64_t nextHour;
+    uint64_t nextEvent;
+    uint64_t next;
+    uint64_t late;
+    uint16_t droppedBefore;
+    uint32_t line;
+    uint32_t i;
+
+    memset(p_jitter, 0, sizeof(jitter_t));
+    xReset();
+    HW_TRACE_Enable(mode != TRACE_OFF);
+    droppedBefore = HW_TRACE_GetDroppedCount();
+
+    start = xCycles;
+    nextTick = start;
+    nextStatus = start + STATUS_PERIOD_CYCLES + TICK_CYCLES - CYCLES_PER_MS;
+    nextCli = start + CLI_PERIOD_CYCLES + (6u * TICK_CYCLES) - (CYCLES_PER_MS / 2u);
+    nextHour = start + HOUR_PERIOD_CYCLES + (14u * TICK_CYCLES) - (CYCLES_PER_MS / 5u);
+    nextEvent = start + (EVENT_PERIOD_CYCLES / 2u) + TICK_CYCLES - (10u * CYCLES_PER_US);
+
+    while ( (xCycles - start) < RUN_CYCLES )
+    {
+        HOST_SetTimeMs((xCycles - start) / CYCLES_PER_MS);
+
+        if ( xCycles >= nextTick )
+        {
+            late = xCycles - nextTick;
+            p_jitter->ticks++;
+            p_jitter->sumLate += late;
+            p_jitter->maxLate = (late > p_jitter->maxLate) ? late : p_jitter->maxLate;
+            p_jitter->lateTicks += (late >= LATE_CYCLES) ? 1u : 0u;
+
+            xRun(ALGO_CYCLES);
+            if ( mode == TRACE_EVERY_TICK )
+            {
+                xTrace(TRACE_ALGO_LATE, 1u, 0u);
+                p_jitter->records++;
+            }
+            nextTick += TICK_CYCLES;
+        }
+
+        if ( xCycles >= nextStatus )
+        {
+            xPrint(STATUS_LEN);
+            p_jitter->textBytes += STATUS_LEN;
+            nextStatus += STATUS_PERIOD_CYCLES;
+        }
+
+        if ( xCycles >= nextCli )
+        {
+            for ( line = 0u; line < CLI_LINES; line++ )
+            {
+                xPrint(CLI_LEN);
+                p_jitter->textBytes += CLI_LEN;
+            }
+            nextCli += CLI_PERIOD_CYCLES;
+        }
+
+        if ( xCycles >= nextHour )
+        {
+            xPrint(HOUR_LEN);
+            p_jitter->textBytes += HOUR_LEN;
+            if ( mode != TRACE_OFF )
+            {
+                xTrace(TRACE_HOUR, 5u, 0u);
+                p_jitter->records++;
+            }
+            nextHour += HOUR_PERIOD_CYCLES;
+        }
+
+        if ( xCycles >= nextEvent )
+        {
+            if ( mode != TRACE_OFF )
+            {
+                xTrace(TRACE_MAG_IDLE, 1u, 0u);
+                xTrace(TRACE_AM_WAKE, 0x8Au, 0u);
+                p_jitter->records += 2u;
+            }
+            nextEvent += EVENT_PERIOD_CYCLES;
+        }
+
+        next = nextTick;
+        next = (nextStatus < next) ? nextStatus : next;
+        next = (nextCli < next) ? nextCli : next;
+        next = (nextHour < next) ? nextHour : next;
+        next = (nextEvent < next) ? nextEvent : next;
+        xIdle(next);
+    }
+
+    uC_UART_Flush();
+    HW_TRACE_Enable(false);
+
+    p_jitter->dropped = HW_TRACE_GetDroppedCount() - droppedBefore;
+    p_jitter->wireBytes = xWireLen;
+    p_jitter->isrCycles = xIsrCycles;
+
+    // pick the records out of the text as the decoder does, the text has no sync byte
+    for ( i = 0u; i < xWireLen; )
+    {
+        uint8_t sum = 0u;
+        uint32_t len;
+        uint32_t j;
+
+        if ( xWire[i] != HW_TRACE_SYNC )
+        {
+            i++;
+            continue;
+        }
+
+        len = ((i + 2u) < xWireLen) ? RECORD_LEN(xWire[i + 2u]) : 0u;
+        for ( j = 1u; (j < len) && ((i + j) < xWireLen); j++ )
+        {
+            sum += xWire[i + j];
+        }
+
+        if ( (len == 0u) || (xWire[i + 2u] > HW_TRACE_MAX_ARGS) || (j != len) || (sum != 0u) )
+        {
+            p_jitter->badRecords++;
+            i++;
+            continue;
+        }
+
+        p_jitter->wireRecords++;
+        i += len;
+    }
+}
+
+static void xReport(traceMode_t mode, const jitter_t * p_jitter)
+{
+    printf("    %-20s %5u ticks, late mean %6.1f us max %6.1f us, %4u records, %6u B on the wire, %4.2f%% CPU in the TX ISR\n",
+           xModeNames[mode], p_jitter->ticks, US(p_jitter->sumLate) / p_jitter->ticks, US(p_jitter->maxLate), p_jitter->records,
+           p_jitter->wireBytes, (100.0 * p_jitter->isrCycles) / RUN_CYCLES);
+}
+
+// LPM0 until the next interrupt, the only one running here is the TX interrupt
+void HOST_Sleep(uint16_t bits)
+{
+    if ( xShifting == false )
+    {
+        printf("  FAIL: sleeping for the UART with nothing to wake it\nFAIL\n");
+        exit(1);
+    }
+
+    xShiftDone();
+}
+
+bool EUSCI_A_UART_init(uint16_t baseAddress, EUSCI_A_UART_initParam *param)
+{
+    return true;
+}
+
+void EUSCI_A_UART_enable(uint16_t baseAddress)
+{
+}
+
+void EUSCI_A_UART_transmitData(uint16_t baseAddress, uint8_t transmitData)
+{
+    if ( xShifting == false )
+    {
+        xShifting = true;
+        xShiftByte = transmitData;
+        xShiftEnd = xCycles + CHAR_CYCLES;
+    }
+    else
+    {
+        xTxBufFull = true;
+        xTxBuf = transmitData;
+    }
+}
+
+uint8_t EUSCI_A_UART_receiveData(uint16_t baseAddress)
+{
+    return 0u;
+}
+
+void EUSCI_A_UART_enableInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+    if ( (mask & EUSCI_A_UART_TRANSMIT_INTERRUPT) != 0u )
+    {
+        xTxIe = true;
+        xDispatch();
+    }
+}
+
+void EUSCI_A_UART_disableInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+    if ( (mask & EUSCI_A_UART_TRANSMIT_INTERRUPT) != 0u )
+    {
+        xTxIe = false;
+    }
+}
+
+void EUSCI_A_UART_clearInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+}
+
+// Polled in a loop by uC_UART_Flush(), so each read takes a little time
+uint8_t EUSCI_A_UART_queryStatusFlags(uint16_t baseAddress, uint8_t mask)
+{
+    xRun(POLL_CYCLES);
+    return ((xShifting == true) && ((mask & EUSCI_A_UART_BUSY) != 0u)) ? EUSCI_A_UART_BUSY : 0u;
+}
+
+void HW_TERM_RxByte(uint8_t byte)
+{
+}
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""Checks of ssm_trace_decode.py on the wire capture test_trace checks HW_TRACE.c against.
+
+traces/trace_capture.bin is terminal text with trace records between it, two
+of them dropped while the UART ring was full and reported by a TRACE_DROPPED
+record, and ticks at both ends of the 32 bit field. The decoder has to render
+every record, pass the text through, give the same output however the bytes
+are split between reads, and step over a corrupted record to the next one.
+
+Usage: python3 test_trace_decode.py      (from this folder, test.sh runs it)
+"""
+
+import os
+import random
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+import ssm_trace_decode  # noqa: E402
+
+CAPTURE = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'traces', 'trace_capture.bin')
+
+EXPECTED_LINES = [
+    'High level state\r\n',
+    '[      0.12] TRACE_BOOT: boot, app state 3, reset state 1\n',
+    'Hour 5\r\n',
+    '[   3600.00] TRACE_HOUR: hour 5\n',
+    '[   3600.00] TRACE_AM_WAKE: waking the AM, attention sources 0x8a\n',
+    '[   3600.00] TRACE_DAILY_LITERS: daily liters 1234, average 65535, red flag 65535\n',
+    '[42949672.95] TRACE_DROPPED: 2 trace records dropped\n',
+    '[42949672.95] TRACE_ALGO_LATE: algorithm ran 7 ticks after the last run, 2 late runs\n',
+    'done\r\n',
+]
+
+RANDOM_SPLITS = 200
+MAX_FIXED_CHUNK = 40
+
+passed = True
+
+
+def check(condition, what):
+    global passed
+    print('  %s: %s' % ('ok  ' if condition else 'FAIL', what))
+    passed = passed and condition
+
+
+def decode(events, data, chunks):
+    decoder = ssm_trace_decode.Decoder(events)
+    return ''.join(decoder.feed(data[start:end]) for start, end in chunks), decoder
+
+
+def main():
+    events = ssm_trace_decode.load_events()
+    with open(CAPTURE, 'rb') as f:
+        capture = f.read()
+
+    check(events[0][0] == 'TRACE_DROPPED' and len(events) == 12, 'the event list is read from HW_TRACE.h')
+
+    whole, decoder = decode(events, capture, [(0, len(capture))])
+    if os.environ.get('HOST_VERBOSE'):
+        print(whole)
+    check(decoder.bad_records == 0, 'every record in the capture is good')
+    check(all(line in whole for line in EXPECTED_LINES), 'every record is rendered and the text passes through')
+    check(whole.count('TRACE_') == 6 and 'TRACE_MAG_ACTIVE' not in whole, 'the dropped records do not appear')
+    check('.' * 100 in whole, 'the text that filled the ring is there')
+
+    same = True
+    for size in range(1, MAX_FIXED_CHUNK):
+        out, _ = decode(events, capture, [(i, i + size) for i in range(0, len(capture), size)])
+        same = same and out == whole
+    check(same, 'the same output for reads of 1 to %d bytes' % (MAX_FIXED_CHUNK - 1))
+
+    same = True
+    for seed in range(RANDOM_SPLITS):
+        rng = random.Random(seed)
+        chunks = []
+        start = 0
+        while start < len(capture):
+            end = start + rng.randint(1, 20)
+            chunks.append((start, end))
+            start = end
+        out, _ = decode(events, capture, chunks)
+        same = same and out == whole
+    check(same, 'the same output for %d random splits' % RANDOM_SPLITS)
+
+    records = [i for i, byte in enumerate(capture) if byte == ssm_trace_decode.SYNC]
+    rejected = True
+    recovered = True
+    for start in records:
+        for offset in range(1, ssm_trace_decode.HEADER_LEN):
+            bad = bytearray(capture)
+            bad[start + offset] ^= 0x10
+            out, decoder = decode(events, bytes(bad), [(0, len(bad))])
+            rejected = rejected and decoder.bad_records >= 1
+            recovered = recovered and out.endswith('done\r\n') and out.count('TRACE_') >= len(records) - 1
+    check(rejected, 'a flipped bit in any header byte is caught by the checksum')
+    check(recovered, 'the decoder resyncs and renders the records after it')
+
+    check(ssm_trace_decode.format_args('%d %u %x', [0xFFFF, 0xFFFF, 0xFFFF]) == '-1 65535 ffff',
+          '%d is signed, %u unsigned, %x hex')
+    check(ssm_trace_decode.format_args('%u and %u', [7]) == '7 and 0', 'a missing argument renders as 0')
+
+    print('PASS' if passed else 'FAIL')
+    return 0 if passed else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())